@@ -198,10 +198,12 @@ void query_columns(ADIOS_FILE* f, enum ADIOS_QUERY_METHOD method, ADIOS_VARINFO
 
 void printUsage(char *prgname)
 {
-    printf ("Usage: %s [fastbit|alacrity]\n"
+    printf ("Usage: %s [fastbit|alacrity|scan|bitmap]\n"
            "  Choose the query method to use.\n"
            "  For ALACRITY, you need to build write_table with and ADIOS which has ALACRITY transformation.\n"
            "  For FastBit, you need to run 'adios_index_fastbit table.bp' to generate the index 'table.idx'.\n"
+           "  SCAN needs no index, it reads the data.\n"
+           "  BITMAP uses the bitmap index that write_table defines for A.\n"
            ,prgname);
 }
 
@@ -215,10 +217,11 @@ int main (int argc, char ** argv)
     adios_read_init_method(ADIOS_READ_METHOD_BP,0,"");
 
     if (!adios_query_is_method_available(ADIOS_QUERY_METHOD_ALACRITY) && 
-        !adios_query_is_method_available(ADIOS_QUERY_METHOD_FASTBIT)) 
+        !adios_query_is_method_available(ADIOS_QUERY_METHOD_FASTBIT) &&
+        !adios_query_is_method_available(ADIOS_QUERY_METHOD_SCAN))
     {
         printf ("This query test on tabular data is only supported by accurate "
-                "point-based query methods like FASTBIT and ALACRITY. "
+                "point-based query methods like FASTBIT, ALACRITY and SCAN. "
                 "No such method is available in this ADIOS build.\n");
         return 1;
     }
@@ -241,6 +244,12 @@ int main (int argc, char ** argv)
                         "Try ALACRITY but first run the write_table code with alacrity transformation!\n");
                 return 1;
             }
+        } else if (!strncasecmp (argv[1], "scan", 4)) {
+            query_method = ADIOS_QUERY_METHOD_SCAN;
+            printf ("Set query method to SCAN\n");
+        } else if (!strncasecmp (argv[1], "bitmap", 6)) {
+            query_method = ADIOS_QUERY_METHOD_BITMAP;
+            printf ("Set query method to BITMAP\n");
         } else {
             printUsage(argv[0]);
             return 1;
@@ -106,6 +106,8 @@ int main (int argc, char ** argv)
         adios_set_transform (varA, "alacrity");
         printf ("Turned on ALACRITY transformation for table A\n");
     }
+    // index A at write time for the BITMAP query method
+    adios_define_var_bitmap_index (g, "A", "0,10,50,100,200");
 
 	sprintf (dimstr, "%d,%d", n_of_elements, Elements_length);
 	adios_define_var (g, "Elements" ,"", adios_byte, dimstr, dimstr, "0,0");
@@ -117,7 +119,8 @@ int main (int argc, char ** argv)
 
 	adios_groupsize = NX*NY*sizeof(int32_t)           /* size of A */
 	+ n_of_elements * Elements_length /* size of Elements */
-	+ NY * Columns_length;            /* size of Columns */
+	+ NY * Columns_length             /* size of Columns */
+	+ 1024;                           /* bitmap index of A */
 
 	adios_group_size (f, adios_groupsize, &adios_totalsize);
 	adios_write (f, "A", A);
@@ -15,9 +15,18 @@
 
 extern int adios_errno;
 
+// Selections are also built concurrently by the transform read threads
+// (see adios_transform_process_all_reads), so only store to adios_errno
+// when there is an error to clear
+static inline void clear_adios_errno(void)
+{
+    if (adios_errno != err_no_error)
+        adios_errno = err_no_error;
+}
+
 ADIOS_SELECTION * a2sel_boundingbox (int ndim, const uint64_t *start, const uint64_t *count)
 {
-    adios_errno = err_no_error;
+    clear_adios_errno();
     ADIOS_SELECTION * sel = (ADIOS_SELECTION *) malloc (sizeof(ADIOS_SELECTION));
     if (sel) {
         sel->type = ADIOS_SELECTION_BOUNDINGBOX;
@@ -35,7 +44,7 @@ ADIOS_SELECTION * a2sel_boundingbox (int ndim, const uint64_t *start, const uint
 ADIOS_SELECTION * a2sel_points (int ndim, uint64_t npoints, const uint64_t *points,
                                 ADIOS_SELECTION * container, int free_points_on_delete)
 {
-    adios_errno = err_no_error;
+    clear_adios_errno();
     ADIOS_SELECTION * sel = (ADIOS_SELECTION *) malloc (sizeof(ADIOS_SELECTION));
     if (sel) {
         sel->type = ADIOS_SELECTION_POINTS;
@@ -52,7 +61,7 @@ ADIOS_SELECTION * a2sel_points (int ndim, uint64_t npoints, const uint64_t *poin
 
 ADIOS_SELECTION * a2sel_writeblock (int index)
 {
-    adios_errno = err_no_error;
+    clear_adios_errno();
     ADIOS_SELECTION * sel = (ADIOS_SELECTION *) malloc (sizeof(ADIOS_SELECTION));
     if (sel) {
         sel->type = ADIOS_SELECTION_WRITEBLOCK;
@@ -70,7 +79,7 @@ ADIOS_SELECTION * a2sel_writeblock (int index)
 
 ADIOS_SELECTION * a2sel_auto (char *hints)
 {
-    adios_errno = err_no_error;
+    clear_adios_errno();
     ADIOS_SELECTION * sel = (ADIOS_SELECTION *) malloc (sizeof(ADIOS_SELECTION));
     if (sel) {
         sel->type = ADIOS_SELECTION_AUTO;
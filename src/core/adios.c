@@ -26,6 +26,7 @@
 #include "core/adios_transport_hooks.h"
 #include "core/adios_logger.h"
 #include "core/adios_timing.h"
+#include "core/strutil.h"
 
 #ifdef DMALLOC
 #include "dmalloc.h"
@@ -222,13 +223,12 @@ int adios_close (int64_t fd_p)
                 while (v->bitmap >> j) {   
                     if (v->bitmap >> j & 1) {   
                         if (j == adios_statistic_hist) {   
-                            struct adios_index_characteristics_hist_struct * hist =
-                                (struct adios_index_characteristics_hist_struct *) v->stats[c][idx].data;
+                            // keep the definition of the histogram for the next steps
+                            struct adios_hist_struct * hist =
+                                (struct adios_hist_struct *) v->stats[c][idx].data;
                             if (hist) {   
-                                free (hist->breaks);
                                 free (hist->frequencies);
-                                free (hist);
-                                v->stats[c][idx].data = 0;
+                                hist->frequencies = 0;
                             }
                         }
                         else {
@@ -398,6 +398,103 @@ int adios_set_transform (int64_t var_id, const char *transform_type_str)
     return adios_common_set_transform (var_id, transform_type_str);
 }
 
+///////////////////////////////////////////////////////////////////////////////
+// adios_common_define_var_characteristics is in adios_internals.c
+// record a histogram of every written block of a variable between break points
+int adios_define_var_histogram (int64_t group_id, const char * name,
+                                const char * break_points)
+{
+    struct adios_group_struct * g = (struct adios_group_struct *) group_id;
+    struct adios_var_struct * var;
+
+    adios_errno = err_no_error;
+    if (!group_id)
+    {
+        adios_error (err_invalid_group, "%s called with invalid group ID\n", __func__);
+        return adios_errno;
+    }
+    var = adios_find_var_by_name (g, name);
+    if (!var)
+    {
+        adios_error (err_invalid_varname,
+                "Histogram: variable %s is not defined in group %s\n", name, g->name);
+        return adios_errno;
+    }
+    if (!var->stats || !(var->bitmap & (1 << adios_statistic_sum)))
+    {
+        adios_error (err_histogram_error,
+                "Histogram of variable %s requires full statistics in group %s\n",
+                name, g->name);
+        return adios_errno;
+    }
+    if (!break_points || !*break_points)
+    {
+        adios_error (err_histogram_error,
+                "Histogram of variable %s: no break points given\n", name);
+        return adios_errno;
+    }
+    adios_common_define_var_characteristics (g, name, break_points, NULL, NULL, NULL, NULL);
+    return adios_errno;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// adios_common_define_var_bitmap_index is in adios_internals.c
+// index the blocks of a variable with bitmaps of the bins between break points
+int adios_define_var_bitmap_index (int64_t group_id, const char * name,
+                                   const char * break_points)
+{
+    char ** tokens = 0;
+    int count = 0, i;
+    double * breaks;
+
+    adios_errno = err_no_error;
+    if (!group_id)
+    {
+        adios_error (err_invalid_group, "%s called with invalid group ID\n", __func__);
+        return adios_errno;
+    }
+    if (break_points)
+        a2s_tokenize_dimensions (break_points, &tokens, &count);
+    if (!count)
+    {
+        adios_error (err_histogram_error,
+                "Bitmap index of variable %s: no break points given\n", name);
+        return adios_errno;
+    }
+
+    breaks = (double *) malloc (count * sizeof (double));
+    if (!breaks)
+    {
+        a2s_cleanup_dimensions (tokens, count);
+        adios_error (err_no_memory,
+                "Cannot allocate memory for the bitmap index of variable %s\n", name);
+        return adios_errno;
+    }
+    for (i = 0; i < count; i++)
+        breaks[i] = atof (tokens[i]);
+    a2s_cleanup_dimensions (tokens, count);
+
+    adios_common_define_var_bitmap_index ((struct adios_group_struct *) group_id, name,
+                                          (uint32_t) count, breaks);
+    free (breaks);
+    return adios_errno;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// adios_common_define_var_zone_map is in adios_internals.c
+// record the min/max of zones of about zone_elements elements in every block of a variable
+int adios_define_var_zone_map (int64_t group_id, const char * name, uint64_t zone_elements)
+{
+    adios_errno = err_no_error;
+    if (!group_id)
+    {
+        adios_error (err_invalid_group, "%s called with invalid group ID\n", __func__);
+        return adios_errno;
+    }
+    return adios_common_define_var_zone_map ((struct adios_group_struct *) group_id, name,
+                                             zone_elements);
+}
+
 
 ///////////////////////////////////////////////////////////////////////////////
 
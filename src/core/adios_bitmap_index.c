@@ -0,0 +1,352 @@
+/*
+ * adios_bitmap_index.c  Write-time binned bitmap index of a variable
+ *
+ * See adios_bitmap_index.h for the index layout.
+ *
+ * WAH encoding: the bits of a bitmap are cut into groups of 31. A literal word
+ * (MSB 0) holds one group. A fill word (MSB 1) stands for a run of groups that
+ * are all 0 or all 1 (bit 30), the run length is in the lowest 30 bits.
+ * Trailing groups of zeros are not stored.
+ */
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include "core/adios_bitmap_index.h"
+
+#define WAH_GROUP_BITS   31
+#define WAH_LITERAL_MASK 0x7FFFFFFFu
+#define WAH_FILL_FLAG    0x80000000u
+#define WAH_FILL_ONES    0x40000000u
+#define WAH_MAX_RUN      0x3FFFFFFFu
+
+#define HEADER_SIZE 16
+
+typedef struct {
+    uint32_t * words;
+    uint64_t   nwords;
+    uint64_t   allocated;
+    uint64_t   ngroups;   // groups encoded so far
+} WAH_ENCODER;
+
+static int wah_push (WAH_ENCODER * e, uint32_t w)
+{
+    if (e->nwords == e->allocated)
+    {
+        uint64_t n = (e->allocated ? 2 * e->allocated : 16);
+        uint32_t * p = (uint32_t *) realloc (e->words, n * sizeof(uint32_t));
+        if (!p)
+            return 1;
+        e->words = p;
+        e->allocated = n;
+    }
+    e->words [e->nwords++] = w;
+    return 0;
+}
+
+static int wah_fill (WAH_ENCODER * e, int ones, uint64_t ngroups)
+{
+    uint32_t fill = WAH_FILL_FLAG | (ones ? WAH_FILL_ONES : 0);
+    while (ngroups > 0)
+    {
+        uint64_t n;
+        if (e->nwords)
+        {
+            uint32_t * last = &e->words [e->nwords - 1];
+            if ((*last & ~WAH_MAX_RUN) == fill && (*last & WAH_MAX_RUN) < WAH_MAX_RUN)
+            {
+                // extend the previous run
+                n = WAH_MAX_RUN - (*last & WAH_MAX_RUN);
+                if (n > ngroups)
+                    n = ngroups;
+                *last += (uint32_t) n;
+                ngroups -= n;
+                continue;
+            }
+        }
+        n = (ngroups < WAH_MAX_RUN ? ngroups : WAH_MAX_RUN);
+        if (wah_push (e, fill | (uint32_t) n))
+            return 1;
+        ngroups -= n;
+    }
+    return 0;
+}
+
+static int wah_literal (WAH_ENCODER * e, uint32_t literal)
+{
+    if (literal == 0)
+        return wah_fill (e, 0, 1);
+    if (literal == WAH_LITERAL_MASK)
+        return wah_fill (e, 1, 1);
+    return wah_push (e, literal);
+}
+
+/* Bin of a value: the number of break points <= v, or the NaN bin */
+static inline uint32_t find_bin (double v, uint32_t num_breaks, const double * breaks)
+{
+    uint32_t low = 0, high = num_breaks;
+    if (isnan (v))
+        return num_breaks + 1;
+    while (low < high)
+    {
+        uint32_t mid = (low + high) / 2;
+        if (breaks [mid] <= v)
+            low = mid + 1;
+        else
+            high = mid;
+    }
+    return low;
+}
+
+/* Bins of 'n' consecutive elements starting at element 'first' */
+static void group_bins (enum ADIOS_DATATYPES type, const void * data, uint64_t first, int n,
+                        uint32_t num_breaks, const double * breaks, uint32_t * bins)
+{
+    int j;
+#define GROUP_BINS(T) \
+    { \
+        const T * d = (const T *) data + first; \
+        for (j = 0; j < n; j++) \
+            bins [j] = find_bin ((double) d [j], num_breaks, breaks); \
+        break; \
+    }
+
+    switch (type)
+    {
+        case adios_byte:             GROUP_BINS(int8_t)
+        case adios_unsigned_byte:    GROUP_BINS(uint8_t)
+        case adios_short:            GROUP_BINS(int16_t)
+        case adios_unsigned_short:   GROUP_BINS(uint16_t)
+        case adios_integer:          GROUP_BINS(int32_t)
+        case adios_unsigned_integer: GROUP_BINS(uint32_t)
+        case adios_long:             GROUP_BINS(int64_t)
+        case adios_unsigned_long:    GROUP_BINS(uint64_t)
+        case adios_real:             GROUP_BINS(float)
+        case adios_double:           GROUP_BINS(double)
+        default:
+            for (j = 0; j < n; j++)
+                bins [j] = num_breaks + 1;
+            break;
+    }
+#undef GROUP_BINS
+}
+
+int adios_bitmap_index_supports_type (enum ADIOS_DATATYPES type)
+{
+    switch (type)
+    {
+        case adios_byte:
+        case adios_unsigned_byte:
+        case adios_short:
+        case adios_unsigned_short:
+        case adios_integer:
+        case adios_unsigned_integer:
+        case adios_long:
+        case adios_unsigned_long:
+        case adios_real:
+        case adios_double:
+            return 1;
+        default:
+            return 0;
+    }
+}
+
+static void write_header (char * p, uint32_t magic, uint32_t num_breaks, uint64_t nelements)
+{
+    memcpy (p, &magic, 4);
+    memcpy (p + 4, &num_breaks, 4);
+    memcpy (p + 8, &nelements, 8);
+}
+
+void adios_bitmap_index_build (enum ADIOS_DATATYPES type, const void * data, uint64_t nelements,
+                               uint32_t num_breaks, const double * breaks,
+                               void ** index, uint64_t * size)
+{
+    uint32_t nbins = num_breaks + 2;
+    WAH_ENCODER * enc = (WAH_ENCODER *) calloc (nbins, sizeof(WAH_ENCODER));
+    uint32_t * literals = (uint32_t *) calloc (nbins, sizeof(uint32_t));
+    uint32_t bins [WAH_GROUP_BITS];
+    uint32_t touched [WAH_GROUP_BITS];
+    uint64_t ngroups = (nelements + WAH_GROUP_BITS - 1) / WAH_GROUP_BITS;
+    uint64_t g, total_words = 0;
+    uint32_t b;
+    int err = (!enc || !literals || (!data && nelements));
+    char * p = NULL;
+
+    for (g = 0; g < ngroups && !err; g++)
+    {
+        uint64_t first = g * WAH_GROUP_BITS;
+        int n = (nelements - first < WAH_GROUP_BITS ? (int) (nelements - first) : WAH_GROUP_BITS);
+        int ntouched = 0, j;
+
+        group_bins (type, data, first, n, num_breaks, breaks, bins);
+        for (j = 0; j < n; j++)
+        {
+            if (!literals [bins [j]])
+                touched [ntouched++] = bins [j];
+            literals [bins [j]] |= (uint32_t) 1 << j;
+        }
+
+        // bins without elements in this group are brought up to date lazily with a 0-fill
+        for (j = 0; j < ntouched && !err; j++)
+        {
+            b = touched [j];
+            if (enc [b].ngroups < g)
+                err = wah_fill (&enc [b], 0, g - enc [b].ngroups);
+            if (!err)
+                err = wah_literal (&enc [b], literals [b]);
+            enc [b].ngroups = g + 1;
+            literals [b] = 0;
+        }
+    }
+
+    for (b = 0; b < nbins && !err; b++)
+    {
+        if (enc [b].nwords > UINT32_MAX)
+            err = 1;
+        total_words += enc [b].nwords;
+    }
+
+    if (!err)
+    {
+        *size = HEADER_SIZE + 8 * (uint64_t) num_breaks + 4 * (uint64_t) nbins + 4 * total_words;
+        p = (char *) malloc (*size);
+    }
+
+    if (p)
+    {
+        char * q = p + HEADER_SIZE;
+        write_header (p, ADIOS_BITMAP_INDEX_MAGIC, num_breaks, nelements);
+        memcpy (q, breaks, 8 * (uint64_t) num_breaks);
+        q += 8 * (uint64_t) num_breaks;
+        for (b = 0; b < nbins; b++)
+        {
+            uint32_t nwords = (uint32_t) enc [b].nwords;
+            memcpy (q, &nwords, 4);
+            q += 4;
+        }
+        for (b = 0; b < nbins; b++)
+        {
+            memcpy (q, enc [b].words, 4 * enc [b].nwords);
+            q += 4 * enc [b].nwords;
+        }
+    }
+    else
+    {
+        // an index block without bitmaps, the reader has to look at the data
+        *size = HEADER_SIZE;
+        p = (char *) malloc (HEADER_SIZE);
+        if (p)
+            write_header (p, 0, 0, nelements);
+        else
+            *size = 0;
+    }
+    *index = p;
+
+    if (enc)
+    {
+        for (b = 0; b < nbins; b++)
+            free (enc [b].words);
+        free (enc);
+    }
+    free (literals);
+}
+
+int adios_bitmap_index_parse (const void * index, uint64_t size, ADIOS_BITMAP_INDEX_BLOCK * block)
+{
+    const char * p = (const char *) index;
+    uint32_t magic, b;
+    uint64_t total_words = 0;
+
+    memset (block, 0, sizeof(ADIOS_BITMAP_INDEX_BLOCK));
+    if (!p || size < HEADER_SIZE)
+        return 1;
+
+    memcpy (&magic, p, 4);
+    memcpy (&block->num_breaks, p + 4, 4);
+    memcpy (&block->nelements, p + 8, 8);
+    if (magic != ADIOS_BITMAP_INDEX_MAGIC || block->num_breaks > UINT32_MAX - 2)
+        return 1;
+
+    block->nbins = block->num_breaks + 2;
+    if (size < HEADER_SIZE + 8 * (uint64_t) block->num_breaks + 4 * (uint64_t) block->nbins)
+        return 1;
+
+    block->breaks = (const double *) (p + HEADER_SIZE);
+    block->nwords = (const uint32_t *) (p + HEADER_SIZE + 8 * (uint64_t) block->num_breaks);
+    block->words  = block->nwords + block->nbins;
+    block->offsets = (uint64_t *) malloc (block->nbins * sizeof(uint64_t));
+    if (!block->offsets)
+        return 1;
+
+    for (b = 0; b < block->nbins; b++)
+    {
+        block->offsets [b] = total_words;
+        total_words += block->nwords [b];
+    }
+    if ((const char *) block->words + 4 * total_words > p + size)
+    {
+        adios_bitmap_index_block_free (block);
+        return 1;
+    }
+    return 0;
+}
+
+void adios_bitmap_index_block_free (ADIOS_BITMAP_INDEX_BLOCK * block)
+{
+    free (block->offsets);
+    block->offsets = NULL;
+}
+
+void adios_bitmap_index_bin_range (const ADIOS_BITMAP_INDEX_BLOCK * block, uint32_t bin,
+                                   double * lo, double * hi)
+{
+    *lo = (bin == 0 ? -HUGE_VAL : block->breaks [bin - 1]);
+    *hi = (bin >= block->num_breaks ? HUGE_VAL : block->breaks [bin]);
+}
+
+/* OR 'w' into the bitmap at bit position 'pos' */
+static inline void bits_put (uint64_t * bits, uint64_t pos, uint64_t w)
+{
+    uint64_t k = pos >> 6;
+    int s = (int) (pos & 63);
+    bits [k] |= w << s;
+    if (s && (w >> (64 - s)))
+        bits [k+1] |= w >> (64 - s);
+}
+
+static void bits_set_range (uint64_t * bits, uint64_t pos, uint64_t n)
+{
+    while (n >= 64)
+    {
+        bits_put (bits, pos, ~(uint64_t) 0);
+        pos += 64;
+        n -= 64;
+    }
+    if (n)
+        bits_put (bits, pos, ((uint64_t) 1 << n) - 1);
+}
+
+void adios_bitmap_index_decode (const ADIOS_BITMAP_INDEX_BLOCK * block, uint32_t bin, uint64_t * bits)
+{
+    const uint32_t * w = block->words + block->offsets [bin];
+    uint64_t i, pos = 0;
+
+    for (i = 0; i < block->nwords [bin] && pos < block->nelements; i++)
+    {
+        if (w [i] & WAH_FILL_FLAG)
+        {
+            uint64_t n = (uint64_t) (w [i] & WAH_MAX_RUN) * WAH_GROUP_BITS;
+            if (w [i] & WAH_FILL_ONES)
+                bits_set_range (bits, pos, (n < block->nelements - pos ? n : block->nelements - pos));
+            pos += n;
+        }
+        else
+        {
+            uint64_t literal = w [i];
+            if (block->nelements - pos < WAH_GROUP_BITS)
+                literal &= ((uint64_t) 1 << (block->nelements - pos)) - 1;
+            bits_put (bits, pos, literal);
+            pos += WAH_GROUP_BITS;
+        }
+    }
+}
@@ -0,0 +1,68 @@
+/*
+ * adios_bitmap_index.h  Write-time binned bitmap index of a variable
+ *
+ * When a bitmap index is defined for an array variable, every written block is
+ * indexed with one bitmap per bin. The bins are given by break points
+ * b[0] < b[1] < ... < b[n-1] (the same as the histogram break points):
+ *   bin 0:      v < b[0]
+ *   bin k:      b[k-1] <= v < b[k]    (0 < k < n)
+ *   bin n:      v >= b[n-1]
+ *   bin n+1:    NaN
+ * The bitmaps are compressed with 32-bit word-aligned hybrid (WAH) encoding.
+ * The index of each block is written as the block of a hidden byte array
+ * variable, ADIOS_BITMAP_INDEX_PATH + the variable's full path, which is written
+ * right after the block of the variable itself.
+ *
+ * Layout of one index block (native byte order):
+ *   uint32_t  magic
+ *   uint32_t  n                  number of break points
+ *   uint64_t  nelements          number of elements in the block
+ *   double    breaks[n]
+ *   uint32_t  nwords[n+2]        number of words of the bitmap of each bin
+ *   uint32_t  words[]            the bitmaps, one after the other
+ * An index block with a zero magic has no bitmaps (indexing failed).
+ */
+#ifndef ADIOS_BITMAP_INDEX_H
+#define ADIOS_BITMAP_INDEX_H
+
+#include <stdint.h>
+#include "public/adios_types.h"
+
+#define ADIOS_BITMAP_INDEX_PATH "/__adios__/bitmap_index"
+#define ADIOS_BITMAP_INDEX_MAGIC 0x58444942  /* "BIDX" */
+
+/* Check if variables of this type can be indexed */
+int adios_bitmap_index_supports_type (enum ADIOS_DATATYPES type);
+
+/* Build the index of 'nelements' elements of 'data'.
+   Returns the allocated index block in 'index' and its size in 'size'.
+   On failure (out of memory) an index block without bitmaps is returned. */
+void adios_bitmap_index_build (enum ADIOS_DATATYPES type, const void * data, uint64_t nelements,
+                               uint32_t num_breaks, const double * breaks,
+                               void ** index, uint64_t * size);
+
+/* One index block as read back */
+typedef struct {
+    uint64_t         nelements;
+    uint32_t         num_breaks;
+    uint32_t         nbins;          // num_breaks + 2, the last bin is the NaN bin
+    const double   * breaks;
+    const uint32_t * nwords;         // nwords[nbins]
+    const uint32_t * words;          // words of all bins
+    uint64_t       * offsets;        // start of each bin's words in 'words', allocated
+} ADIOS_BITMAP_INDEX_BLOCK;
+
+/* Interpret an index block read into memory.
+   Returns 0 on success, 1 if the block has no usable bitmaps.
+   Free the block with adios_bitmap_index_block_free(). */
+int adios_bitmap_index_parse (const void * index, uint64_t size, ADIOS_BITMAP_INDEX_BLOCK * block);
+void adios_bitmap_index_block_free (ADIOS_BITMAP_INDEX_BLOCK * block);
+
+/* Value range [lo, hi) of a bin, infinite at the two ends (not used for the NaN bin) */
+void adios_bitmap_index_bin_range (const ADIOS_BITMAP_INDEX_BLOCK * block, uint32_t bin,
+                                   double * lo, double * hi);
+
+/* OR the bitmap of 'bin' into 'bits', one bit per element of the block */
+void adios_bitmap_index_decode (const ADIOS_BITMAP_INDEX_BLOCK * block, uint32_t bin, uint64_t * bits);
+
+#endif
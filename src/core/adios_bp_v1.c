@@ -184,6 +184,100 @@ int adios_parse_index_offsets_v1 (struct adios_bp_buffer_struct_v1 * b)
     return 0;
 }
 
+/* The string table at the start of an index section written by
+ * adios_write_index_with_string_table_v1(). The strings point into the
+ * buffer and are not 0 terminated. */
+struct index_strings_v1
+{
+    uint32_t count;
+    uint16_t * lens;
+    char ** strings;
+};
+
+static void parse_index_strings_v1 (struct adios_bp_buffer_struct_v1 * b
+                                   ,struct index_strings_v1 * t
+                                   )
+{
+    uint32_t i;
+
+    t->count = *(uint32_t *) (b->buff + b->offset);
+    if(b->change_endianness == adios_flag_yes) {
+        swap_32(t->count);
+    }
+    b->offset += 4;
+
+    t->lens = (uint16_t *) malloc (t->count * sizeof (uint16_t));
+    t->strings = (char **) malloc (t->count * sizeof (char *));
+    for (i = 0; i < t->count; i++)
+    {
+        t->lens [i] = *(uint16_t *) (b->buff + b->offset);
+        if(b->change_endianness == adios_flag_yes) {
+            swap_16(t->lens [i]);
+        }
+        b->offset += 2;
+        t->strings [i] = b->buff + b->offset;
+        b->offset += t->lens [i];
+    }
+}
+
+static void free_index_strings_v1 (struct index_strings_v1 * t)
+{
+    if (t)
+    {
+        free (t->lens);
+        free (t->strings);
+    }
+}
+
+// Return a new copy of the next string of an index entry, which is an id
+// into the string table t if the section has one (t != NULL), otherwise
+// the length and the characters.
+static char * parse_index_string_v1 (struct adios_bp_buffer_struct_v1 * b
+                                    ,struct index_strings_v1 * t
+                                    )
+{
+    const char * s;
+    uint16_t len;
+    char * str;
+
+    if (t)
+    {
+        uint32_t id = *(uint32_t *) (b->buff + b->offset);
+        if(b->change_endianness == adios_flag_yes) {
+            swap_32(id);
+        }
+        b->offset += 4;
+        if (id >= t->count)
+        {
+            adios_error (err_invalid_buffer_index, "String id %u is out of the "
+                    "range of the index string table of %u strings\n",
+                    id, t->count);
+            id = 0;
+            len = 0;
+        }
+        else
+        {
+            len = t->lens [id];
+        }
+        s = (len ? t->strings [id] : "");
+    }
+    else
+    {
+        len = *(uint16_t *) (b->buff + b->offset);
+        if(b->change_endianness == adios_flag_yes) {
+            swap_16(len);
+        }
+        b->offset += 2;
+        s = b->buff + b->offset;
+        b->offset += len;
+    }
+
+    str = (char *) malloc (len + 1);
+    memcpy (str, s, len);
+    str [len] = '\0';
+    return str;
+}
+
 int adios_parse_process_group_index_v1 (struct adios_bp_buffer_struct_v1 * b,
                          struct adios_index_process_group_struct_v1 ** pg_root,
                          struct adios_index_process_group_struct_v1 ** pg_tail
@@ -215,6 +309,14 @@ int adios_parse_process_group_index_v1 (struct adios_bp_buffer_struct_v1 * b,
     }
     b->offset += 8;
 
+    struct index_strings_v1 strings, * st = NULL;
+    if (process_groups_count & ADIOS_INDEX_PG_HAVE_STRING_TABLE)
+    {
+        process_groups_count &= ~ADIOS_INDEX_PG_HAVE_STRING_TABLE;
+        st = &strings;
+        parse_index_strings_v1 (b, st);
+    }
+
     // validate remaining length
 
     uint64_t i;
@@ -235,17 +337,7 @@ int adios_parse_process_group_index_v1 (struct adios_bp_buffer_struct_v1 * b,
             (*root)->is_time_aggregated = 0;
             (*root)->next = 0;
         }
-        uint16_t length_of_name;
-
-        length_of_name = *(uint16_t *) (b->buff + b->offset);
-        if(b->change_endianness == adios_flag_yes) {
-            swap_16(length_of_name);
-        }
-        b->offset += 2;
-        (*root)->group_name = (char *) malloc (length_of_name + 1);
-        (*root)->group_name [length_of_name] = '\0';
-        memcpy ((*root)->group_name, b->buff + b->offset, length_of_name);
-        b->offset += length_of_name;
+        (*root)->group_name = parse_index_string_v1 (b, st);
 
         (*root)->adios_host_language_fortran =
                              (*(b->buff + b->offset) == 'y' ? adios_flag_yes
@@ -259,15 +351,7 @@ int adios_parse_process_group_index_v1 (struct adios_bp_buffer_struct_v1 * b,
         }
         b->offset += 4;
 
-        length_of_name = *(uint16_t *) (b->buff + b->offset);
-        if(b->change_endianness == adios_flag_yes) {
-            swap_16(length_of_name);
-        }
-        b->offset += 2;
-        (*root)->time_index_name = (char *) malloc (length_of_name + 1);
-        (*root)->time_index_name [length_of_name] = '\0';
-        memcpy ((*root)->time_index_name, b->buff + b->offset, length_of_name);
-        b->offset += length_of_name;
+        (*root)->time_index_name = parse_index_string_v1 (b, st);
 
         (*root)->time_index = *(uint32_t *) (b->buff + b->offset);
         if(b->change_endianness == adios_flag_yes) {
@@ -288,6 +372,7 @@ int adios_parse_process_group_index_v1 (struct adios_bp_buffer_struct_v1 * b,
         root = &(*root)->next;
     }
 
+    free_index_strings_v1 (st);
     return 0;
 }
 
@@ -327,6 +412,14 @@ int adios_parse_vars_index_v1 (struct adios_bp_buffer_struct_v1 * b
     }
     b->offset += 8;
 
+    struct index_strings_v1 strings, * st = NULL;
+    if (vars_count & ADIOS_INDEX_HAVE_STRING_TABLE)
+    {
+        vars_count &= ~ADIOS_INDEX_HAVE_STRING_TABLE;
+        st = &strings;
+        parse_index_strings_v1 (b, st);
+    }
+
     // validate remaining length
 
     int i;
@@ -356,35 +449,11 @@ int adios_parse_vars_index_v1 (struct adios_bp_buffer_struct_v1 * b
         }
         b->offset += 4;
 
-        len = *(uint16_t *) (b->buff + b->offset);
-        if(b->change_endianness == adios_flag_yes) {
-            swap_16(len);
-        }
-        b->offset += 2;
-        (*root)->group_name = (char *) malloc (len + 1);
-        (*root)->group_name [len] = '\0';
-        strncpy ((*root)->group_name, b->buff + b->offset, len);
-        b->offset += len;
+        (*root)->group_name = parse_index_string_v1 (b, st);
 
-        len = *(uint16_t *) (b->buff + b->offset);
-        if(b->change_endianness == adios_flag_yes) {
-            swap_16(len);
-        }
-        b->offset += 2;
-        (*root)->var_name = (char *) malloc (len + 1);
-        (*root)->var_name [len] = '\0';
-        strncpy ((*root)->var_name, b->buff + b->offset, len);
-        b->offset += len;
+        (*root)->var_name = parse_index_string_v1 (b, st);
 
-        len = *(uint16_t *) (b->buff + b->offset);
-        if(b->change_endianness == adios_flag_yes) {
-            swap_16(len);
-        }
-        b->offset += 2;
-        (*root)->var_path = (char *) malloc (len + 1);
-        (*root)->var_path [len] = '\0';
-        strncpy ((*root)->var_path, b->buff + b->offset, len);
-        b->offset += len;
+        (*root)->var_path = parse_index_string_v1 (b, st);
 
         flag = *(b->buff + b->offset);
         (*root)->type = (enum ADIOS_DATATYPES) flag;
@@ -476,6 +545,7 @@ int adios_parse_vars_index_v1 (struct adios_bp_buffer_struct_v1 * b
                                             "%d bytes to copy scalar %s\n",
                                             data_size, (*root)->var_name);
 
+                                    free_index_strings_v1 (st);
                                     return 1;
                                 }
 
@@ -516,6 +586,7 @@ int adios_parse_vars_index_v1 (struct adios_bp_buffer_struct_v1 * b
                                     adios_error(err_no_memory, "cannot allocate"
                                             "%d bytes to copy scalar %s\n",
                                             data_size, (*root)->var_name);
+                                    free_index_strings_v1 (st);
                                     return 1;
                                 }
 
@@ -784,6 +855,7 @@ int adios_parse_vars_index_v1 (struct adios_bp_buffer_struct_v1 * b
     log_debug ("end of %s: hashtbl=%p size=%d\n", __func__,
                hashtbl_vars, (hashtbl_vars ? hashtbl_vars->size(hashtbl_vars) : 0));
 
+    free_index_strings_v1 (st);
     return 0;
 }
 
@@ -820,6 +892,14 @@ int adios_parse_attributes_index_v1 (struct adios_bp_buffer_struct_v1 * b
     }
     b->offset += 8;
 
+    struct index_strings_v1 strings, * st = NULL;
+    if (attrs_count & ADIOS_INDEX_HAVE_STRING_TABLE)
+    {
+        attrs_count &= ~ADIOS_INDEX_HAVE_STRING_TABLE;
+        st = &strings;
+        parse_index_strings_v1 (b, st);
+    }
+
     // validate remaining length
 
     int i;
@@ -850,35 +930,11 @@ int adios_parse_attributes_index_v1 (struct adios_bp_buffer_struct_v1 * b
         }
         b->offset += 4;
 
-        len = *(uint16_t *) (b->buff + b->offset);
-        if(b->change_endianness == adios_flag_yes) {
-            swap_16(len);
-        }
-        b->offset += 2;
-        (*root)->group_name = (char *) malloc (len + 1);
-        (*root)->group_name [len] = '\0';
-        strncpy ((*root)->group_name, b->buff + b->offset, len);
-        b->offset += len;
+        (*root)->group_name = parse_index_string_v1 (b, st);
 
-        len = *(uint16_t *) (b->buff + b->offset);
-        if(b->change_endianness == adios_flag_yes) {
-            swap_16(len);
-        }
-        b->offset += 2;
-        (*root)->attr_name = (char *) malloc (len + 1);
-        (*root)->attr_name [len] = '\0';
-        strncpy ((*root)->attr_name, b->buff + b->offset, len);
-        b->offset += len;
+        (*root)->attr_name = parse_index_string_v1 (b, st);
 
-        len = *(uint16_t *) (b->buff + b->offset);
-        if(b->change_endianness == adios_flag_yes) {
-            swap_16(len);
-        }
-        b->offset += 2;
-        (*root)->attr_path = (char *) malloc (len + 1);
-        (*root)->attr_path [len] = '\0';
-        strncpy ((*root)->attr_path, b->buff + b->offset, len);
-        b->offset += len;
+        (*root)->attr_path = parse_index_string_v1 (b, st);
 
         flag = *(b->buff + b->offset);
         (*root)->type = (enum ADIOS_DATATYPES) flag;
@@ -959,6 +1015,7 @@ int adios_parse_attributes_index_v1 (struct adios_bp_buffer_struct_v1 * b
                                     "%d bytes to copy scalar %s\n",
                                     (*root)->nelems*data_size, (*root)->attr_name);
 
+                            free_index_strings_v1 (st);
                             return 1;
                         }
 
@@ -1171,6 +1228,7 @@ int adios_parse_attributes_index_v1 (struct adios_bp_buffer_struct_v1 * b
         root = &(*root)->next;
     }
 
+    free_index_strings_v1 (st);
     return 0;
 }
 
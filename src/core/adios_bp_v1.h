@@ -18,6 +18,14 @@
 #define ADIOS_VERSION_NUM_MASK                       0x000000FF
 #define ADIOS_VERSION_HAVE_SUBFILE                   0x00000100
 #define ADIOS_VERSION_HAVE_TIME_INDEX_CHARACTERISTIC 0x00000200
+
+// Set in the entry count of an index section (PG, vars, attrs) if the
+// section starts with a string table: uint32 count, then len16 + chars
+// for each string. The entries of such a section have a uint32 id into
+// the table instead of each group name, name, path and time index name.
+#define ADIOS_INDEX_PG_HAVE_STRING_TABLE             0x8000000000000000ULL
+#define ADIOS_INDEX_HAVE_STRING_TABLE                0x80000000U
+
 enum ADIOS_CHARACTERISTICS
 {
      adios_characteristic_value          = 0
@@ -194,6 +202,7 @@ struct adios_index_struct_v1
     struct adios_index_attribute_struct_v1     * attrs_tail;
     qhashtbl_t *hashtbl_vars;  // to speed up merging lists
     qhashtbl_t *hashtbl_attrs; // to speed up merging lists
+    int needs_sorting;         // PGs/characteristics were appended out of time order
 };
 
 struct adios_method_info_struct_v1
@@ -36,6 +36,13 @@ void adios_clear_error(void)
     adios_errno = err_no_error;
 }
 
+void adios_restore_error (int errcode, const char *errmsg)
+{
+    adios_errno = errcode;
+    strncpy (aerr, errmsg, ERRMSG_MAXLEN - 1);
+    aerr[ERRMSG_MAXLEN - 1] = '\0';
+}
+
 void adios_error (enum ADIOS_ERRCODES errcode, char *fmt, ...) 
 {
     va_list ap;
@@ -25,6 +25,8 @@
 #include "core/qhashtbl.h"
 #include "core/adios_logger.h"
 #include "core/util.h"
+#include "core/adios_bitmap_index.h"
+#include "core/adios_zone_map.h"
 
 #ifdef DMALLOC
 #include "dmalloc.h"
@@ -1631,6 +1633,9 @@ int adios_common_delete_vardefs (struct adios_group_struct * g)
         // NCSU ALACRITY-ADIOS - Clean transform metadata
         adios_transform_clear_transform_var(var);
 
+        adios_free_bitmap_index (var->bitmap_index);
+        adios_free_zone_map (var->zone_map);
+
         if (var->adata) 
             free (var->adata);
 
@@ -1717,6 +1722,7 @@ int adios_common_define_var_characteristics (struct adios_group_struct * g
         , const char * bin_min
         , const char * bin_max
         , const char * bin_count
+        , const char * index
         )
 {
     struct adios_var_struct * var;
@@ -1736,7 +1742,7 @@ int adios_common_define_var_characteristics (struct adios_group_struct * g
         j ++;
     }
 
-    hist = var->stats[0][i].data = (struct adios_hist_struct *) malloc (sizeof(struct adios_hist_struct));
+    hist = var->stats[0][i].data = (struct adios_hist_struct *) calloc (1, sizeof(struct adios_hist_struct));
 
     if (!var)
     {
@@ -1838,12 +1844,206 @@ int adios_common_define_var_characteristics (struct adios_group_struct * g
 
             var->bitmap = var->bitmap | (1 << adios_statistic_hist);
         }
+
+        // the bins of the histogram are the bins of the index too
+        if (index)
+        {
+            if (!strcasecmp (index, "bitmap"))
+            {
+                if (adios_common_define_var_bitmap_index (g, var_name, hist->num_breaks, hist->breaks))
+                    return 0;
+            }
+            else
+            {
+                log_warn ("config.xml: unknown index '%s' for variable %s (ignored)\n",
+                          index, var_name);
+            }
+        }
     }
 
 
     return 1;
 }
 
+/* Define the hidden byte array under 'prefix' + the path of 'var', where data
+   about each block of 'var' is written after the block (see common_adios_write).
+   Its size is set before each write. */
+static struct adios_var_struct * define_hidden_var (struct adios_group_struct * g
+        , struct adios_var_struct * var
+        , const char * prefix
+        )
+{
+    struct adios_var_struct * hidden;
+    char * path = (char *) malloc (strlen (prefix) + strlen (var->path) + 2);
+    if (!path)
+    {
+        adios_error (err_no_memory,
+                "Cannot allocate memory for the path of %s of variable %s\n", prefix, var->name);
+        return NULL;
+    }
+    strcpy (path, prefix);
+    if (var->path[0] && var->path[0] != '/')
+        strcat (path, "/");
+    if (strcmp (var->path, "/"))
+        strcat (path, var->path);
+
+    hidden = (struct adios_var_struct *) adios_common_define_var ((int64_t) g, var->name, path,
+                                                                  adios_unsigned_byte, "1", "", "");
+    free (path);
+    if (hidden)
+    {
+        // statistics of the hidden data are of no use
+        hidden->bitmap = 0;
+    }
+    return hidden;
+}
+
+/* Index every written block of a variable with a bitmap per bin. The index blocks
+   are written into a hidden local byte array (see define_hidden_var) */
+int adios_common_define_var_bitmap_index (struct adios_group_struct * g
+        , const char * var_name
+        , uint32_t num_breaks
+        , const double * breaks
+        )
+{
+    struct adios_var_struct * var = adios_find_var_by_name (g, var_name);
+    struct adios_bitmap_index_struct * bi;
+    uint32_t i;
+
+    if (!var)
+    {
+        adios_error (err_invalid_varname,
+                "Didn't find the variable %s to index\n", var_name);
+        return adios_errno;
+    }
+    if (!var->dimensions || !adios_bitmap_index_supports_type (var->type))
+    {
+        adios_error (err_invalid_argument,
+                "Bitmap index of variable %s: only arrays of integer, real or double "
+                "type can be indexed\n", var_name);
+        return adios_errno;
+    }
+    if (!num_breaks)
+    {
+        adios_error (err_histogram_error,
+                "Bitmap index of variable %s: no break points given\n", var_name);
+        return adios_errno;
+    }
+    for (i = 1; i < num_breaks; i++)
+    {
+        if (breaks[i] <= breaks[i-1])
+        {
+            adios_error (err_histogram_error,
+                    "Bitmap index of variable %s: break points must be given "
+                    "in increasing order\n", var_name);
+            return adios_errno;
+        }
+    }
+
+    bi = var->bitmap_index;
+    if (!bi)
+    {
+        bi = (struct adios_bitmap_index_struct *) calloc (1, sizeof (struct adios_bitmap_index_struct));
+        if (!bi)
+        {
+            adios_error (err_no_memory,
+                    "Cannot allocate memory for the bitmap index of variable %s\n", var_name);
+            return adios_errno;
+        }
+        bi->index_var = define_hidden_var (g, var, ADIOS_BITMAP_INDEX_PATH);
+        if (!bi->index_var)
+        {
+            free (bi);
+            return adios_errno;
+        }
+        var->bitmap_index = bi;
+    }
+
+    free (bi->breaks);
+    bi->breaks = (double *) malloc (num_breaks * sizeof (double));
+    if (!bi->breaks)
+    {
+        bi->num_breaks = 0;
+        adios_error (err_no_memory,
+                "Cannot allocate memory for the bitmap index of variable %s\n", var_name);
+        return adios_errno;
+    }
+    memcpy (bi->breaks, breaks, num_breaks * sizeof (double));
+    bi->num_breaks = num_breaks;
+    return err_no_error;
+}
+
+void adios_free_bitmap_index (struct adios_bitmap_index_struct * bi)
+{
+    if (bi)
+    {
+        free (bi->breaks);
+        free (bi->index);
+        free (bi);
+    }
+}
+
+/* Record the min/max of zones of consecutive slabs in every written block of a
+   variable. The zone maps are written into a hidden variable next to the blocks. */
+int adios_common_define_var_zone_map (struct adios_group_struct * g
+        , const char * var_name
+        , uint64_t zone_elements
+        )
+{
+    struct adios_var_struct * var = adios_find_var_by_name (g, var_name);
+    struct adios_zone_map_struct * zm;
+
+    if (!var)
+    {
+        adios_error (err_invalid_varname,
+                "Didn't find the variable %s for its zone map\n", var_name);
+        return adios_errno;
+    }
+    if (!var->dimensions || !adios_zone_map_supports_type (var->type))
+    {
+        adios_error (err_invalid_argument,
+                "Zone map of variable %s: only arrays of integer, real or double "
+                "type can have zone maps\n", var_name);
+        return adios_errno;
+    }
+    if (!zone_elements)
+    {
+        adios_error (err_invalid_argument,
+                "Zone map of variable %s: the zone size must be positive\n", var_name);
+        return adios_errno;
+    }
+
+    zm = var->zone_map;
+    if (!zm)
+    {
+        zm = (struct adios_zone_map_struct *) calloc (1, sizeof (struct adios_zone_map_struct));
+        if (!zm)
+        {
+            adios_error (err_no_memory,
+                    "Cannot allocate memory for the zone map of variable %s\n", var_name);
+            return adios_errno;
+        }
+        zm->map_var = define_hidden_var (g, var, ADIOS_ZONE_MAP_PATH);
+        if (!zm->map_var)
+        {
+            free (zm);
+            return adios_errno;
+        }
+        var->zone_map = zm;
+    }
+    zm->zone_elements = zone_elements;
+    return err_no_error;
+}
+
+void adios_free_zone_map (struct adios_zone_map_struct * zm)
+{
+    if (zm)
+    {
+        free (zm->map);
+        free (zm);
+    }
+}
+
 /* copy path but remove trailing / characters, and also
    NULL path becomes "", so that we don't need to check for NULL everywhere
 */
@@ -1916,6 +2116,8 @@ int64_t adios_common_define_var (int64_t group_id, const char * name
     // NCSU - Initializing stat related info
     v->stats = 0;
     v->bitmap = 0;
+    v->bitmap_index = 0;
+    v->zone_map = 0;
 
     // NCSU ALACRITY-ADIOS - Initialize transform metadata (set to 'none')
     adios_transform_init_transform_var(v);
@@ -2441,6 +2643,15 @@ int adios_write_close_process_group_header_v1 (struct adios_file_struct * fd)
     printf ("nil\n");
 }*/
 
+/* Sort order of the PG index: time first, then writer process */
+static int pg_before (const struct adios_index_process_group_struct_v1 * a,
+                      const struct adios_index_process_group_struct_v1 * b)
+{
+    if (a->time_index != b->time_index)
+        return a->time_index < b->time_index;
+    return a->process_id < b->process_id;
+}
+
 void index_append_process_group_v1 (
         struct adios_index_struct_v1 * index,
         struct adios_index_process_group_struct_v1 * item
@@ -2449,12 +2660,16 @@ void index_append_process_group_v1 (
     //printf ("--- Append process group ----\n");
     //print_pglist (index->pg_root, "Current");
     //print_pglist (item,           "Item(s)");
-    /* PG's are not merged, simply add to the end of the list */
-    /* This is actually not correct. PG's should be ordered by time, not by process ID,
-       but it is irrelevant because this information is never used anywhere. Right?
-       See bpdump output PG list is ordered by time for a single process output. 
+    /* PG's are not merged, simply add to the end of the list.
+       PG's should be ordered by (time, process ID). If the new items break
+       that order (time aggregation, MPI_AGGREGATE global index), the list is
+       flagged and sorted once by adios_sort_index_v1() before writing.
     */
+    if (!item)
+        return;
     if (index->pg_root) {
+        if (pg_before (item, index->pg_tail))
+            index->needs_sorting = 1;
         index->pg_tail->next = item;
     } else {
         // first element
@@ -2468,6 +2683,8 @@ void index_append_process_group_v1 (
           Instead, go down to last element to set as tail 
     */
     while (item->next) {
+        if (pg_before (item->next, item))
+            index->needs_sorting = 1;
         item = item->next;
         index->pg_tail = item;
     }
@@ -2532,112 +2749,67 @@ void index_append_var_v1 (
             return;
         }
 
-        if (do_sort && item->characteristics_count > 0) 
+        if (do_sort && item->characteristics_count > 0)
         {
-            log_debug ("  ----------- Append index with merging --------------\n");
-            struct adios_index_characteristic_struct_v1 * c;
-            int count = olditem->characteristics_count + item->characteristics_count;
-//            printf("new variable index has %d\n", count);
-            c = malloc ( count * sizeof (struct adios_index_characteristic_struct_v1));
-            if (!c)
+            /* Do not merge here, that would copy the whole characteristics
+             * array on every append. Just check if the new run keeps the time
+             * order and leave the sorting to adios_sort_index_v1() which
+             * merges all runs at once before the index is written.
+             */
+            uint64_t k;
+            if (olditem->characteristics_count > 0 &&
+                item->characteristics[0].time_index <
+                olditem->characteristics[olditem->characteristics_count-1].time_index)
             {
-                adios_error (err_no_memory, "error allocating memory to build "
-                        "var index.  Index aborted\n");
-                return;
+                index->needs_sorting = 1;
             }
-            /* Merge the characteristics sorted with time_index */
-            struct adios_index_characteristic_struct_v1 * c1 = olditem->characteristics;
-            struct adios_index_characteristic_struct_v1 * c2 = item->characteristics;
-            uint64_t k1 = 0;
-            uint64_t k2 = 0;
-            struct adios_index_characteristic_struct_v1 * cend = c;
-            log_debug ("  old count=%" PRIu64 " item count=%" PRIu64 "\n", olditem->characteristics_count, item->characteristics_count);
-            while (k1 < olditem->characteristics_count || k2 < item->characteristics_count)
+            for (k = 1; k < item->characteristics_count; k++)
             {
-                log_debug ("  k1=%" PRIu64 " k2=%" PRIu64 "", k1, k2);
-                /*
-                if (k2 >= item->characteristics_count || c1->time_index <= c2->time_index) {
-                    memcpy (cend, c1, sizeof(struct adios_index_characteristic_struct_v1)); 
-                    log_debug_cont ("  -> choose c1, time_index=%u", c1->time_index);
-                    c1++;
-                    k1++;
-                }
-                else if (k1 >= olditem->characteristics_count || c1->time_index > c2->time_index) {
-                    memcpy (cend, c2, sizeof(struct adios_index_characteristic_struct_v1)); 
-                    log_debug_cont ("  -> choose c2, time_index=%u", c2->time_index);
-                    c2++;
-                    k2++;
-                }*/
-                if (k2 >= item->characteristics_count) {
-                    memcpy (cend, c1, sizeof(struct adios_index_characteristic_struct_v1)); 
-                    log_debug_cont ("  -> only c1, time_index=%u", c1->time_index);
-                    c1++;
-                    k1++;
-                }
-                else if (k1 >= olditem->characteristics_count) {
-                    memcpy (cend, c2, sizeof(struct adios_index_characteristic_struct_v1)); 
-                    log_debug_cont ("  -> only c2, time_index=%u", c2->time_index);
-                    c2++;
-                    k2++;
-                }
-                else if (c1->time_index <= c2->time_index) {
-                    memcpy (cend, c1, sizeof(struct adios_index_characteristic_struct_v1)); 
-                    log_debug_cont ("  -> choose c1, time_index=%u", c1->time_index);
-                    c1++;
-                    k1++;
-                }
-                else {
-                    memcpy (cend, c2, sizeof(struct adios_index_characteristic_struct_v1)); 
-                    log_debug_cont ("  -> choose c2, time_index=%u", c2->time_index);
-                    c2++;
-                    k2++;
-                }
-                cend++;
-                log_debug_cont ("\n");
-            }
-            free (olditem->characteristics);
-            olditem->characteristics = c;
-            olditem->characteristics_allocated = count;
-            olditem->characteristics_count = count;
-             
-        } 
-        else 
-        {
-            //printf("else in mergeing var index\n");
-            if (  olditem->characteristics_count
-                    + item->characteristics_count
-                    > olditem->characteristics_allocated
-               )
-            {
-                int new_items = (item->characteristics_count == 1)
-                    ? 100 : item->characteristics_count;
-                olditem->characteristics_allocated =
-                    olditem->characteristics_count + new_items;
-                void * ptr = realloc (
-                        olditem->characteristics,
-                        olditem->characteristics_allocated *
-                        sizeof (struct adios_index_characteristic_struct_v1)
-                        );
-
-                if (ptr)
+                if (item->characteristics[k].time_index <
+                    item->characteristics[k-1].time_index)
                 {
-                    olditem->characteristics = ptr;
-                }
-                else
-                {
-                    adios_error (err_no_memory, "error allocating memory to build "
-                            "var index.  Index aborted\n");
-                    return;
+                    index->needs_sorting = 1;
+                    break;
                 }
             }
-            memcpy (&olditem->characteristics [olditem->characteristics_count],
-                    item->characteristics,
-                    item->characteristics_count *
+        }
+
+        if (  olditem->characteristics_count
+                + item->characteristics_count
+                > olditem->characteristics_allocated
+           )
+        {
+            uint64_t new_items = (item->characteristics_count == 1)
+                ? 100 : item->characteristics_count;
+            /* grow geometrically, many steps/processes are appended one by one */
+            if (new_items < olditem->characteristics_count)
+                new_items = olditem->characteristics_count;
+            olditem->characteristics_allocated =
+                olditem->characteristics_count + new_items;
+            void * ptr = realloc (
+                    olditem->characteristics,
+                    olditem->characteristics_allocated *
                     sizeof (struct adios_index_characteristic_struct_v1)
-                   );
+                    );
 
-            olditem->characteristics_count += item->characteristics_count;
+            if (ptr)
+            {
+                olditem->characteristics = ptr;
+            }
+            else
+            {
+                adios_error (err_no_memory, "error allocating memory to build "
+                        "var index.  Index aborted\n");
+                return;
+            }
         }
+        memcpy (&olditem->characteristics [olditem->characteristics_count],
+                item->characteristics,
+                item->characteristics_count *
+                sizeof (struct adios_index_characteristic_struct_v1)
+               );
+
+        olditem->characteristics_count += item->characteristics_count;
 
         free (item->characteristics);
         free (item->group_name);
@@ -2719,7 +2891,8 @@ static void index_append_attribute_v1
 
 // lists in new_index will be destroyed as part of the merge operation...
 // needs_sorting: use 1 if the the inserted new list has multiple timesteps
-//                it will merge sort the characteristics to keep the time in order
+//                the characteristics are then sorted by time when the index
+//                is written (see adios_sort_index_v1)
 void adios_merge_index_v1 (
                    struct adios_index_struct_v1 * main_index
                   ,struct adios_index_process_group_struct_v1 * new_pg_root
@@ -2766,125 +2939,185 @@ void adios_merge_index_v1 (
     }
 }
 
-#if 0
-// obsolete, merge the index with sorting
-// sort pg/var indexes by time index
-void adios_sort_index_v1 (struct adios_index_process_group_struct_v1 ** p1
-        ,struct adios_index_var_struct_v1 ** v1
-        ,struct adios_index_attribute_struct_v1 ** a1
-        )
+/* Stable merge of two adjacent sorted runs src[lo..mid) and src[mid..hi)
+ * into dst[lo..hi), ordered by time index
+ */
+static void merge_characteristics_runs (
+        const struct adios_index_characteristic_struct_v1 * src,
+        struct adios_index_characteristic_struct_v1 * dst,
+        uint64_t lo, uint64_t mid, uint64_t hi)
 {
-    struct adios_index_process_group_struct_v1 * p2 = 0, * p1_temp, * p2_temp, * p2_temp_prev;
-    struct adios_index_var_struct_v1 * v1_temp;
-    int i, j;
+    uint64_t k1 = lo, k2 = mid, k = lo;
+    while (k1 < mid && k2 < hi)
+    {
+        // <= keeps the characteristics of the same step in original order
+        if (src[k1].time_index <= src[k2].time_index)
+            dst[k++] = src[k1++];
+        else
+            dst[k++] = src[k2++];
+    }
+    if (k1 < mid)
+        memcpy (&dst[k], &src[k1], (mid - k1) * sizeof (*src));
+    if (k2 < hi)
+        memcpy (&dst[k], &src[k2], (hi - k2) * sizeof (*src));
+}
 
-    while (*p1)
+/* Natural merge sort of a characteristics array by time index.
+ * The array is a concatenation of already sorted runs (one per appended
+ * index), so find the runs first and merge them pairwise:
+ * O(n log(runs)) instead of one O(n) merge per appended index.
+ */
+static int sort_characteristics_v1 (
+        struct adios_index_characteristic_struct_v1 * c, uint64_t count)
+{
+    struct adios_index_characteristic_struct_v1 * src, * dst, * tmp;
+    uint64_t * runs;   // start of each run, runs[nruns] = count
+    uint64_t nruns, i, k;
+
+    nruns = 1;
+    for (i = 1; i < count; i++)
+        if (c[i].time_index < c[i-1].time_index)
+            nruns++;
+    if (nruns == 1)
+        return 0; // already sorted
+
+    runs = (uint64_t *) malloc ((nruns+1) * sizeof(uint64_t));
+    tmp = (struct adios_index_characteristic_struct_v1 *)
+            malloc (count * sizeof (struct adios_index_characteristic_struct_v1));
+    if (!runs || !tmp)
+    {
+        free (runs);
+        free (tmp);
+        adios_error (err_no_memory, "error allocating memory to sort "
+                "var index.  Index aborted\n");
+        return 1;
+    }
+
+    runs[0] = 0;
+    k = 1;
+    for (i = 1; i < count; i++)
+        if (c[i].time_index < c[i-1].time_index)
+            runs[k++] = i;
+    runs[nruns] = count;
+
+    src = c;
+    dst = tmp;
+    while (nruns > 1)
     {
-        // if new index list is empty
-        if (!p2)
+        k = 0;
+        for (i = 0; i+1 < nruns; i += 2)
         {
-            p2 = *p1;
-            *p1 = (*p1)->next;
-            p2->next = 0;
+            merge_characteristics_runs (src, dst, runs[i], runs[i+1], runs[i+2]);
+            runs[k++] = runs[i];
         }
-        else
+        if (i < nruns)
         {
-            p2_temp = p2;
-            p2_temp_prev = p2;
+            // odd run out, copy over as it is
+            memcpy (&dst[runs[i]], &src[runs[i]],
+                    (runs[nruns] - runs[i]) * sizeof (*src));
+            runs[k++] = runs[i];
+        }
+        runs[k] = runs[nruns];
+        nruns = k;
+        struct adios_index_characteristic_struct_v1 * t = src;
+        src = dst;
+        dst = t;
+    }
 
-            while (p2_temp && (*p1)->time_index >= p2_temp->time_index)
-            {
-                p2_temp_prev = p2_temp;
-                p2_temp = p2_temp->next;
-            }
+    if (src != c)
+        memcpy (c, src, count * sizeof (*src));
+    free (runs);
+    free (tmp);
+    return 0;
+}
 
-            if (!p2_temp)
-            {
-                p2_temp_prev->next = *p1;
-                *p1 = (*p1)->next;
-                p2_temp_prev->next->next = 0;
-            }
-            else
-            {
-                p1_temp = (*p1)->next;
-                (*p1)->next = p2_temp;
-                p2_temp_prev->next = *p1;
+/* Sort the PG list by (time index, process id). Collect the list into an
+ * array, do a stable bottom-up merge sort and relink.
+ */
+static int sort_process_groups_v1 (struct adios_index_struct_v1 * index)
+{
+    struct adios_index_process_group_struct_v1 * pg, ** a, ** b, ** src, ** dst, ** t;
+    uint64_t n = 0, i, width;
 
-                *p1 = p1_temp;
-            }
+    for (pg = index->pg_root; pg; pg = pg->next)
+        n++;
+    if (n < 2)
+        return 0;
 
-        }
+    a = (struct adios_index_process_group_struct_v1 **)
+            malloc (2 * n * sizeof (struct adios_index_process_group_struct_v1 *));
+    if (!a)
+    {
+        adios_error (err_no_memory, "error allocating memory to sort "
+                "process group index.  Index aborted\n");
+        return 1;
     }
+    b = a + n;
 
-    *p1 = p2;
-
-    v1_temp = *v1;
+    i = 0;
+    for (pg = index->pg_root; pg; pg = pg->next)
+        a[i++] = pg;
 
-    while (v1_temp)
+    src = a;
+    dst = b;
+    for (width = 1; width < n; width *= 2)
     {
-        for (i = 0; i < v1_temp->characteristics_count; i++)
+        for (i = 0; i < n; i += 2*width)
         {
-            for (j = 0; j < v1_temp->characteristics_count - i - 1; j++)
+            uint64_t mid = (i + width < n ? i + width : n);
+            uint64_t hi  = (i + 2*width < n ? i + 2*width : n);
+            uint64_t k1 = i, k2 = mid, k = i;
+            while (k1 < mid && k2 < hi)
             {
-                if (v1_temp->characteristics[j].time_index > v1_temp->characteristics[j + 1].time_index)
-                {
-                    uint64_t t_offset;  // beginning of the var or attr entry
-                    struct adios_index_characteristic_dims_struct_v1 t_dims;
-                    uint16_t t_var_id;
-                    void * t_value;
-                    uint64_t t_payload_offset;   // beginning of the var or attr payload
-                    uint32_t t_file_index;
-                    uint32_t t_time_index;
-
-                    // NCSU - Statistics
-                    uint32_t t_bitmap;
-                    struct adios_index_characteristics_stat_struct ** t_stats;
-
-                    t_offset = v1_temp->characteristics[j].offset;
-                    t_dims.count = v1_temp->characteristics[j].dims.count;
-                    t_dims.dims = v1_temp->characteristics[j].dims.dims;
-                    t_var_id = v1_temp->characteristics[j].var_id;
-                    t_value = v1_temp->characteristics[j].value;
-                    t_payload_offset = v1_temp->characteristics[j].payload_offset;
-                    t_file_index = v1_temp->characteristics[j].file_index;
-                    t_time_index = v1_temp->characteristics[j].time_index;
-                    t_bitmap = v1_temp->characteristics[j].bitmap;
-                    t_stats = v1_temp->characteristics[j].stats;
-
-                    v1_temp->characteristics[j].offset = v1_temp->characteristics[j + 1].offset;
-                    v1_temp->characteristics[j].dims.count = v1_temp->characteristics[j + 1].dims.count;
-                    v1_temp->characteristics[j].dims.dims = v1_temp->characteristics[j + 1].dims.dims;
-                    v1_temp->characteristics[j].var_id = v1_temp->characteristics[j + 1].var_id;
-                    v1_temp->characteristics[j].value = v1_temp->characteristics[j + 1].value;
-                    v1_temp->characteristics[j].payload_offset = v1_temp->characteristics[j + 1].payload_offset;
-                    v1_temp->characteristics[j].file_index = v1_temp->characteristics[j + 1].file_index;
-                    v1_temp->characteristics[j].time_index = v1_temp->characteristics[j + 1].time_index;
-                    v1_temp->characteristics[j].bitmap = v1_temp->characteristics[j + 1].bitmap;
-                    v1_temp->characteristics[j].stats = v1_temp->characteristics[j + 1].stats;
-
-                    v1_temp->characteristics[j + 1].offset = t_offset;
-                    v1_temp->characteristics[j + 1].dims.count = t_dims.count;
-                    v1_temp->characteristics[j + 1].dims.dims = t_dims.dims;
-                    v1_temp->characteristics[j + 1].var_id = t_var_id;
-                    v1_temp->characteristics[j + 1].value = t_value;
-                    v1_temp->characteristics[j + 1].payload_offset = t_payload_offset;
-                    v1_temp->characteristics[j + 1].file_index = t_file_index;
-                    v1_temp->characteristics[j + 1].time_index = t_time_index;
-                    v1_temp->characteristics[j + 1].bitmap = t_bitmap;
-                    v1_temp->characteristics[j + 1].stats = t_stats;
-
-                    // NCSU ALACRITY-ADIOS - Swap transform metadata
-                    adios_transform_swap_transform_characteristics(&v1_temp->characteristics[j].transform, &v1_temp->characteristics[j + 1].transform);
-                }
+                if (pg_before (src[k2], src[k1]))
+                    dst[k++] = src[k2++];
+                else
+                    dst[k++] = src[k1++];
             }
+            while (k1 < mid)
+                dst[k++] = src[k1++];
+            while (k2 < hi)
+                dst[k++] = src[k2++];
         }
+        t = src;
+        src = dst;
+        dst = t;
+    }
+
+    for (i = 0; i+1 < n; i++)
+        src[i]->next = src[i+1];
+    src[n-1]->next = NULL;
+    index->pg_root = src[0];
+    index->pg_tail = src[n-1];
+
+    free (a);
+    return 0;
+}
+
+// Sort the PG list and the var characteristics by time index if
+// index_append_*_v1() found that they were appended out of order.
+// Called by adios_write_index_v1(), so the merges do not need to keep
+// the order themselves.
+void adios_sort_index_v1 (struct adios_index_struct_v1 * index)
+{
+    struct adios_index_var_struct_v1 * v;
+
+    if (!index || !index->needs_sorting)
+        return;
+
+    log_debug ("sort index by time\n");
+    if (sort_process_groups_v1 (index))
+        return;
 
-        v1_temp = v1_temp->next;
+    for (v = index->vars_root; v; v = v->next)
+    {
+        if (sort_characteristics_v1 (v->characteristics, v->characteristics_count))
+            return;
     }
 
     // no need to sort attributes
+    index->needs_sorting = 0;
 }
-#endif 
 
 static void adios_clear_process_groups_index_v1 (
         struct adios_index_process_group_struct_v1 * root
@@ -2942,6 +3175,7 @@ static void adios_clear_vars_index_v1 (struct adios_index_var_struct_v1 * root)
                                 struct adios_index_characteristics_hist_struct * hist = (struct adios_index_characteristics_hist_struct    *) root->characteristics [i].stats[c][idx].data;
                                 free (hist->breaks);
                                 free (hist->frequencies);
+                                free (hist);
                             }
                             else
                                 free (root->characteristics [i].stats[c][idx].data);
@@ -3049,6 +3283,7 @@ struct adios_index_struct_v1 * adios_alloc_index_v1 (int alloc_hashtables)
     index->vars_tail = NULL;
     index->attrs_root = NULL;
     index->attrs_tail = NULL;
+    index->needs_sorting = 0;
     if (alloc_hashtables) {
         index->hashtbl_vars  = qhashtbl(500);
         //index->hashtbl_attrs = qhashtbl(100);
@@ -3088,6 +3323,7 @@ void adios_clear_index_v1 (struct adios_index_struct_v1 * index)
     index->vars_tail = NULL;
     index->attrs_root = NULL;
     index->attrs_tail = NULL;
+    index->needs_sorting = 0;
     if (index->hashtbl_vars)
         index->hashtbl_vars->clear  (index->hashtbl_vars);
     if (index->hashtbl_attrs)
@@ -3233,6 +3469,8 @@ void adios_copy_var_written (struct adios_file_struct * fd, struct adios_var_str
     var_new->is_dim = var->is_dim;
     var_new->write_offset = var->write_offset;
     var_new->stats = 0;
+    var_new->bitmap_index = 0;
+    var_new->zone_map = 0;
     var_new->free_data = var->free_data;
     var_new->data = 0;
     var_new->adata = 0;
@@ -4002,11 +4240,105 @@ void adios_build_index_v1 (struct adios_file_struct * fd,
    // }
 }
 
-int adios_write_index_v1 (char ** buffer
+/* The strings of one index section, in the order of their first use,
+ * for writing the index with a string table. The id of a string is its
+ * position in the table. */
+struct index_string_table_v1
+{
+    qhashtbl_t * ids;   // string -> id+1
+    const char ** strings;
+    uint32_t count;
+    uint32_t allocated;
+};
+
+static void index_string_table_init_v1 (struct index_string_table_v1 * st)
+{
+    st->ids = qhashtbl (100);
+    st->strings = 0;
+    st->count = 0;
+    st->allocated = 0;
+}
+
+static void index_string_table_free_v1 (struct index_string_table_v1 * st)
+{
+    free (st->strings);
+    st->ids->free (st->ids);
+}
+
+static void index_string_table_add_v1 (struct index_string_table_v1 * st
+                                      ,const char * s
+                                      )
+{
+    if (!s)
+        s = "";
+    if (st->ids->get (st->ids, s))
+        return;
+
+    if (st->count == st->allocated)
+    {
+        st->allocated = (st->allocated ? 2 * st->allocated : 16);
+        st->strings = (const char **) realloc (st->strings
+                                             ,st->allocated * sizeof (char *)
+                                             );
+        assert (st->strings);
+    }
+    st->strings [st->count++] = s;
+    st->ids->put (st->ids, s, (void *) (intptr_t) st->count);
+}
+
+// write the table at the start of an index section, return its size
+static uint64_t write_index_string_table_v1 (char ** buffer
+                                            ,uint64_t * buffer_size
+                                            ,uint64_t * buffer_offset
+                                            ,const struct index_string_table_v1 * st
+                                            )
+{
+    uint64_t size = 4;
+    uint32_t i;
+
+    buffer_write (buffer, buffer_size, buffer_offset, &st->count, 4);
+    for (i = 0; i < st->count; i++)
+    {
+        uint16_t len = strlen (st->strings [i]);
+        buffer_write (buffer, buffer_size, buffer_offset, &len, 2);
+        buffer_write (buffer, buffer_size, buffer_offset, st->strings [i], len);
+        size += 2 + len;
+    }
+    return size;
+}
+
+// write a string of an index entry, as its id in st if there is a string
+// table, otherwise as length + characters. Return the bytes written.
+static uint16_t write_index_string_v1 (char ** buffer
+                                      ,uint64_t * buffer_size
+                                      ,uint64_t * buffer_offset
+                                      ,struct index_string_table_v1 * st
+                                      ,const char * s
+                                      )
+{
+    uint16_t len;
+
+    if (!s)
+        s = "";
+    if (st)
+    {
+        uint32_t id = (uint32_t) ((intptr_t) st->ids->get (st->ids, s) - 1);
+        buffer_write (buffer, buffer_size, buffer_offset, &id, 4);
+        return 4;
+    }
+
+    len = strlen (s);
+    buffer_write (buffer, buffer_size, buffer_offset, &len, 2);
+    buffer_write (buffer, buffer_size, buffer_offset, s, len);
+    return 2 + len;
+}
+
+static int write_index_v1 (char ** buffer
         ,uint64_t * buffer_size
         ,uint64_t * buffer_offset
         ,uint64_t index_start
         ,struct adios_index_struct_v1 * index
+        ,int with_string_table
         )
 {
     uint64_t groups_count = 0;
@@ -4021,15 +4353,40 @@ int adios_write_index_v1 (char ** buffer
     // we need to save the offset we will write the count and size
     uint64_t buffer_offset_start = 0; // since we realloc, we can't save a ptr
 
-    struct adios_index_process_group_struct_v1 * pg_root = index->pg_root;
-    struct adios_index_var_struct_v1 * vars_root = index->vars_root;
-    struct adios_index_attribute_struct_v1 * attrs_root = index->attrs_root;
+    struct adios_index_process_group_struct_v1 * pg_root;
+    struct adios_index_var_struct_v1 * vars_root;
+    struct adios_index_attribute_struct_v1 * attrs_root;
+
+    struct index_string_table_v1 strings;
+    struct index_string_table_v1 * st = (with_string_table ? &strings : NULL);
+    uint32_t string_size;
+
+    // merges with time aggregation may have left the index out of time order
+    adios_sort_index_v1 (index);
+    pg_root = index->pg_root;
+    vars_root = index->vars_root;
+    attrs_root = index->attrs_root;
 
     // save for the process group index
     buffer_offset_start = *buffer_offset;
 
     *buffer_offset += (8 + 8); // save space for groups count and index size
 
+    if (st)
+    {
+        struct adios_index_process_group_struct_v1 * pg;
+        index_string_table_init_v1 (st);
+        for (pg = pg_root; pg; pg = pg->next)
+        {
+            index_string_table_add_v1 (st, pg->group_name);
+            index_string_table_add_v1 (st, pg->time_index_name);
+        }
+        index_size += write_index_string_table_v1 (buffer, buffer_size
+                                                  ,buffer_offset, st
+                                                  );
+        groups_count |= ADIOS_INDEX_PG_HAVE_STRING_TABLE;
+    }
+
     while (pg_root)
     {
         uint8_t flag;
@@ -4041,13 +4398,8 @@ int adios_write_index_v1 (char ** buffer
 
         *buffer_offset += 2; // save space for the size
 
-        len = strlen (pg_root->group_name);
-        buffer_write (buffer, buffer_size, buffer_offset, &len, 2);
-        index_size += 2;
-        group_size += 2;
-        buffer_write (buffer, buffer_size, buffer_offset
-                ,pg_root->group_name, len
-                );
+        len = write_index_string_v1 (buffer, buffer_size, buffer_offset
+                                    ,st, pg_root->group_name);
         index_size += len;
         group_size += len;
 
@@ -4064,23 +4416,8 @@ int adios_write_index_v1 (char ** buffer
         index_size += 4;
         group_size += 4;
 
-        if (pg_root->time_index_name)
-        {
-            len = strlen (pg_root->time_index_name);
-        }
-        else
-        {
-            len = 0;
-        }
-        buffer_write (buffer, buffer_size, buffer_offset, &len, 2);
-        index_size += 2;
-        group_size += 2;
-        if (len)
-        {
-            buffer_write (buffer, buffer_size, buffer_offset
-                    ,pg_root->time_index_name, len
-                    );
-        }
+        len = write_index_string_v1 (buffer, buffer_size, buffer_offset
+                                    ,st, pg_root->time_index_name);
         index_size += len;
         group_size += len;
 
@@ -4110,6 +4447,23 @@ int adios_write_index_v1 (char ** buffer
 
     *buffer_offset += (4 + 8); // save space for count and size
 
+    if (st)
+    {
+        struct adios_index_var_struct_v1 * v;
+        index_string_table_free_v1 (st);
+        index_string_table_init_v1 (st);
+        for (v = vars_root; v; v = v->next)
+        {
+            index_string_table_add_v1 (st, v->group_name);
+            index_string_table_add_v1 (st, v->var_name);
+            index_string_table_add_v1 (st, v->var_path);
+        }
+        index_size += write_index_string_table_v1 (buffer, buffer_size
+                                                  ,buffer_offset, st
+                                                  );
+        vars_count |= ADIOS_INDEX_HAVE_STRING_TABLE;
+    }
+
     while (vars_root)
     {
         uint8_t flag;
@@ -4126,35 +4480,20 @@ int adios_write_index_v1 (char ** buffer
         index_size += 4;
         var_size += 4;
 
-        len = strlen (vars_root->group_name);
-        buffer_write (buffer, buffer_size, buffer_offset, &len, 2);
-        index_size += 2;
-        var_size += 2;
-        buffer_write (buffer, buffer_size, buffer_offset
-                ,vars_root->group_name, len
-                );
-        index_size += len;
-        var_size += len;
+        string_size = write_index_string_v1 (buffer, buffer_size, buffer_offset
+                                            ,st, vars_root->group_name);
+        index_size += string_size;
+        var_size += string_size;
 
-        len = strlen (vars_root->var_name);
-        buffer_write (buffer, buffer_size, buffer_offset, &len, 2);
-        index_size += 2;
-        var_size += 2;
-        buffer_write (buffer, buffer_size, buffer_offset
-                ,vars_root->var_name, len
-                );
-        index_size += len;
-        var_size += len;
+        string_size = write_index_string_v1 (buffer, buffer_size, buffer_offset
+                                            ,st, vars_root->var_name);
+        index_size += string_size;
+        var_size += string_size;
 
-        len = strlen (vars_root->var_path);
-        buffer_write (buffer, buffer_size, buffer_offset, &len, 2);
-        index_size += 2;
-        var_size += 2;
-        buffer_write (buffer, buffer_size, buffer_offset
-                ,vars_root->var_path, len
-                );
-        index_size += len;
-        var_size += len;
+        string_size = write_index_string_v1 (buffer, buffer_size, buffer_offset
+                                            ,st, vars_root->var_path);
+        index_size += string_size;
+        var_size += string_size;
 
         flag = vars_root->type;
         buffer_write (buffer, buffer_size, buffer_offset, &flag, 1);
@@ -4488,7 +4827,8 @@ int adios_write_index_v1 (char ** buffer
         vars_root = vars_root->next;
     }
 
-    log_debug ("%s: wrote %d variables into the var-index buffer\n", __func__, vars_count);
+    log_debug ("%s: wrote %d variables into the var-index buffer\n", __func__,
+               vars_count & ~ADIOS_INDEX_HAVE_STRING_TABLE);
 
     // vars index count/size prefix
     buffer_write (buffer, buffer_size, &buffer_offset_start, &vars_count, 4);
@@ -4500,6 +4840,23 @@ int adios_write_index_v1 (char ** buffer
 
     *buffer_offset += (4 + 8); // save space for count and size
 
+    if (st)
+    {
+        struct adios_index_attribute_struct_v1 * a;
+        index_string_table_free_v1 (st);
+        index_string_table_init_v1 (st);
+        for (a = attrs_root; a; a = a->next)
+        {
+            index_string_table_add_v1 (st, a->group_name);
+            index_string_table_add_v1 (st, a->attr_name);
+            index_string_table_add_v1 (st, a->attr_path);
+        }
+        index_size += write_index_string_table_v1 (buffer, buffer_size
+                                                  ,buffer_offset, st
+                                                  );
+        attrs_count |= ADIOS_INDEX_HAVE_STRING_TABLE;
+    }
+
     while (attrs_root)
     {
         uint8_t flag;
@@ -4516,35 +4873,20 @@ int adios_write_index_v1 (char ** buffer
         index_size += 4;
         attr_size += 4;
 
-        len = strlen (attrs_root->group_name);
-        buffer_write (buffer, buffer_size, buffer_offset, &len, 2);
-        index_size += 2;
-        attr_size += 2;
-        buffer_write (buffer, buffer_size, buffer_offset
-                ,attrs_root->group_name, len
-                );
-        index_size += len;
-        attr_size += len;
+        string_size = write_index_string_v1 (buffer, buffer_size, buffer_offset
+                                            ,st, attrs_root->group_name);
+        index_size += string_size;
+        attr_size += string_size;
 
-        len = strlen (attrs_root->attr_name);
-        buffer_write (buffer, buffer_size, buffer_offset, &len, 2);
-        index_size += 2;
-        attr_size += 2;
-        buffer_write (buffer, buffer_size, buffer_offset
-                ,attrs_root->attr_name, len
-                );
-        index_size += len;
-        attr_size += len;
+        string_size = write_index_string_v1 (buffer, buffer_size, buffer_offset
+                                            ,st, attrs_root->attr_name);
+        index_size += string_size;
+        attr_size += string_size;
 
-        len = strlen (attrs_root->attr_path);
-        buffer_write (buffer, buffer_size, buffer_offset, &len, 2);
-        index_size += 2;
-        attr_size += 2;
-        buffer_write (buffer, buffer_size, buffer_offset
-                ,attrs_root->attr_path, len
-                );
-        index_size += len;
-        attr_size += len;
+        string_size = write_index_string_v1 (buffer, buffer_size, buffer_offset
+                                            ,st, attrs_root->attr_path);
+        index_size += string_size;
+        attr_size += string_size;
 
         flag = attrs_root->type;
         buffer_write (buffer, buffer_size, buffer_offset, &flag, 1);
@@ -4746,6 +5088,9 @@ int adios_write_index_v1 (char ** buffer
     buffer_write (buffer, buffer_size, &buffer_offset_start, &attrs_count, 4);
     buffer_write (buffer, buffer_size, &buffer_offset_start, &index_size, 8);
 
+    if (st)
+        index_string_table_free_v1 (st);
+
 
     /* Since ADIOS 1.4 Write new information before the last 24+4 bytes into the footer
        New information's format
@@ -4778,6 +5123,30 @@ int adios_write_index_v1 (char ** buffer
     return 0;
 }
 
+int adios_write_index_v1 (char ** buffer
+        ,uint64_t * buffer_size
+        ,uint64_t * buffer_offset
+        ,uint64_t index_start
+        ,struct adios_index_struct_v1 * index
+        )
+{
+    return write_index_v1 (buffer, buffer_size, buffer_offset, index_start
+                          ,index, 0
+                          );
+}
+
+int adios_write_index_with_string_table_v1 (char ** buffer
+        ,uint64_t * buffer_size
+        ,uint64_t * buffer_offset
+        ,uint64_t index_start
+        ,struct adios_index_struct_v1 * index
+        )
+{
+    return write_index_v1 (buffer, buffer_size, buffer_offset, index_start
+                          ,index, 1
+                          );
+}
+
 int adios_write_version_v1 (char ** buffer
         ,uint64_t * buffer_size
         ,uint64_t * buffer_offset
@@ -5246,6 +5615,40 @@ uint16_t adios_write_var_characteristics_v1 (struct adios_file_struct * fd
     return index_size;
 }
 
+/* Build the zone map of the block of 'var' being written. The slabs are along the
+   slowest varying dimension with more than one element, which is the first one
+   in C order, and the last one in Fortran order. */
+static void generate_zone_map (struct adios_file_struct * fd, struct adios_var_struct * var,
+                               enum ADIOS_DATATYPES type, uint64_t total_size)
+{
+    struct adios_dimension_struct * d = (var->transform_type != adios_transform_none ?
+                                         var->pre_transform_dimensions : var->dimensions);
+    uint64_t count [32];
+    int ndim = 0, slab_dim;
+    uint64_t nelements = total_size / adios_get_type_size (type, NULL);
+
+    for (; d && ndim < 32; d = d->next)
+    {
+        uint64_t c = adios_get_dim_value (&d->dimension);
+        if (fd->group->adios_host_language_fortran == adios_flag_yes)
+        {
+            memmove (count + 1, count, ndim * sizeof (uint64_t));
+            count [0] = c;
+        }
+        else
+        {
+            count [ndim] = c;
+        }
+        ndim++;
+    }
+
+    slab_dim = adios_zone_map_slab_dim (ndim, count);
+    if (slab_dim < 0 || nelements % count [slab_dim])
+        return;
+    adios_zone_map_build (type, var->data, count [slab_dim], nelements / count [slab_dim],
+                          var->zone_map->zone_elements, &var->zone_map->map, &var->zone_map->map_size);
+}
+
 int adios_generate_var_characteristics_v1 (struct adios_file_struct * fd, struct adios_var_struct * var)
 {
     uint64_t total_size = 0;
@@ -5259,6 +5662,28 @@ int adios_generate_var_characteristics_v1 (struct adios_file_struct * fd, struct
         total_size = adios_get_var_size (var, var->data);
     }
 
+    // Index the raw data of the block for the bitmap index, which is written
+    // after the variable itself (see common_adios_write)
+    if (var->bitmap_index && var->bitmap_index->num_breaks && var->data)
+    {
+        struct adios_bitmap_index_struct * bi = var->bitmap_index;
+        free (bi->index);
+        adios_bitmap_index_build (original_var_type, var->data,
+                total_size / adios_get_type_size (original_var_type, NULL),
+                bi->num_breaks, bi->breaks, &bi->index, &bi->index_size);
+    }
+
+    // Min/max of the zones of the block for the zone map, written after the
+    // variable itself too
+    if (var->zone_map && var->data)
+    {
+        struct adios_zone_map_struct * zm = var->zone_map;
+        free (zm->map);
+        zm->map = NULL;
+        zm->map_size = 0;
+        generate_zone_map (fd, var, original_var_type, total_size);
+    }
+
     if (var->bitmap == 0)
         return 0;
 
@@ -5330,6 +5755,7 @@ int adios_generate_var_characteristics_v1 (struct adios_file_struct * fd, struct
         *cnt = 0;\
         if (map[adios_statistic_hist] != -1) {\
             hist = (struct adios_hist_struct *) stats[map[adios_statistic_hist]].data; \
+            free (hist->frequencies); \
             hist->frequencies = calloc ((hist->num_breaks + 1), adios_get_type_size(adios_unsigned_integer, "")); \
         } \
         int have_finite_value = 0; \
@@ -49,6 +49,10 @@ struct adios_stat_struct
 };
 
 
+// Number of previous writes of a transformed variable whose storage ratios
+// are kept to predict the buffer space the next write needs
+#define ADIOS_TRANSFORM_RATIO_HISTORY 4
+
 struct adios_var_struct
 {
     uint32_t id;
@@ -84,10 +88,39 @@ struct adios_var_struct
     struct adios_dimension_struct *pre_transform_dimensions;
     uint16_t transform_metadata_len;
     void *transform_metadata;
+    // Transformed/original size of the last writes (a ring of the last
+    // transform_ratio_count values, the next one goes to transform_ratio_next)
+    float transform_ratio[ADIOS_TRANSFORM_RATIO_HISTORY];
+    uint8_t transform_ratio_count;
+    uint8_t transform_ratio_next;
+
+    // Write-time bitmap index (NULL if the variable is not indexed)
+    struct adios_bitmap_index_struct * bitmap_index;
+    // Write-time zone map (NULL if the variable has none)
+    struct adios_zone_map_struct * zone_map;
 
     struct adios_var_struct * next;
 };
 
+// Write-time bitmap index of a variable (see adios_bitmap_index.h)
+struct adios_bitmap_index_struct
+{
+    uint32_t num_breaks; // bin edges, the histogram break points
+    double * breaks;
+    struct adios_var_struct * index_var; // hidden variable the index blocks are written to
+    void * index;        // index of the block being written
+    uint64_t index_size;
+};
+
+// Write-time min/max of the zones of each block of a variable (see adios_zone_map.h)
+struct adios_zone_map_struct
+{
+    uint64_t zone_elements;  // requested number of elements in a zone
+    struct adios_var_struct * map_var; // hidden variable the zone maps are written to
+    void * map;              // zone map of the block being written
+    uint64_t map_size;
+};
+
 // NCSU - structure for histogram
 struct adios_hist_struct
 {
@@ -621,8 +654,24 @@ int adios_common_define_var_characteristics  (struct adios_group_struct * g
                                               ,const char * bin_min
                                               ,const char * bin_max
                                               ,const char * bin_count
+                                              ,const char * index
                                              );
 
+// build a bitmap index of a variable at write time, with bins given by break points
+int adios_common_define_var_bitmap_index (struct adios_group_struct * g
+                                         ,const char * var_name
+                                         ,uint32_t num_breaks
+                                         ,const double * breaks
+                                         );
+void adios_free_bitmap_index (struct adios_bitmap_index_struct * bi);
+
+// record the min/max of zones of about zone_elements elements in every block of a variable
+int adios_common_define_var_zone_map (struct adios_group_struct * g
+                                     ,const char * var_name
+                                     ,uint64_t zone_elements
+                                     );
+void adios_free_zone_map (struct adios_zone_map_struct * zm);
+
 struct adios_group_struct * adios_common_get_group (const char * name);
 int adios_common_delete_attrdefs (struct adios_group_struct * g);
 int adios_common_delete_vardefs (struct adios_group_struct * g);
@@ -683,6 +732,16 @@ int adios_write_index_v1 (char ** buffer
                          ,struct adios_index_struct_v1 * index
                          );
 
+// same as adios_write_index_v1() but each index section starts with a
+// table of its strings and the entries refer to them by id (smaller
+// footer, only readable by ADIOS versions that know the table)
+int adios_write_index_with_string_table_v1 (char ** buffer
+                         ,uint64_t * buffer_size
+                         ,uint64_t * buffer_offset
+                         ,uint64_t index_start
+                         ,struct adios_index_struct_v1 * index
+                         );
+
 void adios_build_index_v1 (struct adios_file_struct * fd
                          ,struct adios_index_struct_v1 * index
                        );
@@ -692,15 +751,12 @@ void adios_merge_index_v1 (
                   ,struct adios_index_process_group_struct_v1 * new_pg_root
                   ,struct adios_index_var_struct_v1 * new_vars_root
                   ,struct adios_index_attribute_struct_v1 * new_attrs_root
-                  ,int needs_sorting // merge-sort the characteristics to keep the time in order
+                  ,int needs_sorting // characteristics may come out of time order, sort before writing
                   );
 
-/* obsolete, merge the index with sorting
-void adios_sort_index_v1 (struct adios_index_process_group_struct_v1 ** p1
-                         ,struct adios_index_var_struct_v1 ** v1
-                         ,struct adios_index_attribute_struct_v1 ** a1
-                         );
-*/
+// sort PGs and var characteristics by time if they were merged out of order
+// (called by adios_write_index_v1)
+void adios_sort_index_v1 (struct adios_index_struct_v1 * index);
  
 void adios_clear_index_v1 (struct adios_index_struct_v1 * index); // in each adios_<method>_close()
 void adios_free_index_v1 (struct adios_index_struct_v1 * index);  // in adios_<method>_finalize()
@@ -1853,6 +1853,8 @@ static int parseAnalysis (mxml_node_t * node)
     const char * bin_count = 0;
     const char * bin_min = 0;
     const char * bin_max = 0;
+    const char * index = 0;
+    const char * zone_size = 0;
 
     int i;
     int64_t group_id;
@@ -1868,6 +1870,8 @@ static int parseAnalysis (mxml_node_t * node)
             GET_ATTR("min",attr,bin_min,"analysis")
             GET_ATTR("max",attr,bin_max,"analysis")
             GET_ATTR("count",attr,bin_count,"analysis")
+            GET_ATTR("index",attr,index,"analysis")
+            GET_ATTR("zone-size",attr,zone_size,"analysis")
             log_warn ("config.xml: unknown attribute '%s' on %s "
                     "(ignored)\n"
                     ,attr->name
@@ -1893,7 +1897,15 @@ static int parseAnalysis (mxml_node_t * node)
         log_warn ("config.xml: Didn't find group %s for analysis\n", group);
         return 0;
     }
-    if(!adios_common_define_var_characteristics(g, var, bin_intervals, bin_min, bin_max, bin_count))
+    if (zone_size)
+    {
+        if (adios_common_define_var_zone_map (g, var, strtoull (zone_size, NULL, 10)))
+            return 0;
+        // a zone map alone needs no histogram
+        if (!bin_intervals && !bin_min && !bin_max && !bin_count && !index)
+            return 1;
+    }
+    if(!adios_common_define_var_characteristics(g, var, bin_intervals, bin_min, bin_max, bin_count, index))
         return 0;
 
     return 1;
@@ -2758,6 +2770,9 @@ void adios_cleanup ()
             // NCSU ALACRITY-ADIOS - Clean transform metadata
             adios_transform_clear_transform_var(adios_groups->group->vars);
 
+            adios_free_bitmap_index (adios_groups->group->vars->bitmap_index);
+            adios_free_zone_map (adios_groups->group->vars->zone_map);
+
             if (adios_groups->group->vars->adata)
                 free (adios_groups->group->vars->adata);
 
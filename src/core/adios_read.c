@@ -90,6 +90,12 @@ int adios_inq_var_blockinfo (ADIOS_FILE *fp, ADIOS_VARINFO * varinfo)
     return common_read_inq_var_blockinfo (fp, varinfo);
 }
 
+int adios_inq_var_scalar_steps (ADIOS_FILE *fp, ADIOS_VARINFO * varinfo,
+                                int from_steps, int nsteps, int all_blocks, void * data)
+{
+    return common_read_inq_var_scalar_steps (fp, varinfo, from_steps, nsteps, all_blocks, data);
+}
+
 ADIOS_MESH * adios_inq_mesh_byid (ADIOS_FILE *fp, int meshid)
 {
     return common_read_inq_mesh_byid (fp, meshid);
@@ -54,9 +54,30 @@ ADIOS_VARTRANSFORM *  adios_inq_var_transform(const ADIOS_FILE *fp, const ADIOS_
 		.sum_nblocks = varinfo->sum_nblocks,
 		.transform_type = tinfo->transform_type,
 		.should_free_transform_metadata = tinfo->should_free_transform_metadata,
-		.transform_metadatas = tinfo->transform_metadatas
+		.transform_metadatas = tinfo->transform_metadatas,
+		.num_stages = 0,
+		.stage_types = NULL
 	};
 
+	// Report the transform chain; a pipeline records its stages in each block's metadata
+	if (tinfo->transform_type == adios_transform_pipeline && varinfo->sum_nblocks > 0) {
+		struct adios_transform_pipeline_stage stages[ADIOS_TRANSFORM_PIPELINE_MAX_STAGES];
+		int nstages = adios_transform_pipeline_parse_metadata(
+				tinfo->transform_metadatas[0].content, (uint16_t)tinfo->transform_metadatas[0].length,
+				stages, ADIOS_TRANSFORM_PIPELINE_MAX_STAGES);
+		if (nstages > 0) {
+			int i;
+			vartransform->num_stages = nstages;
+			vartransform->stage_types = (adios_transform_type_t*) malloc(nstages * sizeof(adios_transform_type_t));
+			for (i = 0; i < nstages; i++)
+				vartransform->stage_types[i] = stages[i].transform_type;
+		}
+	} else if (tinfo->transform_type != adios_transform_none) {
+		vartransform->num_stages = 1;
+		vartransform->stage_types = (adios_transform_type_t*) malloc(sizeof(adios_transform_type_t));
+		vartransform->stage_types[0] = tinfo->transform_type;
+	}
+
 	// Transfer ownership of the transform_metadatas array to the new struct, then free the struct
 	tinfo->transform_metadatas = NULL;
 	common_read_free_transinfo(varinfo, tinfo);
@@ -74,6 +95,7 @@ void adios_free_var_transform(ADIOS_VARTRANSFORM *vartransform) {
 		}
 		MYFREE(vartransform->transform_metadatas);
 	}
+	MYFREE(vartransform->stage_types);
 	MYFREE(vartransform);
 }
 
@@ -27,6 +27,7 @@ if (!strcasecmp (buf,b)) \
 (*t) [b].adios_inq_var_byid_fn = adios_read_##a##_inq_var_byid; \
 (*t) [b].adios_inq_var_stat_fn = adios_read_##a##_inq_var_stat; \
 (*t) [b].adios_inq_var_blockinfo_fn = adios_read_##a##_inq_var_blockinfo; \
+(*t) [b].adios_inq_var_scalar_steps_fn = adios_read_##a##_inq_var_scalar_steps; \
 (*t) [b].adios_schedule_read_byid_fn = adios_read_##a##_schedule_read_byid; \
 (*t) [b].adios_perform_reads_fn = adios_read_##a##_perform_reads; \
 (*t) [b].adios_check_reads_fn = adios_read_##a##_check_reads; \
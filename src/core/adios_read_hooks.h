@@ -26,6 +26,7 @@ void adios_read_##a##_release_step (ADIOS_FILE *fp); \
 ADIOS_VARINFO * adios_read_##a##_inq_var_byid (const ADIOS_FILE *gp, int varid); \
 int adios_read_##a##_inq_var_stat (const ADIOS_FILE *fp, ADIOS_VARINFO * varinfo, int per_step_stat, int per_block_stat); \
 int adios_read_##a##_inq_var_blockinfo (const ADIOS_FILE *fp, ADIOS_VARINFO * varinfo); \
+int adios_read_##a##_inq_var_scalar_steps (const ADIOS_FILE *fp, const ADIOS_VARINFO * varinfo, int from_steps, int nsteps, int all_blocks, void * data); \
 int adios_read_##a##_schedule_read_byid (const ADIOS_FILE * fp, const ADIOS_SELECTION * sel, int varid, int from_steps, int nsteps, void * data) ; \
 int adios_read_##a##_perform_reads (const ADIOS_FILE *fp, int blocking); \
 int adios_read_##a##_check_reads (const ADIOS_FILE * fp, ADIOS_VARCHUNK ** chunk); \
@@ -86,6 +87,8 @@ typedef ADIOS_VARINFO * (* ADIOS_INQ_VAR_BYID_FN) (const ADIOS_FILE *fp, int var
 typedef int  (* ADIOS_INQ_VAR_STAT_FN) (const ADIOS_FILE *fp, ADIOS_VARINFO *varinfo,
                                  int per_step_stat, int per_block_stat);
 typedef int  (* ADIOS_INQ_VAR_BLOCKINFO_FN) (const ADIOS_FILE *fp, ADIOS_VARINFO *varinfo);
+typedef int  (* ADIOS_INQ_VAR_SCALAR_STEPS_FN) (const ADIOS_FILE *fp, const ADIOS_VARINFO *varinfo,
+                                 int from_steps, int nsteps, int all_blocks, void * data);
 typedef int  (* ADIOS_SCHEDULE_READ_BYID_FN) (const ADIOS_FILE * fp, const ADIOS_SELECTION * sel, 
                                  int varid, int from_steps, int nsteps, void * data);
 typedef int  (* ADIOS_PERFORM_READS_FN) (const ADIOS_FILE *fp, int blocking);
@@ -112,6 +115,7 @@ struct adios_read_hooks_struct
     ADIOS_INQ_VAR_BYID_FN           adios_inq_var_byid_fn;
     ADIOS_INQ_VAR_STAT_FN           adios_inq_var_stat_fn;
     ADIOS_INQ_VAR_BLOCKINFO_FN      adios_inq_var_blockinfo_fn;
+    ADIOS_INQ_VAR_SCALAR_STEPS_FN   adios_inq_var_scalar_steps_fn;
     ADIOS_SCHEDULE_READ_BYID_FN     adios_schedule_read_byid_fn;
     ADIOS_PERFORM_READS_FN          adios_perform_reads_fn;
     ADIOS_CHECK_READS_FN            adios_check_reads_fn;
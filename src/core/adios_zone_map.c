@@ -0,0 +1,184 @@
+/*
+ * adios_zone_map.c  Write-time min/max of the zones of each block of a variable
+ *
+ * See adios_zone_map.h for the zone map layout.
+ */
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include "core/adios_zone_map.h"
+
+#define HEADER_SIZE 32
+
+static int type_size (enum ADIOS_DATATYPES type)
+{
+    switch (type)
+    {
+        case adios_byte:
+        case adios_unsigned_byte:    return 1;
+        case adios_short:
+        case adios_unsigned_short:   return 2;
+        case adios_integer:
+        case adios_unsigned_integer:
+        case adios_real:             return 4;
+        case adios_long:
+        case adios_unsigned_long:
+        case adios_double:           return 8;
+        default:                     return 0;
+    }
+}
+
+int adios_zone_map_supports_type (enum ADIOS_DATATYPES type)
+{
+    return (type_size (type) > 0);
+}
+
+int adios_zone_map_slab_dim (int ndim, const uint64_t * count)
+{
+    int d;
+    for (d = 0; d < ndim; d++)
+    {
+        if (count [d] > 1)
+            return d;
+    }
+    return -1;
+}
+
+/* Min/max of the zones of integer type T */
+#define ZONES_INT(T) \
+    { \
+        const T * d = (const T *) data; \
+        T * mins = (T *) (p + HEADER_SIZE); \
+        T * maxs = mins + nzones; \
+        for (z = 0; z < nzones; z++) \
+        { \
+            uint64_t i = z * zone_n, end = i + zone_n; \
+            if (end > n) \
+                end = n; \
+            T lo = d [i], hi = d [i]; \
+            for (i++; i < end; i++) \
+            { \
+                if (d [i] < lo) lo = d [i]; \
+                if (d [i] > hi) hi = d [i]; \
+            } \
+            mins [z] = lo; \
+            maxs [z] = hi; \
+        } \
+        break; \
+    }
+
+/* Min/max of the zones of floating point type T, without NaNs */
+#define ZONES_REAL(T,INF) \
+    { \
+        const T * d = (const T *) data; \
+        T * mins = (T *) (p + HEADER_SIZE); \
+        T * maxs = mins + nzones; \
+        for (z = 0; z < nzones; z++) \
+        { \
+            uint64_t i = z * zone_n, end = i + zone_n; \
+            if (end > n) \
+                end = n; \
+            T lo = INF, hi = -INF; \
+            for (; i < end; i++) \
+            { \
+                if (d [i] < lo) lo = d [i]; \
+                if (d [i] > hi) hi = d [i]; \
+            } \
+            mins [z] = lo; \
+            maxs [z] = hi; \
+        } \
+        break; \
+    }
+
+void adios_zone_map_build (enum ADIOS_DATATYPES type, const void * data,
+                           uint64_t nslabs, uint64_t slab_elements, uint64_t zone_elements,
+                           void ** map, uint64_t * size)
+{
+    int elemsize = type_size (type);
+    uint64_t slabs_per_zone = (slab_elements ? zone_elements / slab_elements : 1);
+    uint64_t nzones, zone_n, n = nslabs * slab_elements, z;
+    uint32_t magic = ADIOS_ZONE_MAP_MAGIC;
+    uint32_t t = (uint32_t) type;
+    char * p;
+
+    *map = NULL;
+    *size = 0;
+    if (!elemsize || !data || !n)
+        return;
+
+    if (slabs_per_zone < 1)
+        slabs_per_zone = 1;
+    if (slabs_per_zone > nslabs)
+        slabs_per_zone = nslabs;
+    nzones = (nslabs + slabs_per_zone - 1) / slabs_per_zone;
+    zone_n = slabs_per_zone * slab_elements;
+
+    p = (char *) malloc (HEADER_SIZE + 2 * nzones * elemsize);
+    if (!p)
+        return;
+
+    memcpy (p, &magic, 4);
+    memcpy (p + 4, &t, 4);
+    memcpy (p + 8, &nslabs, 8);
+    memcpy (p + 16, &slabs_per_zone, 8);
+    memcpy (p + 24, &nzones, 8);
+
+    switch (type)
+    {
+        case adios_byte:             ZONES_INT(int8_t)
+        case adios_unsigned_byte:    ZONES_INT(uint8_t)
+        case adios_short:            ZONES_INT(int16_t)
+        case adios_unsigned_short:   ZONES_INT(uint16_t)
+        case adios_integer:          ZONES_INT(int32_t)
+        case adios_unsigned_integer: ZONES_INT(uint32_t)
+        case adios_long:             ZONES_INT(int64_t)
+        case adios_unsigned_long:    ZONES_INT(uint64_t)
+        case adios_real:             ZONES_REAL(float, HUGE_VALF)
+        case adios_double:           ZONES_REAL(double, HUGE_VAL)
+        default: break;
+    }
+
+    *map = p;
+    *size = HEADER_SIZE + 2 * nzones * elemsize;
+}
+
+#undef ZONES_INT
+#undef ZONES_REAL
+
+int adios_zone_map_parse (const void * map, uint64_t size, ADIOS_ZONE_MAP_BLOCK * block)
+{
+    const char * p = (const char *) map;
+    uint32_t magic, t;
+
+    memset (block, 0, sizeof(ADIOS_ZONE_MAP_BLOCK));
+    if (!p || size < HEADER_SIZE)
+        return 1;
+
+    memcpy (&magic, p, 4);
+    memcpy (&t, p + 4, 4);
+    memcpy (&block->nslabs, p + 8, 8);
+    memcpy (&block->slabs_per_zone, p + 16, 8);
+    memcpy (&block->nzones, p + 24, 8);
+    block->type = (enum ADIOS_DATATYPES) t;
+    block->elemsize = type_size (block->type);
+
+    if (magic != ADIOS_ZONE_MAP_MAGIC || !block->elemsize || !block->slabs_per_zone ||
+        block->nzones != (block->nslabs + block->slabs_per_zone - 1) / block->slabs_per_zone ||
+        (size - HEADER_SIZE) / (2 * block->elemsize) < block->nzones)
+        return 1;
+
+    block->mins = p + HEADER_SIZE;
+    block->maxs = block->mins + block->nzones * block->elemsize;
+    return 0;
+}
+
+void adios_zone_map_zone (const ADIOS_ZONE_MAP_BLOCK * block, uint64_t zone,
+                          uint64_t * first, uint64_t * n, const void ** min, const void ** max)
+{
+    *first = zone * block->slabs_per_zone;
+    *n = block->slabs_per_zone;
+    if (*first + *n > block->nslabs)
+        *n = block->nslabs - *first;
+    *min = block->mins + zone * block->elemsize;
+    *max = block->maxs + zone * block->elemsize;
+}
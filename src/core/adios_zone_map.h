@@ -0,0 +1,68 @@
+/*
+ * adios_zone_map.h  Write-time min/max of the zones of each block of a variable
+ *
+ * When a zone map is defined for an array variable, every written block is cut
+ * into zones along its slowest varying dimension (the first dimension in C
+ * order that has more than one element, the slab dimension), each zone being a
+ * number of consecutive slabs. The min and max of every zone are recorded, so
+ * that readers can skip or read parts of a block instead of whole blocks.
+ * NaN values are not included in min/max, a zone with only NaNs has min=+Inf,
+ * max=-Inf.
+ *
+ * The zone map of each block is written as the block of a hidden byte array
+ * variable, ADIOS_ZONE_MAP_PATH + the variable's full path, which is written
+ * right after the block of the variable itself.
+ *
+ * Layout of one zone map block (native byte order):
+ *   uint32_t  magic
+ *   uint32_t  type               type of the variable (enum ADIOS_DATATYPES)
+ *   uint64_t  nslabs             number of slabs in the block
+ *   uint64_t  slabs_per_zone
+ *   uint64_t  nzones
+ *   T         mins[nzones]       in the type of the variable
+ *   T         maxs[nzones]
+ */
+#ifndef ADIOS_ZONE_MAP_H
+#define ADIOS_ZONE_MAP_H
+
+#include <stdint.h>
+#include "public/adios_types.h"
+
+#define ADIOS_ZONE_MAP_PATH "/__adios__/zone_map"
+#define ADIOS_ZONE_MAP_MAGIC 0x50414D5A  /* "ZMAP" */
+
+/* Check if variables of this type can have a zone map */
+int adios_zone_map_supports_type (enum ADIOS_DATATYPES type);
+
+/* The slab dimension of a block with 'ndim' dimensions of 'count' (slowest first),
+   -1 if the block has at most one element */
+int adios_zone_map_slab_dim (int ndim, const uint64_t * count);
+
+/* Build the zone map of a block of 'nslabs' slabs of 'slab_elements' elements each,
+   with zones of about 'zone_elements' elements (at least one slab).
+   Returns the allocated zone map block in 'map' and its size in 'size',
+   NULL and 0 if it cannot be allocated. */
+void adios_zone_map_build (enum ADIOS_DATATYPES type, const void * data,
+                           uint64_t nslabs, uint64_t slab_elements, uint64_t zone_elements,
+                           void ** map, uint64_t * size);
+
+/* One zone map block as read back */
+typedef struct {
+    enum ADIOS_DATATYPES type;
+    int         elemsize;
+    uint64_t    nslabs;
+    uint64_t    slabs_per_zone;
+    uint64_t    nzones;
+    const char *mins;
+    const char *maxs;
+} ADIOS_ZONE_MAP_BLOCK;
+
+/* Interpret a zone map block read into memory.
+   Returns 0 on success, 1 if the block is not a usable zone map. */
+int adios_zone_map_parse (const void * map, uint64_t size, ADIOS_ZONE_MAP_BLOCK * block);
+
+/* Slabs [*first, *first + *n) of a zone, and pointers to its min and max */
+void adios_zone_map_zone (const ADIOS_ZONE_MAP_BLOCK * block, uint64_t zone,
+                          uint64_t * first, uint64_t * n, const void ** min, const void ** max);
+
+#endif
@@ -278,12 +278,14 @@ void FC_FUNC_(adios_write, ADIOS_WRITE)
                 {   
                     if (j == adios_statistic_hist)
                     {   
-                        struct adios_index_characteristics_hist_struct * hist =
-                            (struct adios_index_characteristics_hist_struct *) v->stats[c][idx].data;
-                        free (hist->breaks);
-                        free (hist->frequencies);
-                        free (hist);
-                        v->stats[c][idx].data = 0;
+                        // keep the definition of the histogram for the next steps
+                        struct adios_hist_struct * hist =
+                            (struct adios_hist_struct *) v->stats[c][idx].data;
+                        if (hist)
+                        {
+                            free (hist->frequencies);
+                            hist->frequencies = 0;
+                        }
                     }
                     else
                     {   
@@ -61,6 +61,8 @@ struct BP_file_handle_header
 
 typedef struct BP_file_handle_header BP_file_handle_list;
 
+struct bp_string_table; /* see bp_utils.c */
+
 typedef struct BP_FILE {
     MPI_File mpi_fh;
     char * fname; // Main file name is needed to calculate subfile names
@@ -76,6 +78,7 @@ typedef struct BP_FILE {
     struct BP_GROUP_ATTR * gattr_h;
     uint32_t tidx_start;
     uint32_t tidx_stop;
+    struct bp_string_table * strtbl; // Group names and paths shared by the index, 0 if not used
     void * priv;
 } BP_FILE;
 
@@ -22,6 +22,7 @@
 #include "core/adios_endianness.h"
 #include "core/adios_logger.h"
 #include "core/futils.h"
+#include "core/qhashtbl.h"
 #define BYTE_ALIGN 8
 #define MINIFOOTER_SIZE 28
 
@@ -292,6 +293,210 @@ static int bp_read_open_rootonly (const char * filename,
     return err;
 }
 
+/* Group names, paths and time index names repeat in every PG, variable and
+ * attribute entry of the index. They are stored only once per file in this
+ * table and the index structs point into it. The id of a string is its
+ * position in 'strings', so group names can be matched by id instead of
+ * comparing the strings.
+ */
+struct bp_string_table
+{
+    qhashtbl_t * ids;   // string -> id+1
+    char ** strings;
+    int * group_ids;    // group index of each string, -1 if it is not a group name
+    uint32_t count;
+    uint32_t allocated;
+};
+
+static struct bp_string_table * bp_string_table_alloc ()
+{
+    struct bp_string_table * st = (struct bp_string_table *)
+                                  malloc (sizeof (struct bp_string_table));
+    assert (st);
+    st->ids = qhashtbl (100);
+    st->strings = 0;
+    st->group_ids = 0;
+    st->count = 0;
+    st->allocated = 0;
+    return st;
+}
+
+void bp_string_table_free (struct bp_string_table * st)
+{
+    uint32_t i;
+    if (!st)
+        return;
+    for (i = 0; i < st->count; i++)
+        free (st->strings[i]);
+    free (st->strings);
+    free (st->group_ids);
+    st->ids->free (st->ids);
+    free (st);
+}
+
+/* Return the shared copy of the first len characters of s, 
+ * and its id in 'id' if not NULL. */
+static char * bp_intern_string (BP_FILE * fh, const char * s, uint16_t len, uint32_t * id)
+{
+    struct bp_string_table * st;
+    char tmp[256];
+    char * str = (len < sizeof(tmp) ? tmp : (char *) malloc (len + 1));
+    intptr_t k;
+
+    if (!fh->strtbl)
+        fh->strtbl = bp_string_table_alloc ();
+    st = fh->strtbl;
+
+    memcpy (str, s, len);
+    str[len] = '\0';
+
+    k = (intptr_t) st->ids->get (st->ids, str);
+    if (!k)
+    {
+        if (st->count == st->allocated)
+        {
+            st->allocated = (st->allocated ? 2 * st->allocated : 16);
+            st->strings = (char **) realloc (st->strings, st->allocated * sizeof (char *));
+            st->group_ids = (int *) realloc (st->group_ids, st->allocated * sizeof (int));
+            assert (st->strings && st->group_ids);
+        }
+        st->strings[st->count] = (str == tmp ? strdup (tmp) : str);
+        st->group_ids[st->count] = -1;
+        st->count++;
+        k = st->count;
+        st->ids->put (st->ids, st->strings[k-1], (void *) k);
+    }
+    else if (str != tmp)
+    {
+        free (str);
+    }
+
+    if (id)
+        *id = (uint32_t) (k-1);
+    return st->strings[k-1];
+}
+
+/* The string table at the start of an index section written by
+ * adios_write_index_with_string_table_v1(). The strings point into the
+ * footer buffer and are interned into fh->strtbl when first used.
+ */
+struct bp_section_strings
+{
+    uint32_t count;
+    uint16_t * lens;
+    const char ** raw;
+    char ** interned;
+    uint32_t * ids;     // ids of the interned strings in fh->strtbl
+};
+
+static struct bp_section_strings * bp_parse_section_strings (BP_FILE * fh)
+{
+    struct adios_bp_buffer_struct_v1 * b = fh->b;
+    struct bp_section_strings * t = (struct bp_section_strings *)
+                                    malloc (sizeof (struct bp_section_strings));
+    uint32_t i;
+
+    assert (t);
+    BUFREAD32(b, t->count)
+    t->lens = (uint16_t *) malloc (t->count * sizeof (uint16_t));
+    t->raw = (const char **) malloc (t->count * sizeof (char *));
+    t->interned = (char **) calloc (t->count, sizeof (char *));
+    t->ids = (uint32_t *) malloc (t->count * sizeof (uint32_t));
+    for (i = 0; i < t->count; i++)
+    {
+        BUFREAD16(b, t->lens[i])
+        t->raw[i] = b->buff + b->offset;
+        b->offset += t->lens[i];
+    }
+    return t;
+}
+
+static void bp_free_section_strings (struct bp_section_strings * t)
+{
+    if (!t)
+        return;
+    free (t->lens);
+    free (t->raw);
+    free (t->interned);
+    free (t->ids);
+    free (t);
+}
+
+/* Read the id of a string of an index entry that refers to table t */
+static uint32_t bp_read_string_id (BP_FILE * fh, struct bp_section_strings * t)
+{
+    struct adios_bp_buffer_struct_v1 * b = fh->b;
+    uint32_t id;
+
+    BUFREAD32(b, id)
+    if (id >= t->count)
+    {
+        adios_error (err_invalid_buffer_index, "String id %u is out of the range "
+                     "of the index string table of %u strings\n", id, t->count);
+        return t->count;
+    }
+    return id;
+}
+
+/* Return the shared copy of the next string of an index entry and its id
+ * in 'id' if not NULL. The entry has an id into t if the section has a
+ * string table, otherwise the length and the characters. */
+static char * bp_read_interned_string (BP_FILE * fh, struct bp_section_strings * t,
+                                       uint32_t * id)
+{
+    struct adios_bp_buffer_struct_v1 * b = fh->b;
+    uint16_t len;
+    char * s;
+
+    if (t)
+    {
+        uint32_t sid = bp_read_string_id (fh, t);
+        if (sid == t->count)
+            return bp_intern_string (fh, "", 0, id);
+        if (!t->interned[sid])
+            t->interned[sid] = bp_intern_string (fh, t->raw[sid], t->lens[sid],
+                                                 &t->ids[sid]);
+        if (id)
+            *id = t->ids[sid];
+        return t->interned[sid];
+    }
+
+    BUFREAD16(b, len)
+    s = bp_intern_string (fh, b->buff + b->offset, len, id);
+    b->offset += len;
+    return s;
+}
+
+/* Same as bp_read_interned_string() but return a new copy of the string */
+static char * bp_read_string (BP_FILE * fh, struct bp_section_strings * t)
+{
+    struct adios_bp_buffer_struct_v1 * b = fh->b;
+    const char * s = "";
+    uint16_t len = 0;
+    char * str;
+
+    if (t)
+    {
+        uint32_t sid = bp_read_string_id (fh, t);
+        if (sid < t->count)
+        {
+            s = t->raw[sid];
+            len = t->lens[sid];
+        }
+    }
+    else
+    {
+        BUFREAD16(b, len)
+        s = b->buff + b->offset;
+        b->offset += len;
+    }
+
+    str = (char *) malloc (len + 1);
+    memcpy (str, s, len);
+    str[len] = '\0';
+    return str;
+}
+
 /* This routine does the parallel bp file open and index parsing.
  */
 int bp_open (const char * fname,
@@ -507,6 +712,7 @@ BP_FILE * BP_FILE_alloc (const char * fname, MPI_Comm comm)
     fh->vars_root = 0;
     fh->attrs_root = 0;
     fh->vars_table = 0;
+    fh->strtbl = 0;
     fh->b = malloc (sizeof (struct adios_bp_buffer_struct_v1));
     assert (fh->b);
     fh->subfile_handles.n_handles = 0;
@@ -658,12 +864,10 @@ int bp_close (BP_FILE * fh)
         }
         if (vr->characteristics)
             free (vr->characteristics);
-        if (vr->group_name)
-            free (vr->group_name);
+        BP_FREE_INDEX_STRING (fh, vr->group_name)
         if (vr->var_name)
             free (vr->var_name);
-        if (vr->var_path)
-            free (vr->var_path);
+        BP_FREE_INDEX_STRING (fh, vr->var_path)
         free(vr);
     }
 
@@ -695,12 +899,10 @@ int bp_close (BP_FILE * fh)
         }
         if (ar->characteristics)
             free (ar->characteristics);
-        if (ar->group_name)
-            free (ar->group_name);
+        BP_FREE_INDEX_STRING (fh, ar->group_name)
         if (ar->attr_name)
             free (ar->attr_name);
-        if (ar->attr_path)
-            free (ar->attr_path);
+        BP_FREE_INDEX_STRING (fh, ar->attr_path)
         free(ar);
     }
 
@@ -713,15 +915,16 @@ int bp_close (BP_FILE * fh)
         pr = pgs_root;
         pgs_root = pgs_root->next;
         //printf("%d\tpg pid=%d addr=%x next=%x\n",i, pr->process_id, pr, pr->next);
-        if (pr->group_name)
-            free(pr->group_name);
-        if (pr->time_index_name)
-            free(pr->time_index_name);
+        BP_FREE_INDEX_STRING (fh, pr->group_name)
+        BP_FREE_INDEX_STRING (fh, pr->time_index_name)
         free(pr);
     }
 
     fh->pgs_root = 0;
 
+    bp_string_table_free (fh->strtbl);
+    fh->strtbl = 0;
+
     /* Free variable structures in BP_GROUP_VAR */
     if (gh) {
         for (j=0;j<2;j++) {
@@ -968,10 +1171,18 @@ int bp_parse_pgs (BP_FILE * fh)
     BUFREAD64(b, mh->pgs_count)
         BUFREAD64(b, mh->pgs_length)
 
+    struct bp_section_strings * st = NULL;
+    if (mh->pgs_count & ADIOS_INDEX_PG_HAVE_STRING_TABLE)
+    {
+        mh->pgs_count &= ~ADIOS_INDEX_PG_HAVE_STRING_TABLE;
+        st = bp_parse_section_strings (fh);
+    }
+
         int j;
     uint64_t group_count = 0;
     char ** namelist;
     char fortran_flag;
+    uint32_t strid;
 
     namelist = (char **) malloc(sizeof(char *)*mh->pgs_count);
     uint16_t * grpidlist = (uint16_t *) malloc(sizeof(uint16_t)*mh->pgs_count);
@@ -991,37 +1202,14 @@ int bp_parse_pgs (BP_FILE * fh)
             memset (*root, 0, sizeof(struct bp_index_pg_struct_v1));
             (*root)->next = 0;
         }
-        uint16_t length_of_name;
-
-        BUFREAD16(b, length_of_name)
-        (*root)->group_name = (char *) malloc (length_of_name + 1);
-        (*root)->group_name [length_of_name] = '\0';
-        memcpy ((*root)->group_name, b->buff + b->offset, length_of_name);
-        b->offset += length_of_name;
+        (*root)->group_name = bp_read_interned_string (fh, st, &strid);
 
-
-        if ( group_count == 0 ) {
-            namelist[group_count] = (char *) malloc (length_of_name + 1);
-            strcpy (namelist[group_count], (*root)->group_name);
+        if (fh->strtbl->group_ids[strid] < 0) {
+            namelist[group_count] = strdup ((*root)->group_name);
+            fh->strtbl->group_ids[strid] = group_count;
             ++group_count;
-            grpidlist[i] = group_count-1;
-        }
-        else {
-            for (j=0; j<group_count; j++) {
-                if (!strcmp(namelist[j], (*root)->group_name)) {
-                    break;
-                }
-            }
-            if (j==group_count) {
-                namelist[group_count] = (char *) malloc (length_of_name + 1);
-                strcpy (namelist[group_count], (*root)->group_name);
-                ++group_count;
-                grpidlist[i] = group_count - 1;
-            }
-            else
-                grpidlist[i] = j;
-
         }
+        grpidlist[i] = fh->strtbl->group_ids[strid];
 
         BUFREAD8(b, fortran_flag)
         (*root)->adios_host_language_fortran =
@@ -1029,11 +1217,7 @@ int bp_parse_pgs (BP_FILE * fh)
 
         BUFREAD32(b, (*root)->process_id)
 
-        BUFREAD16(b, length_of_name)
-        (*root)->time_index_name = (char *) malloc (length_of_name + 1);
-        (*root)->time_index_name [length_of_name] = '\0';
-        memcpy ((*root)->time_index_name, b->buff + b->offset, length_of_name);
-        b->offset += length_of_name;
+        (*root)->time_index_name = bp_read_interned_string (fh, st, NULL);
 
         BUFREAD32(b, (*root)->time_index)
 
@@ -1048,6 +1232,7 @@ int bp_parse_pgs (BP_FILE * fh)
 
         root = &(*root)->next;
     }
+    bp_free_section_strings (st);
 
     /*
     root = &(fh->pgs_root);
@@ -1221,6 +1406,14 @@ int bp_parse_attrs (BP_FILE * fh)
     }
     BUFREAD64(b, mh->attrs_length)
 
+    struct bp_section_strings * st = NULL;
+    if (bpversion > 1 && (mh->attrs_count & ADIOS_INDEX_HAVE_STRING_TABLE))
+    {
+        mh->attrs_count &= ~ADIOS_INDEX_HAVE_STRING_TABLE;
+        st = bp_parse_section_strings (fh);
+    }
+
+    uint32_t * group_strids = (uint32_t *) malloc (sizeof(uint32_t) * mh->attrs_count);
     for (i = 0; i < mh->attrs_count; i++) {
         if (!*root)
         {
@@ -1242,23 +1435,10 @@ int bp_parse_attrs (BP_FILE * fh)
             BUFREAD16(b, (*root)->id)
         }
 
-        BUFREAD16(b, len)
-        (*root)->group_name = (char *) malloc (len + 1);
-        (*root)->group_name [len] = '\0';
-        strncpy ((*root)->group_name, b->buff + b->offset, len);
-        b->offset += len;
-
-        BUFREAD16(b, len)
-        (*root)->attr_name = (char *) malloc (len + 1);
-        (*root)->attr_name [len] = '\0';
-        strncpy ((*root)->attr_name, b->buff + b->offset, len);
-        b->offset += len;
+        (*root)->group_name = bp_read_interned_string (fh, st, &group_strids[i]);
 
-        BUFREAD16(b, len)
-        (*root)->attr_path = (char *) malloc (len + 1);
-        (*root)->attr_path [len] = '\0';
-        strncpy ((*root)->attr_path, b->buff + b->offset, len);
-        b->offset += len;
+        (*root)->attr_name = bp_read_string (fh, st);
+        (*root)->attr_path = bp_read_interned_string (fh, st, NULL);
 
         BUFREAD8(b, flag)
         (*root)->type = (enum ADIOS_DATATYPES) flag;
@@ -1387,12 +1567,10 @@ int bp_parse_attrs (BP_FILE * fh)
     memset (attr_offsets, 0, mh->attrs_count * sizeof(uint64_t *));
 
     for (i = 0; i < mh->attrs_count; i++) {
-        for (grpid = 0; grpid < fh->gattr_h->group_count; grpid++) {
-            if (!strcmp((*root)->group_name, fh->gattr_h->namelist[grpid])) {
-                attr_counts_per_group [grpid]++;
-                attr_gids [i] = grpid;
-                break;
-            }
+        grpid = fh->strtbl->group_ids[group_strids[i]];
+        if (grpid >= 0) {
+            attr_counts_per_group [grpid]++;
+            attr_gids [i] = grpid;
         }
         // Full name of attributes: concatenate attr_path and attr_name
         /*
@@ -1443,6 +1621,8 @@ int bp_parse_attrs (BP_FILE * fh)
     }
     //here is the asssumption that attr_gids is linearly increased
     free(attr_gids);
+    free (group_strids);
+    bp_free_section_strings (st);
 
     fh->gattr_h->attr_namelist = attr_namelist;
     fh->gattr_h->attr_counts_per_group = attr_counts_per_group;
@@ -1529,8 +1709,16 @@ int bp_parse_vars (BP_FILE * fh)
     }
     BUFREAD64(b, mh->vars_length)
 
+    struct bp_section_strings * st = NULL;
+    if (bpversion > 1 && (mh->vars_count & ADIOS_INDEX_HAVE_STRING_TABLE))
+    {
+        mh->vars_count &= ~ADIOS_INDEX_HAVE_STRING_TABLE;
+        st = bp_parse_section_strings (fh);
+    }
+
     // To speed find_var_byid(). Q. Liu, 11-2013.
     fh->vars_table = (struct adios_index_var_struct_v1 **) malloc (8*(size_t)mh->vars_count);
+    uint32_t * group_strids = (uint32_t *) malloc (sizeof(uint32_t) * mh->vars_count);
     // validate remaining length
     int i;
     for (i = 0; i < mh->vars_count; i++) {
@@ -1552,23 +1740,10 @@ int bp_parse_vars (BP_FILE * fh)
             BUFREAD16(b, (*root)->id)
         }
 
-        BUFREAD16(b, len)
-        (*root)->group_name = (char *) malloc (len + 1);
-        (*root)->group_name [len] = '\0';
-        strncpy ((*root)->group_name, b->buff + b->offset, len);
-        b->offset += len;
-
-        BUFREAD16(b, len)
-        (*root)->var_name = (char *) malloc (len + 1);
-        (*root)->var_name [len] = '\0';
-        strncpy ((*root)->var_name, b->buff + b->offset, len);
-        b->offset += len;
+        (*root)->group_name = bp_read_interned_string (fh, st, &group_strids[i]);
 
-        BUFREAD16(b, len)
-        (*root)->var_path = (char *) malloc (len + 1);
-        (*root)->var_path [len] = '\0';
-        strncpy ((*root)->var_path, b->buff + b->offset, len);
-        b->offset += len;
+        (*root)->var_name = bp_read_string (fh, st);
+        (*root)->var_path = bp_read_interned_string (fh, st, NULL);
 
         BUFREAD8(b, flag)
         (*root)->type = (enum ADIOS_DATATYPES) flag;
@@ -1638,12 +1813,10 @@ int bp_parse_vars (BP_FILE * fh)
     memset ( var_offsets, 0, mh->vars_count*sizeof(uint64_t *));
 
     for (i = 0; i < mh->vars_count; i++) {
-        for (grpid=0;grpid<fh->gvar_h->group_count;grpid++) {
-            if (!strcmp((*root)->group_name,fh->gvar_h->namelist[grpid])) {
-                var_counts_per_group [grpid]++;
-                var_gids [i] = grpid;
-                break;
-            }
+        grpid = fh->strtbl->group_ids[group_strids[i]];
+        if (grpid >= 0) {
+            var_counts_per_group [grpid]++;
+            var_gids [i] = grpid;
         }
         /* up until 1.5, name and /name was handled identical */
         /*
@@ -1697,6 +1870,8 @@ int bp_parse_vars (BP_FILE * fh)
 
     //here is the asssumption that var_gids is linearly increased
     free( var_gids);
+    free (group_strids);
+    bp_free_section_strings (st);
     fh->gvar_h->var_namelist = var_namelist;
     fh->gvar_h->var_counts_per_group=var_counts_per_group;
     fh->gvar_h->var_offsets = var_offsets;
@@ -1985,13 +2160,18 @@ SET_DATA_3(t) \
                         if (i == adios_statistic_hist)
                         {
                             uint32_t bi;
+                            double * d;
 
                             (*root)->characteristics [j].stats[c][idx].data = malloc (sizeof(struct adios_index_characteristics_hist_struct));
                             struct adios_index_characteristics_hist_struct * hist = (*root)->characteristics [j].stats[c][idx].data;
 
                             BUFREAD32(b, hist->num_breaks)
-                            hist->min = * (double *) bp_read_data_from_buffer(b, adios_double, 1);
-                            hist->max = * (double *) bp_read_data_from_buffer(b, adios_double, 1);
+                            d = (double *) bp_read_data_from_buffer(b, adios_double, 1);
+                            hist->min = *d;
+                            free (d);
+                            d = (double *) bp_read_data_from_buffer(b, adios_double, 1);
+                            hist->max = *d;
+                            free (d);
 
                             hist->frequencies = malloc((hist->num_breaks + 1) * adios_get_type_size(adios_unsigned_integer, ""));
                             for (bi = 0; bi <= hist->num_breaks; bi ++)
@@ -2002,7 +2182,9 @@ SET_DATA_3(t) \
                             hist->breaks = malloc(hist->num_breaks * adios_get_type_size(adios_double, ""));
                             for (bi = 0; bi < hist->num_breaks; bi ++)
                             {
-                                hist->breaks[bi] = * (double *) bp_read_data_from_buffer(b, adios_double, 1);
+                                d = (double *) bp_read_data_from_buffer(b, adios_double, 1);
+                                hist->breaks[bi] = *d;
+                                free (d);
                             }
                         }
                         else
@@ -41,6 +41,11 @@ int bp_open (const char * fname,
              BP_FILE * fh);
 ADIOS_VARINFO * bp_inq_var_byid (const ADIOS_FILE * fp, int varid);
 int bp_close (BP_FILE * fh);
+void bp_string_table_free (struct bp_string_table * st);
+
+/* Free a string of the index unless it is owned by the string table */
+#define BP_FREE_INDEX_STRING(fh,s) if ((s) && !(fh)->strtbl) free (s);
+
 int bp_read_minifooter (BP_FILE * bp_struct);
 int bp_parse_pgs (BP_FILE * fh);
 int bp_parse_attrs (BP_FILE * fh);
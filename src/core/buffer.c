@@ -36,6 +36,7 @@ static uint64_t max_size =
 #endif
 
 void adios_databuffer_set_max_size (uint64_t v)  { max_size = v; }
+uint64_t adios_databuffer_get_max_size (void)    { return max_size; }
 
 uint64_t adios_databuffer_get_extension_size (struct adios_file_struct *fd)
 {
@@ -13,6 +13,7 @@
 
 /* Set the maximum buffer size usable by one adios_open()...adios_close() operation */
 void  adios_databuffer_set_max_size (uint64_t v);
+uint64_t adios_databuffer_get_max_size (void);
 
 /* Return a size with which the buffer can be extended up to the maximum.
    It returns a default size unless the existing buffer size plus the default size is
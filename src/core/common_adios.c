@@ -33,6 +33,7 @@
 // NCSU ALACRITY-ADIOS
 #include "core/transforms/adios_transforms_common.h"
 #include "core/transforms/adios_transforms_read.h"
+#include "core/transforms/adios_transforms_util.h"
 #include "core/transforms/adios_transforms_write.h"
 
 #ifdef WITH_NCSU_TIMER
@@ -520,11 +521,98 @@ int common_adios_group_size(int64_t fd_p, uint64_t data_size,
   return adios_errno;
 }
 
+/* The variable (vsize bytes) does not fit into the current buffer: extend the
+ * buffer or, if it cannot grow enough, let the methods deal with the full
+ * buffer and continue with a new PG (or stop buffering)
+ */
+static void common_adios_write_make_room(struct adios_file_struct *fd,
+                                         struct adios_var_struct *v,
+                                         uint64_t vsize) {
+  // First, try to realloc the buffer
+  uint64_t extrasize = adios_databuffer_get_extension_size(fd);
+  if (extrasize < vsize) extrasize = vsize;
+  if (adios_databuffer_resize(fd, fd->buffer_size + extrasize)) {
+    /* Second, let the method deal with it */
+    log_debug(
+        "adios_write(): buffer needs to be dumped before buffering "
+        "variable %s/%s\n",
+        v->path, v->name);
+    // these calls don't extend the buffer but we will get a completed PG
+    // here
+    adios_write_close_vars_v1(fd);
+    adios_write_close_process_group_header_v1(fd);
+
+    /* Ask the method to do something with the current buffer then we either
+       1. continue buffering from start with a new PG or
+       2. skip buffering variables from now on, then method gets the same
+       buffer again in close()
+     */
+
+    struct adios_method_list_struct *m = fd->group->methods;
+    while (m) {
+      if (m->method->m != ADIOS_METHOD_UNKNOWN &&
+          m->method->m != ADIOS_METHOD_NULL &&
+          adios_transports[m->method->m].adios_buffer_overflow_fn) {
+        adios_transports[m->method->m].adios_buffer_overflow_fn(fd,
+                                                                m->method);
+      }
+      m = m->next;
+    }
+
+    if (fd->bufstrat == continue_with_new_pg) {
+      // special case: fd->buffer_size is smaller than this single variable,
+      // and the extension failed:
+      // try to extend it to contain this single variable (plus headers) in
+      // the next PG
+      if (fd->buffer_size < vsize + 1024) {
+        if (adios_databuffer_resize(fd, vsize + 1024)) {
+          adios_error(
+              err_no_memory,
+              "adios_write(): buffer cannot accommodate variable %s/%s "
+              "with its storage size of %" PRIu64
+              " bytes at all. "
+              "No more variables will be written.\n",
+              v->path, v->name, vsize);
+          //"This variable won't be written.\n", v->path, v->name, vsize);
+          fd->bufstate = buffering_stopped;
+          /* FIXME: This stops all writing, not just this variable! */
+          /* FIXME: so maybe we should give the method a chance to write
+           * this variable directly? */
+        }
+      }
+      /* Start buffering from scratch (a new PG) */
+      fd->offset = 0;
+      adios_write_open_process_group_header_v1(fd);
+      adios_write_open_vars_v1(fd);
+      add_new_pg_written(fd);
+    } else if (fd->bufstrat == stop_on_overflow) {
+      fd->bufstate = buffering_stopped;
+      if (!adios_errno) {
+        // method is expected to throw an error in this case but we can
+        // ensure it here
+        // to signal error upward to not count this var in index
+        adios_errno = err_buffer_overflow;
+      }
+    }
+  }
+}
+
 static int common_adios_write_transform_helper(struct adios_file_struct *fd,
                                                struct adios_var_struct *v) {
   int use_shared_buffer = (fd->bufstrat != no_buffering);
   int wrote_to_shared_buffer = 0;
 
+  // A transform may reserve up to its worst-case output size in the shared
+  // buffer. If the buffer can never grow that far (the write was admitted on
+  // a predicted size), let it produce its output elsewhere and copy only
+  // the actual output into the buffer.
+  if (use_shared_buffer && !adios_transform_is_streaming(v) &&
+      fd->offset + adios_calc_var_overhead_v1(v) +
+              adios_transform_worst_case_transformed_var_size(v) >
+          adios_databuffer_get_max_size()) {
+    use_shared_buffer = 0;
+  }
+
   if (fd->bufstrat == no_buffering) {
     int ret = adios_transform_variable_data(fd, v, use_shared_buffer,
                                             &wrote_to_shared_buffer);
@@ -563,6 +651,26 @@ static int common_adios_write_transform_helper(struct adios_file_struct *fd,
     // Store the ending offset of the payload write (if any)
     end_offset = fd->offset;
 
+    // Output produced outside of the shared buffer is copied after the
+    // header, make sure it fits
+    if (!wrote_to_shared_buffer) {
+      uint64_t payload_size =
+          adios_get_var_size(v, v->adata ? v->adata : v->data);
+      if (payload_offset + payload_size > fd->buffer_size) {
+        // Larger than predicted: grow the buffer, or as a last resort
+        // complete the PG without this variable and start a new one for it
+        fd->offset = header_offset;
+        common_adios_write_make_room(fd, v, header_size + payload_size);
+        if (fd->bufstate != buffering_ongoing ||
+            fd->offset + header_size + payload_size > fd->buffer_size) {
+          if (!adios_errno) adios_errno = err_buffer_overflow;
+          return 0;
+        }
+        header_offset = fd->offset;
+        payload_offset = header_offset + header_size;
+      }
+    }
+
     // Rewind and write the header back where it should be
     fd->offset = header_offset;
     // var payload sent for sizing information
@@ -581,6 +689,7 @@ static int common_adios_write_transform_helper(struct adios_file_struct *fd,
 
       // Update the buffer back to the end of the header+payload
       fd->offset = end_offset;
+      if (fd->bytes_written < fd->offset) fd->bytes_written = fd->offset;
     } else {
       /* FIXME: This branch should not happen for memory reasons.
          The buffer either had enough space to store the transformation
@@ -605,6 +714,30 @@ static int common_adios_write_transform_helper(struct adios_file_struct *fd,
   return 1;
 }
 
+///////////////////////////////////////////////////////////////////////////////
+/* Write data built for the last block of v (in adios_generate_var_characteristics_v1),
+ * e.g. its bitmap index, as the next block of the hidden variable. A block is
+ * written even if there is no data for it (size 0), so that the blocks of the
+ * variable and of the hidden variable correspond one to one. The data is freed.
+ */
+static void common_adios_write_hidden_block(struct adios_file_struct *fd,
+                                            struct adios_var_struct *v,
+                                            struct adios_var_struct *hidden,
+                                            void **data, uint64_t *size,
+                                            const char *what) {
+  static uint8_t no_data = 0;
+
+  hidden->dimensions->dimension.rank = (*data ? *size : 0);
+  common_adios_write_byid(fd, hidden, *data ? *data : &no_data);
+  if (adios_errno) {
+    log_warn("Could not write the %s of variable %s\n", what, v->name);
+  }
+
+  free(*data);
+  *data = NULL;
+  *size = 0;
+}
+
 ///////////////////////////////////////////////////////////////////////////////
 /* common_adios_write is just a partial implementation. It expects filled out
  * structures. This is because C and Fortran implementations of adios_write are
@@ -630,79 +763,33 @@ int common_adios_write(struct adios_file_struct *fd, struct adios_var_struct *v,
     // and handle the error if buffer cannot be extended
     vsize = adios_transform_worst_case_transformed_var_size(v);
 
+    // A streaming transform grows the buffer while it writes, so only the
+    // header and a first chunk of output need room now, as long as the
+    // buffer may still grow to fit the worst case
+    if (adios_transform_is_streaming(v) &&
+        fd->offset + vsize <= adios_databuffer_get_max_size()) {
+      uint64_t stream_size =
+          adios_calc_var_overhead_v1(v) + SHARED_BUFFER_STREAM_CHUNK;
+      if (stream_size < vsize) vsize = stream_size;
+    } else if (!adios_transform_is_streaming(v)) {
+      // Other transforms: reserve what the storage ratios of the previous
+      // writes of this variable predict rather than the worst case. A larger
+      // output grows the buffer (see common_adios_write_transform_helper)
+      uint64_t predicted_size =
+          adios_transform_predicted_transformed_var_size(v);
+      if (predicted_size) {
+        predicted_size += adios_calc_var_overhead_v1(v);
+        if (predicted_size < vsize) vsize = predicted_size;
+      }
+    }
+
     if (fd->buffer_size < fd->offset + vsize) {
       //    printf("adios_write fd->offset=%llu for variable= %s
       //    buffer_size=%llu\n", fd->offset, v->name, fd->buffer_size);
       //            printf("max_ts=%d ts_to_buffer=%d\n", fd->group->max_ts,
       //            fd->group->ts_to_buffer);
       /* Trouble: this variable does not fit into the current buffer */
-      // First, try to realloc the buffer
-      uint64_t extrasize = adios_databuffer_get_extension_size(fd);
-      if (extrasize < vsize) extrasize = vsize;
-      if (adios_databuffer_resize(fd, fd->buffer_size + extrasize)) {
-        /* Second, let the method deal with it */
-        log_debug(
-            "adios_write(): buffer needs to be dumped before buffering "
-            "variable %s/%s\n",
-            v->path, v->name);
-        // these calls don't extend the buffer but we will get a completed PG
-        // here
-        adios_write_close_vars_v1(fd);
-        adios_write_close_process_group_header_v1(fd);
-
-        /* Ask the method to do something with the current buffer then we either
-           1. continue buffering from start with a new PG or
-           2. skip buffering variables from now on, then method gets the same
-           buffer again in close()
-         */
-
-        m = fd->group->methods;
-        while (m) {
-          if (m->method->m != ADIOS_METHOD_UNKNOWN &&
-              m->method->m != ADIOS_METHOD_NULL &&
-              adios_transports[m->method->m].adios_buffer_overflow_fn) {
-            adios_transports[m->method->m].adios_buffer_overflow_fn(fd,
-                                                                    m->method);
-          }
-          m = m->next;
-        }
-
-        if (fd->bufstrat == continue_with_new_pg) {
-          // special case: fd->buffer_size is smaller than this single variable,
-          // and the extension failed:
-          // try to extend it to contain this single variable (plus headers) in
-          // the next PG
-          if (fd->buffer_size < vsize + 1024) {
-            if (adios_databuffer_resize(fd, vsize + 1024)) {
-              adios_error(
-                  err_no_memory,
-                  "adios_write(): buffer cannot accommodate variable %s/%s "
-                  "with its storage size of %" PRIu64
-                  " bytes at all. "
-                  "No more variables will be written.\n",
-                  v->path, v->name, vsize);
-              //"This variable won't be written.\n", v->path, v->name, vsize);
-              fd->bufstate = buffering_stopped;
-              /* FIXME: This stops all writing, not just this variable! */
-              /* FIXME: so maybe we should give the method a chance to write
-               * this variable directly? */
-            }
-          }
-          /* Start buffering from scratch (a new PG) */
-          fd->offset = 0;
-          adios_write_open_process_group_header_v1(fd);
-          adios_write_open_vars_v1(fd);
-          add_new_pg_written(fd);
-        } else if (fd->bufstrat == stop_on_overflow) {
-          fd->bufstate = buffering_stopped;
-          if (!adios_errno) {
-            // method is expected to throw an error in this case but we can
-            // ensure it here
-            // to signal error upward to not count this var in index
-            adios_errno = err_buffer_overflow;
-          }
-        }
-      }
+      common_adios_write_make_room(fd, v, vsize);
     }
   }
 
@@ -735,6 +822,9 @@ int common_adios_write(struct adios_file_struct *fd, struct adios_var_struct *v,
           "of memory, check previous error messages\n",
           adios_transform_plugin_primary_xml_alias(v->transform_type), v->name);
       // FIXME: Reverse the transform metadata and write raw data as usual
+      // Plugins do not always set an error code, but the variable must not
+      // be indexed without data
+      if (!adios_errno) adios_errno = err_no_memory;
     }
     ADIOST_CALLBACK_EXIT(adiost_event_transform, fd);
 #if defined(WITH_NCSU_TIMER) && defined(TIMER_LEVEL) && (TIMER_LEVEL <= 0)
@@ -780,6 +870,18 @@ int common_adios_write(struct adios_file_struct *fd, struct adios_var_struct *v,
   if (!adios_errno) {
     v->write_count++;
   }
+
+  // Every block of an indexed variable is followed by its bitmap index
+  if (!adios_errno && v->bitmap_index && v->dimensions) {
+    common_adios_write_hidden_block(fd, v, v->bitmap_index->index_var,
+                                    &v->bitmap_index->index,
+                                    &v->bitmap_index->index_size, "bitmap index");
+  }
+  // and by its zone map
+  if (!adios_errno && v->zone_map && v->dimensions) {
+    common_adios_write_hidden_block(fd, v, v->zone_map->map_var, &v->zone_map->map,
+                                    &v->zone_map->map_size, "zone map");
+  }
 #if defined(WITH_NCSU_TIMER) && defined(TIMER_LEVEL) && (TIMER_LEVEL <= 0)
   timer_stop("adios_write");
 #endif
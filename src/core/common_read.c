@@ -27,6 +27,7 @@
 #include "transforms/adios_transforms_transinfo.h"
 #include "transforms/adios_transforms_hooks_read.h"
 #include "transforms/adios_transforms_reqgroup.h"
+#include "transforms/adios_transforms_read.h"
 #include "transforms/adios_transforms_datablock.h"
 #define BYTE_ALIGN 8
 
@@ -136,6 +137,20 @@ int common_read_init_method (enum ADIOS_READ_METHOD method,
             }
             removeit = 1;
         }
+        else if (!strcasecmp (p->name, "transform_threads"))
+        {
+            int nthreads = 0; // no value: one thread per CPU
+            if (p->value) {
+                errno = 0;
+                nthreads = strtol(p->value, &end, 10);
+                if (errno || (end != 0 && *end != '\0') || nthreads < 0) {
+                    log_error ("Invalid 'transform_threads' parameter passed to read init function: '%s'\n", p->value);
+                    nthreads = 1;
+                }
+            }
+            adios_transform_set_read_threads (nthreads);
+            removeit = 1;
+        }
         else if (!strcasecmp (p->name, "abort_on_error"))
         {
             adios_abort_on_error = 1;
@@ -561,6 +576,9 @@ int common_read_close (ADIOS_FILE *fp)
             free(fp->link_namelist);
         }
                 
+        // drop cached query results before the file pointer can be reused
+        common_query_file_closed (fp);
+
         retval = internals->read_hooks[internals->method].adios_read_close_fn (fp);
         a2s_free_namelist (internals->group_namelist, internals->ngroups);
         free (internals->nvars_per_group);
@@ -1011,6 +1029,42 @@ int common_read_inq_var_stat (const ADIOS_FILE *fp, ADIOS_VARINFO * varinfo,
     return retval;
 }
 
+int common_read_inq_var_scalar_steps (const ADIOS_FILE *fp, const ADIOS_VARINFO * varinfo,
+                                      int from_steps, int nsteps, int all_blocks, void * data)
+{
+    if (!fp) {
+        adios_error (err_invalid_file_pointer, "Null pointer passed as file to adios_inq_var_scalar_steps()\n");
+        return adios_errno;
+    }
+    if (!varinfo) {
+        adios_error (err_invalid_argument, "Null pointer passed as varinfo to adios_inq_var_scalar_steps()\n");
+        return adios_errno;
+    }
+    if (!data) {
+        adios_error (err_invalid_argument, "Null pointer passed as data to adios_inq_var_scalar_steps()\n");
+        return adios_errno;
+    }
+    if (varinfo->ndim > 0) {
+        adios_error (err_operation_not_supported, "adios_inq_var_scalar_steps() works on scalar variables only\n");
+        return adios_errno;
+    }
+    if (from_steps < 0 || nsteps < 1 || from_steps + nsteps > varinfo->nsteps) {
+        adios_error (err_out_of_bound, "Steps %d..%d requested in adios_inq_var_scalar_steps() "
+                     "but the variable has %d steps\n", from_steps, from_steps+nsteps-1, varinfo->nsteps);
+        return adios_errno;
+    }
+
+    adios_errno = err_no_error;
+    struct common_read_internals_struct * internals =
+            (struct common_read_internals_struct *) fp->internal_data;
+
+    /* Translate group varid presented to the user to the real varid */
+    ADIOS_VARINFO vi = *varinfo;
+    vi.varid = varinfo->varid + internals->group_varid_offset;
+    return internals->read_hooks[internals->method].adios_inq_var_scalar_steps_fn (fp, &vi,
+                                      from_steps, nsteps, all_blocks, data);
+}
+
 // NCSU ALACRITY-ADIOS - Delegate to the 'inq_var_blockinfo_raw' function, then
 //   patch the original metadata in from the transform info
 int common_read_inq_var_blockinfo (const ADIOS_FILE *fp, ADIOS_VARINFO * varinfo)
@@ -1165,8 +1219,17 @@ void common_read_free_varinfo (ADIOS_VARINFO *vp)
 
             if (sp->histogram) {
                 if (sp->histogram->breaks)        MYFREE(sp->histogram->breaks);
-                if (sp->histogram->frequencies)   MYFREE(sp->histogram->frequencies);
+                if (sp->histogram->frequencies) {
+                    int s;
+                    for(s=0; s < vp->nsteps; s++) if (sp->histogram->frequencies[s]) MYFREE(sp->histogram->frequencies[s]);
+                    MYFREE(sp->histogram->frequencies);
+                }
                 if (sp->histogram->gfrequencies)  MYFREE(sp->histogram->gfrequencies);
+                if (sp->histogram->bfrequencies) {
+                    int b;
+                    for(b = 0; b < vp->sum_nblocks; b++) if (sp->histogram->bfrequencies[b]) MYFREE(sp->histogram->bfrequencies[b]);
+                    MYFREE(sp->histogram->bfrequencies);
+                }
                 MYFREE(sp->histogram);
             }
 
@@ -149,6 +149,7 @@
 
 #include <assert.h>
 #include <stdint.h>
+#include <string.h>
 
 
 // Returns true for big endian, false for little endian
@@ -351,3 +352,62 @@ int adios_transform_swap_transform_characteristics(struct adios_index_characteri
     *trans2 = tmp;
     return 1;
 }
+
+//////////////////////////////////////////////////
+// Transform pipeline metadata
+//////////////////////////////////////////////////
+
+uint16_t adios_transform_pipeline_stage_record_size(enum ADIOS_TRANSFORM_TYPE transform_type, uint16_t stage_metadata_len) {
+    const char *uid = adios_transform_plugin_uid(transform_type);
+    return sizeof(uint8_t) + strlen(uid) + sizeof(uint64_t) + sizeof(uint16_t) + stage_metadata_len;
+}
+
+int adios_transform_pipeline_parse_metadata(const void *metadata, uint16_t metadata_len,
+                                            struct adios_transform_pipeline_stage *stages, int max_stages) {
+    const char *pos = (const char *)metadata;
+    const char *end = pos + metadata_len;
+    char uid[256];
+    uint8_t nstages, uid_len;
+    int i;
+
+    if (!metadata || metadata_len < 1)
+        return -1;
+
+    nstages = *(const uint8_t *)pos;
+    pos += 1;
+    if (nstages > max_stages)
+        return -1;
+
+    for (i = 0; i < nstages; i++) {
+        struct adios_transform_pipeline_stage *stage = &stages[i];
+
+        if (pos + 1 > end)
+            return -1;
+        uid_len = *(const uint8_t *)pos;
+        pos += 1;
+
+        if (pos + uid_len + sizeof(uint64_t) + sizeof(uint16_t) > end)
+            return -1;
+        memcpy(uid, pos, uid_len);
+        uid[uid_len] = '\0';
+        pos += uid_len;
+
+        stage->transform_type = adios_transform_find_type_by_uid(uid);
+        memcpy(&stage->output_len, pos, sizeof(uint64_t));
+        pos += sizeof(uint64_t);
+        memcpy(&stage->metadata_len, pos, sizeof(uint16_t));
+        pos += sizeof(uint16_t);
+
+        if (pos + stage->metadata_len > end)
+            return -1;
+        stage->metadata = stage->metadata_len ? (void *)pos : NULL;
+        pos += stage->metadata_len;
+
+        if (stage->transform_type == adios_transform_unknown ||
+            stage->transform_type == adios_transform_none ||
+            stage->transform_type == adios_transform_pipeline)
+            return -1;
+    }
+
+    return nstages;
+}
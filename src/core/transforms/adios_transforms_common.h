@@ -61,4 +61,39 @@ int adios_transform_clear_transform_characteristic(struct adios_index_characteri
 // Swap
 int adios_transform_swap_transform_characteristics(struct adios_index_characteristic_transform_struct *c1, struct adios_index_characteristic_transform_struct *c2);
 
+//////////////////////////////////////////////////
+// Transform pipeline metadata
+//////////////////////////////////////////////////
+
+// A pipeline (transform="a|b|...") applies its stages in order at write time.
+// Its transform metadata is the concatenation of one record per stage:
+//   uint8_t  uid_len
+//   char     uid[uid_len]
+//   uint64_t output_len       (bytes produced by this stage)
+//   uint16_t metadata_len
+//   char     metadata[metadata_len] (the stage's own transform metadata)
+// preceded by a single uint8_t stage count.
+#define ADIOS_TRANSFORM_PIPELINE_MAX_STAGES 8
+
+struct adios_transform_pipeline_stage {
+    enum ADIOS_TRANSFORM_TYPE transform_type;
+    uint64_t output_len;
+    uint16_t metadata_len;
+    void *metadata; // Points into the pipeline metadata buffer
+};
+
+/*
+ * Returns the number of bytes of pipeline metadata needed to describe a
+ * stage with the given transform type and stage metadata length.
+ */
+uint16_t adios_transform_pipeline_stage_record_size(enum ADIOS_TRANSFORM_TYPE transform_type, uint16_t stage_metadata_len);
+
+/*
+ * Parses pipeline transform metadata into at most max_stages stage records.
+ * The metadata pointers in the stage records point into 'metadata'.
+ * @return the number of stages, or -1 if the metadata is malformed
+ */
+int adios_transform_pipeline_parse_metadata(const void *metadata, uint16_t metadata_len,
+                                            struct adios_transform_pipeline_stage *stages, int max_stages);
+
 #endif /* ADIOS_TRANSFORM_H */
@@ -72,6 +72,10 @@ typedef struct {
             uint64_t *transformed_len, int use_shared_buffer, int *wrote_to_shared_buffer);
 } adios_transform_write_method;
 
+// Transform write method registry, indexed by transform type (also used by
+// the pipeline transform to drive its stages directly)
+extern adios_transform_write_method TRANSFORM_WRITE_METHODS[];
+
 //
 // Every transform plugin has a set of functions that must go through three stages:
 // * Declaration: as with a C header
@@ -1,4 +1,6 @@
 #include <stddef.h>
+#include <stdlib.h>
+#include <string.h>
 #include <assert.h>
 
 #include "core/adios_bp_v1.h"
@@ -867,18 +869,115 @@ void adios_transform_process_read_chunk(adios_transform_read_request **reqgroups
  * producing all required results based on the raw data read.
  * (This function is called after a blocking perform_reads completes)
  */
+/*
+ * Parallel completion of PG read request groups
+ *
+ * Once a blocking read has brought in all raw data, detransforming each PG
+ * (e.g., decompressing it) and patching the result into the user buffer is
+ * independent from one PG to the next: every PG writes a disjoint region of
+ * the output. These PGs are therefore handed to a pool of worker threads,
+ * which needs no locking beyond the shared task counter.
+ */
+
+static int transform_read_threads = 1;
+
+void adios_transform_set_read_threads(int nthreads) {
+    transform_read_threads = (nthreads <= 0 ? adios_util_ncpus() : nthreads);
+}
+
+int adios_transform_get_read_threads() {
+    return transform_read_threads;
+}
+
+// Transform methods whose read hooks keep no state outside of the given PG
+// reqgroup, and may thus be run on several PGs concurrently
+static int is_transform_type_thread_safe(enum ADIOS_TRANSFORM_TYPE transform_type) {
+    switch (transform_type) {
+    case adios_transform_identity:
+    case adios_transform_zlib:
+    case adios_transform_bzip2:
+    case adios_transform_lz4:
+    case adios_transform_zfp:
+    case adios_transform_shuffle:
+    case adios_transform_fpred:
+        return 1;
+    default:
+        return 0;
+    }
+}
+
+// Pipelines (and the auto transform, which records its choice as a pipeline)
+// are thread safe if all of their stages are
+static int is_transform_thread_safe(enum ADIOS_TRANSFORM_TYPE transform_type, const void *metadata, uint16_t metadata_len) {
+    if (transform_type == adios_transform_pipeline || transform_type == adios_transform_auto) {
+        struct adios_transform_pipeline_stage stages[ADIOS_TRANSFORM_PIPELINE_MAX_STAGES];
+        const int nstages = adios_transform_pipeline_parse_metadata(metadata, metadata_len, stages,
+                                                                    ADIOS_TRANSFORM_PIPELINE_MAX_STAGES);
+        int i;
+        if (nstages <= 0)
+            return 0; // Let the serial path report the error
+        for (i = 0; i < nstages; i++)
+            if (!is_transform_thread_safe(stages[i].transform_type, stages[i].metadata, stages[i].metadata_len))
+                return 0;
+        return 1;
+    }
+    return is_transform_type_thread_safe(transform_type);
+}
+
+typedef struct {
+    adios_transform_read_request *reqgroup;
+    adios_transform_pg_read_request *pg_reqgroup;
+} pg_completion_task;
+
+static void complete_pg_reqgroup(adios_transform_read_request *reqgroup, adios_transform_pg_read_request *pg_reqgroup) {
+    // Make the required call to the transform method to apply the results
+    adios_datablock *result = adios_transform_pg_reqgroup_completed(reqgroup, pg_reqgroup);
+    if (result) apply_datablock_to_result_and_free(result, reqgroup);
+}
+
+static void run_pg_completion_task(void *arg, int taskidx) {
+    pg_completion_task *tasks = (pg_completion_task *)arg;
+    complete_pg_reqgroup(tasks[taskidx].reqgroup, tasks[taskidx].pg_reqgroup);
+}
+
+// Runs all tasks using up to nthreads threads, including the calling one
+static void run_pg_completion_tasks(pg_completion_task *tasks, int ntasks, int nthreads) {
+    // An error raised earlier in this read, by the raw reads or by the PGs
+    // completed serially, is the one to report. The workers start from a
+    // clean error state though, so that they never have to reset it.
+    const int saved_errno = adios_errno;
+    char saved_errmsg[256];
+    if (saved_errno != err_no_error) {
+        strncpy(saved_errmsg, adios_get_last_errmsg(), sizeof(saved_errmsg) - 1);
+        saved_errmsg[sizeof(saved_errmsg) - 1] = '\0';
+        adios_clear_error();
+    }
+
+    adios_util_run_tasks(ntasks, nthreads, run_pg_completion_task, tasks);
+
+    if (saved_errno != err_no_error)
+        adios_restore_error(saved_errno, saved_errmsg);
+}
+
 void adios_transform_process_all_reads(adios_transform_read_request **reqgroups_head) {
     // Mark all subrequests, PG request groups and read request groups
     // as completed, calling callbacks as needed
-    adios_transform_read_request *reqgroup;
+    adios_transform_read_request *reqgroup, *next_reqgroup;
     adios_transform_pg_read_request *pg_reqgroup;
     adios_transform_raw_read_request *subreq;
     adios_datablock *result;
+    pg_completion_task *tasks = NULL;
+    int ntasks = 0, max_tasks = 0;
+
+    // Complete the subrequests of each read reqgroup in turn. PG reqgroups
+    // whose transform can run concurrently are set aside for the worker
+    // threads, the others are completed right away.
+    for (reqgroup = *reqgroups_head; reqgroup; reqgroup = next_reqgroup) {
+        next_reqgroup = reqgroup->next;
 
-    // Complete each read reqgroup in turn
-    while ((reqgroup = adios_transform_read_request_pop(reqgroups_head)) != NULL) {
         // Free leftover read request groups immediately, with no further processing
         if (reqgroup->completed) {
+            adios_transform_read_request_remove(reqgroups_head, reqgroup);
             adios_transform_read_request_free(&reqgroup);
             continue;
         }
@@ -903,12 +1002,38 @@ void adios_transform_process_all_reads(adios_transform_read_request **reqgroups_
             }
             assert(pg_reqgroup->completed);
 
-            // Make the required call to the transform method to apply the results
-            result = adios_transform_pg_reqgroup_completed(reqgroup, pg_reqgroup);
-            if (result) apply_datablock_to_result_and_free(result, reqgroup);
+            if (transform_read_threads > 1 &&
+                is_transform_thread_safe(reqgroup->transinfo->transform_type,
+                                         pg_reqgroup->transform_metadata, pg_reqgroup->transform_metadata_len))
+            {
+                if (ntasks == max_tasks) {
+                    pg_completion_task *new_tasks;
+                    max_tasks = max_tasks ? 2 * max_tasks : 64;
+                    new_tasks = (pg_completion_task *)realloc(tasks, max_tasks * sizeof(pg_completion_task));
+                    if (!new_tasks) {
+                        // Out of memory for the task list; finish this PG here instead
+                        max_tasks = ntasks;
+                        complete_pg_reqgroup(reqgroup, pg_reqgroup);
+                        continue;
+                    }
+                    tasks = new_tasks;
+                }
+                tasks[ntasks].reqgroup = reqgroup;
+                tasks[ntasks].pg_reqgroup = pg_reqgroup;
+                ntasks++;
+            } else {
+                complete_pg_reqgroup(reqgroup, pg_reqgroup);
+            }
         }
         assert(reqgroup->completed);
+    }
+
+    if (ntasks > 0)
+        run_pg_completion_tasks(tasks, ntasks, transform_read_threads);
+    FREE(tasks);
 
+    // Complete each read reqgroup in turn
+    while ((reqgroup = adios_transform_read_request_pop(reqgroups_head)) != NULL) {
         // Make the required call to the transform method to apply the results
         result = adios_transform_read_reqgroup_completed(reqgroup);
         if (result) apply_datablock_to_result_and_free(result, reqgroup);
@@ -79,4 +79,11 @@ void adios_transform_process_read_chunk(adios_transform_read_request **reqgroups
  */
 void adios_transform_process_all_reads(adios_transform_read_request **reqgroups_head);
 
+/*
+ * Sets the number of threads used by adios_transform_process_all_reads to
+ * detransform and patch PGs concurrently (1 = serial, <= 0 = one per CPU).
+ */
+void adios_transform_set_read_threads(int nthreads);
+int adios_transform_get_read_threads();
+
 #endif /* ADIOS_TRANSFORMS_READ_H_ */
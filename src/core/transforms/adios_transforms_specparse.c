@@ -11,6 +11,7 @@
 #include <assert.h>
 #include "core/transforms/adios_transforms_specparse.h"
 #include "core/transforms/adios_transforms_hooks.h"
+#include "core/transforms/adios_transforms_common.h"
 #include "core/util.h"
 
 inline static char * strsplit(char *input, char split) {
@@ -31,6 +32,31 @@ inline static int strcount(char *input, char chr) {
     return count;
 }
 
+// Checks that every stage of a "a|b|..." chain names a known, non-pipeline
+// transform, and that the chain is not longer than the pipeline supports
+static int is_valid_pipeline_spec(const char *chain_str) {
+    char *chain = strdup(chain_str);
+    char *stage = chain;
+    int nstages = 0, valid = 1;
+
+    while (stage && valid) {
+        char *next_stage = strsplit(stage, '|');
+        strsplit(stage, ':'); // Drop this stage's parameters
+
+        const enum ADIOS_TRANSFORM_TYPE stage_type = adios_transform_find_type_by_xml_alias(stage);
+        if (stage_type == adios_transform_unknown ||
+            stage_type == adios_transform_none ||
+            stage_type == adios_transform_pipeline ||
+            ++nstages > ADIOS_TRANSFORM_PIPELINE_MAX_STAGES)
+            valid = 0;
+
+        stage = next_stage;
+    }
+
+    free(chain);
+    return valid;
+}
+
 // var is a pointer type
 #define MALLOC_ARRAY(var, type, count) ((var) = (type *)malloc(sizeof(type) * (count)))
 #define MALLOC_VAR(var, type) MALLOC_ARRAY(var, type, 1)
@@ -71,12 +97,26 @@ struct adios_transform_spec * adios_transform_parse_spec(const char *spec_str,
     // Mark the transform method string in the spec string (the beginning)
     spec->transform_type_str = new_spec_str;
 
+    // A chain of transforms (e.g., "aplod|zlib:5") is a pipeline; each stage
+    // carries its own parameters, so keep the whole chain as the type string
+    // and let the pipeline transform parse the stages
+    if (strchr(new_spec_str, '|')) {
+        spec->transform_type = is_valid_pipeline_spec(new_spec_str) ?
+                               adios_transform_pipeline : adios_transform_unknown;
+        return spec;
+    }
+
     // Split off the parameters if present
     char *param_list = strsplit(new_spec_str, ':');
 
     // Parse the transform method string
     spec->transform_type = adios_transform_find_type_by_xml_alias(spec->transform_type_str);
 
+    // A pipeline is only given by the chain of its stages, a bare "pipeline"
+    // has nothing to apply (and would name itself as its only stage)
+    if (spec->transform_type == adios_transform_pipeline)
+        spec->transform_type = adios_transform_unknown;
+
     // If the transform type is unknown (error) or none, stop now and return
     if (spec->transform_type == adios_transform_unknown ||
         spec->transform_type == adios_transform_none)
@@ -7,57 +7,44 @@
 #include "adios_transforms_common.h"
 #include "adios_transforms_util.h"
 #include "core/adios_internals.h"
+#include "core/adios_logger.h"
+#include "core/buffer.h"
 
-static int buffer_reserve(char ** buffer, uint64_t * buffer_size
-                         ,uint64_t * buffer_offset
-                         ,uint64_t size, uint64_t max_size
-                         )
+/*
+ * Makes sure the shared buffer holds at least end bytes, growing it in the
+ * usual extension steps (but at least to end) up to the maximum buffer size.
+ * Growing may move the buffer.
+ */
+static int shared_buffer_grow(struct adios_file_struct *fd, uint64_t end)
 {
-    if (*buffer_offset + size > *buffer_size || *buffer == 0)
-    {
-        if (*buffer_offset + size + 1000 > max_size) {
-            fprintf (stderr, "Cannot allocate memory in buffer_write.  "
-                             "Requested: %" PRIu64 ", Maximum: %" PRIu64 "\n", *buffer_offset + size + 1000, max_size);
-            return 0;
-        }
-
-        char * b = realloc (*buffer, *buffer_offset + size + 1000);
-        if (b)
-        {
-            *buffer = b;
-            *buffer_size = (*buffer_offset + size + 1000);
-        }
-        else
-        {
-            fprintf (stderr, "Cannot allocate memory in buffer_write.  "
-                             "Requested: %" PRIu64 "\n", *buffer_offset + size + 1000);
-
-            return 0;
-        }
-    }
-    return 1;
-}
+    if (end <= fd->buffer_size)
+        return 1;
 
-static int buffer_write (char ** buffer, uint64_t * buffer_size
-                         ,uint64_t * buffer_offset
-                         ,const void * data, uint64_t size, uint64_t max_size
-                         )
-{
-    if (!buffer_reserve(buffer, buffer_size, buffer_offset, size, max_size))
-        return 0;
+    uint64_t extension = adios_databuffer_get_extension_size(fd);
+    if (extension < end - fd->buffer_size)
+        extension = end - fd->buffer_size;
+    adios_databuffer_resize(fd, fd->buffer_size + extension);
 
-    memcpy (*buffer + *buffer_offset, data, size);
-    *buffer_offset += size;
-    return 1;
+    return end <= fd->buffer_size;
 }
 
-
 int shared_buffer_write(struct adios_file_struct *fd, const void * data, uint64_t size) {
-    return buffer_write(&fd->buffer, &fd->buffer_size, &fd->offset, data, size, fd->buffer_size /*fd->write_size_bytes*/);
+    if (!shared_buffer_reserve(fd, size))
+        return 0;
+
+    memcpy(fd->buffer + fd->offset, data, size);
+    fd->offset += size;
+    return 1;
 }
 
 int shared_buffer_reserve(struct adios_file_struct *fd, uint64_t size) {
-    return buffer_reserve(&fd->buffer, &fd->buffer_size, &fd->offset, size, fd->buffer_size /*fd->write_size_bytes*/);
+    if (!shared_buffer_grow(fd, fd->offset + size)) {
+        log_error("Cannot extend the ADIOS buffer to %" PRIu64 " bytes for transform output "
+                  "(maximum buffer size is %" PRIu64 " bytes)\n",
+                  fd->offset + size, adios_databuffer_get_max_size());
+        return 0;
+    }
+    return 1;
 }
 
 int shared_buffer_mark_written(struct adios_file_struct *fd, uint64_t size) {
@@ -67,3 +54,36 @@ int shared_buffer_mark_written(struct adios_file_struct *fd, uint64_t size) {
     fd->offset += size;
     return 1;
 }
+
+void shared_buffer_stream_open(struct shared_buffer_stream *stream, struct adios_file_struct *fd) {
+    stream->fd = fd;
+    stream->written = 0;
+}
+
+char * shared_buffer_stream_space(struct shared_buffer_stream *stream, uint64_t min_size, uint64_t *avail) {
+    struct adios_file_struct *fd = stream->fd;
+    const uint64_t end = fd->offset + stream->written;
+
+    if (!shared_buffer_grow(fd, end + min_size)) {
+        log_error("Cannot extend the ADIOS buffer to %" PRIu64 " bytes for streaming transform output\n",
+                  end + min_size);
+        return NULL;
+    }
+
+    *avail = fd->buffer_size - end;
+    return fd->buffer + end;
+}
+
+void shared_buffer_stream_advance(struct shared_buffer_stream *stream, uint64_t size) {
+    assert(stream->fd->offset + stream->written + size <= stream->fd->buffer_size);
+    stream->written += size;
+}
+
+void shared_buffer_stream_rewind(struct shared_buffer_stream *stream) {
+    stream->written = 0;
+}
+
+uint64_t shared_buffer_stream_close(struct shared_buffer_stream *stream) {
+    shared_buffer_mark_written(stream->fd, stream->written);
+    return stream->written;
+}
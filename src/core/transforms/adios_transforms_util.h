@@ -13,9 +13,37 @@
 #include "core/adios_internals.h"
 #include "core/util.h"
 
+// Both grow the buffer as needed (up to the maximum buffer size), which may
+// move it, so pointers into the buffer must be taken after these calls
 int shared_buffer_write(struct adios_file_struct *fd, const void * data, uint64_t size);
 int shared_buffer_reserve(struct adios_file_struct *fd, uint64_t size);
 int shared_buffer_mark_written(struct adios_file_struct *fd, uint64_t size);
 
+/*
+ * Streaming output into the shared buffer. Instead of reserving room for the
+ * worst-case output up front, a transform appends its output chunk by chunk
+ * after fd->offset, and the buffer is grown as needed. Growing may move the
+ * buffer, so a pointer returned by shared_buffer_stream_space() is only
+ * valid until the next call. A stream that is not closed leaves fd->offset
+ * (and so the buffer contents) as they were.
+ */
+#define SHARED_BUFFER_STREAM_CHUNK (1024 * 1024)
+
+struct shared_buffer_stream {
+    struct adios_file_struct *fd;
+    uint64_t written; // Bytes appended after fd->offset so far
+};
+
+void shared_buffer_stream_open(struct shared_buffer_stream *stream, struct adios_file_struct *fd);
+// Returns where the next output bytes go, with at least min_size bytes of room
+// there (*avail is set to the room actually available), or NULL if the buffer
+// cannot grow that far
+char * shared_buffer_stream_space(struct shared_buffer_stream *stream, uint64_t min_size, uint64_t *avail);
+void shared_buffer_stream_advance(struct shared_buffer_stream *stream, uint64_t size);
+// Drops everything written to the stream so far
+void shared_buffer_stream_rewind(struct shared_buffer_stream *stream);
+// Marks the output as written in the shared buffer; returns its size
+uint64_t shared_buffer_stream_close(struct shared_buffer_stream *stream);
+
 
 #endif /* ADIOS_TRANSFORMS_UTIL_H_ */
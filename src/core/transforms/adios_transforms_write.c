@@ -69,6 +69,47 @@ uint64_t adios_transform_worst_case_transformed_var_size(struct adios_var_struct
     return max_transformed_var_size;
 }
 
+uint64_t adios_transform_predicted_transformed_var_size(struct adios_var_struct * v)
+{
+    float max_ratio = 0;
+    int i;
+
+    if (v->transform_type == adios_transform_none || !v->dimensions || !v->transform_ratio_count)
+        return 0;
+
+    for (i = 0; i < v->transform_ratio_count; i++)
+        max_ratio = MAX(max_ratio, v->transform_ratio[i]);
+
+    const uint64_t size = adios_transform_get_pre_transform_var_size(v);
+    return ceil(max_ratio * (1 + ADIOS_TRANSFORM_RATIO_MARGIN) * size) + ADIOS_TRANSFORM_RATIO_SLACK;
+}
+
+static void adios_transform_record_ratio(struct adios_var_struct * var, uint64_t transformed_len)
+{
+    const uint64_t size = adios_transform_get_pre_transform_var_size(var);
+    if (!size)
+        return;
+
+    var->transform_ratio[var->transform_ratio_next] = (float)((double)transformed_len / size);
+    var->transform_ratio_next = (var->transform_ratio_next + 1) % ADIOS_TRANSFORM_RATIO_HISTORY;
+    if (var->transform_ratio_count < ADIOS_TRANSFORM_RATIO_HISTORY)
+        var->transform_ratio_count++;
+}
+
+int adios_transform_is_streaming(const struct adios_var_struct * v)
+{
+    if (!v->dimensions)
+        return 0;
+
+    switch (v->transform_type) {
+    case adios_transform_zlib:
+    case adios_transform_bzip2:
+        return 1;
+    default:
+        return 0;
+    }
+}
+
 uint64_t adios_transform_worst_case_transformed_group_size(uint64_t group_size, struct adios_file_struct *fd)
 {
 	uint64_t transformed_group_size = group_size; // The upper bound on how much data /might/ be transformed
@@ -346,6 +387,53 @@ static int is_timed_scalar(const struct adios_var_struct *var) {
            is_dimension_item_zero(&var->dimensions->global_dimension); // It's not a global array
 }
 
+int adios_transform_is_float_only(enum ADIOS_TRANSFORM_TYPE transform_type) {
+    switch (transform_type) {
+    case adios_transform_zfp:
+    case adios_transform_sz:
+    case adios_transform_fpred:
+    case adios_transform_alacrity:
+        return 1;
+    default:
+        return 0;
+    }
+}
+
+/*
+ * Returns the first transform of the spec (a pipeline stage, or the transform
+ * itself) that cannot handle its input, or adios_transform_none if all can.
+ * Pipeline stages after the first get the previous stage's bytes as input.
+ */
+static enum ADIOS_TRANSFORM_TYPE find_unsupported_transform(const struct adios_transform_spec *transform_spec,
+                                                            enum ADIOS_DATATYPES type) {
+    enum ADIOS_TRANSFORM_TYPE unsupported = adios_transform_none;
+
+    if (transform_spec->transform_type != adios_transform_pipeline) {
+        if (adios_transform_is_float_only(transform_spec->transform_type) &&
+            type != adios_real && type != adios_double)
+            unsupported = transform_spec->transform_type;
+        return unsupported;
+    }
+
+    char *chain = strdup(transform_spec->transform_type_str);
+    char *stage = chain;
+    while (stage && unsupported == adios_transform_none) {
+        char *next_stage = strchr(stage, '|');
+        if (next_stage)
+            *next_stage++ = '\0';
+        stage[strcspn(stage, ":")] = '\0'; // Drop this stage's parameters
+
+        const enum ADIOS_TRANSFORM_TYPE stage_type = adios_transform_find_type_by_xml_alias(stage);
+        if (adios_transform_is_float_only(stage_type) && type != adios_real && type != adios_double)
+            unsupported = stage_type;
+
+        type = adios_byte;
+        stage = next_stage;
+    }
+    free(chain);
+    return unsupported;
+}
+
 /*
  * Modifies the given variable's metadata to support the data transform specified by
  * orig_var->transform_spec. Also handles error conditions, such as the variable
@@ -368,6 +456,22 @@ struct adios_var_struct * adios_transform_define_var(struct adios_var_struct *or
         return orig_var;
     }
 
+    // If the transform (or a stage of the pipeline) cannot handle the data, it would fail at
+    // write time and leave the variable out: remove the transform, warn the user, and continue as usual
+    const enum ADIOS_TRANSFORM_TYPE unsupported = (transform_spec->transform_type != adios_transform_none) ?
+            find_unsupported_transform(transform_spec, orig_var->type) : adios_transform_none;
+    if (unsupported != adios_transform_none) {
+        log_warn("Variable %s/%s of type %s is marked for transform \"%s\", but \"%s\" handles only real and double data%s; "
+                 "not applying data transform.\n",
+                 orig_var->path, orig_var->name, adios_type_to_string_int(orig_var->type), transform_spec->transform_type_str,
+                 adios_transform_plugin_primary_xml_alias(unsupported),
+                 (transform_spec->transform_type == adios_transform_pipeline ? " (pipeline stages after the first get bytes)" : ""));
+
+        orig_var->transform_type = adios_transform_none;
+        orig_var->transform_spec->transform_type = adios_transform_none;
+        return orig_var;
+    }
+
     // The variable has none of the above errors; apply the transform metadata
 
     log_debug("Transforming variable %s/%s with type %d\n", orig_var->path, orig_var->name, transform_spec->transform_type);
@@ -375,6 +479,10 @@ struct adios_var_struct * adios_transform_define_var(struct adios_var_struct *or
     // Set transform type and spec
     orig_var->transform_type = transform_spec->transform_type;
 
+    // Storage ratios of another transform say nothing about this one
+    orig_var->transform_ratio_count = 0;
+    orig_var->transform_ratio_next = 0;
+
     // If there is no transform, nothing else to do
     if (transform_spec->transform_type == adios_transform_none)
         return orig_var;
@@ -479,6 +587,9 @@ int adios_transform_variable_data(struct adios_file_struct * fd,
     // Store the new length in the metadata
     adios_transform_store_transformed_length(fd, var, transformed_len);
 
+    // Remember the ratio to size the buffer reservation of the next write
+    adios_transform_record_ratio(var, transformed_len);
+
     return 1;
 }
 
@@ -530,6 +641,8 @@ int adios_transform_init_transform_var(struct adios_var_struct *var) {
     //var->transform_type_param = 0;
     var->transform_metadata_len = 0;
     var->transform_metadata = 0;
+    var->transform_ratio_count = 0;
+    var->transform_ratio_next = 0;
     return 1;
 }
 
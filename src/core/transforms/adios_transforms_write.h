@@ -30,6 +30,14 @@ uint64_t adios_transform_get_pre_transform_var_size(struct adios_var_struct *var
  */
 struct adios_var_struct * adios_transform_define_var(struct adios_var_struct *orig_var);
 
+/*
+ * Returns true if the transform handles only adios_real and adios_double
+ * data (e.g., the floating point compressors). adios_transform_define_var()
+ * applies no transform to other variables marked with it, or with a pipeline
+ * using it (stages after the first see bytes).
+ */
+int adios_transform_is_float_only(enum ADIOS_TRANSFORM_TYPE transform_type);
+
 /*
  * Transforms a given variable orig_var via the given transform type.
  *
@@ -68,6 +76,25 @@ int adios_transform_variable_data(struct adios_file_struct * fd,
  */
 uint64_t adios_transform_worst_case_transformed_var_size(struct adios_var_struct * v);
 
+/*
+ * Returns true if the variable's transform streams its output into the shared
+ * buffer (see shared_buffer_stream_open() in adios_transforms_util.h), growing
+ * it as needed, so that the worst-case size need not be reserved beforehand.
+ */
+int adios_transform_is_streaming(const struct adios_var_struct * v);
+
+/*
+ * Predicts the transformed size of a variable from the storage ratios of its
+ * previous writes with the same transform: the largest of the last
+ * ADIOS_TRANSFORM_RATIO_HISTORY ratios, plus a safety margin. Returns 0 if
+ * there is no history to go by (or the variable is not transformed).
+ * Used by common_adios_write() to reserve buffer space for compressing
+ * transforms, whose worst case is well above what they usually produce.
+ */
+#define ADIOS_TRANSFORM_RATIO_MARGIN 0.125
+#define ADIOS_TRANSFORM_RATIO_SLACK 65536
+uint64_t adios_transform_predicted_transformed_var_size(struct adios_var_struct * v);
+
 /*
  * Computes the worse-case required group size for an entire group.
  * Checks all variables in the group to find which transform types are used,
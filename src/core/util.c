@@ -5,6 +5,8 @@
 #include <errno.h>
 #include <assert.h>
 #include <ctype.h>
+#include <unistd.h>
+#include <pthread.h>
 
 
 #include "config.h"
@@ -307,3 +309,79 @@ void * bufdup(const void *buf, uint64_t elem_size, uint64_t count) {
     memcpy(newbuf, buf, len);
     return newbuf;
 }
+
+int adios_util_ncpus (void)
+{
+    const long ncpus = sysconf (_SC_NPROCESSORS_ONLN);
+    return ncpus > 0 ? (int) ncpus : 1;
+}
+
+/* Tasks are handed out one by one from a shared counter, which is the
+   only state the threads share */
+typedef struct {
+    ADIOS_UTIL_TASK_FN fn;
+    void              *arg;
+    int                ntasks;
+    int                next_task;
+    pthread_mutex_t    lock;
+} util_task_pool;
+
+static void * util_task_worker (void *arg)
+{
+    util_task_pool *pool = (util_task_pool *) arg;
+    int task;
+
+    for (;;) {
+        pthread_mutex_lock (&pool->lock);
+        task = pool->next_task++;
+        pthread_mutex_unlock (&pool->lock);
+
+        if (task >= pool->ntasks)
+            break;
+        pool->fn (pool->arg, task);
+    }
+    return NULL;
+}
+
+void adios_util_run_tasks (int ntasks, int nthreads, ADIOS_UTIL_TASK_FN fn, void *arg)
+{
+    util_task_pool pool;
+    pthread_t *threads = NULL;
+    int i, nstarted = 0;
+
+    if (ntasks <= 0)
+        return;
+    if (nthreads > ntasks)
+        nthreads = ntasks;
+    if (nthreads <= 1) {
+        for (i = 0; i < ntasks; i++)
+            fn (arg, i);
+        return;
+    }
+
+    pool.fn = fn;
+    pool.arg = arg;
+    pool.ntasks = ntasks;
+    pool.next_task = 0;
+    pthread_mutex_init (&pool.lock, NULL);
+
+    threads = (pthread_t *) malloc ((nthreads - 1) * sizeof(pthread_t));
+    if (threads) {
+        for (i = 0; i < nthreads - 1; i++) {
+            if (pthread_create (&threads[nstarted], NULL, util_task_worker, &pool) != 0) {
+                log_debug ("Could not start thread %d, continuing with %d threads\n", i + 1, nstarted + 1);
+                break;
+            }
+            nstarted++;
+        }
+    }
+
+    log_debug ("Running %d tasks with %d threads\n", ntasks, nstarted + 1);
+    util_task_worker (&pool);
+
+    for (i = 0; i < nstarted; i++)
+        pthread_join (threads[i], NULL);
+
+    free (threads);
+    pthread_mutex_destroy (&pool.lock);
+}
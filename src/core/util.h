@@ -52,4 +52,12 @@ int list_get_length (read_request * h);
 
 void * bufdup(const void *buf, uint64_t elem_size, uint64_t count);
 
+/* Number of CPUs online, at least 1 */
+int adios_util_ncpus (void);
+
+/* Run fn(arg, task) for every task in [0, ntasks) on up to nthreads threads,
+   the calling one included. Tasks must not depend on each other. */
+typedef void (*ADIOS_UTIL_TASK_FN) (void *arg, int task);
+void adios_util_run_tasks (int ntasks, int nthreads, ADIOS_UTIL_TASK_FN fn, void *arg);
+
 #endif
@@ -148,6 +148,28 @@ uint64_t adios_expected_var_size (int64_t var_id);
 // returns adios_errno (0=OK)
 int adios_set_transform (int64_t var_id, const char *transform_type_str);
 
+// To record a histogram of every written block of an array variable in its
+// statistics, which readers and query estimation can use. break_points is a
+// comma separated, increasing list of bin edges, e.g. "0,10,100".
+// The group must be declared with full statistics (adios_stat_full).
+// returns adios_errno (0=OK)
+int adios_define_var_histogram (int64_t group_id, const char * name,
+                                const char * break_points);
+
+// To build a bitmap index of an array variable while writing it, which the
+// BITMAP query method uses. break_points is a comma separated, increasing
+// list of bin edges, e.g. "0,10,100"
+// returns adios_errno (0=OK)
+int adios_define_var_bitmap_index (int64_t group_id, const char * name,
+                                   const char * break_points);
+
+// To record the min/max of zones of each written block of an array variable,
+// so that queries can skip or read parts of a block. A zone is a range of
+// slabs along the slowest dimension, with about zone_elements elements
+// returns adios_errno (0=OK)
+int adios_define_var_zone_map (int64_t group_id, const char * name,
+                               uint64_t zone_elements);
+
 int adios_define_attribute (int64_t group, 
                             const char * name,
                             const char * path, 
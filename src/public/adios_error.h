@@ -168,6 +168,7 @@ void adios_error_at_line (enum ADIOS_ERRCODES errcode, const char* filename, uns
 
 const char* adios_get_last_errmsg (void);
 void adios_clear_error(void); // reset adios_errno to err_no_err and clear last errmsg
+void adios_restore_error(int errcode, const char *errmsg); // set adios_errno and last errmsg saved before, without logging again
 
 #ifdef __cplusplus
 }
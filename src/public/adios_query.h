@@ -13,7 +13,10 @@ enum ADIOS_QUERY_METHOD
     ADIOS_QUERY_METHOD_MINMAX   = 0,
     ADIOS_QUERY_METHOD_FASTBIT  = 1,
     ADIOS_QUERY_METHOD_ALACRITY = 2,
-    ADIOS_QUERY_METHOD_UNKNOWN  = 3,
+    ADIOS_QUERY_METHOD_SCAN     = 3,
+    ADIOS_QUERY_METHOD_BITMAP   = 4,
+    ADIOS_QUERY_METHOD_SORTED   = 5,
+    ADIOS_QUERY_METHOD_UNKNOWN  = 6,
     ADIOS_QUERY_METHOD_COUNT = ADIOS_QUERY_METHOD_UNKNOWN
 };
     
@@ -98,6 +101,10 @@ typedef struct {
               }
               free (result->selections);
               free (result);
+       SCAN returns a single selection of type ADIOS_SELECTION_POINTS
+           Points are N-D global coordinates (container is NULL) in the output
+           bounding box, npoints is the number of points in it.
+           Delete it the same way as for FASTBIT and ALACRITY.
        MINMAX returns multiple selections, each of them is of type ADIOS_SELECTION_WRITEBLOCK
            Block id of the Nth returned writeblock selection = result->selection[N].u.block.index
            npoints is 0.
@@ -109,6 +116,20 @@ typedef struct {
      */
 } ADIOS_QUERY_RESULT;
 
+/* Result of adios_query_read_where(): the hits and the values of the
+   requested variables at the hits.
+   Delete it with adios_query_free_values(). */
+typedef struct {
+    enum ADIOS_QUERY_METHOD         method_used;
+    enum ADIOS_QUERY_RESULT_STATUS  status;
+    uint64_t                        npoints;  // number of hits returned in this call
+    int                             ndim;
+    uint64_t                       *points;   // npoints*ndim global coordinates of the hits
+    int                             nvars;
+    enum ADIOS_DATATYPES           *types;    // type of each requested variable
+    void                          **values;   // values[i]: npoints values of the i-th variable
+} ADIOS_QUERY_VALUES;
+
 
 
 #ifndef __INCLUDED_FROM_FORTRAN_API__
@@ -149,6 +170,22 @@ void adios_query_set_method (ADIOS_QUERY* q, enum ADIOS_QUERY_METHOD method);
 
 int64_t adios_query_estimate (ADIOS_QUERY* q, int timeStep);
 
+/*
+ * Estimate the number of hits of the query at "timestep" from the statistics
+ * recorded at writing (per block min/max, and histograms if defined), without
+ * reading any data. Works with any query method.
+ *
+ * IN:  q               query
+ *      timestep        timestep of interest
+ * OUT: estimate        expected number of hits
+ *      upperBound      the query cannot have more hits than this
+ *                      (NaN values are accounted for only with histograms)
+ * RETURN:  -1 : error
+ *           0 : success
+ */
+int adios_query_estimate_bounds (ADIOS_QUERY* q, int timeStep,
+                                 uint64_t *estimate, uint64_t *upperBound);
+
 // obsolete. time_steps for non-streaming files should show up in estimate/evalute
 //void adios_query_set_timestep (int timeStep);
 
@@ -178,6 +215,58 @@ ADIOS_QUERY_RESULT * adios_query_evaluate (
                          uint64_t batchSize // limit on number of blocks/points returned at once
                      );
 
+/*
+ * Called by adios_query_evaluate_steps() for each evaluated timestep:
+ * first with result = NULL and the estimated hits of the step (as returned by
+ * adios_query_estimate()), then with every batch of results of that step.
+ * The function owns the result and has to free it like the result of
+ * adios_query_evaluate().
+ * RETURN:   0: continue
+ *           1: skip the remaining results of this timestep
+ *          -1: stop the evaluation
+ */
+typedef int (*ADIOS_QUERY_STEP_FN) (int timestep, int64_t nhits,
+                                    ADIOS_QUERY_RESULT *result, void *arg);
+
+/*
+ * Evaluate the query on timesteps fromStep .. fromStep+nSteps-1 of a file
+ * (not a stream), streaming the results of each step to 'fn' in step order.
+ * Steps without hits get only the first call, with nhits = 0.
+ *
+ * IN:  q               query
+ *      outputBoundary  as in adios_query_evaluate()
+ *      fromStep        first timestep
+ *      nSteps          number of timesteps
+ *      batchSize       as in adios_query_evaluate()
+ *      fn, arg         function called with the results, and its argument
+ * RETURN:   0: all steps evaluated, or stopped by 'fn'
+ *          -1: error, adios_errno is set
+ */
+int adios_query_evaluate_steps (ADIOS_QUERY* q,
+                                ADIOS_SELECTION* outputBoundary,
+                                int fromStep,
+                                int nSteps,
+                                uint64_t batchSize,
+                                ADIOS_QUERY_STEP_FN fn,
+                                void *arg);
+
+/*
+ * Set the number of threads the query methods may use to evaluate the blocks
+ * of a timestep (1 by default, 0 means one per CPU). Data is still read by the
+ * calling thread. Currently used by the SCAN and BITMAP methods.
+ */
+void adios_query_set_threads (int nthreads);
+
+/*
+ * Set the memory limit of the cache of query results (64MB by default,
+ * 0 disables caching). Results of queries and their subqueries on files
+ * (not streams) are cached per timestep until the file is closed, so that
+ * evaluating the same query again needs no reading, and a cached query
+ * AND-ed with new conditions reads only the blocks where it has hits.
+ * Currently used by the SCAN, BITMAP, SORTED and MINMAX methods.
+ */
+void adios_query_set_cache_size (uint64_t bytes);
+
 /*
  * Reading functions
  */
@@ -203,6 +292,78 @@ int adios_query_read_boundingbox (
    );
 
 
+/*
+ * Evaluate the query at "timestep" and return the coordinates of the next
+ * (at most) batchSize hits together with the values of variables 'varnames'
+ * at those points, in compact arrays. The variables can be other than the
+ * ones in the query conditions, but they must be global arrays with the same
+ * number of dimensions. Consecutive calls continue where the previous call
+ * (or adios_query_evaluate()) stopped, like adios_query_evaluate() does.
+ *
+ * The SCAN and BITMAP methods return the values from the data already read
+ * to evaluate the conditions where possible; other values are read block by
+ * block, as the box around the hits in each writeblock, not point by point.
+ * Methods returning writeblocks instead of points (MINMAX) are not supported.
+ *
+ * IN:  q               query
+ *      outputBoundary  as in adios_query_evaluate()
+ *      timestep        timestep of interest
+ *      batchSize       max number of hits to return in this call
+ *      nvars, varnames variables to read at the hits
+ * RETURN:  the result, its status is
+ *          ADIOS_QUERY_RESULT_ERROR on error (adios_errno is set),
+ *          ADIOS_QUERY_HAS_MORE_RESULTS if there are more hits to return,
+ *          ADIOS_QUERY_NO_MORE_RESULTS otherwise
+ */
+ADIOS_QUERY_VALUES * adios_query_read_where (
+                         ADIOS_QUERY* q,
+                         ADIOS_SELECTION* outputBoundary,
+                         int timestep,
+                         uint64_t batchSize,
+                         int nvars,
+                         const char **varnames
+                     );
+
+void adios_query_free_values (ADIOS_QUERY_VALUES *v);
+
+/*
+ * Return the k smallest (largest = 0) or the k largest (largest = 1) values
+ * of variable 'varname' at "timestep" of a file, with their coordinates,
+ * ordered from the extreme value on. NaN values are not counted, and fewer
+ * than k values are returned if the variable has fewer. Which of equal values
+ * at the k-th place are returned is unspecified.
+ *
+ * Needs the sorted index of the variable at that step, built with the
+ * adios_index_sorted utility; only a small part of the index is read besides
+ * the k values and positions returned.
+ *
+ * RETURN:  the result with a single variable (method_used is
+ *          ADIOS_QUERY_METHOD_SORTED), its status is ADIOS_QUERY_RESULT_ERROR
+ *          on error (adios_errno is set), ADIOS_QUERY_NO_MORE_RESULTS otherwise.
+ *          Delete it with adios_query_free_values().
+ */
+ADIOS_QUERY_VALUES * adios_query_topk (
+                         ADIOS_FILE *f,
+                         const char *varname,
+                         int timestep,
+                         uint64_t k,
+                         int largest
+                     );
+
+/*
+ * Return the value of variable 'varname' at "timestep" at 'fraction' (0..1)
+ * of its sorted values, and its coordinates: the value of rank
+ * floor(fraction*(n-1)) among the n values that are not NaN (0.5 gives the
+ * lower median). Needs the sorted index like adios_query_topk(), and returns
+ * the result the same way, with one point (none if all values are NaN).
+ */
+ADIOS_QUERY_VALUES * adios_query_quantile (
+                         ADIOS_FILE *f,
+                         const char *varname,
+                         int timestep,
+                         double fraction
+                     );
+
 void adios_query_free(ADIOS_QUERY* q);
 
 /* conversion from string to query operation enum type */
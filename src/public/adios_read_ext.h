@@ -65,6 +65,12 @@ typedef struct {
 	   Only needed by advanced applications requiring direct manipulation
 	   of transformed data. */
 	ADIOS_TRANSFORM_METADATA *transform_metadatas;
+
+	/* The chain of transforms applied to this variable, in write order. For a
+	   pipeline (e.g., transform="aplod|zlib") this lists each stage; for a
+	   single transform it has one entry, and it is empty (0, NULL) for none. */
+	int num_stages;
+	adios_transform_type_t *stage_types;
 } ADIOS_VARTRANSFORM;
 
 
@@ -85,9 +85,10 @@ struct _ADIOS_VARSTAT {
             uint32_t    num_breaks;
             double      max;
             double      min;
-            double *    breaks;
-            uint32_t ** frequencies;
-            uint32_t *  gfrequencies;
+            double *    breaks;       /* bin k counts breaks[k-1] <= v < breaks[k], 0..num_breaks      */
+            uint32_t ** frequencies;  /* per step (if requested), 'nsteps' arrays of num_breaks+1      */
+            uint32_t *  gfrequencies; /* over all steps, num_breaks+1 elements                        */
+            uint32_t ** bfrequencies; /* per block (if requested), 'sum_nblocks' arrays of num_breaks+1 */
         } *histogram;
 };
 
@@ -381,6 +382,27 @@ int adios_inq_var_stat (ADIOS_FILE *fp, ADIOS_VARINFO * varinfo,
  */
 int adios_inq_var_blockinfo (ADIOS_FILE *fp, ADIOS_VARINFO * varinfo);
 
+/** Get the values of a scalar variable over a range of steps.
+ *  Scalar values are recorded in the metadata, so no extra file access
+ *  is necessary after adios_read_open() for this operation, and all steps are
+ *  returned at once instead of scheduling a read per step.
+ *  Not supported for string variables.
+ *
+ *  IN:  fp          pointer to an (opened) ADIOS_FILE struct
+ *       varinfo     result of adios_inq_var() 
+ *       from_steps  first step to return (0..varinfo->nsteps-1)
+ *       nsteps      number of steps to return
+ *       all_blocks  0: return one value per step (from the first writer block)
+ *                   !=0: return the values of all writer blocks of each step,
+ *                        varinfo->nblocks[] tells how many belong to a step
+ *  OUT: data        pre-allocated memory for nsteps values, or for 
+ *                   sum(varinfo->nblocks[from_steps..from_steps+nsteps-1])
+ *                   values if all_blocks!=0
+ *  RETURN: 0 OK, !=0 on error (adios_errno value)
+ */
+int adios_inq_var_scalar_steps (ADIOS_FILE *fp, ADIOS_VARINFO * varinfo,
+                                int from_steps, int nsteps, int all_blocks, void * data);
+
 /** Inquiry a link by index
 *       linkid   index of link (0..fp->nlinks-1)
 *                in fp->link_namelist of ADIOS_FILE struct
@@ -454,7 +476,11 @@ int adios_schedule_read_byid (const ADIOS_FILE * fp,
                               int                     nsteps,
                               void                  * data);
 
-/* NCSU ALACRITY-ADIOS: Support for those transforms that can change reading behavior (e.g., level-of-detail) */
+/* NCSU ALACRITY-ADIOS: Support for those transforms that can change reading behavior (e.g., level-of-detail)
+ *       param    read hint interpreted by the transform of the variable, ignored otherwise.
+ *                aplod: "bytes=N" reads only the N most significant bytes of each value
+ *                (rounded up to whole byte components), "" reads at full precision.
+ */
 int adios_schedule_read_param (const ADIOS_FILE * fp,
                                const ADIOS_SELECTION * sel,
                                const char            * varname,
@@ -1,4 +1,5 @@
 set(query_method_SOURCES ${query_method_SOURCES} query/query_minmax.c)
+set(query_method_SOURCES ${query_method_SOURCES} query/query_scan.c)
 
 if(HAVE_FASTBIT)
 set(query_method_SOURCES ${query_method_SOURCES} query/query_fastbit.c)
@@ -32,6 +32,12 @@ int64_t adios_query_estimate(ADIOS_QUERY* q, int timestep)
   return common_query_estimate(q, timestep);
 }
 
+int adios_query_estimate_bounds(ADIOS_QUERY* q, int timestep,
+                                uint64_t *estimate, uint64_t *upperBound)
+{
+  return common_query_estimate_bounds(q, timestep, estimate, upperBound);
+}
+
  
 /* //obsolete
 void adios_query_set_timestep(int timeStep)
@@ -48,6 +54,28 @@ ADIOS_QUERY_RESULT * adios_query_evaluate(ADIOS_QUERY* q,
 }
 
 
+int adios_query_evaluate_steps(ADIOS_QUERY* q,
+              ADIOS_SELECTION* outputBoundary,
+              int fromStep,
+              int nSteps,
+              uint64_t batchSize,
+              ADIOS_QUERY_STEP_FN fn,
+              void *arg)
+{
+  return common_query_evaluate_steps(q, outputBoundary, fromStep, nSteps, batchSize, fn, arg);
+}
+
+void adios_query_set_threads(int nthreads)
+{
+  common_query_set_threads(nthreads);
+}
+
+void adios_query_set_cache_size(uint64_t bytes)
+{
+  common_query_set_cache_size(bytes);
+}
+
+
 int adios_query_read_boundingbox (
         ADIOS_FILE *f,
         ADIOS_QUERY *q,
@@ -62,6 +90,44 @@ int adios_query_read_boundingbox (
     return common_query_read_boundingbox (f, q, varname, timestep, nselections, selections, bb, data);
 }
 
+ADIOS_QUERY_VALUES * adios_query_read_where (
+        ADIOS_QUERY* q,
+        ADIOS_SELECTION* outputBoundary,
+        int timestep,
+        uint64_t batchSize,
+        int nvars,
+        const char **varnames
+   )
+{
+    return common_query_read_where (q, outputBoundary, timestep, batchSize, nvars, varnames);
+}
+
+void adios_query_free_values (ADIOS_QUERY_VALUES *v)
+{
+    common_query_free_values (v);
+}
+
+ADIOS_QUERY_VALUES * adios_query_topk (
+        ADIOS_FILE *f,
+        const char *varname,
+        int timestep,
+        uint64_t k,
+        int largest
+   )
+{
+    return common_query_topk (f, varname, timestep, k, largest);
+}
+
+ADIOS_QUERY_VALUES * adios_query_quantile (
+        ADIOS_FILE *f,
+        const char *varname,
+        int timestep,
+        double fraction
+   )
+{
+    return common_query_quantile (f, varname, timestep, fraction);
+}
+
 void adios_query_free(ADIOS_QUERY* q)
 {
   common_query_free(q);
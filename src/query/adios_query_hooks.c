@@ -33,6 +33,7 @@ void adios_query_hooks_init (struct adios_query_hooks_struct ** t)
       (*t) [i].adios_query_can_evaluate_fn = 0;
       (*t) [i].adios_query_evaluate_fn = 0;
       (*t) [i].adios_query_finalize_fn = 0;
+      (*t) [i].adios_query_read_where_fn = 0;
     }
 
     ASSIGN_FNS(minmax, ADIOS_QUERY_METHOD_MINMAX);
@@ -42,6 +43,12 @@ void adios_query_hooks_init (struct adios_query_hooks_struct ** t)
 #ifdef FASTBIT
     ASSIGN_FNS(fastbit, ADIOS_QUERY_METHOD_FASTBIT);
 #endif
+    ASSIGN_FNS(scan, ADIOS_QUERY_METHOD_SCAN);
+    ASSIGN_FNS(bitmap, ADIOS_QUERY_METHOD_BITMAP);
+    ASSIGN_FNS(sorted, ADIOS_QUERY_METHOD_SORTED);
+    (*t) [ADIOS_QUERY_METHOD_SCAN].adios_query_read_where_fn   = adios_query_scan_read_where;
+    (*t) [ADIOS_QUERY_METHOD_BITMAP].adios_query_read_where_fn = adios_query_bitmap_read_where;
+    (*t) [ADIOS_QUERY_METHOD_SORTED].adios_query_read_where_fn = adios_query_sorted_read_where;
 }
 
 #undef ASSIGN_FNS
@@ -14,12 +14,25 @@
 FORWARD_DECLARE(minmax)
 FORWARD_DECLARE(fastbit)
 FORWARD_DECLARE(alac)
+FORWARD_DECLARE(scan)
+FORWARD_DECLARE(bitmap)
+FORWARD_DECLARE(sorted)
+
+// optional, for methods without it common_query_read_where() evaluates and reads the points
+int adios_query_scan_read_where(ADIOS_QUERY* q, int timeStep, uint64_t batchSize, ADIOS_SELECTION* outputBoundry,
+                                int nvars, const char **varnames, ADIOS_QUERY_VALUES * result);
+int adios_query_bitmap_read_where(ADIOS_QUERY* q, int timeStep, uint64_t batchSize, ADIOS_SELECTION* outputBoundry,
+                                  int nvars, const char **varnames, ADIOS_QUERY_VALUES * result);
+int adios_query_sorted_read_where(ADIOS_QUERY* q, int timeStep, uint64_t batchSize, ADIOS_SELECTION* outputBoundry,
+                                  int nvars, const char **varnames, ADIOS_QUERY_VALUES * result);
 
 typedef int      (* ADIOS_QUERY_FREE_FN) (ADIOS_QUERY* q);
 typedef int      (* ADIOS_QUERY_FINALIZE_FN) ();
 typedef int      (* ADIOS_QUERY_EVALUATE_FN) (ADIOS_QUERY* q, int timeStep, uint64_t batchSize, ADIOS_SELECTION* o, ADIOS_QUERY_RESULT * result);
 typedef int64_t  (* ADIOS_QUERY_ESTIMATE_FN) (ADIOS_QUERY* q, int timeStep);
 typedef int  (* ADIOS_QUERY_CAN_EVALUATE_FN) (ADIOS_QUERY* q);
+typedef int      (* ADIOS_QUERY_READ_WHERE_FN) (ADIOS_QUERY* q, int timeStep, uint64_t batchSize, ADIOS_SELECTION* o,
+                                                int nvars, const char **varnames, ADIOS_QUERY_VALUES * result);
 
 struct adios_query_hooks_struct
 {
@@ -29,6 +42,7 @@ struct adios_query_hooks_struct
   ADIOS_QUERY_FREE_FN           adios_query_free_fn;
   ADIOS_QUERY_ESTIMATE_FN       adios_query_estimate_fn;
   ADIOS_QUERY_CAN_EVALUATE_FN   adios_query_can_evaluate_fn;
+  ADIOS_QUERY_READ_WHERE_FN     adios_query_read_where_fn;
 };
   
 void adios_query_hooks_init (struct adios_query_hooks_struct ** t);
@@ -11,6 +11,8 @@
 #include "core/a2sel.h"
 #include "core/adios_logger.h"
 #include "query_utils.h"
+#include "query_cache.h"
+#include "query_sorted.h"
 static struct adios_query_hooks_struct * query_hooks = 0;
 
 static int getTotalByteSize (ADIOS_FILE* f, ADIOS_VARINFO* v, ADIOS_SELECTION* sel, 
@@ -69,6 +71,7 @@ void common_query_finalize()
         // Do not free query_hooks here because they are initialized only once
         // in common_query_init ---> adios_query_hooks_init()
         query_hooks_initialized = 0;
+        query_cache_clear();
     }
 }
 
@@ -113,10 +116,13 @@ static enum ADIOS_QUERY_METHOD detect_and_set_query_method(ADIOS_QUERY* q)
           return m;
         }
     }
-    // return default that always works
+    // return default that always works: FastBit if available (it can work without an index),
+    // the built-in scan otherwise
     //q->method = ADIOS_QUERY_METHOD_FASTBIT;
-    common_query_set_method(q, ADIOS_QUERY_METHOD_FASTBIT);
-    return ADIOS_QUERY_METHOD_FASTBIT;
+    m = (common_query_is_method_available(ADIOS_QUERY_METHOD_FASTBIT) ?
+         ADIOS_QUERY_METHOD_FASTBIT : ADIOS_QUERY_METHOD_SCAN);
+    common_query_set_method(q, m);
+    return m;
 }
 
 int adios_get_actual_timestep(ADIOS_QUERY* q, int timeStep)
@@ -589,6 +595,20 @@ int64_t common_query_estimate(ADIOS_QUERY* q, int timestep)
     return -1;
 }
 
+int common_query_estimate_bounds(ADIOS_QUERY* q, int timestep,
+                                 uint64_t *estimate, uint64_t *upperBound)
+{
+    if (q == NULL || estimate == NULL || upperBound == NULL) {
+        adios_error(err_invalid_argument, "Null pointer passed to adios_query_estimate_bounds()\n");
+        return -1;
+    }
+    int actualTimeStep = adios_check_query_at_timestep(q, timestep);
+    if (actualTimeStep == -1) {
+        return -1;
+    }
+    return common_query_estimate_from_statistics(q, actualTimeStep, estimate, upperBound);
+}
+
 /*
 void common_query_set_timestep(int timeStep)
 {  
@@ -874,6 +894,364 @@ ADIOS_QUERY_RESULT * common_query_evaluate(ADIOS_QUERY* q,
 }
 
 
+/*
+ * Evaluate a range of timesteps one after the other, handing over the estimate
+ * of each step before its results. Reading through one file handle is not
+ * thread safe, so the steps are not evaluated concurrently, the query methods
+ * use the query threads within each step instead.
+ */
+int common_query_evaluate_steps(ADIOS_QUERY* q,
+              ADIOS_SELECTION* outputBoundary,
+              int fromStep,
+              int nSteps,
+              uint64_t batchSize,
+              ADIOS_QUERY_STEP_FN fn,
+              void *arg)
+{
+    ADIOS_QUERY *leaf = q;
+    int step, ret = 0;
+
+    if (q == NULL || fn == NULL) {
+        adios_error(err_invalid_argument, "%s: query and callback function are required\n", __func__);
+        return -1;
+    }
+    while (leaf->left != NULL)
+        leaf = leaf->left;
+    if (leaf->file == NULL) {
+        adios_error(err_invalid_argument, "%s: query has no file\n", __func__);
+        return -1;
+    }
+    if (leaf->file->is_streaming == 1) {
+        adios_error(err_operation_not_supported,
+                    "%s: evaluating a range of timesteps is only supported on files, "
+                    "use adios_query_evaluate() on streams\n", __func__);
+        return -1;
+    }
+    if (fromStep < 0 || nSteps < 0 || fromStep + nSteps > leaf->file->last_step + 1) {
+        adios_error(err_invalid_timestep, "%s: timesteps %d..%d are out of the range "
+                    "of the file (0..%d)\n", __func__, fromStep, fromStep + nSteps - 1,
+                    leaf->file->last_step);
+        return -1;
+    }
+
+    for (step = fromStep; step < fromStep + nSteps && ret == 0; step++)
+    {
+        int64_t nhits = common_query_estimate(q, step);
+        int r;
+        if (nhits < 0) {
+            ret = -1;
+            break;
+        }
+        r = fn(step, nhits, NULL, arg);
+        if (r < 0)
+            break;
+        if (r > 0 || nhits == 0)
+            continue;
+
+        for (;;) {
+            ADIOS_QUERY_RESULT *result = common_query_evaluate(q, outputBoundary, step, batchSize);
+            enum ADIOS_QUERY_RESULT_STATUS status = result->status;
+            if (status == ADIOS_QUERY_RESULT_ERROR) {
+                free(result);
+                ret = -1;
+                break;
+            }
+            r = fn(step, nhits, result, arg);
+            if (r < 0)
+                return 0;
+            if (r > 0 || status == ADIOS_QUERY_NO_MORE_RESULTS)
+                break;
+        }
+    }
+    return ret;
+}
+
+/*
+ * Global coordinates of the points of one selection of an evaluation result
+ * into 'pts' (ndim per point). Points may be relative to a bounding box or
+ * writeblock container, and may be 1D offsets in it (FASTBIT, ALACRITY).
+ */
+static int global_points (ADIOS_QUERY *leaf, int timeStep, ADIOS_SELECTION_POINTS_STRUCT *sp,
+                          int ndim, uint64_t *pts)
+{
+    ADIOS_SELECTION *c = sp->container_selection;
+    uint64_t *start = NULL, *count = NULL;
+    uint64_t n;
+    int d;
+
+    if (c && c->type == ADIOS_SELECTION_BOUNDINGBOX) {
+        start = c->u.bb.start;
+        count = c->u.bb.count;
+    } else if (c && c->type == ADIOS_SELECTION_WRITEBLOCK) {
+        ADIOS_VARINFO *v = leaf->varinfo;
+        int i, idx = c->u.block.index;
+        if (!v->blockinfo)
+            common_read_inq_var_blockinfo (leaf->file, v);
+        if (!c->u.block.is_absolute_index) {
+            for (i = 0; i < timeStep; i++)
+                idx += v->nblocks[i];
+        }
+        if (!v->blockinfo || idx < 0 || idx >= v->sum_nblocks)
+            return -1;
+        start = v->blockinfo[idx].start;
+        count = v->blockinfo[idx].count;
+    } else if (c) {
+        return -1;
+    }
+
+    if (start && sp->ndim == 1 && ndim > 1) {
+        a2sel_points_1DtoND_box (sp->npoints, sp->points, ndim, start, count, 1, pts);
+        return 0;
+    }
+    if (sp->ndim != ndim)
+        return -1;
+    for (n = 0; n < sp->npoints; n++) {
+        for (d = 0; d < ndim; d++)
+            pts[n*ndim+d] = sp->points[n*ndim+d] + (start ? start[d] : 0);
+    }
+    return 0;
+}
+
+/* read_where of the methods without their own: evaluate a batch of points
+   and read the values at them */
+static void read_where_points (ADIOS_QUERY *q, enum ADIOS_QUERY_METHOD m, int timeStep,
+                               uint64_t batchSize, ADIOS_SELECTION *outputBoundary,
+                               int nvars, const char **varnames, ADIOS_QUERY_VALUES *result)
+{
+    ADIOS_QUERY_RESULT *r = (ADIOS_QUERY_RESULT *) calloc (1, sizeof(ADIOS_QUERY_RESULT));
+    ADIOS_QUERY *leaf = q;
+    int i, err = 0;
+
+    assert (r);
+    while (leaf->left != NULL)
+        leaf = leaf->left;
+
+    query_hooks[m].adios_query_evaluate_fn(q, timeStep, batchSize, outputBoundary, r);
+    if (r->status == ADIOS_QUERY_RESULT_ERROR) {
+        free (r);
+        result->status = ADIOS_QUERY_RESULT_ERROR;
+        return;
+    }
+
+    // collect the points of all selections
+    result->ndim = 0;
+    result->npoints = 0;
+    for (i = 0; i < r->nselections && !err; i++) {
+        ADIOS_SELECTION *sel = &r->selections[i];
+        if (sel->type != ADIOS_SELECTION_POINTS) {
+            adios_error (err_operation_not_supported, "%s: query method %s returns writeblocks, "
+                         "not points, reading the values of the hits is not supported\n",
+                         __func__, query_hooks[m].method_name);
+            err = 1;
+            break;
+        }
+        ADIOS_SELECTION *c = sel->u.points.container_selection;
+        int ndim = (c && c->type == ADIOS_SELECTION_BOUNDINGBOX ? c->u.bb.ndim :
+                    (c && sel->u.points.ndim == 1 ? leaf->varinfo->ndim : sel->u.points.ndim));
+        if (result->ndim && ndim != result->ndim) {
+            adios_error (err_incompatible_queries, "%s: the query results have points of different "
+                         "dimensions\n", __func__);
+            err = 1;
+        }
+        result->ndim = ndim;
+        result->npoints += sel->u.points.npoints;
+    }
+    if (!err && result->npoints) {
+        uint64_t offs = 0;
+        result->points = (uint64_t *) malloc (result->npoints * result->ndim * sizeof(uint64_t));
+        if (!result->points) {
+            adios_error (err_no_memory, "%s: cannot allocate memory for %" PRIu64 " points\n",
+                         __func__, result->npoints);
+            err = 1;
+        }
+        for (i = 0; i < r->nselections && !err; i++) {
+            ADIOS_SELECTION_POINTS_STRUCT *sp = &r->selections[i].u.points;
+            if (global_points (leaf, timeStep, sp, result->ndim, result->points + offs * result->ndim)) {
+                adios_error (err_incompatible_queries, "%s: cannot convert the points of the query "
+                             "results to global coordinates\n", __func__);
+                err = 1;
+            }
+            offs += sp->npoints;
+        }
+    }
+
+    for (i = 0; i < r->nselections; i++) {
+        if (r->selections[i].type == ADIOS_SELECTION_POINTS)
+            free (r->selections[i].u.points.points);
+    }
+    free (r->selections);
+    result->status = r->status;
+    free (r);
+
+    if (!err)
+        err = common_query_read_where_values (leaf->file, timeStep, nvars, varnames, NULL, NULL, result);
+    if (err)
+        result->status = ADIOS_QUERY_RESULT_ERROR;
+}
+
+ADIOS_QUERY_VALUES * common_query_read_where(ADIOS_QUERY* q,
+              ADIOS_SELECTION* outputBoundary,
+              int timeStep,
+              uint64_t batchSize,
+              int nvars,
+              const char **varnames)
+{
+    ADIOS_QUERY_VALUES *result = (ADIOS_QUERY_VALUES *) calloc (1, sizeof(ADIOS_QUERY_VALUES));
+    int i;
+    assert (result);
+    result->method_used = ADIOS_QUERY_METHOD_UNKNOWN;
+    result->status = ADIOS_QUERY_RESULT_ERROR;
+
+    if (q == NULL || nvars < 0 || (nvars > 0 && varnames == NULL)) {
+        adios_error(err_invalid_argument, "%s: a query and the names of the variables to read "
+                    "are required\n", __func__);
+        return result;
+    }
+    for (i = 0; i < nvars; i++) {
+        if (varnames[i] == NULL) {
+            adios_error(err_invalid_argument, "%s: variable name %d is NULL\n", __func__, i);
+            return result;
+        }
+    }
+    if (adios_check_query_at_timestep(q, timeStep) == -1)
+        return result;
+
+    int freeOutputBoundary = 0;
+    if ((outputBoundary != NULL) && (outputBoundary->type == ADIOS_SELECTION_WRITEBLOCK)) {
+        int index = outputBoundary->u.block.index;
+        outputBoundary = convertWriteblockToBoundingBox(q, &outputBoundary->u.block, timeStep);
+        if (!outputBoundary) {
+            adios_error(err_invalid_argument,
+              "Attempt to use writeblock output selection on a query where not "
+              "all variables participating have the same varblock bounding box "
+              "at that writeblock index (index = %d)\n", index);
+            return result;
+        }
+        freeOutputBoundary = 1;
+    }
+
+    enum ADIOS_QUERY_METHOD m = detect_and_set_query_method (q);
+    result->method_used = m;
+    if (query_hooks[m].adios_query_read_where_fn != NULL) {
+        query_hooks[m].adios_query_read_where_fn(q, timeStep, batchSize, outputBoundary,
+                                                 nvars, varnames, result);
+    } else if (query_hooks[m].adios_query_evaluate_fn != NULL) {
+        read_where_points(q, m, timeStep, batchSize, outputBoundary, nvars, varnames, result);
+    } else {
+        log_debug ("No selection method is supported for method: %d\n", m);
+        result->method_used = ADIOS_QUERY_METHOD_UNKNOWN;
+    }
+    if (freeOutputBoundary) a2sel_free(outputBoundary);
+    return result;
+}
+
+void common_query_free_values(ADIOS_QUERY_VALUES *v)
+{
+    int i;
+    if (v == NULL)
+        return;
+    if (v->values) {
+        for (i = 0; i < v->nvars; i++)
+            free(v->values[i]);
+    }
+    free(v->values);
+    free(v->types);
+    free(v->points);
+    free(v);
+}
+
+// Open the sorted index of a variable at a timestep for top-k and quantile queries
+static QUERY_SORTED_INDEX * open_sorted_index(ADIOS_FILE *f, const char *varName, int timeStep,
+              ADIOS_QUERY_VALUES *result)
+{
+    QUERY_SORTED_INDEX *idx = NULL;
+    ADIOS_VARINFO *v;
+
+    result->method_used = ADIOS_QUERY_METHOD_SORTED;
+    result->status = ADIOS_QUERY_RESULT_ERROR;
+    if (f == NULL || varName == NULL) {
+        adios_error(err_invalid_argument, "%s: a file and a variable name are required\n", __func__);
+        return NULL;
+    }
+    if (f->is_streaming) {
+        adios_error(err_operation_not_supported, "%s: sorted indexes are supported on files only\n",
+                    __func__);
+        return NULL;
+    }
+    v = common_read_inq_var(f, varName);
+    if (v == NULL) {
+        adios_error(err_invalid_varname, "Invalid variable '%s':\n%s", varName, adios_get_last_errmsg());
+        return NULL;
+    }
+    if (timeStep < 0 || timeStep >= v->nsteps) {
+        adios_error(err_invalid_timestep, "%s: variable %s has no step %d\n", __func__, varName, timeStep);
+    } else {
+        adios_clear_error();
+        idx = query_sorted_open(f, varName, v, timeStep);
+        if (idx == NULL && !adios_errno) {
+            adios_error(err_operation_not_supported, "%s: variable %s has no sorted index at step %d, "
+                        "see the adios_index_sorted utility\n", __func__, varName, timeStep);
+        }
+    }
+    common_read_free_varinfo(v);
+    return idx;
+}
+
+ADIOS_QUERY_VALUES * common_query_topk(ADIOS_FILE *f, const char *varName, int timeStep,
+              uint64_t k, int largest)
+{
+    ADIOS_QUERY_VALUES *result = (ADIOS_QUERY_VALUES *) calloc (1, sizeof(ADIOS_QUERY_VALUES));
+    QUERY_SORTED_INDEX *idx;
+    assert (result);
+
+    idx = open_sorted_index(f, varName, timeStep, result);
+    if (idx != NULL) {
+        if (query_sorted_topk(idx, k, largest, result) == 0)
+            result->status = ADIOS_QUERY_NO_MORE_RESULTS;
+        query_sorted_free(idx);
+    }
+    return result;
+}
+
+ADIOS_QUERY_VALUES * common_query_quantile(ADIOS_FILE *f, const char *varName, int timeStep,
+              double fraction)
+{
+    ADIOS_QUERY_VALUES *result = (ADIOS_QUERY_VALUES *) calloc (1, sizeof(ADIOS_QUERY_VALUES));
+    QUERY_SORTED_INDEX *idx;
+    assert (result);
+
+    if (!(fraction >= 0.0 && fraction <= 1.0)) {
+        result->method_used = ADIOS_QUERY_METHOD_SORTED;
+        result->status = ADIOS_QUERY_RESULT_ERROR;
+        adios_error(err_invalid_argument, "%s: the fraction must be between 0 and 1\n", __func__);
+        return result;
+    }
+    idx = open_sorted_index(f, varName, timeStep, result);
+    if (idx != NULL) {
+        if (query_sorted_quantile(idx, fraction, result) == 0)
+            result->status = ADIOS_QUERY_NO_MORE_RESULTS;
+        query_sorted_free(idx);
+    }
+    return result;
+}
+
+void common_query_set_threads(int nthreads)
+{
+    query_utils_set_threads(nthreads);
+}
+
+void common_query_set_cache_size(uint64_t bytes)
+{
+    query_cache_set_size(bytes);
+}
+
+void common_query_file_closed(ADIOS_FILE *f)
+{
+    query_cache_drop_file(f);
+    query_sorted_file_closed(f);
+}
+
+
 enum ADIOS_PREDICATE_MODE adios_query_getOp(const char* opStr)
 {
   if ((strcmp(opStr, ">=") == 0) || (strcmp(opStr, "GE") == 0)) {
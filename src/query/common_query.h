@@ -32,6 +32,13 @@ ADIOS_QUERY* common_query_combine(ADIOS_QUERY* q1,
 
 int64_t common_query_estimate(ADIOS_QUERY* q, int timestep);
 
+int common_query_estimate_bounds(ADIOS_QUERY* q, int timestep,
+			  uint64_t *estimate, uint64_t *upperBound);
+
+// in common_query_estimate.c, expects a query checked at the timestep
+int common_query_estimate_from_statistics(ADIOS_QUERY* q, int timestep,
+			  uint64_t *estimate, uint64_t *upperBound);
+
 //void common_query_set_timestep(int timeStep);
 
 ADIOS_QUERY_RESULT * common_query_evaluate(ADIOS_QUERY* q, 
@@ -39,6 +46,21 @@ ADIOS_QUERY_RESULT * common_query_evaluate(ADIOS_QUERY* q,
 			  int timestep,
 			  uint64_t batchSize);
 
+int common_query_evaluate_steps(ADIOS_QUERY* q,
+			  ADIOS_SELECTION* outputBoundary,
+			  int fromStep,
+			  int nSteps,
+			  uint64_t batchSize,
+			  ADIOS_QUERY_STEP_FN fn,
+			  void *arg);
+
+void common_query_set_threads(int nthreads);
+
+void common_query_set_cache_size(uint64_t bytes);
+
+// called from Read close; drops the cached query results of the file
+void common_query_file_closed(ADIOS_FILE *f);
+
 int common_query_read_boundingbox (
         ADIOS_FILE *f,
         ADIOS_QUERY *q,
@@ -50,6 +72,30 @@ int common_query_read_boundingbox (
         void *data
    );
 
+ADIOS_QUERY_VALUES * common_query_read_where(ADIOS_QUERY* q,
+			  ADIOS_SELECTION* outputBoundary,
+			  int timestep,
+			  uint64_t batchSize,
+			  int nvars,
+			  const char **varnames);
+
+void common_query_free_values(ADIOS_QUERY_VALUES *v);
+
+ADIOS_QUERY_VALUES * common_query_topk(ADIOS_FILE *f, const char *varName, int timestep,
+			  uint64_t k, int largest);
+
+ADIOS_QUERY_VALUES * common_query_quantile(ADIOS_FILE *f, const char *varName, int timestep,
+			  double fraction);
+
+// in common_query_read.c, used by the read_where of the query methods:
+// fills result->types and result->values for result->points; 'known' (if
+// given) copies the values it has and marks them in 'have', the rest is read
+typedef void (*QUERY_VALUES_KNOWN_FN) (void *arg, const ADIOS_VARINFO *v, uint64_t npoints,
+			  const uint64_t *points, char *values, char *have);
+
+int common_query_read_where_values(ADIOS_FILE *f, int timestep, int nvars, const char **varnames,
+			  QUERY_VALUES_KNOWN_FN known, void *arg, ADIOS_QUERY_VALUES *result);
+
 void common_query_free(ADIOS_QUERY* q);
 
 // called from Read finalize only; 
@@ -0,0 +1,381 @@
+/*
+ * common_query_estimate.c
+ *
+ * Estimation of the number of hits of a query from the statistics recorded at
+ * writing, without reading data and independently of the query method.
+ *
+ * Each condition is estimated block by block. If the writer recorded a
+ * histogram, the elements of a block are counted bin by bin, assuming the
+ * values are distributed uniformly within a bin (narrowed to the block's
+ * min/max). Otherwise they are assumed uniform between the block's min and
+ * max. Blocks partially covered by the selection contribute in proportion.
+ * Conditions combined with AND/OR are assumed to be independent.
+ *
+ * The upper bound counts every element that the statistics cannot exclude.
+ * Like the Minmax method, it relies on the min/max statistics, which do not
+ * include NaN and infinite values.
+ */
+#include <inttypes.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include "public/adios_error.h"
+#include "public/adios_query.h"
+#include "core/common_read.h"
+#include "core/adios_logger.h"
+#include "common_query.h"
+#include "query_utils.h"
+
+typedef struct {
+    uint64_t n;      // elements in the selection
+    double   est;    // estimated hits
+    uint64_t upper;  // hits that cannot be exceeded
+} QUERY_ESTIMATE;
+
+static int is_integer_type (enum ADIOS_DATATYPES type)
+{
+    return (type != adios_real && type != adios_double);
+}
+
+static double value_to_double (enum ADIOS_DATATYPES type, const void *value)
+{
+    switch (type)
+    {
+        case adios_byte:             return *(const int8_t *) value;
+        case adios_unsigned_byte:    return *(const uint8_t *) value;
+        case adios_short:            return *(const int16_t *) value;
+        case adios_unsigned_short:   return *(const uint16_t *) value;
+        case adios_integer:          return *(const int32_t *) value;
+        case adios_unsigned_integer: return *(const uint32_t *) value;
+        case adios_long:             return (double) *(const int64_t *) value;
+        case adios_unsigned_long:    return (double) *(const uint64_t *) value;
+        case adios_real:             return *(const float *) value;
+        case adios_double:           return *(const double *) value;
+        default:                     return 0.0;
+    }
+}
+
+static int is_supported_type (enum ADIOS_DATATYPES type)
+{
+    switch (type)
+    {
+        case adios_byte:
+        case adios_unsigned_byte:
+        case adios_short:
+        case adios_unsigned_short:
+        case adios_integer:
+        case adios_unsigned_integer:
+        case adios_long:
+        case adios_unsigned_long:
+        case adios_real:
+        case adios_double:
+            return 1;
+        default:
+            return 0;
+    }
+}
+
+static double clamp01 (double f)
+{
+    return (f < 0.0 ? 0.0 : (f > 1.0 ? 1.0 : f));
+}
+
+/*
+ * Fraction of the values in [lo, hi] that satisfy 'op x', with values uniformly
+ * distributed in the range (integers only, for integer types). *possible is set
+ * to 0 if no value in the range can satisfy the condition.
+ */
+static double range_fraction (enum ADIOS_PREDICATE_MODE op, double x, double lo, double hi,
+                              int integer, int *possible)
+{
+    double le, lt;   // fraction of values <= x and < x
+
+    switch (op)
+    {
+        case ADIOS_LT:   *possible = (lo < x); break;
+        case ADIOS_LTEQ: *possible = (lo <= x); break;
+        case ADIOS_GT:   *possible = (hi > x); break;
+        case ADIOS_GTEQ: *possible = (hi >= x); break;
+        case ADIOS_EQ:   *possible = (lo <= x && x <= hi); break;
+        case ADIOS_NE:   *possible = !(lo == x && hi == x); break;
+        default:         *possible = 1; break;
+    }
+    if (!*possible)
+        return 0.0;
+
+    if (!isfinite (lo) || !isfinite (hi)) {
+        // no bounds to spread the values over, unless the range is decided
+        le = (hi <= x ? 1.0 : (lo > x ? 0.0 : 0.5));
+        lt = (hi < x ? 1.0 : (lo >= x ? 0.0 : 0.5));
+    } else if (integer) {
+        double m;
+        lo = ceil (lo);
+        hi = floor (hi);
+        m = hi - lo + 1;
+        if (m < 1)
+            return 0.0;
+        le = clamp01 ((floor (x) - lo + 1) / m);
+        lt = clamp01 ((ceil (x) - lo) / m);
+    } else if (hi > lo) {
+        le = lt = clamp01 ((x - lo) / (hi - lo));
+    } else {
+        le = (lo <= x);
+        lt = (lo < x);
+    }
+
+    switch (op)
+    {
+        case ADIOS_LT:   return lt;
+        case ADIOS_LTEQ: return le;
+        case ADIOS_GT:   return 1.0 - le;
+        case ADIOS_GTEQ: return 1.0 - lt;
+        case ADIOS_EQ:   return le - lt;
+        case ADIOS_NE:   return 1.0 - (le - lt);
+        default:         return 1.0;
+    }
+}
+
+/*
+ * Estimate the hits among the 'n' elements of block 'b' (index among all steps).
+ * Real values equal to x inside a continuous range are counted as one element.
+ */
+static void estimate_block (ADIOS_VARINFO *v, int b, uint64_t n,
+                            enum ADIOS_PREDICATE_MODE op, double x,
+                            double *est, uint64_t *upper)
+{
+    ADIOS_VARSTAT *st = v->statistics;
+    int integer = is_integer_type (v->type);
+    double bmin = -HUGE_VAL, bmax = HUGE_VAL;
+    int possible;
+
+    if (!st || !st->blocks || !st->blocks->mins || !st->blocks->maxs ||
+        !st->blocks->mins[b] || !st->blocks->maxs[b])
+    {
+        // nothing is known about the block
+        *est = (double) n;
+        *upper = n;
+        return;
+    }
+    bmin = value_to_double (v->type, st->blocks->mins[b]);
+    bmax = value_to_double (v->type, st->blocks->maxs[b]);
+
+    if (st->histogram && st->histogram->bfrequencies && st->histogram->bfrequencies[b])
+    {
+        const struct ADIOS_HIST *h = st->histogram;
+        const uint32_t *freq = h->bfrequencies[b];
+        uint64_t counted = 0;
+        uint32_t k;
+
+        *est = 0.0;
+        *upper = 0;
+        for (k = 0; k <= h->num_breaks; k++)
+        {
+            double lo = (k == 0 ? bmin : h->breaks[k-1]);
+            double hi = (k == h->num_breaks ? bmax : h->breaks[k]);
+            double f;
+            if (!freq[k])
+                continue;
+            counted += freq[k];
+            if (lo < bmin) lo = bmin;
+            if (hi > bmax) hi = bmax;
+            if (integer && k < h->num_breaks && hi == h->breaks[k])
+                hi = ceil (hi) - 1;   // bins exclude their upper edge
+            f = range_fraction (op, x, lo, hi, integer, &possible);
+            if (!possible)
+                continue;
+            if (!integer && lo < hi && lo <= x && x <= hi) {
+                if (op == ADIOS_EQ)
+                    f = 1.0 / freq[k];
+                else if (op == ADIOS_NE)
+                    f = 1.0 - 1.0 / freq[k];
+            }
+            *est += f * freq[k];
+            *upper += freq[k];
+        }
+        // elements not in the histogram are NaN or infinite
+        if (counted < n) {
+            if (op == ADIOS_NE)
+                *est += (double) (n - counted);
+            if (op != ADIOS_EQ || !isfinite (x))
+                *upper += n - counted;
+        }
+        return;
+    }
+
+    double f = range_fraction (op, x, bmin, bmax, integer, &possible);
+    if (!integer && bmin < bmax && bmin <= x && x <= bmax) {
+        if (op == ADIOS_EQ)
+            f = 1.0 / n;
+        else if (op == ADIOS_NE)
+            f = 1.0 - 1.0 / n;
+    }
+    *est = f * n;
+    *upper = (possible ? n : 0);
+}
+
+static uint64_t box_overlap (int ndim, const uint64_t *start1, const uint64_t *count1,
+                             const uint64_t *start2, const uint64_t *count2)
+{
+    uint64_t n = 1;
+    int d;
+    for (d = 0; d < ndim; d++) {
+        uint64_t s = (start1[d] > start2[d] ? start1[d] : start2[d]);
+        uint64_t e1 = start1[d] + count1[d], e2 = start2[d] + count2[d];
+        uint64_t e = (e1 < e2 ? e1 : e2);
+        if (e <= s)
+            return 0;
+        n *= e - s;
+    }
+    return n;
+}
+
+static uint64_t box_size (int ndim, const uint64_t *count)
+{
+    uint64_t n = 1;
+    int d;
+    for (d = 0; d < ndim; d++)
+        n *= count[d];
+    return n;
+}
+
+static int estimate_leaf (ADIOS_QUERY *q, int timestep, QUERY_ESTIMATE *e)
+{
+    ADIOS_VARINFO *v = q->varinfo;
+    const uint64_t *start = NULL, *count = v->dims;
+    uint64_t zeros[32] = {0};
+    int i, block_start_idx = 0, loop_start = 0, loop_end;
+    int points = 0;
+    double x, sum_est = 0.0, sum_n = 0.0;
+    uint64_t sum_upper = 0;
+
+    if (!is_supported_type (v->type)) {
+        adios_error (err_unsupported_selection, "%s: variable %s has a type that "
+                "cannot be estimated\n", __func__, q->varName);
+        return -1;
+    }
+    if (v->ndim > 32 || timestep < 0 || timestep >= v->nsteps) {
+        adios_error (err_invalid_timestep, "%s: variable %s has no step %d\n",
+                __func__, q->varName, timestep);
+        return -1;
+    }
+    if (!v->blockinfo)
+        common_read_inq_var_blockinfo (q->file, v);
+    if (!v->statistics)
+        common_read_inq_var_stat (q->file, v, 0, 1);
+    if (!v->blockinfo)
+        return -1;
+
+    for (i = 0; i < timestep; i++)
+        block_start_idx += v->nblocks[i];
+    loop_end = v->nblocks[timestep];
+    start = zeros;
+
+    if (q->sel && q->sel->type == ADIOS_SELECTION_BOUNDINGBOX) {
+        start = q->sel->u.bb.start;
+        count = q->sel->u.bb.count;
+    } else if (q->sel && q->sel->type == ADIOS_SELECTION_WRITEBLOCK) {
+        loop_start = (q->sel->u.block.is_absolute_index ?
+                      q->sel->u.block.index - block_start_idx :
+                      q->sel->u.block.index);
+        loop_end = loop_start + 1;
+        if (loop_start < 0 || loop_start >= v->nblocks[timestep]) {
+            adios_error (err_invalid_query_value, "%s: writeblock %d of variable %s "
+                    "does not exist at step %d\n", __func__, q->sel->u.block.index,
+                    q->varName, timestep);
+            return -1;
+        }
+        start = v->blockinfo[block_start_idx + loop_start].start;
+        count = v->blockinfo[block_start_idx + loop_start].count;
+    } else if (q->sel && q->sel->type == ADIOS_SELECTION_POINTS) {
+        points = 1;
+    }
+
+    x = strtod (q->predicateValue, NULL);
+
+    for (i = loop_start; i < loop_end; i++)
+    {
+        int b = block_start_idx + i;
+        uint64_t nb = box_size (v->ndim, v->blockinfo[b].count);
+        uint64_t nisect = nb, bupper;
+        double best;
+
+        if (!points)
+            nisect = box_overlap (v->ndim, v->blockinfo[b].start, v->blockinfo[b].count,
+                                  start, count);
+        if (!nisect || !nb)
+            continue;
+
+        estimate_block (v, b, nb, q->predicateOp, x, &best, &bupper);
+        sum_n += (double) nb;
+        if (points) {
+            sum_est += best;
+            sum_upper += bupper;
+        } else {
+            // the hits of a partially selected block may all be in the selected part
+            sum_est += best * ((double) nisect / (double) nb);
+            sum_upper += (bupper < nisect ? bupper : nisect);
+        }
+    }
+
+    if (points) {
+        // the same share of the points as of the elements of the blocks
+        e->n = q->sel->u.points.npoints;
+        e->est = (sum_n > 0 ? sum_est / sum_n * e->n : 0.0);
+        e->upper = (sum_upper < e->n ? sum_upper : e->n);
+    } else {
+        e->n = box_size (v->ndim, count);
+        e->est = sum_est;
+        e->upper = sum_upper;
+    }
+    return 0;
+}
+
+static int estimate_rec (ADIOS_QUERY *q, int timestep, QUERY_ESTIMATE *e)
+{
+    QUERY_ESTIMATE l, r;
+    double pl, pr;
+
+    if (q->left == NULL && q->right == NULL)
+        return estimate_leaf (q, timestep, e);
+
+    if (q->left == NULL || q->right == NULL)
+        return estimate_rec (q->left ? q->left : q->right, timestep, e);
+
+    if (estimate_rec (q->left, timestep, &l) || estimate_rec (q->right, timestep, &r))
+        return -1;
+
+    // the selections of the conditions have the same shape
+    e->n = (l.n > r.n ? l.n : r.n);
+    pl = (l.n ? l.est / l.n : 0.0);
+    pr = (r.n ? r.est / r.n : 0.0);
+    if (q->combineOp == ADIOS_QUERY_OP_AND) {
+        e->est = pl * pr * e->n;
+        e->upper = (l.upper < r.upper ? l.upper : r.upper);
+    } else {
+        e->est = (pl + pr - pl * pr) * e->n;
+        e->upper = l.upper + r.upper;
+        if (e->upper > e->n)
+            e->upper = e->n;
+    }
+    return 0;
+}
+
+int common_query_estimate_from_statistics (ADIOS_QUERY *q, int timestep,
+                                           uint64_t *estimate, uint64_t *upperBound)
+{
+    QUERY_ESTIMATE e;
+
+    if (estimate_rec (q, timestep, &e))
+        return -1;
+
+    if (e.est < 0.0)
+        e.est = 0.0;
+    *estimate = (uint64_t) llround (e.est);
+    if (*estimate > e.upper)
+        *estimate = e.upper;
+    *upperBound = e.upper;
+    log_debug ("%s: query estimated at step %d: %" PRIu64 " hits, at most %" PRIu64
+            " of %" PRIu64 " elements\n", __func__, timestep, *estimate, *upperBound, e.n);
+    return 0;
+}
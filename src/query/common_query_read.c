@@ -8,6 +8,7 @@
 #include "adios_query_hooks.h"
 #include "public/adios_error.h"
 #include "core/common_read.h"
+#include "core/a2sel.h"
 #include "core/adios_logger.h"
 #include "core/util.h"
 #include "query_utils.h"
@@ -582,3 +583,197 @@ int common_query_read_boundingbox (
     return 0;
 }
 
+
+
+/* Upper limit of data read in one go by common_query_read_where_values().
+   The box of a single block is still read at once. */
+#define QUERY_VALUES_READ_BYTES (64*1024*1024)
+#define QUERY_VALUES_MAX_DIMS 32
+
+static int point_in_block (const ADIOS_VARBLOCK *bi, int ndim, const uint64_t *pt)
+{
+    int d;
+    for (d = 0; d < ndim; d++) {
+        if (pt[d] < bi->start[d] || pt[d] >= bi->start[d] + bi->count[d])
+            return 0;
+    }
+    return 1;
+}
+
+/* Read the values of 'v' at the points (global coordinates) not marked in
+ * 'have' (if given) into 'values'. The points are grouped by the writeblocks
+ * that contain them and only the box around the points of each block is read,
+ * instead of reading the points one by one.
+ */
+static int read_values_at_points (ADIOS_FILE *f, ADIOS_VARINFO *v, int timestep,
+                                  uint64_t npoints, const uint64_t *points,
+                                  const char *have, char *values)
+{
+    int ndim = v->ndim;
+    int elemsize = common_read_type_size (v->type, v->value);
+    int i, d, b, first = 0, last = 0, err = 0;
+    int nb = v->nblocks[timestep];
+    uint64_t p;
+
+    for (i = 0; i < timestep; i++)
+        first += v->nblocks[i];
+
+    int *pblock = (int *) malloc ((npoints ? npoints : 1) * sizeof(int));
+    uint64_t *lo = (uint64_t *) malloc ((nb ? nb : 1) * ndim * sizeof(uint64_t));
+    uint64_t *hi = (uint64_t *) malloc ((nb ? nb : 1) * ndim * sizeof(uint64_t));
+    uint64_t *nhits = (uint64_t *) calloc ((nb ? nb : 1), sizeof(uint64_t));
+    char **data = (char **) calloc ((nb ? nb : 1), sizeof(char *));
+    if (!pblock || !lo || !hi || !nhits || !data) {
+        adios_error (err_no_memory, "%s: cannot allocate memory to read the values of variable %s\n",
+                __func__, f->var_namelist[v->varid]);
+        err = err_no_memory;
+    }
+
+    // assign the points to blocks, consecutive points are usually in the same block
+    for (p = 0; p < npoints && !err; p++)
+    {
+        const uint64_t *pt = points + p * ndim;
+        pblock[p] = -1;
+        if (have && have[p])
+            continue;
+        if (!nb || !point_in_block (&v->blockinfo[first + last], ndim, pt)) {
+            for (b = 0; b < nb && !point_in_block (&v->blockinfo[first + b], ndim, pt); b++)
+                ;
+            if (b == nb) {
+                adios_error (err_out_of_bound, "%s: point %" PRIu64 " of the query results is not "
+                        "in any block of variable %s at step %d\n",
+                        __func__, p, f->var_namelist[v->varid], timestep);
+                err = err_out_of_bound;
+                break;
+            }
+            last = b;
+        }
+        b = last;
+        pblock[p] = b;
+        for (d = 0; d < ndim; d++) {
+            if (!nhits[b] || pt[d] < lo[b*ndim+d])
+                lo[b*ndim+d] = pt[d];
+            if (!nhits[b] || pt[d] > hi[b*ndim+d])
+                hi[b*ndim+d] = pt[d];
+        }
+        nhits[b]++;
+    }
+
+    // read the boxes of the blocks in rounds of limited size, then pick the values
+    b = 0;
+    while (!err && b < nb)
+    {
+        int round_start = b, nscheduled = 0;
+        uint64_t bytes = 0;
+        for (; b < nb && !err; b++)
+        {
+            uint64_t count[QUERY_VALUES_MAX_DIMS], n = 1;
+            if (!nhits[b])
+                continue;
+            for (d = 0; d < ndim; d++) {
+                count[d] = hi[b*ndim+d] - lo[b*ndim+d] + 1;
+                n *= count[d];
+            }
+            if (nscheduled && bytes + n * elemsize > QUERY_VALUES_READ_BYTES)
+                break;
+            data[b] = (char *) malloc (n * elemsize);
+            if (!data[b]) {
+                adios_error (err_no_memory, "%s: cannot allocate %" PRIu64 " bytes to read "
+                        "a block of variable %s\n", __func__, n * elemsize, f->var_namelist[v->varid]);
+                err = err_no_memory;
+                break;
+            }
+            ADIOS_SELECTION *sel = a2sel_boundingbox (ndim, &lo[b*ndim], count);
+            common_read_schedule_read_byid (f, sel, v->varid, timestep, 1, NULL, data[b]);
+            a2sel_free (sel);
+            bytes += n * elemsize;
+            nscheduled++;
+        }
+        if (!err && nscheduled && common_read_perform_reads (f, 1) != 0)
+            err = adios_errno;
+
+        for (p = 0; p < npoints && !err; p++)
+        {
+            int pb = pblock[p];
+            if (pb < round_start || pb >= b)
+                continue;
+            const uint64_t *pt = points + p * ndim;
+            uint64_t pos = 0;
+            for (d = 0; d < ndim; d++)
+                pos = pos * (hi[pb*ndim+d] - lo[pb*ndim+d] + 1) + (pt[d] - lo[pb*ndim+d]);
+            memcpy (values + p * elemsize, data[pb] + pos * elemsize, elemsize);
+        }
+        for (i = round_start; i < b && i < nb; i++) {
+            free (data[i]);
+            data[i] = NULL;
+        }
+    }
+
+    if (data) {
+        for (i = 0; i < nb; i++)
+            free (data[i]);
+    }
+    free (data);
+    free (nhits);
+    free (hi);
+    free (lo);
+    free (pblock);
+    return err;
+}
+
+int common_query_read_where_values (ADIOS_FILE *f, int timestep, int nvars, const char **varnames,
+                                    QUERY_VALUES_KNOWN_FN known, void *arg, ADIOS_QUERY_VALUES *result)
+{
+    int i, err = 0;
+    char *have = NULL;
+
+    result->nvars = nvars;
+    result->types = (enum ADIOS_DATATYPES *) calloc ((nvars ? nvars : 1), sizeof(enum ADIOS_DATATYPES));
+    result->values = (void **) calloc ((nvars ? nvars : 1), sizeof(void *));
+    if (known)
+        have = (char *) malloc (result->npoints ? result->npoints : 1);
+    if (!result->types || !result->values || (known && !have)) {
+        adios_error (err_no_memory, "%s: cannot allocate memory for the values of the query results\n",
+                __func__);
+        free (have);
+        return err_no_memory;
+    }
+
+    for (i = 0; i < nvars && !err; i++)
+    {
+        ADIOS_VARINFO *v = common_read_inq_var (f, varnames[i]);
+        if (!v) {
+            err = adios_errno;
+            break;
+        }
+        if (!v->global || v->ndim != result->ndim || v->ndim > QUERY_VALUES_MAX_DIMS) {
+            adios_error (err_incompatible_queries, "%s: variable %s is not a global array of "
+                    "%d dimensions like the query results\n", __func__, varnames[i], result->ndim);
+            err = err_incompatible_queries;
+        } else if (!v->blockinfo && common_read_inq_var_blockinfo (f, v) != 0) {
+            err = adios_errno;
+        }
+
+        if (!err) {
+            int elemsize = common_read_type_size (v->type, v->value);
+            result->types[i] = v->type;
+            result->values[i] = malloc ((result->npoints ? result->npoints : 1) * elemsize);
+            if (!result->values[i]) {
+                adios_error (err_no_memory, "%s: cannot allocate memory for %" PRIu64 " values of "
+                        "variable %s\n", __func__, result->npoints, varnames[i]);
+                err = err_no_memory;
+            }
+        }
+        if (!err && result->npoints) {
+            if (known) {
+                memset (have, 0, result->npoints);
+                known (arg, v, result->npoints, result->points, (char *) result->values[i], have);
+            }
+            err = read_values_at_points (f, v, timestep, result->npoints, result->points,
+                                         have, (char *) result->values[i]);
+        }
+        common_read_free_varinfo (v);
+    }
+    free (have);
+    return err;
+}
@@ -0,0 +1,275 @@
+/*
+ * query_cache.c
+ *
+ * Cache of query results per open file, timestep and normalized query tree,
+ * see query_cache.h
+ */
+#include <inttypes.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include "public/adios_query.h"
+#include "core/adios_logger.h"
+#include "query_cache.h"
+
+typedef struct QUERY_CACHE_ENTRY {
+    const ADIOS_FILE *f;
+    char             *key;
+    int               timestep;
+    void             *data;
+    uint64_t          size;
+    struct QUERY_CACHE_ENTRY *prev, *next;
+} QUERY_CACHE_ENTRY;
+
+// entries from the most to the least recently used
+static QUERY_CACHE_ENTRY *cache_head = NULL;
+static QUERY_CACHE_ENTRY *cache_tail = NULL;
+static uint64_t cache_bytes = 0;
+static uint64_t cache_limit = QUERY_CACHE_DEFAULT_BYTES;
+
+static const char * op_string (enum ADIOS_PREDICATE_MODE op)
+{
+    switch (op)
+    {
+        case ADIOS_LT:   return "<";
+        case ADIOS_LTEQ: return "<=";
+        case ADIOS_GT:   return ">";
+        case ADIOS_GTEQ: return ">=";
+        case ADIOS_EQ:   return "==";
+        case ADIOS_NE:   return "!=";
+        default:         return "?";
+    }
+}
+
+/* The value as written, but integers in their plain form (" 10", "+10" and
+   "010" are the same). Other forms are kept, because the methods parse the
+   value according to the type of the variable. */
+static void value_string (const char *value, char *str, size_t len)
+{
+    char *end;
+    long long l;
+
+    while (*value == ' ' || *value == '\t')
+        value++;
+    errno = 0;
+    l = strtoll (value, &end, 10);
+    while (*end == ' ' || *end == '\t')
+        end++;
+    if (!errno && end != value && *end == '\0')
+        snprintf (str, len, "%lld", l);
+    else
+        snprintf (str, len, "%s", value);
+}
+
+/* Selection of a condition; 0 if it cannot be cached */
+static int selection_string (const ADIOS_SELECTION *sel, char *str, size_t len)
+{
+    size_t n;
+    int d;
+
+    if (!sel) {
+        snprintf (str, len, "*");
+        return 1;
+    }
+    switch (sel->type)
+    {
+        case ADIOS_SELECTION_BOUNDINGBOX:
+            n = snprintf (str, len, "bb");
+            for (d = 0; d < sel->u.bb.ndim && n < len; d++)
+                n += snprintf (str + n, len - n, "%c%" PRIu64 ":%" PRIu64, (d ? ',' : '['),
+                               sel->u.bb.start[d], sel->u.bb.count[d]);
+            if (n + 1 >= len)
+                return 0;
+            strcat (str, "]");
+            return 1;
+        case ADIOS_SELECTION_WRITEBLOCK:
+            if (sel->u.block.is_sub_pg_selection)
+                return 0;
+            snprintf (str, len, "wb[%s%d]", (sel->u.block.is_absolute_index ? "a" : ""),
+                      sel->u.block.index);
+            return 1;
+        default:
+            return 0;
+    }
+}
+
+static char * tree_key (ADIOS_QUERY *q)
+{
+    if (!q->left && !q->right)
+    {
+        char sel[1024], value[256];
+        char *key;
+        size_t len;
+        if (!q->varName || !q->predicateValue || !selection_string (q->sel, sel, sizeof(sel)))
+            return NULL;
+        value_string (q->predicateValue, value, sizeof(value));
+        len = strlen (q->varName) + strlen (value) + strlen (sel) + 8;
+        key = (char *) malloc (len);
+        if (key)
+            snprintf (key, len, "%s%s%s@%s", q->varName, op_string (q->predicateOp), value, sel);
+        return key;
+    }
+
+    if (!q->left || !q->right)
+        return tree_key ((ADIOS_QUERY *) (q->left ? q->left : q->right));
+
+    char *l = tree_key ((ADIOS_QUERY *) q->left);
+    char *r = tree_key ((ADIOS_QUERY *) q->right);
+    char *key = NULL;
+    if (l && r) {
+        // the same key for both orders of the sides
+        const char *a = (strcmp (l, r) <= 0 ? l : r);
+        const char *b = (a == l ? r : l);
+        size_t len = strlen (a) + strlen (b) + 6;
+        key = (char *) malloc (len);
+        if (key)
+            snprintf (key, len, "(%s)%s(%s)", a, (q->combineOp == ADIOS_QUERY_OP_AND ? "&" : "|"), b);
+    }
+    free (l);
+    free (r);
+    return key;
+}
+
+char * query_cache_key (ADIOS_QUERY *q, const char *kind)
+{
+    ADIOS_QUERY *leaf = q;
+    char *tree, *key;
+    size_t len;
+
+    if (!cache_limit || !q)
+        return NULL;
+    while (leaf->left || leaf->right)
+        leaf = (ADIOS_QUERY *) (leaf->left ? leaf->left : leaf->right);
+    if (!leaf->file || leaf->file->is_streaming)
+        return NULL;
+
+    tree = tree_key (q);
+    if (!tree)
+        return NULL;
+    len = strlen (kind) + strlen (tree) + 2;
+    key = (char *) malloc (len);
+    if (key)
+        snprintf (key, len, "%s:%s", kind, tree);
+    free (tree);
+    return key;
+}
+
+static void unlink_entry (QUERY_CACHE_ENTRY *e)
+{
+    if (e->prev)
+        e->prev->next = e->next;
+    else
+        cache_head = e->next;
+    if (e->next)
+        e->next->prev = e->prev;
+    else
+        cache_tail = e->prev;
+    e->prev = e->next = NULL;
+}
+
+static void push_front (QUERY_CACHE_ENTRY *e)
+{
+    e->prev = NULL;
+    e->next = cache_head;
+    if (cache_head)
+        cache_head->prev = e;
+    cache_head = e;
+    if (!cache_tail)
+        cache_tail = e;
+}
+
+static void free_entry (QUERY_CACHE_ENTRY *e)
+{
+    unlink_entry (e);
+    cache_bytes -= e->size;
+    free (e->key);
+    free (e->data);
+    free (e);
+}
+
+static QUERY_CACHE_ENTRY * find_entry (const ADIOS_FILE *f, const char *key, int timestep)
+{
+    QUERY_CACHE_ENTRY *e;
+    for (e = cache_head; e; e = e->next) {
+        if (e->f == f && e->timestep == timestep && !strcmp (e->key, key))
+            return e;
+    }
+    return NULL;
+}
+
+int query_cache_has (const ADIOS_FILE *f, const char *key, int timestep, uint64_t size)
+{
+    QUERY_CACHE_ENTRY *e = (key ? find_entry (f, key, timestep) : NULL);
+    return (e && e->size == size);
+}
+
+int query_cache_get (const ADIOS_FILE *f, const char *key, int timestep, void *data, uint64_t size)
+{
+    QUERY_CACHE_ENTRY *e;
+    if (!key)
+        return 0;
+    e = find_entry (f, key, timestep);
+    if (!e || e->size != size)
+        return 0;
+    memcpy (data, e->data, size);
+    unlink_entry (e);
+    push_front (e);
+    log_debug ("%s: found %s at step %d\n", __func__, key, timestep);
+    return 1;
+}
+
+void query_cache_put (const ADIOS_FILE *f, const char *key, int timestep, const void *data, uint64_t size)
+{
+    QUERY_CACHE_ENTRY *e;
+    if (!key || !size || size > cache_limit)
+        return;
+
+    e = find_entry (f, key, timestep);
+    if (e)
+        free_entry (e);
+    while (cache_tail && cache_bytes + size > cache_limit)
+        free_entry (cache_tail);
+
+    e = (QUERY_CACHE_ENTRY *) calloc (1, sizeof(QUERY_CACHE_ENTRY));
+    if (!e)
+        return;
+    e->key = strdup (key);
+    e->data = malloc (size);
+    if (!e->key || !e->data) {
+        free (e->key);
+        free (e->data);
+        free (e);
+        return;
+    }
+    memcpy (e->data, data, size);
+    e->f = f;
+    e->timestep = timestep;
+    e->size = size;
+    push_front (e);
+    cache_bytes += size;
+}
+
+void query_cache_drop_file (const ADIOS_FILE *f)
+{
+    QUERY_CACHE_ENTRY *e = cache_head;
+    while (e) {
+        QUERY_CACHE_ENTRY *next = e->next;
+        if (e->f == f)
+            free_entry (e);
+        e = next;
+    }
+}
+
+void query_cache_set_size (uint64_t bytes)
+{
+    cache_limit = bytes;
+    while (cache_tail && cache_bytes > cache_limit)
+        free_entry (cache_tail);
+}
+
+void query_cache_clear (void)
+{
+    while (cache_head)
+        free_entry (cache_head);
+}
@@ -0,0 +1,55 @@
+#ifndef __QUERY_CACHE_H__
+#define __QUERY_CACHE_H__
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdint.h>
+#include "public/adios_query.h"
+
+/*
+ * Cache of query results, shared by the query methods.
+ *
+ * An entry holds the result of a query (sub)tree at one timestep of an open
+ * file, as a method-specific buffer (e.g. the hit bitmap of the scan method,
+ * the block flags of the minmax method). Entries are keyed by a normalized
+ * form of the tree: conditions are written with the variable name, operator,
+ * parsed value and selection, and the two sides of AND/OR are ordered, so
+ * the same query built again, or with its sides swapped, finds the entry.
+ *
+ * The cache holds at most adios_query_set_cache_size() bytes, least recently
+ * used entries are dropped first. Entries of a file are dropped when the file
+ * is closed. Streams are not cached.
+ */
+
+#define QUERY_CACHE_DEFAULT_BYTES (64*1024*1024)
+
+/* Key of query tree 'q' for results of kind 'kind' (e.g. "points").
+   Returns a newly allocated string, NULL if the query cannot be cached. */
+char * query_cache_key (ADIOS_QUERY *q, const char *kind);
+
+/* Copy the cached result of 'key' at 'timestep' of file 'f' into 'data', if
+   there is one of exactly 'size' bytes. Returns 1 if found, 0 otherwise. */
+int query_cache_get (const ADIOS_FILE *f, const char *key, int timestep, void *data, uint64_t size);
+
+/* Check if there is a cached result of 'key' at 'timestep' of 'size' bytes */
+int query_cache_has (const ADIOS_FILE *f, const char *key, int timestep, uint64_t size);
+
+/* Store a copy of a result in the cache (replacing an existing one) */
+void query_cache_put (const ADIOS_FILE *f, const char *key, int timestep, const void *data, uint64_t size);
+
+/* Drop the entries of a file */
+void query_cache_drop_file (const ADIOS_FILE *f);
+
+/* Set the memory limit of the cache, 0 disables caching */
+void query_cache_set_size (uint64_t bytes);
+
+/* Drop all entries */
+void query_cache_clear (void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __QUERY_CACHE_H__ */
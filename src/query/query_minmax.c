@@ -16,8 +16,10 @@
 #include "public/adios_selection.h"
 #include "core/common_read.h"
 #include "core/adios_logger.h"
+#include "core/adios_zone_map.h"
 #include "common_query.h"
 #include "query_utils.h"
+#include "query_cache.h"
 #include "config.h"  // HAVE_STRTOLD
 
 
@@ -235,6 +237,112 @@ static void * string_to_value (char *v_str, enum ADIOS_DATATYPES vartype)
     return retval;
 }
 
+/* Check if some value in [min,max] may satisfy the predicate */
+static int minmax_may_match (void *pred_val, enum ADIOS_PREDICATE_MODE op,
+                             void *min, void *max, enum ADIOS_DATATYPES vartype)
+{
+    switch (op)
+    {
+        case ADIOS_LT:
+            return compare_values (pred_val, ADIOS_GT, min, vartype);
+        case ADIOS_LTEQ:
+            return compare_values (pred_val, ADIOS_GTEQ, min, vartype);
+        case ADIOS_GT:
+            return compare_values (pred_val, ADIOS_LT, max, vartype);
+        case ADIOS_GTEQ:
+            return compare_values (pred_val, ADIOS_LTEQ, max, vartype);
+        case ADIOS_EQ:
+            // we MAY have a match in block if the predicate value falls inside of the min..max range
+            return compare_values (pred_val, ADIOS_GTEQ, min, vartype) &&
+                   compare_values (pred_val, ADIOS_LTEQ, max, vartype);
+        case ADIOS_NE:
+            // we only know for sure that the block is not a match if all elements
+            // are the same (min=max) and the predicate value is that same value
+            return !(compare_values (pred_val, ADIOS_EQ, min, vartype) &&
+                     compare_values (pred_val, ADIOS_EQ, max, vartype));
+    }
+    return 1;
+}
+
+/*
+ * Check the matching blocks (in [loop_start, loop_end) of the timestep) zone by
+ * zone if the variable has zone maps. A block whose zones in the query's
+ * selection cannot match is not a match.
+ * Return the number of blocks taken out.
+ */
+static int minmax_prune_by_zones (ADIOS_QUERY* q, int timestep, int loop_start, int loop_end,
+                                  char * blocks, void * pred_val)
+{
+    ADIOS_VARINFO *v = q->varinfo;
+    ADIOS_VARINFO *zv = query_utils_inq_companion_var (q->file, ADIOS_ZONE_MAP_PATH,
+                                                       q->varName, v, timestep);
+    int i, npruned = 0, nscheduled = 0;
+    if (!zv)
+        return 0;
+
+    int block_start_idx = 0;
+    for (i = 0; i < timestep; i++)
+        block_start_idx += v->nblocks[i];
+
+    char **maps = (char **) calloc (loop_end - loop_start, sizeof(char *));
+    uint64_t *sizes = (uint64_t *) calloc (loop_end - loop_start, sizeof(uint64_t));
+    if (!maps || !sizes) {
+        free (maps);
+        free (sizes);
+        common_read_free_varinfo (zv);
+        return 0;
+    }
+
+    for (i = loop_start; i < loop_end; i++) {
+        if (blocks[i]) {
+            maps[i-loop_start] = query_utils_schedule_companion_block (q->file, zv, timestep, i,
+                                                                       &sizes[i-loop_start]);
+            if (maps[i-loop_start])
+                nscheduled++;
+        }
+    }
+    if (nscheduled && common_read_perform_reads (q->file, 1) != 0)
+        nscheduled = 0; // zone maps cannot be used, keep the blocks
+
+    for (i = loop_start; i < loop_end && nscheduled; i++)
+    {
+        ADIOS_ZONE_MAP_BLOCK zm;
+        ADIOS_VARBLOCK *bi = &v->blockinfo[i+block_start_idx];
+        int d = adios_zone_map_slab_dim (v->ndim, bi->count);
+        uint64_t z;
+        int match = 0;
+
+        if (!maps[i-loop_start] || d < 0 ||
+            adios_zone_map_parse (maps[i-loop_start], sizes[i-loop_start], &zm) ||
+            zm.type != v->type || zm.nslabs != bi->count[d])
+            continue;
+
+        for (z = 0; z < zm.nzones && !match; z++)
+        {
+            uint64_t first, n;
+            const void *min, *max;
+            adios_zone_map_zone (&zm, z, &first, &n, &min, &max);
+            if (q->sel && q->sel->type == ADIOS_SELECTION_BOUNDINGBOX && v->global &&
+                (q->sel->u.bb.start[d] + q->sel->u.bb.count[d] <= bi->start[d] + first ||
+                 bi->start[d] + first + n <= q->sel->u.bb.start[d]))
+                continue; // zone is outside of the selection
+            match = minmax_may_match (pred_val, q->predicateOp, (void *) min, (void *) max, v->type);
+        }
+        if (!match) {
+            blocks[i] = 0;
+            npruned++;
+        }
+    }
+
+    for (i = 0; i < loop_end - loop_start; i++)
+        free (maps[i]);
+    free (maps);
+    free (sizes);
+    common_read_free_varinfo (zv);
+    log_debug ("%s: %s: %d blocks taken out by their zone maps\n", __func__, q->condition, npruned);
+    return npruned;
+}
+
 /*
  * evaluate a single query item (Variable PredicateOP Value) 
  * In: blocks array flag has 1s which writeblocks have to be checked
@@ -318,40 +426,10 @@ static int minmax_evaluate_node (ADIOS_QUERY* q, int timestep, int nblocks, char
         if (blocks[i])  // block is still in boundary
         {
             // check the formula finally
-            switch (q->predicateOp) 
-            {
-                case ADIOS_LT: 
-                    //blocks[i] = (v > q->varinfo->statistics->blocks->mins[i+block_start_idx]);
-                    blocks[i] = compare_values (pred_val, ADIOS_GT, q->varinfo->statistics->blocks->mins[i+block_start_idx], q->varinfo->type);
-                    break;
-                case ADIOS_LTEQ:
-                    //blocks[i] = (v >= q->varinfo->statistics->blocks->mins[i+block_start_idx]);
-                    blocks[i] = compare_values (pred_val, ADIOS_GTEQ, q->varinfo->statistics->blocks->mins[i+block_start_idx], q->varinfo->type);
-                    break;
-                case ADIOS_GT:
-                    //blocks[i] = (v < q->varinfo->statistics->blocks->maxs[i+block_start_idx]);
-                    blocks[i] = compare_values (pred_val, ADIOS_LT, q->varinfo->statistics->blocks->maxs[i+block_start_idx], q->varinfo->type);
-                    break;
-                case ADIOS_GTEQ:
-                    //blocks[i] = (v <= q->varinfo->statistics->blocks->maxs[i+block_start_idx]);
-                    blocks[i] = compare_values (pred_val, ADIOS_LTEQ, q->varinfo->statistics->blocks->maxs[i+block_start_idx], q->varinfo->type);
-                    break;
-                case ADIOS_EQ:
-                    // we MAY have a match in block if the predicate value falls inside of the min..max range
-                    //blocks[i] = (v >= q->varinfo->statistics->blocks->mins[i+block_start_idx] &&
-                    //             v <= q->varinfo->statistics->blocks->maxs[i+block_start_idx]); 
-                    blocks[i] = compare_values (pred_val, ADIOS_GTEQ, q->varinfo->statistics->blocks->mins[i+block_start_idx], q->varinfo->type);
-                    blocks[i] = compare_values (pred_val, ADIOS_LTEQ, q->varinfo->statistics->blocks->maxs[i+block_start_idx], q->varinfo->type);
-                    break;
-                case ADIOS_NE:
-                    // we only know for sure that the block is not a match if all elements
-                    // are the same (min=max) and the predicate value is that same value
-                    //blocks[i] = !(v == q->varinfo->statistics->blocks->mins[i+block_start_idx] &&
-                    //              v == q->varinfo->statistics->blocks->maxs[i+block_start_idx]); 
-                    blocks[i] = !(compare_values (pred_val, ADIOS_EQ, q->varinfo->statistics->blocks->mins[i+block_start_idx], q->varinfo->type) &&
-                                  compare_values (pred_val, ADIOS_EQ, q->varinfo->statistics->blocks->maxs[i+block_start_idx], q->varinfo->type));
-                    break;
-            }
+            blocks[i] = minmax_may_match (pred_val, q->predicateOp,
+                                          q->varinfo->statistics->blocks->mins[i+block_start_idx],
+                                          q->varinfo->statistics->blocks->maxs[i+block_start_idx],
+                                          q->varinfo->type);
         }
 
         if (blocks[i])  // block is still matching after evaluation
@@ -361,6 +439,10 @@ static int minmax_evaluate_node (ADIOS_QUERY* q, int timestep, int nblocks, char
     }
 
 
+    // blocks with zone maps match only if any of their zones may match
+    if (nmatches > 0)
+        nmatches -= minmax_prune_by_zones (q, timestep, loop_start, loop_end, blocks, pred_val);
+
     // update selection going out and up the tree
     *sel = q->sel;
     return nmatches;
@@ -605,8 +687,22 @@ static int do_evaluate_now (ADIOS_QUERY *q, int timestep)
     q->resultsReadSoFar = 0;
     INTERNAL(q)->is_outputBoundary_set = 0;
 
-    // evaluate query for ALL blocks, fill q->queryInternal->blocks bool array 
-    q->maxResultsDesired =  minmax_process(q, timestep, false);
+    // the block flags may be cached from an earlier evaluation of the same query
+    char *key = query_cache_key (q, "blocks");
+    ADIOS_QUERY *leaf = q;
+    while (leaf->left || leaf->right)
+        leaf = (ADIOS_QUERY *) (leaf->left ? leaf->left : leaf->right);
+    if (key && query_cache_get (leaf->file, key, timestep, INTERNAL(q)->blocks, nblocks)) {
+        int i;
+        q->maxResultsDesired = 0;
+        for (i = 0; i < nblocks; i++)
+            q->maxResultsDesired += (INTERNAL(q)->blocks[i] != 0);
+    } else {
+        // evaluate query for ALL blocks, fill q->queryInternal->blocks bool array 
+        q->maxResultsDesired =  minmax_process(q, timestep, false);
+        query_cache_put (leaf->file, key, timestep, INTERNAL(q)->blocks, nblocks);
+    }
+    free (key);
     return q->maxResultsDesired;
 } 
 
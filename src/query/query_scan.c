@@ -0,0 +1,1957 @@
+/*
+ * query_scan.c
+ *
+ * Exact, point-level query evaluation that needs no index.
+ * Writeblocks are first classified with their min/max statistics (like the
+ * minmax method does). Blocks that cannot match are skipped, blocks that match
+ * entirely are marked without reading them, and only the rest is read and
+ * compared element by element. Each query leaf produces a bitmap over its
+ * selection box, and the bitmaps are combined with AND/OR word by word.
+ *
+ * Blocks of variables written with a zone map (see core/adios_zone_map.h) are
+ * classified the same way zone by zone, and only the zones that may match are
+ * read, consecutive ones together.
+ *
+ * The BITMAP method evaluates the same way, but looks up the blocks that the
+ * statistics cannot decide in the bitmap index built at write time (see
+ * core/adios_bitmap_index.h). Bins entirely inside or outside of the condition
+ * are answered by the index alone, the data of a block is read only if some of
+ * its elements in the selection fall into a bin that the condition cuts.
+ *
+ * The SORTED method evaluates each condition with the sorted secondary index
+ * built by the adios_index_sorted utility (see query_sorted.h) instead: the
+ * positions of the values in the condition's range are read from the index,
+ * the data is not read at all.
+ *
+ * Reading is done by the calling thread. Comparing the data read and decoding
+ * index blocks is spread over the query threads (see adios_query_set_threads),
+ * each of them working on its own bitmap that is merged afterwards.
+ *
+ * adios_query_read_where() evaluates the same way, but keeps the data read
+ * for the conditions on the requested variables, and returns the values of
+ * the hits from that data. Only the values not read in the evaluation (e.g.
+ * in blocks matched by their statistics) are read afterwards.
+ */
+#include <inttypes.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+#include <math.h>
+#include "public/adios_error.h"
+#include "public/adios_query.h"
+#include "public/adios_selection.h"
+#include "core/common_read.h"
+#include "core/adios_logger.h"
+#include "core/a2sel.h"
+#include "core/futils.h"
+#include "core/adios_bitmap_index.h"
+#include "core/adios_zone_map.h"
+#include "common_query.h"
+#include "adios_query_hooks.h"
+#include "query_utils.h"
+#include "query_cache.h"
+#include "query_sorted.h"
+
+#define SCAN_MAX_DIMS 32
+
+/* Upper limit of data read in one go while scanning one query leaf.
+   A single block larger than this is still read at once. */
+#define SCAN_READ_BYTES (64*1024*1024)
+
+/* Upper limit of data kept from the evaluation to return values of the hits */
+#define SCAN_KEEP_BYTES (256*1024*1024)
+
+/* Elements compared by one task when the query runs on several threads
+   (a multiple of 64) */
+#define SCAN_CHUNK_ELEMENTS (1024*1024)
+
+/* The index used to evaluate the conditions (the use_index arguments) */
+#define SCAN_INDEX_NONE   0   // SCAN method
+#define SCAN_INDEX_BITMAP 1   // BITMAP method
+#define SCAN_INDEX_SORTED 2   // SORTED method
+
+/* A box in C order (slowest dimension first) */
+typedef struct {
+    int      ndim;
+    uint64_t start[SCAN_MAX_DIMS];
+    uint64_t count[SCAN_MAX_DIMS];
+} SCAN_BOX;
+
+/* A part of a variable read in the evaluation */
+typedef struct {
+    int       varid;
+    SCAN_BOX  isect;
+    char     *data;
+} SCAN_KEPT;
+
+/* The data read in the evaluation that is kept for read_where */
+typedef struct {
+    int          nvars;      // keep the reads of these variables (during the evaluation)
+    const char **varnames;
+    SCAN_KEPT   *kept;
+    int          nkept;
+    int          maxkept;
+    uint64_t     bytes;
+} SCAN_KEEP;
+
+typedef struct {
+    uint64_t  nelements;     // number of elements in the evaluated box
+    uint64_t *bits;          // one bit per element of the box, 1 = hit
+    SCAN_BOX  box;           // box of the first condition, the default output box
+    uint64_t  next_element;  // continue from here in consecutive evaluate calls
+    SCAN_KEEP keep;          // data kept for read_where
+} SCAN_INTERNAL;
+
+#define INTERNAL(q) ((SCAN_INTERNAL*) (q->queryInternal))
+
+static void free_keep (SCAN_KEEP *keep)
+{
+    int i;
+    for (i = 0; i < keep->nkept; i++)
+        free (keep->kept[i].data);
+    free (keep->kept);
+    memset (keep, 0, sizeof(SCAN_KEEP));
+}
+
+static void free_internal (ADIOS_QUERY *q)
+{
+    if (q->queryInternal != NULL) {
+        SCAN_INTERNAL* qi = INTERNAL(q);
+        free_keep (&qi->keep);
+        free (qi->bits);
+        free (qi);
+        q->queryInternal = NULL;
+    }
+}
+
+static uint64_t box_nelements (const SCAN_BOX *box)
+{
+    uint64_t n = 1;
+    int d;
+    for (d = 0; d < box->ndim; d++)
+        n *= box->count[d];
+    return n;
+}
+
+/* Fill a C order box from caller order start/count arrays */
+static void box_set (SCAN_BOX *box, int ndim, const uint64_t *start, const uint64_t *count)
+{
+    const int Corder = !futils_is_called_from_fortran();
+    int d;
+    box->ndim = ndim;
+    for (d = 0; d < ndim; d++) {
+        int src = (Corder ? d : ndim-1-d);
+        box->start[d] = (start ? start[src] : 0);
+        box->count[d] = count[src];
+    }
+}
+
+/* Create a bounding box selection in caller order from a C order box */
+static ADIOS_SELECTION * box_to_selection (const SCAN_BOX *box)
+{
+    const int Corder = !futils_is_called_from_fortran();
+    uint64_t start[SCAN_MAX_DIMS], count[SCAN_MAX_DIMS];
+    int d;
+    for (d = 0; d < box->ndim; d++) {
+        int dst = (Corder ? d : box->ndim-1-d);
+        start[dst] = box->start[d];
+        count[dst] = box->count[d];
+    }
+    return a2sel_boundingbox (box->ndim, start, count);
+}
+
+/* Intersect two boxes, return 0 if they do not overlap */
+static int box_intersect (const SCAN_BOX *a, const SCAN_BOX *b, SCAN_BOX *isect)
+{
+    int d;
+    isect->ndim = a->ndim;
+    for (d = 0; d < a->ndim; d++) {
+        uint64_t s = (a->start[d] > b->start[d] ? a->start[d] : b->start[d]);
+        uint64_t ea = a->start[d] + a->count[d];
+        uint64_t eb = b->start[d] + b->count[d];
+        uint64_t e = (ea < eb ? ea : eb);
+        if (e <= s)
+            return 0;
+        isect->start[d] = s;
+        isect->count[d] = e - s;
+    }
+    return 1;
+}
+
+/* Take over 'data' read for 'isect' of leaf 'q' if read_where asked for the
+   variable and the limit allows it. Returns 1 if kept, 0 if not. */
+static int keep_data (SCAN_KEEP *keep, ADIOS_QUERY *q, const SCAN_BOX *isect, char *data, uint64_t nbytes)
+{
+    const char *name = (q->varName[0] == '/' ? q->varName + 1 : q->varName);
+    int i;
+
+    if (!keep || !data || keep->bytes + nbytes > SCAN_KEEP_BYTES)
+        return 0;
+    for (i = 0; i < keep->nvars; i++) {
+        const char *v = (keep->varnames[i][0] == '/' ? keep->varnames[i] + 1 : keep->varnames[i]);
+        if (!strcmp (v, name))
+            break;
+    }
+    if (i == keep->nvars)
+        return 0;
+    // another condition on the same variable may have read it already
+    for (i = 0; i < keep->nkept; i++) {
+        const SCAN_BOX *k = &keep->kept[i].isect;
+        int d;
+        if (keep->kept[i].varid != q->varinfo->varid || k->ndim != isect->ndim)
+            continue;
+        for (d = 0; d < k->ndim; d++) {
+            if (isect->start[d] < k->start[d] ||
+                isect->start[d] + isect->count[d] > k->start[d] + k->count[d])
+                break;
+        }
+        if (d == k->ndim)
+            return 0;
+    }
+
+    if (keep->nkept == keep->maxkept) {
+        int n = (keep->maxkept ? 2 * keep->maxkept : 16);
+        SCAN_KEPT *k = (SCAN_KEPT *) realloc (keep->kept, n * sizeof(SCAN_KEPT));
+        if (!k)
+            return 0;
+        keep->kept = k;
+        keep->maxkept = n;
+    }
+    keep->kept[keep->nkept].varid = q->varinfo->varid;
+    keep->kept[keep->nkept].isect = *isect;
+    keep->kept[keep->nkept].data = data;
+    keep->nkept++;
+    keep->bytes += nbytes;
+    return 1;
+}
+
+
+/*
+ * Predicate values and min/max statistics are compared in a common domain:
+ * signed integers and unsigned integers up to 32 bits in int64_t,
+ * 64-bit unsigned integers in uint64_t and floating point values in double.
+ */
+enum SCAN_DOMAIN { SCAN_DOMAIN_INT, SCAN_DOMAIN_UINT, SCAN_DOMAIN_REAL };
+
+typedef struct {
+    enum ADIOS_DATATYPES      type;
+    enum SCAN_DOMAIN          domain;
+    enum ADIOS_PREDICATE_MODE op;
+    int64_t  v_int;
+    uint64_t v_uint;
+    double   v_real;
+} SCAN_PREDICATE;
+
+static int is_supported_type (enum ADIOS_DATATYPES type)
+{
+    switch (type)
+    {
+        case adios_byte:
+        case adios_unsigned_byte:
+        case adios_short:
+        case adios_unsigned_short:
+        case adios_integer:
+        case adios_unsigned_integer:
+        case adios_long:
+        case adios_unsigned_long:
+        case adios_real:
+        case adios_double:
+            return 1;
+        default:
+            return 0;
+    }
+}
+
+static void predicate_init (SCAN_PREDICATE *p, ADIOS_QUERY *q)
+{
+    p->type = q->varinfo->type;
+    p->op = q->predicateOp;
+    switch (p->type)
+    {
+        case adios_unsigned_long:
+            p->domain = SCAN_DOMAIN_UINT;
+            p->v_uint = strtoull (q->predicateValue, NULL, 10);
+            break;
+        case adios_real:
+        case adios_double:
+            p->domain = SCAN_DOMAIN_REAL;
+            p->v_real = strtod (q->predicateValue, NULL);
+            break;
+        default:
+            p->domain = SCAN_DOMAIN_INT;
+            p->v_int = strtoll (q->predicateValue, NULL, 10);
+            break;
+    }
+}
+
+/* Compare a statistics value (of the variable's type) to the predicate value:
+   return <0, 0, >0 if the value is less, equal or greater */
+static int predicate_cmp (const SCAN_PREDICATE *p, const void *value)
+{
+    int64_t i = 0;
+    switch (p->type)
+    {
+        case adios_byte:             i = *(const int8_t *) value; break;
+        case adios_unsigned_byte:    i = *(const uint8_t *) value; break;
+        case adios_short:            i = *(const int16_t *) value; break;
+        case adios_unsigned_short:   i = *(const uint16_t *) value; break;
+        case adios_integer:          i = *(const int32_t *) value; break;
+        case adios_unsigned_integer: i = *(const uint32_t *) value; break;
+        case adios_long:             i = *(const int64_t *) value; break;
+        case adios_unsigned_long:
+        {
+            uint64_t u = *(const uint64_t *) value;
+            return (u < p->v_uint ? -1 : (u > p->v_uint ? 1 : 0));
+        }
+        case adios_real:
+        case adios_double:
+        {
+            double r = (p->type == adios_real ? *(const float *) value : *(const double *) value);
+            return (r < p->v_real ? -1 : (r > p->v_real ? 1 : 0));
+        }
+        default:
+            return 0;
+    }
+    return (i < p->v_int ? -1 : (i > p->v_int ? 1 : 0));
+}
+
+enum SCAN_BLOCK_MATCH { SCAN_BLOCK_NONE, SCAN_BLOCK_SOME, SCAN_BLOCK_ALL };
+
+/* Decide from a block's min/max if none, some or all of its elements match.
+   The statistics skip NaN and infinite values, so a floating point block is never
+   declared a full match (a NaN in it would not match) */
+static enum SCAN_BLOCK_MATCH classify_block (const SCAN_PREDICATE *p, const void *min, const void *max)
+{
+    if (!min || !max)
+        return SCAN_BLOCK_SOME;
+
+    int cmin = predicate_cmp (p, min);
+    int cmax = predicate_cmp (p, max);
+    enum SCAN_BLOCK_MATCH m = SCAN_BLOCK_SOME;
+
+    switch (p->op)
+    {
+        case ADIOS_LT:
+            if (cmax < 0) m = SCAN_BLOCK_ALL;
+            else if (cmin >= 0) m = SCAN_BLOCK_NONE;
+            break;
+        case ADIOS_LTEQ:
+            if (cmax <= 0) m = SCAN_BLOCK_ALL;
+            else if (cmin > 0) m = SCAN_BLOCK_NONE;
+            break;
+        case ADIOS_GT:
+            if (cmin > 0) m = SCAN_BLOCK_ALL;
+            else if (cmax <= 0) m = SCAN_BLOCK_NONE;
+            break;
+        case ADIOS_GTEQ:
+            if (cmin >= 0) m = SCAN_BLOCK_ALL;
+            else if (cmax < 0) m = SCAN_BLOCK_NONE;
+            break;
+        case ADIOS_EQ:
+            if (cmin == 0 && cmax == 0) m = SCAN_BLOCK_ALL;
+            else if (cmin > 0 || cmax < 0) m = SCAN_BLOCK_NONE;
+            break;
+        case ADIOS_NE:
+            if (cmin > 0 || cmax < 0) m = SCAN_BLOCK_ALL;
+            else if (cmin == 0 && cmax == 0) m = SCAN_BLOCK_NONE;
+            break;
+    }
+    if (m == SCAN_BLOCK_ALL && p->domain == SCAN_DOMAIN_REAL)
+        m = SCAN_BLOCK_SOME;
+    return m;
+}
+
+/* Integers below this magnitude convert to double exactly */
+#define SCAN_EXACT_INT ((int64_t)1 << 53)
+
+/* Decide for the elements of a bitmap index bin, whose values are in [lo,hi)
+   or are NaN, if none, some or all of them match.
+   Values are binned as doubles. Since the conversion to double is monotonic,
+   the bounds decide exactly as long as the predicate value is a finite double,
+   or an integer converting to double exactly */
+static enum SCAN_BLOCK_MATCH classify_bin (const SCAN_PREDICATE *p, double lo, double hi, int nanbin)
+{
+    double x;
+    switch (p->domain)
+    {
+        case SCAN_DOMAIN_REAL:
+            x = p->v_real;
+            if (!isfinite (x))
+                return SCAN_BLOCK_SOME;
+            break;
+        case SCAN_DOMAIN_UINT:
+            if (p->v_uint >= (uint64_t) SCAN_EXACT_INT)
+                return SCAN_BLOCK_SOME;
+            x = (double) p->v_uint;
+            break;
+        default:
+            if (p->v_int <= -SCAN_EXACT_INT || p->v_int >= SCAN_EXACT_INT)
+                return SCAN_BLOCK_SOME;
+            x = (double) p->v_int;
+            break;
+    }
+
+    if (nanbin)
+        return (p->op == ADIOS_NE ? SCAN_BLOCK_ALL : SCAN_BLOCK_NONE);
+
+    switch (p->op)
+    {
+        case ADIOS_LT:
+            if (hi <= x) return SCAN_BLOCK_ALL;
+            if (lo >= x) return SCAN_BLOCK_NONE;
+            break;
+        case ADIOS_LTEQ:
+            if (hi <= x) return SCAN_BLOCK_ALL;
+            if (lo > x)  return SCAN_BLOCK_NONE;
+            break;
+        case ADIOS_GT:
+            if (lo > x)  return SCAN_BLOCK_ALL;
+            if (hi <= x) return SCAN_BLOCK_NONE;
+            break;
+        case ADIOS_GTEQ:
+            if (lo >= x) return SCAN_BLOCK_ALL;
+            if (hi <= x) return SCAN_BLOCK_NONE;
+            break;
+        case ADIOS_EQ:
+            if (x < lo || x >= hi) return SCAN_BLOCK_NONE;
+            break;
+        case ADIOS_NE:
+            if (x < lo || x >= hi) return SCAN_BLOCK_ALL;
+            break;
+    }
+    return SCAN_BLOCK_SOME;
+}
+
+
+/*
+ * Bitmap helpers
+ */
+
+/* OR 'w' into the bitmap at bit position 'pos' */
+static inline void bits_put (uint64_t *bits, uint64_t pos, uint64_t w)
+{
+    uint64_t k = pos >> 6;
+    int s = (int) (pos & 63);
+    bits[k] |= w << s;
+    if (s && (w >> (64 - s)))
+        bits[k+1] |= w >> (64 - s);
+}
+
+static void bits_set_range (uint64_t *bits, uint64_t pos, uint64_t n)
+{
+    while (n >= 64) {
+        bits_put (bits, pos, ~(uint64_t)0);
+        pos += 64;
+        n -= 64;
+    }
+    if (n)
+        bits_put (bits, pos, ((uint64_t)1 << n) - 1);
+}
+
+static uint64_t bits_count (const uint64_t *bits, uint64_t nwords)
+{
+    uint64_t i, n = 0;
+    for (i = 0; i < nwords; i++)
+        n += __builtin_popcountll (bits[i]);
+    return n;
+}
+
+/* Get 'n' (1..64) bits of the bitmap from bit position 'pos' */
+static inline uint64_t bits_get (const uint64_t *bits, uint64_t pos, int n)
+{
+    uint64_t k = pos >> 6;
+    int s = (int) (pos & 63);
+    uint64_t w = bits[k] >> s;
+    if (s && s + n > 64)
+        w |= bits[k+1] << (64 - s);
+    return (n < 64 ? w & (((uint64_t)1 << n) - 1) : w);
+}
+
+/* OR 'n' bits from position 'spos' of 'src' into 'dst' at position 'dpos' */
+static void bits_copy (uint64_t *dst, uint64_t dpos, const uint64_t *src, uint64_t spos, uint64_t n)
+{
+    while (n > 0) {
+        int m = (n < 64 ? (int) n : 64);
+        uint64_t w = bits_get (src, spos, m);
+        if (w)
+            bits_put (dst, dpos, w);
+        dpos += m;
+        spos += m;
+        n -= m;
+    }
+}
+
+
+/*
+ * Compare kernels: evaluate the predicate on 'n' contiguous elements and OR the
+ * result bits into 'bits' starting at bit position 'pos'.
+ * The comparison of a chunk goes into a byte mask first, the loop of which the
+ * compiler turns into vector compares, then the mask is packed into one word.
+ */
+#define SCAN_KERNEL(NAME, T, W)                                                     \
+static void scan_compare_##NAME (const T *data, uint64_t n,                         \
+        enum ADIOS_PREDICATE_MODE op, W v, uint64_t *bits, uint64_t pos)            \
+{                                                                                   \
+    uint8_t mask[64];                                                               \
+    uint64_t i;                                                                     \
+    for (i = 0; i < n; i += 64) {                                                   \
+        const T *d = data + i;                                                      \
+        int m = (n - i < 64 ? (int) (n - i) : 64);                                  \
+        int j;                                                                      \
+        uint64_t w = 0;                                                             \
+        switch (op) {                                                               \
+            case ADIOS_LT:   for (j = 0; j < m; j++) mask[j] = ((W) d[j] <  v); break; \
+            case ADIOS_LTEQ: for (j = 0; j < m; j++) mask[j] = ((W) d[j] <= v); break; \
+            case ADIOS_GT:   for (j = 0; j < m; j++) mask[j] = ((W) d[j] >  v); break; \
+            case ADIOS_GTEQ: for (j = 0; j < m; j++) mask[j] = ((W) d[j] >= v); break; \
+            case ADIOS_EQ:   for (j = 0; j < m; j++) mask[j] = ((W) d[j] == v); break; \
+            case ADIOS_NE:   for (j = 0; j < m; j++) mask[j] = ((W) d[j] != v); break; \
+            default:         for (j = 0; j < m; j++) mask[j] = 0; break;            \
+        }                                                                           \
+        for (j = 0; j < m; j++)                                                     \
+            w |= (uint64_t) mask[j] << j;                                           \
+        if (w)                                                                      \
+            bits_put (bits, pos + i, w);                                            \
+    }                                                                               \
+}
+
+SCAN_KERNEL(byte,    int8_t,   int64_t)
+SCAN_KERNEL(ubyte,   uint8_t,  int64_t)
+SCAN_KERNEL(short,   int16_t,  int64_t)
+SCAN_KERNEL(ushort,  uint16_t, int64_t)
+SCAN_KERNEL(int,     int32_t,  int64_t)
+SCAN_KERNEL(uint,    uint32_t, int64_t)
+SCAN_KERNEL(long,    int64_t,  int64_t)
+SCAN_KERNEL(ulong,   uint64_t, uint64_t)
+SCAN_KERNEL(float,   float,    double)
+SCAN_KERNEL(double,  double,   double)
+
+#undef SCAN_KERNEL
+
+static void scan_compare (const SCAN_PREDICATE *p, const void *data, uint64_t n,
+                          uint64_t *bits, uint64_t pos)
+{
+    switch (p->type)
+    {
+        case adios_byte:             scan_compare_byte   (data, n, p->op, p->v_int,  bits, pos); break;
+        case adios_unsigned_byte:    scan_compare_ubyte  (data, n, p->op, p->v_int,  bits, pos); break;
+        case adios_short:            scan_compare_short  (data, n, p->op, p->v_int,  bits, pos); break;
+        case adios_unsigned_short:   scan_compare_ushort (data, n, p->op, p->v_int,  bits, pos); break;
+        case adios_integer:          scan_compare_int    (data, n, p->op, p->v_int,  bits, pos); break;
+        case adios_unsigned_integer: scan_compare_uint   (data, n, p->op, p->v_int,  bits, pos); break;
+        case adios_long:             scan_compare_long   (data, n, p->op, p->v_int,  bits, pos); break;
+        case adios_unsigned_long:    scan_compare_ulong  (data, n, p->op, p->v_uint, bits, pos); break;
+        case adios_real:             scan_compare_float  (data, n, p->op, p->v_real, bits, pos); break;
+        case adios_double:           scan_compare_double (data, n, p->op, p->v_real, bits, pos); break;
+        default: break;
+    }
+}
+
+typedef void (*SUBBOX_RUN_FN) (void *ctx, uint64_t boxpos, uint64_t isectpos, uint64_t runlen);
+
+/*
+ * Walk the contiguous runs of sub-box 'isect' inside 'box' (both in C order) and
+ * call 'fn' with the position of each run in 'box' and in 'isect', where the
+ * elements of 'isect' are numbered contiguously.
+ */
+static void walk_subbox (const SCAN_BOX *box, const SCAN_BOX *isect, SUBBOX_RUN_FN fn, void *ctx)
+{
+    int ndim = box->ndim;
+    int d;
+    uint64_t stride[SCAN_MAX_DIMS];   // element strides in 'box'
+    uint64_t idx[SCAN_MAX_DIMS];      // position of the current run in 'isect'
+
+    if (ndim == 0)
+        return;
+
+    // merge the fastest dimensions where isect spans the whole box into one run
+    int rundim = ndim - 1;
+    uint64_t runlen = isect->count[ndim-1];
+    while (rundim > 0 && isect->count[rundim] == box->count[rundim]) {
+        rundim--;
+        runlen *= isect->count[rundim];
+    }
+
+    stride[ndim-1] = 1;
+    for (d = ndim-2; d >= 0; d--)
+        stride[d] = stride[d+1] * box->count[d+1];
+
+    uint64_t nruns = 1;
+    for (d = 0; d < rundim; d++) {
+        nruns *= isect->count[d];
+        idx[d] = 0;
+    }
+
+    uint64_t r;
+    for (r = 0; r < nruns; r++)
+    {
+        uint64_t pos = 0;
+        for (d = 0; d < ndim; d++) {
+            uint64_t c = isect->start[d] - box->start[d] + (d < rundim ? idx[d] : 0);
+            pos += c * stride[d];
+        }
+
+        fn (ctx, pos, r * runlen, runlen);
+
+        // next run
+        for (d = rundim-1; d >= 0; d--) {
+            if (++idx[d] < isect->count[d])
+                break;
+            idx[d] = 0;
+        }
+    }
+}
+
+typedef struct {
+    const SCAN_PREDICATE *p;
+    const char *data;
+    int elemsize;
+    uint64_t *bits;
+} SUBBOX_COMPARE;
+
+static void run_compare (void *ctx, uint64_t boxpos, uint64_t isectpos, uint64_t runlen)
+{
+    SUBBOX_COMPARE *c = (SUBBOX_COMPARE *) ctx;
+    if (c->data)
+        scan_compare (c->p, c->data + isectpos * c->elemsize, runlen, c->bits, boxpos);
+    else
+        bits_set_range (c->bits, boxpos, runlen);
+}
+
+/*
+ * Set the bits of sub-box 'isect' inside 'box'. If 'data' is NULL, all bits of
+ * 'isect' are set, otherwise 'data' holds the elements of 'isect' contiguously
+ * and the predicate is evaluated on them.
+ */
+static void process_subbox (const SCAN_PREDICATE *p, const SCAN_BOX *box, const SCAN_BOX *isect,
+                            const char *data, int elemsize, uint64_t *bits)
+{
+    SUBBOX_COMPARE c = { p, data, elemsize, bits };
+    walk_subbox (box, isect, run_compare, &c);
+}
+
+typedef struct {
+    uint64_t *boxbits;
+    uint64_t *isectbits;
+    int to_box;
+} SUBBOX_COPY;
+
+static void run_copy (void *ctx, uint64_t boxpos, uint64_t isectpos, uint64_t runlen)
+{
+    SUBBOX_COPY *c = (SUBBOX_COPY *) ctx;
+    if (c->to_box)
+        bits_copy (c->boxbits, boxpos, c->isectbits, isectpos, runlen);
+    else
+        bits_copy (c->isectbits, isectpos, c->boxbits, boxpos, runlen);
+}
+
+/* OR the bits of sub-box 'isect' (numbered contiguously) into the bitmap of 'box'
+   if 'to_box', or the other way around */
+static void copy_subbox_bits (const SCAN_BOX *box, const SCAN_BOX *isect,
+                              uint64_t *boxbits, uint64_t *isectbits, int to_box)
+{
+    SUBBOX_COPY c = { boxbits, isectbits, to_box };
+    walk_subbox (box, isect, run_copy, &c);
+}
+
+typedef struct {
+    const uint64_t *bits;
+    int any;
+} SUBBOX_ANY;
+
+static void run_any (void *ctx, uint64_t boxpos, uint64_t isectpos, uint64_t runlen)
+{
+    SUBBOX_ANY *c = (SUBBOX_ANY *) ctx;
+    while (runlen > 0 && !c->any) {
+        int m = (runlen < 64 ? (int) runlen : 64);
+        c->any = (bits_get (c->bits, boxpos, m) != 0);
+        boxpos += m;
+        runlen -= m;
+    }
+}
+
+/* Check if any bit of sub-box 'isect' is set in the bitmap of 'box' */
+static int subbox_has_bits (const SCAN_BOX *box, const SCAN_BOX *isect, const uint64_t *boxbits)
+{
+    SUBBOX_ANY c = { boxbits, 0 };
+    walk_subbox (box, isect, run_any, &c);
+    return c.any;
+}
+
+
+/*
+ * Evaluation of one query leaf
+ */
+
+/* Get the box of a leaf's selection at 'timestep' (in C order) */
+static int leaf_box (ADIOS_QUERY *q, int timestep, SCAN_BOX *box)
+{
+    ADIOS_VARINFO *v = q->varinfo;
+    if (!q->sel) {
+        box_set (box, v->ndim, NULL, v->dims);
+    } else if (q->sel->type == ADIOS_SELECTION_BOUNDINGBOX) {
+        box_set (box, q->sel->u.bb.ndim, q->sel->u.bb.start, q->sel->u.bb.count);
+    } else if (q->sel->type == ADIOS_SELECTION_WRITEBLOCK) {
+        int idx = query_utils_getGlobalWriteBlockId (q->sel->u.block.index, timestep, v);
+        if (q->sel->u.block.is_absolute_index)
+            idx = q->sel->u.block.index;
+        if (idx < 0 || idx >= v->sum_nblocks) {
+            adios_error (err_invalid_query_value,
+                    "%s: writeblock %d of variable %s does not exist at step %d\n",
+                    __func__, q->sel->u.block.index, q->varName, timestep);
+            return -1;
+        }
+        box_set (box, v->ndim, v->blockinfo[idx].start, v->blockinfo[idx].count);
+    } else {
+        return -1;
+    }
+    return 0;
+}
+
+typedef struct {
+    SCAN_BOX isect;
+    char    *data;
+} SCAN_READ;
+
+/* The reads of a leaf, performed in batches of at most SCAN_READ_BYTES */
+typedef struct {
+    ADIOS_QUERY          *q;
+    const SCAN_PREDICATE *p;
+    const SCAN_BOX       *box;
+    int                   timestep;
+    int                   elemsize;
+    uint64_t             *bits;
+    const uint64_t       *mask;      // only elements set here are needed, if not NULL
+    SCAN_KEEP            *keep;      // keep the data read here if not NULL
+    SCAN_READ            *reads;
+    int                   nreads;
+    int                   maxreads;
+    uint64_t              readbytes;
+} SCAN_READER;
+
+/* One chunk of a read to compare on a thread into the bitmap of the read */
+typedef struct {
+    const SCAN_READ *rd;
+    uint64_t        *cmp;     // one bit per element of rd->isect
+    uint64_t         first;   // multiple of 64, so chunks never share a word
+    uint64_t         n;
+} SCAN_CHUNK;
+
+typedef struct {
+    const SCAN_PREDICATE *p;
+    int                   elemsize;
+    SCAN_CHUNK           *chunks;
+} SCAN_CHUNK_TASKS;
+
+static void compare_chunk (void *arg, int task)
+{
+    SCAN_CHUNK_TASKS *t = (SCAN_CHUNK_TASKS *) arg;
+    SCAN_CHUNK *c = &t->chunks[task];
+    scan_compare (t->p, c->rd->data + c->first * t->elemsize, c->n, c->cmp, c->first);
+}
+
+/* Compare the reads in chunks on the query threads, then merge the bitmap of
+   each read into the leaf's bitmap. Returns 1 if there is not enough memory. */
+static int compare_reads_threaded (SCAN_READER *r)
+{
+    uint64_t **cmp = (uint64_t **) calloc (r->nreads, sizeof(uint64_t *));
+    SCAN_CHUNK_TASKS t = { r->p, r->elemsize, NULL };
+    int i, nchunks = 0, err = (cmp == NULL);
+
+    for (i = 0; i < r->nreads && !err; i++) {
+        uint64_t n = box_nelements (&r->reads[i].isect);
+        cmp[i] = (uint64_t *) calloc ((n + 63) / 64 ? (n + 63) / 64 : 1, sizeof(uint64_t));
+        err = (cmp[i] == NULL);
+        nchunks += (int) ((n + SCAN_CHUNK_ELEMENTS - 1) / SCAN_CHUNK_ELEMENTS);
+    }
+    if (!err) {
+        t.chunks = (SCAN_CHUNK *) malloc ((nchunks ? nchunks : 1) * sizeof(SCAN_CHUNK));
+        err = (t.chunks == NULL);
+    }
+
+    if (!err) {
+        int k = 0;
+        for (i = 0; i < r->nreads; i++) {
+            uint64_t first, n = box_nelements (&r->reads[i].isect);
+            for (first = 0; first < n; first += SCAN_CHUNK_ELEMENTS, k++) {
+                t.chunks[k].rd = &r->reads[i];
+                t.chunks[k].cmp = cmp[i];
+                t.chunks[k].first = first;
+                t.chunks[k].n = (n - first < SCAN_CHUNK_ELEMENTS ? n - first : SCAN_CHUNK_ELEMENTS);
+            }
+        }
+        query_utils_run_tasks (nchunks, compare_chunk, &t);
+        for (i = 0; i < r->nreads; i++)
+            copy_subbox_bits (r->box, &r->reads[i].isect, r->bits, cmp[i], 1);
+    }
+
+    if (cmp) {
+        for (i = 0; i < r->nreads; i++)
+            free (cmp[i]);
+    }
+    free (cmp);
+    free (t.chunks);
+    return err;
+}
+
+/* Read the scheduled boxes and evaluate the predicate on them */
+static int perform_leaf_reads (SCAN_READER *r)
+{
+    int i, err = 0;
+    if (r->nreads == 0)
+        return 0;
+    if (common_read_perform_reads (r->q->file, 1) != 0)
+        err = adios_errno;
+    if (!err && (query_utils_get_threads () == 1 || compare_reads_threaded (r))) {
+        for (i = 0; i < r->nreads; i++)
+            process_subbox (r->p, r->box, &r->reads[i].isect, r->reads[i].data, r->elemsize, r->bits);
+    }
+    for (i = 0; i < r->nreads; i++) {
+        if (err || !keep_data (r->keep, r->q, &r->reads[i].isect, r->reads[i].data,
+                               box_nelements (&r->reads[i].isect) * r->elemsize))
+            free (r->reads[i].data);
+    }
+    r->nreads = 0;
+    r->readbytes = 0;
+    return err;
+}
+
+/* Schedule reading 'isect' (part of the leaf's box), as writeblock 'block' if
+   it is not -1. Scheduled reads are performed when the batch is full. */
+static int add_leaf_read (SCAN_READER *r, const SCAN_BOX *isect, int block)
+{
+    uint64_t nbytes = box_nelements (isect) * r->elemsize;
+    if (r->nreads == r->maxreads ||
+        (r->nreads > 0 && r->readbytes + nbytes > SCAN_READ_BYTES))
+    {
+        int err = perform_leaf_reads (r);
+        if (err)
+            return err;
+    }
+
+    SCAN_READ *rd = &r->reads[r->nreads];
+    rd->isect = *isect;
+    rd->data = (char *) malloc (nbytes);
+    if (!rd->data) {
+        adios_error (err_no_memory, "%s: cannot allocate %" PRIu64 " bytes to read "
+                "a block of variable %s\n", __func__, nbytes, r->q->varName);
+        return err_no_memory;
+    }
+    ADIOS_SELECTION *sel = (block >= 0 ? a2sel_writeblock (block) : box_to_selection (isect));
+    common_read_schedule_read_byid (r->q->file, sel, r->q->varinfo->varid, r->timestep, 1, NULL, rd->data);
+    a2sel_free (sel);
+    r->nreads++;
+    r->readbytes += nbytes;
+    return 0;
+}
+
+/* A block that the statistics cannot decide */
+typedef struct {
+    int       block;      // index of the block in the timestep
+    SCAN_BOX  blockbox;
+    SCAN_BOX  isect;      // part of the block in the leaf's box
+    char     *zmap;       // zone map of the block as read, or NULL
+    uint64_t  zmap_size;
+} SCAN_BLOCK_REF;
+
+/* Schedule reading slabs [first, first+n) of a block along dimension 'd', in the leaf's box */
+static int add_slab_read (SCAN_READER *r, const SCAN_BOX *blockbox, int d, uint64_t first, uint64_t n)
+{
+    SCAN_BOX slabs = *blockbox, isect;
+    slabs.start[d] += first;
+    slabs.count[d] = n;
+    if (!box_intersect (&slabs, r->box, &isect))
+        return 0;
+    return add_leaf_read (r, &isect, -1);
+}
+
+/* Evaluate a block zone by zone with its zone map: zones that cannot match are
+   skipped, integer zones that match entirely are marked, consecutive zones that
+   may match are read together. Returns 1 if the zone map cannot be used. */
+static int scan_zones (SCAN_READER *r, const SCAN_BLOCK_REF *ref,
+                       int *zones_skipped, int *zones_full, int *zones_read, int *err)
+{
+    ADIOS_ZONE_MAP_BLOCK zm;
+    int d = adios_zone_map_slab_dim (ref->blockbox.ndim, ref->blockbox.count);
+    uint64_t z, run_first = 0, run_n = 0;
+
+    if (d < 0 || adios_zone_map_parse (ref->zmap, ref->zmap_size, &zm) ||
+        zm.type != r->p->type || zm.nslabs != ref->blockbox.count[d])
+        return 1;
+
+    for (z = 0; z < zm.nzones && !*err; z++)
+    {
+        uint64_t first, n;
+        const void *min, *max;
+        SCAN_BOX zbox = ref->blockbox, zisect;
+        adios_zone_map_zone (&zm, z, &first, &n, &min, &max);
+        zbox.start[d] += first;
+        zbox.count[d] = n;
+        if (!box_intersect (&zbox, r->box, &zisect))
+            continue;
+        if (r->mask && !subbox_has_bits (r->box, &zisect, r->mask)) {
+            (*zones_skipped)++;
+            continue;
+        }
+
+        enum SCAN_BLOCK_MATCH m = classify_block (r->p, min, max);
+        if (m == SCAN_BLOCK_SOME) {
+            (*zones_read)++;
+            if (run_n && run_first + run_n == first) {
+                run_n += n;
+                continue;
+            }
+            if (run_n)
+                *err = add_slab_read (r, &ref->blockbox, d, run_first, run_n);
+            run_first = first;
+            run_n = n;
+        } else if (m == SCAN_BLOCK_ALL) {
+            (*zones_full)++;
+            process_subbox (r->p, r->box, &zisect, NULL, r->elemsize, r->bits);
+        } else {
+            (*zones_skipped)++;
+        }
+    }
+    if (run_n && !*err)
+        *err = add_slab_read (r, &ref->blockbox, d, run_first, run_n);
+    return 0;
+}
+
+/* Evaluate a leaf into 'bits' (zeroed, covering the leaf's box) by reading
+   the blocks that the statistics cannot decide, or only their zones that
+   the zone maps cannot decide. If 'mask' is given, only the elements set
+   in it are needed, blocks and zones without them are skipped.
+   The data read is taken over by 'keep' if it is given and wants it. */
+static int scan_leaf (ADIOS_QUERY *q, int timestep, const SCAN_BOX *box, uint64_t *bits,
+                      const uint64_t *mask, SCAN_KEEP *keep)
+{
+    ADIOS_VARINFO *v = q->varinfo;
+    SCAN_PREDICATE pred;
+    SCAN_READER r;
+    int i, k, err = 0;
+
+    predicate_init (&pred, q);
+
+    // varinfo contains blocks for many timesteps, we need the index where the current timestep starts
+    int block_start_idx = 0;
+    for (i = 0; i < timestep; i++)
+        block_start_idx += v->nblocks[i];
+
+    int loop_start = 0;
+    int loop_end = v->nblocks[timestep];
+    if (q->sel && q->sel->type == ADIOS_SELECTION_WRITEBLOCK) {
+        loop_start = (q->sel->u.block.is_absolute_index ?
+                      q->sel->u.block.index - block_start_idx :
+                      q->sel->u.block.index);
+        loop_end = loop_start + 1;
+    }
+
+    int blocks_skipped = 0, blocks_full = 0, blocks_read = 0, blocks_zoned = 0;
+    int zones_skipped = 0, zones_full = 0, zones_read = 0;
+    int nblocks = (loop_end > loop_start ? loop_end - loop_start : 1);
+    SCAN_BLOCK_REF *list = (SCAN_BLOCK_REF *) calloc (nblocks, sizeof(SCAN_BLOCK_REF));
+    int nlist = 0;
+
+    memset (&r, 0, sizeof(r));
+    r.q = q;
+    r.p = &pred;
+    r.box = box;
+    r.timestep = timestep;
+    r.elemsize = common_read_type_size (v->type, NULL);
+    r.bits = bits;
+    r.mask = mask;
+    r.keep = keep;
+    r.maxreads = nblocks;
+    r.reads = (SCAN_READ *) malloc (r.maxreads * sizeof(SCAN_READ));
+    if (!list || !r.reads) {
+        adios_error (err_no_memory, "%s: cannot allocate memory for the read list\n", __func__);
+        free (list);
+        free (r.reads);
+        return err_no_memory;
+    }
+
+    // decide what we can with the statistics of the blocks
+    for (i = loop_start; i < loop_end; i++)
+    {
+        int b = i + block_start_idx;
+        SCAN_BOX blockbox, isect;
+        box_set (&blockbox, v->ndim, v->blockinfo[b].start, v->blockinfo[b].count);
+        if (!box_intersect (&blockbox, box, &isect))
+            continue;
+
+        enum SCAN_BLOCK_MATCH m = SCAN_BLOCK_SOME;
+        if (mask && !subbox_has_bits (box, &isect, mask))
+            m = SCAN_BLOCK_NONE;
+        else if (v->statistics && v->statistics->blocks)
+            m = classify_block (&pred, v->statistics->blocks->mins[b], v->statistics->blocks->maxs[b]);
+
+        if (m == SCAN_BLOCK_NONE) {
+            blocks_skipped++;
+        } else if (m == SCAN_BLOCK_ALL) {
+            blocks_full++;
+            process_subbox (&pred, box, &isect, NULL, r.elemsize, bits);
+        } else {
+            list[nlist].block = i;
+            list[nlist].blockbox = blockbox;
+            list[nlist].isect = isect;
+            nlist++;
+        }
+    }
+
+    // read the zone maps of the remaining blocks, if the variable has them
+    ADIOS_VARINFO *zv = NULL;
+    if (nlist)
+        zv = query_utils_inq_companion_var (q->file, ADIOS_ZONE_MAP_PATH, q->varName, v, timestep);
+    if (zv) {
+        int nscheduled = 0;
+        for (k = 0; k < nlist && !err; k++) {
+            list[k].zmap = query_utils_schedule_companion_block (q->file, zv, timestep, list[k].block,
+                                                                 &list[k].zmap_size);
+            if (list[k].zmap)
+                nscheduled++;
+            else if (list[k].zmap_size)
+                err = adios_errno;
+        }
+        if (!err && nscheduled && common_read_perform_reads (q->file, 1) != 0)
+            err = adios_errno;
+        common_read_free_varinfo (zv);
+    }
+
+    // read and check the remaining blocks, or their zones that may match
+    for (k = 0; k < nlist && !err; k++)
+    {
+        if (list[k].zmap &&
+            !scan_zones (&r, &list[k], &zones_skipped, &zones_full, &zones_read, &err))
+        {
+            blocks_zoned++;
+            continue;
+        }
+        blocks_read++;
+        if (q->sel && q->sel->type == ADIOS_SELECTION_WRITEBLOCK)
+            err = add_leaf_read (&r, &list[k].isect, list[k].block);
+        else
+            err = add_leaf_read (&r, &list[k].isect, -1);
+    }
+
+    if (!err) {
+        err = perform_leaf_reads (&r);
+    } else {
+        for (i = 0; i < r.nreads; i++)
+            free (r.reads[i].data);
+    }
+    for (k = 0; k < nlist; k++)
+        free (list[k].zmap);
+    free (list);
+    free (r.reads);
+
+    log_debug ("%s: %s: %d blocks skipped, %d blocks matched by statistics, %d blocks read, "
+            "%d blocks by zones (%d zones skipped, %d zones matched, %d zones read)\n",
+            __func__, q->condition, blocks_skipped, blocks_full, blocks_read,
+            blocks_zoned, zones_skipped, zones_full, zones_read);
+    return err;
+}
+
+/*
+ * Evaluation of one query leaf with the bitmap index
+ */
+
+typedef struct {
+    int       block;      // index of the block in the timestep
+    SCAN_BOX  blockbox;
+    SCAN_BOX  isect;      // part of the block in the leaf's box
+    char     *index;      // index block as read
+    uint64_t  index_size;
+    uint64_t *hits;       // elements of isect matched by the index
+    uint64_t *cand;       // elements of isect in bins cut by the condition
+    char     *data;       // elements of isect, read only if there are candidates
+} INDEX_BLOCK;
+
+/* Decide the elements of a block's part in the leaf's box from its index block.
+   Elements not decided by the index become candidates; all of them if the index
+   block is not usable. Returns 0 or an error code. */
+static int lookup_index_block (const SCAN_PREDICATE *p, INDEX_BLOCK *ib)
+{
+    ADIOS_BITMAP_INDEX_BLOCK block;
+    uint64_t n = box_nelements (&ib->blockbox);
+    uint64_t nisect = box_nelements (&ib->isect);
+    uint64_t nwords = (nisect + 63) / 64;
+    uint64_t *hits = NULL, *cand = NULL;
+    uint32_t bin;
+
+    ib->hits = (uint64_t *) calloc (nwords ? nwords : 1, sizeof(uint64_t));
+    ib->cand = (uint64_t *) calloc (nwords ? nwords : 1, sizeof(uint64_t));
+    if (!ib->hits || !ib->cand)
+        goto nomem;
+
+    if (adios_bitmap_index_parse (ib->index, ib->index_size, &block) || block.nelements != n) {
+        adios_bitmap_index_block_free (&block);
+        bits_set_range (ib->cand, 0, nisect);
+        return 0;
+    }
+
+    // the index covers the whole block, decode bins block-wide first if only a part is needed
+    if (nisect == n) {
+        hits = ib->hits;
+        cand = ib->cand;
+    } else {
+        hits = (uint64_t *) calloc ((n + 63) / 64, sizeof(uint64_t));
+        cand = (uint64_t *) calloc ((n + 63) / 64, sizeof(uint64_t));
+        if (!hits || !cand) {
+            adios_bitmap_index_block_free (&block);
+            goto nomem;
+        }
+    }
+
+    for (bin = 0; bin < block.nbins; bin++) {
+        double lo = 0, hi = 0;
+        int nanbin = (bin == block.nbins - 1);
+        if (!nanbin)
+            adios_bitmap_index_bin_range (&block, bin, &lo, &hi);
+        switch (classify_bin (p, lo, hi, nanbin)) {
+            case SCAN_BLOCK_ALL:  adios_bitmap_index_decode (&block, bin, hits); break;
+            case SCAN_BLOCK_SOME: adios_bitmap_index_decode (&block, bin, cand); break;
+            default: break;
+        }
+    }
+    adios_bitmap_index_block_free (&block);
+
+    if (hits != ib->hits) {
+        copy_subbox_bits (&ib->blockbox, &ib->isect, hits, ib->hits, 0);
+        copy_subbox_bits (&ib->blockbox, &ib->isect, cand, ib->cand, 0);
+        free (hits);
+        free (cand);
+    }
+    return 0;
+
+nomem:
+    if (hits != ib->hits) {
+        free (hits);
+        free (cand);
+    }
+    adios_error (err_no_memory, "%s: cannot allocate memory for the bitmaps of a block "
+            "of %" PRIu64 " elements\n", __func__, n);
+    return err_no_memory;
+}
+
+/* Candidates of an index block that satisfy the condition become hits */
+static int check_index_candidates (const SCAN_PREDICATE *p, INDEX_BLOCK *ib)
+{
+    uint64_t nisect = box_nelements (&ib->isect);
+    uint64_t w, nwords = (nisect + 63) / 64;
+    uint64_t *cmp = (uint64_t *) calloc (nwords, sizeof(uint64_t));
+    if (!cmp) {
+        adios_error (err_no_memory, "%s: cannot allocate memory for a bitmap of "
+                "%" PRIu64 " elements\n", __func__, nisect);
+        return err_no_memory;
+    }
+    scan_compare (p, ib->data, nisect, cmp, 0);
+    for (w = 0; w < nwords; w++)
+        ib->hits[w] |= ib->cand[w] & cmp[w];
+    free (cmp);
+    return 0;
+}
+
+/* Index blocks looked up or checked on the query threads, one block per task */
+typedef struct {
+    const SCAN_PREDICATE *p;
+    INDEX_BLOCK          *list;
+    int                  *errs;
+} INDEX_TASKS;
+
+static void lookup_index_task (void *arg, int task)
+{
+    INDEX_TASKS *t = (INDEX_TASKS *) arg;
+    t->errs[task] = lookup_index_block (t->p, &t->list[task]);
+}
+
+static void check_index_task (void *arg, int task)
+{
+    INDEX_TASKS *t = (INDEX_TASKS *) arg;
+    if (t->list[task].data)
+        t->errs[task] = check_index_candidates (t->p, &t->list[task]);
+}
+
+/* Run 'fn' on every block of the list, return the first error */
+static int run_index_tasks (const SCAN_PREDICATE *p, INDEX_BLOCK *list, int n, QUERY_TASK_FN fn)
+{
+    INDEX_TASKS t = { p, list, NULL };
+    int k, err = 0;
+    t.errs = (int *) calloc (n, sizeof(int));
+    if (!t.errs) {
+        adios_error (err_no_memory, "%s: cannot allocate memory for the block list\n", __func__);
+        return err_no_memory;
+    }
+    query_utils_run_tasks (n, fn, &t);
+    for (k = 0; k < n && !err; k++)
+        err = t.errs[k];
+    free (t.errs);
+    return err;
+}
+
+/* Decide a list of blocks with their index, then read the data of the blocks
+   that still have candidates and check those. Decoding the index blocks and
+   checking the candidates runs on the query threads. */
+static int process_index_blocks (ADIOS_QUERY *q, const SCAN_PREDICATE *p, int timestep,
+                                 const SCAN_BOX *box, ADIOS_VARINFO *iv,
+                                 INDEX_BLOCK *list, int n, int elemsize, uint64_t *bits,
+                                 SCAN_KEEP *keep, int *blocks_indexed, int *blocks_read)
+{
+    int k, nscheduled = 0, err = 0;
+
+    for (k = 0; k < n && !err; k++) {
+        INDEX_BLOCK *ib = &list[k];
+        ib->index = query_utils_schedule_companion_block (q->file, iv, timestep, ib->block,
+                                                          &ib->index_size);
+        if (ib->index)
+            nscheduled++;
+        else if (ib->index_size)
+            err = adios_errno;
+    }
+    if (!err && nscheduled && common_read_perform_reads (q->file, 1) != 0)
+        err = adios_errno;
+
+    if (!err)
+        err = run_index_tasks (p, list, n, lookup_index_task);
+
+    nscheduled = 0;
+    for (k = 0; k < n && !err; k++) {
+        INDEX_BLOCK *ib = &list[k];
+        uint64_t nisect = box_nelements (&ib->isect);
+        if (!bits_count (ib->cand, (nisect + 63) / 64)) {
+            (*blocks_indexed)++;
+            continue;
+        }
+        ib->data = (char *) malloc (nisect * elemsize);
+        if (!ib->data) {
+            adios_error (err_no_memory, "%s: cannot allocate %" PRIu64 " bytes to read "
+                    "a block of variable %s\n", __func__, nisect * elemsize, q->varName);
+            err = err_no_memory;
+            break;
+        }
+        ADIOS_SELECTION *sel;
+        if (q->sel && q->sel->type == ADIOS_SELECTION_WRITEBLOCK)
+            sel = a2sel_writeblock (ib->block);
+        else
+            sel = box_to_selection (&ib->isect);
+        common_read_schedule_read_byid (q->file, sel, q->varinfo->varid, timestep, 1, NULL, ib->data);
+        a2sel_free (sel);
+        nscheduled++;
+        (*blocks_read)++;
+    }
+    if (!err && nscheduled && common_read_perform_reads (q->file, 1) != 0)
+        err = adios_errno;
+    if (!err && nscheduled)
+        err = run_index_tasks (p, list, n, check_index_task);
+
+    for (k = 0; k < n; k++) {
+        INDEX_BLOCK *ib = &list[k];
+        if (!err && ib->hits)
+            copy_subbox_bits (box, &ib->isect, bits, ib->hits, 1);
+        free (ib->index);
+        free (ib->hits);
+        free (ib->cand);
+        if (err || !keep_data (keep, q, &ib->isect, ib->data, box_nelements (&ib->isect) * elemsize))
+            free (ib->data);
+    }
+    return err;
+}
+
+/* Evaluate a leaf into 'bits' (zeroed, covering the leaf's box) with the help
+   of the bitmap index in variable 'iv'. Blocks without elements in 'mask'
+   (if given) are skipped. */
+static int index_leaf (ADIOS_QUERY *q, int timestep, const SCAN_BOX *box, uint64_t *bits,
+                       const uint64_t *mask, ADIOS_VARINFO *iv, SCAN_KEEP *keep)
+{
+    ADIOS_VARINFO *v = q->varinfo;
+    SCAN_PREDICATE pred;
+    int elemsize = common_read_type_size (v->type, NULL);
+    int i, err = 0;
+
+    predicate_init (&pred, q);
+
+    // varinfo contains blocks for many timesteps, we need the index where the current timestep starts
+    int block_start_idx = 0;
+    for (i = 0; i < timestep; i++)
+        block_start_idx += v->nblocks[i];
+
+    int loop_start = 0;
+    int loop_end = v->nblocks[timestep];
+    if (q->sel && q->sel->type == ADIOS_SELECTION_WRITEBLOCK) {
+        loop_start = (q->sel->u.block.is_absolute_index ?
+                      q->sel->u.block.index - block_start_idx :
+                      q->sel->u.block.index);
+        loop_end = loop_start + 1;
+    }
+
+    int blocks_skipped = 0, blocks_full = 0, blocks_indexed = 0, blocks_read = 0;
+    INDEX_BLOCK *list = (INDEX_BLOCK *) calloc (loop_end - loop_start, sizeof(INDEX_BLOCK));
+    int nlist = 0;
+    uint64_t listbytes = 0;
+    if (!list) {
+        adios_error (err_no_memory, "%s: cannot allocate memory for the block list\n", __func__);
+        return err_no_memory;
+    }
+
+    for (i = loop_start; i < loop_end && !err; i++)
+    {
+        int b = i + block_start_idx;
+        SCAN_BOX blockbox, isect;
+        box_set (&blockbox, v->ndim, v->blockinfo[b].start, v->blockinfo[b].count);
+        if (!box_intersect (&blockbox, box, &isect))
+            continue;
+
+        enum SCAN_BLOCK_MATCH m = SCAN_BLOCK_SOME;
+        if (mask && !subbox_has_bits (box, &isect, mask))
+            m = SCAN_BLOCK_NONE;
+        else if (v->statistics && v->statistics->blocks)
+            m = classify_block (&pred, v->statistics->blocks->mins[b], v->statistics->blocks->maxs[b]);
+
+        if (m == SCAN_BLOCK_NONE) {
+            blocks_skipped++;
+        } else if (m == SCAN_BLOCK_ALL) {
+            blocks_full++;
+            process_subbox (&pred, box, &isect, NULL, elemsize, bits);
+        } else {
+            // the data of the listed blocks may have to be read, limit it like scan does
+            uint64_t nbytes = box_nelements (&isect) * elemsize;
+            if (nlist > 0 && listbytes + nbytes > SCAN_READ_BYTES) {
+                err = process_index_blocks (q, &pred, timestep, box, iv, list, nlist,
+                                            elemsize, bits, keep, &blocks_indexed, &blocks_read);
+                memset (list, 0, nlist * sizeof(INDEX_BLOCK));
+                nlist = 0;
+                listbytes = 0;
+                if (err)
+                    break;
+            }
+            list[nlist].block = i;
+            list[nlist].blockbox = blockbox;
+            list[nlist].isect = isect;
+            nlist++;
+            listbytes += nbytes;
+        }
+    }
+
+    if (!err && nlist)
+        err = process_index_blocks (q, &pred, timestep, box, iv, list, nlist,
+                                    elemsize, bits, keep, &blocks_indexed, &blocks_read);
+    free (list);
+
+    log_debug ("%s: %s: %d blocks skipped, %d blocks matched by statistics, "
+            "%d blocks decided by the index, %d blocks read\n",
+            __func__, q->condition, blocks_skipped, blocks_full, blocks_indexed, blocks_read);
+    return err;
+}
+
+static const char * method_name (int use_index)
+{
+    return (use_index == SCAN_INDEX_SORTED ? "sorted" : (use_index ? "bitmap" : "scan"));
+}
+
+/* Evaluate a leaf into 'bits' (zeroed, covering the leaf's box), needed only
+   where 'mask' is set if it is given */
+static int evaluate_leaf (ADIOS_QUERY *q, int timestep, const SCAN_BOX *box, uint64_t *bits,
+                          const uint64_t *mask, int use_index, SCAN_KEEP *keep)
+{
+    if (use_index == SCAN_INDEX_SORTED) {
+        QUERY_SORTED_INDEX *idx = query_sorted_open (q->file, q->varName, q->varinfo, timestep);
+        if (idx) {
+            int err = query_sorted_evaluate (idx, q->predicateOp, q->predicateValue,
+                                             box->ndim, box->start, box->count, bits);
+            query_sorted_free (idx);
+            return err;
+        }
+        log_debug ("%s: no sorted index for %s at step %d, scanning the data\n",
+                __func__, q->varName, timestep);
+    } else if (use_index) {
+        ADIOS_VARINFO *iv = query_utils_inq_companion_var (q->file, ADIOS_BITMAP_INDEX_PATH,
+                                                           q->varName, q->varinfo, timestep);
+        if (iv) {
+            int err = index_leaf (q, timestep, box, bits, mask, iv, keep);
+            common_read_free_varinfo (iv);
+            return err;
+        }
+        log_debug ("%s: no bitmap index for %s, scanning the data\n", __func__, q->varName);
+    }
+    return scan_leaf (q, timestep, box, bits, mask, keep);
+}
+
+
+static ADIOS_QUERY * first_leaf (ADIOS_QUERY *q)
+{
+    while (q->left || q->right)
+        q = (ADIOS_QUERY *) (q->left ? q->left : q->right);
+    return q;
+}
+
+static int evaluate_rec (ADIOS_QUERY *q, int timestep, uint64_t nelements, uint64_t *bits, uint64_t nwords,
+                         const uint64_t *mask, int use_index, SCAN_KEEP *keep);
+
+static int is_cached (ADIOS_QUERY *q, int timestep, uint64_t nwords)
+{
+    char *key = query_cache_key (q, "points");
+    int cached = query_cache_has (first_leaf (q)->file, key, timestep, nwords * sizeof(uint64_t));
+    free (key);
+    return cached;
+}
+
+/* Evaluate an AND/OR node into 'bits'. The side of an AND that is in the
+   cache is evaluated first, so that its hits mask the other side. */
+static int evaluate_node (ADIOS_QUERY *q, int timestep, uint64_t nelements, uint64_t *bits, uint64_t nwords,
+                          const uint64_t *mask, int use_index, SCAN_KEEP *keep)
+{
+    ADIOS_QUERY *first = (ADIOS_QUERY *) q->left;
+    ADIOS_QUERY *second = (ADIOS_QUERY *) q->right;
+    int err;
+
+    if (q->combineOp == ADIOS_QUERY_OP_AND &&
+        !is_cached (first, timestep, nwords) && is_cached (second, timestep, nwords))
+    {
+        first = (ADIOS_QUERY *) q->right;
+        second = (ADIOS_QUERY *) q->left;
+    }
+
+    err = evaluate_rec (first, timestep, nelements, bits, nwords, mask, use_index, keep);
+    if (err)
+        return err;
+
+    if (q->combineOp == ADIOS_QUERY_OP_AND && !bits_count (bits, nwords))
+        return 0; // skip evaluating the other side since the first produced already zero results
+
+    uint64_t *rbits = (uint64_t *) calloc (nwords, sizeof(uint64_t));
+    if (!rbits) {
+        adios_error (err_no_memory, "%s: cannot allocate memory for a bitmap of %" PRIu64 " elements\n",
+                __func__, nelements);
+        return err_no_memory;
+    }
+    // with AND, only the hits of the first side are needed from the other side
+    err = evaluate_rec (second, timestep, nelements, rbits, nwords,
+                        (q->combineOp == ADIOS_QUERY_OP_AND ? bits : mask), use_index, keep);
+    if (!err) {
+        uint64_t i;
+        if (q->combineOp == ADIOS_QUERY_OP_AND) {
+            for (i = 0; i < nwords; i++)
+                bits[i] &= rbits[i];
+        } else {
+            for (i = 0; i < nwords; i++)
+                bits[i] |= rbits[i];
+        }
+    }
+    free (rbits);
+    return err;
+}
+
+/* Evaluate the query tree into 'bits' (zeroed, 'nwords' long). If 'mask' is
+   given, the result is needed only where it is set (set bits are always hits).
+   Results evaluated without a mask are cached, and are taken from the cache
+   when the same (sub)query is evaluated again at the same timestep. */
+static int evaluate_rec (ADIOS_QUERY *q, int timestep, uint64_t nelements, uint64_t *bits, uint64_t nwords,
+                         const uint64_t *mask, int use_index, SCAN_KEEP *keep)
+{
+    if ((q->left == NULL) != (q->right == NULL))
+        return evaluate_rec ((ADIOS_QUERY *) (q->left ? q->left : q->right), timestep, nelements, bits, nwords,
+                             mask, use_index, keep);
+
+    const ADIOS_FILE *f = first_leaf (q)->file;
+    char *key = query_cache_key (q, "points");
+    int err = 0;
+
+    if (query_cache_get (f, key, timestep, bits, nwords * sizeof(uint64_t))) {
+        free (key);
+        return 0;
+    }
+
+    if (!q->left && !q->right)
+    {
+        SCAN_BOX box;
+        if (leaf_box (q, timestep, &box)) {
+            err = adios_errno ? adios_errno : err_invalid_query_value;
+        } else if (box_nelements (&box) != nelements) {
+            adios_error (err_incompatible_queries,
+                    "%s: the selection of condition %s has %" PRIu64 " elements instead of %" PRIu64 "\n",
+                    __func__, q->condition, box_nelements (&box), nelements);
+            err = err_incompatible_queries;
+        } else {
+            err = evaluate_leaf (q, timestep, &box, bits, mask, use_index, keep);
+        }
+    }
+    else
+    {
+        err = evaluate_node (q, timestep, nelements, bits, nwords, mask, use_index, keep);
+    }
+
+    if (!err && !mask)
+        query_cache_put (f, key, timestep, bits, nwords * sizeof(uint64_t));
+    free (key);
+    return err;
+}
+
+/* Make sure every leaf has varinfo with statistics and blockinfo */
+static int prepare_leaves (ADIOS_QUERY *q)
+{
+    if (q->left || q->right) {
+        return (!q->left || prepare_leaves ((ADIOS_QUERY *) q->left)) &&
+               (!q->right || prepare_leaves ((ADIOS_QUERY *) q->right));
+    }
+    if (!q->varinfo)
+        q->varinfo = common_read_inq_var (q->file, q->varName);
+    if (!q->varinfo)
+        return 0;
+    if (!q->varinfo->statistics)
+        common_read_inq_var_stat (q->file, q->varinfo, 0, 1); // get per block statistics
+    if (!q->varinfo->blockinfo)
+        common_read_inq_var_blockinfo (q->file, q->varinfo); // get per block dimensions
+    return (q->varinfo->blockinfo != NULL);
+}
+
+// Do the evaluation first time for this timestep, with the index 'use_index' (SCAN_INDEX_*).
+// The data read of variables 'keepvars' is kept for read_where.
+// Return the total number of hits, -1 on error
+static int64_t do_evaluate_now (ADIOS_QUERY *q, int timestep, int use_index,
+                                int nkeepvars, const char **keepvars)
+{
+    if (!adios_query_scan_can_evaluate (q)) {
+        adios_error (err_incompatible_queries,
+                "%s: the query is not compatible with the %s query method\n",
+                __func__, method_name (use_index));
+        return -1;
+    }
+
+    SCAN_BOX box;
+    if (leaf_box (first_leaf (q), timestep, &box))
+        return -1;
+
+    free_internal (q);
+    SCAN_INTERNAL *qi = (SCAN_INTERNAL *) calloc (1, sizeof(SCAN_INTERNAL));
+    if (!qi) {
+        adios_error (err_no_memory, "%s: cannot allocate memory for the query evaluation\n", __func__);
+        return -1;
+    }
+    q->queryInternal = qi;
+    qi->box = box;
+    qi->nelements = box_nelements (&box);
+    uint64_t nwords = (qi->nelements + 63) / 64;
+    qi->bits = (uint64_t *) calloc (nwords ? nwords : 1, sizeof(uint64_t));
+    if (!qi->bits) {
+        adios_error (err_no_memory, "%s: cannot allocate memory for a bitmap of %" PRIu64 " elements\n",
+                __func__, qi->nelements);
+        free_internal (q);
+        return -1;
+    }
+
+    qi->keep.nvars = nkeepvars;
+    qi->keep.varnames = keepvars;
+    if (evaluate_rec (q, timestep, qi->nelements, qi->bits, nwords, NULL, use_index,
+                      (nkeepvars ? &qi->keep : NULL))) {
+        free_internal (q);
+        return -1;
+    }
+    qi->keep.nvars = 0;
+    qi->keep.varnames = NULL;
+
+    q->resultsReadSoFar = 0;
+    q->maxResultsDesired = bits_count (qi->bits, nwords);
+    return (int64_t) q->maxResultsDesired;
+}
+
+/* Convert the next 'retrievalSize' hits into a point list in the output box.
+   The points are global coordinates (no container), in the caller's dimension order */
+static uint64_t * next_points (ADIOS_QUERY *q, uint64_t retrievalSize, const SCAN_BOX *outbox)
+{
+    SCAN_INTERNAL *qi = INTERNAL(q);
+    const int Corder = !futils_is_called_from_fortran();
+    int ndim = outbox->ndim;
+    uint64_t *points = (uint64_t *) malloc ((retrievalSize ? retrievalSize : 1) * ndim * sizeof(uint64_t));
+    if (!points) {
+        adios_error (err_no_memory, "%s: cannot allocate memory for %" PRIu64 " points\n",
+                __func__, retrievalSize);
+        return NULL;
+    }
+
+    uint64_t n = 0;
+    uint64_t e = qi->next_element;
+    while (n < retrievalSize && e < qi->nelements)
+    {
+        uint64_t w = qi->bits[e >> 6] >> (e & 63);
+        if (!w) {
+            e = (e | 63) + 1; // jump to next word
+            continue;
+        }
+        e += __builtin_ctzll (w);
+
+        // element position -> coordinates
+        uint64_t rem = e;
+        int d;
+        for (d = ndim-1; d >= 0; d--) {
+            uint64_t c = rem % outbox->count[d];
+            rem /= outbox->count[d];
+            int dst = (Corder ? d : ndim-1-d);
+            points[n*ndim + dst] = outbox->start[d] + c;
+        }
+        n++;
+        e++;
+    }
+    assert (n == retrievalSize);
+    qi->next_element = e;
+    return points;
+}
+
+static int64_t estimate (ADIOS_QUERY* q, int timestep, int use_index)
+{
+    const int absoluteTimestep = adios_get_actual_timestep(q, timestep);
+    int64_t retval = do_evaluate_now (q, timestep, use_index, 0, NULL);
+    if (retval > -1) {
+        // the evaluation is exact, so no need to evaluate again when the
+        // evaluate function is called for the same timestep
+        q->onTimeStep = absoluteTimestep;
+    }
+    return retval;
+}
+
+/* Evaluate the query at 'timestep' if it is not evaluated yet (keeping the data
+   read of variables 'keepvars'), and get the box the hits are mapped to */
+static int prepare_results (ADIOS_QUERY* q, int timestep, ADIOS_SELECTION* outputBoundry, int use_index,
+                            int nkeepvars, const char **keepvars, SCAN_BOX *outbox)
+{
+    const int absoluteTimestep = adios_get_actual_timestep(q, timestep);
+    // timestep is always 0 for streaming; the absolute timestep for files
+
+    if (q->onTimeStep != absoluteTimestep || !q->queryInternal)
+    {
+        // this is the first call to evaluate the query for a new timestep
+        if (do_evaluate_now (q, timestep, use_index, nkeepvars, keepvars) < 0)
+            return -1;
+        q->onTimeStep = absoluteTimestep;
+    }
+
+    SCAN_INTERNAL *qi = INTERNAL(q);
+
+    // hits are mapped to the output box, or to the first condition's box by default
+    *outbox = qi->box;
+    if (outputBoundry)
+    {
+        if (outputBoundry->type != ADIOS_SELECTION_BOUNDINGBOX) {
+            adios_error (err_incompatible_queries,
+                    "%s: the %s query method supports bounding box "
+                    "or writeblock output selections only\n",
+                    __func__, method_name (use_index));
+            return -1;
+        }
+        box_set (outbox, outputBoundry->u.bb.ndim, outputBoundry->u.bb.start, outputBoundry->u.bb.count);
+        if (box_nelements (outbox) != qi->nelements) {
+            adios_error (err_incompatible_queries,
+                    "%s: the outputBoundary selection is not compatible with the "
+                    "selections used in the query conditions\n", __func__);
+            return -1;
+        }
+    }
+    return 0;
+}
+
+static int evaluate (ADIOS_QUERY* q,
+                     int timestep,
+                     uint64_t batchSize,
+                     ADIOS_SELECTION* outputBoundry,
+                     ADIOS_QUERY_RESULT * queryResult,
+                     int use_index)
+{
+#ifdef BREAKDOWN
+    double tStart = dclock();
+#endif
+    SCAN_BOX outbox;
+    if (prepare_results (q, timestep, outputBoundry, use_index, 0, NULL, &outbox)) {
+        queryResult->status = ADIOS_QUERY_RESULT_ERROR;
+        return -1;
+    }
+
+    // calculate how many results we will return at this time
+    uint64_t retrievalSize = q->maxResultsDesired - q->resultsReadSoFar;
+    if (retrievalSize == 0) {
+        queryResult->nselections = 0;
+        queryResult->selections = NULL;
+        queryResult->npoints = 0;
+        queryResult->status = ADIOS_QUERY_NO_MORE_RESULTS;
+        return 0;
+    }
+    if (retrievalSize > batchSize) {
+        retrievalSize = batchSize;
+    }
+
+    uint64_t *points = next_points (q, retrievalSize, &outbox);
+    if (!points) {
+        queryResult->status = ADIOS_QUERY_RESULT_ERROR;
+        return -1;
+    }
+    queryResult->selections = a2sel_points (outbox.ndim, retrievalSize, points, NULL, 1);
+    queryResult->nselections = 1;
+    queryResult->npoints = retrievalSize;
+
+    q->resultsReadSoFar += retrievalSize;
+
+#ifdef BREAKDOWN
+    printf("time [%s plugin] : %f \n", method_name (use_index), dclock() - tStart);
+#endif
+
+    int moreResults = (q->resultsReadSoFar < q->maxResultsDesired);
+    queryResult->status = (moreResults ? ADIOS_QUERY_HAS_MORE_RESULTS : ADIOS_QUERY_NO_MORE_RESULTS);
+    return moreResults;
+}
+
+/* Position of point 'pt' (caller's order) in kept data, 0 if it is not in it */
+static int kept_position (const SCAN_KEPT *k, const uint64_t *pt, int Corder, uint64_t *pos)
+{
+    int ndim = k->isect.ndim, d;
+    uint64_t p = 0;
+    for (d = 0; d < ndim; d++) {
+        uint64_t c = pt[Corder ? d : ndim-1-d];
+        if (c < k->isect.start[d] || c >= k->isect.start[d] + k->isect.count[d])
+            return 0;
+        p = p * k->isect.count[d] + (c - k->isect.start[d]);
+    }
+    *pos = p;
+    return 1;
+}
+
+/* Copy the values of variable 'v' at the points from the data kept in the
+   evaluation (see QUERY_VALUES_KNOWN_FN in common_query.h) */
+static void kept_values (void *arg, const ADIOS_VARINFO *v, uint64_t npoints,
+                         const uint64_t *points, char *values, char *have)
+{
+    const SCAN_KEEP *keep = (const SCAN_KEEP *) arg;
+    const int Corder = !futils_is_called_from_fortran();
+    int elemsize = common_read_type_size (v->type, v->value);
+    int k, last = -1;
+    uint64_t p, pos, nfound = 0;
+
+    for (p = 0; p < npoints && keep->nkept; p++)
+    {
+        const uint64_t *pt = points + p * v->ndim;
+        // consecutive hits are mostly in the same part
+        if (last < 0 || !kept_position (&keep->kept[last], pt, Corder, &pos)) {
+            for (k = 0; k < keep->nkept; k++) {
+                if (keep->kept[k].varid == v->varid && keep->kept[k].isect.ndim == v->ndim &&
+                    kept_position (&keep->kept[k], pt, Corder, &pos))
+                    break;
+            }
+            if (k == keep->nkept)
+                continue;
+            last = k;
+        }
+        memcpy (values + p * elemsize, keep->kept[last].data + pos * elemsize, elemsize);
+        have[p] = 1;
+        nfound++;
+    }
+    log_debug ("%s: %" PRIu64 " of %" PRIu64 " values of variable %d from the evaluation\n",
+            __func__, nfound, npoints, v->varid);
+}
+
+static int read_where (ADIOS_QUERY* q,
+                       int timestep,
+                       uint64_t batchSize,
+                       ADIOS_SELECTION* outputBoundry,
+                       int nvars,
+                       const char **varnames,
+                       ADIOS_QUERY_VALUES * result,
+                       int use_index)
+{
+    SCAN_BOX outbox;
+    if (prepare_results (q, timestep, outputBoundry, use_index, nvars, varnames, &outbox)) {
+        result->status = ADIOS_QUERY_RESULT_ERROR;
+        return -1;
+    }
+    SCAN_INTERNAL *qi = INTERNAL(q);
+
+    uint64_t retrievalSize = q->maxResultsDesired - q->resultsReadSoFar;
+    if (retrievalSize > batchSize) {
+        retrievalSize = batchSize;
+    }
+    result->ndim = outbox.ndim;
+    result->npoints = retrievalSize;
+    if (retrievalSize) {
+        result->points = next_points (q, retrievalSize, &outbox);
+        if (!result->points) {
+            result->status = ADIOS_QUERY_RESULT_ERROR;
+            return -1;
+        }
+    }
+    q->resultsReadSoFar += retrievalSize;
+
+    if (common_query_read_where_values (first_leaf (q)->file, timestep, nvars, varnames,
+                                        kept_values, &qi->keep, result)) {
+        result->status = ADIOS_QUERY_RESULT_ERROR;
+        return -1;
+    }
+
+    int moreResults = (q->resultsReadSoFar < q->maxResultsDesired);
+    if (!moreResults)
+        free_keep (&qi->keep); // all values are returned
+    result->status = (moreResults ? ADIOS_QUERY_HAS_MORE_RESULTS : ADIOS_QUERY_NO_MORE_RESULTS);
+    return moreResults;
+}
+
+
+/*====================================================================================*/
+/*                                  Public functions
+*/
+
+int adios_query_scan_can_evaluate(ADIOS_QUERY* q)
+{
+    // we can evaluate iff every query item
+    // - is on a global array of a real or integer type
+    // - has a NULL, bounding box or writeblock selection
+    if (q->left || q->right) {
+        return (!q->left  || adios_query_scan_can_evaluate ((ADIOS_QUERY *) q->left)) &&
+               (!q->right || adios_query_scan_can_evaluate ((ADIOS_QUERY *) q->right));
+    }
+
+    if (q->sel &&
+        q->sel->type != ADIOS_SELECTION_BOUNDINGBOX &&
+        q->sel->type != ADIOS_SELECTION_WRITEBLOCK)
+        return 0;
+    if (!prepare_leaves (q))
+        return 0;
+    if (!q->varinfo->global || q->varinfo->ndim == 0 || q->varinfo->ndim > SCAN_MAX_DIMS)
+        return 0;
+    if (!is_supported_type (q->varinfo->type))
+        return 0;
+    if (q->sel && q->sel->type == ADIOS_SELECTION_BOUNDINGBOX && q->sel->u.bb.ndim != q->varinfo->ndim)
+        return 0;
+    return 1;
+}
+
+
+int64_t adios_query_scan_estimate(ADIOS_QUERY* q, int timestep)
+{
+    return estimate (q, timestep, SCAN_INDEX_NONE);
+}
+
+int adios_query_scan_evaluate(ADIOS_QUERY* q,
+                   int timestep,
+                   uint64_t batchSize,
+                   ADIOS_SELECTION* outputBoundry,
+                   ADIOS_QUERY_RESULT * queryResult)
+{
+    return evaluate (q, timestep, batchSize, outputBoundry, queryResult, SCAN_INDEX_NONE);
+}
+
+int adios_query_scan_read_where(ADIOS_QUERY* q,
+                   int timestep,
+                   uint64_t batchSize,
+                   ADIOS_SELECTION* outputBoundry,
+                   int nvars,
+                   const char **varnames,
+                   ADIOS_QUERY_VALUES * result)
+{
+    return read_where (q, timestep, batchSize, outputBoundry, nvars, varnames, result, SCAN_INDEX_NONE);
+}
+
+int adios_query_scan_free(ADIOS_QUERY* query)
+{
+    if (query == NULL)
+        return 0;
+    free_internal (query);
+    return 1;
+}
+
+int adios_query_scan_finalize() { return 0; /* there is nothing to finalize */ }
+
+
+/* The bitmap query method is the scan with the write-time bitmap indexes */
+
+static int has_index (ADIOS_QUERY *q)
+{
+    if (q->left || q->right) {
+        return (!q->left  || has_index ((ADIOS_QUERY *) q->left)) &&
+               (!q->right || has_index ((ADIOS_QUERY *) q->right));
+    }
+    return (query_utils_find_companion_var (q->file, ADIOS_BITMAP_INDEX_PATH, q->varName) >= 0);
+}
+
+int adios_query_bitmap_can_evaluate(ADIOS_QUERY* q)
+{
+    // like scan, and every query item must have an index
+    return adios_query_scan_can_evaluate (q) && has_index (q);
+}
+
+int64_t adios_query_bitmap_estimate(ADIOS_QUERY* q, int timestep)
+{
+    return estimate (q, timestep, SCAN_INDEX_BITMAP);
+}
+
+int adios_query_bitmap_evaluate(ADIOS_QUERY* q,
+                   int timestep,
+                   uint64_t batchSize,
+                   ADIOS_SELECTION* outputBoundry,
+                   ADIOS_QUERY_RESULT * queryResult)
+{
+    return evaluate (q, timestep, batchSize, outputBoundry, queryResult, SCAN_INDEX_BITMAP);
+}
+
+int adios_query_bitmap_read_where(ADIOS_QUERY* q,
+                   int timestep,
+                   uint64_t batchSize,
+                   ADIOS_SELECTION* outputBoundry,
+                   int nvars,
+                   const char **varnames,
+                   ADIOS_QUERY_VALUES * result)
+{
+    return read_where (q, timestep, batchSize, outputBoundry, nvars, varnames, result, SCAN_INDEX_BITMAP);
+}
+
+int adios_query_bitmap_free(ADIOS_QUERY* query)
+{
+    return adios_query_scan_free (query);
+}
+
+int adios_query_bitmap_finalize() { return 0; /* there is nothing to finalize */ }
+
+
+/* The sorted query method evaluates the conditions with the sorted index
+   built by the adios_index_sorted utility */
+
+static int has_sorted_index (ADIOS_QUERY *q)
+{
+    if (q->left || q->right) {
+        return (!q->left  || has_sorted_index ((ADIOS_QUERY *) q->left)) &&
+               (!q->right || has_sorted_index ((ADIOS_QUERY *) q->right));
+    }
+    return query_sorted_has_index (q->file, q->varName, -1);
+}
+
+int adios_query_sorted_can_evaluate(ADIOS_QUERY* q)
+{
+    // like scan, and every query item must have an index
+    return adios_query_scan_can_evaluate (q) && has_sorted_index (q);
+}
+
+int64_t adios_query_sorted_estimate(ADIOS_QUERY* q, int timestep)
+{
+    return estimate (q, timestep, SCAN_INDEX_SORTED);
+}
+
+int adios_query_sorted_evaluate(ADIOS_QUERY* q,
+                   int timestep,
+                   uint64_t batchSize,
+                   ADIOS_SELECTION* outputBoundry,
+                   ADIOS_QUERY_RESULT * queryResult)
+{
+    return evaluate (q, timestep, batchSize, outputBoundry, queryResult, SCAN_INDEX_SORTED);
+}
+
+int adios_query_sorted_read_where(ADIOS_QUERY* q,
+                   int timestep,
+                   uint64_t batchSize,
+                   ADIOS_SELECTION* outputBoundry,
+                   int nvars,
+                   const char **varnames,
+                   ADIOS_QUERY_VALUES * result)
+{
+    return read_where (q, timestep, batchSize, outputBoundry, nvars, varnames, result, SCAN_INDEX_SORTED);
+}
+
+int adios_query_sorted_free(ADIOS_QUERY* query)
+{
+    return adios_query_scan_free (query);
+}
+
+int adios_query_sorted_finalize() { return 0; /* there is nothing to finalize */ }
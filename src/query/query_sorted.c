@@ -0,0 +1,1270 @@
+/*
+ * query_sorted.c
+ *
+ * Sorted (value, position) secondary index, see query_sorted.h.
+ * Building the runs of the index (used by the adios_index_sorted utility),
+ * and range, top-k and quantile queries on it.
+ *
+ * A range condition needs two bounds in every run at most, each found with a
+ * binary search in the fences held in memory and one read of less than
+ * QUERY_SORTED_FENCE values. The positions between the bounds are then read
+ * sequentially.
+ *
+ * The value of a given rank (for top-k and quantiles) is selected without
+ * merging the runs: the fences give, for any value, a lower and an upper
+ * bound of the number of values less than it. A binary search over the sorted
+ * fences finds two fences that surely enclose the value of the rank, and only
+ * the parts of the runs between those two are read and sorted.
+ */
+#include <inttypes.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+#include <math.h>
+#include "public/adios_error.h"
+#include "public/adios_query.h"
+#include "public/adios_selection.h"
+#include "core/common_read.h"
+#include "core/adios_logger.h"
+#include "core/a2sel.h"
+#include "core/futils.h"
+#include "query_utils.h"
+#include "query_sorted.h"
+
+#define SORTED_MAX_DIMS 32
+
+/* Upper limit of positions read in one go while evaluating a condition */
+#define SORTED_READ_BYTES (64*1024*1024)
+
+
+/*
+ * Building the index
+ */
+
+char * query_sorted_index_file_name (const char *bpFileName)
+{
+    size_t len = strlen (bpFileName);
+    char *name = (char *) malloc (len + 6);
+    if (!name)
+        return NULL;
+    if (len > 3 && !strcmp (bpFileName + len - 3, ".bp"))
+        len -= 3;
+    memcpy (name, bpFileName, len);
+    strcpy (name + len, ".sidx");
+    return name;
+}
+
+void query_sorted_var_name (char *name, size_t len, const char *varName, int timestep, const char *what)
+{
+    if (varName[0] == '/')
+        varName++;
+    snprintf (name, len, "%s/%d/%s/%s", QUERY_SORTED_PATH, timestep, varName, what);
+}
+
+int query_sorted_supports_type (enum ADIOS_DATATYPES type)
+{
+    switch (type)
+    {
+        case adios_byte:
+        case adios_unsigned_byte:
+        case adios_short:
+        case adios_unsigned_short:
+        case adios_integer:
+        case adios_unsigned_integer:
+        case adios_long:
+        case adios_unsigned_long:
+        case adios_real:
+        case adios_double:
+            return 1;
+        default:
+            return 0;
+    }
+}
+
+uint64_t query_sorted_nfences (uint64_t n)
+{
+    return (n ? (n + QUERY_SORTED_FENCE - 1) / QUERY_SORTED_FENCE + 1 : 0);
+}
+
+/* Position of fence 'i' in a run of n values */
+static uint64_t fence_pos (uint64_t n, uint64_t i)
+{
+    uint64_t p = i * QUERY_SORTED_FENCE;
+    return (p < n ? p : n - 1);
+}
+
+/* Offsets of the elements of a block in the whole array, in the block's order */
+static void block_positions (int ndim, const uint64_t *dims, const uint64_t *start,
+                             const uint64_t *count, uint64_t *positions)
+{
+    uint64_t idx[SORTED_MAX_DIMS];
+    uint64_t nrows = 1, row, n = 0, j;
+    int d;
+
+    for (d = 0; d < ndim - 1; d++) {
+        idx[d] = 0;
+        nrows *= count[d];
+    }
+    for (row = 0; row < nrows; row++)
+    {
+        uint64_t base = 0;
+        for (d = 0; d < ndim; d++)
+            base = base * dims[d] + start[d] + (d < ndim - 1 ? idx[d] : 0);
+        for (j = 0; j < count[ndim-1]; j++)
+            positions[n++] = base + j;
+        for (d = ndim - 2; d >= 0; d--) {
+            if (++idx[d] < count[d])
+                break;
+            idx[d] = 0;
+        }
+    }
+}
+
+/* Sort (value, position) pairs by value (NaN last), then by position */
+#define SORTED_RUN_SORT(NAME, T, ISNAN)                                             \
+typedef struct { T v; uint64_t p; } SORTED_PAIR_##NAME;                             \
+static int cmp_pair_##NAME (const void *a, const void *b)                           \
+{                                                                                   \
+    const SORTED_PAIR_##NAME *x = (const SORTED_PAIR_##NAME *) a;                   \
+    const SORTED_PAIR_##NAME *y = (const SORTED_PAIR_##NAME *) b;                   \
+    int xn = ISNAN(x->v), yn = ISNAN(y->v);                                         \
+    if (xn != yn)                                                                   \
+        return xn - yn;                                                             \
+    if (!xn && x->v != y->v)                                                        \
+        return (x->v < y->v ? -1 : 1);                                              \
+    return (x->p < y->p ? -1 : (x->p > y->p ? 1 : 0));                              \
+}                                                                                   \
+static int sort_run_##NAME (T *data, uint64_t *positions, uint64_t n)               \
+{                                                                                   \
+    SORTED_PAIR_##NAME *pairs = (SORTED_PAIR_##NAME *) malloc (n * sizeof(SORTED_PAIR_##NAME)); \
+    uint64_t i;                                                                     \
+    if (!pairs)                                                                     \
+        return 1;                                                                   \
+    for (i = 0; i < n; i++) {                                                       \
+        pairs[i].v = data[i];                                                       \
+        pairs[i].p = positions[i];                                                  \
+    }                                                                               \
+    qsort (pairs, n, sizeof(SORTED_PAIR_##NAME), cmp_pair_##NAME);                  \
+    for (i = 0; i < n; i++) {                                                       \
+        data[i] = pairs[i].v;                                                       \
+        positions[i] = pairs[i].p;                                                  \
+    }                                                                               \
+    free (pairs);                                                                   \
+    return 0;                                                                       \
+}
+
+#define SORTED_NO_NAN(x) 0
+#define SORTED_IS_NAN(x) isnan(x)
+
+SORTED_RUN_SORT(byte,   int8_t,   SORTED_NO_NAN)
+SORTED_RUN_SORT(ubyte,  uint8_t,  SORTED_NO_NAN)
+SORTED_RUN_SORT(short,  int16_t,  SORTED_NO_NAN)
+SORTED_RUN_SORT(ushort, uint16_t, SORTED_NO_NAN)
+SORTED_RUN_SORT(int,    int32_t,  SORTED_NO_NAN)
+SORTED_RUN_SORT(uint,   uint32_t, SORTED_NO_NAN)
+SORTED_RUN_SORT(long,   int64_t,  SORTED_NO_NAN)
+SORTED_RUN_SORT(ulong,  uint64_t, SORTED_NO_NAN)
+SORTED_RUN_SORT(float,  float,    SORTED_IS_NAN)
+SORTED_RUN_SORT(double, double,   SORTED_IS_NAN)
+
+#undef SORTED_RUN_SORT
+
+int query_sorted_build_run (enum ADIOS_DATATYPES type, int ndim, const uint64_t *dims,
+                            const uint64_t *start, const uint64_t *count,
+                            void *data, uint64_t *positions, void *fences)
+{
+    int elemsize = common_read_type_size (type, NULL);
+    uint64_t n = 1, i, nfences;
+    int d, err = 0;
+
+    for (d = 0; d < ndim; d++)
+        n *= count[d];
+    if (!n)
+        return 0;
+
+    block_positions (ndim, dims, start, count, positions);
+    switch (type)
+    {
+        case adios_byte:             err = sort_run_byte   (data, positions, n); break;
+        case adios_unsigned_byte:    err = sort_run_ubyte  (data, positions, n); break;
+        case adios_short:            err = sort_run_short  (data, positions, n); break;
+        case adios_unsigned_short:   err = sort_run_ushort (data, positions, n); break;
+        case adios_integer:          err = sort_run_int    (data, positions, n); break;
+        case adios_unsigned_integer: err = sort_run_uint   (data, positions, n); break;
+        case adios_long:             err = sort_run_long   (data, positions, n); break;
+        case adios_unsigned_long:    err = sort_run_ulong  (data, positions, n); break;
+        case adios_real:             err = sort_run_float  (data, positions, n); break;
+        case adios_double:           err = sort_run_double (data, positions, n); break;
+        default: break;
+    }
+    if (err) {
+        adios_error (err_no_memory, "%s: cannot allocate memory to sort %" PRIu64 " values\n",
+                __func__, n);
+        return err_no_memory;
+    }
+
+    nfences = query_sorted_nfences (n);
+    for (i = 0; i < nfences; i++)
+        memcpy ((char *) fences + i * elemsize, (char *) data + fence_pos (n, i) * elemsize, elemsize);
+    return 0;
+}
+
+
+/*
+ * Reading the index
+ */
+
+/* Values are compared in a common domain: signed integers and unsigned integers
+   up to 32 bits in int64_t, 64-bit unsigned integers in uint64_t and floating
+   point values in double, where NaN is greater than any other value. */
+enum SORTED_DOMAIN { SORTED_DOMAIN_INT, SORTED_DOMAIN_UINT, SORTED_DOMAIN_REAL };
+
+/* A value of the index in the common domain, and where it is */
+typedef struct {
+    union {
+        int64_t  i;
+        uint64_t u;
+        double   r;
+    } v;
+    int      run;
+    uint64_t idx;       // index in the run
+} SORTED_ELEM;
+
+typedef struct {
+    uint64_t     start;     // offset of the run in the index arrays
+    uint64_t     n;         // number of values
+    uint64_t     nvalid;    // number of values that are not NaN
+    uint64_t     nfences;
+    SORTED_ELEM *fences;
+} SORTED_RUN;
+
+struct QUERY_SORTED_INDEX {
+    ADIOS_FILE          *ixf;           // the index file
+    int                  values_id;
+    int                  positions_id;
+    enum ADIOS_DATATYPES type;
+    enum SORTED_DOMAIN   domain;
+    int                  elemsize;
+    int                  ndim;
+    uint64_t             dims[SORTED_MAX_DIMS];  // of the variable, in C order
+    uint64_t             nelements;
+    int                  nruns;
+    SORTED_RUN          *runs;
+    int                  have_nvalid;
+    char                *name;          // of the variable, for messages
+};
+
+/* Index files opened for the data files */
+typedef struct SORTED_FILE {
+    const ADIOS_FILE   *f;
+    ADIOS_FILE         *ixf;            // NULL if the file has no index file
+    struct SORTED_FILE *next;
+} SORTED_FILE;
+
+static SORTED_FILE *sorted_files = NULL;
+
+static ADIOS_FILE * index_file (ADIOS_FILE *f)
+{
+    SORTED_FILE *sf;
+    for (sf = sorted_files; sf; sf = sf->next) {
+        if (sf->f == f)
+            return sf->ixf;
+    }
+
+    sf = (SORTED_FILE *) calloc (1, sizeof(SORTED_FILE));
+    if (!sf)
+        return NULL;
+    if (!f->is_streaming && f->path) {
+        char *name = query_sorted_index_file_name (f->path);
+        if (name && query_utils_file_exists (name)) {
+            sf->ixf = common_read_open_file (name, ADIOS_READ_METHOD_BP, MPI_COMM_SELF);
+            if (!sf->ixf)
+                log_warn ("Could not open the sorted index file '%s'\n", name);
+        }
+        free (name);
+    }
+    sf->f = f;
+    sf->next = sorted_files;
+    sorted_files = sf;
+    return sf->ixf;
+}
+
+void query_sorted_file_closed (const ADIOS_FILE *f)
+{
+    SORTED_FILE **p = &sorted_files;
+    while (*p) {
+        SORTED_FILE *sf = *p;
+        if (sf->f == f) {
+            *p = sf->next;
+            if (sf->ixf)
+                common_read_close (sf->ixf);
+            free (sf);
+        } else {
+            p = &sf->next;
+        }
+    }
+}
+
+/* Id of the variable 'name' in the index file, -1 if there is none */
+static int find_index_var (const ADIOS_FILE *ixf, const char *name)
+{
+    int i;
+    if (name[0] == '/')
+        name++;
+    for (i = 0; i < ixf->nvars; i++) {
+        const char *v = ixf->var_namelist[i];
+        if (v[0] == '/')
+            v++;
+        if (!strcmp (v, name))
+            return i;
+    }
+    return -1;
+}
+
+int query_sorted_has_index (ADIOS_FILE *f, const char *varName, int timestep)
+{
+    ADIOS_FILE *ixf = index_file (f);
+    const char *prefix = QUERY_SORTED_PATH + 1;
+    size_t plen = strlen (prefix), nlen;
+    int i;
+
+    if (!ixf)
+        return 0;
+    if (varName[0] == '/')
+        varName++;
+    nlen = strlen (varName);
+    for (i = 0; i < ixf->nvars; i++)
+    {
+        const char *v = ixf->var_namelist[i], *s;
+        if (v[0] == '/')
+            v++;
+        if (strncmp (v, prefix, plen) || v[plen] != '/')
+            continue;
+        // the step
+        v += plen + 1;
+        for (s = v; isdigit (*s); s++)
+            ;
+        if (s == v || *s != '/' || (timestep >= 0 && atoi (v) != timestep))
+            continue;
+        s++;
+        if (!strncmp (s, varName, nlen) && !strcmp (s + nlen, "/values"))
+            return 1;
+    }
+    return 0;
+}
+
+static enum SORTED_DOMAIN type_domain (enum ADIOS_DATATYPES type)
+{
+    switch (type)
+    {
+        case adios_unsigned_long: return SORTED_DOMAIN_UINT;
+        case adios_real:
+        case adios_double:        return SORTED_DOMAIN_REAL;
+        default:                  return SORTED_DOMAIN_INT;
+    }
+}
+
+/* Convert a value of the index' type to the common domain */
+static void elem_set (const QUERY_SORTED_INDEX *idx, const void *value, SORTED_ELEM *e)
+{
+    switch (idx->type)
+    {
+        case adios_byte:             e->v.i = *(const int8_t *) value; break;
+        case adios_unsigned_byte:    e->v.i = *(const uint8_t *) value; break;
+        case adios_short:            e->v.i = *(const int16_t *) value; break;
+        case adios_unsigned_short:   e->v.i = *(const uint16_t *) value; break;
+        case adios_integer:          e->v.i = *(const int32_t *) value; break;
+        case adios_unsigned_integer: e->v.i = *(const uint32_t *) value; break;
+        case adios_long:             e->v.i = *(const int64_t *) value; break;
+        case adios_unsigned_long:    e->v.u = *(const uint64_t *) value; break;
+        case adios_real:             e->v.r = *(const float *) value; break;
+        case adios_double:           e->v.r = *(const double *) value; break;
+        default:                     e->v.i = 0; break;
+    }
+}
+
+/* Convert a value in the common domain back to the index' type */
+static void elem_get (const QUERY_SORTED_INDEX *idx, const SORTED_ELEM *e, void *value)
+{
+    switch (idx->type)
+    {
+        case adios_byte:             *(int8_t *) value = (int8_t) e->v.i; break;
+        case adios_unsigned_byte:    *(uint8_t *) value = (uint8_t) e->v.i; break;
+        case adios_short:            *(int16_t *) value = (int16_t) e->v.i; break;
+        case adios_unsigned_short:   *(uint16_t *) value = (uint16_t) e->v.i; break;
+        case adios_integer:          *(int32_t *) value = (int32_t) e->v.i; break;
+        case adios_unsigned_integer: *(uint32_t *) value = (uint32_t) e->v.i; break;
+        case adios_long:             *(int64_t *) value = e->v.i; break;
+        case adios_unsigned_long:    *(uint64_t *) value = e->v.u; break;
+        case adios_real:             *(float *) value = (float) e->v.r; break;
+        case adios_double:           *(double *) value = e->v.r; break;
+        default: break;
+    }
+}
+
+/* Parse a condition's value into the common domain */
+static void elem_parse (const QUERY_SORTED_INDEX *idx, const char *value, SORTED_ELEM *e)
+{
+    switch (idx->domain)
+    {
+        case SORTED_DOMAIN_UINT: e->v.u = strtoull (value, NULL, 10); break;
+        case SORTED_DOMAIN_REAL: e->v.r = strtod (value, NULL); break;
+        default:                 e->v.i = strtoll (value, NULL, 10); break;
+    }
+}
+
+static int elem_is_nan (enum SORTED_DOMAIN dom, const SORTED_ELEM *e)
+{
+    return (dom == SORTED_DOMAIN_REAL && isnan (e->v.r));
+}
+
+/* Compare the values of two elements, NaN being the greatest */
+static int elem_cmp (enum SORTED_DOMAIN dom, const SORTED_ELEM *a, const SORTED_ELEM *b)
+{
+    switch (dom)
+    {
+        case SORTED_DOMAIN_UINT:
+            return (a->v.u < b->v.u ? -1 : (a->v.u > b->v.u ? 1 : 0));
+        case SORTED_DOMAIN_REAL:
+        {
+            int an = isnan (a->v.r), bn = isnan (b->v.r);
+            if (an || bn)
+                return an - bn;
+            return (a->v.r < b->v.r ? -1 : (a->v.r > b->v.r ? 1 : 0));
+        }
+        default:
+            return (a->v.i < b->v.i ? -1 : (a->v.i > b->v.i ? 1 : 0));
+    }
+}
+
+/* Order of elements: by value, then by where they are */
+#define SORTED_ELEM_ORDER(NAME, DOM)                                                \
+static int cmp_elem_##NAME (const void *a, const void *b)                           \
+{                                                                                   \
+    const SORTED_ELEM *x = (const SORTED_ELEM *) a;                                 \
+    const SORTED_ELEM *y = (const SORTED_ELEM *) b;                                 \
+    int c = elem_cmp (DOM, x, y);                                                   \
+    if (c)                                                                          \
+        return c;                                                                   \
+    if (x->run != y->run)                                                           \
+        return (x->run < y->run ? -1 : 1);                                          \
+    return (x->idx < y->idx ? -1 : (x->idx > y->idx ? 1 : 0));                      \
+}
+
+SORTED_ELEM_ORDER(int,  SORTED_DOMAIN_INT)
+SORTED_ELEM_ORDER(uint, SORTED_DOMAIN_UINT)
+SORTED_ELEM_ORDER(real, SORTED_DOMAIN_REAL)
+
+#undef SORTED_ELEM_ORDER
+
+static void sort_elems (enum SORTED_DOMAIN dom, SORTED_ELEM *elems, uint64_t n)
+{
+    switch (dom)
+    {
+        case SORTED_DOMAIN_UINT: qsort (elems, n, sizeof(SORTED_ELEM), cmp_elem_uint); break;
+        case SORTED_DOMAIN_REAL: qsort (elems, n, sizeof(SORTED_ELEM), cmp_elem_real); break;
+        default:                 qsort (elems, n, sizeof(SORTED_ELEM), cmp_elem_int); break;
+    }
+}
+
+void query_sorted_free (QUERY_SORTED_INDEX *idx)
+{
+    int j;
+    if (!idx)
+        return;
+    if (idx->runs) {
+        for (j = 0; j < idx->nruns; j++)
+            free (idx->runs[j].fences);
+    }
+    free (idx->runs);
+    free (idx->name);
+    free (idx);
+}
+
+QUERY_SORTED_INDEX * query_sorted_open (ADIOS_FILE *f, const char *varName,
+                                        ADIOS_VARINFO *v, int timestep)
+{
+    QUERY_SORTED_INDEX *idx = NULL;
+    ADIOS_VARINFO *vv = NULL, *pv = NULL, *fv = NULL;
+    ADIOS_FILE *ixf;
+    char **raw = NULL;
+    size_t len = strlen (varName) + 64;
+    char *name = NULL;
+    uint64_t total = 1, sum = 0;
+    int fences_id, j, d, ok = 0;
+
+    if (!query_sorted_supports_type (v->type) || v->ndim < 1 || v->ndim > SORTED_MAX_DIMS)
+        return NULL;
+    ixf = index_file (f);
+    if (!ixf)
+        return NULL;
+
+    name = (char *) malloc (len);
+    if (!name)
+        return NULL;
+    query_sorted_var_name (name, len, varName, timestep, "values");
+    int values_id = find_index_var (ixf, name);
+    query_sorted_var_name (name, len, varName, timestep, "positions");
+    int positions_id = find_index_var (ixf, name);
+    query_sorted_var_name (name, len, varName, timestep, "fences");
+    fences_id = find_index_var (ixf, name);
+    free (name);
+    if (values_id < 0 || positions_id < 0 || fences_id < 0)
+        return NULL;
+
+    vv = common_read_inq_var_byid (ixf, values_id);
+    pv = common_read_inq_var_byid (ixf, positions_id);
+    fv = common_read_inq_var_byid (ixf, fences_id);
+    if (vv)
+        common_read_inq_var_blockinfo (ixf, vv);
+    if (fv)
+        common_read_inq_var_blockinfo (ixf, fv);
+    for (d = 0; d < v->ndim; d++)
+        total *= v->dims[d];
+    if (!vv || !pv || !fv || !vv->blockinfo || !fv->blockinfo ||
+        vv->type != v->type || fv->type != v->type || pv->type != adios_unsigned_long ||
+        vv->ndim != 1 || pv->ndim != 1 || vv->dims[0] != total || pv->dims[0] != total ||
+        vv->sum_nblocks != fv->sum_nblocks)
+    {
+        log_warn ("The sorted index of %s at step %d does not match the variable\n", varName, timestep);
+        goto done;
+    }
+
+    idx = (QUERY_SORTED_INDEX *) calloc (1, sizeof(QUERY_SORTED_INDEX));
+    if (idx) {
+        idx->runs = (SORTED_RUN *) calloc (vv->sum_nblocks ? vv->sum_nblocks : 1, sizeof(SORTED_RUN));
+        idx->name = strdup (varName);
+    }
+    raw = (char **) calloc (vv->sum_nblocks ? vv->sum_nblocks : 1, sizeof(char *));
+    if (!idx || !idx->runs || !idx->name || !raw) {
+        adios_error (err_no_memory, "%s: cannot allocate memory for the sorted index of %s\n",
+                __func__, varName);
+        goto done;
+    }
+    idx->ixf = ixf;
+    idx->values_id = values_id;
+    idx->positions_id = positions_id;
+    idx->type = v->type;
+    idx->domain = type_domain (v->type);
+    idx->elemsize = common_read_type_size (v->type, NULL);
+    idx->ndim = v->ndim;
+    memcpy (idx->dims, v->dims, v->ndim * sizeof(uint64_t));
+    idx->nelements = total;
+    idx->nruns = vv->sum_nblocks;
+
+    // read the fences of all runs
+    for (j = 0; j < idx->nruns; j++)
+    {
+        SORTED_RUN *run = &idx->runs[j];
+        run->start = vv->blockinfo[j].start[0];
+        run->n = vv->blockinfo[j].count[0];
+        run->nvalid = run->n;
+        run->nfences = fv->blockinfo[j].count[0];
+        sum += run->n;
+        if (run->nfences != query_sorted_nfences (run->n)) {
+            log_warn ("The sorted index of %s at step %d has bad fences\n", varName, timestep);
+            goto done;
+        }
+        raw[j] = (char *) malloc (run->nfences * idx->elemsize);
+        run->fences = (SORTED_ELEM *) malloc (run->nfences * sizeof(SORTED_ELEM));
+        if (!raw[j] || !run->fences) {
+            adios_error (err_no_memory, "%s: cannot allocate memory for the sorted index of %s\n",
+                    __func__, varName);
+            goto done;
+        }
+    }
+    if (sum != total) {
+        log_warn ("The sorted index of %s at step %d does not match the variable\n", varName, timestep);
+        goto done;
+    }
+    for (j = 0; j < idx->nruns; j++) {
+        ADIOS_SELECTION *sel = a2sel_writeblock (j);
+        common_read_schedule_read_byid (ixf, sel, fences_id, 0, 1, NULL, raw[j]);
+        a2sel_free (sel);
+    }
+    if (idx->nruns && common_read_perform_reads (ixf, 1) != 0)
+        goto done;
+
+    for (j = 0; j < idx->nruns; j++)
+    {
+        SORTED_RUN *run = &idx->runs[j];
+        uint64_t i;
+        for (i = 0; i < run->nfences; i++) {
+            elem_set (idx, raw[j] + i * idx->elemsize, &run->fences[i]);
+            run->fences[i].run = j;
+            run->fences[i].idx = fence_pos (run->n, i);
+        }
+    }
+    idx->have_nvalid = (idx->domain != SORTED_DOMAIN_REAL);
+    ok = 1;
+
+done:
+    if (raw) {
+        for (j = 0; j < (idx ? idx->nruns : 0); j++)
+            free (raw[j]);
+    }
+    free (raw);
+    common_read_free_varinfo (vv);
+    common_read_free_varinfo (pv);
+    common_read_free_varinfo (fv);
+    if (!ok) {
+        query_sorted_free (idx);
+        return NULL;
+    }
+    return idx;
+}
+
+static void schedule_range (QUERY_SORTED_INDEX *idx, int varid, uint64_t start, uint64_t count, void *data)
+{
+    ADIOS_SELECTION *sel = a2sel_boundingbox (1, &start, &count);
+    common_read_schedule_read_byid (idx->ixf, sel, varid, 0, 1, NULL, data);
+    a2sel_free (sel);
+}
+
+static int perform_reads (QUERY_SORTED_INDEX *idx)
+{
+    if (common_read_perform_reads (idx->ixf, 1) != 0)
+        return (adios_errno ? adios_errno : err_invalid_read_method);
+    return 0;
+}
+
+
+/*
+ * Bounds of a value in the runs
+ */
+
+enum SORTED_BOUND {
+    SORTED_LOWER,   // the first value not less than the key
+    SORTED_UPPER,   // the first value greater than the key
+    SORTED_VALID    // the first NaN
+};
+
+/* Check if value 'e' is before bound 'b' of 'key' */
+static int before_bound (enum SORTED_DOMAIN dom, enum SORTED_BOUND b, const SORTED_ELEM *key, const SORTED_ELEM *e)
+{
+    if (b == SORTED_VALID)
+        return !elem_is_nan (dom, e);
+    int c = elem_cmp (dom, e, key);
+    return (b == SORTED_LOWER ? c < 0 : c <= 0);
+}
+
+/* First fence of a run that is not before the bound */
+static uint64_t fence_bound (enum SORTED_DOMAIN dom, const SORTED_RUN *run,
+                             enum SORTED_BOUND b, const SORTED_ELEM *key)
+{
+    uint64_t lo = 0, hi = run->nfences;
+    while (lo < hi) {
+        uint64_t mid = lo + (hi - lo) / 2;
+        if (before_bound (dom, b, key, &run->fences[mid]))
+            lo = mid + 1;
+        else
+            hi = mid;
+    }
+    return lo;
+}
+
+/* Find bound 'b' of 'key' in every run: pos[j] is the number of values
+   of run j before the bound. Reads less than QUERY_SORTED_FENCE values
+   of each run whose fences do not decide it. */
+static int find_bounds (QUERY_SORTED_INDEX *idx, enum SORTED_BOUND b, const SORTED_ELEM *key, uint64_t *pos)
+{
+    char **win = (char **) calloc (idx->nruns ? idx->nruns : 1, sizeof(char *));
+    uint64_t *wfirst = (uint64_t *) calloc (idx->nruns ? idx->nruns : 1, sizeof(uint64_t));
+    int j, nscheduled = 0, err = 0;
+
+    if (!win || !wfirst) {
+        adios_error (err_no_memory, "%s: cannot allocate memory for the sorted index of %s\n",
+                __func__, idx->name);
+        free (win);
+        free (wfirst);
+        return err_no_memory;
+    }
+
+    for (j = 0; j < idx->nruns && !err; j++)
+    {
+        const SORTED_RUN *run = &idx->runs[j];
+        if (b == SORTED_VALID && idx->domain != SORTED_DOMAIN_REAL) {
+            pos[j] = run->n;
+            continue;
+        }
+        uint64_t i = fence_bound (idx->domain, run, b, key);
+        if (i == run->nfences) {
+            pos[j] = run->n;
+            continue;
+        }
+        if (i == 0) {
+            pos[j] = 0;
+            continue;
+        }
+        // the bound is after fence i-1, at fence i at the latest
+        wfirst[j] = fence_pos (run->n, i - 1) + 1;
+        pos[j] = fence_pos (run->n, i);
+        if (pos[j] > wfirst[j]) {
+            win[j] = (char *) malloc ((pos[j] - wfirst[j]) * idx->elemsize);
+            if (!win[j]) {
+                adios_error (err_no_memory, "%s: cannot allocate memory for the sorted index of %s\n",
+                        __func__, idx->name);
+                err = err_no_memory;
+                break;
+            }
+            schedule_range (idx, idx->values_id, run->start + wfirst[j], pos[j] - wfirst[j], win[j]);
+            nscheduled++;
+        }
+    }
+    if (nscheduled) {
+        // the scheduled reads are performed even after an error, before freeing their buffers
+        int rerr = perform_reads (idx);
+        if (!err)
+            err = rerr;
+    }
+
+    for (j = 0; j < idx->nruns; j++)
+    {
+        if (!win[j])
+            continue;
+        if (!err) {
+            uint64_t lo = 0, hi = pos[j] - wfirst[j];
+            while (lo < hi) {
+                uint64_t mid = lo + (hi - lo) / 2;
+                SORTED_ELEM e;
+                elem_set (idx, win[j] + mid * idx->elemsize, &e);
+                if (before_bound (idx->domain, b, key, &e))
+                    lo = mid + 1;
+                else
+                    hi = mid;
+            }
+            pos[j] = wfirst[j] + lo;
+        }
+        free (win[j]);
+    }
+    free (win);
+    free (wfirst);
+    return err;
+}
+
+/* Count the values that are not NaN in every run */
+static int load_nvalid (QUERY_SORTED_INDEX *idx)
+{
+    uint64_t *pos;
+    int j, err;
+
+    if (idx->have_nvalid)
+        return 0;
+    pos = (uint64_t *) malloc ((idx->nruns ? idx->nruns : 1) * sizeof(uint64_t));
+    if (!pos) {
+        adios_error (err_no_memory, "%s: cannot allocate memory for the sorted index of %s\n",
+                __func__, idx->name);
+        return err_no_memory;
+    }
+    err = find_bounds (idx, SORTED_VALID, NULL, pos);
+    if (!err) {
+        for (j = 0; j < idx->nruns; j++)
+            idx->runs[j].nvalid = pos[j];
+        idx->have_nvalid = 1;
+    }
+    free (pos);
+    return err;
+}
+
+
+/*
+ * Range conditions
+ */
+
+typedef struct {
+    uint64_t first;     // offset in the index arrays
+    uint64_t n;
+} SORTED_RANGE;
+
+/* Set the bits of the positions in the box */
+static void set_position_bits (const QUERY_SORTED_INDEX *idx, const uint64_t *positions, uint64_t n,
+                               const uint64_t *start, const uint64_t *count, int whole, uint64_t *bits)
+{
+    uint64_t i, c[SORTED_MAX_DIMS];
+    int d;
+
+    for (i = 0; i < n; i++)
+    {
+        uint64_t p = positions[i], e = 0;
+        if (p >= idx->nelements)
+            continue;
+        if (!whole) {
+            for (d = idx->ndim - 1; d >= 0; d--) {
+                c[d] = p % idx->dims[d];
+                p /= idx->dims[d];
+            }
+            for (d = 0; d < idx->ndim; d++) {
+                if (c[d] < start[d] || c[d] >= start[d] + count[d])
+                    break;
+                e = e * count[d] + (c[d] - start[d]);
+            }
+            if (d < idx->ndim)
+                continue;
+            p = e;
+        }
+        bits[p >> 6] |= (uint64_t) 1 << (p & 63);
+    }
+}
+
+/* Read the positions of the ranges in batches of at most SORTED_READ_BYTES and set their bits */
+static int read_range_positions (QUERY_SORTED_INDEX *idx, const SORTED_RANGE *ranges, int nranges,
+                                 const uint64_t *start, const uint64_t *count, int whole,
+                                 uint64_t *bits, uint64_t *nread)
+{
+    const uint64_t maxn = SORTED_READ_BYTES / sizeof(uint64_t);
+    uint64_t total = 0, bufn, done = 0;
+    uint64_t *buf;
+    int k, err = 0;
+
+    for (k = 0; k < nranges; k++)
+        total += ranges[k].n;
+    *nread = total;
+    if (!total)
+        return 0;
+
+    bufn = (total < maxn ? total : maxn);
+    buf = (uint64_t *) malloc (bufn * sizeof(uint64_t));
+    if (!buf) {
+        adios_error (err_no_memory, "%s: cannot allocate memory to read %" PRIu64 " positions\n",
+                __func__, bufn);
+        return err_no_memory;
+    }
+
+    k = 0;
+    while (k < nranges && !err)
+    {
+        uint64_t n = 0;
+        // fill the buffer with (parts of) the next ranges
+        while (k < nranges && n < bufn) {
+            uint64_t m = ranges[k].n - done;
+            if (m > bufn - n)
+                m = bufn - n;
+            if (m)
+                schedule_range (idx, idx->positions_id, ranges[k].first + done, m, buf + n);
+            n += m;
+            done += m;
+            if (done == ranges[k].n) {
+                k++;
+                done = 0;
+            }
+        }
+        err = perform_reads (idx);
+        if (!err)
+            set_position_bits (idx, buf, n, start, count, whole, bits);
+    }
+    free (buf);
+    return err;
+}
+
+int query_sorted_evaluate (QUERY_SORTED_INDEX *idx, enum ADIOS_PREDICATE_MODE op, const char *value,
+                           int ndim, const uint64_t *start, const uint64_t *count, uint64_t *bits)
+{
+    uint64_t *lower = NULL, *upper = NULL, nread = 0;
+    SORTED_RANGE *ranges = NULL;
+    SORTED_ELEM key;
+    int j, d, nranges = 0, whole = 1, err = 0;
+
+    if (ndim != idx->ndim) {
+        adios_error (err_incompatible_queries, "%s: the selection of %s has %d dimensions "
+                "instead of %d\n", __func__, idx->name, ndim, idx->ndim);
+        return err_incompatible_queries;
+    }
+    for (d = 0; d < ndim; d++) {
+        if (start[d] != 0 || count[d] != idx->dims[d])
+            whole = 0;
+    }
+
+    elem_parse (idx, value, &key);
+    if (elem_is_nan (idx->domain, &key) && op != ADIOS_NE)
+        return 0; // nothing compares to NaN
+
+    lower = (uint64_t *) malloc ((idx->nruns ? idx->nruns : 1) * sizeof(uint64_t));
+    upper = (uint64_t *) malloc ((idx->nruns ? idx->nruns : 1) * sizeof(uint64_t));
+    ranges = (SORTED_RANGE *) malloc ((idx->nruns ? 2 * idx->nruns : 1) * sizeof(SORTED_RANGE));
+    if (!lower || !upper || !ranges) {
+        adios_error (err_no_memory, "%s: cannot allocate memory for the sorted index of %s\n",
+                __func__, idx->name);
+        err = err_no_memory;
+        goto done;
+    }
+
+    // lower[j], upper[j]: the range of run j where the condition holds
+    // (and where it does not, for NE)
+    if (elem_is_nan (idx->domain, &key)) {
+        for (j = 0; j < idx->nruns; j++) {
+            lower[j] = upper[j] = idx->runs[j].n;
+        }
+    } else {
+        switch (op)
+        {
+            case ADIOS_LT:
+            case ADIOS_LTEQ:
+                memset (lower, 0, idx->nruns * sizeof(uint64_t));
+                err = find_bounds (idx, (op == ADIOS_LT ? SORTED_LOWER : SORTED_UPPER), &key, upper);
+                break;
+            case ADIOS_GT:
+            case ADIOS_GTEQ:
+                err = find_bounds (idx, (op == ADIOS_GT ? SORTED_UPPER : SORTED_LOWER), &key, lower);
+                if (!err)
+                    err = find_bounds (idx, SORTED_VALID, NULL, upper);
+                break;
+            case ADIOS_EQ:
+            case ADIOS_NE:
+                err = find_bounds (idx, SORTED_LOWER, &key, lower);
+                if (!err)
+                    err = find_bounds (idx, SORTED_UPPER, &key, upper);
+                break;
+            default:
+                goto done;
+        }
+    }
+    if (err)
+        goto done;
+
+    for (j = 0; j < idx->nruns; j++)
+    {
+        const SORTED_RUN *run = &idx->runs[j];
+        if (op == ADIOS_NE) {
+            if (lower[j] > 0) {
+                ranges[nranges].first = run->start;
+                ranges[nranges++].n = lower[j];
+            }
+            if (upper[j] < run->n) {
+                ranges[nranges].first = run->start + upper[j];
+                ranges[nranges++].n = run->n - upper[j];
+            }
+        } else if (upper[j] > lower[j]) {
+            ranges[nranges].first = run->start + lower[j];
+            ranges[nranges++].n = upper[j] - lower[j];
+        }
+    }
+    err = read_range_positions (idx, ranges, nranges, start, count, whole, bits, &nread);
+    log_debug ("%s: %s: %d runs, %" PRIu64 " of %" PRIu64 " positions read\n",
+            __func__, idx->name, idx->nruns, nread, idx->nelements);
+
+done:
+    free (lower);
+    free (upper);
+    free (ranges);
+    return err;
+}
+
+
+/*
+ * Top-k and quantiles
+ */
+
+/* Select a value of rank 'r' (0-based) among the non-NaN values of all runs,
+   and where it is. The fences bound the number of values less than a value v:
+   in a run, at most the position of the first fence >= v, and at least the
+   position after the last fence < v. The value of rank r is between the last
+   fence 'lo' that surely has at most r values less than it, and the first
+   fence 'hi' that surely has more than r values not greater than it. Only the
+   values of the runs between those two fences are read and sorted. */
+static int select_rank (QUERY_SORTED_INDEX *idx, uint64_t r, SORTED_ELEM *out)
+{
+    enum SORTED_DOMAIN dom = idx->domain;
+    SORTED_ELEM *cand = NULL, *win = NULL;
+    uint64_t *first = NULL, *last = NULL;
+    char **raw = NULL;
+    uint64_t ncand = 0, nwin = 0, below = 0, i, a, b, lo, hi;
+    int j, err = 0;
+
+    for (j = 0; j < idx->nruns; j++)
+        ncand += idx->runs[j].nfences;
+    cand = (SORTED_ELEM *) malloc ((ncand ? ncand : 1) * sizeof(SORTED_ELEM));
+    first = (uint64_t *) malloc ((idx->nruns ? idx->nruns : 1) * sizeof(uint64_t));
+    last = (uint64_t *) malloc ((idx->nruns ? idx->nruns : 1) * sizeof(uint64_t));
+    raw = (char **) calloc (idx->nruns ? idx->nruns : 1, sizeof(char *));
+    if (!cand || !first || !last || !raw) {
+        err = err_no_memory;
+        goto done;
+    }
+
+    // the fences that are values (not NaN), in order
+    ncand = 0;
+    for (j = 0; j < idx->nruns; j++) {
+        for (i = 0; i < idx->runs[j].nfences; i++) {
+            if (!elem_is_nan (dom, &idx->runs[j].fences[i]))
+                cand[ncand++] = idx->runs[j].fences[i];
+        }
+    }
+    sort_elems (dom, cand, ncand);
+
+    // lo: the last candidate with at most r values less than it for sure
+    a = 0;
+    b = ncand;
+    while (a < b) {
+        uint64_t mid = a + (b - a) / 2, nless = 0;
+        for (j = 0; j < idx->nruns; j++) {
+            const SORTED_RUN *run = &idx->runs[j];
+            i = fence_bound (dom, run, SORTED_LOWER, &cand[mid]);
+            nless += (i == run->nfences || fence_pos (run->n, i) > run->nvalid ?
+                      run->nvalid : fence_pos (run->n, i));
+        }
+        if (nless <= r)
+            a = mid + 1;
+        else
+            b = mid;
+    }
+    lo = a; // lo-1 is the candidate, none if lo is 0
+
+    // hi: the first candidate with more than r values not greater than it for sure
+    a = 0;
+    b = ncand;
+    while (a < b) {
+        uint64_t mid = a + (b - a) / 2, nle = 0;
+        for (j = 0; j < idx->nruns; j++) {
+            const SORTED_RUN *run = &idx->runs[j];
+            i = fence_bound (dom, run, SORTED_UPPER, &cand[mid]);
+            nle += (i ? fence_pos (run->n, i - 1) + 1 : 0);
+        }
+        if (nle <= r)
+            a = mid + 1;
+        else
+            b = mid;
+    }
+    hi = a; // none if hi is ncand
+
+    // the part of each run between lo and hi
+    for (j = 0; j < idx->nruns; j++)
+    {
+        const SORTED_RUN *run = &idx->runs[j];
+        first[j] = 0;
+        last[j] = run->nvalid;
+        if (lo > 0) {
+            i = fence_bound (dom, run, SORTED_LOWER, &cand[lo-1]);
+            first[j] = (i ? fence_pos (run->n, i - 1) + 1 : 0);
+        }
+        if (hi < ncand) {
+            i = fence_bound (dom, run, SORTED_UPPER, &cand[hi]);
+            if (i < run->nfences && fence_pos (run->n, i) < last[j])
+                last[j] = fence_pos (run->n, i);
+        }
+        if (first[j] > last[j])
+            first[j] = last[j];
+        below += first[j];
+        nwin += last[j] - first[j];
+        if (last[j] > first[j]) {
+            raw[j] = (char *) malloc ((last[j] - first[j]) * idx->elemsize);
+            if (!raw[j]) {
+                err = err_no_memory;
+                goto done;
+            }
+        }
+    }
+    if (r < below || r - below >= nwin) {
+        adios_error (err_invalid_query_value, "%s: the sorted index of %s is not consistent\n",
+                __func__, idx->name);
+        err = err_invalid_query_value;
+        goto done;
+    }
+    for (j = 0; j < idx->nruns; j++) {
+        if (raw[j])
+            schedule_range (idx, idx->values_id, idx->runs[j].start + first[j], last[j] - first[j], raw[j]);
+    }
+    err = perform_reads (idx);
+    if (err)
+        goto done;
+
+    win = (SORTED_ELEM *) malloc (nwin * sizeof(SORTED_ELEM));
+    if (!win) {
+        err = err_no_memory;
+        goto done;
+    }
+    nwin = 0;
+    for (j = 0; j < idx->nruns; j++) {
+        for (i = first[j]; i < last[j]; i++, nwin++) {
+            elem_set (idx, raw[j] + (i - first[j]) * idx->elemsize, &win[nwin]);
+            win[nwin].run = j;
+            win[nwin].idx = i;
+        }
+    }
+    sort_elems (dom, win, nwin);
+    *out = win[r - below];
+    log_debug ("%s: %s: rank %" PRIu64 " found reading %" PRIu64 " values\n",
+            __func__, idx->name, r, nwin);
+
+done:
+    if (err == err_no_memory)
+        adios_error (err_no_memory, "%s: cannot allocate memory for the sorted index of %s\n",
+                __func__, idx->name);
+    if (raw) {
+        for (j = 0; j < idx->nruns; j++)
+            free (raw[j]);
+    }
+    free (raw);
+    free (cand);
+    free (first);
+    free (last);
+    free (win);
+    return err;
+}
+
+/* Coordinates of a position, in the caller's dimension order */
+static void position_to_point (const QUERY_SORTED_INDEX *idx, uint64_t p, int Corder, uint64_t *point)
+{
+    int d;
+    for (d = idx->ndim - 1; d >= 0; d--) {
+        point[Corder ? d : idx->ndim - 1 - d] = p % idx->dims[d];
+        p /= idx->dims[d];
+    }
+}
+
+/* Allocate the points and values of 'npoints' hits in 'result' */
+static int alloc_result (QUERY_SORTED_INDEX *idx, uint64_t npoints, ADIOS_QUERY_VALUES *result)
+{
+    result->ndim = idx->ndim;
+    result->npoints = npoints;
+    result->nvars = 1;
+    result->types = (enum ADIOS_DATATYPES *) malloc (sizeof(enum ADIOS_DATATYPES));
+    result->values = (void **) calloc (1, sizeof(void *));
+    if (result->types)
+        result->types[0] = idx->type;
+    if (npoints) {
+        result->points = (uint64_t *) malloc (npoints * idx->ndim * sizeof(uint64_t));
+        if (result->values)
+            result->values[0] = malloc (npoints * idx->elemsize);
+    }
+    if (!result->types || !result->values || (npoints && (!result->points || !result->values[0]))) {
+        adios_error (err_no_memory, "%s: cannot allocate memory for %" PRIu64 " values of %s\n",
+                __func__, npoints, idx->name);
+        return err_no_memory;
+    }
+    return 0;
+}
+
+int query_sorted_topk (QUERY_SORTED_INDEX *idx, uint64_t k, int largest, ADIOS_QUERY_VALUES *result)
+{
+    const int Corder = !futils_is_called_from_fortran();
+    uint64_t *lower = NULL, *upper = NULL, *from = NULL, *to = NULL, *positions = NULL;
+    SORTED_ELEM *elems = NULL;
+    char *values = NULL;
+    uint64_t nvalid = 0, taken = 0, ties, i, n;
+    SORTED_ELEM t;
+    int j, err;
+
+    err = load_nvalid (idx);
+    if (err)
+        return err;
+    for (j = 0; j < idx->nruns; j++)
+        nvalid += idx->runs[j].nvalid;
+    if (k > nvalid)
+        k = nvalid;
+    err = alloc_result (idx, k, result);
+    if (err || !k)
+        return err;
+
+    err = select_rank (idx, (largest ? nvalid - k : k - 1), &t);
+    if (err)
+        return err;
+
+    lower = (uint64_t *) malloc (idx->nruns * sizeof(uint64_t));
+    upper = (uint64_t *) malloc (idx->nruns * sizeof(uint64_t));
+    from = (uint64_t *) malloc (idx->nruns * sizeof(uint64_t));
+    to = (uint64_t *) malloc (idx->nruns * sizeof(uint64_t));
+    positions = (uint64_t *) malloc (k * sizeof(uint64_t));
+    values = (char *) malloc (k * idx->elemsize);
+    elems = (SORTED_ELEM *) malloc (k * sizeof(SORTED_ELEM));
+    if (!lower || !upper || !from || !to || !positions || !values || !elems) {
+        adios_error (err_no_memory, "%s: cannot allocate memory for %" PRIu64 " values of %s\n",
+                __func__, k, idx->name);
+        err = err_no_memory;
+        goto done;
+    }
+    err = find_bounds (idx, SORTED_LOWER, &t, lower);
+    if (!err)
+        err = find_bounds (idx, SORTED_UPPER, &t, upper);
+    if (err)
+        goto done;
+
+    // all values beyond t, and as many values equal to t as needed
+    for (j = 0; j < idx->nruns; j++)
+        taken += (largest ? idx->runs[j].nvalid - upper[j] : lower[j]);
+    ties = k - taken;
+    for (j = 0; j < idx->nruns; j++)
+    {
+        uint64_t m = upper[j] - lower[j];
+        if (m > ties)
+            m = ties;
+        ties -= m;
+        from[j] = (largest ? upper[j] - m : 0);
+        to[j] = (largest ? idx->runs[j].nvalid : lower[j] + m);
+    }
+
+    n = 0;
+    for (j = 0; j < idx->nruns; j++)
+        n += to[j] - from[j];
+    if (n != k) {
+        adios_error (err_invalid_query_value, "%s: the sorted index of %s is not consistent\n",
+                __func__, idx->name);
+        err = err_invalid_query_value;
+        goto done;
+    }
+    n = 0;
+    for (j = 0; j < idx->nruns; j++) {
+        if (to[j] > from[j]) {
+            schedule_range (idx, idx->values_id, idx->runs[j].start + from[j], to[j] - from[j],
+                            values + n * idx->elemsize);
+            schedule_range (idx, idx->positions_id, idx->runs[j].start + from[j], to[j] - from[j],
+                            positions + n);
+            n += to[j] - from[j];
+        }
+    }
+    err = perform_reads (idx);
+    if (err)
+        goto done;
+
+    // order by value, then by position
+    for (i = 0; i < k; i++) {
+        elem_set (idx, values + i * idx->elemsize, &elems[i]);
+        elems[i].run = 0;
+        elems[i].idx = positions[i];
+    }
+    sort_elems (idx->domain, elems, k);
+    for (i = 0; i < k; i++) {
+        const SORTED_ELEM *e = &elems[largest ? k - 1 - i : i];
+        elem_get (idx, e, (char *) result->values[0] + i * idx->elemsize);
+        position_to_point (idx, e->idx, Corder, result->points + i * idx->ndim);
+    }
+
+done:
+    free (lower);
+    free (upper);
+    free (from);
+    free (to);
+    free (positions);
+    free (values);
+    free (elems);
+    return err;
+}
+
+int query_sorted_quantile (QUERY_SORTED_INDEX *idx, double fraction, ADIOS_QUERY_VALUES *result)
+{
+    const int Corder = !futils_is_called_from_fortran();
+    uint64_t nvalid = 0, position;
+    SORTED_ELEM t;
+    int j, err;
+
+    err = load_nvalid (idx);
+    if (err)
+        return err;
+    for (j = 0; j < idx->nruns; j++)
+        nvalid += idx->runs[j].nvalid;
+    err = alloc_result (idx, (nvalid ? 1 : 0), result);
+    if (err || !nvalid)
+        return err;
+
+    err = select_rank (idx, (uint64_t) floor (fraction * (nvalid - 1)), &t);
+    if (err)
+        return err;
+    schedule_range (idx, idx->positions_id, idx->runs[t.run].start + t.idx, 1, &position);
+    err = perform_reads (idx);
+    if (err)
+        return err;
+
+    elem_get (idx, &t, result->values[0]);
+    position_to_point (idx, position, Corder, result->points);
+    return 0;
+}
@@ -0,0 +1,94 @@
+#ifndef __QUERY_SORTED_H__
+#define __QUERY_SORTED_H__
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdint.h>
+#include <stddef.h>
+#include "public/adios_types.h"
+#include "public/adios_query.h"
+
+/*
+ * Sorted (value, position) secondary index, column-store style.
+ *
+ * The index of foo.bp is the companion file foo.sidx, built by the
+ * adios_index_sorted utility for chosen variables and steps. For variable V
+ * at step s it holds three 1D global arrays named QUERY_SORTED_PATH/s/V/...:
+ *
+ *   values     the elements of V, the elements of each writeblock sorted
+ *              separately (a run) and written as one block; NaN values last
+ *   positions  uint64_t, the offset of each value in the whole array V
+ *              (in C order), in the same layout as values
+ *   fences     every QUERY_SORTED_FENCE-th value of each run and its last
+ *              value, one block per run
+ *
+ * Empty writeblocks have no run. A bound of a value in a run is found by a
+ * binary search in the fences and reading less than QUERY_SORTED_FENCE
+ * values of the run; the matching values and positions are then read
+ * sequentially. The index file has a single step.
+ */
+
+#define QUERY_SORTED_PATH  "/__adios__/sorted"
+#define QUERY_SORTED_FENCE 1024
+
+/* Name of the index file of a BP file: foo.bp -> foo.sidx (newly allocated) */
+char * query_sorted_index_file_name (const char *bpFileName);
+
+/* Full name of the index array 'what' ("values", "positions" or "fences")
+   of variable 'varName' at 'timestep' */
+void query_sorted_var_name (char *name, size_t len, const char *varName, int timestep, const char *what);
+
+/* Check if variables of this type can be indexed */
+int query_sorted_supports_type (enum ADIOS_DATATYPES type);
+
+/* Number of fences of a run of n values */
+uint64_t query_sorted_nfences (uint64_t n);
+
+/* Turn the block at 'start' of size 'count' of an 'ndim' dimensional array of
+   size 'dims' (all in C order) into a run: 'data' is sorted in place,
+   'positions' (one per element) and 'fences' (query_sorted_nfences()
+   values) are filled in. Returns 0, or err_no_memory. */
+int query_sorted_build_run (enum ADIOS_DATATYPES type, int ndim, const uint64_t *dims,
+                            const uint64_t *start, const uint64_t *count,
+                            void *data, uint64_t *positions, void *fences);
+
+
+/* The index of one variable at one timestep, opened from the index file of a file */
+typedef struct QUERY_SORTED_INDEX QUERY_SORTED_INDEX;
+
+/* Check if variable 'varName' of 'f' has a sorted index at 'timestep'
+   (at any step if timestep < 0) */
+int query_sorted_has_index (ADIOS_FILE *f, const char *varName, int timestep);
+
+/* Open the index of variable 'v' at 'timestep' and read its fences. Returns
+   NULL if there is no index that matches the variable, or on error (adios_errno
+   is set then). */
+QUERY_SORTED_INDEX * query_sorted_open (ADIOS_FILE *f, const char *varName,
+                                        ADIOS_VARINFO *v, int timestep);
+
+void query_sorted_free (QUERY_SORTED_INDEX *idx);
+
+/* Set the bits of the elements of the box at 'start' of size 'count' (C order,
+   one bit per element of the box in 'bits') where the condition 'op value' holds */
+int query_sorted_evaluate (QUERY_SORTED_INDEX *idx, enum ADIOS_PREDICATE_MODE op, const char *value,
+                           int ndim, const uint64_t *start, const uint64_t *count, uint64_t *bits);
+
+/* Fill 'result' with the k smallest (or largest) values of the index and their
+   coordinates, the extreme value first. NaN values are not included.
+   Returns 0, or the error code. */
+int query_sorted_topk (QUERY_SORTED_INDEX *idx, uint64_t k, int largest, ADIOS_QUERY_VALUES *result);
+
+/* Fill 'result' with the value at 'fraction' (0..1) of the sorted non-NaN
+   values and its coordinates. Returns 0, or the error code. */
+int query_sorted_quantile (QUERY_SORTED_INDEX *idx, double fraction, ADIOS_QUERY_VALUES *result);
+
+/* Close the index file opened for 'f' */
+void query_sorted_file_closed (const ADIOS_FILE *f);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __QUERY_SORTED_H__ */
@@ -7,8 +7,12 @@
 #include <inttypes.h>
 #include <assert.h>
 
+#include "public/adios_error.h"
 #include "core/common_read.h"
 #include "core/adios_logger.h"
+#include "core/a2sel.h"
+#include "core/util.h"
+#include "query_utils.h"
 
 int query_utils_getGlobalWriteBlockId(int idxRelativeToTimeStep, int timeStep, ADIOS_VARINFO* v) 
 {
@@ -26,6 +30,100 @@ int query_utils_getGlobalWriteBlockId(int idxRelativeToTimeStep, int timeStep, A
 }
 
 
+int query_utils_find_companion_var (const ADIOS_FILE *f, const char *prefix, const char *varName)
+{
+    const char *name = (varName[0] == '/' ? varName + 1 : varName);
+    size_t plen;
+    int i;
+
+    if (prefix[0] == '/')
+        prefix++;
+    plen = strlen (prefix);
+    for (i = 0; i < f->nvars; i++) {
+        const char *v = f->var_namelist[i];
+        if (v[0] == '/')
+            v++;
+        if (!strncmp (v, prefix, plen) && v[plen] == '/' && !strcmp (v + plen + 1, name))
+            return i;
+    }
+    return -1;
+}
+
+ADIOS_VARINFO * query_utils_inq_companion_var (ADIOS_FILE *f, const char *prefix,
+                                               const char *varName, ADIOS_VARINFO *v, int timestep)
+{
+    ADIOS_VARINFO *cv;
+    int id = query_utils_find_companion_var (f, prefix, varName);
+    if (id < 0)
+        return NULL;
+
+    cv = common_read_inq_var_byid (f, id);
+    if (cv && (cv->nsteps != v->nsteps || cv->nblocks[timestep] != v->nblocks[timestep]))
+    {
+        log_debug ("%s: %s of %s does not match its blocks\n", __func__, prefix, varName);
+        common_read_free_varinfo (cv);
+        return NULL;
+    }
+    if (cv && !cv->blockinfo)
+        common_read_inq_var_blockinfo (f, cv);
+    if (cv && !cv->blockinfo) {
+        common_read_free_varinfo (cv);
+        return NULL;
+    }
+    return cv;
+}
+
+void * query_utils_schedule_companion_block (ADIOS_FILE *f, ADIOS_VARINFO *cv, int timestep,
+                                             int block, uint64_t *size)
+{
+    int i, start = 0;
+    char *data;
+    ADIOS_SELECTION *sel;
+
+    for (i = 0; i < timestep; i++)
+        start += cv->nblocks[i];
+    *size = cv->blockinfo[start + block].count[0];
+    if (!*size)
+        return NULL;
+
+    data = (char *) malloc (*size);
+    if (!data) {
+        adios_error (err_no_memory, "%s: cannot allocate %" PRIu64 " bytes to read "
+                "a block of %s\n", __func__, *size, f->var_namelist[cv->varid]);
+        *size = 0;
+        return NULL;
+    }
+    sel = a2sel_writeblock (block);
+    common_read_schedule_read_byid (f, sel, cv->varid, timestep, 1, NULL, data);
+    a2sel_free (sel);
+    return data;
+}
+
+
+/*
+ * Thread pool for the CPU work of query evaluation (comparing and decoding
+ * blocks that have been read). Reading stays with the calling thread, the
+ * read layer is not thread safe.
+ */
+
+static int query_threads = 1;
+
+void query_utils_set_threads (int nthreads)
+{
+    query_threads = (nthreads <= 0 ? adios_util_ncpus() : nthreads);
+}
+
+int query_utils_get_threads (void)
+{
+    return query_threads;
+}
+
+void query_utils_run_tasks (int ntasks, QUERY_TASK_FN fn, void *arg)
+{
+    adios_util_run_tasks (ntasks, query_threads, fn, arg);
+}
+
+
 int query_utils_file_exists (char * path)
 {
     struct stat sb;
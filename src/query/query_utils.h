@@ -15,6 +15,32 @@ extern "C" {
 int query_utils_getGlobalWriteBlockId(int idxRelativeToTimeStep, int timeStep, ADIOS_VARINFO* v);
 
 
+/* Find the hidden variable written under 'prefix' with the blocks of variable
+   'varName' (e.g. its bitmap index or zone map). Return its id, -1 if none */
+int query_utils_find_companion_var (const ADIOS_FILE *f, const char *prefix, const char *varName);
+
+/* Inquire the hidden variable written under 'prefix' with the blocks of variable
+   'v', with its block info. Return NULL if there is none, or if its blocks do not
+   correspond one to one to the blocks of 'v' at 'timestep' */
+ADIOS_VARINFO * query_utils_inq_companion_var (ADIOS_FILE *f, const char *prefix,
+                                               const char *varName, ADIOS_VARINFO *v, int timestep);
+
+/* Schedule reading block 'block' (relative to 'timestep') of the hidden variable 'cv'
+   into a newly allocated buffer, returned with its size. Returns NULL if the block
+   is empty or on error (adios_errno is set then). */
+void * query_utils_schedule_companion_block (ADIOS_FILE *f, ADIOS_VARINFO *cv, int timestep,
+                                             int block, uint64_t *size);
+
+/* Number of threads the query methods may use (see adios_query_set_threads),
+   nthreads <= 0 means one per CPU */
+void query_utils_set_threads (int nthreads);
+int query_utils_get_threads (void);
+
+/* Run fn(arg, task) for every task in [0, ntasks) on up to query_utils_get_threads()
+   threads, the calling one included. Tasks must not read or schedule reads. */
+typedef void (*QUERY_TASK_FN) (void *arg, int task);
+void query_utils_run_tasks (int ntasks, QUERY_TASK_FN fn, void *arg);
+
 /* Return 1 if path exists on the file system, 0 otherwise */
 int query_utils_file_exists (char * path);
 
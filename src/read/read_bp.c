@@ -15,6 +15,7 @@
 #include <math.h>
 #include <assert.h>
 #include <errno.h>
+#include <sys/stat.h>
 #include "public/adios_read.h"
 #include "public/adios_error.h"
 #include "public/adios_types.h"
@@ -39,6 +40,7 @@
 
 static int chunk_buffer_size = 1024*1024*16;
 static int poll_interval_msec = 10000; // 10 secs by default
+static int min_poll_interval_msec = 100; // first wait when following a file
 static int show_hidden_attrs = 0; // don't show hidden attr by default
 
 static ADIOS_VARCHUNK * read_var_bb  (const ADIOS_FILE * fp, read_request * r);
@@ -325,45 +327,73 @@ static BP_FILE * open_file (const char * fname, MPI_Comm comm)
     return fh;
 }
 
-/* This routine set ADIOS_FILE fields from BP_FILE struct */
-void build_ADIOS_FILE_struct (ADIOS_FILE * fp, BP_FILE * fh)
+/* This routine replaces the BP_FILE of an opened stream with a newly opened
+ * one (that has more steps in it) and updates the ADIOS_FILE fields.
+ * The BP_PROC struct, i.e. the read request list etc., is kept.
+ */
+static void switch_BP_FILE (ADIOS_FILE * fp, BP_FILE * new_fh)
 {
-    BP_PROC * p;
-    int rank;
+    BP_PROC * p = GET_BP_PROC (fp);
 
-    log_debug ("build_ADIOS_FILE_struct is called\n");
+    log_debug ("switch_BP_FILE is called\n");
 
-    MPI_Comm_rank (fh->comm, &rank);
+    if (p->fh)
+    {
+        bp_close (p->fh);
+    }
+    p->fh = new_fh;
 
-    p = (BP_PROC *) malloc (sizeof (BP_PROC));
-    assert (p);
-    p->fh = fh;
-    p->streaming = 1;
-    p->varid_mapping = 0;
-    p->local_read_request_list = 0;
-    p->b = 0;
-    p->priv = 0;
+    fp->file_size = new_fh->mfooter.file_size;
+    fp->version = new_fh->mfooter.version & ADIOS_VERSION_NUM_MASK;
+    fp->endianness = bp_get_endianness (new_fh->mfooter.change_endianness);
+    /* For file, the last step is tidx_stop */
+    fp->last_step = new_fh->tidx_stop - new_fh->tidx_start;
 
-    fp->fh = (uint64_t) p;
-    fp->file_size = fh->mfooter.file_size;
-    fp->version = fh->mfooter.version & ADIOS_VERSION_NUM_MASK;
-    fp->endianness = bp_get_endianness (fh->mfooter.change_endianness);
-    fp->last_step = fh->tidx_stop - 1;
+    return;
+}
 
-    /* Seek to the initial step. */
-    release_step (fp);
-    bp_seek_to_step (fp, 0, show_hidden_attrs);
+/* Returns the size of the file as seen by rank 0, 0 if it does not exist.
+ * A stat() is much cheaper than opening the file and parsing its footer,
+ * so it is used to detect if the writer has appended anything at all.
+ */
+static uint64_t get_file_size_rootonly (const char * fname, MPI_Comm comm)
+{
+    int rank;
+    uint64_t file_size = 0;
+    struct stat st;
 
-    /* For file, the last step is tidx_stop */
-    fp->last_step = fh->tidx_stop - 1;
+    MPI_Comm_rank (comm, &rank);
 
-    return;
+    if (rank == 0)
+    {
+        if (!stat (fname, &st))
+        {
+            file_size = (uint64_t) st.st_size;
+        }
+    }
+
+    MPI_Bcast (&file_size, 1, MPI_UNSIGNED_LONG_LONG, 0, comm);
+
+    return file_size;
 }
 
-static int get_new_step (ADIOS_FILE * fp, const char * fname, MPI_Comm comm, int last_tidx, float timeout_sec)
+/* Follow the file being appended by a writer until it has more steps than
+ * last_tidx or the timeout expires. The currently opened BP_FILE stays valid
+ * until new steps are found, then it is replaced with the new one.
+ * The file is only re-opened and its footer re-parsed if its size has
+ * changed since the last look. The wait between two checks starts at
+ * min_poll_interval_msec and is doubled up to poll_interval_msec while
+ * nothing happens to the file.
+ */
+static int get_new_step (ADIOS_FILE * fp, int last_tidx, float timeout_sec)
 {
+    BP_FILE * fh = GET_BP_FILE (fp);
     BP_FILE * new_fh;
     double t1 = adios_gettime_double();
+    uint64_t last_size = fh->mfooter.file_size;
+    uint64_t file_size;
+    int wait_msec = (min_poll_interval_msec < poll_interval_msec ?
+                     min_poll_interval_msec : poll_interval_msec);
 
     log_debug ("enter get_new_step\n");
     /* First check if the file has been updated with more steps. */
@@ -377,25 +407,39 @@ static int get_new_step (ADIOS_FILE * fp, const char * fname, MPI_Comm comm, int
 
     while (stay_in_poll_loop)
     {
-        /* Re-open the file */
-        new_fh = open_file (fname, comm);
-        if (!new_fh)
-        {
-            // file is bad so keeps polling.
-            stay_in_poll_loop = 1;
-        }
-        else if (new_fh && new_fh->tidx_stop == last_tidx)
+        file_size = get_file_size_rootonly (fh->fname, fh->comm);
+        if (file_size == last_size)
         {
-            // file is good but no new steps in it. Continue polling.
-            bp_close (new_fh);
+            // nothing has been written since the last look. Continue polling.
             stay_in_poll_loop = 1;
         }
         else
         {
-            // the file looks good and there are new steps written.
-            build_ADIOS_FILE_struct (fp, new_fh);
-            stay_in_poll_loop = 0;
-            found_stream = 1;
+            // the writer is active, so look again soon
+            wait_msec = (min_poll_interval_msec < poll_interval_msec ?
+                         min_poll_interval_msec : poll_interval_msec);
+
+            /* Re-open the file */
+            new_fh = open_file (fh->fname, fh->comm);
+            if (!new_fh)
+            {
+                // file is bad (footer is being written) so keeps polling.
+                stay_in_poll_loop = 1;
+            }
+            else if (new_fh->tidx_stop == last_tidx)
+            {
+                // file is good but no new steps in it. Continue polling.
+                last_size = file_size;
+                bp_close (new_fh);
+                stay_in_poll_loop = 1;
+            }
+            else
+            {
+                // the file looks good and there are new steps written.
+                switch_BP_FILE (fp, new_fh);
+                stay_in_poll_loop = 0;
+                found_stream = 1;
+            }
         }
         // check if we need to stay in loop
         if (stay_in_poll_loop)
@@ -404,10 +448,6 @@ static int get_new_step (ADIOS_FILE * fp, const char * fname, MPI_Comm comm, int
             {
                 stay_in_poll_loop = 0;
             }
-            else if (timeout_sec < 0.0)
-            {
-                stay_in_poll_loop = 1;
-            }
             else if (timeout_sec > 0.0 && (adios_gettime_double () - t1 > timeout_sec))
             {
                 log_debug ("Time is out in get_new_step()\n");
@@ -415,8 +455,13 @@ static int get_new_step (ADIOS_FILE * fp, const char * fname, MPI_Comm comm, int
             }
             else
             {
-                adios_nanosleep (poll_interval_msec/1000,
-                    (int)(((uint64_t)poll_interval_msec * 1000000L)%1000000000L));
+                adios_nanosleep (wait_msec/1000,
+                    (int)(((uint64_t)wait_msec * 1000000L)%1000000000L));
+                wait_msec *= 2;
+                if (wait_msec > poll_interval_msec)
+                {
+                    wait_msec = poll_interval_msec;
+                }
             }
         }
 
@@ -1564,6 +1609,22 @@ int adios_read_bp_init_method (MPI_Comm comm, PairStruct * params)
                             "read method: '%s'\n", p->value);
             }
         }
+        else if (!strcasecmp (p->name, "min_poll_interval"))
+        {
+            errno = 0;
+            pollinterval = strtol(p->value, NULL, 10);
+            if (pollinterval > 0 && !errno)
+            {
+                log_debug ("min_poll_interval set to %d msecs for READ_BP read method\n",
+                            pollinterval);
+                min_poll_interval_msec = pollinterval;
+            }
+            else
+            {
+                log_error ("Invalid 'min_poll_interval' parameter given to the READ_BP "
+                            "read method: '%s'\n", p->value);
+            }
+        }
         else if (!strcasecmp (p->name, "show_hidden_attrs"))
         {
             show_hidden_attrs = 1;
@@ -1582,6 +1643,7 @@ int adios_read_bp_finalize_method ()
     /* Set these back to default */
     chunk_buffer_size = 1024*1024*16;
     poll_interval_msec = 10000; // 10 secs by default
+    min_poll_interval_msec = 100;
     show_hidden_attrs = 0; // don't show hidden attr by default
 
     return 0;
@@ -1849,11 +1911,10 @@ int adios_read_bp_close (ADIOS_FILE * fp)
 }
 
 /* Since we have no way to know that the end of the stream has been reached, we cannot
- * block the call and expect new step will arrive. Therefore, if last == 0, we simply sleep
- * for a specified period of time and re-open the file to see if there is any new steps came in.
- * The trick is that when step is being advanced, it is likely that file has
- * already being appended with new steps. Therefore, we have to close and reopen
- * the file if the expected step is not found.
+ * block the call and expect new step will arrive. Therefore, if the expected step is
+ * not in the file yet, we follow the file (see get_new_step) until new steps came in
+ * or the timeout expires. The currently opened file remains usable if no new
+ * step has arrived.
  * last - 0: next available step, !=0: newest available step
  *  RETURN: 0 OK, !=0 on error (also sets adios_errno)
  *
@@ -1865,15 +1926,10 @@ int adios_read_bp_close (ADIOS_FILE * fp)
  */
 int adios_read_bp_advance_step (ADIOS_FILE * fp, int last, float timeout_sec)
 {
-    BP_PROC * p = GET_BP_PROC (fp);
     BP_FILE * fh = GET_BP_FILE (fp);
-    int last_tidx;
-    MPI_Comm comm;
-    char * fname;
 
     log_debug ("adios_read_bp_advance_step\n");
 
-    //TODO: this part of code needs to cleaned up a bit. Some if-else branches can be merged. Q.Liu
     adios_errno = 0;
     if (last == 0) // read in the next step
     {
@@ -1882,56 +1938,29 @@ int adios_read_bp_advance_step (ADIOS_FILE * fp, int last, float timeout_sec)
             release_step (fp);
             bp_seek_to_step (fp, ++fp->current_step, show_hidden_attrs);
         }
-        else // re-open to read in footer again. We should keep polling until there are new steps in OR
-             // time out.
+        else // follow the file until there are new steps in OR time out.
         {
-            last_tidx = fh->tidx_stop;
-            fname = strdup (fh->fname);
-            comm = fh->comm;
-
-            if (p->fh)
-            {
-                bp_close (fh);
-                p->fh = 0;
-            }
-
-            if (!get_new_step (fp, fname, comm, last_tidx, timeout_sec))
+            if (!get_new_step (fp, fh->tidx_stop, timeout_sec))
             {
                 // With file reading, how can we tell it is the end of the streams?
                 adios_errno = err_step_notready;
             }
-
-            free (fname);
-
-            if (adios_errno == 0)
+            else
             {
                 release_step (fp);
-                bp_seek_to_step (fp, fp->last_step + 1, show_hidden_attrs);
-                fp->current_step = fp->last_step + 1;
+                bp_seek_to_step (fp, ++fp->current_step, show_hidden_attrs);
             }
         }
     }
-    else // read in newest step. Re-open no matter whether current_step < last_step
+    else // read in newest step. Look for new steps no matter whether current_step < last_step
     {
-        last_tidx = fh->tidx_stop;
-        fname = strdup (fh->fname);
-        comm = fh->comm;
-
-        if (p->fh)
-        {
-            bp_close (fh);
-            p->fh = 0;
-        }
-
         // lockmode is currently not supported.
-        if (!get_new_step (fp, fh->fname, fh->comm, last_tidx, timeout_sec))
+        if (!get_new_step (fp, fh->tidx_stop, timeout_sec)
+            && fp->current_step == fp->last_step)
         {
             adios_errno = err_step_notready;
         }
-
-        free (fname);
-
-        if (adios_errno == 0)
+        else
         {
             release_step (fp);
             bp_seek_to_step (fp, fp->last_step, show_hidden_attrs);
@@ -2002,6 +2031,7 @@ typedef struct {
             double *    breaks;
             uint32_t ** frequencies;
             uint32_t *  gfrequencies;
+            uint32_t ** bfrequencies;
         } *histogram;
 
 } ADIOS_VARSTAT;
@@ -2169,32 +2199,35 @@ typedef struct {
             }
         }
     }
-/*
-    if (map[adios_statistic_hist] != -1 && (var_root->characteristics[0].stats[0][map[adios_statistic_hist]].data))
+    if (map[adios_statistic_hist] != -1 && var_root->characteristics[from_ch].stats &&
+        var_root->characteristics[from_ch].stats[0][map[adios_statistic_hist]].data)
     {
-        struct adios_index_characteristics_stat_struct * stats = var_root->characteristics[0].stats[0];
-        struct adios_index_characteristics_hist_struct * hist = stats[map[adios_statistic_hist]].data;
-        int num_breaks = hist->num_breaks;
+        // the break points are the same in every block
+        struct adios_index_characteristics_hist_struct * hist =
+            var_root->characteristics[from_ch].stats[0][map[adios_statistic_hist]].data;
+        uint32_t num_breaks = hist->num_breaks;
+
+        MALLOC(vs->histogram, sizeof(struct ADIOS_HIST), "histogram")
+        vs->histogram->num_breaks = num_breaks;
+        vs->histogram->min = hist->min;
+        vs->histogram->max = hist->max;
+        vs->histogram->frequencies = NULL;
+        vs->histogram->bfrequencies = NULL;
+        MALLOC(vs->histogram->breaks, num_breaks * sizeof(double), "break points of histogram")
+        memcpy(vs->histogram->breaks, hist->breaks, num_breaks * sizeof(double));
+        CALLOC(vs->histogram->gfrequencies, num_breaks + 1, sizeof(uint32_t), "global frequencies of histogram")
 
-        MALLOC(vi->hist, sizeof(struct ADIOS_HIST), "histogram");
-        MALLOC(vi->hist->breaks, num_breaks * sizeof(double), "break points of histogram");
-        MALLOC(vi->hist->gfrequencies, (num_breaks + 1) * sizeof(uint32_t), "global frequencies of histogram");
-
-        vi->hist->num_breaks = hist->num_breaks;
-        vi->hist->min = hist->min;
-        vi->hist->max = hist->max;
-
-        memcpy(vi->hist->breaks, hist->breaks, num_breaks * sizeof(double));
-        CALLOC(vi->hist->gfrequencies, (num_breaks + 1), bp_get_type_size(adios_unsigned_integer, ""), "global frequency");
-
-        if (ntimes > 0)
-        {
-            MALLOC(vi->hist->frequenciess, (ntimes * sizeof(int32_t *)), "frequencies for timesteps");
-            for(i = 0; i < ntimes; i++)
-                CALLOC(vi->hist->frequenciess[i], (num_breaks + 1), bp_get_type_size(adios_unsigned_integer, ""), "frequency at timestep");
+        if (per_step_stat) {
+            MALLOC(vs->histogram->frequencies, nsteps * sizeof(uint32_t *), "frequencies per timestep")
+            for (i = 0; i < nsteps; i++)
+                CALLOC(vs->histogram->frequencies[i], num_breaks + 1, sizeof(uint32_t), "frequencies of a timestep")
+        }
+        if (per_block_stat) {
+            MALLOC(vs->histogram->bfrequencies, nb * sizeof(uint32_t *), "frequencies per writeblock")
+            for (i = 0; i < nb; i++)
+                CALLOC(vs->histogram->bfrequencies[i], num_breaks + 1, sizeof(uint32_t), "frequencies of a writeblock")
         }
     }
-*/
     enum ADIOS_DATATYPES original_var_type = var_root->type;
 
     if (var_root->characteristics[from_ch].transform.transform_type != adios_transform_none) {
@@ -2692,19 +2725,22 @@ typedef struct {
                     }
                 }
             }
-//TODO
-/*
-            if(map[adios_statistic_hist] != -1 && stats[map[adios_statistic_hist]].data)
+            if (vs->histogram && stats[map[adios_statistic_hist]].data)
             {
-                for(j = 0; j <= vi->hist->num_breaks; j++)
+                struct adios_index_characteristics_hist_struct * hist = stats[map[adios_statistic_hist]].data;
+                if (hist->num_breaks == vs->histogram->num_breaks)
                 {
-                    uint32_t freq = hist->frequencies[j];
-                    vi->hist->gfrequencies[j] += freq;
-                    if (ntimes > 0)
-                        vi->hist->frequenciess[tidx][j] += freq;
+                    for (j = 0; j <= hist->num_breaks; j++)
+                    {
+                        uint32_t freq = hist->frequencies[j];
+                        vs->histogram->gfrequencies[j] += freq;
+                        if (per_step_stat)
+                            vs->histogram->frequencies[tidx][j] += freq;
+                        if (per_block_stat)
+                            vs->histogram->bfrequencies[idx][j] = freq;
+                    }
                 }
             }
-*/
             if (map[adios_statistic_cnt] != -1 && stats[map[adios_statistic_cnt]].data)
             {
                 if (per_step_stat) {
@@ -3007,6 +3043,66 @@ int adios_read_bp_inq_var_blockinfo (const ADIOS_FILE * fp, ADIOS_VARINFO * vari
 
 }
 
+/* Copy the scalar values of steps from_steps..from_steps+nsteps-1 directly
+ * from the var characteristics, without any read requests.
+ * The characteristics are ordered by time, so one pass over them is enough.
+ */
+int adios_read_bp_inq_var_scalar_steps (const ADIOS_FILE *fp, const ADIOS_VARINFO * varinfo,
+                                        int from_steps, int nsteps, int all_blocks, void * data)
+{
+    BP_FILE * fh = GET_BP_FILE (fp);
+    struct adios_index_var_struct_v1 * v;
+    int64_t i, start_idx;
+    int time, prev_time, step, size;
+    char * p = (char *) data;
+
+    adios_errno = 0;
+
+    int mapped_id = map_req_varid (fp, varinfo->varid);
+    v = bp_find_var_byid (fh, mapped_id);
+    assert (v);
+
+    if (v->type == adios_string || !v->characteristics_count || !v->characteristics[0].value)
+    {
+        adios_error (err_operation_not_supported, 
+                     "Variable %s is not a numeric scalar, its values cannot be "
+                     "returned from the metadata\n", v->var_name);
+        return adios_errno;
+    }
+
+    time = adios_step_to_time_v1 (fp, v, from_steps);
+    start_idx = get_var_start_index (v, time);
+    if (start_idx < 0)
+    {
+        adios_error (err_no_data_at_timestep, "Variable %s has no data at step %d\n",
+                     v->var_name, from_steps);
+        return adios_errno;
+    }
+
+    size = bp_get_type_size (v->type, v->characteristics[start_idx].value);
+    prev_time = time;
+    step = 0;
+    for (i = start_idx; i < v->characteristics_count; i++)
+    {
+        if (v->characteristics[i].time_index != prev_time)
+        {
+            step++;
+            if (step == nsteps)
+                break;
+            prev_time = v->characteristics[i].time_index;
+        }
+        else if (!all_blocks && i != start_idx)
+        {
+            continue; // only the first block of each step
+        }
+
+        memcpy (p, v->characteristics[i].value, size);
+        p += size;
+    }
+
+    return 0;
+}
+
 // NCSU ALACRITY-ADIOS - Adding an inq function to get the new transform metadata from storage
 ADIOS_TRANSINFO * adios_read_bp_inq_var_transinfo(const ADIOS_FILE *fp, const ADIOS_VARINFO *vi) {
     BP_FILE * fh = GET_BP_FILE (fp);
@@ -2152,6 +2152,7 @@ ADIOS_FILE * adios_read_bp_staged_open_file (const char * fname, MPI_Comm comm)
     fh->vars_root = 0;
     fh->attrs_root = 0;
     fh->vars_table = 0;
+    fh->strtbl = 0;
     fh->b = malloc (sizeof (struct adios_bp_buffer_struct_v1));
     assert (fh->b);
     adios_buffer_struct_init (fh->b);
@@ -2295,6 +2296,12 @@ int adios_read_bp_staged_inq_var_blockinfo (const ADIOS_FILE *fp, ADIOS_VARINFO
     return 0;
 }
 
+int adios_read_bp_staged_inq_var_scalar_steps (const ADIOS_FILE *fp, const ADIOS_VARINFO * varinfo,
+                                               int from_steps, int nsteps, int all_blocks, void * data)
+{
+    return adios_read_bp_inq_var_scalar_steps (fp, varinfo, from_steps, nsteps, all_blocks, data);
+}
+
 int adios_read_bp_staged_schedule_read_byid (const ADIOS_FILE * fp,
                                              const ADIOS_SELECTION * sel,
                                              int varid,
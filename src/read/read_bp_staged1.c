@@ -85,6 +85,11 @@ int adios_read_bp_staged1_inq_var_blockinfo (const ADIOS_FILE *fp, ADIOS_VARINFO
     return 0;
 }
 
+int adios_read_bp_staged1_inq_var_scalar_steps (const ADIOS_FILE *fp, const ADIOS_VARINFO * varinfo, int from_steps, int nsteps, int all_blocks, void * data)
+{
+    return 0;
+}
+
 int adios_read_bp_staged1_schedule_read_byid (const ADIOS_FILE * fp, const ADIOS_SELECTION * sel, int varid, int from_steps, int nsteps, void * data)
 {
     return 0;
@@ -4073,6 +4078,7 @@ ADIOS_FILE * adios_read_bp_staged1_fopen (const char * fname, MPI_Comm comm)
     fh->pgs_root = 0;
     fh->vars_root = 0;
     fh->attrs_root = 0;
+    fh->strtbl = 0;
     fh->b = malloc (sizeof (struct adios_bp_buffer_struct_v1));
     assert (fh->b);
 
@@ -4277,12 +4283,10 @@ int adios_read_bp_staged1_fclose (ADIOS_FILE *fp)
 
         if (vr->characteristics) 
             free (vr->characteristics);
-        if (vr->group_name) 
-            free (vr->group_name);
+        BP_FREE_INDEX_STRING (fh, vr->group_name)
         if (vr->var_name) 
             free (vr->var_name);
-        if (vr->var_path) 
-            free (vr->var_path);
+        BP_FREE_INDEX_STRING (fh, vr->var_path)
         free(vr);
     }
 
@@ -4298,12 +4302,10 @@ int adios_read_bp_staged1_fclose (ADIOS_FILE *fp)
         }
         if (ar->characteristics) 
             free (ar->characteristics);
-        if (ar->group_name) 
-            free (ar->group_name);
+        BP_FREE_INDEX_STRING (fh, ar->group_name)
         if (ar->attr_name) 
             free (ar->attr_name);
-        if (ar->attr_path) 
-            free (ar->attr_path);
+        BP_FREE_INDEX_STRING (fh, ar->attr_path)
         free(ar);
     }
 
@@ -4315,13 +4317,14 @@ int adios_read_bp_staged1_fclose (ADIOS_FILE *fp)
         pr = pgs_root;
         pgs_root = pgs_root->next;
         //printf("%d\tpg pid=%d addr=%x next=%x\n",i, pr->process_id, pr, pr->next);
-        if (pr->group_name)
-            free(pr->group_name);
-        if (pr->time_index_name)
-            free(pr->time_index_name);
+        BP_FREE_INDEX_STRING (fh, pr->group_name)
+        BP_FREE_INDEX_STRING (fh, pr->time_index_name)
         free(pr);
     }
 
+    bp_string_table_free (fh->strtbl);
+    fh->strtbl = 0;
+
     /* Free variable structures in BP_GROUP_VAR */
     if (gh) {
         for (j=0;j<2;j++) { 
@@ -1115,6 +1115,14 @@ int adios_read_dataspaces_inq_var_blockinfo (const ADIOS_FILE *fp, ADIOS_VARINFO
     return 0;
 }
 
+int adios_read_dataspaces_inq_var_scalar_steps (const ADIOS_FILE *fp, const ADIOS_VARINFO * varinfo,
+                                                int from_steps, int nsteps, int all_blocks, void * data)
+{
+    adios_error (err_operation_not_supported, "DataSpaces does not support reading scalars over steps "
+                 "from the metadata, use adios_schedule_read() instead.\n");
+    return adios_errno;
+}
+
 int adios_read_dataspaces_inq_var_trans_blockinfo(const ADIOS_FILE *gp, const ADIOS_VARINFO *vi, ADIOS_TRANSINFO *ti)
 {
     adios_error(err_operation_not_supported, "DataSpaces does not yet support transforms: trans_blockinfo.\n");
@@ -2195,6 +2195,18 @@ adios_read_flexpath_inq_var_blockinfo(const ADIOS_FILE* fp,
 				      ADIOS_VARINFO* varinfo)
 { /*log_debug( "flexpath:adios function inq var block info\n");*/ return 0; }
 
+int
+adios_read_flexpath_inq_var_scalar_steps(const ADIOS_FILE* fp,
+					 const ADIOS_VARINFO* varinfo,
+					 int from_steps,
+					 int nsteps,
+					 int all_blocks,
+					 void* data)
+{
+    adios_error(err_operation_not_supported, "Flexpath does not support reading scalars over steps from the metadata.\n");
+    return adios_errno;
+}
+
 int
 adios_read_flexpath_inq_var_stat(const ADIOS_FILE* fp,
 				 ADIOS_VARINFO* varinfo,
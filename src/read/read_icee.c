@@ -1249,6 +1249,18 @@ adios_read_icee_inq_var_blockinfo(const ADIOS_FILE* fp,
     return 0;
 }
 
+int
+adios_read_icee_inq_var_scalar_steps(const ADIOS_FILE* fp,
+                                     const ADIOS_VARINFO* varinfo,
+                                     int from_steps,
+                                     int nsteps,
+                                     int all_blocks,
+                                     void* data)
+{
+    adios_error(err_operation_not_supported, "No support yet: %s\n", __FUNCTION__);
+    return adios_errno;
+}
+
 int
 adios_read_icee_inq_var_stat(const ADIOS_FILE* fp,
                              ADIOS_VARINFO* varinfo,
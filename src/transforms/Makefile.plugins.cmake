@@ -33,3 +33,19 @@ set(transforms_read_method_SOURCES ${transforms_read_method_SOURCES} transforms/
 # LZ4 plugin:
 set(transforms_write_method_SOURCES ${transforms_write_method_SOURCES} transforms/adios_transform_lz4_write.c)
 set(transforms_read_method_SOURCES ${transforms_read_method_SOURCES} transforms/adios_transform_lz4_read.c)
+
+# Pipeline (chained transforms) plugin:
+set(transforms_write_method_SOURCES ${transforms_write_method_SOURCES} transforms/adios_transform_pipeline_write.c)
+set(transforms_read_method_SOURCES ${transforms_read_method_SOURCES} transforms/adios_transform_pipeline_read.c)
+
+# Shuffle plugin:
+set(transforms_write_method_SOURCES ${transforms_write_method_SOURCES} transforms/adios_transform_shuffle_write.c)
+set(transforms_read_method_SOURCES ${transforms_read_method_SOURCES} transforms/adios_transform_shuffle_read.c)
+
+# Automatic (per-block) transform selection plugin:
+set(transforms_write_method_SOURCES ${transforms_write_method_SOURCES} transforms/adios_transform_auto_write.c)
+set(transforms_read_method_SOURCES ${transforms_read_method_SOURCES} transforms/adios_transform_auto_read.c)
+
+# Lossless predictive floating-point compression plugin:
+set(transforms_write_method_SOURCES ${transforms_write_method_SOURCES} transforms/adios_transform_fpred_write.c)
+set(transforms_read_method_SOURCES ${transforms_read_method_SOURCES} transforms/adios_transform_fpred_read.c)
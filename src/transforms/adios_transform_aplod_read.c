@@ -1,12 +1,45 @@
 #include <stdlib.h>
 #include <stdint.h>
 #include <stdio.h>
+#include <string.h>
 #include <assert.h>
 
 #include "util.h"
+#include "core/adios_logger.h"
 #include "core/transforms/adios_transforms_hooks_read.h"
 #include "core/transforms/adios_transforms_reqgroup.h"
 #include "core/adios_internals.h" // adios_get_type_size()
+#include "adios_transform_aplod_read.h"
+
+int adios_transform_aplod_components_to_read(const char *read_param, int num_components, const int32_t *components)
+{
+    int i, n, bytes;
+    char *end;
+
+    if (!read_param || !*read_param)
+        return num_components;
+
+    if (!strncmp(read_param, "bytes=", 6)) {
+        bytes = strtol(read_param + 6, &end, 10);
+        if (*end || bytes <= 0) {
+            log_warn("Invalid APLOD read parameter '%s', reading at full precision\n", read_param);
+            return num_components;
+        }
+        n = 0;
+        for (i = 0; i < num_components && bytes > 0; i++) {
+            bytes -= components[i];
+            n++;
+        }
+        return n;
+    }
+
+    n = strtol(read_param, &end, 10);
+    if (*end || n <= 0) {
+        log_warn("Invalid APLOD read parameter '%s', reading at full precision\n", read_param);
+        return num_components;
+    }
+    return n < num_components ? n : num_components;
+}
 
 #ifdef APLOD
 
@@ -54,11 +87,7 @@ int adios_transform_aplod_generate_read_subrequests(adios_transform_read_request
     aplod_meta_t aplodmeta;
     parse_aplod_meta(pg_reqgroup->transform_metadata, &aplodmeta);
 
-    int numComponentsToUse;
-    if (!reqgroup->read_param || strcmp(reqgroup->read_param, "") == 0)
-        numComponentsToUse = aplodmeta.numComponents;
-    else
-        numComponentsToUse = atoi(reqgroup->read_param);
+    int numComponentsToUse = adios_transform_aplod_components_to_read(reqgroup->read_param, aplodmeta.numComponents, aplodmeta.components);
 
     assert(numComponentsToUse > 0);
     int totalComponentsSize = 0;
@@ -141,7 +170,8 @@ adios_datablock * adios_transform_aplod_pg_reqgroup_completed(adios_transform_re
 
     uint32_t numElements = arm->numElements;
     uint64_t decompressed_len = numElements * elementSize;
-    void* decompressed_buff = malloc (decompressed_len);
+    // The bytes of the components not read must come back as zero
+    void* decompressed_buff = calloc (decompressed_len, 1);
 
     aplod_meta_t aplodmeta;
     parse_aplod_meta(completed_pg_reqgroup->transform_metadata, &aplodmeta);
@@ -0,0 +1,30 @@
+/*
+ * adios_transform_aplod_read.h
+ *
+ * Read parameter handling of the APLOD transform, kept out of the APLOD
+ * library dependent code so that it can be tested on its own.
+ */
+
+#ifndef ADIOS_TRANSFORM_APLOD_READ_H_
+#define ADIOS_TRANSFORM_APLOD_READ_H_
+
+#include <stdint.h>
+
+/*
+ * Determines how many of the byte components (most significant first) of an
+ * APLOD variable to read from the read parameter given to
+ * adios_schedule_read_param():
+ *   NULL or ""   all components (full precision)
+ *   "bytes=N"    the fewest leading components holding at least N bytes of
+ *                each value
+ *   "N"          the first N components
+ * Invalid parameters are warned about and read at full precision. The bytes
+ * of the components not read are zero in the values returned.
+ * @param read_param the read parameter
+ * @param num_components the number of components the variable was written with
+ * @param components the size of each component in bytes
+ * @return the number of components to read, between 1 and num_components
+ */
+int adios_transform_aplod_components_to_read(const char *read_param, int num_components, const int32_t *components);
+
+#endif /* ADIOS_TRANSFORM_APLOD_READ_H_ */
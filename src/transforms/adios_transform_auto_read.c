@@ -0,0 +1,40 @@
+/*
+ * adios_transform_auto_read.c
+ *
+ * Read side of the "auto" transform (see adios_transform_auto_write.c). Every
+ * block's metadata is the pipeline metadata of the chain chosen for that
+ * block, so each block is undone by the pipeline read hooks, which dispatch
+ * on the transforms it names.
+ */
+
+#include "core/transforms/adios_transforms_common.h"
+#include "core/transforms/adios_transforms_hooks_read.h"
+#include "core/transforms/adios_transforms_reqgroup.h"
+
+DECLARE_TRANSFORM_READ_METHOD(pipeline)
+
+int adios_transform_auto_is_implemented (void) {return 1;}
+
+int adios_transform_auto_generate_read_subrequests(adios_transform_read_request *reqgroup,
+                                                   adios_transform_pg_read_request *pg_reqgroup)
+{
+    return adios_transform_pipeline_generate_read_subrequests(reqgroup, pg_reqgroup);
+}
+
+adios_datablock * adios_transform_auto_subrequest_completed(adios_transform_read_request *reqgroup,
+                                                            adios_transform_pg_read_request *pg_reqgroup,
+                                                            adios_transform_raw_read_request *completed_subreq)
+{
+    return adios_transform_pipeline_subrequest_completed(reqgroup, pg_reqgroup, completed_subreq);
+}
+
+adios_datablock * adios_transform_auto_pg_reqgroup_completed(adios_transform_read_request *reqgroup,
+                                                             adios_transform_pg_read_request *completed_pg_reqgroup)
+{
+    return adios_transform_pipeline_pg_reqgroup_completed(reqgroup, completed_pg_reqgroup);
+}
+
+adios_datablock * adios_transform_auto_reqgroup_completed(adios_transform_read_request *completed_reqgroup)
+{
+    return adios_transform_pipeline_reqgroup_completed(completed_reqgroup);
+}
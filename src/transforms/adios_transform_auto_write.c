@@ -0,0 +1,442 @@
+/*
+ * adios_transform_auto_write.c
+ *
+ * The "auto" transform picks a transform for every block at write time. A
+ * sample of the block is run through each candidate transform, and the
+ * candidate with the best compression ratio whose measured throughput meets
+ * the requested floor is then applied to the whole block. Parameters:
+ *
+ *   min_throughput=<MB/s>  only consider candidates at least this fast on the
+ *                          sample (default 0, i.e., pick the best ratio)
+ *   accuracy=<abs. error>  also consider the lossy compressors (zfp, sz) for
+ *                          real and double variables, within this error bound
+ *   candidates=<list>      '/'-separated candidates, each a transform (with
+ *                          optional ':' parameters) or a '+'-separated chain
+ *                          of them, e.g. "identity/lz4:lvl=9/shuffle:bit+zlib"
+ *
+ * Each candidate is run as a pipeline (a single transform being a one-stage
+ * pipeline), so the block's metadata is the chosen chain's pipeline metadata
+ * (see adios_transforms_common.h), padded to the size of the largest
+ * candidate. The read side then simply undoes whatever chain each block names.
+ */
+
+#include <stdint.h>
+#include <inttypes.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <assert.h>
+#include <math.h>
+
+#include "core/adios_logger.h"
+#include "core/adios_internals.h"
+#include "core/adios_clock.h"
+#include "core/transforms/adios_transforms_common.h"
+#include "core/transforms/adios_transforms_write.h"
+#include "core/transforms/adios_transforms_hooks.h"
+#include "core/transforms/adios_transforms_hooks_write.h"
+#include "core/transforms/adios_transforms_specparse.h"
+
+DECLARE_TRANSFORM_WRITE_METHOD(pipeline)
+
+#define AUTO_MAX_CANDIDATES 16
+#define AUTO_MAX_CANDIDATE_STR 256
+
+// Blocks up to this size are sampled whole; larger ones through
+// AUTO_SAMPLE_CHUNKS evenly spaced chunks of AUTO_SAMPLE_CHUNK_SIZE bytes
+#define AUTO_SAMPLE_CHUNKS 4
+#define AUTO_SAMPLE_CHUNK_SIZE (16 * 1024)
+
+// A candidate must improve on the best ratio so far by this factor to be
+// preferred over the faster candidates listed before it
+#define AUTO_MIN_RATIO_GAIN 1.01
+
+struct auto_params {
+    double min_throughput; // MB/s
+    const char *accuracy;  // NULL if lossy compression is not allowed
+    int ncandidates;
+    struct adios_transform_spec candidates[AUTO_MAX_CANDIDATES];
+    int lossy[AUTO_MAX_CANDIDATES];
+    int float_only[AUTO_MAX_CANDIDATES];
+};
+
+// Whether a transform can be used as (part of) an auto candidate in this build
+static int is_available_for_auto(enum ADIOS_TRANSFORM_TYPE type, int *is_lossy, int *is_float_only)
+{
+    *is_lossy = 0;
+    *is_float_only = adios_transform_is_float_only(type);
+    switch (type) {
+    case adios_transform_identity:
+    case adios_transform_shuffle:
+    case adios_transform_fpred:
+        return 1;
+#ifdef ZLIB
+    case adios_transform_zlib:
+        return 1;
+#endif
+#ifdef BZIP2
+    case adios_transform_bzip2:
+        return 1;
+#endif
+#ifdef LZ4
+    case adios_transform_lz4:
+        return 1;
+#endif
+#ifdef ZFP
+    case adios_transform_zfp:
+        *is_lossy = 1;
+        return 1;
+#endif
+#ifdef HAVE_SZ
+    case adios_transform_sz:
+        *is_lossy = 1;
+        return 1;
+#endif
+    default:
+        return 0;
+    }
+}
+
+/*
+ * Turns a candidate like "shuffle+zlib" into a pipeline spec ("shuffle|zlib"),
+ * giving the lossy compressors the requested error bound. Returns 0 if the
+ * candidate is not usable in this build or under these parameters.
+ */
+static int add_candidate(struct auto_params *params, const char *candidate, int warn)
+{
+    char chain[AUTO_MAX_CANDIDATE_STR];
+    char *stages = strdup(candidate);
+    char *stage = stages;
+    int len = 0, nstages = 0, lossy = 0, float_only = 0, ok = 1;
+
+    chain[0] = '\0';
+    while (stage && ok) {
+        char *next_stage = strchr(stage, '+');
+        enum ADIOS_TRANSFORM_TYPE type;
+        int stage_lossy, stage_float_only;
+
+        if (next_stage)
+            *next_stage++ = '\0';
+
+        // A stage may carry its own parameters, e.g. "shuffle:bit"
+        {
+            char name[AUTO_MAX_CANDIDATE_STR];
+            snprintf(name, sizeof(name), "%.*s", (int)strcspn(stage, ":"), stage);
+            type = adios_transform_find_type_by_xml_alias(name);
+        }
+        if (!is_available_for_auto(type, &stage_lossy, &stage_float_only) || ++nstages > ADIOS_TRANSFORM_PIPELINE_MAX_STAGES) {
+            ok = 0;
+        } else if (stage_lossy && !params->accuracy) {
+            ok = 0;
+        } else {
+            const char *sep = len ? "|" : "";
+            if (type == adios_transform_zfp)
+                len += snprintf(chain + len, sizeof(chain) - len, "%szfp:accuracy=%s", sep, params->accuracy);
+            else if (type == adios_transform_sz)
+                len += snprintf(chain + len, sizeof(chain) - len, "%ssz:absErrBound=%s", sep, params->accuracy);
+            else
+                len += snprintf(chain + len, sizeof(chain) - len, "%s%s", sep, stage);
+            lossy |= stage_lossy;
+            float_only |= stage_float_only;
+            ok = (len < (int)sizeof(chain));
+        }
+        stage = next_stage;
+    }
+    free(stages);
+
+    if (!ok || params->ncandidates >= AUTO_MAX_CANDIDATES) {
+        if (warn)
+            log_warn("Ignoring auto transform candidate \"%s\": it is not available in this build of ADIOS, "
+                     "needs an accuracy parameter, or exceeds the candidate limits\n", candidate);
+        return 0;
+    }
+
+    struct adios_transform_spec *spec = &params->candidates[params->ncandidates];
+    memset(spec, 0, sizeof(struct adios_transform_spec));
+    spec->transform_type = adios_transform_pipeline;
+    spec->transform_type_str = strdup(chain); // No backing string: freed by adios_transform_clear_spec
+    params->lossy[params->ncandidates] = lossy;
+    params->float_only[params->ncandidates] = float_only;
+    params->ncandidates++;
+    return 1;
+}
+
+// Parameter problems are reported only if warn is set, so that they show up once per variable
+static void parse_auto_params(const struct adios_transform_spec *transform_spec, struct auto_params *params, int warn)
+{
+    const char *candidate_list = NULL;
+    int i;
+
+    memset(params, 0, sizeof(struct auto_params));
+    for (i = 0; i < transform_spec->param_count; i++) {
+        const struct adios_transform_spec_kv_pair *param = &transform_spec->params[i];
+        if (!param->value) {
+            if (warn)
+                log_warn("The auto transform parameter %s needs a value\n", param->key);
+        } else if (!strcmp(param->key, "min_throughput")) {
+            params->min_throughput = atof(param->value);
+        } else if (!strcmp(param->key, "accuracy")) {
+            params->accuracy = param->value;
+        } else if (!strcmp(param->key, "candidates")) {
+            candidate_list = param->value;
+        } else if (warn) {
+            log_warn("An unknown auto transform parameter: %s\n", param->key);
+        }
+    }
+
+    if (candidate_list) {
+        char *list = strdup(candidate_list);
+        char *candidate = list;
+        while (candidate) {
+            char *next_candidate = strchr(candidate, '/');
+            if (next_candidate)
+                *next_candidate++ = '\0';
+            add_candidate(params, candidate, warn);
+            candidate = next_candidate;
+        }
+        free(list);
+    } else {
+        // Defaults, roughly fastest first; unavailable ones are skipped
+        add_candidate(params, "identity", 0);
+        add_candidate(params, "lz4", 0);
+        add_candidate(params, "zlib", 0);
+        add_candidate(params, "shuffle+zlib", 0);
+        add_candidate(params, "fpred", 0);
+        add_candidate(params, "zfp", 0);
+        add_candidate(params, "sz", 0);
+    }
+
+    if (params->ncandidates == 0)
+        add_candidate(params, "identity", 0);
+}
+
+static void clear_auto_params(struct auto_params *params)
+{
+    int i;
+    for (i = 0; i < params->ncandidates; i++)
+        adios_transform_clear_spec(&params->candidates[i]);
+    params->ncandidates = 0;
+}
+
+uint16_t adios_transform_auto_get_metadata_size(struct adios_transform_spec *transform_spec)
+{
+    struct auto_params params;
+    uint16_t size = 0;
+    int i;
+
+    parse_auto_params(transform_spec, &params, 1);
+    for (i = 0; i < params.ncandidates; i++) {
+        const uint16_t candidate_size = adios_transform_pipeline_get_metadata_size(&params.candidates[i]);
+        if (candidate_size > size)
+            size = candidate_size;
+    }
+    clear_auto_params(&params);
+    return size;
+}
+
+void adios_transform_auto_transformed_size_growth(
+        const struct adios_var_struct *var, const struct adios_transform_spec *transform_spec,
+        uint64_t *constant_factor, double *linear_factor, double *capped_linear_factor, uint64_t *capped_linear_cap)
+{
+    struct auto_params params;
+    int i;
+
+    // Any candidate may be chosen, so take the largest bound of them all
+    parse_auto_params(transform_spec, &params, 0);
+    for (i = 0; i < params.ncandidates; i++) {
+        uint64_t c = 0, cap = 0;
+        double l = 1, cl = 0;
+
+        adios_transform_pipeline_transformed_size_growth(var, &params.candidates[i], &c, &l, &cl, &cap);
+        if (c > *constant_factor)
+            *constant_factor = c;
+        if (l + cl > *linear_factor)
+            *linear_factor = l + cl;
+    }
+    clear_auto_params(&params);
+}
+
+// Copies an evenly spaced, element-aligned sample of the block into *sample; returns its size in bytes
+static uint64_t take_sample(const char *data, uint64_t size, uint64_t elem_size, char **sample)
+{
+    const uint64_t chunk_size = AUTO_SAMPLE_CHUNK_SIZE / elem_size * elem_size;
+    const uint64_t nelems = size / elem_size;
+    uint64_t sample_size = 0;
+    int i;
+
+    *sample = (char *)malloc(AUTO_SAMPLE_CHUNKS * chunk_size);
+    if (!*sample)
+        return 0;
+
+    for (i = 0; i < AUTO_SAMPLE_CHUNKS; i++) {
+        const uint64_t start = (nelems * i / AUTO_SAMPLE_CHUNKS) * elem_size;
+        memcpy(*sample + sample_size, data + start, chunk_size);
+        sample_size += chunk_size;
+    }
+    return sample_size;
+}
+
+/*
+ * Runs candidate over the sample held in var->data (with var's type and
+ * dimensions already describing the sample) and reports its compression
+ * ratio and throughput. Returns 0 if the candidate failed.
+ */
+static int try_candidate(struct adios_file_struct *fd, struct adios_var_struct *var,
+                         struct adios_transform_spec *candidate, void *scratch_metadata,
+                         uint64_t sample_size, double *ratio, double *throughput)
+{
+    uint64_t output_len = 0;
+    int wrote_to_shared_buffer = 0;
+    double start, elapsed;
+    int success;
+
+    var->transform_type = adios_transform_pipeline;
+    var->transform_spec = candidate;
+    var->transform_metadata = scratch_metadata;
+    var->transform_metadata_len = adios_transform_pipeline_get_metadata_size(candidate);
+    var->adata = NULL;
+    var->free_data = adios_flag_no;
+
+    start = adios_gettime_double();
+    success = adios_transform_pipeline_apply(fd, var, &output_len, 0, &wrote_to_shared_buffer);
+    elapsed = adios_gettime_double() - start;
+
+    if (var->adata && var->adata != var->data && var->free_data == adios_flag_yes)
+        free(var->adata);
+    var->adata = NULL;
+    var->free_data = adios_flag_no;
+
+    if (!success || output_len == 0)
+        return 0;
+
+    *ratio = (double)sample_size / output_len;
+    *throughput = (elapsed > 0) ? sample_size / elapsed / (1024.0 * 1024.0) : HUGE_VAL;
+    return 1;
+}
+
+int adios_transform_auto_apply(struct adios_file_struct *fd,
+                               struct adios_var_struct *var,
+                               uint64_t *transformed_len,
+                               int use_shared_buffer,
+                               int *wrote_to_shared_buffer)
+{
+    assert(var->transform_type == adios_transform_auto);
+
+    struct auto_params params;
+    const uint64_t input_size = adios_transform_get_pre_transform_var_size(var);
+    const int is_float = (var->pre_transform_type == adios_real || var->pre_transform_type == adios_double);
+    int best = -1, i;
+
+    *wrote_to_shared_buffer = 0;
+    parse_auto_params(var->transform_spec, &params, 0);
+
+    // Some candidates (the lossy ones among them) only apply to floating point data
+    if (!is_float) {
+        int nkept = 0;
+        for (i = 0; i < params.ncandidates; i++) {
+            if (params.float_only[i]) {
+                adios_transform_clear_spec(&params.candidates[i]);
+            } else {
+                params.candidates[nkept] = params.candidates[i];
+                params.lossy[nkept] = params.lossy[i];
+                params.float_only[nkept] = 0;
+                nkept++;
+            }
+        }
+        params.ncandidates = nkept;
+        if (nkept == 0)
+            add_candidate(&params, "identity", 0);
+    }
+
+    // Save the variable fields that the candidates temporarily take over
+    struct adios_transform_spec *auto_spec = var->transform_spec;
+    void *auto_metadata = var->transform_metadata;
+    const uint16_t auto_metadata_len = var->transform_metadata_len;
+    struct adios_dimension_struct *orig_pre_transform_dims = var->pre_transform_dimensions;
+    const void *orig_data = var->data;
+    void *orig_adata = var->adata;
+    const enum ADIOS_FLAG orig_free_data = var->free_data;
+
+    if (params.ncandidates == 1 || input_size == 0) {
+        best = 0;
+    } else {
+        const uint64_t elem_size = adios_get_type_size(var->pre_transform_type, "");
+        const int whole_block = (input_size <= AUTO_SAMPLE_CHUNKS * AUTO_SAMPLE_CHUNK_SIZE || elem_size == 0 ||
+                                 elem_size > AUTO_SAMPLE_CHUNK_SIZE);
+        char *sample = NULL;
+        uint64_t sample_size = input_size;
+        void *scratch_metadata = malloc(auto_metadata_len ? auto_metadata_len : 1);
+        double best_ratio = 0, best_throughput = 0;
+
+        // Larger blocks are sampled as a 1D array of the variable's type
+        struct adios_dimension_struct sample_dim;
+        memset(&sample_dim, 0, sizeof(sample_dim));
+        sample_dim.dimension.is_time_index = adios_flag_no;
+        sample_dim.global_dimension.is_time_index = adios_flag_no;
+        sample_dim.local_offset.is_time_index = adios_flag_no;
+
+        if (!whole_block) {
+            sample_size = take_sample((const char *)orig_data, input_size, elem_size, &sample);
+            if (sample_size) {
+                sample_dim.dimension.rank = sample_size / elem_size;
+                var->pre_transform_dimensions = &sample_dim;
+                var->data = sample;
+            }
+        }
+
+        for (i = 0; i < params.ncandidates && scratch_metadata && sample_size; i++) {
+            double ratio, throughput;
+            if (!try_candidate(fd, var, &params.candidates[i], scratch_metadata, sample_size, &ratio, &throughput))
+                continue;
+
+            log_debug("auto transform: candidate %s on %" PRIu64 " bytes of %s: ratio %.3f, %.1f MB/s\n",
+                      params.candidates[i].transform_type_str, sample_size, var->name, ratio, throughput);
+
+            if (throughput < params.min_throughput)
+                continue;
+            if (best < 0 || ratio > best_ratio * AUTO_MIN_RATIO_GAIN) {
+                best = i;
+                best_ratio = ratio;
+                best_throughput = throughput;
+            }
+        }
+
+        var->transform_type = adios_transform_auto;
+        var->transform_spec = auto_spec;
+        var->transform_metadata = auto_metadata;
+        var->transform_metadata_len = auto_metadata_len;
+        var->pre_transform_dimensions = orig_pre_transform_dims;
+        var->data = orig_data;
+        var->adata = orig_adata;
+        var->free_data = orig_free_data;
+        free(sample);
+        free(scratch_metadata);
+
+        if (best < 0) {
+            // Nothing met the throughput floor; do the cheapest thing possible
+            log_debug("auto transform: no candidate reached %.1f MB/s for %s\n", params.min_throughput, var->name);
+            best = 0;
+        } else {
+            log_debug("auto transform: chose %s for %s (ratio %.3f, %.1f MB/s)\n",
+                      params.candidates[best].transform_type_str, var->name, best_ratio, best_throughput);
+        }
+    }
+
+    // Apply the chosen chain to the whole block, recording it in the block's metadata
+    if (auto_metadata && auto_metadata_len)
+        memset(auto_metadata, 0, auto_metadata_len);
+
+    var->transform_type = adios_transform_pipeline;
+    var->transform_spec = &params.candidates[best];
+    var->transform_metadata_len = adios_transform_pipeline_get_metadata_size(&params.candidates[best]);
+
+    int success = (var->transform_metadata_len <= auto_metadata_len) &&
+                  adios_transform_pipeline_apply(fd, var, transformed_len, use_shared_buffer, wrote_to_shared_buffer);
+
+    var->transform_type = adios_transform_auto;
+    var->transform_spec = auto_spec;
+    var->transform_metadata_len = auto_metadata_len;
+    clear_auto_params(&params);
+
+    return success;
+}
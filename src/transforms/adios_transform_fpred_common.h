@@ -0,0 +1,129 @@
+/*
+ * adios_transform_fpred_common.h
+ *
+ * Layout shared by the write and read sides of the "fpred" transform, a
+ * lossless compressor for float and double data that needs no external
+ * library.
+ *
+ * Every value is first predicted from values already seen:
+ *
+ *   lorenzo:  from its neighbors in the (up to) three fastest varying
+ *             dimensions, by the Lorenzo predictor (the previous value in
+ *             1D, a + b - c in 2D, the 7-point corner rule in 3D). Values
+ *             are mapped to unsigned integers that sort like the floats,
+ *             the prediction is done in that (64-bit) integer space, and
+ *             the residual is the difference (modulo 2^32 for floats),
+ *             zig-zag encoded so that small negative residuals have leading
+ *             zeros too.
+ *   previous: from the previous value in memory; the residual is the XOR of
+ *             the bit patterns of the two values.
+ *
+ * The residuals are then bit-packed in groups of ADIOS_FPRED_GROUP_SIZE: a
+ * byte giving the number of significant bits w of the largest residual in the
+ * group (0 to 64), followed by the residuals, w bits each, least significant
+ * bit first. ADIOS_FPRED_PADDING zero bytes end the stream so the decoder can
+ * always load whole words.
+ *
+ * If the packed stream would not be smaller than the data, the data is
+ * stored as is (predictor "stored").
+ */
+#ifndef ADIOS_TRANSFORM_FPRED_COMMON_H
+#define ADIOS_TRANSFORM_FPRED_COMMON_H
+
+#include <stdint.h>
+#include <string.h>
+
+enum ADIOS_FPRED_PREDICTOR {
+    adios_fpred_stored   = 0,
+    adios_fpred_lorenzo  = 1,
+    adios_fpred_previous = 2
+};
+
+/*
+ * Metadata: original data size (uint64_t) + element size (uint8_t) + predictor (uint8_t) + group size (uint8_t)
+ *           + values per row nx (uint64_t) + rows per plane ny (uint64_t)
+ */
+#define ADIOS_FPRED_METADATA_SIZE (3 * sizeof(uint64_t) + 3 * sizeof(uint8_t))
+
+#define ADIOS_FPRED_GROUP_SIZE 32
+#define ADIOS_FPRED_PADDING 8
+
+/* Residuals are computed and consumed in chunks of this many values (a multiple of the group size) */
+#define ADIOS_FPRED_CHUNK 4096
+
+/* Largest packed size of n values of elem_size bytes, padding included */
+static inline uint64_t adios_fpred_max_packed_size(uint64_t n, unsigned elem_size)
+{
+    return n * elem_size + (n + ADIOS_FPRED_GROUP_SIZE - 1) / ADIOS_FPRED_GROUP_SIZE + ADIOS_FPRED_PADDING;
+}
+
+/*
+ * The Lorenzo predictor works on the three fastest varying dimensions:
+ * nx values per row, ny rows per plane, and nz planes (any slower
+ * dimensions are folded into nz). dims are given slowest first.
+ */
+static inline void adios_fpred_fold_dims(int ndims, const uint64_t *dims, uint64_t *nx, uint64_t *ny, uint64_t *nz)
+{
+    int d;
+    *nx = ndims >= 1 ? dims[ndims - 1] : 1;
+    *ny = ndims >= 2 ? dims[ndims - 2] : 1;
+    *nz = 1;
+    for (d = 0; d < ndims - 2; d++)
+        *nz *= dims[d];
+}
+
+/*
+ * Maps float bit patterns to unsigned integers in the same order as the
+ * floats (negative values are flipped, positive ones get the top bit set).
+ */
+static inline uint32_t adios_fpred_map32(uint32_t u)
+{
+    return u ^ ((uint32_t)((int32_t)u >> 31) | UINT32_C(0x80000000));
+}
+
+static inline uint64_t adios_fpred_map64(uint64_t u)
+{
+    return u ^ ((uint64_t)((int64_t)u >> 63) | UINT64_C(0x8000000000000000));
+}
+
+static inline uint32_t adios_fpred_unmap32(uint32_t m)
+{
+    return m ^ ((uint32_t)((int32_t)~m >> 31) | UINT32_C(0x80000000));
+}
+
+static inline uint64_t adios_fpred_unmap64(uint64_t m)
+{
+    return m ^ ((uint64_t)((int64_t)~m >> 63) | UINT64_C(0x8000000000000000));
+}
+
+/* Zig-zag coding: 0, -1, 1, -2, ... become 0, 1, 2, 3, ... */
+static inline uint64_t adios_fpred_zigzag(uint64_t d)
+{
+    return (d << 1) ^ (uint64_t)((int64_t)d >> 63);
+}
+
+static inline uint64_t adios_fpred_unzigzag(uint64_t z)
+{
+    return (z >> 1) ^ (0 - (z & 1));
+}
+
+/* Unaligned little-endian 64-bit word access */
+static inline uint64_t adios_fpred_load64(const uint8_t *p)
+{
+    uint64_t w;
+    memcpy(&w, p, sizeof(w));
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+    w = __builtin_bswap64(w);
+#endif
+    return w;
+}
+
+static inline void adios_fpred_store64(uint8_t *p, uint64_t w)
+{
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+    w = __builtin_bswap64(w);
+#endif
+    memcpy(p, &w, sizeof(w));
+}
+
+#endif /* ADIOS_TRANSFORM_FPRED_COMMON_H */
@@ -0,0 +1,377 @@
+/*
+ * adios_transform_fpred_read.c
+ *
+ * Read side of the "fpred" transform: unpacks the residuals written by
+ * adios_transform_fpred_write.c and adds the predictions back, using AVX2 or
+ * SSE2 kernels for the Lorenzo prediction when the compiler targets them.
+ */
+
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <assert.h>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+#if defined(__AVX2__)
+#include <immintrin.h>
+#endif
+
+#include "core/util.h"
+#include "core/adios_logger.h"
+#include "core/transforms/adios_transforms_hooks_read.h"
+#include "core/transforms/adios_transforms_reqgroup.h"
+#include "core/adios_internals.h" // adios_get_type_size()
+#include "adios_transform_fpred_common.h"
+
+/*
+ * Lorenzo kernels
+ *
+ * While decoding, the output holds the mapped integers of the values (see
+ * adios_fpred_map64()); they are unmapped once all values are decoded. For
+ * the row a being decoded and its already decoded neighbor rows b, c and d
+ * (as on the write side), t[k - k0] is set to the residual of value k plus
+ * the neighbor part of its prediction, so that a[k] = a[k - 1] + t[k - k0].
+ */
+
+static inline uint64_t load_value(const void *row, uint64_t k, unsigned elem_size)
+{
+    return elem_size == 8 ? ((const uint64_t *)row)[k] : ((const uint32_t *)row)[k];
+}
+
+// row[k] - row[k-1], with row[-1] = 0 and a NULL row being all zeros
+static inline uint64_t value_step(const void *row, uint64_t k, unsigned elem_size)
+{
+    if (!row)
+        return 0;
+    return load_value(row, k, elem_size) - (k ? load_value(row, k - 1, elem_size) : 0);
+}
+
+// Inverse of the residual coding of the write side
+static inline uint64_t unresidual(uint64_t z, unsigned elem_size)
+{
+    if (elem_size == 8)
+        return adios_fpred_unzigzag(z);
+    const uint32_t z32 = (uint32_t)z;
+    return (uint32_t)((z32 >> 1) ^ (0 - (z32 & 1)));
+}
+
+#if defined(__AVX2__)
+// Values k..k+3 of a row, widened to 64 bits
+static inline __m256i avx2_load(const void *row, uint64_t k, unsigned elem_size)
+{
+    if (elem_size == 8)
+        return _mm256_loadu_si256((const __m256i *)((const uint64_t *)row + k));
+    return _mm256_cvtepu32_epi64(_mm_loadu_si128((const __m128i *)((const uint32_t *)row + k)));
+}
+
+static inline __m256i avx2_step(const void *row, uint64_t k, unsigned elem_size)
+{
+    return _mm256_sub_epi64(avx2_load(row, k, elem_size), avx2_load(row, k - 1, elem_size));
+}
+
+// Processes values [k, k1) 4 at a time, for k >= 1; returns the first value not processed
+static inline uint64_t lorenzo_terms_avx2(const void *b, const void *c, const void *d, const uint64_t *r,
+                                          uint64_t k, uint64_t k1, uint64_t k0, unsigned elem_size, uint64_t *t)
+{
+    const __m256i one = _mm256_set1_epi64x(1);
+    for (; k + 4 <= k1; k += 4) {
+        const __m256i z = _mm256_loadu_si256((const __m256i *)(r + k - k0));
+        __m256i sum;
+        if (elem_size == 8) {
+            sum = _mm256_xor_si256(_mm256_srli_epi64(z, 1), _mm256_sub_epi64(_mm256_setzero_si256(), _mm256_and_si256(z, one)));
+        } else {
+            // 32-bit zig-zag in the low half of each lane; the high half stays 0
+            sum = _mm256_xor_si256(_mm256_srli_epi32(z, 1), _mm256_sub_epi32(_mm256_setzero_si256(), _mm256_and_si256(z, one)));
+        }
+        if (b) sum = _mm256_add_epi64(sum, avx2_step(b, k, elem_size));
+        if (c) sum = _mm256_add_epi64(sum, avx2_step(c, k, elem_size));
+        if (d) sum = _mm256_sub_epi64(sum, avx2_step(d, k, elem_size));
+        _mm256_storeu_si256((__m256i *)(t + k - k0), sum);
+    }
+    return k;
+}
+#endif
+
+#if defined(__SSE2__)
+// Values k..k+1 of a row, widened to 64 bits
+static inline __m128i sse2_load(const void *row, uint64_t k, unsigned elem_size)
+{
+    if (elem_size == 8)
+        return _mm_loadu_si128((const __m128i *)((const uint64_t *)row + k));
+    return _mm_unpacklo_epi32(_mm_loadl_epi64((const __m128i *)((const uint32_t *)row + k)), _mm_setzero_si128());
+}
+
+static inline __m128i sse2_step(const void *row, uint64_t k, unsigned elem_size)
+{
+    return _mm_sub_epi64(sse2_load(row, k, elem_size), sse2_load(row, k - 1, elem_size));
+}
+
+// Processes values [k, k1) 2 at a time, for k >= 1; returns the first value not processed
+static inline uint64_t lorenzo_terms_sse2(const void *b, const void *c, const void *d, const uint64_t *r,
+                                          uint64_t k, uint64_t k1, uint64_t k0, unsigned elem_size, uint64_t *t)
+{
+    const __m128i one = _mm_set_epi32(0, 1, 0, 1);
+    for (; k + 2 <= k1; k += 2) {
+        const __m128i z = _mm_loadu_si128((const __m128i *)(r + k - k0));
+        __m128i sum;
+        if (elem_size == 8) {
+            sum = _mm_xor_si128(_mm_srli_epi64(z, 1), _mm_sub_epi64(_mm_setzero_si128(), _mm_and_si128(z, one)));
+        } else {
+            // 32-bit zig-zag in the low half of each lane; the high half stays 0
+            sum = _mm_xor_si128(_mm_srli_epi32(z, 1), _mm_sub_epi32(_mm_setzero_si128(), _mm_and_si128(z, one)));
+        }
+        if (b) sum = _mm_add_epi64(sum, sse2_step(b, k, elem_size));
+        if (c) sum = _mm_add_epi64(sum, sse2_step(c, k, elem_size));
+        if (d) sum = _mm_sub_epi64(sum, sse2_step(d, k, elem_size));
+        _mm_storeu_si128((__m128i *)(t + k - k0), sum);
+    }
+    return k;
+}
+#endif
+
+// Decodes values [k0, k1) of row a from their residuals r, using t as scratch space
+static void lorenzo_decode_row(void *a, const void *b, const void *c, const void *d, const uint64_t *r,
+                               uint64_t k0, uint64_t k1, unsigned elem_size, uint64_t *t)
+{
+    uint64_t k = k0, prev;
+
+    if (k == 0 && k < k1) {
+        t[0] = unresidual(r[0], elem_size) + value_step(b, 0, elem_size) + value_step(c, 0, elem_size) - value_step(d, 0, elem_size);
+        k = 1;
+    }
+
+#if defined(__AVX2__)
+    k = lorenzo_terms_avx2(b, c, d, r, k, k1, k0, elem_size, t);
+#endif
+#if defined(__SSE2__)
+    k = lorenzo_terms_sse2(b, c, d, r, k, k1, k0, elem_size, t);
+#endif
+
+    for (; k < k1; k++)
+        t[k - k0] = unresidual(r[k - k0], elem_size) + value_step(b, k, elem_size) + value_step(c, k, elem_size) - value_step(d, k, elem_size);
+
+    // The running sum along the row is inherently serial
+    prev = k0 ? load_value(a, k0 - 1, elem_size) : 0;
+    if (elem_size == 8) {
+        uint64_t *out = (uint64_t *)a;
+        for (k = k0; k < k1; k++)
+            out[k] = prev += t[k - k0];
+    } else {
+        uint32_t *out = (uint32_t *)a;
+        for (k = k0; k < k1; k++)
+            out[k] = (uint32_t)(prev += t[k - k0]);
+    }
+}
+
+static void unmap_values(void *data, uint64_t n, unsigned elem_size)
+{
+    uint64_t i;
+    if (elem_size == 8) {
+        uint64_t *v = (uint64_t *)data;
+        for (i = 0; i < n; i++)
+            v[i] = adios_fpred_unmap64(v[i]);
+    } else {
+        uint32_t *v = (uint32_t *)data;
+        for (i = 0; i < n; i++)
+            v[i] = adios_fpred_unmap32(v[i]);
+    }
+}
+
+/*
+ * Unpacks the count residuals (a multiple of the group size, except at the
+ * end of the stream) starting at *pos into r. Returns 0 if the stream ends
+ * before them.
+ */
+static int unpack_residuals(const uint8_t **pos, const uint8_t *end, uint64_t count, uint64_t *r)
+{
+    const uint8_t *p = *pos;
+    uint64_t g;
+
+    for (g = 0; g < count; g += ADIOS_FPRED_GROUP_SIZE) {
+        const unsigned n = (unsigned)(count - g < ADIOS_FPRED_GROUP_SIZE ? count - g : ADIOS_FPRED_GROUP_SIZE);
+        unsigned i;
+
+        if (p >= end)
+            return 0;
+        const unsigned w = *p++;
+        if (w > 64)
+            return 0;
+        const uint64_t nbytes = ((uint64_t)n * w + 7) / 8;
+        if ((uint64_t)(end - p) < nbytes)
+            return 0;
+
+        if (w == 0) {
+            memset(r + g, 0, n * sizeof(uint64_t));
+            continue;
+        }
+
+        // The padding after the stream keeps these loads in bounds
+        const uint64_t mask = w == 64 ? ~UINT64_C(0) : (UINT64_C(1) << w) - 1;
+        unsigned bit = 0;
+        for (i = 0; i < n; i++, bit += w) {
+            const uint8_t *q = p + bit / 8;
+            const unsigned sh = bit % 8;
+            uint64_t v = adios_fpred_load64(q) >> sh;
+            if (sh + w > 64)
+                v |= (uint64_t)q[8] << (64 - sh);
+            r[g + i] = v & mask;
+        }
+        p += nbytes;
+    }
+
+    *pos = p;
+    return 1;
+}
+
+/*
+ * Decodes the nx * ny * nz values packed at in into out. Returns 0 if the
+ * data is corrupt or memory runs out.
+ */
+static int fpred_decode(const uint8_t *in, uint64_t in_len, unsigned elem_size, uint64_t nx, uint64_t ny, uint64_t nz,
+                        enum ADIOS_FPRED_PREDICTOR predictor, void *out)
+{
+    const uint64_t n = nx * ny * nz;
+    const uint8_t *pos = in;
+    const uint8_t *end = in + in_len - ADIOS_FPRED_PADDING;
+    uint64_t l = 0;
+    int ok = 1;
+
+    uint64_t *r = (uint64_t *)malloc(2 * ADIOS_FPRED_CHUNK * sizeof(uint64_t));
+    if (!r)
+        return 0;
+    uint64_t *t = r + ADIOS_FPRED_CHUNK;
+
+    while (ok && l < n) {
+        const uint64_t chunk = n - l < ADIOS_FPRED_CHUNK ? n - l : ADIOS_FPRED_CHUNK;
+        uint64_t fill = 0;
+
+        if (!unpack_residuals(&pos, end, chunk, r)) {
+            ok = 0;
+            break;
+        }
+
+        if (predictor == adios_fpred_previous) {
+            uint64_t prev = l ? load_value(out, l - 1, elem_size) : 0;
+            if (elem_size == 8) {
+                uint64_t *v = (uint64_t *)out + l;
+                for (fill = 0; fill < chunk; fill++)
+                    v[fill] = prev ^= r[fill];
+            } else {
+                uint32_t *v = (uint32_t *)out + l;
+                for (fill = 0; fill < chunk; fill++)
+                    v[fill] = (uint32_t)(prev ^= r[fill]);
+            }
+            l += chunk;
+            continue;
+        }
+
+        // Lorenzo: decode the chunk row segment by row segment, as it was coded
+        while (fill < chunk) {
+            const uint64_t k = l % nx, row = l / nx;
+            const uint64_t j = row % ny, i = row / ny;
+            char *a = (char *)out + row * nx * elem_size;
+            const char *b = j > 0 ? a - nx * elem_size : NULL;
+            const char *c = i > 0 ? a - nx * ny * elem_size : NULL;
+            const char *d = (i > 0 && j > 0) ? c - nx * elem_size : NULL;
+            uint64_t seg = chunk - fill;
+
+            if (seg > nx - k)
+                seg = nx - k;
+            lorenzo_decode_row(a, b, c, d, r + fill, k, k + seg, elem_size, t);
+            fill += seg;
+            l += seg;
+        }
+    }
+
+    if (ok && pos != end)
+        ok = 0;
+    if (ok && predictor == adios_fpred_lorenzo)
+        unmap_values(out, n, elem_size);
+
+    free(r);
+    return ok;
+}
+
+int adios_transform_fpred_is_implemented (void) {return 1;}
+
+int adios_transform_fpred_generate_read_subrequests(adios_transform_read_request *reqgroup,
+                                                    adios_transform_pg_read_request *pg_reqgroup)
+{
+    void *buf = malloc(pg_reqgroup->raw_var_length);
+    assert(buf);
+    adios_transform_raw_read_request *subreq = adios_transform_raw_read_request_new_whole_pg(pg_reqgroup, buf);
+    adios_transform_raw_read_request_append(pg_reqgroup, subreq);
+    return 0;
+}
+
+// Do nothing for individual subrequest
+adios_datablock * adios_transform_fpred_subrequest_completed(adios_transform_read_request *reqgroup,
+                                                             adios_transform_pg_read_request *pg_reqgroup,
+                                                             adios_transform_raw_read_request *completed_subreq)
+{
+    return NULL;
+}
+
+adios_datablock * adios_transform_fpred_pg_reqgroup_completed(adios_transform_read_request *reqgroup,
+                                                              adios_transform_pg_read_request *completed_pg_reqgroup)
+{
+    const uint8_t *packed_data = (const uint8_t *)completed_pg_reqgroup->subreqs->data;
+    const uint64_t packed_size = completed_pg_reqgroup->raw_var_length;
+
+    if (completed_pg_reqgroup->transform_metadata_len < ADIOS_FPRED_METADATA_SIZE) {
+        adios_error(err_invalid_transform_type, "Invalid fpred transform metadata in block %d\n",
+                    completed_pg_reqgroup->blockidx);
+        return NULL;
+    }
+
+    const char *md = (const char *)completed_pg_reqgroup->transform_metadata;
+    uint64_t orig_size_meta, nx, ny;
+    uint8_t elem_size, predictor, group_size;
+    memcpy(&orig_size_meta, md, sizeof(uint64_t));
+    memcpy(&elem_size, md + sizeof(uint64_t), sizeof(uint8_t));
+    memcpy(&predictor, md + sizeof(uint64_t) + sizeof(uint8_t), sizeof(uint8_t));
+    memcpy(&group_size, md + sizeof(uint64_t) + 2 * sizeof(uint8_t), sizeof(uint8_t));
+    memcpy(&nx, md + sizeof(uint64_t) + 3 * sizeof(uint8_t), sizeof(uint64_t));
+    memcpy(&ny, md + 2 * sizeof(uint64_t) + 3 * sizeof(uint8_t), sizeof(uint64_t));
+
+    uint64_t orig_size = adios_get_type_size(reqgroup->transinfo->orig_type, "");
+    int d;
+    for (d = 0; d < reqgroup->transinfo->orig_ndim; d++)
+        orig_size *= (uint64_t)(completed_pg_reqgroup->orig_varblock->count[d]);
+
+    const uint64_t nvalues = elem_size ? orig_size / elem_size : 0;
+    int valid = orig_size_meta == orig_size && (elem_size == 4 || elem_size == 8) && group_size == ADIOS_FPRED_GROUP_SIZE;
+    if (predictor == adios_fpred_stored) {
+        valid = valid && packed_size == orig_size;
+    } else {
+        valid = valid && (predictor == adios_fpred_lorenzo || predictor == adios_fpred_previous) &&
+                packed_size >= ADIOS_FPRED_PADDING && nx > 0 && ny > 0 && nvalues % (nx * ny) == 0;
+    }
+    if (!valid) {
+        adios_error(err_invalid_transform_type, "fpred transform metadata in block %d does not match "
+                    "the stored data\n", completed_pg_reqgroup->blockidx);
+        return NULL;
+    }
+
+    void *orig_data = malloc(orig_size);
+    if (!orig_data)
+        return NULL;
+
+    if (predictor == adios_fpred_stored) {
+        memcpy(orig_data, packed_data, orig_size);
+    } else if (!fpred_decode(packed_data, packed_size, elem_size, nx, ny, nvalues / (nx * ny),
+                             (enum ADIOS_FPRED_PREDICTOR)predictor, orig_data)) {
+        adios_error(err_invalid_transform_type, "Corrupt fpred data in block %d\n", completed_pg_reqgroup->blockidx);
+        free(orig_data);
+        return NULL;
+    }
+
+    return adios_datablock_new_whole_pg(reqgroup, completed_pg_reqgroup, orig_data);
+}
+
+adios_datablock * adios_transform_fpred_reqgroup_completed(adios_transform_read_request *completed_reqgroup)
+{
+    return NULL;
+}
@@ -0,0 +1,470 @@
+/*
+ * adios_transform_fpred_write.c
+ *
+ * Write side of the "fpred" transform: predicts every float or double value
+ * from its neighbors and bit-packs the residuals (see
+ * adios_transform_fpred_common.h). The residuals are computed with AVX2 or
+ * SSE2 when the compiler targets them.
+ */
+
+#include <stdint.h>
+#include <inttypes.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+#if defined(__AVX2__)
+#include <immintrin.h>
+#endif
+
+#include "core/adios_logger.h"
+#include "core/adios_internals.h" // count_dimensions(), adios_get_dim_value()
+#include "core/transforms/adios_transforms_common.h"
+#include "core/transforms/adios_transforms_write.h"
+#include "core/transforms/adios_transforms_hooks_write.h"
+#include "core/transforms/adios_transforms_util.h"
+#include "adios_transform_fpred_common.h"
+
+/*
+ * Residual kernels
+ *
+ * Rows hold elem_size (4 or 8) byte values. For the Lorenzo predictor, a is
+ * the row being coded and b, c and d are the rows before it in y, in z, and
+ * in both (NULL where that row lies outside the block). Residuals of values
+ * k0..k1-1 are written to r[0..k1-k0).
+ */
+
+// Value k of a row, mapped to an ordered integer
+static inline uint64_t load_mapped(const void *row, uint64_t k, unsigned elem_size)
+{
+    return elem_size == 8 ? adios_fpred_map64(((const uint64_t *)row)[k])
+                          : adios_fpred_map32(((const uint32_t *)row)[k]);
+}
+
+static inline uint64_t load_raw(const void *row, uint64_t k, unsigned elem_size)
+{
+    return elem_size == 8 ? ((const uint64_t *)row)[k] : ((const uint32_t *)row)[k];
+}
+
+// Float residuals are taken modulo 2^32 so they fit in 32 bits after zig-zag coding
+static inline uint64_t residual(uint64_t delta, unsigned elem_size)
+{
+    if (elem_size == 8)
+        return adios_fpred_zigzag(delta);
+    const uint32_t d32 = (uint32_t)delta;
+    return (uint32_t)((d32 << 1) ^ (uint32_t)((int32_t)d32 >> 31));
+}
+
+// row[k] - row[k-1], with row[-1] = 0 and a NULL row being all zeros
+static inline uint64_t mapped_step(const void *row, uint64_t k, unsigned elem_size)
+{
+    if (!row)
+        return 0;
+    return load_mapped(row, k, elem_size) - (k ? load_mapped(row, k - 1, elem_size) : 0);
+}
+
+#if defined(__AVX2__)
+static inline __m256i avx2_map64(__m256i x)
+{
+    const __m256i sign = _mm256_cmpgt_epi64(_mm256_setzero_si256(), x);
+    return _mm256_xor_si256(x, _mm256_or_si256(sign, _mm256_set1_epi64x((long long)UINT64_C(0x8000000000000000))));
+}
+
+// Values k..k+3 of a row, mapped and widened to 64 bits
+static inline __m256i avx2_load_mapped(const void *row, uint64_t k, unsigned elem_size)
+{
+    if (elem_size == 8)
+        return avx2_map64(_mm256_loadu_si256((const __m256i *)((const uint64_t *)row + k)));
+    const __m128i x = _mm_loadu_si128((const __m128i *)((const uint32_t *)row + k));
+    const __m128i mask = _mm_or_si128(_mm_srai_epi32(x, 31), _mm_set1_epi32((int)UINT32_C(0x80000000)));
+    return _mm256_cvtepu32_epi64(_mm_xor_si128(x, mask));
+}
+
+static inline __m256i avx2_step(const void *row, uint64_t k, unsigned elem_size)
+{
+    return _mm256_sub_epi64(avx2_load_mapped(row, k, elem_size), avx2_load_mapped(row, k - 1, elem_size));
+}
+
+// Processes values [k, k1) 4 at a time, for k >= 1; returns the first value not processed
+static inline uint64_t lorenzo_residuals_avx2(const void *a, const void *b, const void *c, const void *d,
+                                              uint64_t k, uint64_t k1, uint64_t k0, unsigned elem_size, uint64_t *r)
+{
+    for (; k + 4 <= k1; k += 4) {
+        __m256i delta = avx2_step(a, k, elem_size);
+        if (b) delta = _mm256_sub_epi64(delta, avx2_step(b, k, elem_size));
+        if (c) delta = _mm256_sub_epi64(delta, avx2_step(c, k, elem_size));
+        if (d) delta = _mm256_add_epi64(delta, avx2_step(d, k, elem_size));
+        __m256i z;
+        if (elem_size == 8) {
+            z = _mm256_xor_si256(_mm256_slli_epi64(delta, 1), _mm256_cmpgt_epi64(_mm256_setzero_si256(), delta));
+        } else {
+            // 32-bit zig-zag of the low half of each lane
+            z = _mm256_xor_si256(_mm256_slli_epi32(delta, 1), _mm256_srai_epi32(delta, 31));
+            z = _mm256_and_si256(z, _mm256_set1_epi64x(0xFFFFFFFFLL));
+        }
+        _mm256_storeu_si256((__m256i *)(r + k - k0), z);
+    }
+    return k;
+}
+#endif
+
+#if defined(__SSE2__)
+// Sign of each 64-bit lane, spread over the lane (SSE2 has no 64-bit compare)
+static inline __m128i sse2_sign64(__m128i x)
+{
+    return _mm_shuffle_epi32(_mm_srai_epi32(x, 31), _MM_SHUFFLE(3, 3, 1, 1));
+}
+
+// Values k..k+1 of a row, mapped and widened to 64 bits
+static inline __m128i sse2_load_mapped(const void *row, uint64_t k, unsigned elem_size)
+{
+    if (elem_size == 8) {
+        const __m128i x = _mm_loadu_si128((const __m128i *)((const uint64_t *)row + k));
+        return _mm_xor_si128(x, _mm_or_si128(sse2_sign64(x), _mm_set_epi32((int)UINT32_C(0x80000000), 0, (int)UINT32_C(0x80000000), 0)));
+    }
+    const __m128i x = _mm_loadl_epi64((const __m128i *)((const uint32_t *)row + k));
+    const __m128i mask = _mm_or_si128(_mm_srai_epi32(x, 31), _mm_set1_epi32((int)UINT32_C(0x80000000)));
+    return _mm_unpacklo_epi32(_mm_xor_si128(x, mask), _mm_setzero_si128());
+}
+
+static inline __m128i sse2_step(const void *row, uint64_t k, unsigned elem_size)
+{
+    return _mm_sub_epi64(sse2_load_mapped(row, k, elem_size), sse2_load_mapped(row, k - 1, elem_size));
+}
+
+// Processes values [k, k1) 2 at a time, for k >= 1; returns the first value not processed
+static inline uint64_t lorenzo_residuals_sse2(const void *a, const void *b, const void *c, const void *d,
+                                              uint64_t k, uint64_t k1, uint64_t k0, unsigned elem_size, uint64_t *r)
+{
+    for (; k + 2 <= k1; k += 2) {
+        __m128i delta = sse2_step(a, k, elem_size);
+        if (b) delta = _mm_sub_epi64(delta, sse2_step(b, k, elem_size));
+        if (c) delta = _mm_sub_epi64(delta, sse2_step(c, k, elem_size));
+        if (d) delta = _mm_add_epi64(delta, sse2_step(d, k, elem_size));
+        __m128i z;
+        if (elem_size == 8) {
+            z = _mm_xor_si128(_mm_slli_epi64(delta, 1), sse2_sign64(delta));
+        } else {
+            // 32-bit zig-zag of the low half of each lane
+            z = _mm_xor_si128(_mm_slli_epi32(delta, 1), _mm_srai_epi32(delta, 31));
+            z = _mm_and_si128(z, _mm_set_epi32(0, -1, 0, -1));
+        }
+        _mm_storeu_si128((__m128i *)(r + k - k0), z);
+    }
+    return k;
+}
+#endif
+
+static void lorenzo_residuals(const void *a, const void *b, const void *c, const void *d,
+                              uint64_t k0, uint64_t k1, unsigned elem_size, uint64_t *r)
+{
+    uint64_t k = k0;
+
+    // The first value of a row has no left neighbors, which the vector kernels assume
+    if (k == 0 && k < k1) {
+        uint64_t delta = load_mapped(a, 0, elem_size);
+        delta -= mapped_step(b, 0, elem_size) + mapped_step(c, 0, elem_size) - mapped_step(d, 0, elem_size);
+        r[0] = residual(delta, elem_size);
+        k = 1;
+    }
+
+#if defined(__AVX2__)
+    k = lorenzo_residuals_avx2(a, b, c, d, k, k1, k0, elem_size, r);
+#endif
+#if defined(__SSE2__)
+    k = lorenzo_residuals_sse2(a, b, c, d, k, k1, k0, elem_size, r);
+#endif
+
+    for (; k < k1; k++) {
+        uint64_t delta = mapped_step(a, k, elem_size);
+        delta -= mapped_step(b, k, elem_size) + mapped_step(c, k, elem_size) - mapped_step(d, k, elem_size);
+        r[k - k0] = residual(delta, elem_size);
+    }
+}
+
+// XOR of every value k0..k1-1 with the one before it (value -1 being 0)
+static void previous_residuals(const void *in, uint64_t k0, uint64_t k1, unsigned elem_size, uint64_t *r)
+{
+    uint64_t k = k0;
+
+    if (k == 0 && k < k1) {
+        r[0] = load_raw(in, 0, elem_size);
+        k = 1;
+    }
+
+#if defined(__AVX2__)
+    if (elem_size == 8) {
+        for (; k + 4 <= k1; k += 4) {
+            const __m256i cur = _mm256_loadu_si256((const __m256i *)((const uint64_t *)in + k));
+            const __m256i prev = _mm256_loadu_si256((const __m256i *)((const uint64_t *)in + k - 1));
+            _mm256_storeu_si256((__m256i *)(r + k - k0), _mm256_xor_si256(cur, prev));
+        }
+    } else {
+        for (; k + 4 <= k1; k += 4) {
+            const __m128i cur = _mm_loadu_si128((const __m128i *)((const uint32_t *)in + k));
+            const __m128i prev = _mm_loadu_si128((const __m128i *)((const uint32_t *)in + k - 1));
+            _mm256_storeu_si256((__m256i *)(r + k - k0), _mm256_cvtepu32_epi64(_mm_xor_si128(cur, prev)));
+        }
+    }
+#endif
+#if defined(__SSE2__)
+    if (elem_size == 8) {
+        for (; k + 2 <= k1; k += 2) {
+            const __m128i cur = _mm_loadu_si128((const __m128i *)((const uint64_t *)in + k));
+            const __m128i prev = _mm_loadu_si128((const __m128i *)((const uint64_t *)in + k - 1));
+            _mm_storeu_si128((__m128i *)(r + k - k0), _mm_xor_si128(cur, prev));
+        }
+    }
+#endif
+
+    for (; k < k1; k++)
+        r[k - k0] = load_raw(in, k, elem_size) ^ load_raw(in, k - 1, elem_size);
+}
+
+/*
+ * Bit packing
+ */
+
+static inline unsigned significant_bits(uint64_t x)
+{
+#if defined(__GNUC__)
+    return x ? 64 - (unsigned)__builtin_clzll(x) : 0;
+#else
+    unsigned n = 0;
+    while (x) {
+        x >>= 1;
+        n++;
+    }
+    return n;
+#endif
+}
+
+// Packs count values of w bits each at out; returns the end of the packed bytes
+static uint8_t * pack_group(const uint64_t *r, unsigned count, unsigned w, uint8_t *out)
+{
+    uint64_t acc = 0;
+    unsigned nbits = 0, i;
+
+    if (w == 0)
+        return out;
+
+    for (i = 0; i < count; i++) {
+        acc |= r[i] << nbits;
+        nbits += w;
+        if (nbits >= 64) {
+            adios_fpred_store64(out, acc);
+            out += 8;
+            nbits -= 64;
+            acc = nbits ? r[i] >> (w - nbits) : 0;
+        }
+    }
+    for (i = 0; i < nbits; i += 8) {
+        *out++ = (uint8_t)acc;
+        acc >>= 8;
+    }
+    return out;
+}
+
+// Packs count residuals group by group; returns the end of the packed bytes
+static uint8_t * pack_residuals(const uint64_t *r, uint64_t count, uint8_t *out)
+{
+    uint64_t g;
+    for (g = 0; g < count; g += ADIOS_FPRED_GROUP_SIZE) {
+        const unsigned n = (unsigned)(count - g < ADIOS_FPRED_GROUP_SIZE ? count - g : ADIOS_FPRED_GROUP_SIZE);
+        uint64_t all = 0;
+        unsigned i;
+        for (i = 0; i < n; i++)
+            all |= r[g + i];
+
+        const unsigned w = significant_bits(all);
+        *out++ = (uint8_t)w;
+        out = pack_group(r + g, n, w, out);
+    }
+    return out;
+}
+
+/*
+ * Encodes the nx * ny * nz values at in (x varying fastest) into out, which
+ * must hold adios_fpred_max_packed_size() bytes. Returns the encoded size,
+ * or 0 if out of memory.
+ */
+static uint64_t fpred_encode(const void *in, unsigned elem_size, uint64_t nx, uint64_t ny, uint64_t nz,
+                             enum ADIOS_FPRED_PREDICTOR predictor, uint8_t *out)
+{
+    const uint64_t n = nx * ny * nz;
+    uint8_t *pos = out;
+    uint64_t fill = 0, l = 0;
+
+    uint64_t *r = (uint64_t *)malloc(ADIOS_FPRED_CHUNK * sizeof(uint64_t));
+    if (!r)
+        return 0;
+
+    while (l < n) {
+        uint64_t seg = ADIOS_FPRED_CHUNK - fill;
+
+        if (predictor == adios_fpred_previous) {
+            if (seg > n - l)
+                seg = n - l;
+            previous_residuals(in, l, l + seg, elem_size, r + fill);
+        } else {
+            // Code at most the rest of the current row
+            const uint64_t k = l % nx, row = l / nx;
+            const uint64_t j = row % ny, i = row / ny;
+            const char *a = (const char *)in + row * nx * elem_size;
+            const char *b = j > 0 ? a - nx * elem_size : NULL;
+            const char *c = i > 0 ? a - nx * ny * elem_size : NULL;
+            const char *d = (i > 0 && j > 0) ? c - nx * elem_size : NULL;
+
+            if (seg > nx - k)
+                seg = nx - k;
+            lorenzo_residuals(a, b, c, d, k, k + seg, elem_size, r + fill);
+        }
+
+        fill += seg;
+        l += seg;
+        if (fill == ADIOS_FPRED_CHUNK || l == n) {
+            pos = pack_residuals(r, fill, pos);
+            fill = 0;
+        }
+    }
+
+    memset(pos, 0, ADIOS_FPRED_PADDING);
+    pos += ADIOS_FPRED_PADDING;
+
+    free(r);
+    return (uint64_t)(pos - out);
+}
+
+uint16_t adios_transform_fpred_get_metadata_size(struct adios_transform_spec *transform_spec)
+{
+    return ADIOS_FPRED_METADATA_SIZE;
+}
+
+void adios_transform_fpred_transformed_size_growth(
+        const struct adios_var_struct *var, const struct adios_transform_spec *transform_spec,
+        uint64_t *constant_factor, double *linear_factor, double *capped_linear_factor, uint64_t *capped_linear_cap)
+{
+    // Incompressible data is stored as is, but the packed stream is written
+    // (with its group width bytes and padding) before that is known
+    *constant_factor = 1 + ADIOS_FPRED_PADDING;
+    *linear_factor = 1.0 + 1.0 / (ADIOS_FPRED_GROUP_SIZE * sizeof(float));
+}
+
+int adios_transform_fpred_apply(struct adios_file_struct *fd,
+                                struct adios_var_struct *var,
+                                uint64_t *transformed_len,
+                                int use_shared_buffer,
+                                int *wrote_to_shared_buffer)
+{
+    // Assume this function is only called for the fpred transform type
+    assert(var->transform_type == adios_transform_fpred);
+
+    // Get the input data and data length
+    const uint64_t input_size = adios_transform_get_pre_transform_var_size(var);
+    const void *input_buff = var->data;
+
+    unsigned elem_size;
+    if (var->pre_transform_type == adios_double) {
+        elem_size = 8;
+    } else if (var->pre_transform_type == adios_real) {
+        elem_size = 4;
+    } else {
+        adios_error(err_invalid_argument, "The fpred transform only handles adios_real and adios_double "
+                    "variables, but variable %s has type %s\n", var->name, adios_type_to_string_int(var->pre_transform_type));
+        return 0;
+    }
+
+    // Parse the parameters
+    enum ADIOS_FPRED_PREDICTOR predictor = adios_fpred_lorenzo;
+    int i;
+    for (i = 0; i < var->transform_spec->param_count; i++) {
+        const struct adios_transform_spec_kv_pair *param = &var->transform_spec->params[i];
+        if (!strcmp(param->key, "predictor") && param->value && !strcmp(param->value, "lorenzo")) {
+            predictor = adios_fpred_lorenzo;
+        } else if (!strcmp(param->key, "predictor") && param->value && !strcmp(param->value, "previous")) {
+            predictor = adios_fpred_previous;
+        } else {
+            log_warn("An unknown fpred parameter: %s%s%s\n", param->key,
+                     param->value ? "=" : "", param->value ? param->value : "");
+        }
+    }
+
+    // Lorenzo prediction runs over the fastest varying dimensions of the block
+    uint64_t dims[32], nx, ny, nz;
+    struct adios_dimension_struct *d = var->pre_transform_dimensions;
+    const int ndims = count_dimensions(d);
+    if (ndims > 32) {
+        adios_error(err_invalid_dimension, "The fpred transform does not handle the %d dimensional variable %s\n",
+                    ndims, var->name);
+        return 0;
+    }
+    for (i = 0; i < ndims; i++, d = d->next) {
+        // Slowest dimension first, as in memory
+        const int di = (fd->group->adios_host_language_fortran == adios_flag_yes) ? ndims - 1 - i : i;
+        dims[di] = adios_get_dim_value(&d->dimension);
+    }
+    adios_fpred_fold_dims(ndims, dims, &nx, &ny, &nz);
+    if (nx * ny * nz * elem_size != input_size) {
+        // Should not happen, but code the data as a 1D array rather than misread it
+        nx = input_size / elem_size;
+        ny = nz = 1;
+    }
+
+    // decide the output buffer
+    const uint64_t max_size = adios_fpred_max_packed_size(nx * ny * nz, elem_size);
+    uint8_t *output_buff = NULL;
+
+    if (use_shared_buffer) {
+        // If shared buffer is permitted, serialize to there
+        if (!shared_buffer_reserve(fd, max_size)) {
+            log_error("Out of memory allocating %" PRIu64 " bytes for %s for fpred transform\n", max_size, var->name);
+            return 0;
+        }
+        output_buff = (uint8_t *)(fd->buffer + fd->offset);
+    } else { // Else, fall back to var->adata memory allocation
+        output_buff = (uint8_t *)malloc(max_size);
+        if (!output_buff) {
+            log_error("Out of memory allocating %" PRIu64 " bytes for %s for fpred transform\n", max_size, var->name);
+            return 0;
+        }
+    }
+    *wrote_to_shared_buffer = use_shared_buffer;
+
+    uint64_t output_size = fpred_encode(input_buff, elem_size, nx, ny, nz, predictor, output_buff);
+    if (output_size == 0) {
+        log_error("Out of memory in fpred transform for %s\n", var->name);
+        if (!use_shared_buffer)
+            free(output_buff);
+        *wrote_to_shared_buffer = 0;
+        return 0;
+    }
+    if (output_size >= input_size) {
+        // Not compressible: store the data as is
+        memcpy(output_buff, input_buff, input_size);
+        output_size = input_size;
+        predictor = adios_fpred_stored;
+    }
+
+    // Wrap up, depending on buffer mode
+    if (*wrote_to_shared_buffer) {
+        shared_buffer_mark_written(fd, output_size);
+    } else {
+        var->adata = output_buff;
+        var->data_size = output_size;
+        var->free_data = adios_flag_yes;
+    }
+    *transformed_len = output_size; // Return the size of the data buffer
+
+    if (var->transform_metadata && var->transform_metadata_len > 0) {
+        const uint8_t md[3] = { (uint8_t)elem_size, (uint8_t)predictor, (uint8_t)ADIOS_FPRED_GROUP_SIZE };
+        memcpy((char*)var->transform_metadata, &input_size, sizeof(uint64_t));
+        memcpy((char*)var->transform_metadata + sizeof(uint64_t), md, sizeof(md));
+        memcpy((char*)var->transform_metadata + sizeof(uint64_t) + sizeof(md), &nx, sizeof(uint64_t));
+        memcpy((char*)var->transform_metadata + 2 * sizeof(uint64_t) + sizeof(md), &ny, sizeof(uint64_t));
+    }
+
+    return 1;
+}
@@ -0,0 +1,226 @@
+/*
+ * adios_transform_pipeline_read.c
+ *
+ * Read side of the "pipeline" transform (see adios_transform_pipeline_write.c).
+ * The whole transformed PG is read, and the stages are then undone in reverse
+ * order. Each stage is driven through its own plugin's read hooks, with its
+ * raw read requests answered from the in-memory output of the stage after it
+ * instead of from the file. Every stage except the first decodes to a 1D byte
+ * array; the first stage decodes to the variable's original type and shape.
+ */
+
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <assert.h>
+
+#include "core/adios_logger.h"
+#include "core/a2sel.h"
+#include "core/transforms/adios_transforms_common.h"
+#include "core/transforms/adios_transforms_hooks_read.h"
+#include "core/transforms/adios_transforms_reqgroup.h"
+
+#define MYFREE(p) {if (p) free(p); (p)=NULL;}
+
+int adios_transform_pipeline_is_implemented (void) {return 1;}
+
+int adios_transform_pipeline_generate_read_subrequests(adios_transform_read_request *reqgroup,
+                                                       adios_transform_pg_read_request *pg_reqgroup)
+{
+    void *buf = malloc(pg_reqgroup->raw_var_length);
+    assert(buf);
+    adios_transform_raw_read_request *subreq = adios_transform_raw_read_request_new_whole_pg(pg_reqgroup, buf);
+    adios_transform_raw_read_request_append(pg_reqgroup, subreq);
+    return 0;
+}
+
+// Do nothing for individual subrequest
+adios_datablock * adios_transform_pipeline_subrequest_completed(adios_transform_read_request *reqgroup,
+                                                                adios_transform_pg_read_request *pg_reqgroup,
+                                                                adios_transform_raw_read_request *completed_subreq)
+{
+    return NULL;
+}
+
+static void keep_single_datablock(adios_datablock **result, adios_datablock *new_result)
+{
+    if (!new_result)
+        return;
+    if (*result) {
+        adios_error(err_operation_not_supported,
+                    "A transform used as a pipeline stage produced more than one data block per PG, "
+                    "which is not supported\n");
+        adios_datablock_free(&new_result, 1);
+        return;
+    }
+    *result = new_result;
+}
+
+/*
+ * Runs the read hooks of one pipeline stage over 'input', the stage's
+ * transformed bytes (stage_pg->raw_var_length of them), and returns the
+ * datablock the stage produces (NULL on error).
+ */
+static adios_datablock * run_stage(const adios_transform_read_request *reqgroup,
+                                   const ADIOS_TRANSINFO *stage_transinfo,
+                                   adios_transform_pg_read_request *stage_pg,
+                                   const char *read_param, const ADIOS_SELECTION *orig_sel,
+                                   const char *input)
+{
+    adios_transform_read_request stage_req = *reqgroup;
+    adios_transform_raw_read_request *subreq;
+    adios_datablock *result = NULL;
+
+    stage_req.completed = 0;
+    stage_req.lent_varchunk_data = NULL;
+    stage_req.transinfo = stage_transinfo;
+    stage_req.orig_sel = orig_sel;
+    stage_req.read_param = read_param;
+    stage_req.orig_data = NULL;
+    stage_req.num_pg_reqgroups = 1;
+    stage_req.num_completed_pg_reqgroups = 0;
+    stage_req.pg_reqgroups = stage_pg;
+    stage_req.transform_internal = NULL;
+    stage_req.next = NULL;
+
+    adios_transform_generate_read_subrequests(&stage_req, stage_pg);
+
+    // Answer the stage's raw reads from memory, then complete them in the
+    // same way adios_transform_process_all_reads does
+    for (subreq = stage_pg->subreqs; subreq; subreq = subreq->next) {
+        const ADIOS_SELECTION_WRITEBLOCK_STRUCT *wb = &subreq->raw_sel->u.block;
+        uint64_t start = 0, count = stage_pg->raw_var_length;
+
+        assert(subreq->raw_sel->type == ADIOS_SELECTION_WRITEBLOCK);
+        if (wb->is_sub_pg_selection) {
+            start = wb->element_offset;
+            count = wb->nelements;
+        }
+        assert(start + count <= stage_pg->raw_var_length);
+        memcpy(subreq->data, input + start, count);
+    }
+
+    for (subreq = stage_pg->subreqs; subreq; subreq = subreq->next) {
+        adios_transform_raw_read_request_mark_complete(&stage_req, stage_pg, subreq);
+        keep_single_datablock(&result, adios_transform_subrequest_completed(&stage_req, stage_pg, subreq));
+    }
+
+    if (stage_pg->completed)
+        keep_single_datablock(&result, adios_transform_pg_reqgroup_completed(&stage_req, stage_pg));
+    if (stage_req.completed)
+        keep_single_datablock(&result, adios_transform_read_reqgroup_completed(&stage_req));
+
+    // Release the stage's subrequests and private state
+    while ((subreq = adios_transform_raw_read_request_pop(stage_pg)) != NULL)
+        adios_transform_raw_read_request_free(&subreq);
+    MYFREE(stage_pg->transform_internal);
+    MYFREE(stage_req.transform_internal);
+
+    return result;
+}
+
+adios_datablock * adios_transform_pipeline_pg_reqgroup_completed(adios_transform_read_request *reqgroup,
+                                                                 adios_transform_pg_read_request *completed_pg_reqgroup)
+{
+    struct adios_transform_pipeline_stage stages[ADIOS_TRANSFORM_PIPELINE_MAX_STAGES];
+    const int nstages = adios_transform_pipeline_parse_metadata(completed_pg_reqgroup->transform_metadata,
+                                                                completed_pg_reqgroup->transform_metadata_len,
+                                                                stages, ADIOS_TRANSFORM_PIPELINE_MAX_STAGES);
+    adios_datablock *result = NULL;
+    int k;
+
+    if (nstages <= 0) {
+        adios_error(err_invalid_transform_type, "Invalid transform pipeline metadata in block %d\n",
+                    completed_pg_reqgroup->blockidx);
+        return NULL;
+    }
+    if (stages[nstages - 1].output_len != completed_pg_reqgroup->raw_var_length) {
+        adios_error(err_invalid_transform_type, "Transform pipeline metadata in block %d does not match "
+                    "the stored data length\n", completed_pg_reqgroup->blockidx);
+        return NULL;
+    }
+    for (k = 0; k < nstages; k++) {
+        if (!adios_transform_is_implemented(stages[k].transform_type)) {
+            adios_error(err_operation_not_supported, "Transform pipeline stage %s is not supported for read "
+                        "in this configuration of ADIOS\n", adios_transform_plugin_uid(stages[k].transform_type));
+            return NULL;
+        }
+    }
+
+    // Take ownership of the stored (fully transformed) bytes
+    char *cur_data = completed_pg_reqgroup->subreqs->data;
+    completed_pg_reqgroup->subreqs->data = NULL;
+
+    // Undo the stages last-to-first
+    for (k = nstages - 1; k >= 0 && cur_data; k--) {
+        const struct adios_transform_pipeline_stage *stage = &stages[k];
+        ADIOS_TRANSINFO stage_transinfo = *reqgroup->transinfo;
+        adios_transform_pg_read_request stage_pg = *completed_pg_reqgroup;
+        adios_datablock *stage_result;
+
+        stage_transinfo.transform_type = stage->transform_type;
+        stage_transinfo.transform_metadata = stage->metadata;
+        stage_transinfo.transform_metadata_len = stage->metadata_len;
+
+        stage_pg.completed = 0;
+        stage_pg.raw_var_length = stage->output_len;
+        stage_pg.transform_metadata = stage->metadata;
+        stage_pg.transform_metadata_len = stage->metadata_len;
+        stage_pg.num_subreqs = 0;
+        stage_pg.num_completed_subreqs = 0;
+        stage_pg.subreqs = NULL;
+        stage_pg.transform_internal = NULL;
+        stage_pg.next = NULL;
+
+        if (k == 0) {
+            // The first stage restores the user's view, so it sees the real selection
+            result = run_stage(reqgroup, &stage_transinfo, &stage_pg,
+                               reqgroup->read_param, reqgroup->orig_sel, cur_data);
+            MYFREE(cur_data);
+            break;
+        }
+
+        // Inner stages decode to the whole 1D byte array fed into them at write time
+        uint64_t in_len = stages[k - 1].output_len;
+        uint64_t zero = 0;
+        ADIOS_VARBLOCK byte_vb = *completed_pg_reqgroup->orig_varblock;
+        ADIOS_SELECTION *byte_sel = a2sel_boundingbox(1, &zero, &in_len);
+
+        byte_vb.start = &zero;
+        byte_vb.count = &in_len;
+
+        stage_transinfo.orig_type = adios_byte;
+        stage_transinfo.orig_ndim = 1;
+        stage_transinfo.orig_dims = &in_len;
+        stage_transinfo.orig_global = 0;
+        stage_transinfo.orig_blockinfo = NULL;
+        stage_transinfo.transform_metadatas = NULL;
+
+        stage_pg.orig_ndim = 1;
+        stage_pg.orig_varblock = &byte_vb;
+        stage_pg.pg_bounds_sel = byte_sel;
+        stage_pg.pg_intersection_sel = byte_sel;
+
+        stage_result = run_stage(reqgroup, &stage_transinfo, &stage_pg, NULL, byte_sel, cur_data);
+        a2sel_free(byte_sel);
+        MYFREE(cur_data);
+
+        if (stage_result) {
+            assert(stage_result->ragged_offset == 0);
+            cur_data = stage_result->data;
+            adios_datablock_free(&stage_result, 0);
+        }
+    }
+
+    if (!result)
+        adios_error(err_invalid_transform_type, "Failed to undo the transform pipeline for block %d\n",
+                    completed_pg_reqgroup->blockidx);
+    return result;
+}
+
+adios_datablock * adios_transform_pipeline_reqgroup_completed(adios_transform_read_request *completed_reqgroup)
+{
+    return NULL;
+}
+
+#undef MYFREE
@@ -0,0 +1,245 @@
+/*
+ * adios_transform_pipeline_write.c
+ *
+ * The "pipeline" transform applies an ordered chain of other transforms to a
+ * variable, e.g. transform="aplod|zlib:5" first splits the values into byte
+ * columns with APLOD and then compresses those bytes with zlib. Each stage is run through its own plugin's
+ * apply function; every stage after the first sees its input as a 1D byte
+ * array holding the previous stage's output. Only the last stage may write
+ * into the ADIOS shared buffer.
+ *
+ * The per-stage transform metadata is recorded in the pipeline's metadata
+ * (see adios_transforms_common.h for the layout), so that the stages can be
+ * undone in reverse order on read.
+ */
+
+#include <stdint.h>
+#include <inttypes.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+#include <math.h>
+
+#include "core/adios_logger.h"
+#include "core/adios_internals.h"
+#include "core/transforms/adios_transforms_common.h"
+#include "core/transforms/adios_transforms_write.h"
+#include "core/transforms/adios_transforms_hooks_write.h"
+#include "core/transforms/adios_transforms_specparse.h"
+
+// Splits the pipeline spec into one parsed spec per stage; returns the number
+// of stages. The stage specs must be released with clear_pipeline_stages.
+static int parse_pipeline_stages(const struct adios_transform_spec *transform_spec,
+                                 struct adios_transform_spec *stages)
+{
+    char *chain = strdup(transform_spec->transform_type_str);
+    char *stage_str = chain;
+    int nstages = 0;
+
+    while (stage_str && nstages < ADIOS_TRANSFORM_PIPELINE_MAX_STAGES) {
+        char *next_stage = strchr(stage_str, '|');
+        if (next_stage)
+            *next_stage++ = '\0';
+
+        memset(&stages[nstages], 0, sizeof(struct adios_transform_spec));
+        adios_transform_parse_spec(stage_str, &stages[nstages]);
+        nstages++;
+
+        stage_str = next_stage;
+    }
+
+    free(chain);
+    return nstages;
+}
+
+static void clear_pipeline_stages(struct adios_transform_spec *stages, int nstages)
+{
+    int i;
+    for (i = 0; i < nstages; i++)
+        adios_transform_clear_spec(&stages[i]);
+}
+
+uint16_t adios_transform_pipeline_get_metadata_size(struct adios_transform_spec *transform_spec)
+{
+    struct adios_transform_spec stages[ADIOS_TRANSFORM_PIPELINE_MAX_STAGES];
+    const int nstages = parse_pipeline_stages(transform_spec, stages);
+    uint64_t size = sizeof(uint8_t); // Stage count
+    int i;
+
+    for (i = 0; i < nstages; i++) {
+        const uint16_t stage_metadata_len = adios_transform_get_metadata_size(&stages[i]);
+        size += adios_transform_pipeline_stage_record_size(stages[i].transform_type, stage_metadata_len);
+    }
+    clear_pipeline_stages(stages, nstages);
+
+    if (size > UINT16_MAX) {
+        adios_error(err_invalid_transform_type,
+                    "Transform pipeline \"%s\" needs %" PRIu64 " bytes of metadata, "
+                    "more than the %d bytes allowed per variable\n",
+                    transform_spec->transform_type_str, size, UINT16_MAX);
+        return 0;
+    }
+    return (uint16_t)size;
+}
+
+void adios_transform_pipeline_transformed_size_growth(
+        const struct adios_var_struct *var, const struct adios_transform_spec *transform_spec,
+        uint64_t *constant_factor, double *linear_factor, double *capped_linear_factor, uint64_t *capped_linear_cap)
+{
+    struct adios_transform_spec stages[ADIOS_TRANSFORM_PIPELINE_MAX_STAGES];
+    const int nstages = parse_pipeline_stages(transform_spec, stages);
+    uint64_t total_constant = 0;
+    double total_linear = 1;
+    int i;
+
+    // Each stage bounds its output as c + l*X + cl*min(X, cap) <= c + (l + cl)*X
+    // for an input of X bytes; compose these bounds in stage order. The stage
+    // factors are evaluated against the variable's original layout.
+    for (i = 0; i < nstages; i++) {
+        uint64_t c = 0, cap = 0;
+        double l = 1, cl = 0;
+
+        TRANSFORM_WRITE_METHODS[stages[i].transform_type].transform_transformed_size_growth(
+                var, &stages[i], &c, &l, &cl, &cap);
+
+        total_constant = c + (uint64_t)ceil((l + cl) * total_constant);
+        total_linear *= (l + cl);
+    }
+    clear_pipeline_stages(stages, nstages);
+
+    *constant_factor = total_constant;
+    *linear_factor = total_linear;
+}
+
+int adios_transform_pipeline_apply(struct adios_file_struct *fd,
+                                   struct adios_var_struct *var,
+                                   uint64_t *transformed_len,
+                                   int use_shared_buffer,
+                                   int *wrote_to_shared_buffer)
+{
+    assert(var->transform_type == adios_transform_pipeline);
+
+    struct adios_transform_spec stages[ADIOS_TRANSFORM_PIPELINE_MAX_STAGES];
+    const int nstages = parse_pipeline_stages(var->transform_spec, stages);
+
+    // Save the variable fields that each stage temporarily takes over
+    struct adios_transform_spec *pipeline_spec = var->transform_spec;
+    void *pipeline_metadata = var->transform_metadata;
+    const uint16_t pipeline_metadata_len = var->transform_metadata_len;
+    const enum ADIOS_DATATYPES orig_pre_transform_type = var->pre_transform_type;
+    struct adios_dimension_struct *orig_pre_transform_dims = var->pre_transform_dimensions;
+    const void *orig_data = var->data;
+    void *orig_adata = var->adata;
+    const enum ADIOS_FLAG orig_free_data = var->free_data;
+
+    // Stages after the first see the previous output as a local 1D byte array
+    struct adios_dimension_struct byte_dim;
+    memset(&byte_dim, 0, sizeof(byte_dim));
+    byte_dim.dimension.is_time_index = adios_flag_no;
+    byte_dim.global_dimension.is_time_index = adios_flag_no;
+    byte_dim.local_offset.is_time_index = adios_flag_no;
+
+    void *cur_data = (void *)orig_data;
+    uint64_t cur_len = adios_transform_get_pre_transform_var_size(var);
+    int cur_owned = 0;
+    int success = 1;
+    int i;
+
+    *wrote_to_shared_buffer = 0;
+
+    if (!pipeline_metadata || pipeline_metadata_len != adios_transform_pipeline_get_metadata_size(pipeline_spec)) {
+        adios_error(err_invalid_transform_type, "Transform pipeline \"%s\" for variable %s has an unexpected metadata size\n",
+                    pipeline_spec->transform_type_str, var->name);
+        clear_pipeline_stages(stages, nstages);
+        return 0;
+    }
+
+    char *md = (char *)pipeline_metadata;
+    *(uint8_t *)md = (uint8_t)nstages;
+    md += sizeof(uint8_t);
+
+    for (i = 0; i < nstages; i++) {
+        const int is_last_stage = (i == nstages - 1);
+        const char *uid = adios_transform_plugin_uid(stages[i].transform_type);
+        const uint8_t uid_len = (uint8_t)strlen(uid);
+        const uint16_t stage_metadata_len = adios_transform_get_metadata_size(&stages[i]);
+        char *output_len_pos;
+        uint64_t stage_output_len = 0;
+        int stage_wrote_to_shared_buffer = 0;
+
+        // Stage record header
+        memcpy(md, &uid_len, sizeof(uint8_t));
+        md += sizeof(uint8_t);
+        memcpy(md, uid, uid_len);
+        md += uid_len;
+        output_len_pos = md;
+        md += sizeof(uint64_t);
+        memcpy(md, &stage_metadata_len, sizeof(uint16_t));
+        md += sizeof(uint16_t);
+
+        // Point the variable at this stage's spec, metadata slot and input
+        var->transform_type = stages[i].transform_type;
+        var->transform_spec = &stages[i];
+        var->transform_metadata = stage_metadata_len ? md : NULL;
+        var->transform_metadata_len = stage_metadata_len;
+        md += stage_metadata_len;
+
+        var->data = cur_data;
+        var->adata = NULL;
+        var->free_data = adios_flag_no;
+        if (i > 0) {
+            byte_dim.dimension.rank = cur_len;
+            var->pre_transform_type = adios_byte;
+            var->pre_transform_dimensions = &byte_dim;
+        }
+
+        if (!adios_transform_apply(fd, var, &stage_output_len,
+                                   is_last_stage && use_shared_buffer,
+                                   &stage_wrote_to_shared_buffer)) {
+            success = 0;
+            break;
+        }
+        memcpy(output_len_pos, &stage_output_len, sizeof(uint64_t));
+
+        if (stage_wrote_to_shared_buffer) {
+            assert(is_last_stage);
+            *wrote_to_shared_buffer = 1;
+        } else if (var->adata && var->adata != cur_data) {
+            // The stage allocated a new output buffer
+            if (cur_owned)
+                free(cur_data);
+            cur_data = var->adata;
+            cur_owned = (var->free_data == adios_flag_yes);
+        }
+        // else: the stage passed its input through unchanged (e.g., identity)
+
+        cur_len = stage_output_len;
+    }
+
+    // Restore the pipeline view of the variable
+    var->transform_type = adios_transform_pipeline;
+    var->transform_spec = pipeline_spec;
+    var->transform_metadata = pipeline_metadata;
+    var->transform_metadata_len = pipeline_metadata_len;
+    var->pre_transform_type = orig_pre_transform_type;
+    var->pre_transform_dimensions = orig_pre_transform_dims;
+    var->data = orig_data;
+    clear_pipeline_stages(stages, nstages);
+
+    if (success && !*wrote_to_shared_buffer && cur_data != orig_data) {
+        var->adata = cur_data;
+        var->data_size = cur_len;
+        var->free_data = cur_owned ? adios_flag_yes : adios_flag_no;
+    } else {
+        if (cur_owned)
+            free(cur_data);
+        var->adata = orig_adata;
+        var->free_data = orig_free_data;
+    }
+
+    if (!success)
+        return 0;
+
+    *transformed_len = cur_len;
+    return 1;
+}
@@ -0,0 +1,60 @@
+/*
+ * adios_transform_shuffle_common.h
+ *
+ * Layout shared by the write and read sides of the "shuffle" transform.
+ *
+ * The transform regroups the bytes of a variable so that like-significance
+ * bytes of neighboring values end up next to each other, which makes the
+ * data far more compressible by a following lossless compressor. For N
+ * elements of S bytes each:
+ *
+ *   byte mode: the output is S rows of N bytes; row j holds byte j of every
+ *              element (out[j*N + i] = in[i*S + j]).
+ *   bit mode:  only the first N8 = N rounded down to a multiple of 8 elements
+ *              are shuffled. Byte row j is further split into 8 bit planes of
+ *              N8/8 bytes each; bit k of byte g of plane (8*j + b) is bit b of
+ *              byte j of element 8*g + k.
+ *
+ * Any bytes that do not belong to a shuffled element are stored unchanged
+ * after the shuffled ones, so the output is always the same size as the input.
+ */
+#ifndef ADIOS_TRANSFORM_SHUFFLE_COMMON_H
+#define ADIOS_TRANSFORM_SHUFFLE_COMMON_H
+
+#include <stdint.h>
+
+enum ADIOS_SHUFFLE_MODE {
+    adios_shuffle_byte = 0,
+    adios_shuffle_bit  = 1
+};
+
+/* Metadata: original data size (uint64_t) + element size (uint8_t) + mode (uint8_t) */
+#define ADIOS_SHUFFLE_METADATA_SIZE (sizeof(uint64_t) + 2 * sizeof(uint8_t))
+
+/* Element sizes must fit in the uint8_t metadata field */
+#define ADIOS_SHUFFLE_MAX_ELEMENT_SIZE 255
+
+/* Number of leading elements of a len-byte buffer that are shuffled */
+static inline uint64_t adios_shuffle_num_elements(uint64_t len, unsigned elem_size, enum ADIOS_SHUFFLE_MODE mode)
+{
+    const uint64_t n = len / elem_size;
+    return (mode == adios_shuffle_bit) ? (n & ~(uint64_t)7) : n;
+}
+
+/*
+ * Transposes an 8x8 bit matrix held one row per byte (row k in bits 8k..8k+7):
+ * on return, bit k of row b is what bit b of row k was on entry.
+ */
+static inline uint64_t adios_shuffle_transpose8x8(uint64_t x)
+{
+    uint64_t t;
+    t = (x ^ (x >> 7)) & 0x00AA00AA00AA00AAULL;
+    x = x ^ t ^ (t << 7);
+    t = (x ^ (x >> 14)) & 0x0000CCCC0000CCCCULL;
+    x = x ^ t ^ (t << 14);
+    t = (x ^ (x >> 28)) & 0x00000000F0F0F0F0ULL;
+    x = x ^ t ^ (t << 28);
+    return x;
+}
+
+#endif /* ADIOS_TRANSFORM_SHUFFLE_COMMON_H */
@@ -0,0 +1,266 @@
+/*
+ * adios_transform_shuffle_read.c
+ *
+ * Read side of the "shuffle" transform: undoes the byte (and bit) transpose
+ * done by adios_transform_shuffle_write.c, using AVX2 or SSE2 kernels when
+ * the compiler targets them.
+ */
+
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <assert.h>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+#if defined(__AVX2__)
+#include <immintrin.h>
+#endif
+
+#include "core/util.h"
+#include "core/adios_logger.h"
+#include "core/transforms/adios_transforms_hooks_read.h"
+#include "core/transforms/adios_transforms_reqgroup.h"
+#include "core/adios_internals.h" // adios_get_type_size()
+#include "adios_transform_shuffle_common.h"
+
+/*
+ * The vector kernels are the exact inverse of the ones on the write side:
+ * starting from the S byte rows of W elements, stream s and stream
+ * s + nstreams are interleaved byte by byte log2(S) times, which leaves the W
+ * elements in their original layout.
+ */
+
+#if defined(__AVX2__)
+// Processes elements [start, n) 32 at a time; returns the first element not processed
+static inline uint64_t unshuffle_bytes_avx2(const uint8_t *in, uint8_t *out, uint64_t n, unsigned elem_size, uint64_t start)
+{
+    __m256i bufs[2][16];
+    uint64_t i;
+
+    for (i = start; i + 32 <= n; i += 32) {
+        __m256i *cur = bufs[0], *next = bufs[1], *swap;
+        unsigned j, k, s, nstreams;
+
+        for (j = 0; j < elem_size; j++)
+            cur[j] = _mm256_loadu_si256((const __m256i *)(in + j * n + i));
+
+        for (nstreams = elem_size / 2; nstreams >= 1; nstreams /= 2) {
+            const unsigned half = elem_size / nstreams / 2; // Vectors per stream before the merge
+            for (s = 0; s < nstreams; s++) {
+                const __m256i *even = cur + half * s;
+                const __m256i *odd = cur + half * (s + nstreams);
+                __m256i *dst = next + 2 * half * s;
+                for (k = 0; k < half; k++) {
+                    // unpack works within 128-bit lanes; 0xD8 lines up the quarters it reads
+                    const __m256i e = _mm256_permute4x64_epi64(even[k], 0xD8);
+                    const __m256i o = _mm256_permute4x64_epi64(odd[k], 0xD8);
+                    dst[2 * k] = _mm256_unpacklo_epi8(e, o);
+                    dst[2 * k + 1] = _mm256_unpackhi_epi8(e, o);
+                }
+            }
+            swap = cur; cur = next; next = swap;
+        }
+
+        for (j = 0; j < elem_size; j++)
+            _mm256_storeu_si256((__m256i *)(out + i * elem_size + 32 * j), cur[j]);
+    }
+    return i;
+}
+#endif
+
+#if defined(__SSE2__)
+// Processes elements [start, n) 16 at a time; returns the first element not processed
+static inline uint64_t unshuffle_bytes_sse2(const uint8_t *in, uint8_t *out, uint64_t n, unsigned elem_size, uint64_t start)
+{
+    __m128i bufs[2][16];
+    uint64_t i;
+
+    for (i = start; i + 16 <= n; i += 16) {
+        __m128i *cur = bufs[0], *next = bufs[1], *swap;
+        unsigned j, k, s, nstreams;
+
+        for (j = 0; j < elem_size; j++)
+            cur[j] = _mm_loadu_si128((const __m128i *)(in + j * n + i));
+
+        for (nstreams = elem_size / 2; nstreams >= 1; nstreams /= 2) {
+            const unsigned half = elem_size / nstreams / 2; // Vectors per stream before the merge
+            for (s = 0; s < nstreams; s++) {
+                const __m128i *even = cur + half * s;
+                const __m128i *odd = cur + half * (s + nstreams);
+                __m128i *dst = next + 2 * half * s;
+                for (k = 0; k < half; k++) {
+                    dst[2 * k] = _mm_unpacklo_epi8(even[k], odd[k]);
+                    dst[2 * k + 1] = _mm_unpackhi_epi8(even[k], odd[k]);
+                }
+            }
+            swap = cur; cur = next; next = swap;
+        }
+
+        for (j = 0; j < elem_size; j++)
+            _mm_storeu_si128((__m128i *)(out + i * elem_size + 16 * j), cur[j]);
+    }
+    return i;
+}
+#endif
+
+// out[i*elem_size + j] = in[j*n + i] for the n elements of out
+static void unshuffle_bytes(const uint8_t *in, uint8_t *out, uint64_t n, unsigned elem_size)
+{
+    uint64_t i, done = 0;
+    unsigned j;
+
+    if (elem_size <= 16 && (elem_size & (elem_size - 1)) == 0) {
+#if defined(__AVX2__)
+        switch (elem_size) {
+        // Constant element sizes let the compiler unroll the kernel completely
+        case 1:  done = unshuffle_bytes_avx2(in, out, n, 1, done); break;
+        case 2:  done = unshuffle_bytes_avx2(in, out, n, 2, done); break;
+        case 4:  done = unshuffle_bytes_avx2(in, out, n, 4, done); break;
+        case 8:  done = unshuffle_bytes_avx2(in, out, n, 8, done); break;
+        case 16: done = unshuffle_bytes_avx2(in, out, n, 16, done); break;
+        }
+#endif
+#if defined(__SSE2__)
+        switch (elem_size) {
+        // Constant element sizes let the compiler unroll the kernel completely
+        case 1:  done = unshuffle_bytes_sse2(in, out, n, 1, done); break;
+        case 2:  done = unshuffle_bytes_sse2(in, out, n, 2, done); break;
+        case 4:  done = unshuffle_bytes_sse2(in, out, n, 4, done); break;
+        case 8:  done = unshuffle_bytes_sse2(in, out, n, 8, done); break;
+        case 16: done = unshuffle_bytes_sse2(in, out, n, 16, done); break;
+        }
+#endif
+    }
+
+    for (j = 0; j < elem_size; j++) {
+        const uint8_t *row = in + j * n;
+        for (i = done; i < n; i++)
+            out[i * elem_size + j] = row[i];
+    }
+}
+
+// Rebuilds nrows rows of n bytes (n a multiple of 8) from their 8 bit planes of n/8 bytes each
+static void bitplanes_to_rows(const uint8_t *in, uint8_t *rows, unsigned nrows, uint64_t n)
+{
+    const uint64_t plane_len = n / 8;
+    unsigned r, b, k;
+    uint64_t i;
+
+    for (r = 0; r < nrows; r++) {
+        const uint8_t *planes = in + 8 * r * plane_len;
+        uint8_t *row = rows + r * n;
+
+        i = 0;
+#if defined(__SSE2__)
+        for (; i + 16 <= n; i += 16) {
+            // Byte b holds plane b's bits for elements i..i+7, byte 8+b those for i+8..i+15;
+            // the top bit of every byte then gives one output byte of each half
+            __m128i x = _mm_setr_epi8(
+                    planes[0 * plane_len + i / 8], planes[1 * plane_len + i / 8],
+                    planes[2 * plane_len + i / 8], planes[3 * plane_len + i / 8],
+                    planes[4 * plane_len + i / 8], planes[5 * plane_len + i / 8],
+                    planes[6 * plane_len + i / 8], planes[7 * plane_len + i / 8],
+                    planes[0 * plane_len + i / 8 + 1], planes[1 * plane_len + i / 8 + 1],
+                    planes[2 * plane_len + i / 8 + 1], planes[3 * plane_len + i / 8 + 1],
+                    planes[4 * plane_len + i / 8 + 1], planes[5 * plane_len + i / 8 + 1],
+                    planes[6 * plane_len + i / 8 + 1], planes[7 * plane_len + i / 8 + 1]);
+            for (k = 8; k-- > 0; ) {
+                const uint32_t bits = (uint32_t)_mm_movemask_epi8(x);
+                row[i + k] = (uint8_t)bits;
+                row[i + 8 + k] = (uint8_t)(bits >> 8);
+                x = _mm_add_epi8(x, x);
+            }
+        }
+#endif
+        for (; i < n; i += 8) {
+            uint64_t x = 0;
+            for (b = 0; b < 8; b++)
+                x |= (uint64_t)planes[b * plane_len + i / 8] << (8 * b);
+            x = adios_shuffle_transpose8x8(x);
+            for (k = 0; k < 8; k++)
+                row[i + k] = (uint8_t)(x >> (8 * k));
+        }
+    }
+}
+
+int adios_transform_shuffle_is_implemented (void) {return 1;}
+
+int adios_transform_shuffle_generate_read_subrequests(adios_transform_read_request *reqgroup,
+                                                      adios_transform_pg_read_request *pg_reqgroup)
+{
+    void *buf = malloc(pg_reqgroup->raw_var_length);
+    assert(buf);
+    adios_transform_raw_read_request *subreq = adios_transform_raw_read_request_new_whole_pg(pg_reqgroup, buf);
+    adios_transform_raw_read_request_append(pg_reqgroup, subreq);
+    return 0;
+}
+
+// Do nothing for individual subrequest
+adios_datablock * adios_transform_shuffle_subrequest_completed(adios_transform_read_request *reqgroup,
+                                                               adios_transform_pg_read_request *pg_reqgroup,
+                                                               adios_transform_raw_read_request *completed_subreq)
+{
+    return NULL;
+}
+
+adios_datablock * adios_transform_shuffle_pg_reqgroup_completed(adios_transform_read_request *reqgroup,
+                                                                adios_transform_pg_read_request *completed_pg_reqgroup)
+{
+    const uint8_t *shuffled_data = (const uint8_t *)completed_pg_reqgroup->subreqs->data;
+    const uint64_t shuffled_size = completed_pg_reqgroup->raw_var_length;
+
+    if (completed_pg_reqgroup->transform_metadata_len < ADIOS_SHUFFLE_METADATA_SIZE) {
+        adios_error(err_invalid_transform_type, "Invalid shuffle transform metadata in block %d\n",
+                    completed_pg_reqgroup->blockidx);
+        return NULL;
+    }
+
+    const char *md = (const char *)completed_pg_reqgroup->transform_metadata;
+    uint64_t orig_size_meta;
+    uint8_t elem_size, mode;
+    memcpy(&orig_size_meta, md, sizeof(uint64_t));
+    memcpy(&elem_size, md + sizeof(uint64_t), sizeof(uint8_t));
+    memcpy(&mode, md + sizeof(uint64_t) + sizeof(uint8_t), sizeof(uint8_t));
+
+    uint64_t orig_size = adios_get_type_size(reqgroup->transinfo->orig_type, "");
+    int d;
+    for (d = 0; d < reqgroup->transinfo->orig_ndim; d++)
+        orig_size *= (uint64_t)(completed_pg_reqgroup->orig_varblock->count[d]);
+
+    if (orig_size_meta != orig_size || shuffled_size != orig_size || elem_size == 0 ||
+        (mode != adios_shuffle_byte && mode != adios_shuffle_bit)) {
+        adios_error(err_invalid_transform_type, "Shuffle transform metadata in block %d does not match "
+                    "the stored data\n", completed_pg_reqgroup->blockidx);
+        return NULL;
+    }
+
+    uint8_t *orig_data = (uint8_t *)malloc(orig_size);
+    if (!orig_data)
+        return NULL;
+
+    const uint64_t nelems = adios_shuffle_num_elements(orig_size, elem_size, (enum ADIOS_SHUFFLE_MODE)mode);
+    const uint64_t nshuffled = nelems * elem_size;
+
+    if (mode == adios_shuffle_bit && nelems > 0) {
+        uint8_t *rows = (uint8_t *)malloc(nshuffled);
+        if (!rows) {
+            free(orig_data);
+            return NULL;
+        }
+        bitplanes_to_rows(shuffled_data, rows, elem_size, nelems);
+        unshuffle_bytes(rows, orig_data, nelems, elem_size);
+        free(rows);
+    } else {
+        unshuffle_bytes(shuffled_data, orig_data, nelems, elem_size);
+    }
+    memcpy(orig_data + nshuffled, shuffled_data + nshuffled, orig_size - nshuffled);
+
+    return adios_datablock_new_whole_pg(reqgroup, completed_pg_reqgroup, orig_data);
+}
+
+adios_datablock * adios_transform_shuffle_reqgroup_completed(adios_transform_read_request *completed_reqgroup)
+{
+    return NULL;
+}
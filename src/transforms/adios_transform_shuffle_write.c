@@ -0,0 +1,318 @@
+/*
+ * adios_transform_shuffle_write.c
+ *
+ * Write side of the "shuffle" transform (see adios_transform_shuffle_common.h
+ * for the data layout). transform="shuffle" transposes the bytes of each
+ * element, transform="shuffle:bit" additionally transposes the bits within
+ * each byte row. The element size defaults to the size of the variable's type
+ * and can be overridden with "typesize=N", which is useful when shuffle is not
+ * the first stage of a pipeline (later stages see a byte array).
+ *
+ * The byte transpose uses AVX2 or SSE2 kernels when the compiler targets
+ * them, for element sizes of 1, 2, 4, 8 and 16 bytes; anything else, and the
+ * elements left over after the vector loop, goes through the scalar code.
+ */
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <inttypes.h>
+#include <assert.h>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+#if defined(__AVX2__)
+#include <immintrin.h>
+#endif
+
+#include "core/adios_logger.h"
+#include "core/transforms/adios_transforms_common.h"
+#include "core/transforms/adios_transforms_write.h"
+#include "core/transforms/adios_transforms_hooks_write.h"
+#include "core/transforms/adios_transforms_util.h"
+#include "core/bp_utils.h" // bp_get_type_size()
+#include "adios_transform_shuffle_common.h"
+
+/*
+ * The vector kernels load S vectors holding W consecutive S-byte elements and
+ * split them log2(S) times into their even and odd bytes. The even bytes of
+ * stream s stay in stream s and the odd ones move to stream s + nstreams, so
+ * that in the end stream j is byte j of the W elements.
+ */
+
+#if defined(__AVX2__)
+// Processes elements [start, n) 32 at a time; returns the first element not processed
+static inline uint64_t shuffle_bytes_avx2(const uint8_t *in, uint8_t *out, uint64_t n, unsigned elem_size, uint64_t start)
+{
+    const __m256i lo_mask = _mm256_set1_epi16(0x00FF);
+    __m256i bufs[2][16];
+    uint64_t i;
+
+    for (i = start; i + 32 <= n; i += 32) {
+        __m256i *cur = bufs[0], *next = bufs[1], *swap;
+        unsigned j, k, s, nstreams;
+
+        for (j = 0; j < elem_size; j++)
+            cur[j] = _mm256_loadu_si256((const __m256i *)(in + i * elem_size + 32 * j));
+
+        for (nstreams = 1; nstreams < elem_size; nstreams *= 2) {
+            const unsigned half = elem_size / nstreams / 2; // Vectors per stream after the split
+            for (s = 0; s < nstreams; s++) {
+                const __m256i *src = cur + 2 * half * s;
+                __m256i *even = next + half * s;
+                __m256i *odd = next + half * (s + nstreams);
+                for (k = 0; k < half; k++) {
+                    // packus interleaves the 128-bit lanes of its operands; 0xD8 puts them back in order
+                    even[k] = _mm256_permute4x64_epi64(
+                            _mm256_packus_epi16(_mm256_and_si256(src[2 * k], lo_mask),
+                                                _mm256_and_si256(src[2 * k + 1], lo_mask)), 0xD8);
+                    odd[k] = _mm256_permute4x64_epi64(
+                            _mm256_packus_epi16(_mm256_srli_epi16(src[2 * k], 8),
+                                                _mm256_srli_epi16(src[2 * k + 1], 8)), 0xD8);
+                }
+            }
+            swap = cur; cur = next; next = swap;
+        }
+
+        for (j = 0; j < elem_size; j++)
+            _mm256_storeu_si256((__m256i *)(out + j * n + i), cur[j]);
+    }
+    return i;
+}
+#endif
+
+#if defined(__SSE2__)
+// Processes elements [start, n) 16 at a time; returns the first element not processed
+static inline uint64_t shuffle_bytes_sse2(const uint8_t *in, uint8_t *out, uint64_t n, unsigned elem_size, uint64_t start)
+{
+    const __m128i lo_mask = _mm_set1_epi16(0x00FF);
+    __m128i bufs[2][16];
+    uint64_t i;
+
+    for (i = start; i + 16 <= n; i += 16) {
+        __m128i *cur = bufs[0], *next = bufs[1], *swap;
+        unsigned j, k, s, nstreams;
+
+        for (j = 0; j < elem_size; j++)
+            cur[j] = _mm_loadu_si128((const __m128i *)(in + i * elem_size + 16 * j));
+
+        for (nstreams = 1; nstreams < elem_size; nstreams *= 2) {
+            const unsigned half = elem_size / nstreams / 2; // Vectors per stream after the split
+            for (s = 0; s < nstreams; s++) {
+                const __m128i *src = cur + 2 * half * s;
+                __m128i *even = next + half * s;
+                __m128i *odd = next + half * (s + nstreams);
+                for (k = 0; k < half; k++) {
+                    even[k] = _mm_packus_epi16(_mm_and_si128(src[2 * k], lo_mask),
+                                               _mm_and_si128(src[2 * k + 1], lo_mask));
+                    odd[k] = _mm_packus_epi16(_mm_srli_epi16(src[2 * k], 8),
+                                              _mm_srli_epi16(src[2 * k + 1], 8));
+                }
+            }
+            swap = cur; cur = next; next = swap;
+        }
+
+        for (j = 0; j < elem_size; j++)
+            _mm_storeu_si128((__m128i *)(out + j * n + i), cur[j]);
+    }
+    return i;
+}
+#endif
+
+// out[j*n + i] = in[i*elem_size + j] for the n elements of in
+static void shuffle_bytes(const uint8_t *in, uint8_t *out, uint64_t n, unsigned elem_size)
+{
+    uint64_t i, done = 0;
+    unsigned j;
+
+    if (elem_size <= 16 && (elem_size & (elem_size - 1)) == 0) {
+#if defined(__AVX2__)
+        switch (elem_size) {
+        // Constant element sizes let the compiler unroll the kernel completely
+        case 1:  done = shuffle_bytes_avx2(in, out, n, 1, done); break;
+        case 2:  done = shuffle_bytes_avx2(in, out, n, 2, done); break;
+        case 4:  done = shuffle_bytes_avx2(in, out, n, 4, done); break;
+        case 8:  done = shuffle_bytes_avx2(in, out, n, 8, done); break;
+        case 16: done = shuffle_bytes_avx2(in, out, n, 16, done); break;
+        }
+#endif
+#if defined(__SSE2__)
+        switch (elem_size) {
+        // Constant element sizes let the compiler unroll the kernel completely
+        case 1:  done = shuffle_bytes_sse2(in, out, n, 1, done); break;
+        case 2:  done = shuffle_bytes_sse2(in, out, n, 2, done); break;
+        case 4:  done = shuffle_bytes_sse2(in, out, n, 4, done); break;
+        case 8:  done = shuffle_bytes_sse2(in, out, n, 8, done); break;
+        case 16: done = shuffle_bytes_sse2(in, out, n, 16, done); break;
+        }
+#endif
+    }
+
+    for (j = 0; j < elem_size; j++) {
+        uint8_t *row = out + j * n;
+        for (i = done; i < n; i++)
+            row[i] = in[i * elem_size + j];
+    }
+}
+
+// Splits each of the nrows rows of n bytes (n a multiple of 8) into 8 bit planes of n/8 bytes
+static void rows_to_bitplanes(const uint8_t *rows, uint8_t *out, unsigned nrows, uint64_t n)
+{
+    const uint64_t plane_len = n / 8;
+    unsigned r, b, k;
+    uint64_t i;
+
+    for (r = 0; r < nrows; r++) {
+        const uint8_t *row = rows + r * n;
+        uint8_t *planes = out + 8 * r * plane_len;
+
+        i = 0;
+#if defined(__AVX2__)
+        for (; i + 32 <= n; i += 32) {
+            __m256i x = _mm256_loadu_si256((const __m256i *)(row + i));
+            for (b = 8; b-- > 0; ) {
+                // Gather the top bit of each byte, then move the next bit up
+                const uint32_t bits = (uint32_t)_mm256_movemask_epi8(x);
+                uint8_t *dst = planes + b * plane_len + i / 8;
+                dst[0] = (uint8_t)bits;
+                dst[1] = (uint8_t)(bits >> 8);
+                dst[2] = (uint8_t)(bits >> 16);
+                dst[3] = (uint8_t)(bits >> 24);
+                x = _mm256_add_epi8(x, x);
+            }
+        }
+#endif
+#if defined(__SSE2__)
+        for (; i + 16 <= n; i += 16) {
+            __m128i x = _mm_loadu_si128((const __m128i *)(row + i));
+            for (b = 8; b-- > 0; ) {
+                const uint32_t bits = (uint32_t)_mm_movemask_epi8(x);
+                uint8_t *dst = planes + b * plane_len + i / 8;
+                dst[0] = (uint8_t)bits;
+                dst[1] = (uint8_t)(bits >> 8);
+                x = _mm_add_epi8(x, x);
+            }
+        }
+#endif
+        for (; i < n; i += 8) {
+            uint64_t x = 0;
+            for (k = 0; k < 8; k++)
+                x |= (uint64_t)row[i + k] << (8 * k);
+            x = adios_shuffle_transpose8x8(x);
+            for (b = 0; b < 8; b++)
+                planes[b * plane_len + i / 8] = (uint8_t)(x >> (8 * b));
+        }
+    }
+}
+
+uint16_t adios_transform_shuffle_get_metadata_size(struct adios_transform_spec *transform_spec)
+{
+    return ADIOS_SHUFFLE_METADATA_SIZE;
+}
+
+void adios_transform_shuffle_transformed_size_growth(
+        const struct adios_var_struct *var, const struct adios_transform_spec *transform_spec,
+        uint64_t *constant_factor, double *linear_factor, double *capped_linear_factor, uint64_t *capped_linear_cap)
+{
+    // Do nothing (defaults to "no transform effect on data size")
+}
+
+int adios_transform_shuffle_apply(struct adios_file_struct *fd,
+                                  struct adios_var_struct *var,
+                                  uint64_t *transformed_len,
+                                  int use_shared_buffer,
+                                  int *wrote_to_shared_buffer)
+{
+    // Assume this function is only called for the shuffle transform type
+    assert(var->transform_type == adios_transform_shuffle);
+
+    // Get the input data and data length
+    const uint64_t input_size = adios_transform_get_pre_transform_var_size(var);
+    const uint8_t *input_buff = (const uint8_t *)var->data;
+
+    // Parse the parameters
+    enum ADIOS_SHUFFLE_MODE mode = adios_shuffle_byte;
+    int elem_size = bp_get_type_size(var->pre_transform_type, "");
+    int i;
+
+    for (i = 0; i < var->transform_spec->param_count; i++) {
+        const struct adios_transform_spec_kv_pair *param = &var->transform_spec->params[i];
+        if (!strcmp(param->key, "bit")) {
+            mode = adios_shuffle_bit;
+        } else if (!strcmp(param->key, "byte")) {
+            mode = adios_shuffle_byte;
+        } else if (!strcmp(param->key, "typesize") && param->value) {
+            const int size = atoi(param->value);
+            if (size >= 1 && size <= ADIOS_SHUFFLE_MAX_ELEMENT_SIZE)
+                elem_size = size;
+            else
+                log_warn("Ignoring invalid shuffle typesize %s for variable %s\n", param->value, var->name);
+        } else {
+            log_warn("An unknown shuffle parameter: %s\n", param->key);
+        }
+    }
+    if (elem_size < 1 || elem_size > ADIOS_SHUFFLE_MAX_ELEMENT_SIZE)
+        elem_size = 1;
+
+    // decide the output buffer
+    uint64_t output_size = input_size;
+    uint8_t *output_buff = NULL;
+
+    if (use_shared_buffer) {
+        // If shared buffer is permitted, serialize to there
+        if (!shared_buffer_reserve(fd, output_size)) {
+            log_error("Out of memory allocating %" PRIu64 " bytes for %s for shuffle transform\n", output_size, var->name);
+            return 0;
+        }
+        output_buff = (uint8_t *)(fd->buffer + fd->offset);
+    } else { // Else, fall back to var->adata memory allocation
+        output_buff = (uint8_t *)malloc(output_size);
+        if (!output_buff) {
+            log_error("Out of memory allocating %" PRIu64 " bytes for %s for shuffle transform\n", output_size, var->name);
+            return 0;
+        }
+    }
+    *wrote_to_shared_buffer = use_shared_buffer;
+
+    // Shuffle the elements, then copy any leftover bytes as they are
+    const uint64_t nelems = adios_shuffle_num_elements(input_size, elem_size, mode);
+    const uint64_t shuffled_size = nelems * elem_size;
+
+    if (mode == adios_shuffle_bit && nelems > 0) {
+        uint8_t *rows = (uint8_t *)malloc(shuffled_size);
+        if (!rows) {
+            log_error("Out of memory allocating %" PRIu64 " bytes for %s for shuffle transform\n", shuffled_size, var->name);
+            if (!use_shared_buffer)
+                free(output_buff);
+            *wrote_to_shared_buffer = 0;
+            return 0;
+        }
+        shuffle_bytes(input_buff, rows, nelems, elem_size);
+        rows_to_bitplanes(rows, output_buff, elem_size, nelems);
+        free(rows);
+    } else {
+        shuffle_bytes(input_buff, output_buff, nelems, elem_size);
+    }
+    memcpy(output_buff + shuffled_size, input_buff + shuffled_size, input_size - shuffled_size);
+
+    // Wrap up, depending on buffer mode
+    if (*wrote_to_shared_buffer) {
+        shared_buffer_mark_written(fd, output_size);
+    } else {
+        var->adata = output_buff;
+        var->data_size = output_size;
+        var->free_data = adios_flag_yes;
+    }
+    *transformed_len = output_size; // Return the size of the data buffer
+
+    if (var->transform_metadata && var->transform_metadata_len > 0) {
+        const uint8_t elem_size_md = (uint8_t)elem_size;
+        const uint8_t mode_md = (uint8_t)mode;
+        memcpy((char*)var->transform_metadata, &input_size, sizeof(uint64_t));
+        memcpy((char*)var->transform_metadata + sizeof(uint64_t), &elem_size_md, sizeof(uint8_t));
+        memcpy((char*)var->transform_metadata + sizeof(uint64_t) + sizeof(uint8_t), &mode_md, sizeof(uint8_t));
+    }
+
+    return 1;
+}
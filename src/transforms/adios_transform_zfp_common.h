@@ -61,7 +61,7 @@ struct zfp_buffer
 	
 	char name[ZFP_STRSIZE]; 			// Name of variable
 	zfp_type type;					// data type
-	uint mode;					// 0 = accuracy, 1 = precsion, 2 = rate
+	uint mode;					// 0 = accuracy, 1 = precsion, 2 = rate, 3 = rate with random access
 	char ctol[ZFP_STRSIZE];				// string for "tolerance"
 	uint ndims; 					// number of dimensions
 	uint* dims;					// array of dimension sizes
@@ -105,11 +105,29 @@ static int zfp_get_datatype(struct zfp_buffer* zbuff, enum ADIOS_DATATYPES type)
 }
 
 
+/* Random access mode (3) is fixed rate, with the zfp field laid out like the array in memory:
+ * x is the fastest varying, i.e. last, dimension. Every 4^d block then takes the same number
+ * of bits, and blocks are stored with x varying fastest, then y, then z.
+ */
+#define ZFP_MODE_RANDOM_ACCESS 3
+
 /* Configure ZFP according to the user's specified mode and tolerance */
 static void zfp_initialize(void* array, struct zfp_buffer* zbuff)
 {
 	zbuff->zstream = zfp_stream_open(NULL);
 
+	/* ADIOS gives the dimensions slowest first, zfp wants x (fastest) first */
+	if (zbuff->mode == ZFP_MODE_RANDOM_ACCESS)
+	{
+		uint i, tmp;
+		for (i=0; i<zbuff->ndims/2; i++)
+		{
+			tmp = zbuff->dims[i];
+			zbuff->dims[i] = zbuff->dims[zbuff->ndims - 1 - i];
+			zbuff->dims[zbuff->ndims - 1 - i] = tmp;
+		}
+	}
+
 	/* set up the field dimensionality */
 	if (zbuff->ndims == 1)
 	{
@@ -174,7 +192,7 @@ static void zfp_initialize(void* array, struct zfp_buffer* zbuff)
 
 		zfp_stream_set_precision(zbuff->zstream, tol, zbuff->type);
 	}
-	else if (zbuff->mode == 2) 	// rate
+	else if (zbuff->mode == 2 || zbuff->mode == ZFP_MODE_RANDOM_ACCESS) 	// rate
 	{
 		double tol;
 		int success = sscanf(zbuff->ctol, "%lf", &tol);
@@ -99,6 +99,286 @@ static int zfp_decompression(struct zfp_buffer* zbuff, void* uarray, void* carra
 }
 
 
+/*
+ * Random access decoding
+ *
+ * In random access mode every zfp block takes the same number of bits, so the
+ * blocks that intersect a bounding box selection can be located, read and
+ * decoded on their own. Dimensions are indexed zfp style here (0 = x, the
+ * fastest varying); unused dimensions have extent 1.
+ */
+
+#define ZFP_RA_GAP (64 * 1024)	// merge byte ranges of blocks less than this far apart into one read
+
+#ifndef MIN
+#define MIN(a, b) ((a) < (b) ? (a) : (b))
+#endif
+#ifndef MAX
+#define MAX(a, b) ((a) > (b) ? (a) : (b))
+#endif
+
+struct zfp_ra_layout
+{
+	zfp_type type;
+	uint ndims;
+	double rate;		// bits per value, as given to zfp_stream_set_rate()
+	uint maxbits;		// bits per block
+	uint64_t size[3];	// PG extent
+	uint64_t start[3];	// selection start, relative to the PG
+	uint64_t count[3];	// selection extent
+	uint64_t nblocks[3];	// blocks in the PG
+	uint64_t bfirst[3];	// first intersecting block
+	uint64_t blast[3];	// last intersecting block
+};
+
+
+/* Returns 1, and fills in the layout, if only part of the PG is selected and it can be decoded on its own */
+static int zfp_ra_get_layout(const adios_transform_read_request *reqgroup, const adios_transform_pg_read_request *pg_reqgroup,
+		struct zfp_ra_layout *layout)
+{
+	struct zfp_metadata metadata;
+	int i;
+
+	if (pg_reqgroup->transform_metadata_len < 2*sizeof(uint64_t) + sizeof(uint) + 2*ZFP_STRSIZE)
+	{
+		return 0;
+	}
+	zfp_read_metadata(&metadata, (adios_transform_pg_read_request *) pg_reqgroup);
+	if (metadata.cmode != ZFP_MODE_RANDOM_ACCESS || sscanf(metadata.ctol, "%lf", &layout->rate) != 1)
+	{
+		return 0;
+	}
+
+	const ADIOS_SELECTION *sel = pg_reqgroup->pg_intersection_sel;
+	const ADIOS_SELECTION_BOUNDINGBOX_STRUCT *pgbb = &pg_reqgroup->pg_bounds_sel->u.bb;
+	const int ndims = reqgroup->transinfo->orig_ndim;
+	if (sel->type != ADIOS_SELECTION_BOUNDINGBOX || ndims < 1 || ndims > 3 || sel->u.bb.ndim != ndims)
+	{
+		return 0;
+	}
+	if (reqgroup->transinfo->orig_type == adios_double)
+	{
+		layout->type = zfp_type_double;
+	}
+	else if (reqgroup->transinfo->orig_type == adios_real)
+	{
+		layout->type = zfp_type_float;
+	}
+	else
+	{
+		return 0;
+	}
+
+	uint64_t selected = 1, total = 1;
+	for (i=0; i<3; i++)
+	{
+		const int d = ndims - 1 - i;	// ADIOS dimension of zfp dimension i
+		if (d >= 0)
+		{
+			layout->size[i] = pgbb->count[d];
+			layout->start[i] = sel->u.bb.start[d] - pgbb->start[d];
+			layout->count[i] = sel->u.bb.count[d];
+		}
+		else
+		{
+			layout->size[i] = 1;
+			layout->start[i] = 0;
+			layout->count[i] = 1;
+		}
+		if (layout->count[i] == 0)
+		{
+			return 0;
+		}
+		layout->nblocks[i] = (layout->size[i] + 3) / 4;
+		layout->bfirst[i] = layout->start[i] / 4;
+		layout->blast[i] = (layout->start[i] + layout->count[i] - 1) / 4;
+		selected *= layout->count[i];
+		total *= layout->size[i];
+	}
+	if (selected == total)
+	{
+		return 0;	// Whole PG: the regular full decompression is just as good
+	}
+
+	zfp_stream *zstream = zfp_stream_open(NULL);
+	zfp_stream_set_rate(zstream, layout->rate, layout->type, ndims, 0);
+	layout->maxbits = zstream->maxbits;
+	zfp_stream_close(zstream);
+	layout->ndims = ndims;
+
+	return 1;
+}
+
+
+/* One raw read of bytes [start, end) of the PG */
+static void zfp_ra_append_subrequest(adios_transform_pg_read_request *pg_reqgroup, uint64_t start, uint64_t end)
+{
+	void *buf = malloc(end - start);
+	assert(buf);
+	adios_transform_raw_read_request *subreq = adios_transform_raw_read_request_new_byte_segment(pg_reqgroup, start, end - start, buf);
+	adios_transform_raw_read_request_append(pg_reqgroup, subreq);
+}
+
+
+/* Bit offset of the block at (bx, by, bz) in the compressed stream */
+static uint64_t zfp_ra_block_offset(const struct zfp_ra_layout *layout, uint64_t bx, uint64_t by, uint64_t bz)
+{
+	return (bx + layout->nblocks[0] * (by + layout->nblocks[1] * bz)) * layout->maxbits;
+}
+
+
+/* Reads the byte ranges holding the intersecting blocks, one x-row of blocks at a time, merging close rows */
+static void zfp_ra_generate_subrequests(adios_transform_pg_read_request *pg_reqgroup, const struct zfp_ra_layout *layout)
+{
+	const uint64_t wordbytes = stream_word_bits / 8;
+	uint64_t by, bz;
+	uint64_t range_start = 0, range_end = 0;
+	int have_range = 0;
+
+	for (bz = layout->bfirst[2]; bz <= layout->blast[2]; bz++)
+	{
+		for (by = layout->bfirst[1]; by <= layout->blast[1]; by++)
+		{
+			/* Whole stream words, so that the bit stream never reads past a buffer */
+			uint64_t start = zfp_ra_block_offset(layout, layout->bfirst[0], by, bz) / stream_word_bits * wordbytes;
+			uint64_t end = (zfp_ra_block_offset(layout, layout->blast[0] + 1, by, bz) + stream_word_bits - 1) / stream_word_bits * wordbytes;
+			if (end > pg_reqgroup->raw_var_length)
+			{
+				end = pg_reqgroup->raw_var_length;
+			}
+
+			if (have_range && start <= range_end + ZFP_RA_GAP)
+			{
+				range_end = end;
+				continue;
+			}
+			if (have_range)
+			{
+				zfp_ra_append_subrequest(pg_reqgroup, range_start, range_end);
+			}
+			range_start = start;
+			range_end = end;
+			have_range = 1;
+		}
+	}
+	zfp_ra_append_subrequest(pg_reqgroup, range_start, range_end);
+}
+
+
+/* Returns 1 if the bytes read by the subrequest hold the bits [offset, offset + nbits) of the stream */
+static int zfp_ra_subrequest_holds(const adios_transform_raw_read_request *subreq, uint64_t offset, uint64_t nbits)
+{
+	const uint64_t start = subreq->raw_sel->u.block.element_offset * 8;
+	const uint64_t end = start + subreq->raw_sel->u.block.nelements * 8;
+	return start <= offset && offset + nbits <= end;
+}
+
+
+/* Decodes the intersecting blocks and copies the selected values into a new buffer shaped like the selection */
+static void* zfp_ra_decode(const adios_transform_pg_read_request *pg_reqgroup, const struct zfp_ra_layout *layout)
+{
+	const size_t elemsize = (layout->type == zfp_type_double) ? sizeof(double) : sizeof(float);
+	const adios_transform_raw_read_request *subreq = NULL;
+	bitstream *bstream = NULL;
+	uint64_t bx, by, bz, y, z;
+	double block[64];	// Large enough for 64 floats too
+	int ok = 1;
+
+	char *out = (char*) malloc(layout->count[0] * layout->count[1] * layout->count[2] * elemsize);
+	zfp_stream *zstream = zfp_stream_open(NULL);
+	if (!out || !zstream)
+	{
+		adios_error(err_no_memory, "Ran out of memory allocating buffers for ZFP random access decoding.\n");
+		free(out);
+		if (zstream) zfp_stream_close(zstream);
+		return NULL;
+	}
+	zfp_stream_set_rate(zstream, layout->rate, layout->type, layout->ndims, 0);
+
+	for (bz = layout->bfirst[2]; ok && bz <= layout->blast[2]; bz++)
+	{
+		for (by = layout->bfirst[1]; ok && by <= layout->blast[1]; by++)
+		{
+			for (bx = layout->bfirst[0]; bx <= layout->blast[0]; bx++)
+			{
+				const uint64_t offset = zfp_ra_block_offset(layout, bx, by, bz);
+
+				/* Subrequests are not kept in stream order; switch to the one holding this block */
+				if (!subreq || !zfp_ra_subrequest_holds(subreq, offset, layout->maxbits))
+				{
+					if (bstream)
+					{
+						stream_close(bstream);
+						bstream = NULL;
+					}
+					for (subreq = pg_reqgroup->subreqs; subreq; subreq = subreq->next)
+					{
+						if (zfp_ra_subrequest_holds(subreq, offset, layout->maxbits))
+						{
+							break;
+						}
+					}
+				}
+				if (!subreq)
+				{
+					adios_error(err_transform_failure, "ZFP random access decoding found no data read for a zfp block of block %d\n",
+							pg_reqgroup->blockidx);
+					ok = 0;
+					break;
+				}
+				if (!bstream)
+				{
+					bstream = stream_open(subreq->data, subreq->raw_sel->u.block.nelements);
+					zfp_stream_set_bit_stream(zstream, bstream);
+				}
+				stream_rseek(bstream, offset - subreq->raw_sel->u.block.element_offset * 8);
+
+				if (layout->type == zfp_type_double)
+				{
+					if (layout->ndims == 1) zfp_decode_block_double_1(zstream, block);
+					else if (layout->ndims == 2) zfp_decode_block_double_2(zstream, block);
+					else zfp_decode_block_double_3(zstream, block);
+				}
+				else
+				{
+					float *fblock = (float*) block;
+					if (layout->ndims == 1) zfp_decode_block_float_1(zstream, fblock);
+					else if (layout->ndims == 2) zfp_decode_block_float_2(zstream, fblock);
+					else zfp_decode_block_float_3(zstream, fblock);
+				}
+
+				/* Copy the part of the block inside the selection (which also keeps out the padding of partial blocks) */
+				const uint64_t x0 = MAX(4*bx, layout->start[0]), x1 = MIN(4*bx + 4, layout->start[0] + layout->count[0]);
+				const uint64_t y0 = MAX(4*by, layout->start[1]), y1 = MIN(4*by + 4, layout->start[1] + layout->count[1]);
+				const uint64_t z0 = MAX(4*bz, layout->start[2]), z1 = MIN(4*bz + 4, layout->start[2] + layout->count[2]);
+				for (z = z0; z < z1; z++)
+				{
+					for (y = y0; y < y1; y++)
+					{
+						const uint64_t outidx = ((z - layout->start[2]) * layout->count[1] + (y - layout->start[1])) * layout->count[0]
+							+ (x0 - layout->start[0]);
+						const uint64_t blockidx = (x0 - 4*bx) + 4 * (y - 4*by) + 16 * (z - 4*bz);
+						memcpy(out + outidx * elemsize, (char*) block + blockidx * elemsize, (x1 - x0) * elemsize);
+					}
+				}
+			}
+		}
+	}
+
+	if (bstream)
+	{
+		stream_close(bstream);
+	}
+	zfp_stream_close(zstream);
+	if (!ok)
+	{
+		free(out);
+		return NULL;
+	}
+	return out;
+}
+
+
 /* ZFP is installed */
 int adios_transform_zfp_is_implemented (void) {return 1;}
 
@@ -106,6 +386,13 @@ int adios_transform_zfp_is_implemented (void) {return 1;}
 /* Kept the default. I think this is piecing together how to read a "block" from smaller subrequests*/
 int adios_transform_zfp_generate_read_subrequests(adios_transform_read_request *reqgroup, adios_transform_pg_read_request *pg_reqgroup)
 {
+    struct zfp_ra_layout layout;
+    if (zfp_ra_get_layout(reqgroup, pg_reqgroup, &layout))
+    {
+        zfp_ra_generate_subrequests(pg_reqgroup, &layout);
+        return 0;
+    }
+
     void *buf = malloc(pg_reqgroup->raw_var_length);
     assert(buf);
     adios_transform_raw_read_request *subreq = adios_transform_raw_read_request_new_whole_pg(pg_reqgroup, buf);
@@ -130,6 +417,20 @@ adios_datablock * adios_transform_zfp_pg_reqgroup_completed(adios_transform_read
 	int success;	// was (a piece of) the decompression okay
 
 
+	/* Random access data: decode only the blocks that were read */
+	struct zfp_ra_layout layout;
+	if (zfp_ra_get_layout(reqgroup, completed_pg_reqgroup, &layout))
+	{
+		void* selected = zfp_ra_decode(completed_pg_reqgroup, &layout);
+		if (!selected)
+		{
+			return NULL;
+		}
+		return adios_datablock_new(reqgroup->transinfo->orig_type, completed_pg_reqgroup->timestep,
+				completed_pg_reqgroup->pg_intersection_sel, selected);
+	}
+
+
 	/* Get the transform metadata */
 	struct zfp_metadata* metadata = (struct zfp_metadata*) malloc(sizeof(struct zfp_metadata));	// allocate metadata
 	metadata = zfp_read_metadata(metadata, completed_pg_reqgroup);
@@ -155,15 +155,34 @@ int adios_transform_zfp_apply(struct adios_file_struct *fd, struct adios_var_str
 	get_dims(d, zbuff, var, fd);
 
 
+	/* "random_access" may accompany the rate mode; pick it out of the parameters first */
+	int i;
+	int random_access = 0;
+	int nmodes = 0;
+	const struct adios_transform_spec_kv_pair* param = NULL;
+	for (i=0; i<var->transform_spec->param_count; i++)
+	{
+		if (strcmp(var->transform_spec->params[i].key, "random_access") == 0)
+		{
+			random_access = 1;
+		}
+		else
+		{
+			param = &var->transform_spec->params[i];
+			nmodes++;
+		}
+	}
+
+
 	/* make sure the user only gives the sensible number of key:values -- 1. */
-	if (var->transform_spec->param_count == 0)
+	if (nmodes == 0)
 	{
 	    adios_error(err_invalid_argument, "No ZFP compression mode specified for variable %s. "
 	                "Choose from: accuracy, precision, rate\n", zbuff->name);
 	    zbuff->error = true;
 	    return 0;
 	}
-	else if (var->transform_spec->param_count > 1)
+	else if (nmodes > 1)
 	{
 	    adios_error(err_invalid_argument, "Too many ZFP parameters specified for variable %s. "
 	                "You can only give one key:value, the compression mode and it's tolerance.\n",
@@ -171,17 +190,9 @@ int adios_transform_zfp_apply(struct adios_file_struct *fd, struct adios_var_str
 	    zbuff->error = true;
 		return 0;
 	}
-	else if (var->transform_spec->param_count < 0)
-	{
-	    adios_error(err_invalid_argument, "Negative number of ZFP parameters for variable %s indicates corruption.\n",
-	                zbuff->name);
-        zbuff->error = true;
-		return 0;
-	}
 
 
 	/* Which zfp mode to use */
-	const struct adios_transform_spec_kv_pair* const param = &var->transform_spec->params[0];
 	if (strcmp(param->key, "accuracy") == 0) 
 	{
 		zbuff->mode = 0;
@@ -192,7 +203,7 @@ int adios_transform_zfp_apply(struct adios_file_struct *fd, struct adios_var_str
 	}
 	else if (strcmp(param->key, "rate") == 0)
 	{
-		zbuff->mode = 2;
+		zbuff->mode = random_access ? ZFP_MODE_RANDOM_ACCESS : 2;
 	}
 	else 
 	{
@@ -203,6 +214,14 @@ int adios_transform_zfp_apply(struct adios_file_struct *fd, struct adios_var_str
 		return 0;
 	}
 
+	if (random_access && zbuff->mode != ZFP_MODE_RANDOM_ACCESS)
+	{
+        adios_error(err_invalid_argument, "ZFP random_access requires the rate compression mode "
+                    "(variable %s).\n", zbuff->name);
+        zbuff->error = true;
+		return 0;
+	}
+
 	if (param->value == NULL)
 	{
         adios_error(err_invalid_argument, "ZFP compression type %s must be given a value "
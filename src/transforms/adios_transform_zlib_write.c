@@ -1,5 +1,6 @@
 #include <stdint.h>
 #include <inttypes.h>
+#include <string.h>
 #include <assert.h>
 #include <limits.h>
 #include <sys/time.h>
@@ -59,6 +60,72 @@ int compress_zlib_pre_allocated(const void* input_data,
     return 0;
 }
 
+/*
+ * Compresses into a shared buffer stream, which grows as the output does.
+ * Output longer than the input is abandoned. Returns 1 on success, 0 if the
+ * data did not compress (or zlib failed), and -1 if the buffer cannot grow.
+ */
+static int compress_zlib_to_stream(const void* input_data,
+                                   const uint64_t input_len,
+                                   struct shared_buffer_stream *stream,
+                                   int compress_level)
+{
+    const Bytef *next_in = (const Bytef *)input_data;
+    uint64_t in_left = input_len, out_len = 0;
+    int zerr = Z_OK;
+    z_stream zs;
+
+    memset(&zs, 0, sizeof(zs));
+    if (deflateInit(&zs, compress_level) != Z_OK)
+        return 0;
+
+    while (zerr != Z_STREAM_END)
+    {
+        uint64_t avail, room;
+        char *out;
+
+        // zlib counts in uInt, so feed large inputs piecewise
+        if (zs.avail_in == 0 && in_left > 0)
+        {
+            zs.avail_in = (uInt)(in_left < UINT_MAX ? in_left : UINT_MAX);
+            zs.next_in = (Bytef *)next_in;
+            next_in += zs.avail_in;
+            in_left -= zs.avail_in;
+        }
+
+        if (out_len >= input_len)
+        {
+            deflateEnd(&zs);
+            return 0;
+        }
+
+        out = shared_buffer_stream_space(stream, 1, &avail);
+        if (!out)
+        {
+            deflateEnd(&zs);
+            return -1;
+        }
+        room = input_len - out_len;
+        if (room > avail) room = avail;
+        if (room > UINT_MAX) room = UINT_MAX;
+
+        zs.next_out = (Bytef *)out;
+        zs.avail_out = (uInt)room;
+        zerr = deflate(&zs, in_left == 0 ? Z_FINISH : Z_NO_FLUSH);
+        if (zerr != Z_OK && zerr != Z_STREAM_END && zerr != Z_BUF_ERROR)
+        {
+            deflateEnd(&zs);
+            return 0;
+        }
+
+        shared_buffer_stream_advance(stream, room - zs.avail_out);
+        out_len += room - zs.avail_out;
+    }
+
+    deflateEnd(&zs);
+    return 1;
+}
+
 uint16_t adios_transform_zlib_get_metadata_size(struct adios_transform_spec *transform_spec)
 {
     return (sizeof(uint64_t) + sizeof(char));    // metadata: original data size (uint64_t) + compression succ flag (char)
@@ -106,24 +173,47 @@ int adios_transform_zlib_apply(struct adios_file_struct *fd,
     }
 
 
-    // decide the output buffer
-    uint64_t output_size = input_size; // for compression, at most the original data size
-    void* output_buff = NULL;
+    uint64_t actual_output_size = input_size;
+    char compress_ok = 1;
 
-    if (use_shared_buffer)    // If shared buffer is permitted, serialize to there
+    if (use_shared_buffer)    // If shared buffer is permitted, stream the output to there
     {
-        *wrote_to_shared_buffer = 1;
-        if (!shared_buffer_reserve(fd, output_size))
+        struct shared_buffer_stream stream;
+        shared_buffer_stream_open(&stream, fd);
+
+        int rtn = compress_zlib_to_stream(input_buff, input_size, &stream, compress_level);
+        if (rtn == 0)   // not compressible, or zlib failed: store the data as is
         {
-            log_error("Out of memory allocating %" PRIu64 " bytes for %s for zlib transform\n", output_size, var->name);
+            uint64_t avail;
+            char *out;
+
+            shared_buffer_stream_rewind(&stream);
+            out = shared_buffer_stream_space(&stream, input_size, &avail);
+            if (out)
+            {
+                memcpy(out, input_buff, input_size);
+                shared_buffer_stream_advance(&stream, input_size);
+            }
+            else
+            {
+                rtn = -1;
+            }
+            compress_ok = 0;    // succ sign set to 0
+        }
+        if (rtn < 0)
+        {
+            log_error("Out of memory in the ADIOS buffer for %s for zlib transform\n", var->name);
             return 0;
         }
 
-        // Write directly to the shared buffer
-        output_buff = fd->buffer + fd->offset;
+        *wrote_to_shared_buffer = 1;
+        actual_output_size = shared_buffer_stream_close(&stream);
     }
     else    // Else, fall back to var->adata memory allocation
     {
+        uint64_t output_size = input_size; // for compression, at most the original data size
+        void* output_buff = NULL;
+
         *wrote_to_shared_buffer = 0;
         output_buff = malloc(output_size);
         if (!output_buff)
@@ -131,30 +221,20 @@ int adios_transform_zlib_apply(struct adios_file_struct *fd,
             log_error("Out of memory allocating %" PRIu64 " bytes for %s for zlib transform\n", output_size, var->name);
             return 0;
         }
-    }
-
-    // compress it
-    uint64_t actual_output_size = output_size;
-    char compress_ok = 1;
 
-    int rtn = compress_zlib_pre_allocated(input_buff, input_size, output_buff, &actual_output_size, compress_level);
+        // compress it
+        actual_output_size = output_size;
+        int rtn = compress_zlib_pre_allocated(input_buff, input_size, output_buff, &actual_output_size, compress_level);
 
-    if(0 != rtn                     // compression failed for some reason, then just copy the buffer
-        || actual_output_size > input_size)  // or size after compression is even larger (not likely to happen since compression lib will return non-zero in this case)
-    {
-        // printf("compression failed, fall back to memory copy\n");
-        memcpy(output_buff, input_buff, input_size);
-        actual_output_size = input_size;
-        compress_ok = 0;    // succ sign set to 0
-    }
+        if(0 != rtn                     // compression failed for some reason, then just copy the buffer
+            || actual_output_size > input_size)  // or size after compression is even larger (not likely to happen since compression lib will return non-zero in this case)
+        {
+            // printf("compression failed, fall back to memory copy\n");
+            memcpy(output_buff, input_buff, input_size);
+            actual_output_size = input_size;
+            compress_ok = 0;    // succ sign set to 0
+        }
 
-    // Wrap up, depending on buffer mode
-    if (use_shared_buffer)
-    {
-        shared_buffer_mark_written(fd, actual_output_size);
-    }
-    else
-    {
         var->adata = output_buff;
         var->data_size = actual_output_size;
         var->free_data = adios_flag_yes;
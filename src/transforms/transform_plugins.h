@@ -14,3 +14,7 @@ REGISTER_TRANSFORM_PLUGIN(alacrity, "alacrity", "ncsu-alacrity", "ALACRITY index
 REGISTER_TRANSFORM_PLUGIN(zfp, "zfp", "zfp", "zfp compression")
 REGISTER_TRANSFORM_PLUGIN(sz, "sz", "sz", "sz compression")
 REGISTER_TRANSFORM_PLUGIN(lz4, "lz4", "lz4", "lz4 compression")
+REGISTER_TRANSFORM_PLUGIN(pipeline, "pipeline", "pipeline", "Ordered chain of data transforms")
+REGISTER_TRANSFORM_PLUGIN(shuffle, "shuffle", "shuffle", "Byte/bit shuffle of data elements")
+REGISTER_TRANSFORM_PLUGIN(auto, "auto", "auto", "Per-block automatic transform selection")
+REGISTER_TRANSFORM_PLUGIN(fpred, "fpred", "fpred", "Lossless predictive floating-point compression")
@@ -61,6 +61,7 @@ static int adios_mpi_amr_initialized = 0;
 #define DEFAULT_NUM_OST  672
 #define DEFAULT_STRIPE_COUNT 1
 #define DEFAULT_STRIPE_SIZE  1024*1024
+#define PIPELINE_NUM_CHUNKS  4
 
 
 
@@ -102,6 +103,8 @@ struct adios_MPI_data_struct
     int g_num_ost;
     int is_local_fs;
     int g_threading;
+    int g_shm_aggregation; // aggregate through shared memory if the group is on one node
+    uint64_t g_pipeline_buffer_size; // aggregator's receive ring in bytes, 0: no pipelining
     int is_color_set; // whether 'color' is set from XML.
     int g_color1;
     int g_color2;
@@ -600,6 +603,42 @@ adios_mpi_amr_set_aggregation_parameters(char * parameters, struct adios_MPI_dat
     }
     free (temp_string);
 
+    // set up whether to aggregate on a node through shared memory
+    temp_string = a2s_trim_spaces (parameters);
+    if ( (p_size = strstr (temp_string, "shm_aggregation")) )
+    {
+        char * p = strchr (p_size, '=');
+        char * q = strtok (p, ";");
+        if (!q)
+            md->g_shm_aggregation = atoi(q + 1);
+        else
+            md->g_shm_aggregation = atoi(p + 1);
+    }
+    else
+    {
+        // by default, groups within a node use shared memory
+        md->g_shm_aggregation = 1;
+    }
+    free (temp_string);
+
+    // set up the memory of pipelined aggregation (in MB)
+    temp_string = a2s_trim_spaces (parameters);
+    if ( (p_size = strstr (temp_string, "pipeline_buffer_size")) )
+    {
+        char * p = strchr (p_size, '=');
+        char * q = strtok (p, ";");
+        if (!q)
+            md->g_pipeline_buffer_size = (uint64_t) atoi(q + 1) * 1024 * 1024;
+        else
+            md->g_pipeline_buffer_size = (uint64_t) atoi(p + 1) * 1024 * 1024;
+    }
+    else
+    {
+        // by default, the aggregator receives all PGs before writing
+        md->g_pipeline_buffer_size = 0;
+    }
+    free (temp_string);
+
     // set up which ost's to skip
     temp_string = a2s_trim_spaces (parameters);
 
@@ -769,6 +808,88 @@ adios_mpi_amr_striping_unit_write(MPI_File   fh
     return err;
 }
 
+/* Write 'n' buffers back to back into the file at 'offset' (-1 means the
+ * current position). Consecutive buffers go into the same MPI_File_write
+ * call through an hindexed datatype, up to MAX_MPIWRITE_SIZE bytes per call.
+ * Returns the number of bytes written.
+ */
+static uint64_t
+adios_mpi_amr_striping_unit_writev(MPI_File   fh
+                                  ,MPI_Offset offset
+                                  ,int        n
+                                  ,void       **bufs
+                                  ,uint64_t   *lens
+                                  )
+{
+    MPI_Status status;
+    MPI_Datatype type;
+    uint64_t total_written = 0, done = 0;
+    int * blens;
+    MPI_Aint * displs;
+    int i = 0, nb, count;
+
+    blens = (int *) malloc (n * sizeof(int));
+    displs = (MPI_Aint *) malloc (n * sizeof(MPI_Aint));
+    if (!blens || !displs)
+    {
+        adios_error (err_no_memory, "MPI_AMR method: Cannot allocate memory "
+                    "for a vectored write of %d buffers\n", n);
+        FREE (blens);
+        FREE (displs);
+        return 0;
+    }
+
+    if (offset == -1) // use current position
+        MPI_File_get_position(fh, &offset);
+    else
+        MPI_File_seek (fh, offset, MPI_SEEK_SET);
+
+    // 'done' bytes of bufs[i] are written already
+    while (i < n)
+    {
+        uint64_t room = MAX_MPIWRITE_SIZE, batch = 0;
+        nb = 0;
+        while (i < n && room > 0)
+        {
+            uint64_t len = lens[i] - done;
+            if (len > room)
+                len = room;
+            if (len > 0)
+            {
+                blens[nb] = (int) len;
+                MPI_Get_address ((char *) bufs[i] + done, &displs[nb]);
+                nb++;
+            }
+            room -= len;
+            batch += len;
+            done += len;
+            if (done == lens[i])
+            {
+                i++;
+                done = 0;
+            }
+        }
+        if (nb == 0)
+            break;
+
+        MPI_Type_create_hindexed (nb, blens, displs, MPI_BYTE, &type);
+        MPI_Type_commit (&type);
+        MPI_File_write (fh, MPI_BOTTOM, 1, type, &status);
+        MPI_Get_elements (&status, type, &count);
+        MPI_Type_free (&type);
+        if ((uint64_t) count != batch)
+        {
+            total_written += (count > 0 ? count : 0);
+            break;
+        }
+        total_written += batch;
+    }
+
+    free (blens);
+    free (displs);
+    return total_written;
+}
+
 struct adios_var_struct * adios_mpi_amr_copy_var (struct adios_var_struct * v)
 {
     struct adios_var_struct * v_new = (struct adios_var_struct *) 
@@ -1102,6 +1223,8 @@ void adios_mpi_amr_init (const PairStruct * parameters
     md->g_num_ost = 0;
     md->is_local_fs = 0;
     md->g_threading = 0;
+    md->g_shm_aggregation = 1;
+    md->g_pipeline_buffer_size = 0;
     md->is_color_set = 0;
     md->g_color1 = 0;
     md->g_color2 = 0;
@@ -1615,6 +1738,325 @@ int adios_MPI_Irecv(void *buf, uint64_t count, int source,
     return n;
 }
 
+/* Node-local aggregation: if all processes of the aggregation group (g_comm1)
+ * run on the same node, every process copies its PG into its part of an MPI-3
+ * shared memory window, and the aggregator writes the PGs in group rank order
+ * (their order in the subfile) straight from the window with vectored writes,
+ * starting at md->b.pg_index_offset. No PG is sent as a message and the
+ * aggregator needs no aggregation buffer.
+ * Collective over g_comm1. Returns 1 if the PGs have been written this way,
+ * 0 if the group spans several nodes (or shm_aggregation=0) and the caller
+ * has to aggregate them with messages.
+ */
+static int adios_mpi_amr_shm_aggregate (struct adios_file_struct * fd
+                                       ,struct adios_MPI_data_struct * md
+                                       ,int group_size
+                                       ,uint64_t * pg_sizes
+                                       )
+{
+#if MPI_VERSION >= 3
+    MPI_Comm shm_comm;
+    MPI_Win win;
+    char * base = 0;
+    int shm_size, i;
+
+    if (!md->g_shm_aggregation)
+        return 0;
+
+    // same order as in g_comm1, the aggregator is rank 0 in both
+    MPI_Comm_split_type (md->g_comm1, MPI_COMM_TYPE_SHARED, 0, MPI_INFO_NULL, &shm_comm);
+    MPI_Comm_size (shm_comm, &shm_size);
+    if (shm_size != group_size)
+    {
+        // the same on every process of the group
+        MPI_Comm_free (&shm_comm);
+        return 0;
+    }
+
+    START_TIMER (ADIOS_TIMER_COMM);
+    MPI_Win_allocate_shared ((MPI_Aint) fd->bytes_written, 1, MPI_INFO_NULL
+                            ,shm_comm, &base, &win);
+    MPI_Win_lock_all (MPI_MODE_NOCHECK, win);
+    memcpy (base, fd->buffer, fd->bytes_written);
+    MPI_Win_sync (win);
+    MPI_Barrier (shm_comm);
+    MPI_Win_sync (win);
+    STOP_TIMER (ADIOS_TIMER_COMM);
+
+    if (is_aggregator (md->rank))
+    {
+        void ** bufs = (void **) malloc (group_size * sizeof(void *));
+        uint64_t * lens = (uint64_t *) malloc (group_size * sizeof(uint64_t));
+        uint64_t total_data_size = 0, count;
+        int n = 0;
+
+        if (!bufs || !lens)
+        {
+            adios_error (err_no_memory, "MPI_AMR method: Cannot allocate memory "
+                        "for writing %d process blocks from shared memory\n", group_size);
+        }
+        else
+        {
+            // merge the parts that are contiguous in the window (usually all)
+            for (i = 0; i < group_size; i++)
+            {
+                MPI_Aint size;
+                int disp_unit;
+                char * p;
+
+                MPI_Win_shared_query (win, i, &size, &disp_unit, &p);
+                if (!pg_sizes[i])
+                    continue;
+                if (n > 0 && (char *) bufs[n - 1] + lens[n - 1] == p)
+                {
+                    lens[n - 1] += pg_sizes[i];
+                }
+                else
+                {
+                    bufs[n] = p;
+                    lens[n] = pg_sizes[i];
+                    n++;
+                }
+                total_data_size += pg_sizes[i];
+            }
+
+            if (md->g_threading)
+            {
+                pthread_join (md->g_sot, NULL);
+            }
+
+            START_TIMER (ADIOS_TIMER_IO);
+            count = adios_mpi_amr_striping_unit_writev (md->fh, md->b.pg_index_offset
+                                                       ,n, bufs, lens);
+            STOP_TIMER (ADIOS_TIMER_IO);
+            if (count != total_data_size)
+            {
+                adios_error (err_unspecified, "Error in adios_mpi_amr_striping_unit_writev(). "
+                    "count = %llu != total_data_size = %llu\n",
+                    count, total_data_size);
+            }
+        }
+        FREE (bufs);
+        FREE (lens);
+    }
+
+    // MPI_Win_free waits for the aggregator to finish writing from the window
+    MPI_Win_unlock_all (win);
+    MPI_Win_free (&win);
+    MPI_Comm_free (&shm_comm);
+    return 1;
+#else
+    return 0;
+#endif
+}
+
+/* Post the receives of the chunk covering [start, end) of the group's PGs,
+ * one per member overlapping it, starting from member '*member' (updated to
+ * the first member that continues in the next chunk).
+ * Returns the number of requests posted.
+ */
+static int adios_mpi_amr_post_chunk (char * chunk, uint64_t start, uint64_t end
+                                    ,int * member, int group_size
+                                    ,uint64_t * pg_sizes, uint64_t * disp
+                                    ,MPI_Comm comm, MPI_Request * requests
+                                    )
+{
+    int n = 0;
+
+    while (*member < group_size && disp[*member] < end)
+    {
+        uint64_t lo = (disp[*member] > start) ? disp[*member] : start;
+        uint64_t hi = disp[*member] + pg_sizes[*member];
+
+        if (hi > end)
+            hi = end;
+        if (hi > lo)
+        {
+            MPI_Irecv (chunk + (lo - start), (int) (hi - lo), MPI_BYTE
+                      ,*member, 0, comm, requests + n);
+            n++;
+        }
+        if (disp[*member] + pg_sizes[*member] > end)
+            break;
+        (*member)++;
+    }
+
+    return n;
+}
+
+/* Pipelined aggregation: the PGs of the members after the aggregator form
+ * a stream cut into chunks of pipeline_buffer_size / PIPELINE_NUM_CHUNKS bytes
+ * (a chunk may hold parts of several PGs). The members send their PGs in
+ * pieces cut at the chunk boundaries, the aggregator receives them into a
+ * ring of PIPELINE_NUM_CHUNKS chunks and writes each complete chunk with a
+ * non-blocking write while the next chunks are arriving. The aggregator's
+ * own PG is written from its buffer. The aggregator's memory is bounded by
+ * pipeline_buffer_size, independent of the number and size of the PGs.
+ * Collective over g_comm1. Returns 1 if the PGs have been written this way,
+ * 0 if pipelining is off.
+ */
+static int adios_mpi_amr_pipeline_aggregate (struct adios_file_struct * fd
+                                            ,struct adios_MPI_data_struct * md
+                                            ,int group_size
+                                            ,int group_rank
+                                            ,uint64_t * pg_sizes
+                                            ,uint64_t * disp
+                                            )
+{
+    uint64_t chunk_size, stream_start, total_data_size, nchunks, k, count;
+    uint64_t total_written = 0;
+    char * ring = 0;
+    MPI_Request * recv_reqs = 0, * write_reqs = 0;
+    MPI_Status status;
+    int * nrecvs = 0;
+    int nslots, slot, member = 1, i, written;
+
+    if (!md->g_pipeline_buffer_size)
+        return 0;
+
+    chunk_size = md->g_pipeline_buffer_size / PIPELINE_NUM_CHUNKS;
+    if (chunk_size > MAX_MPIWRITE_SIZE)
+        chunk_size = MAX_MPIWRITE_SIZE;
+    stream_start = pg_sizes[0];
+    total_data_size = disp[group_size - 1] + pg_sizes[group_size - 1];
+    nchunks = (total_data_size - stream_start + chunk_size - 1) / chunk_size;
+
+    if (!is_aggregator (md->rank))
+    {
+        uint64_t pos = disp[group_rank];
+        uint64_t end = disp[group_rank] + pg_sizes[group_rank];
+
+        START_TIMER (ADIOS_TIMER_COMM);
+        while (pos < end)
+        {
+            uint64_t boundary = stream_start
+                              + ((pos - stream_start) / chunk_size + 1) * chunk_size;
+            uint64_t len = ((end < boundary) ? end : boundary) - pos;
+
+            MPI_Send (fd->buffer + (pos - disp[group_rank]), (int) len, MPI_BYTE
+                     ,0, 0, md->g_comm1);
+            pos += len;
+        }
+        STOP_TIMER (ADIOS_TIMER_COMM);
+        return 1;
+    }
+
+    nslots = (nchunks < PIPELINE_NUM_CHUNKS) ? (int) nchunks : PIPELINE_NUM_CHUNKS;
+    if (nslots)
+    {
+        ring = (char *) malloc (nslots * chunk_size);
+        recv_reqs = (MPI_Request *) malloc (nslots * group_size * sizeof (MPI_Request));
+        write_reqs = (MPI_Request *) malloc (nslots * sizeof (MPI_Request));
+        nrecvs = (int *) malloc (nslots * sizeof (int));
+        if (!ring || !recv_reqs || !write_reqs || !nrecvs)
+        {
+            adios_error (err_no_memory, "MPI_AMR method (pipelined): Cannot allocate "
+                        "%llu bytes for the aggregation buffers. "
+                        "Decrease pipeline_buffer_size.\n",
+                        nslots * chunk_size);
+            FREE (ring);
+            FREE (recv_reqs);
+            FREE (write_reqs);
+            FREE (nrecvs);
+            return 1;
+        }
+        for (i = 0; i < nslots; i++)
+        {
+            write_reqs[i] = MPI_REQUEST_NULL;
+        }
+    }
+
+    if (md->g_threading)
+    {
+        pthread_join (md->g_sot, NULL);
+    }
+
+    // the first chunks arrive while the aggregator writes its own PG
+    START_TIMER (ADIOS_TIMER_COMM);
+    for (k = 0; k < nslots; k++)
+    {
+        uint64_t start = stream_start + k * chunk_size;
+        uint64_t end = (start + chunk_size < total_data_size) ? start + chunk_size : total_data_size;
+        nrecvs[k] = adios_mpi_amr_post_chunk (ring + k * chunk_size, start, end
+                                             ,&member, group_size, pg_sizes, disp
+                                             ,md->g_comm1, recv_reqs + k * group_size);
+    }
+    STOP_TIMER (ADIOS_TIMER_COMM);
+
+    START_TIMER (ADIOS_TIMER_IO);
+    count = adios_mpi_amr_striping_unit_write (md->fh, md->b.pg_index_offset
+                                              ,fd->buffer, pg_sizes[0]);
+    STOP_TIMER (ADIOS_TIMER_IO);
+    if (count != pg_sizes[0])
+    {
+        adios_error (err_unspecified, "Error in adios_mpi_amr_striping_unit_write(). "
+            "count = %llu != pg_size = %llu\n", count, pg_sizes[0]);
+    }
+
+    for (k = 0; k < nchunks; k++)
+    {
+        uint64_t start = stream_start + k * chunk_size;
+        uint64_t len = (start + chunk_size < total_data_size) ? chunk_size : total_data_size - start;
+
+        slot = k % nslots;
+        START_TIMER (ADIOS_TIMER_COMM);
+        MPI_Waitall (nrecvs[slot], recv_reqs + slot * group_size, MPI_STATUSES_IGNORE);
+        STOP_TIMER (ADIOS_TIMER_COMM);
+
+        START_TIMER (ADIOS_TIMER_IO);
+        MPI_File_iwrite_at (md->fh, md->b.pg_index_offset + start
+                           ,ring + slot * chunk_size, (int) len, MPI_BYTE
+                           ,&write_reqs[slot]);
+        STOP_TIMER (ADIOS_TIMER_IO);
+
+        // refill the slot of the previous chunk, its write ran during this chunk's receive
+        if (k >= 1 && k - 1 + nslots < nchunks)
+        {
+            uint64_t next = k - 1 + nslots;
+            uint64_t next_start = stream_start + next * chunk_size;
+            uint64_t next_end = (next_start + chunk_size < total_data_size) ?
+                                next_start + chunk_size : total_data_size;
+
+            slot = (k - 1) % nslots;
+            START_TIMER (ADIOS_TIMER_IO);
+            MPI_Wait (&write_reqs[slot], &status);
+            STOP_TIMER (ADIOS_TIMER_IO);
+            MPI_Get_count (&status, MPI_BYTE, &written);
+            total_written += written;
+
+            START_TIMER (ADIOS_TIMER_COMM);
+            nrecvs[slot] = adios_mpi_amr_post_chunk (ring + slot * chunk_size, next_start, next_end
+                                                    ,&member, group_size, pg_sizes, disp
+                                                    ,md->g_comm1, recv_reqs + slot * group_size);
+            STOP_TIMER (ADIOS_TIMER_COMM);
+        }
+    }
+
+    START_TIMER (ADIOS_TIMER_IO);
+    for (i = 0; i < nslots; i++)
+    {
+        if (write_reqs[i] != MPI_REQUEST_NULL)
+        {
+            MPI_Wait (&write_reqs[i], &status);
+            MPI_Get_count (&status, MPI_BYTE, &written);
+            total_written += written;
+        }
+    }
+    STOP_TIMER (ADIOS_TIMER_IO);
+    if (total_written != total_data_size - stream_start)
+    {
+        adios_error (err_unspecified, "MPI_AMR method (pipelined): wrote %llu bytes "
+            "of the %llu bytes received by the aggregator\n",
+            total_written, total_data_size - stream_start);
+    }
+
+    FREE (ring);
+    FREE (recv_reqs);
+    FREE (write_reqs);
+    FREE (nrecvs);
+    return 1;
+}
+
 void adios_mpi_amr_bg_close (struct adios_file_struct * fd
                             ,struct adios_method_struct * method
                             )
@@ -1687,124 +2129,131 @@ void adios_mpi_amr_bg_close (struct adios_file_struct * fd
                     max_data_size = (pg_sizes[i] > max_data_size) ? pg_sizes[i] : max_data_size;
                 }
 
-                int nMPIrequests = max_data_size / UINT32_MAX + 1;
-                MPI_Request *requests = (MPI_Request *) malloc (nMPIrequests * sizeof (MPI_Request));
-                MPI_Status *statuses = (MPI_Status *) malloc (nMPIrequests * sizeof (MPI_Status));
+                total_data_size = disp[new_group_size - 1]
+                                + pg_sizes[new_group_size - 1];
 
-                if (is_aggregator (md->rank))
+                if (adios_mpi_amr_shm_aggregate (fd, md, new_group_size, pg_sizes))
                 {
-                    aggr_buff = malloc (max_data_size);
-                    recv_buff = malloc (max_data_size);
-                    if (aggr_buff == 0 || recv_buff == 0)
-                    {
-                        adios_error (err_no_memory, "MPI_AMR method (with brigade strategy): Cannot allocate "
-                                    "2 x %lu bytes for aggregation buffers. "
-                                    "An aggregator process needs a buffer to hold one process' output for writing, "
-                                    "while it needs another buffer to concurrently receive another process' output for "
-                                    "subsequent writing.\n", 
-                                    max_data_size);
-                        return;
-                    }
+                    // the group's PGs are written from shared memory
                 }
                 else
                 {
-                    recv_buff = malloc (max_data_size);
-                    if (recv_buff == 0)
+                    int nMPIrequests = max_data_size / UINT32_MAX + 1;
+                    MPI_Request *requests = (MPI_Request *) malloc (nMPIrequests * sizeof (MPI_Request));
+                    MPI_Status *statuses = (MPI_Status *) malloc (nMPIrequests * sizeof (MPI_Status));
+
+                    if (is_aggregator (md->rank))
                     {
-                        adios_error (err_no_memory, "MPI_AMR method (with brigade strategy): Cannot allocate "
-                                    "%lu bytes for receive buffer in a non-aggregator process. "
-                                    "This method needs an extra buffer in every process to pass data along "
-                                    "towards the aggregator.\n", 
-                                    max_data_size);
-                        return;
+                        aggr_buff = malloc (max_data_size);
+                        recv_buff = malloc (max_data_size);
+                        if (aggr_buff == 0 || recv_buff == 0)
+                        {
+                            adios_error (err_no_memory, "MPI_AMR method (with brigade strategy): Cannot allocate "
+                                        "2 x %lu bytes for aggregation buffers. "
+                                        "An aggregator process needs a buffer to hold one process' output for writing, "
+                                        "while it needs another buffer to concurrently receive another process' output for "
+                                        "subsequent writing.\n", 
+                                        max_data_size);
+                            return;
+                        }
                     }
-                }
-
-                total_data_size = disp[new_group_size - 1]
-                                + pg_sizes[new_group_size - 1];
-
-                if (is_aggregator (md->rank))
-                {
-                    if (md->g_threading)
+                    else
                     {
-                        pthread_join (md->g_sot, NULL);
+                        recv_buff = malloc (max_data_size);
+                        if (recv_buff == 0)
+                        {
+                            adios_error (err_no_memory, "MPI_AMR method (with brigade strategy): Cannot allocate "
+                                        "%lu bytes for receive buffer in a non-aggregator process. "
+                                        "This method needs an extra buffer in every process to pass data along "
+                                        "towards the aggregator.\n", 
+                                        max_data_size);
+                            return;
+                        }
                     }
 
-                    index_start1 = md->b.pg_index_offset; // starting point to write data at this moment
-                    for (i = 0; i < new_group_size; i++)
+                    if (is_aggregator (md->rank))
                     {
-                        if (i + 1 < new_group_size)
+                        if (md->g_threading)
                         {
-                            START_TIMER (ADIOS_TIMER_COMM);
-                            nMPIrequests = adios_MPI_Irecv (recv_buff, pg_sizes[i + 1], new_rank + 1
-                                                            ,0, md->g_comm1, requests);
-                            STOP_TIMER (ADIOS_TIMER_COMM);
+                            pthread_join (md->g_sot, NULL);
                         }
 
-                        write_thread_data.fh = &md->fh;
-                        write_thread_data.base_offset = &index_start1;
-                        write_thread_data.aggr_buff = (i == 0) ? fd->buffer : aggr_buff;
-                        write_thread_data.total_data_size = &pg_sizes[i];
-
-                        //printf ("rank %d: Write PG to subfile %d, offset=%llu, size=%u\n", md->rank,
-                        //       fd->subfile_index, *write_thread_data.base_offset, pg_sizes[i]);
-
-                        // This write call is not threaded
-                        START_TIMER (ADIOS_TIMER_IO);
-                        adios_mpi_amr_do_write_thread ((void *) &write_thread_data);
-                        STOP_TIMER (ADIOS_TIMER_IO);
-
-                        index_start1 += pg_sizes[i];
-
-                        if (i + 1 < new_group_size)
+                        index_start1 = md->b.pg_index_offset; // starting point to write data at this moment
+                        for (i = 0; i < new_group_size; i++)
                         {
-                            START_TIMER (ADIOS_TIMER_COMM);
-                            MPI_Waitall (nMPIrequests, requests, statuses);
-                            STOP_TIMER (ADIOS_TIMER_COMM);
-                            // swap receive and aggregate buffers, so we can write out the just received PG while getting another one
-                            void *tmp = aggr_buff;
-                            aggr_buff = recv_buff;
-                            recv_buff = tmp;
-                            //memcpy (aggr_buff, recv_buff, pg_sizes[i + 1]);
+                            if (i + 1 < new_group_size)
+                            {
+                                START_TIMER (ADIOS_TIMER_COMM);
+                                nMPIrequests = adios_MPI_Irecv (recv_buff, pg_sizes[i + 1], new_rank + 1
+                                                                ,0, md->g_comm1, requests);
+                                STOP_TIMER (ADIOS_TIMER_COMM);
+                            }
+
+                            write_thread_data.fh = &md->fh;
+                            write_thread_data.base_offset = &index_start1;
+                            write_thread_data.aggr_buff = (i == 0) ? fd->buffer : aggr_buff;
+                            write_thread_data.total_data_size = &pg_sizes[i];
+
+                            //printf ("rank %d: Write PG to subfile %d, offset=%llu, size=%u\n", md->rank,
+                            //       fd->subfile_index, *write_thread_data.base_offset, pg_sizes[i]);
+
+                            // This write call is not threaded
+                            START_TIMER (ADIOS_TIMER_IO);
+                            adios_mpi_amr_do_write_thread ((void *) &write_thread_data);
+                            STOP_TIMER (ADIOS_TIMER_IO);
+
+                            index_start1 += pg_sizes[i];
+
+                            if (i + 1 < new_group_size)
+                            {
+                                START_TIMER (ADIOS_TIMER_COMM);
+                                MPI_Waitall (nMPIrequests, requests, statuses);
+                                STOP_TIMER (ADIOS_TIMER_COMM);
+                                // swap receive and aggregate buffers, so we can write out the just received PG while getting another one
+                                void *tmp = aggr_buff;
+                                aggr_buff = recv_buff;
+                                recv_buff = tmp;
+                                //memcpy (aggr_buff, recv_buff, pg_sizes[i + 1]);
+                            }
                         }
                     }
-                }
-                else
-                {
-                    if (new_rank == new_group_size - 1)
-                    {
-                        START_TIMER (ADIOS_TIMER_COMM);
-                        adios_MPI_Send (fd->buffer, pg_size, new_rank - 1
-                                 ,0, md->g_comm1);
-                        STOP_TIMER (ADIOS_TIMER_COMM);
-                    }
                     else
                     {
-                        for (i = new_rank + 1; i < new_group_size; i++)
+                        if (new_rank == new_group_size - 1)
                         {
                             START_TIMER (ADIOS_TIMER_COMM);
-                            // Recv data from upstream rank
-                            nMPIrequests = adios_MPI_Irecv (recv_buff, pg_sizes[i], new_rank + 1
-                                                            ,0, md->g_comm1, requests);
-
-                            if (i == new_rank + 1)
-                                // Send my data to downstream rank
-                                adios_MPI_Send (fd->buffer, pg_size, new_rank - 1
-                                         ,0, md->g_comm1);
-
-                            MPI_Waitall(nMPIrequests, requests, statuses);
-                            // Send it to downstream rank
-                            adios_MPI_Send (recv_buff, pg_sizes[i], new_rank - 1
+                            adios_MPI_Send (fd->buffer, pg_size, new_rank - 1
                                      ,0, md->g_comm1);
                             STOP_TIMER (ADIOS_TIMER_COMM);
                         }
+                        else
+                        {
+                            for (i = new_rank + 1; i < new_group_size; i++)
+                            {
+                                START_TIMER (ADIOS_TIMER_COMM);
+                                // Recv data from upstream rank
+                                nMPIrequests = adios_MPI_Irecv (recv_buff, pg_sizes[i], new_rank + 1
+                                                                ,0, md->g_comm1, requests);
+
+                                if (i == new_rank + 1)
+                                    // Send my data to downstream rank
+                                    adios_MPI_Send (fd->buffer, pg_size, new_rank - 1
+                                             ,0, md->g_comm1);
+
+                                MPI_Waitall(nMPIrequests, requests, statuses);
+                                // Send it to downstream rank
+                                adios_MPI_Send (recv_buff, pg_sizes[i], new_rank - 1
+                                         ,0, md->g_comm1);
+                                STOP_TIMER (ADIOS_TIMER_COMM);
+                            }
+                        }
                     }
-                }
 
-                FREE (aggr_buff);
-                FREE (recv_buff);
-                FREE (requests);
-                FREE (statuses);
+                    FREE (aggr_buff);
+                    FREE (recv_buff);
+                    FREE (requests);
+                    FREE (statuses);
+                }
             }
             else 
             {
@@ -2198,6 +2647,7 @@ void adios_mpi_amr_ag_close (struct adios_file_struct * fd
             void * aggr_buff = 0;
             struct adios_MPI_thread_data_write write_thread_data;
             int i, new_rank, new_group_size, new_rank2, new_group_size2;
+            int pgs_written = 0;
             uint64_t total_data_size = 0, total_data_size1 = 0;;
 
             START_TIMER (ADIOS_TIMER_COMM);
@@ -2251,47 +2701,56 @@ void adios_mpi_amr_ag_close (struct adios_file_struct * fd
                                 + pg_sizes[new_group_size - 1];
                 //if (md->rank==0) fprintf (stderr, "total=%llu\n", total_data_size); 
 
-                if (is_aggregator (md->rank))
+                pgs_written = adios_mpi_amr_shm_aggregate (fd, md, new_group_size, pg_sizes);
+                if (!pgs_written)
                 {
-                    aggr_buff = malloc (total_data_size);
-                    if (aggr_buff == 0)
-                    {
-                        adios_error (err_no_memory, 
-                                "MPI_AMR method (AG): Cannot allocate %lu bytes "
-                                "for aggregation buffer.\n"
-                                "Need to increase the number of aggregators.\n",
-                                total_data_size);
-                        return;
-                    }
+                    pgs_written = adios_mpi_amr_pipeline_aggregate (fd, md, new_group_size, new_rank
+                                                                   ,pg_sizes, disp);
                 }
-                else
+                if (!pgs_written)
                 {
-                }
+                    if (is_aggregator (md->rank))
+                    {
+                        aggr_buff = malloc (total_data_size);
+                        if (aggr_buff == 0)
+                        {
+                            adios_error (err_no_memory, 
+                                    "MPI_AMR method (AG): Cannot allocate %lu bytes "
+                                    "for aggregation buffer.\n"
+                                    "Need to increase the number of aggregators.\n",
+                                    total_data_size);
+                            return;
+                        }
+                    }
+                    else
+                    {
+                    }
 
-                START_TIMER (ADIOS_TIMER_COMM);
-                // This needs to be changed in the future to support > 2 GB data.
-                int * int_pg_sizes = (int*) malloc (new_group_size * sizeof(int));
-                int * int_disp = (int*) malloc (new_group_size * sizeof(int));
-                int int_total_data_size = (int) total_data_size;
-                for (i = 0; i < new_group_size; i++)
-                {
-                    int_pg_sizes[i] = pg_sizes[i];
-                    int_disp[i] = disp[i];
-                }
-                if (total_data_size != (uint64_t) int_total_data_size)
-                {
-                    adios_error (err_unspecified, 
-                            "MPI_AGGRGATE with aggregate_type=1 does not handle >2GB buffers. "
-                            "If each process writes less than 2GB, then increase the number of aggregators "
-                            "so that the total data size on each aggregator is still < 2GB. "
-                            "If some process has more than 2GB data, use aggregate_type=2 "
-                            "(the default aggregation method)."
-                            );
+                    START_TIMER (ADIOS_TIMER_COMM);
+                    // This needs to be changed in the future to support > 2 GB data.
+                    int * int_pg_sizes = (int*) malloc (new_group_size * sizeof(int));
+                    int * int_disp = (int*) malloc (new_group_size * sizeof(int));
+                    int int_total_data_size = (int) total_data_size;
+                    for (i = 0; i < new_group_size; i++)
+                    {
+                        int_pg_sizes[i] = pg_sizes[i];
+                        int_disp[i] = disp[i];
+                    }
+                    if (total_data_size != (uint64_t) int_total_data_size)
+                    {
+                        adios_error (err_unspecified, 
+                                "MPI_AGGRGATE with aggregate_type=1 does not handle >2GB buffers. "
+                                "If each process writes less than 2GB, then increase the number of aggregators "
+                                "so that the total data size on each aggregator is still < 2GB. "
+                                "If some process has more than 2GB data, use aggregate_type=2 "
+                                "(the default aggregation method)."
+                                );
+                    }
+                    MPI_Gatherv (fd->buffer, (int)pg_size, MPI_BYTE
+                                ,aggr_buff, int_pg_sizes, int_disp, MPI_BYTE
+                                ,0, md->g_comm1);
+                    STOP_TIMER (ADIOS_TIMER_COMM);
                 }
-                MPI_Gatherv (fd->buffer, (int)pg_size, MPI_BYTE
-                            ,aggr_buff, int_pg_sizes, int_disp, MPI_BYTE
-                            ,0, md->g_comm1);
-                STOP_TIMER (ADIOS_TIMER_COMM);
             }
             else 
             {
@@ -2451,23 +2910,33 @@ void adios_mpi_amr_ag_close (struct adios_file_struct * fd
                 //adios_write_version_v1 (&buffer, &buffer_size, &buffer_offset, flag);
                 adios_write_version_flag_v1 (&buffer, &buffer_size, &buffer_offset, flag);
 
-                aggr_buff = realloc (aggr_buff, total_data_size + buffer_offset);
-                memcpy (aggr_buff + total_data_size, buffer, buffer_offset); 
-
-                // Waiting for the subfile to open if pthread is enabled
-                if (md->g_threading)
+                if (pgs_written)
                 {
-                    pthread_join (md->g_sot, NULL);
+                    // the PGs are in the subfile already, only the index follows them
+                    index_start1 = index_start;
+                    total_data_size1 = buffer_offset;
+                    write_thread_data.aggr_buff = buffer;
                 }
+                else
+                {
+                    aggr_buff = realloc (aggr_buff, total_data_size + buffer_offset);
+                    memcpy (aggr_buff + total_data_size, buffer, buffer_offset); 
 
-                index_start1 = md->b.pg_index_offset; // starting point to write data at this moment
-                total_data_size1 = total_data_size + buffer_offset;
-                //fprintf (stderr,"rank %d: Write index+data with PG offset %llu, sizes %llu + %llu = %llu bytes\n", 
-                //        md->rank, index_start1, total_data_size, buffer_offset, total_data_size1);
+                    // Waiting for the subfile to open if pthread is enabled
+                    if (md->g_threading)
+                    {
+                        pthread_join (md->g_sot, NULL);
+                    }
+
+                    index_start1 = md->b.pg_index_offset; // starting point to write data at this moment
+                    total_data_size1 = total_data_size + buffer_offset;
+                    //fprintf (stderr,"rank %d: Write index+data with PG offset %llu, sizes %llu + %llu = %llu bytes\n", 
+                    //        md->rank, index_start1, total_data_size, buffer_offset, total_data_size1);
+                    write_thread_data.aggr_buff = aggr_buff;
+                }
 
                 write_thread_data.fh = &md->fh;
                 write_thread_data.base_offset = &index_start1;
-                write_thread_data.aggr_buff = aggr_buff;
                 write_thread_data.total_data_size = &total_data_size1;
 
                 // Threading the write so that we can overlap write with index collection.
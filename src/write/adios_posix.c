@@ -71,6 +71,7 @@ struct adios_POSIX_data_struct
     char *filename; // remember the currently opened filename to recognize when user suddenly changes to another one
     int index_is_in_memory; // = 1 when index is kept in memory, no need to read from file. =1 after first 'append/update' is completed but not after first 'write'.
     uint64_t pg_start_next; // remember end of PG data for future append steps
+    int index_string_table; // = 1 write the index with a string table (smaller footer)
 
     uint64_t total_bytes_written;  /* bytes including all PGs written during one open()..close() with overflows
           index position will be fd->current_pg->pg_start_in_file + total_bytes_written
@@ -107,6 +108,7 @@ void adios_posix_init (const PairStruct * parameters
     p->filename = NULL;
     p->index_is_in_memory = 0; 
     p->pg_start_next = 0;
+    p->index_string_table = 0;
     p->total_bytes_written = 0;
 
 
@@ -136,6 +138,18 @@ void adios_posix_init (const PairStruct * parameters
                 log_error ("Invalid 'local-fs' parameter given to the POSIX write "
                            "method: '%s'\n", ps->value);
             }
+        }
+        else if (!strcasecmp (ps->name, "index_string_table"))
+        {
+            errno = 0;
+            p->index_string_table = strtol(ps->value, NULL, 10);
+            if (!errno) {
+                log_debug ("Parameter 'index_string_table' set to %d for POSIX write method\n",
+                           p->index_string_table);
+            } else {
+                log_error ("Invalid 'index_string_table' parameter given to the POSIX write "
+                           "method: '%s'\n", ps->value);
+            }
         } else {
             log_error ("Parameter name %s is not recognized by the POSIX write "
                         "method\n", ps->name);
@@ -145,6 +159,21 @@ void adios_posix_init (const PairStruct * parameters
 }
 
 
+static int posix_write_index_v1 (struct adios_POSIX_data_struct * p
+                                ,char ** buffer, uint64_t * buffer_size
+                                ,uint64_t * buffer_offset, uint64_t index_start
+                                ,struct adios_index_struct_v1 * index
+                                )
+{
+    if (p->index_string_table)
+        return adios_write_index_with_string_table_v1 (buffer, buffer_size
+                                                      ,buffer_offset, index_start
+                                                      ,index);
+    return adios_write_index_v1 (buffer, buffer_size, buffer_offset
+                                ,index_start, index);
+}
+
+
 // Indices for the timer object
 #if defined ADIOS_TIMERS || defined ADIOS_TIMER_EVENTS
 static int ADIOS_TIMER_COMM         = ADIOS_TIMING_MAX_USER_TIMERS + 0;
@@ -957,7 +986,7 @@ void adios_posix_close (struct adios_file_struct * fd
             adios_build_index_v1 (fd, p->index);
             // if collective, gather the indexes from the rest and call
             // adios_merge_index_v1 (&new_pg_root, &new_vars_root, pg, vars);
-            adios_write_index_v1 (&buffer, &buffer_size, &buffer_offset
+            posix_write_index_v1 (p, &buffer, &buffer_size, &buffer_offset
                                  ,index_start, p->index);
             adios_write_version_v1 (&buffer, &buffer_size, &buffer_offset);
             STOP_TIMER (ADIOS_TIMER_LOCALMD);
@@ -1035,7 +1064,7 @@ void adios_posix_close (struct adios_file_struct * fd
                     uint64_t global_index_start = 0;
                     uint16_t flag = 0;
 
-                    adios_write_index_v1 (&global_index_buffer, &global_index_buffer_size
+                    posix_write_index_v1 (p, &global_index_buffer, &global_index_buffer_size
                                          ,&global_index_buffer_offset, global_index_start
                                          ,p->index);
 
@@ -1129,7 +1158,7 @@ void adios_posix_close (struct adios_file_struct * fd
             // new timestep so sorting is not needed during merge
             adios_merge_index_v1 (p->index, current_index->pg_root, 
                     current_index->vars_root, current_index->attrs_root, 0);
-            adios_write_index_v1 (&buffer, &buffer_size, &buffer_offset
+            posix_write_index_v1 (p, &buffer, &buffer_size, &buffer_offset
                                  ,index_start, p->index);
             // free current_index structure but do not clear it's content, which is merged
             // into p->index
@@ -1225,7 +1254,7 @@ void adios_posix_close (struct adios_file_struct * fd
                     uint64_t global_index_start = 0;
                     uint16_t flag = 0;
 
-                    adios_write_index_v1 (&global_index_buffer, &global_index_buffer_size
+                    posix_write_index_v1 (p, &global_index_buffer, &global_index_buffer_size
                                          ,&global_index_buffer_offset, global_index_start
                                          ,gindex);
 
@@ -191,7 +191,7 @@ int main(int argc, char ** argv) {
     MPI_Init(&argc, &argv);
 
     if (argc < 4 || argc > 7) {
-        fprintf(stderr," usage: %s {input bp file} {xml file} {query engine (ALACRITY/FASTBIT/MINMAX)} [mode (FILE/stream)] [print points? (TRUE/false)] [read results? (true/FALSE)]\n", argv[0]);
+        fprintf(stderr," usage: %s {input bp file} {xml file} {query engine (ALACRITY/FASTBIT/MINMAX/SCAN/BITMAP/SORTED)} [mode (FILE/stream)] [print points? (TRUE/false)] [read results? (true/FALSE)]\n", argv[0]);
         MPI_Abort(comm, 1);
     }
     else {
@@ -216,6 +216,15 @@ int main(int argc, char ** argv) {
         //fprintf(stderr,"Minmax not supported in this test yet, exiting...\n");
         //MPI_Abort(comm, 1);
     }
+    else if (strcasecmp(argv[3], "SCAN") == 0) {
+        query_method = ADIOS_QUERY_METHOD_SCAN;
+    }
+    else if (strcasecmp(argv[3], "BITMAP") == 0) {
+        query_method = ADIOS_QUERY_METHOD_BITMAP;
+    }
+    else if (strcasecmp(argv[3], "SORTED") == 0) {
+        query_method = ADIOS_QUERY_METHOD_SORTED;
+    }
     else {
     	fprintf(stderr,"Unsupported query engine %s, exiting...\n", argv[3]);
         MPI_Abort(comm, 1);
@@ -0,0 +1,102 @@
+/*
+ * ADIOS is freely available under the terms of the BSD license described
+ * in the COPYING file in the top level directory of this source distribution.
+ *
+ * Copyright (c) 2008 - 2009.  UT-BATTELLE, LLC. All rights reserved.
+ */
+
+/* Write or append steps of a 1D global array and an attribute into
+ * subfiles only (MPI_AGGREGATE, have_metadata_file=0), so that bpmeta
+ * has to create the metadata file. Ranks from the third on write no
+ * variables at all and odd ranks write none after the first step,
+ * so some subfiles contain PGs without any variables.
+ *
+ * Usage: bpmeta_append <first step> <number of steps>
+ *   The file is created if <first step> is 0, otherwise appended to.
+ * Output: bpmeta_append.bp.dir/bpmeta_append.bp.*
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <errno.h>
+#include "mpi.h"
+#include "adios.h"
+
+#ifdef DMALLOC
+#include "dmalloc.h"
+#endif
+
+#define NX 10
+
+int main (int argc, char ** argv)
+{
+    char        filename [] = "bpmeta_append.bp";
+    int         rank, size, i, step, first, nsteps;
+    int         nx = NX, gnx, offs;
+    double      t[NX];
+    MPI_Comm    comm = MPI_COMM_WORLD;
+    uint64_t    adios_groupsize, adios_totalsize;
+    int64_t     m_adios_group, m_adios_file;
+
+    MPI_Init (&argc, &argv);
+    MPI_Comm_rank (comm, &rank);
+    MPI_Comm_size (comm, &size);
+
+    if (argc < 3)
+    {
+        if (!rank)
+            printf ("Usage: bpmeta_append <first step> <number of steps>\n");
+        MPI_Finalize ();
+        return 1;
+    }
+    errno = 0;
+    first = strtol (argv[1], NULL, 10);
+    nsteps = strtol (argv[2], NULL, 10);
+    if (errno || first < 0 || nsteps < 1)
+    {
+        if (!rank)
+            printf ("Invalid arguments %s %s\n", argv[1], argv[2]);
+        MPI_Finalize ();
+        return 1;
+    }
+
+    gnx = NX * size;
+    offs = NX * rank;
+
+    adios_init_noxml (comm);
+    adios_set_max_buffer_size (1);
+
+    adios_declare_group (&m_adios_group, "bpmeta_append", "", adios_stat_default);
+    adios_select_method (m_adios_group, "MPI_AGGREGATE",
+                         "num_aggregators=2;have_metadata_file=0", "");
+
+    adios_define_var (m_adios_group, "nx", "", adios_integer, 0, 0, 0);
+    adios_define_var (m_adios_group, "gnx", "", adios_integer, 0, 0, 0);
+    adios_define_var (m_adios_group, "offs", "", adios_integer, 0, 0, 0);
+    adios_define_var (m_adios_group, "t", "", adios_double, "nx", "gnx", "offs");
+    adios_define_attribute (m_adios_group, "note", "", adios_string,
+                            "written step by step", 0);
+
+    for (step = first; step < first + nsteps; step++)
+    {
+        for (i = 0; i < NX; i++)
+            t[i] = 1000*step + offs + i;
+
+        adios_open (&m_adios_file, "bpmeta_append", filename, (step ? "a" : "w"), comm);
+        adios_groupsize = 3*sizeof(int) + NX*sizeof(double);
+        adios_group_size (m_adios_file, adios_groupsize, &adios_totalsize);
+        if (rank < 2 && !(rank % 2 && step > 0))
+        {
+            adios_write (m_adios_file, "nx", &nx);
+            adios_write (m_adios_file, "gnx", &gnx);
+            adios_write (m_adios_file, "offs", &offs);
+            adios_write (m_adios_file, "t", t);
+        }
+        adios_close (m_adios_file);
+    }
+
+    MPI_Barrier (comm);
+    adios_finalize (rank);
+    MPI_Finalize ();
+    return 0;
+}
@@ -0,0 +1,174 @@
+/*
+ * ADIOS is freely available under the terms of the BSD license described
+ * in the COPYING file in the top level directory of this source distribution.
+ *
+ * Copyright (c) 2008 - 2009.  UT-BATTELLE, LLC. All rights reserved.
+ */
+
+/* Write several steps of a 1D global array with the MPI_AGGREGATE method
+ * and the given method parameters, then read back the block of every rank
+ * in every step and check the values.
+ * The blocks are uneven: every rank writes a different number of elements,
+ * which also changes from step to step, and most of the PGs are larger than
+ * a chunk of the pipelined aggregation with pipeline_buffer_size=1.
+ *
+ * Usage: mpi_amr_aggregation <filename> <method parameters>
+ * Output: <filename>, <filename>.dir/<filename>.*
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include "mpi.h"
+#include "adios.h"
+#include "adios_read.h"
+
+#ifdef DMALLOC
+#include "dmalloc.h"
+#endif
+
+#define NSTEPS 3
+
+/* 1 MB of pipeline buffer makes chunks of 256 KB, 32768 doubles */
+#define NX(step,rank) (20000 + 17001*(rank) + 1000*(step))
+#define VALUE(step,rank,i) (1000000.0*(step) + 100000.0*(rank) + (i))
+
+int write_file (const char *filename, const char *params, MPI_Comm comm)
+{
+    int         rank, size, i, r, step;
+    int         nx, gnx, offs;
+    double      *t;
+    uint64_t    adios_groupsize, adios_totalsize;
+    int64_t     m_adios_group, m_adios_file;
+
+    MPI_Comm_rank (comm, &rank);
+    MPI_Comm_size (comm, &size);
+
+    adios_init_noxml (comm);
+    adios_set_max_buffer_size (8);
+
+    adios_declare_group (&m_adios_group, "mpi_amr_aggregation", "", adios_stat_default);
+    adios_select_method (m_adios_group, "MPI_AGGREGATE", params, "");
+
+    adios_define_var (m_adios_group, "nx", "", adios_integer, 0, 0, 0);
+    adios_define_var (m_adios_group, "gnx", "", adios_integer, 0, 0, 0);
+    adios_define_var (m_adios_group, "offs", "", adios_integer, 0, 0, 0);
+    adios_define_var (m_adios_group, "t", "", adios_double, "nx", "gnx", "offs");
+
+    t = (double *) malloc (NX(NSTEPS-1,rank) * sizeof(double));
+    for (step = 0; step < NSTEPS; step++)
+    {
+        nx = NX(step,rank);
+        gnx = 0;
+        offs = 0;
+        for (r = 0; r < size; r++)
+        {
+            if (r < rank)
+                offs += NX(step,r);
+            gnx += NX(step,r);
+        }
+        for (i = 0; i < nx; i++)
+            t[i] = VALUE(step,rank,i);
+
+        adios_open (&m_adios_file, "mpi_amr_aggregation", filename, (step ? "a" : "w"), comm);
+        adios_groupsize = 3*sizeof(int) + nx*sizeof(double);
+        adios_group_size (m_adios_file, adios_groupsize, &adios_totalsize);
+        adios_write (m_adios_file, "nx", &nx);
+        adios_write (m_adios_file, "gnx", &gnx);
+        adios_write (m_adios_file, "offs", &offs);
+        adios_write (m_adios_file, "t", t);
+        adios_close (m_adios_file);
+    }
+    free (t);
+
+    MPI_Barrier (comm);
+    adios_finalize (rank);
+    return 0;
+}
+
+/* Every process reads the blocks of every writer in every step */
+int read_file (const char *filename, MPI_Comm comm)
+{
+    int         rank, size, i, r, step, nerr = 0;
+    double      *t;
+    ADIOS_FILE  *f;
+    ADIOS_SELECTION *sel;
+
+    MPI_Comm_rank (comm, &rank);
+    MPI_Comm_size (comm, &size);
+
+    adios_read_init_method (ADIOS_READ_METHOD_BP, comm, "");
+    f = adios_read_open_file (filename, ADIOS_READ_METHOD_BP, comm);
+    if (f == NULL)
+    {
+        printf ("rank %d: ERROR: cannot open %s: %s\n", rank, filename, adios_errmsg());
+        adios_read_finalize_method (ADIOS_READ_METHOD_BP);
+        return 1;
+    }
+    if (f->last_step != NSTEPS-1)
+    {
+        printf ("rank %d: ERROR: %s has %d steps instead of %d\n",
+                rank, filename, f->last_step+1, NSTEPS);
+        nerr++;
+    }
+
+    t = (double *) malloc (NX(NSTEPS-1,size-1) * sizeof(double));
+    for (step = 0; !nerr && step < NSTEPS; step++)
+    {
+        for (r = 0; !nerr && r < size; r++)
+        {
+            sel = adios_selection_writeblock (r);
+            adios_schedule_read (f, sel, "t", step, 1, t);
+            if (adios_perform_reads (f, 1))
+            {
+                printf ("rank %d: ERROR: reading the block of rank %d in step %d failed: %s\n",
+                        rank, r, step, adios_errmsg());
+                nerr++;
+            }
+            adios_selection_delete (sel);
+            for (i = 0; !nerr && i < NX(step,r); i++)
+            {
+                if (t[i] != VALUE(step,r,i))
+                {
+                    printf ("rank %d: ERROR: step %d, block of rank %d, t[%d] = %g instead of %g\n",
+                            rank, step, r, i, t[i], VALUE(step,r,i));
+                    nerr++;
+                }
+            }
+        }
+    }
+    free (t);
+
+    adios_read_close (f);
+    adios_read_finalize_method (ADIOS_READ_METHOD_BP);
+    return nerr;
+}
+
+int main (int argc, char ** argv)
+{
+    int         rank, nerr, total;
+    MPI_Comm    comm = MPI_COMM_WORLD;
+
+    MPI_Init (&argc, &argv);
+    MPI_Comm_rank (comm, &rank);
+
+    if (argc < 3)
+    {
+        if (!rank)
+            printf ("Usage: mpi_amr_aggregation <filename> <method parameters>\n");
+        MPI_Finalize ();
+        return 1;
+    }
+
+    if (!rank)
+        printf ("Write %d steps to %s with \"%s\"\n", NSTEPS, argv[1], argv[2]);
+    write_file (argv[1], argv[2], comm);
+    nerr = read_file (argv[1], comm);
+
+    MPI_Allreduce (&nerr, &total, 1, MPI_INT, MPI_SUM, comm);
+    if (!rank && !total)
+        printf ("Read back every block of %s\n", argv[1]);
+
+    MPI_Finalize ();
+    return (total ? 1 : 0);
+}
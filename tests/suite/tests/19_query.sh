@@ -106,6 +106,17 @@ if [ "$HAS_FASTBIT" ]; then
   cp $FASTBIT_INDEXER_EXE_PATH  $FASTBIT_INDEXER_EXE_LOCAL
 fi
 
+# The SORTED method needs the sorted index built by another program
+case $ALL_QUERY_ENGINES in *sorted*) HAS_SORTED=1 ;; esac
+if [ "$HAS_SORTED" ]; then
+  SORTED_INDEXER_EXE_BASENAME="adios_index_sorted"
+  SORTED_INDEXER_EXE_PATH="$UTILS_DIR/sortedindex/$SORTED_INDEXER_EXE_BASENAME"
+  [ -f "$SORTED_INDEXER_EXE_PATH" -a -x "$SORTED_INDEXER_EXE_PATH" ] || die "ERROR: $SORTED_INDEXER_EXE_PATH is not executable"
+
+  SORTED_INDEXER_EXE_LOCAL="./$SORTED_INDEXER_EXE_BASENAME"
+  cp $SORTED_INDEXER_EXE_PATH  $SORTED_INDEXER_EXE_LOCAL
+fi
+
 
 
 #
@@ -181,6 +192,38 @@ function build_indexed_datasets_minmax() {
   echo "Minmax method uses data as is, no index file is built"
 }
 
+function build_indexed_datasets_scan() {
+  local DSID="$1"
+  local DSOUTPUT="$2"
+  [[ $# -eq 2 ]] || die "ERROR: Internal testing error, invalid parameters to build_indexed_datasets_scan: $@"
+  
+  invoke_dataset_builder "$DSID" "$DSOUTPUT" "none"
+  echo "Scan method uses data as is, no index file is built"
+}
+
+function build_indexed_datasets_bitmap() {
+  local DSID="$1"
+  local DSOUTPUT="$2"
+  [[ $# -eq 2 ]] || die "ERROR: Internal testing error, invalid parameters to build_indexed_datasets_bitmap: $@"
+  
+  # The datasets define no bitmap index, so this checks that the method
+  # scans the blocks without one
+  invoke_dataset_builder "$DSID" "$DSOUTPUT" "none"
+}
+
+function build_indexed_datasets_sorted() {
+  local DSID="$1"
+  local DSOUTPUT="$2"
+  [[ $# -eq 2 ]] || die "ERROR: Internal testing error, invalid parameters to build_indexed_datasets_sorted: $@"
+  
+  invoke_dataset_builder "$DSID" "$DSOUTPUT" "none"
+  
+  set -o xtrace
+  $MPIRUN_SERIAL $SORTED_INDEXER_EXE_LOCAL "$DSOUTPUT".bp ||
+    die "ERROR: $SORTED_INDEXER_EXE_LOCAL failed with exit code $?"
+  set +o xtrace
+}
+
 function build_datasets() {
   echo "STEP 2: INDEXING ALL TEST DATASETS USING ALL ENABLED INDEXING METHODS"
   echo "(ALSO PRODUCING A NON-INDEXED VERSION OF EACH DATASET FOR REFERENCE)"
@@ -0,0 +1,70 @@
+#!/bin/bash
+#
+# Test if bpmeta -i updates a metadata file after steps are appended to
+# the subfiles the same way as bpmeta creating it from scratch.
+# Uses ../programs/bpmeta_append
+#
+# Environment variables set by caller:
+# MPIRUN        Run command
+# NP_MPIRUN     Run commands option to set number of processes
+# MAXPROCS      Max number of processes allowed
+# HAVE_FORTRAN  yes or no
+# SRCDIR        Test source dir (.. of this script)
+# TRUNKDIR      ADIOS trunk dir
+
+PROCS=4
+
+if [ $MAXPROCS -lt $PROCS ]; then
+    echo "WARNING: Needs $PROCS processes at least"
+    exit 77  # not failure, just skip
+fi
+
+# copy codes and inputs to .
+cp $SRCDIR/programs/bpmeta_append .
+
+echo "Run bpmeta_append to write 2 steps"
+$MPIRUN $NP_MPIRUN $PROCS $EXEOPT ./bpmeta_append 0 2
+EX=$?
+if [ $EX != 0 ] || [ ! -f bpmeta_append.bp.dir/bpmeta_append.bp.1 ]; then
+    echo "ERROR: bpmeta_append failed at creating the subfiles. Exit code=$EX"
+    exit 1
+fi
+
+echo "Create the metadata file with bpmeta"
+$TRUNKDIR/utils/bpmeta/bpmeta -n 2 bpmeta_append.bp
+if [ $? != 0 ]; then
+    echo "ERROR: bpmeta failed at creating bpmeta_append.bp"
+    exit 1
+fi
+
+echo "Run bpmeta_append to append 1 step"
+$MPIRUN $NP_MPIRUN $PROCS $EXEOPT ./bpmeta_append 2 1
+EX=$?
+if [ $EX != 0 ]; then
+    echo "ERROR: bpmeta_append failed at appending to the subfiles. Exit code=$EX"
+    exit 1
+fi
+
+echo "Update the metadata file with bpmeta -i"
+$TRUNKDIR/utils/bpmeta/bpmeta -i -n 2 bpmeta_append.bp
+if [ $? != 0 ]; then
+    echo "ERROR: bpmeta -i failed at updating bpmeta_append.bp"
+    exit 1
+fi
+$TRUNKDIR/utils/bpdump/bpdump bpmeta_append.bp > incremental.txt
+
+echo "Create the metadata file again from scratch"
+rm -f bpmeta_append.bp
+$TRUNKDIR/utils/bpmeta/bpmeta -n 2 bpmeta_append.bp
+if [ $? != 0 ]; then
+    echo "ERROR: bpmeta failed at recreating bpmeta_append.bp"
+    exit 1
+fi
+$TRUNKDIR/utils/bpdump/bpdump bpmeta_append.bp > full.txt
+
+diff -q incremental.txt full.txt
+if [ $? != 0 ]; then
+    echo "ERROR: the index made by bpmeta -i differs from the one made by bpmeta."
+    echo "Compare $PWD/incremental.txt to $PWD/full.txt"
+    exit 1
+fi
@@ -0,0 +1,49 @@
+#!/bin/bash
+#
+# Test the aggregation paths of the MPI_AGGREGATE method: through node-local
+# shared memory or with messages, with the simple all-to-one (AG) and the
+# brigade (BG) strategies, and the pipelined AG with a small buffer. Every
+# configuration writes and appends steps of uneven blocks, and reads back
+# the block of every rank.
+# Uses ../programs/mpi_amr_aggregation
+#
+# Environment variables set by caller:
+# MPIRUN        Run command
+# NP_MPIRUN     Run commands option to set number of processes
+# MAXPROCS      Max number of processes allowed
+# HAVE_FORTRAN  yes or no
+# SRCDIR        Test source dir (.. of this script)
+# TRUNKDIR      ADIOS trunk dir
+
+PROCS=5
+
+if [ $MAXPROCS -lt $PROCS ]; then
+    echo "WARNING: Needs $PROCS processes at least"
+    exit 77  # not failure, just skip
+fi
+
+# copy codes and inputs to .
+cp $SRCDIR/programs/mpi_amr_aggregation .
+
+# 2 aggregators for 5 processes make groups of 3 and 2 processes
+CONFIGS="
+shm_aggregation=0;aggregation_type=1
+shm_aggregation=1;aggregation_type=1
+shm_aggregation=0;aggregation_type=2
+shm_aggregation=1;aggregation_type=2
+shm_aggregation=0;aggregation_type=1;pipeline_buffer_size=1
+shm_aggregation=1;aggregation_type=1;pipeline_buffer_size=1
+"
+
+N=0
+for CONFIG in $CONFIGS; do
+    N=$((N+1))
+    PARAMS="num_aggregators=2;$CONFIG"
+    echo "Run mpi_amr_aggregation with $PARAMS"
+    $MPIRUN $NP_MPIRUN $PROCS $EXEOPT ./mpi_amr_aggregation aggr$N.bp "$PARAMS"
+    EX=$?
+    if [ $EX != 0 ]; then
+        echo "ERROR: mpi_amr_aggregation failed with $PARAMS. Exit code=$EX"
+        exit 1
+    fi
+done
@@ -0,0 +1,72 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "transforms/adios_transform_aplod_read.h"
+
+/* Test how many APLOD byte components are read for a read parameter
+ * (see adios_schedule_read_param()).
+ */
+
+/* Components of a double and a float, as set with the transform parameters */
+const int32_t double_components[] = {2, 2, 4};
+const int32_t float_components[] = {2, 1, 1};
+/* The default components of a double */
+const int32_t default_double_components[] = {2, 2, 2, 2};
+
+int dotest (const char * param, int ncomponents, const int32_t *components, int expected)
+{
+    int nerrors = 0;
+    int n = adios_transform_aplod_components_to_read (param, ncomponents, components);
+    printf("param=[%s] components=%d -> %d\n", param ? param : "(null)", ncomponents, n);
+
+    /* Check value */
+    if (n != expected)
+    {
+        printf("   ERROR: %d components to read instead of %d\n", n, expected);
+        nerrors++;
+    }
+
+    return nerrors;
+}
+
+int main (int argc, char ** argv)
+{
+    int nerrors = 0;
+    printf("\n============= APLOD read parameter test =========\n");
+
+    /* Full precision */
+    nerrors += dotest (NULL, 3, double_components, 3);
+    nerrors += dotest ("", 3, double_components, 3);
+
+    /* bytes=N rounds up to whole components and is clamped to the value size */
+    nerrors += dotest ("bytes=1", 3, double_components, 1);
+    nerrors += dotest ("bytes=2", 3, double_components, 1);
+    nerrors += dotest ("bytes=3", 3, double_components, 2);
+    nerrors += dotest ("bytes=4", 3, double_components, 2);
+    nerrors += dotest ("bytes=5", 3, double_components, 3);
+    nerrors += dotest ("bytes=8", 3, double_components, 3);
+    nerrors += dotest ("bytes=100", 3, double_components, 3);
+    nerrors += dotest ("bytes=3", 3, float_components, 2);
+    nerrors += dotest ("bytes=4", 3, float_components, 3);
+    nerrors += dotest ("bytes=2", 4, default_double_components, 1);
+    nerrors += dotest ("bytes=7", 4, default_double_components, 4);
+
+    /* N components, clamped to the number of components */
+    nerrors += dotest ("1", 3, double_components, 1);
+    nerrors += dotest ("2", 3, double_components, 2);
+    nerrors += dotest ("3", 3, double_components, 3);
+    nerrors += dotest ("7", 3, double_components, 3);
+
+    /* Invalid parameters read at full precision */
+    nerrors += dotest ("bytes=", 3, double_components, 3);
+    nerrors += dotest ("bytes=0", 3, double_components, 3);
+    nerrors += dotest ("bytes=-2", 3, double_components, 3);
+    nerrors += dotest ("bytes=2x", 3, double_components, 3);
+    nerrors += dotest ("bits=2", 3, double_components, 3);
+    nerrors += dotest ("0", 3, double_components, 3);
+    nerrors += dotest ("-1", 3, double_components, 3);
+    nerrors += dotest ("2 components", 3, double_components, 3);
+
+    printf("\nNumber of errors in this test: %d\n", nerrors);
+    return nerrors;
+}
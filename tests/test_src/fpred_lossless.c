@@ -0,0 +1,362 @@
+/*
+ * ADIOS is freely available under the terms of the BSD license described
+ * in the COPYING file in the top level directory of this source distribution.
+ *
+ * Copyright (c) 2008 - 2009.  UT-BATTELLE, LLC. All rights reserved.
+ */
+
+/* ADIOS C test:
+ *  Write 1D, 2D and 3D float and double arrays with transform="fpred", with
+ *  both predictors, in blocks along the slowest dimension. The special values
+ *  are NaNs with payloads, infinities, negative zeros and denormals. Arrays
+ *  made of them only do not shrink and are stored as is, while smooth arrays,
+ *  also with a few special values sprinkled in, must be compressed. One array
+ *  has a single element.
+ *
+ *  fpred is lossless, so the whole arrays and sub-boxes of them, within and
+ *  across blocks, must read back bit for bit.
+ *
+ * How to run: ./fpred_lossless
+ * Output: fpred_lossless.bp
+ *
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <float.h>
+#include <math.h>
+#include "public/adios.h"
+#include "public/adios_read.h"
+#include "public/adios_read_ext.h"
+
+#ifdef DMALLOC
+#include "dmalloc.h"
+#endif
+
+#define log(...) fprintf (stderr, "[rank=%3.3d, line %d]: ", rank, __LINE__); fprintf (stderr, __VA_ARGS__); fflush(stderr);
+#define printE(...) fprintf (stderr, "[rank=%3.3d, line %d]: ERROR: ", rank, __LINE__); fprintf (stderr, __VA_ARGS__); fflush(stderr);
+
+static const char FILENAME[] = "fpred_lossless.bp";
+
+MPI_Comm    comm = MPI_COMM_SELF; // dummy comm for sequential code
+int rank;
+int size;
+
+/* How the values of an array are made: smooth, special only, or smooth with
+   a special value every 97 values */
+enum fill { SMOOTH, SPECIAL, SPRINKLED };
+
+/* The arrays, written in nblocks blocks of ldims along the slowest dimension */
+struct test_var {
+    const char *name;
+    enum ADIOS_DATATYPES type;
+    int ndim;
+    uint64_t ldims[3];
+    int nblocks;
+    const char *transform;
+    enum fill fill;
+    int compressed;  // every block must be compressed, not stored as is
+    void *data;      // the whole global array
+} VARS[] = {
+    { "d1_special",  adios_double, 1, {1000},       2, "fpred",                    SPECIAL,   0 },
+    { "f1_special",  adios_real,   1, {1000},       2, "fpred:predictor=previous", SPECIAL,   0 },
+    { "d1_one",      adios_double, 1, {1},          1, "fpred",                    SPRINKLED, 0 },
+    { "f1_one",      adios_real,   1, {1},          1, "fpred:predictor=previous", SMOOTH,    0 },
+    { "d2_smooth",   adios_double, 2, {20, 37},     2, "fpred",                    SMOOTH,    1 },
+    { "f2_previous", adios_real,   2, {16, 33},     2, "fpred:predictor=previous", SMOOTH,    1 },
+    { "f3_sprinkled",adios_real,   3, {6, 9, 35},   2, "fpred",                    SPRINKLED, 1 },
+    { "d3_sprinkled",adios_double, 3, {5, 8, 13},   2, "fpred:predictor=lorenzo",  SPRINKLED, 1 },
+};
+#define NVARS (int)(sizeof(VARS) / sizeof(VARS[0]))
+
+static int elem_size (const struct test_var *v)
+{
+    return (v->type == adios_real ? sizeof(float) : sizeof(double));
+}
+
+static void global_dims (const struct test_var *v, uint64_t *gdims)
+{
+    int d;
+    for (d = 0; d < v->ndim; d++)
+        gdims[d] = v->ldims[d];
+    gdims[0] *= v->nblocks;
+}
+
+static uint64_t nelems (int ndim, const uint64_t *dims)
+{
+    int d;
+    uint64_t n = 1;
+    for (d = 0; d < ndim; d++)
+        n *= dims[d];
+    return n;
+}
+
+/* NaNs with payloads and both signs, infinities, negative zero, denormals */
+static double special_double (uint64_t n)
+{
+    uint64_t bits;
+    double d;
+    switch (n % 8) {
+        case 0:  bits = 0x7ff80000deadbeefULL; memcpy (&d, &bits, sizeof(d)); return d;
+        case 1:  bits = 0xfff0000000000001ULL + n; memcpy (&d, &bits, sizeof(d)); return d;
+        case 2:  return INFINITY;
+        case 3:  return -INFINITY;
+        case 4:  return -0.0;
+        case 5:  return DBL_MIN / (2 + n % 1000);
+        case 6:  return -DBL_MIN / (2 + n % 1000);
+        default: return 1.5 * n;
+    }
+}
+
+static float special_float (uint64_t n)
+{
+    uint32_t bits;
+    float f;
+    switch (n % 8) {
+        case 0:  bits = 0x7fc0beefU; memcpy (&f, &bits, sizeof(f)); return f;
+        case 1:  bits = 0xff800001U + (uint32_t) n; memcpy (&f, &bits, sizeof(f)); return f;
+        case 2:  return INFINITY;
+        case 3:  return -INFINITY;
+        case 4:  return -0.0f;
+        case 5:  return FLT_MIN / (2 + n % 1000);
+        case 6:  return -FLT_MIN / (2 + n % 1000);
+        default: return 1.5f * n;
+    }
+}
+
+/* Value at global point (i,j,k), n is its position in the global array */
+static void fill_value (struct test_var *v, uint64_t n, uint64_t i, uint64_t j, uint64_t k)
+{
+    double d = 0.25*i + 0.5*j + 2.0*k + 100.0;
+    int special = (v->fill == SPECIAL || (v->fill == SPRINKLED && n % 97 == 0));
+
+    if (v->type == adios_real)
+        ((float *) v->data)[n] = (special ? special_float (n) : (float) d);
+    else
+        ((double *) v->data)[n] = (special ? special_double (n) : d);
+}
+
+static void fill_var (struct test_var *v)
+{
+    uint64_t gdims[3] = {1, 1, 1}, i, j, k, n = 0;
+
+    global_dims (v, gdims);
+    v->data = malloc (nelems (v->ndim, gdims) * elem_size (v));
+    for (i = 0; i < gdims[0]; i++)
+        for (j = 0; j < (v->ndim > 1 ? gdims[1] : 1); j++)
+            for (k = 0; k < (v->ndim > 2 ? gdims[2] : 1); k++, n++)
+                fill_value (v, n, i, j, k);
+}
+
+int write_file ();
+int read_file ();
+
+int main (int argc, char ** argv)
+{
+    int err, i;
+
+    MPI_Init (&argc, &argv);
+    MPI_Comm_rank (comm, &rank);
+    MPI_Comm_size (comm, &size);
+
+    for (i = 0; i < NVARS; i++)
+        fill_var (&VARS[i]);
+
+    adios_init_noxml (comm);
+    err = adios_read_init_method(ADIOS_READ_METHOD_BP, comm, "verbose=2");
+    if (err) {
+        printE ("%s\n", adios_errmsg());
+    }
+
+    err = write_file ();
+    if (!err)
+        err = read_file ();
+
+    adios_read_finalize_method (ADIOS_READ_METHOD_BP);
+    adios_finalize (rank);
+    MPI_Finalize ();
+    for (i = 0; i < NVARS; i++)
+        free (VARS[i].data);
+    return err;
+}
+
+/* "a,b,c" from the values */
+static void dims_str (char *s, int ndim, const uint64_t *dims)
+{
+    int d;
+    s[0] = '\0';
+    for (d = 0; d < ndim; d++)
+        sprintf (s + strlen(s), "%s%llu", (d ? "," : ""), (unsigned long long) dims[d]);
+}
+
+int write_file ()
+{
+    int64_t       m_adios_group, fh;
+    uint64_t      groupsize = sizeof(int), totalsize;
+    uint64_t      gdims[3];
+    char          l[64], g[64], o[64];
+    int           i, b, offs;
+
+    adios_declare_group (&m_adios_group, "fpred_lossless", "", adios_stat_default);
+    adios_select_method (m_adios_group, "POSIX", "", "");
+    adios_define_var (m_adios_group, "offs", "", adios_integer, 0, 0, 0);
+    for (i = 0; i < NVARS; i++) {
+        struct test_var *v = &VARS[i];
+        global_dims (v, gdims);
+        dims_str (l, v->ndim, v->ldims);
+        dims_str (g, v->ndim, gdims);
+        // the block offset along the slowest dimension is "offs", zero in the others
+        strcpy (o, (v->ndim == 1 ? "offs" : (v->ndim == 2 ? "offs,0" : "offs,0,0")));
+        for (b = 0; b < v->nblocks; b++) {
+            int64_t varid = adios_define_var (m_adios_group, v->name, "", v->type, l, g, o);
+            adios_set_transform (varid, v->transform);
+        }
+        groupsize += nelems (v->ndim, gdims) * elem_size (v) + v->nblocks * sizeof(int);
+    }
+
+    log ("Write to %s\n", FILENAME);
+    adios_open (&fh, "fpred_lossless", FILENAME, "w", comm);
+    adios_group_size (fh, groupsize, &totalsize);
+    for (i = 0; i < NVARS; i++) {
+        struct test_var *v = &VARS[i];
+        uint64_t blocksize = nelems (v->ndim, v->ldims) * elem_size (v);
+        for (b = 0; b < v->nblocks; b++) {
+            offs = b * v->ldims[0];
+            adios_write (fh, "offs", &offs);
+            adios_write (fh, v->name, (char *) v->data + b * blocksize);
+        }
+    }
+    if (adios_close (fh)) {
+        printE ("Writing failed: %s\n", adios_errmsg());
+        return 1;
+    }
+    return 0;
+}
+
+/* Read box (start,count) of v and compare it bit for bit to the written data */
+static int check_box (ADIOS_FILE *f, struct test_var *v, const uint64_t *start, const uint64_t *count)
+{
+    int nerr = 0, es = elem_size (v), d, pad = 3 - v->ndim;
+    uint64_t gdims[3], g[3] = {1, 1, 1}, s[3] = {0, 0, 0}, c[3] = {1, 1, 1}, i, j, n = 0;
+    char *box = malloc (nelems (v->ndim, count) * es);
+    ADIOS_SELECTION *sel = adios_selection_boundingbox (v->ndim, (uint64_t *) start, (uint64_t *) count);
+
+    // look at every array as 3D, with leading dimensions of 1
+    global_dims (v, gdims);
+    for (d = 0; d < v->ndim; d++) {
+        g[pad+d] = gdims[d];
+        s[pad+d] = start[d];
+        c[pad+d] = count[d];
+    }
+
+    adios_schedule_read (f, sel, v->name, 0, 1, box);
+    if (adios_perform_reads (f, 1)) {
+        printE ("Reading a box of %s failed: %s\n", v->name, adios_errmsg());
+        nerr++;
+    }
+    // compare the box row by row along the fastest dimension
+    for (i = s[0]; !nerr && i < s[0]+c[0]; i++)
+        for (j = s[1]; !nerr && j < s[1]+c[1]; j++, n++)
+            if (memcmp (box + n*c[2]*es, (char *) v->data + ((i*g[1] + j)*g[2] + s[2])*es, c[2]*es)) {
+                printE ("%s: box {%llu,%llu,%llu} + {%llu,%llu,%llu} differs in its row at [%llu,%llu]\n",
+                        v->name, (unsigned long long) s[0], (unsigned long long) s[1],
+                        (unsigned long long) s[2], (unsigned long long) c[0],
+                        (unsigned long long) c[1], (unsigned long long) c[2],
+                        (unsigned long long) i, (unsigned long long) j);
+                nerr++;
+            }
+    adios_selection_delete (sel);
+    free (box);
+    return nerr;
+}
+
+/* Check that fpred was applied to every block, and compressed them if it must */
+static int check_transform (ADIOS_FILE *f, struct test_var *v)
+{
+    int nerr = 0, b;
+    ADIOS_VARINFO *vi = adios_inq_var (f, v->name);
+    if (!vi) {
+        printE ("%s is missing: %s\n", v->name, adios_errmsg());
+        return 1;
+    }
+    ADIOS_VARTRANSFORM *vt = adios_inq_var_transform (f, vi);
+    if (vt->transform_type == NO_TRANSFORM || vi->sum_nblocks != v->nblocks) {
+        printE ("%s was not written in %d blocks with transform \"%s\"\n",
+                v->name, v->nblocks, v->transform);
+        nerr++;
+    }
+    // the predictor follows the original size and the element size in the metadata
+    for (b = 0; !nerr && v->compressed && b < vt->sum_nblocks; b++) {
+        const uint8_t *md = vt->transform_metadatas[b].content;
+        if (vt->transform_metadatas[b].length < sizeof(uint64_t) + 2 || md[sizeof(uint64_t) + 1] == 0) {
+            printE ("Block %d of %s was stored as is instead of compressed\n", b, v->name);
+            nerr++;
+        }
+    }
+    adios_free_var_transform (vt);
+    adios_free_varinfo (vi);
+    return nerr;
+}
+
+int read_file ()
+{
+    ADIOS_FILE * f;
+    int nerr = 0, i, d;
+
+    log ("Read from %s\n", FILENAME);
+    f = adios_read_open_file (FILENAME, ADIOS_READ_METHOD_BP, comm);
+    if (f == NULL) {
+        printE ("Error at opening file: %s\n", adios_errmsg());
+        return 1;
+    }
+
+    for (i = 0; i < NVARS; i++) {
+        struct test_var *v = &VARS[i];
+        uint64_t gdims[3], start[3], count[3], zero[3] = {0, 0, 0};
+        int err;
+
+        global_dims (v, gdims);
+        err = check_transform (f, v);
+
+        // the whole array
+        if (!err)
+            err += check_box (f, v, zero, gdims);
+
+        // a box within the dimensions, across the blocks
+        for (d = 0; d < v->ndim; d++) {
+            start[d] = (gdims[d] > 2 ? 1 : 0);
+            count[d] = gdims[d] - 2*start[d];
+        }
+        if (v->nblocks > 1) {
+            start[0] = v->ldims[0]/2;
+            count[0] = v->ldims[0];
+        }
+        if (!err)
+            err += check_box (f, v, start, count);
+
+        // a box within the second block
+        if (v->nblocks > 1) {
+            start[0] = v->ldims[0] + 1;
+            count[0] = (v->ldims[0] > 2 ? v->ldims[0] - 2 : 1);
+            if (!err)
+                err += check_box (f, v, start, count);
+        }
+
+        // the last value
+        for (d = 0; d < v->ndim; d++) {
+            start[d] = gdims[d] - 1;
+            count[d] = 1;
+        }
+        if (!err)
+            err += check_box (f, v, start, count);
+
+        if (!err) {
+            log ("    %s with transform \"%s\" as expected\n", v->name, v->transform);
+        }
+        nerr += err;
+    }
+
+    adios_read_close (f);
+    return nerr;
+}
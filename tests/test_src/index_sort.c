@@ -0,0 +1,274 @@
+/*
+ * ADIOS is freely available under the terms of the BSD license described
+ * in the COPYING file in the top level directory of this source distribution.
+ *
+ * Copyright (c) 2008 - 2009.  UT-BATTELLE, LLC. All rights reserved.
+ */
+
+/* ADIOS C test:
+ *  Merge the time-aggregated indexes of NPROCS processes into one index,
+ *  the way an aggregator does: every process buffered NSTEPS steps, so the
+ *  merged PGs and characteristics are runs of steps out of time order. The
+ *  last process lists its steps backwards, so its run is out of order too.
+ *
+ *  adios_sort_index_v1() must order the PGs by (time, process) and the
+ *  characteristics by time, keeping the process order within a step. Then
+ *  the index is written with adios_write_index_v1(), parsed back, and the
+ *  order and values of the parsed index are checked again.
+ *
+ * How to run: ./index_sort
+ * Output: None
+ *
+ */
+#ifndef _NOMPI
+#define _NOMPI
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include "core/adios_internals.h"
+#include "core/adios_bp_v1.h"
+#include "public/adios_error.h"
+
+#ifdef DMALLOC
+#include "dmalloc.h"
+#endif
+
+#define log(...) fprintf (stderr, "[line %d]: ", __LINE__); fprintf (stderr, __VA_ARGS__); fflush(stderr);
+#define printE(...) fprintf (stderr, "[line %d]: ERROR: ", __LINE__); fprintf (stderr, __VA_ARGS__); fflush(stderr);
+
+#define NPROCS 3
+#define NSTEPS 4
+#define NX 10
+
+/* steps are 1-based time indexes, the last process lists them backwards */
+#define STEP(proc,k) ((proc) == NPROCS-1 ? NSTEPS-(k) : (k)+1)
+
+/* identify where a PG or characteristic came from */
+#define OFFSET(proc,step) (100000*(proc) + 1000*(step))
+#define VALUE(proc,step)  (100.0*(step) + (proc))
+
+static struct adios_index_var_struct_v1 * new_var (uint32_t id, const char * name,
+                                                   enum ADIOS_DATATYPES type)
+{
+    struct adios_index_var_struct_v1 * v = calloc (1, sizeof (*v));
+    v->id = id;
+    v->group_name = strdup ("g");
+    v->var_name = strdup (name);
+    v->var_path = strdup ("");
+    v->type = type;
+    v->characteristics_count = NSTEPS;
+    v->characteristics_allocated = NSTEPS;
+    v->characteristics = calloc (NSTEPS, sizeof (struct adios_index_characteristic_struct_v1));
+    return v;
+}
+
+/* The time-aggregated index of one process: NSTEPS PGs, a scalar 'step'
+   and a 1D array 't' */
+static void merge_process_index (struct adios_index_struct_v1 * index, int proc)
+{
+    struct adios_index_process_group_struct_v1 * pgs = NULL, * pg, * last = NULL;
+    struct adios_index_var_struct_v1 * step, * t;
+    int k;
+
+    step = new_var (1, "step", adios_double);
+    t = new_var (2, "t", adios_double);
+    step->next = t;
+
+    for (k = 0; k < NSTEPS; k++)
+    {
+        uint32_t s = STEP(proc,k);
+        struct adios_index_characteristic_struct_v1 * c;
+
+        pg = calloc (1, sizeof (*pg));
+        pg->group_name = strdup ("g");
+        pg->adios_host_language_fortran = adios_flag_no;
+        pg->process_id = proc;
+        pg->time_index_name = strdup ("");
+        pg->time_index = s;
+        pg->offset_in_file = OFFSET(proc,s);
+        pg->is_time_aggregated = 1;
+        if (last)
+            last->next = pg;
+        else
+            pgs = pg;
+        last = pg;
+
+        c = &step->characteristics[k];
+        c->offset = OFFSET(proc,s) + 10;
+        c->payload_offset = OFFSET(proc,s) + 20;
+        c->file_index = proc;
+        c->time_index = s;
+        c->value = malloc (sizeof(double));
+        *(double *) c->value = VALUE(proc,s);
+
+        c = &t->characteristics[k];
+        c->offset = OFFSET(proc,s) + 30;
+        c->payload_offset = OFFSET(proc,s) + 40;
+        c->file_index = proc;
+        c->time_index = s;
+        c->dims.count = 1;
+        c->dims.dims = malloc (3 * sizeof(uint64_t));
+        c->dims.dims[0] = NX;
+        c->dims.dims[1] = NX*NPROCS;
+        c->dims.dims[2] = NX*proc;
+    }
+
+    adios_merge_index_v1 (index, pgs, step, NULL, 0);
+}
+
+/* Check that the index lists everything in (time, process) order
+   with the values written for that process and step */
+static int check_index (struct adios_index_struct_v1 * index, const char * what)
+{
+    struct adios_index_process_group_struct_v1 * pg;
+    struct adios_index_var_struct_v1 * v;
+    int nerr = 0, n = 0;
+    uint64_t i;
+
+    for (pg = index->pg_root; pg; pg = pg->next, n++)
+    {
+        uint32_t s = n / NPROCS + 1, proc = n % NPROCS;
+        if (pg->time_index != s || pg->process_id != proc ||
+            pg->offset_in_file != OFFSET(proc,s))
+        {
+            printE ("%s: PG %d is (time %u, process %u, offset %llu) instead of "
+                    "(time %u, process %u, offset %llu)\n", what, n,
+                    pg->time_index, pg->process_id,
+                    (unsigned long long) pg->offset_in_file,
+                    s, proc, (unsigned long long) OFFSET(proc,s));
+            nerr++;
+        }
+    }
+    if (n != NPROCS*NSTEPS)
+    {
+        printE ("%s: %d PGs instead of %d\n", what, n, NPROCS*NSTEPS);
+        nerr++;
+    }
+
+    for (v = index->vars_root; v && !nerr; v = v->next)
+    {
+        int is_step = !strcmp (v->var_name, "step");
+        if (v->characteristics_count != NPROCS*NSTEPS)
+        {
+            printE ("%s: %s has %llu characteristics instead of %d\n", what, v->var_name,
+                    (unsigned long long) v->characteristics_count, NPROCS*NSTEPS);
+            nerr++;
+            break;
+        }
+        for (i = 0; i < v->characteristics_count && nerr < 10; i++)
+        {
+            struct adios_index_characteristic_struct_v1 * c = &v->characteristics[i];
+            uint32_t s = i / NPROCS + 1, proc = i % NPROCS;
+            uint64_t offset = OFFSET(proc,s) + (is_step ? 10 : 30);
+
+            if (c->time_index != s || c->file_index != proc || c->offset != offset ||
+                c->payload_offset != offset + 10)
+            {
+                printE ("%s: %s[%llu] is (time %u, file %u, offset %llu) instead of "
+                        "(time %u, file %u, offset %llu)\n", what, v->var_name,
+                        (unsigned long long) i, c->time_index, c->file_index,
+                        (unsigned long long) c->offset, s, proc,
+                        (unsigned long long) offset);
+                nerr++;
+            }
+            else if (is_step && (!c->value || *(double *) c->value != VALUE(proc,s)))
+            {
+                printE ("%s: step[%llu] has value %g instead of %g\n", what,
+                        (unsigned long long) i, (c->value ? *(double *) c->value : -1.0),
+                        VALUE(proc,s));
+                nerr++;
+            }
+            else if (!is_step && (c->dims.count != 1 || c->dims.dims[0] != NX ||
+                     c->dims.dims[1] != NX*NPROCS || c->dims.dims[2] != NX*proc))
+            {
+                printE ("%s: t[%llu] has wrong dimensions\n", what, (unsigned long long) i);
+                nerr++;
+            }
+        }
+    }
+    return nerr;
+}
+
+/* Write the index into a buffer and parse it back into parsed */
+static int write_and_parse (struct adios_index_struct_v1 * index,
+                            struct adios_index_struct_v1 * parsed)
+{
+    struct adios_bp_buffer_struct_v1 b;
+    char * buffer = NULL;
+    uint64_t buffer_size = 0, buffer_offset = 0;
+    int err;
+
+    adios_write_index_v1 (&buffer, &buffer_size, &buffer_offset, 0, index);
+    adios_write_version_v1 (&buffer, &buffer_size, &buffer_offset);
+
+    memset (&b, 0, sizeof(b));
+    b.buff = buffer;
+    b.length = buffer_offset;
+    b.file_size = buffer_offset;
+    b.change_endianness = adios_flag_no;
+    b.offset = buffer_offset - 28;
+    err = adios_parse_index_offsets_v1 (&b);
+    if (!err)
+    {
+        b.offset = b.pg_index_offset;
+        err = adios_parse_process_group_index_v1 (&b, &parsed->pg_root, &parsed->pg_tail);
+    }
+    if (!err)
+    {
+        b.offset = b.vars_index_offset;
+        err = adios_parse_vars_index_v1 (&b, &parsed->vars_root, parsed->hashtbl_vars,
+                                         &parsed->vars_tail);
+    }
+    if (err)
+    {
+        printE ("Parsing the written index failed: %s\n", adios_get_last_errmsg());
+    }
+    free (buffer);
+    return err;
+}
+
+int main (int argc, char ** argv)
+{
+    struct adios_index_struct_v1 * index, * parsed;
+    int proc, err = 0;
+
+    index = adios_alloc_index_v1 (1);
+    for (proc = 0; proc < NPROCS; proc++)
+        merge_process_index (index, proc);
+
+    if (!index->needs_sorting)
+    {
+        printE ("The merged index is not flagged for sorting\n");
+        err++;
+    }
+
+    log ("Sort the merged index\n");
+    adios_sort_index_v1 (index);
+    if (index->needs_sorting)
+    {
+        printE ("The index is still flagged for sorting after sorting it\n");
+        err++;
+    }
+    err += check_index (index, "sorted index");
+
+    if (!err)
+    {
+        log ("Write and parse back the sorted index\n");
+        parsed = adios_alloc_index_v1 (1);
+        err = write_and_parse (index, parsed);
+        if (!err)
+            err = check_index (parsed, "parsed index");
+        adios_clear_index_v1 (parsed);
+        adios_free_index_v1 (parsed);
+    }
+
+    adios_clear_index_v1 (index);
+    adios_free_index_v1 (index);
+    if (!err) {
+        log ("The index is in time order with the right values\n");
+    }
+    return err;
+}
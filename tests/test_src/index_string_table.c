@@ -0,0 +1,270 @@
+/*
+ * ADIOS is freely available under the terms of the BSD license described
+ * in the COPYING file in the top level directory of this source distribution.
+ *
+ * Copyright (c) 2008 - 2009.  UT-BATTELLE, LLC. All rights reserved.
+ */
+
+/* ADIOS C test:
+ *  Write the same variables and attributes in several steps with the POSIX
+ *  method, once with the default index and once with index_string_table=1,
+ *  appending the steps after the first one (so the index of the file is
+ *  read back and merged by the writer too).
+ *
+ *  The index with the string table must be smaller, and both files must
+ *  give the same variables, attributes and values.
+ *
+ * How to run: ./index_string_table
+ * Output: index_string_table_plain.bp, index_string_table.bp
+ *
+ */
+#ifndef _NOMPI
+#define _NOMPI
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <sys/stat.h>
+#include "public/adios.h"
+#include "public/adios_read.h"
+
+#ifdef DMALLOC
+#include "dmalloc.h"
+#endif
+
+#define log(...) fprintf (stderr, "[line %d]: ", __LINE__); fprintf (stderr, __VA_ARGS__); fflush(stderr);
+#define printE(...) fprintf (stderr, "[line %d]: ERROR: ", __LINE__); fprintf (stderr, __VA_ARGS__); fflush(stderr);
+
+static const char PLAINFILE[] = "index_string_table_plain.bp";
+static const char TABLEFILE[] = "index_string_table.bp";
+
+#define NSTEPS 3
+#define NFIELDS 20   // arrays, in two paths
+#define NX 10
+
+static const int nx = NX;
+static const char * paths[] = { "mesh/fields", "mesh/diagnostics" };
+static const char * attr_values[] = { "m/s", "K", "" };
+
+MPI_Comm comm = MPI_COMM_SELF; // dummy comm for sequential code
+
+#define VALUE(step,f,i) (1000.0*(step) + 10.0*(f) + (i))
+
+void define_group (int64_t * group, const char * name, const char * params)
+{
+    char vname[32];
+    int f;
+
+    adios_declare_group (group, name, "", adios_stat_default);
+    adios_select_method (*group, "POSIX", params, "");
+
+    adios_define_var (*group, "nx", "", adios_integer, 0, 0, 0);
+    adios_define_var (*group, "step", "", adios_integer, 0, 0, 0);
+    for (f = 0; f < NFIELDS; f++)
+    {
+        snprintf (vname, sizeof(vname), "field%d", f);
+        adios_define_var (*group, vname, paths[f%2], adios_double, "nx", "", "");
+        adios_define_attribute (*group, "unit", vname, adios_string,
+                                attr_values[f%3], 0);
+    }
+    adios_define_attribute (*group, "description", "", adios_string,
+                            "index string table test", 0);
+}
+
+int write_file (const char * group, const char * filename)
+{
+    int64_t fh;
+    uint64_t groupsize, totalsize;
+    double v[NX];
+    char vname[64];
+    int step, f, i;
+
+    log ("Write %s\n", filename);
+    for (step = 0; step < NSTEPS; step++)
+    {
+        adios_open (&fh, group, filename, (step ? "a" : "w"), comm);
+        groupsize = 2*sizeof(int) + NFIELDS*NX*sizeof(double);
+        adios_group_size (fh, groupsize, &totalsize);
+        adios_write (fh, "nx", (void *) &nx);
+        adios_write (fh, "step", &step);
+        for (f = 0; f < NFIELDS; f++)
+        {
+            for (i = 0; i < NX; i++)
+                v[i] = VALUE(step,f,i);
+            snprintf (vname, sizeof(vname), "%s/field%d", paths[f%2], f);
+            adios_write (fh, vname, v);
+        }
+        if (adios_close (fh))
+        {
+            printE ("Writing %s failed: %s\n", filename, adios_errmsg());
+            return 1;
+        }
+    }
+    return 0;
+}
+
+int64_t file_size (const char * filename)
+{
+    struct stat st;
+    if (stat (filename, &st))
+        return -1;
+    return (int64_t) st.st_size;
+}
+
+/* The timer variables and attributes are named after the group */
+int is_timer (const char * name)
+{
+    return !strncmp (name, "/__adios__", 10);
+}
+
+/* Read every variable and attribute of both files and compare them */
+int compare_files ()
+{
+    ADIOS_FILE *fp, *ft;
+    int nerr = 0, i, s;
+    uint64_t start = 0, count = NX;
+    double vp[NX*NSTEPS], vt[NX*NSTEPS];
+
+    adios_read_init_method (ADIOS_READ_METHOD_BP, comm, "");
+    fp = adios_read_open_file (PLAINFILE, ADIOS_READ_METHOD_BP, comm);
+    ft = adios_read_open_file (TABLEFILE, ADIOS_READ_METHOD_BP, comm);
+    if (!fp || !ft)
+    {
+        printE ("Error at opening the files: %s\n", adios_errmsg());
+        return 1;
+    }
+
+    if (fp->nvars != ft->nvars || fp->nattrs != ft->nattrs ||
+        ft->last_step != NSTEPS-1)
+    {
+        printE ("%s has %d variables, %d attributes and %d steps while "
+                "%s has %d variables, %d attributes and %d steps\n",
+                TABLEFILE, ft->nvars, ft->nattrs, ft->last_step+1,
+                PLAINFILE, fp->nvars, fp->nattrs, fp->last_step+1);
+        nerr++;
+    }
+
+    for (i = 0; !nerr && i < fp->nvars; i++)
+    {
+        ADIOS_VARINFO *vi;
+        if (is_timer (fp->var_namelist[i]))
+            continue;
+        vi = adios_inq_var (ft, fp->var_namelist[i]);
+        if (!vi)
+        {
+            printE ("Variable %s is missing from %s\n", fp->var_namelist[i], TABLEFILE);
+            nerr++;
+            continue;
+        }
+        if (vi->nsteps != NSTEPS)
+        {
+            printE ("Variable %s has %d steps instead of %d\n", fp->var_namelist[i],
+                    vi->nsteps, NSTEPS);
+            nerr++;
+        }
+        if (vi->ndim == 1)
+        {
+            ADIOS_SELECTION *sel = adios_selection_boundingbox (1, &start, &count);
+            memset (vt, 0, sizeof(vt));
+            adios_schedule_read (fp, sel, fp->var_namelist[i], 0, NSTEPS, vp);
+            adios_schedule_read (ft, sel, fp->var_namelist[i], 0, NSTEPS, vt);
+            adios_perform_reads (fp, 1);
+            adios_perform_reads (ft, 1);
+            adios_selection_delete (sel);
+            if (memcmp (vp, vt, sizeof(vt)))
+            {
+                printE ("Variable %s differs in the two files\n", fp->var_namelist[i]);
+                nerr++;
+            }
+        }
+        adios_free_varinfo (vi);
+    }
+
+    for (i = 0; !nerr && i < fp->nattrs; i++)
+    {
+        enum ADIOS_DATATYPES tp, tt;
+        int sp, st;
+        void *dp, *dt;
+        if (is_timer (fp->attr_namelist[i]))
+            continue;
+        if (adios_get_attr (fp, fp->attr_namelist[i], &tp, &sp, &dp) ||
+            adios_get_attr (ft, fp->attr_namelist[i], &tt, &st, &dt))
+        {
+            printE ("Attribute %s is missing from %s\n", fp->attr_namelist[i], TABLEFILE);
+            nerr++;
+            continue;
+        }
+        if (tp != tt || sp != st || memcmp (dp, dt, sp))
+        {
+            printE ("Attribute %s differs in the two files\n", fp->attr_namelist[i]);
+            nerr++;
+        }
+        free (dp);
+        free (dt);
+    }
+
+    /* check the values themselves in the file with the table */
+    for (i = 0; !nerr && i < NFIELDS; i++)
+    {
+        char vname[64];
+        ADIOS_SELECTION *sel = adios_selection_boundingbox (1, &start, &count);
+        snprintf (vname, sizeof(vname), "%s/field%d", paths[i%2], i);
+        adios_schedule_read (ft, sel, vname, 0, NSTEPS, vt);
+        adios_perform_reads (ft, 1);
+        adios_selection_delete (sel);
+        for (s = 0; s < NSTEPS*NX; s++)
+        {
+            if (vt[s] != VALUE(s/NX, i, s%NX))
+            {
+                printE ("%s[%d] = %g instead of %g\n", vname, s, vt[s],
+                        VALUE(s/NX, i, s%NX));
+                nerr++;
+                break;
+            }
+        }
+    }
+
+    adios_read_close (fp);
+    adios_read_close (ft);
+    adios_read_finalize_method (ADIOS_READ_METHOD_BP);
+    return nerr;
+}
+
+int main (int argc, char ** argv)
+{
+    int64_t plain, table;
+    int64_t plain_size, table_size;
+    int err;
+
+    MPI_Init (&argc, &argv);
+    adios_init_noxml (comm);
+
+    define_group (&plain, "plain", "");
+    define_group (&table, "table", "index_string_table=1");
+
+    err = write_file ("plain", PLAINFILE);
+    if (!err)
+        err = write_file ("table", TABLEFILE);
+
+    if (!err)
+    {
+        plain_size = file_size (PLAINFILE);
+        table_size = file_size (TABLEFILE);
+        log ("File size without the string table: %" PRId64 ", with it: %" PRId64 "\n",
+             plain_size, table_size);
+        if (table_size >= plain_size)
+        {
+            printE ("The index with the string table is not smaller\n");
+            err = 1;
+        }
+    }
+
+    if (!err)
+        err = compare_files ();
+
+    adios_finalize (0);
+    MPI_Finalize ();
+    return err;
+}
@@ -0,0 +1,284 @@
+/*
+ * ADIOS is freely available under the terms of the BSD license described
+ * in the COPYING file in the top level directory of this source distribution.
+ *
+ * Copyright (c) 2008 - 2009.  UT-BATTELLE, LLC. All rights reserved.
+ */
+
+/* ADIOS C test:
+ *  Write a 2D array of 2D blocks, a float array 'data' and an integer array 'label'.
+ *  data[i,j] = 100*i+j (global coordinates), NaN in every 4th row, label[i,j] = i % 5
+ *
+ *  Then evaluate queries repeatedly with the scan, bitmap and minmax methods:
+ *  the same query again, the same conditions in the other order, cached queries
+ *  AND-ed and OR-ed with new conditions, with the cache disabled and after
+ *  reopening the file, and test that the results are always exactly the points
+ *  that satisfy the query, compared to a brute force check of the same condition.
+ *
+ * How to run: ./query_cache <N>
+ * It writes N*N 2D blocks organized into a NxN 2D array.
+ * Output: query_cache.bp
+ *
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <math.h>
+#include "public/adios.h"
+#include "public/adios_read.h"
+#include "public/adios_query.h"
+#include "query_test_common.h"
+
+#ifdef DMALLOC
+#include "dmalloc.h"
+#endif
+
+static const char FILENAME[] = "query_cache.bp";
+
+#define LDIM1 8
+#define LDIM2 7
+
+#define DATA(i,j)  (((i) % 4 == 3) ? NAN : (float)(100*(i)+(j)))
+#define LABEL(i,j) ((int)((i) % 5))
+
+/* The arrays to write */
+static double data_value (int step, int i, int j) { return DATA(i,j); }
+static double label_value (int step, int i, int j) { return LABEL(i,j); }
+
+static const QUERY_TEST_VAR vars[] = {
+    { "data",  adios_real,    data_value },
+    { "label", adios_integer, label_value },
+};
+
+static void define_indexes (int64_t group)
+{
+    adios_define_var_bitmap_index (group, "data", "100,200,300,400,500");
+}
+
+int query_as_file ();
+
+static const QUERY_TEST test = {
+    .name           = "query_cache",
+    .filename       = FILENAME,
+    .method_params  = "",
+    .stats          = adios_stat_default,
+    .ldim1          = LDIM1,
+    .ldim2          = LDIM2,
+    .N              = 3,
+    .nsteps         = 1,
+    .nvars          = sizeof(vars) / sizeof(vars[0]),
+    .vars           = vars,
+    .define_indexes = define_indexes,
+    .index_size     = 4096,
+    .queries        = query_as_file,
+};
+
+int main (int argc, char ** argv)
+{
+    return query_test_main (argc, argv, &test);
+}
+
+
+/* Expected result of the test queries at global point (i,j) */
+typedef int (*MATCH_FN) (int i, int j);
+
+// data > 150.0 && data <= 420.0
+static int match_range (int i, int j) { return DATA(i,j) > 150.0 && DATA(i,j) <= 420.0; }
+// data > 150.0 && data <= 420.0 && label == 2
+static int match_refined (int i, int j) { return match_range (i, j) && LABEL(i,j) == 2; }
+// (data > 150.0 && data <= 420.0) || label == 0
+static int match_or (int i, int j) { return match_range (i, j) || LABEL(i,j) == 0; }
+
+/*
+ * Evaluate query q in batches of batchSize with 'method' and check every
+ * returned point against the expected condition within box (start,count).
+ */
+static int check_query (ADIOS_QUERY *q, const char *name, enum ADIOS_QUERY_METHOD method,
+                        ADIOS_SELECTION *outsel, uint64_t *start, uint64_t *count, MATCH_FN match)
+{
+    int nerr = 0;
+    uint64_t i, j, n, nexpected = 0, nhits = 0, batchSize = 50;
+    char *seen = calloc (gdim1*gdim2, 1);
+
+    for (i = start[0]; i < start[0]+count[0]; i++)
+        for (j = start[1]; j < start[1]+count[1]; j++)
+            if (match (i, j))
+                nexpected++;
+
+    adios_query_set_method (q, method);
+    ADIOS_QUERY_RESULT *result;
+    do {
+        result = adios_query_evaluate (q, outsel, 0, batchSize);
+        if (result->status == ADIOS_QUERY_RESULT_ERROR) {
+            printE ("%s: query evaluation failed with error: %s\n", name, adios_errmsg());
+            nerr++;
+            free (result);
+            break;
+        }
+        if (result->nselections == 1) {
+            ADIOS_SELECTION_POINTS_STRUCT *pts = &result->selections[0].u.points;
+            for (n = 0; n < pts->npoints; n++) {
+                i = pts->points[2*n];
+                j = pts->points[2*n+1];
+                if (i < start[0] || i >= start[0]+count[0] ||
+                    j < start[1] || j >= start[1]+count[1] ||
+                    !match (i, j) || seen[i*gdim2+j])
+                {
+                    printE ("%s: wrong point (%" PRIu64 ",%" PRIu64 ") returned\n", name, i, j);
+                    nerr++;
+                }
+                else
+                {
+                    seen[i*gdim2+j] = 1;
+                }
+            }
+            nhits += pts->npoints;
+            free (pts->points);
+            free (result->selections);
+        }
+        n = result->status;
+        free (result);
+    } while (n == ADIOS_QUERY_HAS_MORE_RESULTS && nerr < 10);
+
+    if (nhits != nexpected) {
+        printE ("%s: query returned %" PRIu64 " points instead of %" PRIu64 "\n", name, nhits, nexpected);
+        nerr++;
+    } else {
+        log ("    %s: %" PRIu64 " points as expected\n", name, nhits);
+    }
+    free (seen);
+    return nerr;
+}
+
+/* The minmax method returns the same blocks every time */
+static int check_minmax (ADIOS_FILE *f, const char *value, int64_t nexpected)
+{
+    int nerr = 0, k;
+    for (k = 0; k < 2; k++) {
+        ADIOS_QUERY *q = adios_query_create (f, NULL, "data", ADIOS_GTEQ, value);
+        adios_query_set_method (q, ADIOS_QUERY_METHOD_MINMAX);
+        int64_t n = adios_query_estimate (q, 0);
+        if (n != nexpected) {
+            printE ("data >= %s: minmax estimated %" PRId64 " blocks instead of %" PRId64 " at try %d\n",
+                    value, n, nexpected, k);
+            nerr++;
+        }
+        adios_query_free(q);
+    }
+    return nerr;
+}
+
+/*
+ * A new query tree for data > 150.0 && data <= 420.0 every time:
+ * a query that was evaluated to the end cannot be evaluated again,
+ * while the cache is shared by all queries on the file.
+ * The leaves are returned in q1, q2 to be freed by the caller.
+ */
+static ADIOS_QUERY * range_query (ADIOS_FILE *f, ADIOS_SELECTION *boxsel, int swap,
+                                  ADIOS_QUERY **q1, ADIOS_QUERY **q2)
+{
+    *q1 = adios_query_create (f, boxsel, "data", ADIOS_GT, "150.0");
+    *q2 = adios_query_create (f, boxsel, "data", ADIOS_LTEQ, (swap ? " 420.0" : "420.0"));
+    if (swap)
+        return adios_query_combine (*q2, ADIOS_QUERY_OP_AND, *q1);
+    return adios_query_combine (*q1, ADIOS_QUERY_OP_AND, *q2);
+}
+
+int query_test (ADIOS_FILE *f, uint64_t *start, uint64_t *count, enum ADIOS_QUERY_METHOD method)
+{
+    int nerr = 0, k;
+    ADIOS_QUERY  *q1, *q2, *q, *q3, *qr;
+    ADIOS_SELECTION *boxsel = NULL;
+    uint64_t gstart[2] = {0,0};
+    uint64_t gcount[2] = {gdim1,gdim2};
+
+    if (start) {
+        boxsel = adios_selection_boundingbox (2, start, count);
+    } else {
+        start = gstart;
+        count = gcount;
+    }
+
+    // the same query twice, then with the conditions in the other order
+    for (k = 0; k < 3; k++) {
+        q = range_query (f, boxsel, (k == 2), &q1, &q2);
+        nerr += check_query (q, (k == 0 ? "range" : (k == 1 ? "range again" : "range swapped")),
+                             method, boxsel, start, count, match_range);
+        adios_query_free(q);
+        adios_query_free(q2);
+        adios_query_free(q1);
+    }
+
+    // AND-ed onto the cached query
+    q3 = adios_query_create (f, boxsel, "label", ADIOS_EQ, "2");
+    q  = range_query (f, boxsel, 0, &q1, &q2);
+    qr = adios_query_combine (q3, ADIOS_QUERY_OP_AND, q);
+    nerr += check_query (qr, "label == 2 AND range", method, boxsel, start, count, match_refined);
+    adios_query_free(qr);
+    adios_query_free(q);
+    adios_query_free(q2);
+    adios_query_free(q1);
+    adios_query_free(q3);
+
+    // OR-ed with the cached query
+    q3 = adios_query_create (f, boxsel, "label", ADIOS_EQ, "0");
+    q  = range_query (f, boxsel, 1, &q1, &q2);
+    qr = adios_query_combine (q, ADIOS_QUERY_OP_OR, q3);
+    nerr += check_query (qr, "range OR label == 0", method, boxsel, start, count, match_or);
+    adios_query_free(qr);
+    adios_query_free(q);
+    adios_query_free(q2);
+    adios_query_free(q1);
+    adios_query_free(q3);
+
+    if (boxsel)
+        adios_selection_delete (boxsel);
+    return nerr;
+}
+
+int query_as_file ()
+{
+    ADIOS_FILE * f;
+    int err=0, k;
+    enum ADIOS_QUERY_METHOD methods[2] = {ADIOS_QUERY_METHOD_SCAN, ADIOS_QUERY_METHOD_BITMAP};
+
+    log ("Query data in %s\n", FILENAME);
+    f = adios_read_open_file (FILENAME, ADIOS_READ_METHOD_BP, comm);
+    if (f == NULL) {
+        printE ("Error at opening file: %s\n", adios_errmsg());
+        return 1;
+    }
+
+    // a box that cuts through the blocks
+    uint64_t start[2] = {ldim1/2, ldim2+1};
+    uint64_t count[2] = {gdim1-ldim1, gdim2-ldim2-2};
+
+    for (k = 0; k < 2; k++) {
+        log ("  Query the whole array with method %d...\n", methods[k]);
+        err += query_test (f, NULL, NULL, methods[k]);
+        log ("  Query with a bounding box selection crossing blocks with method %d...\n", methods[k]);
+        err += query_test (f, start, count, methods[k]);
+    }
+
+    log ("  Query blocks with the minmax method...\n");
+    err += check_minmax (f, "1600", (N > 2 ? N*(N-2) : 0));
+
+    log ("  Query without the cache...\n");
+    adios_query_set_cache_size (0);
+    err += query_test (f, NULL, NULL, ADIOS_QUERY_METHOD_SCAN);
+    err += check_minmax (f, "1600", (N > 2 ? N*(N-2) : 0));
+    adios_query_set_cache_size (1024*1024);
+
+    adios_read_close(f);
+
+    log ("  Query again after reopening the file...\n");
+    f = adios_read_open_file (FILENAME, ADIOS_READ_METHOD_BP, comm);
+    if (f == NULL) {
+        printE ("Error at opening file: %s\n", adios_errmsg());
+        return err+1;
+    }
+    err += query_test (f, start, count, ADIOS_QUERY_METHOD_SCAN);
+    adios_read_close(f);
+    return err;
+}
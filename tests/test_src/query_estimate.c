@@ -0,0 +1,256 @@
+/*
+ * ADIOS is freely available under the terms of the BSD license described
+ * in the COPYING file in the top level directory of this source distribution.
+ *
+ * Copyright (c) 2008 - 2009.  UT-BATTELLE, LLC. All rights reserved.
+ */
+
+/* ADIOS C test:
+ *  Write a 2D array of 2D blocks with full statistics: a double array 'data'
+ *  and an integer array 'label' with histograms, and a double array 'plain'
+ *  without a histogram.
+ *  data[i,j] = gdim2*i+j (global coordinates), NaN at every 50th element,
+ *  label[i,j] = i % 5, plain[i,j] = data[i,j]
+ *
+ *  Then test if adios_query_estimate_bounds() returns an upper bound that is
+ *  not less than the exact number of hits, and an estimate that is exact for
+ *  conditions on the break points of the histograms.
+ *
+ * How to run: ./query_estimate <N>
+ * It writes N*N 2D blocks organized into a NxN 2D array.
+ * Output: query_estimate.bp
+ *
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <math.h>
+#include "public/adios.h"
+#include "public/adios_read.h"
+#include "public/adios_query.h"
+#include "query_test_common.h"
+
+#ifdef DMALLOC
+#include "dmalloc.h"
+#endif
+
+static const char FILENAME[] = "query_estimate.bp";
+
+#define LDIM1 8
+#define LDIM2 10
+
+#define DATA(i,j)  ((((i)*gdim2+(j)) % 50 == 49) ? NAN : (double)((i)*gdim2+(j)))
+#define LABEL(i,j) ((int)((i) % 5))
+
+/* The arrays to write */
+static double data_value (int step, int i, int j) { return DATA(i,j); }
+static double label_value (int step, int i, int j) { return LABEL(i,j); }
+static double plain_value (int step, int i, int j) { return DATA(i,j); }
+
+static const QUERY_TEST_VAR vars[] = {
+    { "data",  adios_double,  data_value },
+    { "label", adios_integer, label_value },
+    { "plain", adios_double,  plain_value },
+};
+
+static void define_indexes (int64_t group)
+{
+    adios_define_var_histogram (group, "data", "100,200,300,400,500,600");
+    adios_define_var_histogram (group, "label", "1,2,3,4");
+}
+
+int query_as_file ();
+
+static const QUERY_TEST test = {
+    .name           = "query_estimate",
+    .filename       = FILENAME,
+    .method_params  = "",
+    .stats          = adios_stat_full,
+    .ldim1          = LDIM1,
+    .ldim2          = LDIM2,
+    .N              = 3,
+    .nsteps         = 1,
+    .nvars          = sizeof(vars) / sizeof(vars[0]),
+    .vars           = vars,
+    .define_indexes = define_indexes,
+    .index_size     = 0,
+    .queries        = query_as_file,
+};
+
+int main (int argc, char ** argv)
+{
+    return query_test_main (argc, argv, &test);
+}
+
+
+/* Expected result of the test queries at global point (i,j) */
+typedef int (*MATCH_FN) (int i, int j);
+
+// data < 300
+static int match_lt (int i, int j) { return DATA(i,j) < 300.0; }
+// data >= 200 && data < 500
+static int match_and (int i, int j) { return DATA(i,j) >= 200.0 && DATA(i,j) < 500.0; }
+// data < 100 || label == 3
+static int match_or (int i, int j) { return DATA(i,j) < 100.0 || LABEL(i,j) == 3; }
+// label == 3
+static int match_eq (int i, int j) { return LABEL(i,j) == 3; }
+// label != 0
+static int match_ne (int i, int j) { return LABEL(i,j) != 0; }
+// data != 250.0, true for the NaNs
+static int match_data_ne (int i, int j) { return DATA(i,j) != 250.0; }
+// data > 150.5
+static int match_gt (int i, int j) { return DATA(i,j) > 150.5; }
+// plain < 300
+static int match_plain (int i, int j) { return DATA(i,j) < 300.0; }
+// data == 1.0e6
+static int match_none (int i, int j) { return DATA(i,j) == 1.0e6; }
+
+/*
+ * Check the estimate and upper bound of query q against the exact number
+ * of hits within box (start,count). If exact is set, the estimate has to
+ * be exact. Otherwise, it has to be within 'tolerance' of the exact number.
+ */
+static int check_estimate (ADIOS_QUERY *q, const char *name, uint64_t *start, uint64_t *count,
+                           MATCH_FN match, int exact, double tolerance)
+{
+    int nerr = 0;
+    uint64_t i, j, nexpected = 0, estimate = 0, upper = 0;
+
+    for (i = start[0]; i < start[0]+count[0]; i++)
+        for (j = start[1]; j < start[1]+count[1]; j++)
+            if (match (i, j))
+                nexpected++;
+
+    if (adios_query_estimate_bounds (q, 0, &estimate, &upper)) {
+        printE ("%s: estimate failed with error: %s\n", name, adios_errmsg());
+        return 1;
+    }
+    if (upper < nexpected || upper > count[0]*count[1]) {
+        printE ("%s: upper bound %" PRIu64 " with %" PRIu64 " hits in %" PRIu64 " elements\n",
+                name, upper, nexpected, count[0]*count[1]);
+        nerr++;
+    }
+    if (estimate > upper) {
+        printE ("%s: estimate %" PRIu64 " is above the upper bound %" PRIu64 "\n",
+                name, estimate, upper);
+        nerr++;
+    }
+    if (exact && estimate != nexpected) {
+        printE ("%s: estimated %" PRIu64 " hits instead of %" PRIu64 "\n", name, estimate, nexpected);
+        nerr++;
+    }
+    if (!exact && fabs ((double) estimate - (double) nexpected) > tolerance * count[0]*count[1]) {
+        printE ("%s: estimated %" PRIu64 " hits, too far from %" PRIu64 "\n", name, estimate, nexpected);
+        nerr++;
+    }
+    if (!nerr) {
+        log ("    %s: estimate %" PRIu64 ", upper bound %" PRIu64 ", %" PRIu64 " hits\n",
+             name, estimate, upper, nexpected);
+    }
+    return nerr;
+}
+
+int query_test (ADIOS_FILE *f, uint64_t *start, uint64_t *count)
+{
+    int nerr = 0;
+    ADIOS_QUERY  *q1, *q2, *q;
+    ADIOS_SELECTION *boxsel = NULL;
+    uint64_t gstart[2] = {0,0};
+    uint64_t gcount[2] = {gdim1,gdim2};
+
+    // partially selected blocks are estimated less accurately
+    double tol = 0.1;
+
+    if (start) {
+        boxsel = adios_selection_boundingbox (2, start, count);
+        tol = 0.2;
+    } else {
+        start = gstart;
+        count = gcount;
+    }
+
+    // the histogram is only exact for whole blocks
+    q = adios_query_create (f, boxsel, "data", ADIOS_LT, "300");
+    nerr += check_estimate (q, "data < 300", start, count, match_lt, !boxsel, tol);
+    adios_query_free(q);
+
+    q1 = adios_query_create (f, boxsel, "data", ADIOS_GTEQ, "200");
+    q2 = adios_query_create (f, boxsel, "data", ADIOS_LT, "500");
+    q  = adios_query_combine (q1, ADIOS_QUERY_OP_AND, q2);
+    nerr += check_estimate (q, "data >= 200 AND data < 500", start, count, match_and, 0, 2*tol);
+    adios_query_free(q);
+    adios_query_free(q2);
+    adios_query_free(q1);
+
+    q1 = adios_query_create (f, boxsel, "data", ADIOS_LT, "100");
+    q2 = adios_query_create (f, boxsel, "label", ADIOS_EQ, "3");
+    q  = adios_query_combine (q1, ADIOS_QUERY_OP_OR, q2);
+    nerr += check_estimate (q, "data < 100 OR label == 3", start, count, match_or, 0, tol);
+    adios_query_free(q);
+    adios_query_free(q2);
+    adios_query_free(q1);
+
+    q = adios_query_create (f, boxsel, "label", ADIOS_EQ, "3");
+    nerr += check_estimate (q, "label == 3", start, count, match_eq, !boxsel, tol);
+    adios_query_free(q);
+
+    q = adios_query_create (f, boxsel, "label", ADIOS_NE, "0");
+    nerr += check_estimate (q, "label != 0", start, count, match_ne, !boxsel, tol);
+    adios_query_free(q);
+
+    q = adios_query_create (f, boxsel, "data", ADIOS_NE, "250");
+    nerr += check_estimate (q, "data != 250", start, count, match_data_ne, 0, tol/10);
+    adios_query_free(q);
+
+    q = adios_query_create (f, boxsel, "data", ADIOS_GT, "150.5");
+    nerr += check_estimate (q, "data > 150.5", start, count, match_gt, 0, tol);
+    adios_query_free(q);
+
+    q = adios_query_create (f, boxsel, "plain", ADIOS_LT, "300");
+    nerr += check_estimate (q, "plain < 300 (no histogram)", start, count, match_plain, 0, 2*tol);
+    adios_query_free(q);
+
+    q = adios_query_create (f, boxsel, "data", ADIOS_EQ, "1e6");
+    nerr += check_estimate (q, "data == 1e6", start, count, match_none, 1, 0);
+    adios_query_free(q);
+
+    if (boxsel)
+        adios_selection_delete (boxsel);
+    return nerr;
+}
+
+int query_as_file ()
+{
+    ADIOS_FILE * f;
+    int err=0;
+
+    log ("Query data in %s\n", FILENAME);
+    f = adios_read_open_file (FILENAME, ADIOS_READ_METHOD_BP, comm);
+    if (f == NULL) {
+        printE ("Error at opening file: %s\n", adios_errmsg());
+        return 1;
+    }
+
+    log ("  Estimate the whole array with NULL as bounding box selection...\n");
+    err += query_test (f, NULL, NULL);
+
+    // a box that cuts through the blocks
+    uint64_t start[2] = {ldim1/2, ldim2+1};
+    uint64_t count[2] = {gdim1-ldim1, gdim2-ldim2-2};
+    log ("  Estimate with a bounding box selection crossing blocks...\n");
+    err += query_test (f, start, count);
+
+    // a writeblock selection
+    uint64_t wbstart[2] = {ldim1*(N-1), ldim2*(N-1)};
+    uint64_t wbcount[2] = {ldim1, ldim2};
+    ADIOS_SELECTION *wb = adios_selection_writeblock (N*N-1);
+    ADIOS_QUERY *q = adios_query_create (f, wb, "label", ADIOS_NE, "0");
+    log ("  Estimate with a writeblock selection...\n");
+    err += check_estimate (q, "label != 0 in last block", wbstart, wbcount, match_ne, 1, 0);
+    adios_query_free(q);
+    adios_selection_delete (wb);
+
+    adios_read_close(f);
+    return err;
+}
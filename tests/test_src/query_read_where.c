@@ -0,0 +1,246 @@
+/*
+ * ADIOS is freely available under the terms of the BSD license described
+ * in the COPYING file in the top level directory of this source distribution.
+ *
+ * Copyright (c) 2008 - 2009.  UT-BATTELLE, LLC. All rights reserved.
+ */
+
+/* ADIOS C test:
+ *  Write a 2D array of 2D blocks, a float array 'data', an integer array 'label'
+ *  and a double array 'extra' that is not used in the queries.
+ *  data[i,j] = 100*i+j (global coordinates), NaN in every 4th row, label[i,j] = i % 5,
+ *  extra[i,j] = 1000*i+j+0.5
+ *
+ *  Then read the values of all three arrays at the hits of queries with
+ *  adios_query_read_where() using the scan and bitmap methods, and test that
+ *  exactly the points satisfying the query are returned, with the right values.
+ *
+ * How to run: ./query_read_where <N>
+ * It writes N*N 2D blocks organized into a NxN 2D array.
+ * Output: query_read_where.bp
+ *
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <math.h>
+#include "public/adios.h"
+#include "public/adios_read.h"
+#include "public/adios_query.h"
+#include "query_test_common.h"
+
+#ifdef DMALLOC
+#include "dmalloc.h"
+#endif
+
+static const char FILENAME[] = "query_read_where.bp";
+
+#define LDIM1 8
+#define LDIM2 7
+
+#define DATA(i,j)  (((i) % 4 == 3) ? NAN : (float)(100*(i)+(j)))
+#define LABEL(i,j) ((int)((i) % 5))
+#define EXTRA(i,j) (1000.0*(i)+(j)+0.5)
+
+/* The arrays to write */
+static double data_value (int step, int i, int j) { return DATA(i,j); }
+static double label_value (int step, int i, int j) { return LABEL(i,j); }
+static double extra_value (int step, int i, int j) { return EXTRA(i,j); }
+
+static const QUERY_TEST_VAR vars[] = {
+    { "data",  adios_real,    data_value },
+    { "label", adios_integer, label_value },
+    { "extra", adios_double,  extra_value },
+};
+
+static void define_indexes (int64_t group)
+{
+    adios_define_var_bitmap_index (group, "data", "100,200,300,400,500");
+    adios_define_var_bitmap_index (group, "label", "1,2,3");
+}
+
+int query_as_file ();
+
+static const QUERY_TEST test = {
+    .name           = "query_read_where",
+    .filename       = FILENAME,
+    .method_params  = "",
+    .stats          = adios_stat_default,
+    .ldim1          = LDIM1,
+    .ldim2          = LDIM2,
+    .N              = 3,
+    .nsteps         = 1,
+    .nvars          = sizeof(vars) / sizeof(vars[0]),
+    .vars           = vars,
+    .define_indexes = define_indexes,
+    .index_size     = 2 * 4096,
+    .queries        = query_as_file,
+};
+
+int main (int argc, char ** argv)
+{
+    return query_test_main (argc, argv, &test);
+}
+
+
+/* Expected result of the test queries at global point (i,j) */
+typedef int (*MATCH_FN) (int i, int j);
+
+// data > 150.0 && data <= 1420.0
+static int match_range (int i, int j) { return DATA(i,j) > 150.0 && DATA(i,j) <= 1420.0; }
+// label >= 0 && data < 900.0
+static int match_label (int i, int j) { return LABEL(i,j) >= 0 && DATA(i,j) < 900.0; }
+
+static const char *varnames[3] = {"data", "extra", "label"};
+
+/*
+ * Read the values at the hits of query q in batches of batchSize with 'method'
+ * and check every returned point and its values against the expected ones
+ * within box (start,count).
+ */
+static int check_read_where (ADIOS_QUERY *q, const char *name, enum ADIOS_QUERY_METHOD method,
+                             ADIOS_SELECTION *outsel, uint64_t *start, uint64_t *count, MATCH_FN match)
+{
+    int nerr = 0, status;
+    uint64_t i, j, n, nexpected = 0, nhits = 0, batchSize = 10;
+    char *seen = calloc (gdim1*gdim2, 1);
+
+    for (i = start[0]; i < start[0]+count[0]; i++)
+        for (j = start[1]; j < start[1]+count[1]; j++)
+            if (match (i, j))
+                nexpected++;
+
+    adios_query_set_method (q, method);
+    do {
+        ADIOS_QUERY_VALUES *v = adios_query_read_where (q, outsel, 0, batchSize, 3, varnames);
+        status = v->status;
+        if (status == ADIOS_QUERY_RESULT_ERROR) {
+            printE ("%s: reading the values of the hits failed with error: %s\n", name, adios_errmsg());
+            nerr++;
+            adios_query_free_values (v);
+            break;
+        }
+        if (v->ndim != 2 || v->nvars != 3 || v->types[0] != adios_real ||
+            v->types[1] != adios_double || v->types[2] != adios_integer)
+        {
+            printE ("%s: unexpected result layout\n", name);
+            nerr++;
+            adios_query_free_values (v);
+            break;
+        }
+        const float  *dv = (const float *) v->values[0];
+        const double *ev = (const double *) v->values[1];
+        const int    *lv = (const int *) v->values[2];
+        for (n = 0; n < v->npoints; n++) {
+            i = v->points[2*n];
+            j = v->points[2*n+1];
+            if (i < start[0] || i >= start[0]+count[0] ||
+                j < start[1] || j >= start[1]+count[1] ||
+                !match (i, j) || seen[i*gdim2+j])
+            {
+                printE ("%s: wrong point (%" PRIu64 ",%" PRIu64 ") returned\n", name, i, j);
+                nerr++;
+                continue;
+            }
+            seen[i*gdim2+j] = 1;
+            if (dv[n] != DATA(i,j) || ev[n] != EXTRA(i,j) || lv[n] != LABEL(i,j)) {
+                printE ("%s: wrong values at (%" PRIu64 ",%" PRIu64 "): data=%g extra=%g label=%d, "
+                        "expected %g %g %d\n", name, i, j, dv[n], ev[n], lv[n],
+                        DATA(i,j), EXTRA(i,j), LABEL(i,j));
+                nerr++;
+            }
+        }
+        nhits += v->npoints;
+        adios_query_free_values (v);
+    } while (status == ADIOS_QUERY_HAS_MORE_RESULTS && nerr < 10);
+
+    if (nhits != nexpected) {
+        printE ("%s: query returned %" PRIu64 " points instead of %" PRIu64 "\n", name, nhits, nexpected);
+        nerr++;
+    } else {
+        log ("    %s: %" PRIu64 " points with the expected values\n", name, nhits);
+    }
+    free (seen);
+    return nerr;
+}
+
+int query_test (ADIOS_FILE *f, uint64_t *start, uint64_t *count, enum ADIOS_QUERY_METHOD method)
+{
+    int nerr = 0;
+    ADIOS_QUERY  *q1, *q2, *q;
+    ADIOS_SELECTION *boxsel = NULL;
+    uint64_t gstart[2] = {0,0};
+    uint64_t gcount[2] = {gdim1,gdim2};
+
+    if (start) {
+        boxsel = adios_selection_boundingbox (2, start, count);
+    } else {
+        start = gstart;
+        count = gcount;
+    }
+
+    q1 = adios_query_create (f, boxsel, "data", ADIOS_GT, "150.0");
+    q2 = adios_query_create (f, boxsel, "data", ADIOS_LTEQ, "1420.0");
+    q  = adios_query_combine (q1, ADIOS_QUERY_OP_AND, q2);
+    nerr += check_read_where (q, "data > 150 AND data <= 1420", method, boxsel, start, count, match_range);
+    adios_query_free(q);
+    adios_query_free(q2);
+    adios_query_free(q1);
+
+    // every block matches the first condition by its statistics, nothing is read for it
+    q1 = adios_query_create (f, boxsel, "label", ADIOS_GTEQ, "0");
+    q2 = adios_query_create (f, boxsel, "data", ADIOS_LT, "900.0");
+    q  = adios_query_combine (q1, ADIOS_QUERY_OP_AND, q2);
+    nerr += check_read_where (q, "label >= 0 AND data < 900", method, boxsel, start, count, match_label);
+    adios_query_free(q);
+    adios_query_free(q2);
+    adios_query_free(q1);
+
+    if (boxsel)
+        adios_selection_delete (boxsel);
+    return nerr;
+}
+
+int query_as_file ()
+{
+    ADIOS_FILE * f;
+    int err=0, k;
+    enum ADIOS_QUERY_METHOD methods[2] = {ADIOS_QUERY_METHOD_SCAN, ADIOS_QUERY_METHOD_BITMAP};
+
+    log ("Query data in %s\n", FILENAME);
+    f = adios_read_open_file (FILENAME, ADIOS_READ_METHOD_BP, comm);
+    if (f == NULL) {
+        printE ("Error at opening file: %s\n", adios_errmsg());
+        return 1;
+    }
+
+    // a box that cuts through the blocks
+    uint64_t start[2] = {ldim1/2, ldim2+1};
+    uint64_t count[2] = {gdim1-ldim1, gdim2-ldim2-2};
+
+    for (k = 0; k < 2; k++) {
+        log ("  Read where, whole array with method %d...\n", methods[k]);
+        err += query_test (f, NULL, NULL, methods[k]);
+        log ("  Read where, bounding box selection crossing blocks with method %d...\n", methods[k]);
+        err += query_test (f, start, count, methods[k]);
+    }
+
+    // results cached by the runs above, all values have to be read
+    log ("  Read where, results from the cache...\n");
+    err += query_test (f, NULL, NULL, ADIOS_QUERY_METHOD_SCAN);
+
+    log ("  Read where with the minmax method is not supported...\n");
+    ADIOS_QUERY *q = adios_query_create (f, NULL, "data", ADIOS_GT, "150.0");
+    adios_query_set_method (q, ADIOS_QUERY_METHOD_MINMAX);
+    ADIOS_QUERY_VALUES *v = adios_query_read_where (q, NULL, 0, 10, 3, varnames);
+    if (v->status != ADIOS_QUERY_RESULT_ERROR) {
+        printE ("read where with the minmax method did not fail\n");
+        err++;
+    }
+    adios_query_free_values (v);
+    adios_query_free (q);
+
+    adios_read_close(f);
+    return err;
+}
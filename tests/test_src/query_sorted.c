@@ -0,0 +1,493 @@
+/*
+ * ADIOS is freely available under the terms of the BSD license described
+ * in the COPYING file in the top level directory of this source distribution.
+ *
+ * Copyright (c) 2008 - 2009.  UT-BATTELLE, LLC. All rights reserved.
+ */
+
+/* ADIOS C test:
+ *  Write a 2D array of 2D blocks, a double array 'data' with many equal values
+ *  and some NaNs, an integer array 'label' and a double array 'extra',
+ *  then build the sorted index of 'data' and 'label' the way the
+ *  adios_index_sorted utility does (into query_sorted.sidx).
+ *
+ *  Test that queries evaluated with the SORTED method return exactly the
+ *  points satisfying them, that 'extra' without index is evaluated by scanning,
+ *  and that adios_query_topk() and adios_query_quantile() return the same
+ *  values as sorting all values.
+ *
+ * How to run: ./query_sorted <N>
+ * It writes N*N 2D blocks organized into a NxN 2D array.
+ * Output: query_sorted.bp, query_sorted.sidx
+ *
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <math.h>
+#include "public/adios.h"
+#include "public/adios_read.h"
+#include "public/adios_query.h"
+#include "query/query_sorted.h"
+#include "query_test_common.h"
+
+#ifdef DMALLOC
+#include "dmalloc.h"
+#endif
+
+static const char FILENAME[] = "query_sorted.bp";
+
+// blocks have more than QUERY_SORTED_FENCE elements, so that runs have inner fences
+#define LDIM1 40
+#define LDIM2 70
+
+int64_t       m_index_group;
+
+#define DATA(i,j)  ((((i)*gdim2+(j)) % 17 == 5) ? NAN : (double)(((i)*31+(j)*7) % 101) - 50.0)
+#define LABEL(i,j) ((int)(((i)+3*(j)) % 40) - 10)
+#define EXTRA(i,j) ((double)(i)-(double)(j))
+
+/* The arrays to write */
+static double data_value (int step, int i, int j) { return DATA(i,j); }
+static double label_value (int step, int i, int j) { return LABEL(i,j); }
+static double extra_value (int step, int i, int j) { return EXTRA(i,j); }
+
+static const QUERY_TEST_VAR vars[] = {
+    { "data",  adios_double,  data_value },
+    { "label", adios_integer, label_value },
+    { "extra", adios_double,  extra_value },
+};
+
+int build_index ();
+int query_as_file ();
+int index_and_query ();
+
+static const QUERY_TEST test = {
+    .name           = "query_sorted",
+    .filename       = FILENAME,
+    .method_params  = "",
+    .stats          = adios_stat_default,
+    .ldim1          = LDIM1,
+    .ldim2          = LDIM2,
+    .N              = 2,
+    .nsteps         = 1,
+    .nvars          = sizeof(vars) / sizeof(vars[0]),
+    .vars           = vars,
+    .define_indexes = NULL,
+    .index_size     = 0,
+    .queries        = index_and_query,
+};
+
+int main (int argc, char ** argv)
+{
+    return query_test_main (argc, argv, &test);
+}
+
+/* Build the sorted index, then run the queries with it */
+int index_and_query ()
+{
+    int err;
+
+    adios_declare_group (&m_index_group, "sorted_index", "", adios_stat_no);
+    adios_select_method (m_index_group, "POSIX", "", "");
+
+    // evaluate every query, the SORTED and SCAN results must not come from the cache
+    adios_query_set_cache_size (0);
+
+    err = build_index ();
+    if (!err)
+        err = query_as_file ();
+    return err;
+}
+
+static void write_index_array (int64_t fh, const char *name, enum ADIOS_DATATYPES type,
+                               uint64_t n, uint64_t total, uint64_t offset, void *data)
+{
+    char l[32], g[32], o[32];
+    snprintf (l, sizeof(l), "%" PRIu64, n);
+    snprintf (g, sizeof(g), "%" PRIu64, total);
+    snprintf (o, sizeof(o), "%" PRIu64, offset);
+    int64_t id = adios_define_var (m_index_group, name, "", type, l, g, o);
+    adios_write_byid (fh, id, data);
+}
+
+/* Sort every block of the variable into a run and write the runs */
+static int index_variable (ADIOS_FILE *f, int64_t fh, const char *varname)
+{
+    ADIOS_VARINFO *v = adios_inq_var (f, varname);
+    char vname[256], pname[256], fname[256];
+    uint64_t total = (uint64_t) gdim1 * gdim2, voffset = 0, foffset = 0, nfences = 0;
+    uint64_t n = (uint64_t) ldim1 * ldim2, nf = query_sorted_nfences (n);
+    int b, err = 0;
+
+    if (!v) {
+        printE ("Cannot inquire variable %s: %s\n", varname, adios_errmsg());
+        return 1;
+    }
+    adios_inq_var_blockinfo (f, v);
+    int elemsize = adios_type_size (v->type, NULL);
+    char *data = malloc (n * elemsize);
+    uint64_t *positions = malloc (n * sizeof(uint64_t));
+    char *fences = malloc (nf * elemsize);
+
+    query_sorted_var_name (vname, sizeof(vname), varname, 0, "values");
+    query_sorted_var_name (pname, sizeof(pname), varname, 0, "positions");
+    query_sorted_var_name (fname, sizeof(fname), varname, 0, "fences");
+    nfences = v->nblocks[0] * nf;
+
+    for (b = 0; b < v->nblocks[0] && !err; b++) {
+        ADIOS_SELECTION *sel = adios_selection_writeblock (b);
+        adios_schedule_read_byid (f, sel, v->varid, 0, 1, data);
+        err = adios_perform_reads (f, 1);
+        adios_selection_delete (sel);
+        if (err) {
+            printE ("Cannot read block %d of %s: %s\n", b, varname, adios_errmsg());
+            break;
+        }
+        err = query_sorted_build_run (v->type, v->ndim, v->dims, v->blockinfo[b].start,
+                                      v->blockinfo[b].count, data, positions, fences);
+        if (err) {
+            printE ("Cannot sort block %d of %s\n", b, varname);
+            break;
+        }
+        write_index_array (fh, vname, v->type, n, total, voffset, data);
+        write_index_array (fh, pname, adios_unsigned_long, n, total, voffset, positions);
+        write_index_array (fh, fname, v->type, nf, nfences, foffset, fences);
+        voffset += n;
+        foffset += nf;
+    }
+    free (data);
+    free (positions);
+    free (fences);
+    adios_free_varinfo (v);
+    return (err != 0);
+}
+
+int build_index ()
+{
+    ADIOS_FILE *f;
+    int64_t fh;
+    uint64_t groupsize, totalsize, n = (uint64_t) N*N*ldim1*ldim2;
+    char *idxname = query_sorted_index_file_name (FILENAME);
+    int err = 0;
+
+    log ("Build the sorted index of %s into %s\n", FILENAME, idxname);
+    f = adios_read_open_file (FILENAME, ADIOS_READ_METHOD_BP, comm);
+    if (f == NULL) {
+        printE ("Error at opening file: %s\n", adios_errmsg());
+        free (idxname);
+        return 1;
+    }
+
+    groupsize  = n * (sizeof(double) + sizeof(int) + 2*sizeof(uint64_t)); // values and positions
+    groupsize += N*N * query_sorted_nfences (ldim1*ldim2) * (sizeof(double) + sizeof(int)); // fences
+    adios_open (&fh, "sorted_index", idxname, "w", comm);
+    adios_group_size (fh, groupsize, &totalsize);
+    err = index_variable (f, fh, "data");
+    if (!err)
+        err = index_variable (f, fh, "label");
+    adios_close (fh);
+
+    adios_read_close (f);
+    free (idxname);
+    return err;
+}
+
+
+/* Expected result of the test queries at global point (i,j) */
+typedef int (*MATCH_FN) (int i, int j);
+
+static int match_lt   (int i, int j) { return DATA(i,j) < -10.0; }
+static int match_lteq (int i, int j) { return DATA(i,j) <= -10.0; }
+static int match_gt   (int i, int j) { return DATA(i,j) > 20.0; }
+static int match_gteq (int i, int j) { return DATA(i,j) >= 20.0; }
+static int match_eq   (int i, int j) { return DATA(i,j) == 0.0; }
+static int match_ne   (int i, int j) { return DATA(i,j) != 0.0; }
+static int match_none (int i, int j) { return 0; }
+static int match_and  (int i, int j) { return LABEL(i,j) == 5 && DATA(i,j) < 0.0; }
+static int match_or   (int i, int j) { return LABEL(i,j) > 25 || DATA(i,j) >= 45.0; }
+static int match_extra (int i, int j) { return EXTRA(i,j) <= -30.0; }
+
+/*
+ * Evaluate query q with the SORTED method in batches of batchSize
+ * and check every returned point against the expected ones within box (start,count).
+ */
+static int check_query (ADIOS_QUERY *q, const char *name, ADIOS_SELECTION *outsel,
+                        uint64_t *start, uint64_t *count, MATCH_FN match)
+{
+    int nerr = 0;
+    uint64_t i, j, n, nexpected = 0, nhits = 0, batchSize = 1000;
+    char *seen = calloc (gdim1*gdim2, 1);
+
+    for (i = start[0]; i < start[0]+count[0]; i++)
+        for (j = start[1]; j < start[1]+count[1]; j++)
+            if (match (i, j))
+                nexpected++;
+
+    adios_query_set_method (q, ADIOS_QUERY_METHOD_SORTED);
+    ADIOS_QUERY_RESULT *result;
+    do {
+        result = adios_query_evaluate (q, outsel, 0, batchSize);
+        if (result->status == ADIOS_QUERY_RESULT_ERROR) {
+            printE ("%s: query evaluation failed with error: %s\n", name, adios_errmsg());
+            nerr++;
+            free (result);
+            break;
+        }
+        if (result->method_used != ADIOS_QUERY_METHOD_SORTED) {
+            printE ("%s: query evaluated with method %d instead of SORTED\n", name, result->method_used);
+            nerr++;
+        }
+        if (result->nselections == 1) {
+            ADIOS_SELECTION_POINTS_STRUCT *pts = &result->selections[0].u.points;
+            for (n = 0; n < pts->npoints; n++) {
+                i = pts->points[2*n];
+                j = pts->points[2*n+1];
+                if (i < start[0] || i >= start[0]+count[0] ||
+                    j < start[1] || j >= start[1]+count[1] ||
+                    !match (i, j) || seen[i*gdim2+j])
+                {
+                    printE ("%s: wrong point (%" PRIu64 ",%" PRIu64 ") returned\n", name, i, j);
+                    nerr++;
+                }
+                else
+                {
+                    seen[i*gdim2+j] = 1;
+                }
+            }
+            nhits += pts->npoints;
+            free (pts->points);
+            free (result->selections);
+        }
+        n = result->status;
+        free (result);
+    } while (n == ADIOS_QUERY_HAS_MORE_RESULTS && nerr < 10);
+
+    if (nhits != nexpected) {
+        printE ("%s: query returned %" PRIu64 " points instead of %" PRIu64 "\n", name, nhits, nexpected);
+        nerr++;
+    } else {
+        log ("    %s: %" PRIu64 " points\n", name, nhits);
+    }
+    free (seen);
+    return nerr;
+}
+
+static int check_single (ADIOS_FILE *f, ADIOS_SELECTION *boxsel, uint64_t *start, uint64_t *count,
+                         const char *varname, enum ADIOS_PREDICATE_MODE op, const char *value,
+                         const char *name, MATCH_FN match)
+{
+    ADIOS_QUERY *q = adios_query_create (f, boxsel, varname, op, value);
+    int nerr = check_query (q, name, boxsel, start, count, match);
+    adios_query_free (q);
+    return nerr;
+}
+
+int query_test (ADIOS_FILE *f, uint64_t *start, uint64_t *count)
+{
+    int nerr = 0;
+    ADIOS_QUERY  *q1, *q2, *q;
+    ADIOS_SELECTION *boxsel = NULL;
+    uint64_t gstart[2] = {0,0};
+    uint64_t gcount[2] = {gdim1,gdim2};
+
+    if (start) {
+        boxsel = adios_selection_boundingbox (2, start, count);
+    } else {
+        start = gstart;
+        count = gcount;
+    }
+
+    nerr += check_single (f, boxsel, start, count, "data", ADIOS_LT,   "-10", "data < -10",  match_lt);
+    nerr += check_single (f, boxsel, start, count, "data", ADIOS_LTEQ, "-10", "data <= -10", match_lteq);
+    nerr += check_single (f, boxsel, start, count, "data", ADIOS_GT,   "20",  "data > 20",   match_gt);
+    nerr += check_single (f, boxsel, start, count, "data", ADIOS_GTEQ, "20",  "data >= 20",  match_gteq);
+    nerr += check_single (f, boxsel, start, count, "data", ADIOS_EQ,   "0",   "data == 0",   match_eq);
+    nerr += check_single (f, boxsel, start, count, "data", ADIOS_NE,   "0",   "data != 0",   match_ne);
+    nerr += check_single (f, boxsel, start, count, "data", ADIOS_EQ,   "0.5", "data == 0.5", match_none);
+    nerr += check_single (f, boxsel, start, count, "data", ADIOS_GT,   "1e9", "data > 1e9",  match_none);
+    nerr += check_single (f, boxsel, start, count, "extra", ADIOS_LTEQ, "-30",
+                          "extra <= -30 (no index)", match_extra);
+
+    q1 = adios_query_create (f, boxsel, "label", ADIOS_EQ, "5");
+    q2 = adios_query_create (f, boxsel, "data", ADIOS_LT, "0");
+    q  = adios_query_combine (q1, ADIOS_QUERY_OP_AND, q2);
+    nerr += check_query (q, "label == 5 AND data < 0", boxsel, start, count, match_and);
+    adios_query_free(q);
+    adios_query_free(q2);
+    adios_query_free(q1);
+
+    q1 = adios_query_create (f, boxsel, "label", ADIOS_GT, "25");
+    q2 = adios_query_create (f, boxsel, "data", ADIOS_GTEQ, "45");
+    q  = adios_query_combine (q1, ADIOS_QUERY_OP_OR, q2);
+    nerr += check_query (q, "label > 25 OR data >= 45", boxsel, start, count, match_or);
+    adios_query_free(q);
+    adios_query_free(q2);
+    adios_query_free(q1);
+
+    if (boxsel)
+        adios_selection_delete (boxsel);
+    return nerr;
+}
+
+
+static int cmp_double (const void *a, const void *b)
+{
+    double x = *(const double *) a, y = *(const double *) b;
+    return (x < y ? -1 : (x > y ? 1 : 0));
+}
+
+/* All values of 'data' (is_label = 0) or 'label' that are not NaN, sorted */
+static double * sorted_values (int is_label, uint64_t *n)
+{
+    double *all = malloc ((size_t) gdim1 * gdim2 * sizeof(double));
+    int i, j;
+    *n = 0;
+    for (i = 0; i < gdim1; i++)
+        for (j = 0; j < gdim2; j++) {
+            double x = (is_label ? (double) LABEL(i,j) : DATA(i,j));
+            if (!isnan (x))
+                all[(*n)++] = x;
+        }
+    qsort (all, *n, sizeof(double), cmp_double);
+    return all;
+}
+
+/* Check the returned values against 'expected' (npoints of them) and that
+   each returned point has its value */
+static int check_values (ADIOS_QUERY_VALUES *v, const char *name, int is_label,
+                         const double *expected, uint64_t npoints)
+{
+    int nerr = 0;
+    uint64_t n;
+    char *seen;
+
+    if (v->status == ADIOS_QUERY_RESULT_ERROR) {
+        printE ("%s failed with error: %s\n", name, adios_errmsg());
+        return 1;
+    }
+    if (v->method_used != ADIOS_QUERY_METHOD_SORTED || v->ndim != 2 || v->nvars != 1 ||
+        v->types[0] != (is_label ? adios_integer : adios_double))
+    {
+        printE ("%s: unexpected result layout\n", name);
+        return 1;
+    }
+    if (v->npoints != npoints) {
+        printE ("%s: %" PRIu64 " points returned instead of %" PRIu64 "\n", name, v->npoints, npoints);
+        return 1;
+    }
+    seen = calloc (gdim1*gdim2, 1);
+    for (n = 0; n < npoints && nerr < 10; n++) {
+        uint64_t i = v->points[2*n], j = v->points[2*n+1];
+        double x = (is_label ? (double) ((int *) v->values[0])[n] : ((double *) v->values[0])[n]);
+        if (i >= gdim1 || j >= gdim2 || seen[i*gdim2+j]) {
+            printE ("%s: wrong point (%" PRIu64 ",%" PRIu64 ") returned\n", name, i, j);
+            nerr++;
+            continue;
+        }
+        seen[i*gdim2+j] = 1;
+        if (x != expected[n] || x != (is_label ? (double) LABEL(i,j) : DATA(i,j))) {
+            printE ("%s: value %g at (%" PRIu64 ",%" PRIu64 ") returned as #%" PRIu64
+                    ", expected %g\n", name, x, i, j, n, expected[n]);
+            nerr++;
+        }
+    }
+    if (!nerr) {
+        log ("    %s: %" PRIu64 " values\n", name, npoints);
+    }
+    free (seen);
+    return nerr;
+}
+
+static int topk_test (ADIOS_FILE *f, int is_label, uint64_t k, int largest)
+{
+    const char *varname = (is_label ? "label" : "data");
+    char name[64];
+    uint64_t i, n;
+    double *all = sorted_values (is_label, &n);
+    uint64_t m = (k < n ? k : n);
+    double *expected = malloc ((m ? m : 1) * sizeof(double));
+    int nerr;
+
+    for (i = 0; i < m; i++)
+        expected[i] = (largest ? all[n-1-i] : all[i]);
+    snprintf (name, sizeof(name), "%s top-%" PRIu64 " %s", varname, k, (largest ? "largest" : "smallest"));
+
+    ADIOS_QUERY_VALUES *v = adios_query_topk (f, varname, 0, k, largest);
+    nerr = check_values (v, name, is_label, expected, m);
+    adios_query_free_values (v);
+    free (expected);
+    free (all);
+    return nerr;
+}
+
+static int quantile_test (ADIOS_FILE *f, int is_label, double fraction)
+{
+    const char *varname = (is_label ? "label" : "data");
+    char name[64];
+    uint64_t n;
+    double *all = sorted_values (is_label, &n);
+    int nerr;
+
+    snprintf (name, sizeof(name), "%s quantile %g", varname, fraction);
+    ADIOS_QUERY_VALUES *v = adios_query_quantile (f, varname, 0, fraction);
+    nerr = check_values (v, name, is_label, &all[(uint64_t) (fraction * (n-1))], 1);
+    adios_query_free_values (v);
+    free (all);
+    return nerr;
+}
+
+int query_as_file ()
+{
+    ADIOS_FILE * f;
+    int err=0, is_label;
+    ADIOS_QUERY_VALUES *v;
+
+    log ("Query data in %s\n", FILENAME);
+    f = adios_read_open_file (FILENAME, ADIOS_READ_METHOD_BP, comm);
+    if (f == NULL) {
+        printE ("Error at opening file: %s\n", adios_errmsg());
+        return 1;
+    }
+
+    // a box that cuts through the blocks
+    uint64_t start[2] = {ldim1/2, ldim2+1};
+    uint64_t count[2] = {gdim1-ldim1, gdim2-ldim2-2};
+
+    log ("  Queries with the SORTED method, whole array...\n");
+    err += query_test (f, NULL, NULL);
+    log ("  Queries with the SORTED method, bounding box selection crossing blocks...\n");
+    err += query_test (f, start, count);
+
+    for (is_label = 0; is_label < 2; is_label++) {
+        log ("  Top-k and quantiles of %s...\n", (is_label ? "label" : "data"));
+        err += topk_test (f, is_label, 1, 0);
+        err += topk_test (f, is_label, 37, 0);
+        err += topk_test (f, is_label, 2500, 1);
+        err += topk_test (f, is_label, 1000000, 0);
+        err += quantile_test (f, is_label, 0.0);
+        err += quantile_test (f, is_label, 0.5);
+        err += quantile_test (f, is_label, 0.9);
+        err += quantile_test (f, is_label, 1.0);
+    }
+
+    log ("  Top-k of a variable without index is an error...\n");
+    v = adios_query_topk (f, "extra", 0, 10, 0);
+    if (v->status != ADIOS_QUERY_RESULT_ERROR) {
+        printE ("top-k of a variable without sorted index did not fail\n");
+        err++;
+    }
+    adios_query_free_values (v);
+
+    log ("  Quantile outside of 0..1 is an error...\n");
+    v = adios_query_quantile (f, "data", 0, 1.5);
+    if (v->status != ADIOS_QUERY_RESULT_ERROR) {
+        printE ("quantile 1.5 did not fail\n");
+        err++;
+    }
+    adios_query_free_values (v);
+
+    adios_read_close(f);
+    return err;
+}
@@ -0,0 +1,239 @@
+/*
+ * ADIOS is freely available under the terms of the BSD license described
+ * in the COPYING file in the top level directory of this source distribution.
+ *
+ * Copyright (c) 2008 - 2009.  UT-BATTELLE, LLC. All rights reserved.
+ */
+
+/* ADIOS C test:
+ *  Write NSTEPS steps of a 2D array of 2D blocks, a float array 'data' with a
+ *  bitmap index, data[i,j] = i+j+step (global coordinates), except in step 1
+ *  where every element is -1.
+ *
+ *  Then evaluate a query over all steps with adios_query_evaluate_steps(),
+ *  with the SCAN and BITMAP methods, on one and on several threads, and check
+ *  the hit counts and points of every step against a brute force check.
+ *
+ * How to run: ./query_steps <N>
+ * It writes N*N 2D blocks organized into a NxN 2D array in each step.
+ * Output: query_steps.bp.dir/query_steps.bp.0
+ *
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include "public/adios.h"
+#include "public/adios_read.h"
+#include "public/adios_query.h"
+#include "query_test_common.h"
+
+#ifdef DMALLOC
+#include "dmalloc.h"
+#endif
+
+static const char FILENAME[] = "query_steps.bp";
+/* Appending steps with a metadata file overruns the dummy MPI_Gatherv of the
+   sequential library, so only the subfile is written and read */
+static const char READNAME[] = "query_steps.bp.dir/query_steps.bp.0";
+
+#define NSTEPS 4
+#define LDIM1 5
+#define LDIM2 7
+
+#define DATA(s,i,j) ((s) == 1 ? -1.0f : (float)((i)+(j)+(s)))
+
+/* the test query: data >= 8 AND data < 14 */
+static int match (int s, int i, int j) { return DATA(s,i,j) >= 8.0 && DATA(s,i,j) < 14.0; }
+
+/* The arrays to write */
+static double data_value (int step, int i, int j) { return DATA(step,i,j); }
+
+static const QUERY_TEST_VAR vars[] = {
+    { "data", adios_real, data_value },
+};
+
+static void define_indexes (int64_t group)
+{
+    adios_define_var_bitmap_index (group, "data", "0,4,8,10,16");
+}
+
+int query_as_file ();
+
+static const QUERY_TEST test = {
+    .name           = "query_steps",
+    .filename       = FILENAME,
+    .method_params  = "have_metadata_file=0",
+    .stats          = adios_stat_default,
+    .ldim1          = LDIM1,
+    .ldim2          = LDIM2,
+    .N              = 3,
+    .nsteps         = NSTEPS,
+    .nvars          = sizeof(vars) / sizeof(vars[0]),
+    .vars           = vars,
+    .define_indexes = define_indexes,
+    .index_size     = 4096,
+    .queries        = query_as_file,
+};
+
+int main (int argc, char ** argv)
+{
+    return query_test_main (argc, argv, &test);
+}
+
+
+/* State of one adios_query_evaluate_steps() call, checked in the step function */
+typedef struct {
+    const char *name;
+    uint64_t    batchSize;
+    int         skip_step;      // return 1 after the hit count of this step
+    int         stop_step;      // return -1 after the hit count of this step
+    int         last_step;      // last step seen
+    int         ncounts;        // number of calls with the hit count
+    int64_t     nhits;          // hit count of the current step
+    uint64_t    npoints;        // points returned in the current step
+    uint64_t    points[NSTEPS]; // points returned per step
+    char       *seen;
+    int         nerr;
+} STEP_CHECK;
+
+static int check_step (int timestep, int64_t nhits, ADIOS_QUERY_RESULT *result, void *arg)
+{
+    STEP_CHECK *c = (STEP_CHECK *) arg;
+    uint64_t n, i, j;
+
+    if (!result) {
+        // first call of the step: its hit count, the previous step must be complete
+        if (c->last_step >= 0 && c->nhits != c->npoints && c->last_step != c->skip_step) {
+            printE ("%s: step %d returned %" PRIu64 " points instead of %" PRId64 "\n",
+                    c->name, c->last_step, c->npoints, c->nhits);
+            c->nerr++;
+        }
+        if (timestep != c->last_step + 1) {
+            printE ("%s: step %d follows step %d\n", c->name, timestep, c->last_step);
+            c->nerr++;
+        }
+        c->last_step = timestep;
+        c->ncounts++;
+        c->nhits = nhits;
+        c->npoints = 0;
+        memset (c->seen, 0, gdim1*gdim2);
+        if (timestep == c->stop_step)
+            return -1;
+        return (timestep == c->skip_step ? 1 : 0);
+    }
+
+    if (timestep != c->last_step || timestep == c->skip_step) {
+        printE ("%s: unexpected result of step %d\n", c->name, timestep);
+        c->nerr++;
+    }
+    if (result->nselections == 1) {
+        ADIOS_SELECTION_POINTS_STRUCT *pts = &result->selections[0].u.points;
+        if (pts->npoints > c->batchSize) {
+            printE ("%s: %" PRIu64 " points returned with batch size %" PRIu64 "\n",
+                    c->name, pts->npoints, c->batchSize);
+            c->nerr++;
+        }
+        for (n = 0; n < pts->npoints; n++) {
+            i = pts->points[2*n];
+            j = pts->points[2*n+1];
+            if (i >= gdim1 || j >= gdim2 || !match (timestep, i, j) || c->seen[i*gdim2+j]) {
+                printE ("%s: wrong point (%" PRIu64 ",%" PRIu64 ") returned in step %d\n",
+                        c->name, i, j, timestep);
+                c->nerr++;
+            } else {
+                c->seen[i*gdim2+j] = 1;
+            }
+        }
+        c->npoints += pts->npoints;
+        c->points[timestep] += pts->npoints;
+        free (pts->points);
+        free (result->selections);
+    }
+    free (result);
+    return (c->nerr < 10 ? 0 : -1);
+}
+
+static int check_steps (ADIOS_QUERY *q, const char *name, enum ADIOS_QUERY_METHOD method,
+                        int nthreads, uint64_t batchSize, int skip_step, int stop_step)
+{
+    STEP_CHECK c;
+    int s, i, j, nsteps_expected = (stop_step >= 0 ? stop_step + 1 : NSTEPS);
+
+    memset (&c, 0, sizeof(c));
+    c.name = name;
+    c.batchSize = batchSize;
+    c.skip_step = skip_step;
+    c.stop_step = stop_step;
+    c.last_step = -1;
+    c.seen = calloc (gdim1*gdim2, 1);
+
+    adios_query_set_method (q, method);
+    adios_query_set_threads (nthreads);
+    if (adios_query_evaluate_steps (q, NULL, 0, NSTEPS, batchSize, check_step, &c) != 0) {
+        printE ("%s: query evaluation failed with error: %s\n", name, adios_errmsg());
+        c.nerr++;
+    }
+    adios_query_set_threads (1);
+
+    if (c.ncounts != nsteps_expected) {
+        printE ("%s: hit counts of %d steps were returned instead of %d\n",
+                name, c.ncounts, nsteps_expected);
+        c.nerr++;
+    }
+    for (s = 0; s < nsteps_expected; s++) {
+        uint64_t nexpected = 0;
+        for (i = 0; i < gdim1; i++)
+            for (j = 0; j < gdim2; j++)
+                if (match (s, i, j))
+                    nexpected++;
+        if (s == skip_step || s == stop_step)
+            nexpected = 0;
+        if (c.points[s] != nexpected) {
+            printE ("%s: step %d returned %" PRIu64 " points instead of %" PRIu64 "\n",
+                    name, s, c.points[s], nexpected);
+            c.nerr++;
+        }
+    }
+    if (!c.nerr) {
+        log ("    %s: all steps as expected\n", name);
+    }
+    free (c.seen);
+    return c.nerr;
+}
+
+int query_as_file ()
+{
+    ADIOS_FILE * f;
+    ADIOS_QUERY  *q1, *q2, *q;
+    int err=0;
+
+    log ("Query data in %s\n", READNAME);
+    f = adios_read_open_file (READNAME, ADIOS_READ_METHOD_BP, comm);
+    if (f == NULL) {
+        printE ("Error at opening file: %s\n", adios_errmsg());
+        return 1;
+    }
+
+    q1 = adios_query_create (f, NULL, "data", ADIOS_GTEQ, "8.0");
+    q2 = adios_query_create (f, NULL, "data", ADIOS_LT, "14.0");
+    q  = adios_query_combine (q1, ADIOS_QUERY_OP_AND, q2);
+
+    err += check_steps (q, "scan, 1 thread", ADIOS_QUERY_METHOD_SCAN, 1, 10, -1, -1);
+    err += check_steps (q, "scan, 4 threads", ADIOS_QUERY_METHOD_SCAN, 4, 10, -1, -1);
+    err += check_steps (q, "bitmap, 1 thread", ADIOS_QUERY_METHOD_BITMAP, 1, 1000, -1, -1);
+    err += check_steps (q, "bitmap, 4 threads", ADIOS_QUERY_METHOD_BITMAP, 4, 7, -1, -1);
+    err += check_steps (q, "skip step 2", ADIOS_QUERY_METHOD_SCAN, 2, 5, 2, -1);
+    err += check_steps (q, "stop at step 2", ADIOS_QUERY_METHOD_SCAN, 2, 5, -1, 2);
+
+    if (adios_query_evaluate_steps (q, NULL, 1, NSTEPS, 10, check_step, NULL) == 0) {
+        printE ("Evaluation of steps beyond the last step did not fail\n");
+        err++;
+    }
+
+    adios_query_free(q);
+    adios_query_free(q2);
+    adios_query_free(q1);
+    adios_read_close (f);
+    return err;
+}
@@ -0,0 +1,182 @@
+/*
+ * ADIOS is freely available under the terms of the BSD license described
+ * in the COPYING file in the top level directory of this source distribution.
+ *
+ * Copyright (c) 2008 - 2009.  UT-BATTELLE, LLC. All rights reserved.
+ */
+
+/* Common part of the query tests, see query_test_common.h */
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <errno.h>
+#include "public/adios.h"
+#include "public/adios_read.h"
+#include "query_test_common.h"
+
+#ifdef DMALLOC
+#include "dmalloc.h"
+#endif
+
+/* user arguments */
+int N = 1;       // organize blocks in NxN shape
+
+int ldim1, ldim2;
+int gdim1, gdim2;
+static int offs1, offs2;
+
+int64_t       m_adios_group;
+
+MPI_Comm    comm = MPI_COMM_SELF; // dummy comm for sequential code
+int rank;
+int size;
+
+
+static int type_size (enum ADIOS_DATATYPES type)
+{
+    switch (type) {
+        case adios_real:    return sizeof(float);
+        case adios_double:  return sizeof(double);
+        default:            return sizeof(int);
+    }
+}
+
+static void fill_block (const QUERY_TEST *test, int step, void **blocks)
+{
+    int i, j, v, k = 0;
+    for (i=0; i<ldim1; i++) {
+        for (j=0; j<ldim2; j++) {
+            for (v=0; v<test->nvars; v++) {
+                double d = test->vars[v].value (step, offs1+i, offs2+j);
+                switch (test->vars[v].type) {
+                    case adios_real:   ((float *) blocks[v])[k] = (float) d; break;
+                    case adios_double: ((double *) blocks[v])[k] = d; break;
+                    default:           ((int *) blocks[v])[k] = (int) d; break;
+                }
+            }
+            k++;
+        }
+    }
+}
+
+
+static void Usage (const QUERY_TEST *test)
+{
+    printf("Usage: %s <N>\n"
+            "    <N>:       Number of blocks in each of X and Y direction\n", test->name);
+}
+
+static void define_vars (const QUERY_TEST *test)
+{
+    int i, v;
+
+    adios_define_var (m_adios_group, "ldim1", "", adios_integer, 0, 0, 0);
+    adios_define_var (m_adios_group, "ldim2", "", adios_integer, 0, 0, 0);
+    adios_define_var (m_adios_group, "gdim1", "", adios_integer, 0, 0, 0);
+    adios_define_var (m_adios_group, "gdim2", "", adios_integer, 0, 0, 0);
+    adios_define_var (m_adios_group, "offs1", "", adios_integer, 0, 0, 0);
+    adios_define_var (m_adios_group, "offs2", "", adios_integer, 0, 0, 0);
+
+    for (i=0; i<N*N; i++) {
+        for (v=0; v<test->nvars; v++) {
+            adios_define_var (m_adios_group, test->vars[v].name, "", test->vars[v].type,
+                    "ldim1,ldim2", "gdim1,gdim2", "offs1,offs2");
+        }
+    }
+    if (test->define_indexes)
+        test->define_indexes (m_adios_group);
+}
+
+static int write_file (const QUERY_TEST *test)
+{
+    int64_t       fh;
+    uint64_t      groupsize=0, totalsize;
+    int           nblocks = N*N;
+    int           i, j, s, v, elemsize = 0;
+    void        **blocks = malloc (test->nvars * sizeof(void *));
+
+    for (v=0; v<test->nvars; v++) {
+        blocks[v] = malloc (ldim1 * ldim2 * type_size (test->vars[v].type));
+        elemsize += type_size (test->vars[v].type);
+    }
+
+    log ("Write %d step(s) to %s\n", test->nsteps, test->filename);
+    for (s=0; s<test->nsteps; s++) {
+        adios_open (&fh, test->name, test->filename, (s == 0 ? "w" : "a"), comm);
+
+        groupsize  = (4 + nblocks*2) * sizeof(int);                  // dimensions
+        groupsize += (uint64_t) nblocks * ldim1 * ldim2 * elemsize;  // 2D  blocks
+        groupsize += nblocks * test->index_size;                     // indexes
+        adios_group_size (fh, groupsize, &totalsize);
+
+        for (i=0; i<N; i++) {
+            for (j=0; j<N; j++) {
+                offs1 = i*ldim1;
+                offs2 = j*ldim2;
+                fill_block (test, s, blocks);
+                adios_write (fh, "gdim1", &gdim1);
+                adios_write (fh, "gdim2", &gdim2);
+                adios_write (fh, "ldim1", &ldim1);
+                adios_write (fh, "ldim2", &ldim2);
+                adios_write (fh, "offs1", &offs1);
+                adios_write (fh, "offs2", &offs2);
+                for (v=0; v<test->nvars; v++)
+                    adios_write (fh, test->vars[v].name, blocks[v]);
+            }
+        }
+        adios_close (fh);
+    }
+
+    for (v=0; v<test->nvars; v++)
+        free (blocks[v]);
+    free (blocks);
+    return 0;
+}
+
+int query_test_main (int argc, char ** argv, const QUERY_TEST *test)
+{
+    int err,i ;
+
+    MPI_Init (&argc, &argv);
+    MPI_Comm_rank (comm, &rank);
+    MPI_Comm_size (comm, &size);
+
+    N = test->N;
+    if (argc == 1)
+    {
+        // this case is for the test harness. otherwise this should be calling for Usage();
+        printf("Running %s <N=%d>\n", test->name, N);
+    }
+    else
+    {
+        errno = 0;
+        i = strtol (argv[1], NULL, 10);
+        if (errno || i < 1) { printf("Invalid 1st argument %s\n", argv[1]); Usage(test); return 1;}
+        N = i;
+    }
+    ldim1 = test->ldim1;
+    ldim2 = test->ldim2;
+    gdim1 = N*ldim1;
+    gdim2 = N*ldim2;
+
+    adios_init_noxml (comm);
+    err = adios_read_init_method(ADIOS_READ_METHOD_BP, comm, "verbose=2");
+    if (err) {
+        printE ("%s\n", adios_errmsg());
+    }
+
+    adios_declare_group (&m_adios_group, test->name, "", test->stats);
+    adios_select_method (m_adios_group, "POSIX", test->method_params, "");
+
+    define_vars (test);
+    err = write_file (test);
+
+    if (!err)
+        err = test->queries ();
+
+    adios_read_finalize_method (ADIOS_READ_METHOD_BP);
+    adios_finalize (rank);
+    MPI_Finalize ();
+    return err;
+}
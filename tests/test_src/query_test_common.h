@@ -0,0 +1,65 @@
+/*
+ * ADIOS is freely available under the terms of the BSD license described
+ * in the COPYING file in the top level directory of this source distribution.
+ *
+ * Copyright (c) 2008 - 2009.  UT-BATTELLE, LLC. All rights reserved.
+ */
+
+/* Common part of the query tests:
+ *  Write a 2D array of NxN 2D blocks of ldim1*ldim2 elements for each array
+ *  of the test with the POSIX method, in one or more steps, then run the
+ *  queries of the test on it.
+ *
+ *  Each test describes its arrays and indexes in a QUERY_TEST and calls
+ *  query_test_main() from main().
+ */
+#ifndef QUERY_TEST_COMMON_H
+#define QUERY_TEST_COMMON_H
+
+#include <stdio.h>
+#include <stdint.h>
+#include "public/adios.h"
+#include "public/adios_read.h"
+
+#define log(...) fprintf (stderr, "[rank=%3.3d, line %d]: ", rank, __LINE__); fprintf (stderr, __VA_ARGS__); fflush(stderr);
+#define printE(...) fprintf (stderr, "[rank=%3.3d, line %d]: ERROR: ", rank, __LINE__); fprintf (stderr, __VA_ARGS__); fflush(stderr);
+
+/* An array written in every block, value(step,i,j) at global point (i,j) */
+typedef struct {
+    const char *name;
+    enum ADIOS_DATATYPES type;  // adios_real, adios_double or adios_integer
+    double (*value) (int step, int i, int j);
+} QUERY_TEST_VAR;
+
+typedef struct {
+    const char *name;           // test name, also the name of the adios group
+    const char *filename;       // file to write
+    const char *method_params;  // parameters of the POSIX method
+    enum ADIOS_STATISTICS_FLAG stats;
+    int ldim1, ldim2;           // size of a block
+    int N;                      // default number of blocks in each direction
+    int nsteps;                 // number of steps, the ones after the first are appended
+    int nvars;
+    const QUERY_TEST_VAR *vars;
+    void (*define_indexes) (int64_t group); // define the indexes of the arrays, or NULL
+    uint64_t index_size;        // bytes of the indexes of one block in one step
+    int (*queries) (void);      // run the queries on the file, return the number of errors
+} QUERY_TEST;
+
+/* user arguments */
+extern int N;                   // organize blocks in NxN shape
+
+extern int ldim1, ldim2;
+extern int gdim1, gdim2;
+
+extern int64_t m_adios_group;
+
+extern MPI_Comm comm;           // dummy comm for sequential code
+extern int rank;
+extern int size;
+
+/* Parse the arguments, write the file and run the queries of the test.
+   Returns the exit code of the test. */
+int query_test_main (int argc, char ** argv, const QUERY_TEST *test);
+
+#endif
@@ -0,0 +1,273 @@
+/*
+ * ADIOS is freely available under the terms of the BSD license described
+ * in the COPYING file in the top level directory of this source distribution.
+ *
+ * Copyright (c) 2008 - 2009.  UT-BATTELLE, LLC. All rights reserved.
+ */
+
+/* ADIOS C test:
+ *  Write a 2D array of 2D blocks, a float array 'data' and an integer array 'label',
+ *  both with a zone map of one row per zone.
+ *  data[i,j] = 100*i+j (global coordinates), NaN in every 4th row, label[i,j] = i % 5
+ *
+ *  Then test if the scan query method returns exactly the points that
+ *  satisfy the query, compared to a brute force check of the same condition,
+ *  and if the minmax query method drops the blocks whose zones cannot match.
+ *
+ * How to run: ./query_zonemap <N>
+ * It writes N*N 2D blocks organized into a NxN 2D array.
+ * Output: query_zonemap.bp
+ *
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <math.h>
+#include "public/adios.h"
+#include "public/adios_read.h"
+#include "public/adios_query.h"
+#include "query_test_common.h"
+
+#ifdef DMALLOC
+#include "dmalloc.h"
+#endif
+
+static const char FILENAME[] = "query_zonemap.bp";
+
+#define LDIM1 8
+#define LDIM2 7
+
+#define DATA(i,j)  (((i) % 4 == 3) ? NAN : (float)(100*(i)+(j)))
+#define LABEL(i,j) ((int)((i) % 5))
+
+/* The arrays to write */
+static double data_value (int step, int i, int j) { return DATA(i,j); }
+static double label_value (int step, int i, int j) { return LABEL(i,j); }
+
+static const QUERY_TEST_VAR vars[] = {
+    { "data",  adios_real,    data_value },
+    { "label", adios_integer, label_value },
+};
+
+static void define_indexes (int64_t group)
+{
+    adios_define_var_zone_map (group, "data", LDIM2);
+    adios_define_var_zone_map (group, "label", LDIM2);
+}
+
+int query_as_file ();
+
+static const QUERY_TEST test = {
+    .name           = "query_zonemap",
+    .filename       = FILENAME,
+    .method_params  = "",
+    .stats          = adios_stat_default,
+    .ldim1          = LDIM1,
+    .ldim2          = LDIM2,
+    .N              = 3,
+    .nsteps         = 1,
+    .nvars          = sizeof(vars) / sizeof(vars[0]),
+    .vars           = vars,
+    .define_indexes = define_indexes,
+    .index_size     = 2 * (32 + 2 * LDIM1 * sizeof(int)),
+    .queries        = query_as_file,
+};
+
+int main (int argc, char ** argv)
+{
+    return query_test_main (argc, argv, &test);
+}
+
+
+/* Expected result of the test queries at global point (i,j) */
+typedef int (*MATCH_FN) (int i, int j);
+
+// data > 150.0 && data <= 420.0
+static int match_and (int i, int j) { return DATA(i,j) > 150.0 && DATA(i,j) <= 420.0; }
+// data < 14.0 || label == 3
+static int match_or (int i, int j) { return DATA(i,j) < 14.0 || LABEL(i,j) == 3; }
+// label != 0, matching whole zones
+static int match_ne (int i, int j) { return LABEL(i,j) != 0; }
+// data != 105.0, true for the NaNs
+static int match_data_ne (int i, int j) { return DATA(i,j) != 105.0; }
+
+/*
+ * Evaluate query q in batches of batchSize and check every returned point
+ * against the expected condition within box (start,count).
+ */
+static int check_query (ADIOS_QUERY *q, const char *name, uint64_t batchSize,
+                        ADIOS_SELECTION *outsel, uint64_t *start, uint64_t *count, MATCH_FN match)
+{
+    int nerr = 0;
+    uint64_t i, j, n, nexpected = 0, nhits = 0;
+    char *seen = calloc (gdim1*gdim2, 1);
+
+    for (i = start[0]; i < start[0]+count[0]; i++)
+        for (j = start[1]; j < start[1]+count[1]; j++)
+            if (match (i, j))
+                nexpected++;
+
+    adios_query_set_method (q, ADIOS_QUERY_METHOD_SCAN);
+    int64_t estimate = adios_query_estimate (q, 0);
+    if (estimate != nexpected) {
+        printE ("%s: estimate returned %" PRId64 " instead of %" PRIu64 "\n", name, estimate, nexpected);
+        nerr++;
+    }
+
+    ADIOS_QUERY_RESULT *result;
+    do {
+        result = adios_query_evaluate (q, outsel, 0, batchSize);
+        if (result->status == ADIOS_QUERY_RESULT_ERROR) {
+            printE ("%s: query evaluation failed with error: %s\n", name, adios_errmsg());
+            nerr++;
+            free (result);
+            break;
+        }
+        if (result->method_used != ADIOS_QUERY_METHOD_SCAN) {
+            printE ("%s: query evaluated with method %d instead of SCAN\n", name, result->method_used);
+            nerr++;
+        }
+        if (result->nselections == 1) {
+            ADIOS_SELECTION_POINTS_STRUCT *pts = &result->selections[0].u.points;
+            if (pts->npoints > batchSize) {
+                printE ("%s: %" PRIu64 " points returned with batch size %" PRIu64 "\n",
+                        name, pts->npoints, batchSize);
+                nerr++;
+            }
+            for (n = 0; n < pts->npoints; n++) {
+                i = pts->points[2*n];
+                j = pts->points[2*n+1];
+                if (i < start[0] || i >= start[0]+count[0] ||
+                    j < start[1] || j >= start[1]+count[1] ||
+                    !match (i, j) || seen[i*gdim2+j])
+                {
+                    printE ("%s: wrong point (%" PRIu64 ",%" PRIu64 ") returned\n", name, i, j);
+                    nerr++;
+                }
+                else
+                {
+                    seen[i*gdim2+j] = 1;
+                }
+            }
+            nhits += pts->npoints;
+            free (pts->points);
+            free (result->selections);
+        }
+        n = result->status;
+        free (result);
+    } while (n == ADIOS_QUERY_HAS_MORE_RESULTS && nerr < 10);
+
+    if (nhits != nexpected) {
+        printE ("%s: query returned %" PRIu64 " points instead of %" PRIu64 "\n", name, nhits, nexpected);
+        nerr++;
+    } else {
+        log ("    %s: %" PRIu64 " points as expected\n", name, nhits);
+    }
+    free (seen);
+    return nerr;
+}
+
+int query_test (ADIOS_FILE *f, uint64_t *start, uint64_t *count)
+{
+    int nerr = 0;
+    ADIOS_QUERY  *q1, *q2, *q;
+    ADIOS_SELECTION *boxsel = NULL;
+    uint64_t gstart[2] = {0,0};
+    uint64_t gcount[2] = {gdim1,gdim2};
+
+    if (start) {
+        boxsel = adios_selection_boundingbox (2, start, count);
+    } else {
+        start = gstart;
+        count = gcount;
+    }
+
+    q1 = adios_query_create (f, boxsel, "data", ADIOS_GT, "150.0");
+    q2 = adios_query_create (f, boxsel, "data", ADIOS_LTEQ, "420.0");
+    q  = adios_query_combine (q1, ADIOS_QUERY_OP_AND, q2);
+    nerr += check_query (q, "data > 150 AND data <= 420", gdim1*gdim2, boxsel, start, count, match_and);
+    adios_query_free(q);
+    adios_query_free(q2);
+    adios_query_free(q1);
+
+    q1 = adios_query_create (f, boxsel, "data", ADIOS_LT, "14.0");
+    q2 = adios_query_create (f, boxsel, "label", ADIOS_EQ, "3");
+    q  = adios_query_combine (q1, ADIOS_QUERY_OP_OR, q2);
+    nerr += check_query (q, "data < 14 OR label == 3", 7, boxsel, start, count, match_or);
+    adios_query_free(q);
+    adios_query_free(q2);
+    adios_query_free(q1);
+
+    q = adios_query_create (f, boxsel, "label", ADIOS_NE, "0");
+    nerr += check_query (q, "label != 0", 100, boxsel, start, count, match_ne);
+    adios_query_free(q);
+
+    q = adios_query_create (f, boxsel, "data", ADIOS_NE, "105.0");
+    nerr += check_query (q, "data != 105", 64, boxsel, start, count, match_data_ne);
+    adios_query_free(q);
+
+    if (boxsel)
+        adios_selection_delete (boxsel);
+    return nerr;
+}
+
+
+/* The minmax method returns the blocks that may match */
+static int check_minmax (ADIOS_FILE *f, const char *value, int64_t nexpected)
+{
+    int nerr = 0;
+    ADIOS_QUERY *q = adios_query_create (f, NULL, "data", ADIOS_EQ, value);
+    adios_query_set_method (q, ADIOS_QUERY_METHOD_MINMAX);
+    int64_t n = adios_query_estimate (q, 0);
+    if (n != nexpected) {
+        printE ("data == %s: minmax estimated %" PRId64 " blocks instead of %" PRId64 "\n",
+                value, n, nexpected);
+        nerr++;
+    } else {
+        log ("    data == %s: %" PRId64 " blocks as expected\n", value, n);
+    }
+    adios_query_free(q);
+    return nerr;
+}
+
+int query_as_file ()
+{
+    ADIOS_FILE * f;
+    int err=0;
+
+    log ("Query data in %s\n", FILENAME);
+    f = adios_read_open_file (FILENAME, ADIOS_READ_METHOD_BP, comm);
+    if (f == NULL) {
+        printE ("Error at opening file: %s\n", adios_errmsg());
+        return 1;
+    }
+
+    log ("  Query the whole array with NULL as bounding box selection...\n");
+    err += query_test (f, NULL, NULL);
+
+    // a box that cuts through the blocks
+    uint64_t start[2] = {ldim1/2, ldim2+1};
+    uint64_t count[2] = {gdim1-ldim1, gdim2-ldim2-2};
+    log ("  Query with a bounding box selection crossing blocks...\n");
+    err += query_test (f, start, count);
+
+    // a writeblock selection
+    uint64_t wbstart[2] = {ldim1*(N-1), ldim2*(N-1)};
+    uint64_t wbcount[2] = {ldim1, ldim2};
+    ADIOS_SELECTION *wb = adios_selection_writeblock (N*N-1);
+    ADIOS_QUERY *q = adios_query_create (f, wb, "label", ADIOS_NE, "0");
+    log ("  Query with a writeblock selection...\n");
+    err += check_query (q, "label != 0 in last block", 10, wb, wbstart, wbcount, match_ne);
+    adios_query_free(q);
+    adios_selection_delete (wb);
+
+    // 50 falls into the range of the first row of blocks but not into any of their zones,
+    // 105 is in the second row of the first block only
+    log ("  Query blocks with the minmax method...\n");
+    err += check_minmax (f, "50", 0);
+    err += check_minmax (f, "105", 1);
+
+    adios_read_close(f);
+    return err;
+}
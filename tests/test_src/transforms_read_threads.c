@@ -0,0 +1,296 @@
+/*
+ * ADIOS is freely available under the terms of the BSD license described
+ * in the COPYING file in the top level directory of this source distribution.
+ *
+ * Copyright (c) 2008 - 2009.  UT-BATTELLE, LLC. All rights reserved.
+ */
+
+/* ADIOS C test:
+ *  Write a 2D double array of N blocks along the slowest dimension with
+ *  several transforms, and without any.
+ *  data[i,j] = sin(0.1*i) + 0.01*j (global coordinates)
+ *
+ *  Then read the whole arrays and boxes across the blocks, all in one
+ *  adios_perform_reads(), with transform_threads=1 and with several threads.
+ *  Lossless transforms must give the written data back, and each read with
+ *  threads must give the same values as the serial one.
+ *
+ * How to run: ./transforms_read_threads <N>
+ * Output: transforms_read_threads.bp
+ *
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <math.h>
+#include <errno.h>
+#include "public/adios.h"
+#include "public/adios_read.h"
+#include "public/adios_transform_methods.h"
+
+#ifdef DMALLOC
+#include "dmalloc.h"
+#endif
+
+#define log(...) fprintf (stderr, "[rank=%3.3d, line %d]: ", rank, __LINE__); fprintf (stderr, __VA_ARGS__); fflush(stderr);
+#define printE(...) fprintf (stderr, "[rank=%3.3d, line %d]: ERROR: ", rank, __LINE__); fprintf (stderr, __VA_ARGS__); fflush(stderr);
+
+/* user arguments */
+int N = 16;      // number of blocks
+
+static const char FILENAME[] = "transforms_read_threads.bp";
+
+#define LDIM1 8
+#define LDIM2 300
+static const int ldim1 = LDIM1;
+static const int ldim2 = LDIM2;
+int gdim1;
+int offs1;
+
+int64_t       m_adios_group;
+
+/* Variables to write */
+double a2[LDIM1*LDIM2];
+
+MPI_Comm    comm = MPI_COMM_SELF; // dummy comm for sequential code
+int rank;
+int size;
+
+#define DATA(i,j) (sin(0.1*(i)) + 0.01*(j))
+
+/* The variables, their transform and whether it is lossless */
+struct test_var {
+    const char *name;
+    const char *transform;
+    const char *method;  // transform method that must be available, NULL if none
+    int lossless;
+} VARS[] = {
+    { "raw",          "",                        NULL,      1 },
+    { "identity",     "identity",                NULL,      1 },
+    { "zlib",         "zlib",                    "zlib",    1 },
+    { "shuffle_zlib", "shuffle|zlib",            "zlib",    1 },
+    { "zfp",          "zfp:accuracy=0.0001",     "zfp",     0 },
+};
+#define NVARS (int)(sizeof(VARS) / sizeof(VARS[0]))
+int available[NVARS];
+
+/* Boxes to read: the whole array, one within a block and one across all blocks */
+#define NBOXES 3
+uint64_t starts[NBOXES][2];
+uint64_t counts[NBOXES][2];
+
+
+void fill_block ()
+{
+    int i, j, n = 0;
+    for (i=0; i<ldim1; i++)
+        for (j=0; j<ldim2; j++)
+            a2[n++] = DATA(offs1+i, j);
+}
+
+
+void Usage()
+{
+    printf("Usage: transforms_read_threads <N>\n"
+            "    <N>:       Number of blocks along the slowest dimension\n");
+}
+
+int method_available (const char *method);
+void define_vars ();
+int write_file ();
+int read_file (const char *params, double **result);
+
+int main (int argc, char ** argv)
+{
+    int err, i, b;
+    double *serial[NVARS*NBOXES], *threaded[NVARS*NBOXES];
+
+    MPI_Init (&argc, &argv);
+    MPI_Comm_rank (comm, &rank);
+    MPI_Comm_size (comm, &size);
+
+    if (argc == 1)
+    {
+        // this case is for the test harness. otherwise this should be calling for Usage();
+        printf("Running transforms_read_threads <N=%d>\n", N);
+    }
+    else
+    {
+        errno = 0;
+        i = strtol (argv[1], NULL, 10);
+        if (errno || i < 1) { printf("Invalid 1st argument %s\n", argv[1]); Usage(); return 1;}
+        N = i;
+    }
+    gdim1 = N*ldim1;
+
+    starts[0][0] = 0;           starts[0][1] = 0;
+    counts[0][0] = gdim1;       counts[0][1] = ldim2;
+    starts[1][0] = ldim1+1;     starts[1][1] = 17;
+    counts[1][0] = ldim1-2;     counts[1][1] = 101;
+    starts[2][0] = ldim1/2;     starts[2][1] = ldim2-9;
+    counts[2][0] = gdim1-ldim1; counts[2][1] = 9;
+
+    adios_init_noxml (comm);
+    for (i=0; i<NVARS; i++)
+        available[i] = (!VARS[i].method || method_available (VARS[i].method));
+
+    adios_declare_group (&m_adios_group, "transforms_read_threads", "", adios_stat_default);
+    adios_select_method (m_adios_group, "POSIX", "", "");
+
+    define_vars();
+    err = write_file ();
+
+    if (!err) {
+        log ("Read with a single thread\n");
+        err = read_file ("transform_threads=1", serial);
+    }
+    if (!err) {
+        log ("Read with 4 threads\n");
+        err = read_file ("transform_threads=4", threaded);
+    }
+
+    if (!err) {
+        for (i=0; i<NVARS; i++) {
+            if (!available[i])
+                continue;
+            for (b=0; b<NBOXES; b++) {
+                uint64_t n = counts[b][0]*counts[b][1];
+                if (memcmp (serial[i*NBOXES+b], threaded[i*NBOXES+b], n*sizeof(double))) {
+                    printE ("%s box %d read with threads differs from the serial read\n", VARS[i].name, b);
+                    err++;
+                }
+                free (serial[i*NBOXES+b]);
+                free (threaded[i*NBOXES+b]);
+            }
+        }
+    }
+
+    adios_finalize (rank);
+    MPI_Finalize ();
+    return err;
+}
+
+int method_available (const char *method)
+{
+    int i, found = 0;
+    ADIOS_AVAILABLE_TRANSFORM_METHODS *t = adios_available_transform_methods();
+    if (t) {
+        for (i=0; i<t->ntransforms; i++)
+            if (!strcmp (t->name[i], method))
+                found = 1;
+        adios_available_transform_methods_free (t);
+    }
+    if (!found) {
+        log ("%s is not available in this build, it is not tested\n", method);
+    }
+    return found;
+}
+
+void define_vars ()
+{
+    int i, v;
+
+    adios_define_var (m_adios_group, "ldim1", "", adios_integer, 0, 0, 0);
+    adios_define_var (m_adios_group, "ldim2", "", adios_integer, 0, 0, 0);
+    adios_define_var (m_adios_group, "gdim1", "", adios_integer, 0, 0, 0);
+    adios_define_var (m_adios_group, "offs1", "", adios_integer, 0, 0, 0);
+
+    for (i=0; i<N; i++) {
+        for (v=0; v<NVARS; v++) {
+            if (!available[v])
+                continue;
+            int64_t varid = adios_define_var (m_adios_group, VARS[v].name, "", adios_double,
+                    "ldim1,ldim2", "gdim1,ldim2", "offs1,0");
+            if (*VARS[v].transform)
+                adios_set_transform (varid, VARS[v].transform);
+        }
+    }
+}
+
+int write_file ()
+{
+    int64_t       fh;
+    uint64_t      groupsize=0, totalsize;
+    int           i, v;
+
+    log ("Write to %s\n", FILENAME);
+    adios_open (&fh, "transforms_read_threads", FILENAME, "w", comm);
+
+    groupsize  = (2 + N*2) * sizeof(int);                        // dimensions
+    groupsize += NVARS * N * ldim1 * ldim2 * sizeof(double);     // 2D blocks
+    adios_group_size (fh, groupsize, &totalsize);
+
+    for (i=0; i<N; i++) {
+        offs1 = i*ldim1;
+        fill_block ();
+        adios_write (fh, "gdim1", &gdim1);
+        adios_write (fh, "ldim1", &ldim1);
+        adios_write (fh, "ldim2", &ldim2);
+        adios_write (fh, "offs1", &offs1);
+        for (v=0; v<NVARS; v++)
+            if (available[v])
+                adios_write (fh, VARS[v].name, a2);
+    }
+    if (adios_close (fh)) {
+        printE ("Writing failed: %s\n", adios_errmsg());
+        return 1;
+    }
+    return 0;
+}
+
+/* Read every box of every variable in one adios_perform_reads() into newly
+   allocated buffers in result[], and check the lossless ones */
+int read_file (const char *params, double **result)
+{
+    ADIOS_FILE * f;
+    ADIOS_SELECTION *sel[NBOXES];
+    int nerr = 0, v, b;
+    uint64_t i, j, n;
+
+    adios_read_init_method (ADIOS_READ_METHOD_BP, comm, params);
+    f = adios_read_open_file (FILENAME, ADIOS_READ_METHOD_BP, comm);
+    if (f == NULL) {
+        printE ("Error at opening file: %s\n", adios_errmsg());
+        adios_read_finalize_method (ADIOS_READ_METHOD_BP);
+        return 1;
+    }
+
+    for (b=0; b<NBOXES; b++)
+        sel[b] = adios_selection_boundingbox (2, starts[b], counts[b]);
+    for (v=0; v<NVARS; v++) {
+        if (!available[v])
+            continue;
+        for (b=0; b<NBOXES; b++) {
+            result[v*NBOXES+b] = malloc (counts[b][0]*counts[b][1]*sizeof(double));
+            adios_schedule_read (f, sel[b], VARS[v].name, 0, 1, result[v*NBOXES+b]);
+        }
+    }
+    if (adios_perform_reads (f, 1) || adios_errno) {
+        printE ("Reading failed: %s\n", adios_errmsg());
+        nerr++;
+    }
+    for (b=0; b<NBOXES; b++)
+        adios_selection_delete (sel[b]);
+
+    for (v=0; !nerr && v<NVARS; v++) {
+        if (!available[v] || !VARS[v].lossless)
+            continue;
+        for (b=0; b<NBOXES; b++) {
+            n = 0;
+            for (i = starts[b][0]; i < starts[b][0]+counts[b][0]; i++)
+                for (j = starts[b][1]; j < starts[b][1]+counts[b][1]; j++, n++)
+                    if (result[v*NBOXES+b][n] != DATA(i,j) && nerr++ < 10) {
+                        printE ("%s[%" PRIu64 ",%" PRIu64 "] = %g instead of %g\n",
+                                VARS[v].name, i, j, result[v*NBOXES+b][n], DATA(i,j));
+                    }
+        }
+        if (!nerr) {
+            log ("    %s as expected\n", VARS[v].name);
+        }
+    }
+
+    adios_read_close (f);
+    adios_read_finalize_method (ADIOS_READ_METHOD_BP);
+    return nerr;
+}
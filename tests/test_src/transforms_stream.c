@@ -0,0 +1,342 @@
+/*
+ * ADIOS is freely available under the terms of the BSD license described
+ * in the COPYING file in the top level directory of this source distribution.
+ *
+ * Copyright (c) 2008 - 2009.  UT-BATTELLE, LLC. All rights reserved.
+ */
+
+/* ADIOS C test:
+ *  1. Stream output into a small shared buffer with shared_buffer_stream_*()
+ *     in odd-sized chunks, far beyond the buffer size, so the buffer grows
+ *     (and likely moves) while streaming. The data before the stream and the
+ *     streamed data must survive; a rewound stream, an unclosed stream and a
+ *     stream beyond the maximum buffer size must leave the offset as it was.
+ *  2. Write byte arrays with the streaming zlib and bzip2 transforms (bzip2
+ *     only if it is available in this build): a compressible one, whose
+ *     output is still larger than one extension of the buffer, and an
+ *     incompressible one, which is streamed until the output exceeds the
+ *     input and is then stored as is. The group size is given without the
+ *     arrays, so the buffer grows while the transforms write into it. Both
+ *     arrays must read back as written, and only the compressible one may
+ *     be stored compressed.
+ *
+ * How to run: ./transforms_stream
+ * Output: transforms_stream.bp
+ *
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include "public/adios.h"
+#include "public/adios_read.h"
+#include "public/adios_read_ext.h"
+#include "public/adios_transform_methods.h"
+#include "core/adios_internals.h"
+#include "core/buffer.h"
+#include "core/transforms/adios_transforms_util.h"
+
+#ifdef DMALLOC
+#include "dmalloc.h"
+#endif
+
+#define log(...) fprintf (stderr, "[rank=%3.3d, line %d]: ", rank, __LINE__); fprintf (stderr, __VA_ARGS__); fflush(stderr);
+#define printE(...) fprintf (stderr, "[rank=%3.3d, line %d]: ERROR: ", rank, __LINE__); fprintf (stderr, __VA_ARGS__); fflush(stderr);
+
+static const char FILENAME[] = "transforms_stream.bp";
+
+MPI_Comm    comm = MPI_COMM_SELF; // dummy comm for sequential code
+int rank;
+int size;
+
+/* Both arrays are larger than one extension of the buffer (16MB), and the
+   compressible one still is after compression (4 random bits per byte) */
+#define MB (1024*1024)
+#define COMPRESSIBLE_SIZE   (48*MB)
+#define INCOMPRESSIBLE_SIZE (24*MB)
+
+#define PREFIX_SIZE 1000
+#define STREAM_SIZE (40*MB)
+#define CHUNK 77777
+
+/* byte n of the data of the streaming test */
+#define STREAM_BYTE(n) ((char) ((n)*7 + (n)/251))
+
+static const char *TRANSFORMS[] = { "zlib", "bzip2" };
+#define NTRANSFORMS (int)(sizeof(TRANSFORMS) / sizeof(TRANSFORMS[0]))
+
+/* Random bytes; only the low 'bits' bits are set */
+static void fill_random (unsigned char *data, uint64_t n, int bits, uint32_t seed)
+{
+    uint64_t i;
+    for (i = 0; i < n; i++) {
+        seed = seed * 1664525u + 1013904223u;
+        data[i] = (unsigned char) (seed >> 24) & ((1 << bits) - 1);
+    }
+}
+
+static int transform_available (const char *name)
+{
+    int i, found = 0;
+    ADIOS_AVAILABLE_TRANSFORM_METHODS *t = adios_available_transform_methods();
+    if (t) {
+        for (i=0; i<t->ntransforms; i++)
+            if (!strcmp (t->name[i], name))
+                found = 1;
+        adios_available_transform_methods_free (t);
+    }
+    return found;
+}
+
+int test_stream ();
+int write_file (const unsigned char *compressible, const unsigned char *incompressible);
+int read_file (const unsigned char *compressible, const unsigned char *incompressible);
+
+int main (int argc, char ** argv)
+{
+    int err;
+    unsigned char *compressible, *incompressible;
+
+    MPI_Init (&argc, &argv);
+    MPI_Comm_rank (comm, &rank);
+    MPI_Comm_size (comm, &size);
+
+    adios_init_noxml (comm);
+    err = adios_read_init_method(ADIOS_READ_METHOD_BP, comm, "verbose=2");
+    if (err) {
+        printE ("%s\n", adios_errmsg());
+    }
+
+    err = test_stream ();
+
+    compressible = malloc (COMPRESSIBLE_SIZE);
+    incompressible = malloc (INCOMPRESSIBLE_SIZE);
+    fill_random (compressible, COMPRESSIBLE_SIZE, 4, 17);
+    fill_random (incompressible, INCOMPRESSIBLE_SIZE, 8, 4711);
+
+    if (!err)
+        err = write_file (compressible, incompressible);
+    if (!err)
+        err = read_file (compressible, incompressible);
+
+    free (compressible);
+    free (incompressible);
+    adios_read_finalize_method (ADIOS_READ_METHOD_BP);
+    adios_finalize (rank);
+    MPI_Finalize ();
+    return err;
+}
+
+/* Stream size bytes of STREAM_BYTE() in chunks of CHUNK bytes or less */
+static int stream_data (struct shared_buffer_stream *stream, uint64_t size)
+{
+    uint64_t n = 0, avail, i, len;
+    char *out;
+    while (n < size) {
+        out = shared_buffer_stream_space (stream, 1, &avail);
+        if (!out) {
+            printE ("No room to stream byte %llu\n", (unsigned long long) n);
+            return 1;
+        }
+        len = (size - n < CHUNK ? size - n : CHUNK);
+        if (len > avail)
+            len = avail;
+        for (i = 0; i < len; i++)
+            out[i] = STREAM_BYTE(n+i);
+        shared_buffer_stream_advance (stream, len);
+        n += len;
+    }
+    return 0;
+}
+
+int test_stream ()
+{
+    struct adios_file_struct *fd = calloc (1, sizeof (struct adios_file_struct));
+    struct adios_group_struct group = { .name = "stream_test" }; // for the log messages
+    struct shared_buffer_stream stream;
+    char prefix[PREFIX_SIZE];
+    uint64_t avail, n, max_size = adios_databuffer_get_max_size ();
+    int nerr = 0;
+
+    log ("Stream %d MB into a buffer of %d bytes\n", STREAM_SIZE/MB, 2*PREFIX_SIZE);
+    fd->group = &group;
+    adios_databuffer_set_max_size (STREAM_SIZE + 2*PREFIX_SIZE);
+    adios_databuffer_resize (fd, 2*PREFIX_SIZE);
+    memset (prefix, 'p', PREFIX_SIZE);
+    shared_buffer_write (fd, prefix, PREFIX_SIZE);
+
+    // a rewound stream and a stream that is not closed write nothing
+    shared_buffer_stream_open (&stream, fd);
+    nerr += stream_data (&stream, 3*CHUNK);
+    shared_buffer_stream_rewind (&stream);
+    if (shared_buffer_stream_close (&stream) != 0 || fd->offset != PREFIX_SIZE) {
+        printE ("A rewound stream moved the buffer offset to %llu\n", (unsigned long long) fd->offset);
+        nerr++;
+    }
+    shared_buffer_stream_open (&stream, fd);
+    nerr += stream_data (&stream, 2*CHUNK);
+    if (fd->offset != PREFIX_SIZE) {
+        printE ("An open stream moved the buffer offset to %llu\n", (unsigned long long) fd->offset);
+        nerr++;
+    }
+
+    // the whole stream, growing the buffer
+    shared_buffer_stream_open (&stream, fd);
+    nerr += stream_data (&stream, STREAM_SIZE);
+    if (!nerr && shared_buffer_stream_close (&stream) != STREAM_SIZE) {
+        printE ("Closing the stream returned the wrong size\n");
+        nerr++;
+    }
+    if (!nerr && fd->offset != PREFIX_SIZE + STREAM_SIZE) {
+        printE ("The buffer offset is %llu instead of %llu after the stream\n",
+                (unsigned long long) fd->offset, (unsigned long long) PREFIX_SIZE + STREAM_SIZE);
+        nerr++;
+    }
+    if (!nerr && memcmp (fd->buffer, prefix, PREFIX_SIZE)) {
+        printE ("The data before the stream was overwritten\n");
+        nerr++;
+    }
+    for (n = 0; !nerr && n < STREAM_SIZE; n++) {
+        if (fd->buffer[PREFIX_SIZE + n] != STREAM_BYTE(n)) {
+            printE ("Streamed byte %llu is wrong\n", (unsigned long long) n);
+            nerr++;
+        }
+    }
+    if (!nerr) {
+        log ("    the buffer grew to %llu bytes, all data as expected\n",
+             (unsigned long long) fd->buffer_size);
+    }
+
+    // a stream cannot grow the buffer beyond the maximum size
+    log ("  Stream beyond the maximum buffer size, an error message is expected\n");
+    shared_buffer_stream_open (&stream, fd);
+    if (shared_buffer_stream_space (&stream, 2*PREFIX_SIZE, &avail) != NULL ||
+        shared_buffer_stream_close (&stream) != 0 || fd->offset != PREFIX_SIZE + STREAM_SIZE) {
+        printE ("A stream grew the buffer beyond its maximum size of %llu bytes\n",
+                (unsigned long long) adios_databuffer_get_max_size());
+        nerr++;
+    }
+
+    adios_databuffer_free (fd);
+    free (fd);
+    adios_databuffer_set_max_size (max_size);
+    return nerr;
+}
+
+int write_file (const unsigned char *compressible, const unsigned char *incompressible)
+{
+    int64_t       m_adios_group, fh, varid;
+    uint64_t      totalsize;
+    int           i, nc = COMPRESSIBLE_SIZE, ni = INCOMPRESSIBLE_SIZE;
+    char          name[64];
+
+    adios_set_max_buffer_size (512);
+    adios_declare_group (&m_adios_group, "transforms_stream", "", adios_stat_no);
+    adios_select_method (m_adios_group, "POSIX", "", "");
+    adios_define_var (m_adios_group, "nc", "", adios_integer, 0, 0, 0);
+    adios_define_var (m_adios_group, "ni", "", adios_integer, 0, 0, 0);
+    for (i = 0; i < NTRANSFORMS; i++) {
+        if (!transform_available (TRANSFORMS[i])) {
+            log ("%s is not available in this build, skip it\n", TRANSFORMS[i]);
+            continue;
+        }
+        snprintf (name, sizeof(name), "compressible_%s", TRANSFORMS[i]);
+        varid = adios_define_var (m_adios_group, name, "", adios_unsigned_byte, "nc", "nc", "0");
+        adios_set_transform (varid, TRANSFORMS[i]);
+        snprintf (name, sizeof(name), "incompressible_%s", TRANSFORMS[i]);
+        varid = adios_define_var (m_adios_group, name, "", adios_unsigned_byte, "ni", "ni", "0");
+        adios_set_transform (varid, TRANSFORMS[i]);
+    }
+
+    log ("Write to %s\n", FILENAME);
+    adios_open (&fh, "transforms_stream", FILENAME, "w", comm);
+    // leave the arrays out of the group size, the buffer grows as they are written
+    adios_group_size (fh, 2*sizeof(int), &totalsize);
+    adios_write (fh, "nc", &nc);
+    adios_write (fh, "ni", &ni);
+    for (i = 0; i < NTRANSFORMS; i++) {
+        if (!transform_available (TRANSFORMS[i]))
+            continue;
+        snprintf (name, sizeof(name), "compressible_%s", TRANSFORMS[i]);
+        adios_write (fh, name, (void *) compressible);
+        snprintf (name, sizeof(name), "incompressible_%s", TRANSFORMS[i]);
+        adios_write (fh, name, (void *) incompressible);
+    }
+    if (adios_close (fh)) {
+        printE ("Writing failed: %s\n", adios_errmsg());
+        return 1;
+    }
+    return 0;
+}
+
+/* Read back one array, check its values and whether it was stored compressed */
+static int check_var (ADIOS_FILE *f, const char *name, const unsigned char *data,
+                      uint64_t n, int compressed, unsigned char *rdata)
+{
+    int nerr = 0;
+    uint64_t start = 0, count = n;
+    ADIOS_VARINFO *vi = adios_inq_var (f, name);
+    if (!vi) {
+        printE ("%s is missing: %s\n", name, adios_errmsg());
+        return 1;
+    }
+
+    // metadata: original size (uint64_t) + compression success flag (char)
+    ADIOS_VARTRANSFORM *vt = adios_inq_var_transform (f, vi);
+    if (vt->transform_type == NO_TRANSFORM ||
+        vt->transform_metadatas[0].length < sizeof(uint64_t) + 1) {
+        printE ("%s was written without its transform\n", name);
+        nerr++;
+    } else if (((const char *) vt->transform_metadatas[0].content)[sizeof(uint64_t)] != compressed) {
+        printE ("%s was stored %s\n", name, (compressed ? "as is" : "compressed"));
+        nerr++;
+    }
+    adios_free_var_transform (vt);
+
+    ADIOS_SELECTION *sel = adios_selection_boundingbox (1, &start, &count);
+    memset (rdata, 0, n);
+    adios_schedule_read_byid (f, sel, vi->varid, 0, 1, rdata);
+    if (adios_perform_reads (f, 1)) {
+        printE ("Reading %s failed: %s\n", name, adios_errmsg());
+        nerr++;
+    } else if (memcmp (rdata, data, n)) {
+        printE ("%s was read back wrong\n", name);
+        nerr++;
+    }
+    adios_selection_delete (sel);
+    adios_free_varinfo (vi);
+
+    if (!nerr) {
+        log ("    %s as expected\n", name);
+    }
+    return nerr;
+}
+
+int read_file (const unsigned char *compressible, const unsigned char *incompressible)
+{
+    ADIOS_FILE * f;
+    int nerr = 0, i;
+    char name[64];
+    unsigned char *rdata = malloc (COMPRESSIBLE_SIZE);
+
+    log ("Read from %s\n", FILENAME);
+    f = adios_read_open_file (FILENAME, ADIOS_READ_METHOD_BP, comm);
+    if (f == NULL) {
+        printE ("Error at opening file: %s\n", adios_errmsg());
+        free (rdata);
+        return 1;
+    }
+
+    for (i = 0; i < NTRANSFORMS; i++) {
+        if (!transform_available (TRANSFORMS[i]))
+            continue;
+        snprintf (name, sizeof(name), "compressible_%s", TRANSFORMS[i]);
+        nerr += check_var (f, name, compressible, COMPRESSIBLE_SIZE, 1, rdata);
+        snprintf (name, sizeof(name), "incompressible_%s", TRANSFORMS[i]);
+        nerr += check_var (f, name, incompressible, INCOMPRESSIBLE_SIZE, 0, rdata);
+    }
+
+    adios_read_close (f);
+    free (rdata);
+    return nerr;
+}
@@ -0,0 +1,171 @@
+/*
+ * ADIOS is freely available under the terms of the BSD license described
+ * in the COPYING file in the top level directory of this source distribution.
+ *
+ * Copyright (c) 2008 - 2009.  UT-BATTELLE, LLC. All rights reserved.
+ */
+
+/* ADIOS C test:
+ *  Write 1D arrays with data transforms that cannot handle their data:
+ *  a floating point compressor on integers, alone or as a pipeline stage,
+ *  and as a pipeline stage after the first, which gets bytes even for doubles.
+ *  These variables must be written without a transform instead of being left
+ *  out of the file. A double array with a valid pipeline is written too.
+ *
+ *  Then read back every variable, check its values and which transform
+ *  was applied to it.
+ *
+ * How to run: ./transforms_unsupported_type
+ * Output: transforms_unsupported_type.bp
+ *
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include "public/adios.h"
+#include "public/adios_read.h"
+#include "public/adios_read_ext.h"
+
+#ifdef DMALLOC
+#include "dmalloc.h"
+#endif
+
+#define log(...) fprintf (stderr, "[rank=%3.3d, line %d]: ", rank, __LINE__); fprintf (stderr, __VA_ARGS__); fflush(stderr);
+#define printE(...) fprintf (stderr, "[rank=%3.3d, line %d]: ERROR: ", rank, __LINE__); fprintf (stderr, __VA_ARGS__); fflush(stderr);
+
+static const char FILENAME[] = "transforms_unsupported_type.bp";
+
+#define NX 1000
+int    ints[NX];
+double doubles[NX];
+
+MPI_Comm    comm = MPI_COMM_SELF; // dummy comm for sequential code
+int rank;
+int size;
+
+/* The variables, their type and transform, and whether the transform is kept */
+struct test_var {
+    const char *name;
+    enum ADIOS_DATATYPES type;
+    const char *transform;
+    int transformed;
+} VARS[] = {
+    { "ints_shuffle_zfp",      adios_integer, "shuffle|zfp:accuracy=0.001", 0 },
+    { "ints_fpred",            adios_integer, "fpred",                      0 },
+    { "doubles_shuffle_zfp",   adios_double,  "shuffle|zfp:accuracy=0.001", 0 },
+    { "doubles_fpred_shuffle", adios_double,  "fpred|shuffle",              1 },
+};
+#define NVARS (int)(sizeof(VARS) / sizeof(VARS[0]))
+
+int write_file ();
+int read_file ();
+
+int main (int argc, char ** argv)
+{
+    int err, i;
+
+    MPI_Init (&argc, &argv);
+    MPI_Comm_rank (comm, &rank);
+    MPI_Comm_size (comm, &size);
+
+    for (i = 0; i < NX; i++) {
+        ints[i] = 3*i - 1000;
+        doubles[i] = 0.25*i + 1.0/(i+1);
+    }
+
+    adios_init_noxml (comm);
+    err = adios_read_init_method(ADIOS_READ_METHOD_BP, comm, "verbose=2");
+    if (err) {
+        printE ("%s\n", adios_errmsg());
+    }
+
+    err = write_file ();
+    if (!err)
+        err = read_file ();
+
+    adios_read_finalize_method (ADIOS_READ_METHOD_BP);
+    adios_finalize (rank);
+    MPI_Finalize ();
+    return err;
+}
+
+int write_file ()
+{
+    int64_t       m_adios_group, fh;
+    uint64_t      totalsize;
+    int           i, nx = NX;
+
+    adios_declare_group (&m_adios_group, "unsupported_type", "", adios_stat_default);
+    adios_select_method (m_adios_group, "POSIX", "", "");
+    adios_define_var (m_adios_group, "nx", "", adios_integer, 0, 0, 0);
+    for (i = 0; i < NVARS; i++) {
+        int64_t varid = adios_define_var (m_adios_group, VARS[i].name, "", VARS[i].type, "nx", "nx", "0");
+        adios_set_transform (varid, VARS[i].transform);
+    }
+
+    log ("Write to %s\n", FILENAME);
+    adios_open (&fh, "unsupported_type", FILENAME, "w", comm);
+    adios_group_size (fh, sizeof(int) + NVARS * NX * sizeof(double), &totalsize);
+    adios_write (fh, "nx", &nx);
+    for (i = 0; i < NVARS; i++)
+        adios_write (fh, VARS[i].name, VARS[i].type == adios_integer ? (void *) ints : (void *) doubles);
+    if (adios_close (fh)) {
+        printE ("Writing failed: %s\n", adios_errmsg());
+        return 1;
+    }
+    return 0;
+}
+
+int read_file ()
+{
+    ADIOS_FILE * f;
+    int nerr = 0, i, j;
+    int    rints[NX];
+    double rdoubles[NX];
+    uint64_t start = 0, count = NX;
+
+    log ("Read from %s\n", FILENAME);
+    f = adios_read_open_file (FILENAME, ADIOS_READ_METHOD_BP, comm);
+    if (f == NULL) {
+        printE ("Error at opening file: %s\n", adios_errmsg());
+        return 1;
+    }
+
+    ADIOS_SELECTION *sel = adios_selection_boundingbox (1, &start, &count);
+    for (i = 0; i < NVARS; i++) {
+        ADIOS_VARINFO *vi = adios_inq_var (f, VARS[i].name);
+        if (!vi) {
+            printE ("%s with transform \"%s\" is missing: %s\n", VARS[i].name, VARS[i].transform, adios_errmsg());
+            nerr++;
+            continue;
+        }
+
+        ADIOS_VARTRANSFORM *vt = adios_inq_var_transform (f, vi);
+        if ((vt->transform_type != NO_TRANSFORM) != VARS[i].transformed) {
+            printE ("%s was written %s transform \"%s\"\n", VARS[i].name,
+                    VARS[i].transformed ? "without" : "with", VARS[i].transform);
+            nerr++;
+        }
+        adios_free_var_transform (vt);
+
+        void *data = (VARS[i].type == adios_integer) ? (void *) rints : (void *) rdoubles;
+        adios_schedule_read_byid (f, sel, vi->varid, 0, 1, data);
+        adios_perform_reads (f, 1);
+        for (j = 0; j < NX; j++) {
+            if ((VARS[i].type == adios_integer) ? (rints[j] != ints[j]) : (rdoubles[j] != doubles[j])) {
+                printE ("%s[%d] was read back wrong\n", VARS[i].name, j);
+                nerr++;
+                break;
+            }
+        }
+        if (j == NX) {
+            log ("    %s with transform \"%s\" as expected\n", VARS[i].name, VARS[i].transform);
+        }
+        adios_free_varinfo (vi);
+    }
+    adios_selection_delete (sel);
+
+    adios_read_close (f);
+    return nerr;
+}
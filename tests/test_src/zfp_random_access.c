@@ -0,0 +1,286 @@
+/*
+ * ADIOS is freely available under the terms of the BSD license described
+ * in the COPYING file in the top level directory of this source distribution.
+ *
+ * Copyright (c) 2008 - 2009.  UT-BATTELLE, LLC. All rights reserved.
+ */
+
+/* ADIOS C test:
+ *  Write a 3D double array of N blocks along the slowest dimension, compressed
+ *  with transform="zfp:rate=R,random_access".
+ *  data[i,j,k] = sin(0.1*i) + cos(0.07*j) + 0.01*k (global coordinates)
+ *
+ *  Then read sub-boxes of it, which go through the random access decoder.
+ *  Each block is large enough that a box covering several layers of zfp
+ *  blocks is read with several byte ranges. Every sub-box must match the
+ *  same region of a whole array read, which decompresses the blocks in full.
+ *
+ * How to run: ./zfp_random_access <N>
+ * Output: zfp_random_access.bp
+ *
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <math.h>
+#include <errno.h>
+#include "public/adios.h"
+#include "public/adios_read.h"
+#include "public/adios_transform_methods.h"
+
+#ifdef DMALLOC
+#include "dmalloc.h"
+#endif
+
+#define log(...) fprintf (stderr, "[rank=%3.3d, line %d]: ", rank, __LINE__); fprintf (stderr, __VA_ARGS__); fflush(stderr);
+#define printE(...) fprintf (stderr, "[rank=%3.3d, line %d]: ERROR: ", rank, __LINE__); fprintf (stderr, __VA_ARGS__); fflush(stderr);
+
+/* user arguments */
+int N = 2;       // number of blocks
+
+static const char FILENAME[] = "zfp_random_access.bp";
+
+/* One 4x4x4 zfp block takes 64*64 bits = 512 bytes at rate 64, so a layer of
+ * 16x16 zfp blocks is 128KB, more than the gap that is merged into one read */
+#define RATE "64"
+#define LDIM1 12
+#define LDIM2 64
+#define LDIM3 62
+static const int ldim1 = LDIM1;
+static const int ldim2 = LDIM2;
+static const int ldim3 = LDIM3;
+int gdim1;
+int offs1;
+
+int64_t       m_adios_group;
+
+/* Variables to write */
+double a3[LDIM1*LDIM2*LDIM3];
+
+MPI_Comm    comm = MPI_COMM_SELF; // dummy comm for sequential code
+int rank;
+int size;
+
+#define DATA(i,j,k) (sin(0.1*(i)) + cos(0.07*(j)) + 0.01*(k))
+
+
+void fill_block ()
+{
+    int i, j, k, n = 0;
+    for (i=0; i<ldim1; i++)
+        for (j=0; j<ldim2; j++)
+            for (k=0; k<ldim3; k++)
+                a3[n++] = DATA(offs1+i, j, k);
+}
+
+
+void Usage()
+{
+    printf("Usage: zfp_random_access <N>\n"
+            "    <N>:       Number of blocks along the slowest dimension\n");
+}
+
+int zfp_available ();
+void define_vars ();
+int write_file ();
+int read_file ();
+
+int main (int argc, char ** argv)
+{
+    int err,i ;
+
+    MPI_Init (&argc, &argv);
+    MPI_Comm_rank (comm, &rank);
+    MPI_Comm_size (comm, &size);
+
+    if (argc == 1)
+    {
+        // this case is for the test harness. otherwise this should be calling for Usage();
+        printf("Running zfp_random_access <N=%d>\n", N);
+    }
+    else
+    {
+        errno = 0;
+        i = strtol (argv[1], NULL, 10);
+        if (errno || i < 1) { printf("Invalid 1st argument %s\n", argv[1]); Usage(); return 1;}
+        N = i;
+    }
+    gdim1 = N*ldim1;
+
+    adios_init_noxml (comm);
+    if (!zfp_available())
+    {
+        log ("zfp is not available in this build, nothing to test\n");
+        adios_finalize (rank);
+        MPI_Finalize ();
+        return 0;
+    }
+    err = adios_read_init_method(ADIOS_READ_METHOD_BP, comm, "verbose=2");
+    if (err) {
+        printE ("%s\n", adios_errmsg());
+    }
+
+    adios_declare_group (&m_adios_group, "zfp_random_access", "", adios_stat_default);
+    adios_select_method (m_adios_group, "POSIX", "", "");
+
+    define_vars();
+    err = write_file ();
+
+    if (!err)
+        err = read_file ();
+
+    adios_read_finalize_method (ADIOS_READ_METHOD_BP);
+    adios_finalize (rank);
+    MPI_Finalize ();
+    return err;
+}
+
+int zfp_available ()
+{
+    int i, found = 0;
+    ADIOS_AVAILABLE_TRANSFORM_METHODS *t = adios_available_transform_methods();
+    if (t) {
+        for (i=0; i<t->ntransforms; i++)
+            if (!strcmp (t->name[i], "zfp"))
+                found = 1;
+        adios_available_transform_methods_free (t);
+    }
+    return found;
+}
+
+void define_vars ()
+{
+    int i;
+
+    adios_define_var (m_adios_group, "ldim1", "", adios_integer, 0, 0, 0);
+    adios_define_var (m_adios_group, "ldim2", "", adios_integer, 0, 0, 0);
+    adios_define_var (m_adios_group, "ldim3", "", adios_integer, 0, 0, 0);
+    adios_define_var (m_adios_group, "gdim1", "", adios_integer, 0, 0, 0);
+    adios_define_var (m_adios_group, "offs1", "", adios_integer, 0, 0, 0);
+
+    for (i=0; i<N; i++) {
+        int64_t varid = adios_define_var (m_adios_group, "data", "", adios_double,
+                "ldim1,ldim2,ldim3", "gdim1,ldim2,ldim3", "offs1,0,0");
+        adios_set_transform (varid, "zfp:rate=" RATE ",random_access");
+    }
+}
+
+int write_file ()
+{
+    int64_t       fh;
+    uint64_t      groupsize=0, totalsize;
+    int           i;
+
+    log ("Write to %s\n", FILENAME);
+    adios_open (&fh, "zfp_random_access", FILENAME, "w", comm);
+
+    groupsize  = (3 + N*2) * sizeof(int);                   // dimensions
+    groupsize += N * ldim1 * ldim2 * ldim3 * sizeof(double); // 3D blocks
+    adios_group_size (fh, groupsize, &totalsize);
+
+    for (i=0; i<N; i++) {
+        offs1 = i*ldim1;
+        fill_block ();
+        adios_write (fh, "gdim1", &gdim1);
+        adios_write (fh, "ldim1", &ldim1);
+        adios_write (fh, "ldim2", &ldim2);
+        adios_write (fh, "ldim3", &ldim3);
+        adios_write (fh, "offs1", &offs1);
+        adios_write (fh, "data", a3);
+    }
+    adios_close (fh);
+    return 0;
+}
+
+
+/* Read box (start,count) and compare it to the same region of the whole array */
+static int check_box (ADIOS_FILE *f, const double *whole, uint64_t *start, uint64_t *count)
+{
+    int nerr = 0;
+    uint64_t i, j, k, n = 0;
+    double *box = malloc (count[0]*count[1]*count[2]*sizeof(double));
+    ADIOS_SELECTION *sel = adios_selection_boundingbox (3, start, count);
+
+    adios_schedule_read (f, sel, "data", 0, 1, box);
+    if (adios_perform_reads (f, 1)) {
+        printE ("Reading box {%" PRIu64 ",%" PRIu64 ",%" PRIu64 "} failed: %s\n",
+                start[0], start[1], start[2], adios_errmsg());
+        nerr++;
+    }
+    for (i = start[0]; !nerr && i < start[0]+count[0]; i++)
+        for (j = start[1]; j < start[1]+count[1]; j++)
+            for (k = start[2]; k < start[2]+count[2]; k++, n++)
+                if (box[n] != whole[(i*ldim2 + j)*ldim3 + k] && nerr++ < 10) {
+                    printE ("data[%" PRIu64 ",%" PRIu64 ",%" PRIu64 "] = %g in the box, %g in the whole array\n",
+                            i, j, k, box[n], whole[(i*ldim2 + j)*ldim3 + k]);
+                }
+    if (!nerr) {
+        log ("    box {%" PRIu64 ",%" PRIu64 ",%" PRIu64 "} + {%" PRIu64 ",%" PRIu64 ",%" PRIu64 "} as expected\n",
+                start[0], start[1], start[2], count[0], count[1], count[2]);
+    }
+    adios_selection_delete (sel);
+    free (box);
+    return nerr;
+}
+
+int read_file ()
+{
+    ADIOS_FILE * f;
+    int err=0;
+    uint64_t i, j, k, n = 0;
+    double maxdiff = 0.0;
+
+    log ("Read data from %s\n", FILENAME);
+    f = adios_read_open_file (FILENAME, ADIOS_READ_METHOD_BP, comm);
+    if (f == NULL) {
+        printE ("Error at opening file: %s\n", adios_errmsg());
+        return 1;
+    }
+
+    uint64_t wstart[3] = {0, 0, 0};
+    uint64_t wcount[3] = {gdim1, ldim2, ldim3};
+    double *whole = malloc (gdim1*ldim2*ldim3*sizeof(double));
+    ADIOS_SELECTION *wsel = adios_selection_boundingbox (3, wstart, wcount);
+    adios_schedule_read (f, wsel, "data", 0, 1, whole);
+    if (adios_perform_reads (f, 1)) {
+        printE ("Reading the whole array failed: %s\n", adios_errmsg());
+        err++;
+    }
+    adios_selection_delete (wsel);
+
+    // zfp is lossy, but not by much at this rate
+    for (i = 0; !err && i < gdim1; i++)
+        for (j = 0; j < ldim2; j++)
+            for (k = 0; k < ldim3; k++, n++)
+                if (fabs (whole[n] - DATA(i,j,k)) > maxdiff)
+                    maxdiff = fabs (whole[n] - DATA(i,j,k));
+    if (maxdiff > 1e-6) {
+        printE ("Whole array differs from the written data by up to %g\n", maxdiff);
+        err++;
+    }
+
+    if (!err) {
+        log ("  Read boxes covering several layers of zfp blocks, within and across blocks...\n");
+        uint64_t start1[3] = {1, 5, 7};
+        uint64_t count1[3] = {ldim1-2, 10, 9};
+        err += check_box (f, whole, start1, count1);
+        uint64_t start2[3] = {ldim1/2, 30, 0};
+        uint64_t count2[3] = {gdim1-ldim1, 3, ldim3};
+        err += check_box (f, whole, start2, count2);
+
+        log ("  Read boxes at the partial zfp blocks of the edges...\n");
+        uint64_t start3[3] = {0, ldim2-3, ldim3-5};
+        uint64_t count3[3] = {gdim1, 3, 5};
+        err += check_box (f, whole, start3, count3);
+
+        log ("  Read a single value...\n");
+        uint64_t start4[3] = {gdim1-1, 17, 41};
+        uint64_t count4[3] = {1, 1, 1};
+        err += check_box (f, whole, start4, count4);
+    }
+
+    free (whole);
+    adios_read_close(f);
+    return err;
+}
@@ -0,0 +1,772 @@
+/*
+ * ADIOS is freely available under the terms of the BSD license described
+ * in the COPYING file in the top level directory of this source distribution.
+ *
+ * Copyright (c) 2008 - 2009.  UT-BATTELLE, LLC. All rights reserved.
+ */
+
+/* ADIOS transform benchmark utility
+ *
+ *   Runs data transforms (compression, reduction) through the regular
+ *   adios_write / adios_close and adios_schedule_read / adios_perform_reads
+ *   paths on synthetic fields and on variables taken from existing BP files,
+ *   and reports for each (input, transform) pair
+ *     - the storage ratio (original size / stored size)
+ *     - compression and decompression throughput in GB/s
+ *     - the largest absolute error of the data read back
+ *     - the peak resident memory of the process during the run
+ *   as CSV or JSON.
+ *
+ * This is a sequential program but compiled with MPI to use libadios.a
+ */
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <stdint.h>
+#include <inttypes.h>
+#include <unistd.h>
+#include <string.h>
+#include <getopt.h>
+#include <errno.h>
+#include <math.h>
+#include <sys/time.h>
+#include <sys/resource.h>
+
+#include "mpi.h"
+#include "public/adios.h"
+#include "public/adios_read.h"
+#include "public/adios_read_ext.h"
+#include "public/adios_transform_methods.h"
+
+#define MAX_DIMS        3   /* dimensions of the synthetic fields */
+#define MAX_INPUT_DIMS 16   /* dimensions of variables read from files */
+#define MAX_SPECS      64
+#define MAX_INPUTS     64
+
+/* One data set to run the transforms on */
+struct bench_input {
+    char name[256];
+    enum ADIOS_DATATYPES type;
+    int ndim;
+    uint64_t dims[MAX_INPUT_DIMS];
+    uint64_t nelems;
+    uint64_t nbytes;
+    void *data;
+};
+
+struct bench_result {
+    uint64_t stored_bytes;
+    double compress_time;      /* best of the repetitions, seconds */
+    double decompress_time;
+    double max_error;
+    long peak_rss_kb;
+    const char *status;
+};
+
+enum output_format { FORMAT_CSV, FORMAT_JSON };
+
+/* Options */
+static const char *specs[MAX_SPECS];
+static int nspecs = 0;
+static char datasets[1024] = "smooth,turbulent,random,integer,sparse";
+static uint64_t field_dims[MAX_DIMS] = {128, 128, 64};
+static int field_ndim = 3;
+static enum ADIOS_DATATYPES field_type = adios_double;
+static const char *input_file = NULL;
+static const char *input_vars[MAX_INPUTS];
+static int ninput_vars = 0;
+static double error_bound = 1e-6;
+static int repeat = 3;
+static enum output_format format = FORMAT_CSV;
+static const char *output_file = NULL;
+static const char *workdir = ".";
+
+static struct option options[] = {
+    {"transform",   required_argument, NULL, 't'},
+    {"datasets",    required_argument, NULL, 'd'},
+    {"dims",        required_argument, NULL, 'n'},
+    {"type",        required_argument, NULL, 'T'},
+    {"input",       required_argument, NULL, 'i'},
+    {"var",         required_argument, NULL, 'v'},
+    {"error-bound", required_argument, NULL, 'e'},
+    {"repeat",      required_argument, NULL, 'r'},
+    {"format",      required_argument, NULL, 'f'},
+    {"output",      required_argument, NULL, 'o'},
+    {"workdir",     required_argument, NULL, 'w'},
+    {"help",        no_argument,       NULL, 'h'},
+    {NULL,          0,                 NULL, 0}
+};
+
+static const char *optstring = "t:d:n:T:i:v:e:r:f:o:w:h";
+
+static void display_help(void)
+{
+    printf("Usage: adios_transform_bench [OPTIONS]\n"
+           "\n"
+           "Run data transforms through the ADIOS write and read paths and report\n"
+           "storage ratio, throughput, error and peak memory.\n"
+           "\n"
+           "  --transform   | -t SPEC    Transform spec to run, e.g. zlib:9 or zfp:accuracy=1e-4.\n"
+           "                             Can be given several times. Default: every\n"
+           "                             available transform with default parameters.\n"
+           "  --datasets    | -d LIST    Comma separated synthetic fields to generate:\n"
+           "                             smooth, turbulent, random, integer, sparse, or\n"
+           "                             none (default: all of them)\n"
+           "  --dims        | -n DIMS    Size of the synthetic fields, 1 to 3 dimensions,\n"
+           "                             slowest first, e.g. 1048576 or 256x256x64\n"
+           "                             (default: 128x128x64)\n"
+           "  --type        | -T TYPE    float or double, type of the floating point\n"
+           "                             fields (default: double)\n"
+           "  --input       | -i FILE    BP file to take variables from\n"
+           "  --var         | -v NAME    Variable of FILE to run on (first step, first\n"
+           "                             block of local arrays). Can be given several times.\n"
+           "  --error-bound | -e BOUND   Absolute error bound used in the default specs\n"
+           "                             of the lossy transforms (default: 1e-6)\n"
+           "  --repeat      | -r N       Repeat each write and read N times and report\n"
+           "                             the fastest (default: 3)\n"
+           "  --format      | -f FORMAT  csv or json (default: csv)\n"
+           "  --output      | -o FILE    Write the results to FILE instead of stdout\n"
+           "  --workdir     | -w DIR     Directory for the temporary BP files (default: .)\n"
+           "  --help        | -h         Print this help\n"
+           "\n"
+           "Transforms that only handle floating point data are skipped on integer inputs.\n"
+           "The peak memory column is the high water mark of the resident set size of\n"
+           "the whole process over one (input, transform) run.\n");
+}
+
+/*
+ * Timing and memory
+ */
+static double now(void)
+{
+    struct timeval tv;
+    gettimeofday(&tv, NULL);
+    return tv.tv_sec + tv.tv_usec * 1e-6;
+}
+
+/* Resets the peak RSS counter where the kernel supports it (Linux >= 4.0) */
+static void reset_peak_rss(void)
+{
+    FILE *f = fopen("/proc/self/clear_refs", "w");
+    if (f) {
+        fputs("5", f);
+        fclose(f);
+    }
+}
+
+/* Peak RSS in kB: VmHWM from /proc, or the lifetime maximum from getrusage */
+static long get_peak_rss_kb(void)
+{
+    char line[256];
+    long kb = -1;
+    FILE *f = fopen("/proc/self/status", "r");
+    if (f) {
+        while (fgets(line, sizeof(line), f)) {
+            if (!strncmp(line, "VmHWM:", 6)) {
+                kb = strtol(line + 6, NULL, 10);
+                break;
+            }
+        }
+        fclose(f);
+    }
+    if (kb < 0) {
+        struct rusage ru;
+        if (!getrusage(RUSAGE_SELF, &ru))
+            kb = ru.ru_maxrss;
+    }
+    return kb;
+}
+
+/*
+ * Synthetic fields
+ */
+static uint64_t rng_state = 0x9E3779B97F4A7C15ULL;
+
+static uint64_t rng_next(void)
+{
+    /* xorshift64*, so runs are reproducible across platforms */
+    rng_state ^= rng_state >> 12;
+    rng_state ^= rng_state << 25;
+    rng_state ^= rng_state >> 27;
+    return rng_state * 0x2545F4914F6CDD1DULL;
+}
+
+/* Uniform in [0,1) */
+static double rng_uniform(void)
+{
+    return (rng_next() >> 11) * (1.0 / 9007199254740992.0);
+}
+
+static void set_value(void *data, enum ADIOS_DATATYPES type, uint64_t i, double v)
+{
+    switch (type) {
+        case adios_real:    ((float *)data)[i] = (float)v; break;
+        case adios_double:  ((double *)data)[i] = v; break;
+        case adios_integer: ((int32_t *)data)[i] = (int32_t)v; break;
+        default: break;
+    }
+}
+
+/* Normalized coordinates of element i of the field, one per dimension */
+static void field_coords(uint64_t i, double *x)
+{
+    int d;
+    for (d = MAX_DIMS - 1; d >= 0; d--) {
+        if (d < field_ndim) {
+            uint64_t n = field_dims[d];
+            x[d] = n > 1 ? (double)(i % n) / (n - 1) : 0.0;
+            i /= n;
+        } else {
+            x[d] = 0.0;
+        }
+    }
+}
+
+static int generate_field(const char *name, struct bench_input *in)
+{
+    const double twopi = 2.0 * M_PI;
+    const int noctaves = 8;
+    double phase[8][MAX_DIMS];
+    double x[MAX_DIMS];
+    double v = 0.0;
+    uint64_t i;
+    int d, o;
+
+    memset(in, 0, sizeof(*in));
+    snprintf(in->name, sizeof(in->name), "%s", name);
+    in->ndim = field_ndim;
+    in->nelems = 1;
+    for (d = 0; d < field_ndim; d++) {
+        in->dims[d] = field_dims[d];
+        in->nelems *= field_dims[d];
+    }
+    in->type = strcmp(name, "integer") ? field_type : adios_integer;
+    in->nbytes = in->nelems * adios_type_size(in->type, NULL);
+    in->data = malloc(in->nbytes);
+    if (!in->data) {
+        fprintf(stderr, "Error: cannot allocate %" PRIu64 " bytes for field %s\n", in->nbytes, name);
+        return 1;
+    }
+
+    rng_state = 0x9E3779B97F4A7C15ULL;
+    for (o = 0; o < noctaves; o++)
+        for (d = 0; d < MAX_DIMS; d++)
+            phase[o][d] = twopi * rng_uniform();
+
+    for (i = 0; i < in->nelems; i++) {
+        field_coords(i, x);
+        if (!strcmp(name, "smooth")) {
+            v = sin(twopi * x[0]) * cos(twopi * x[1]) + 0.5 * sin(twopi * (x[1] + x[2]));
+        } else if (!strcmp(name, "turbulent")) {
+            /* octaves of sines with a k^-5/3 spectrum plus a little noise */
+            double k = 1.0;
+            v = 0.0;
+            for (o = 0; o < noctaves; o++, k *= 2.0) {
+                v += pow(k, -5.0 / 3.0) * sin(twopi * k * x[0] + phase[o][0])
+                                        * sin(twopi * k * x[1] + phase[o][1])
+                                        * sin(twopi * k * x[2] + phase[o][2]);
+            }
+            v += 1e-3 * (rng_uniform() - 0.5);
+        } else if (!strcmp(name, "random")) {
+            v = 2.0 * rng_uniform() - 1.0;
+        } else if (!strcmp(name, "integer")) {
+            /* slowly increasing counters, like ids or particle indices */
+            v = (i == 0) ? 0.0 : v + (double)(rng_next() % 4);
+        } else if (!strcmp(name, "sparse")) {
+            v = rng_uniform() < 0.05 ? 2.0 * rng_uniform() - 1.0 : 0.0;
+        } else {
+            fprintf(stderr, "Error: unknown data set '%s'\n", name);
+            free(in->data);
+            in->data = NULL;
+            return 1;
+        }
+        set_value(in->data, in->type, i, v);
+    }
+    return 0;
+}
+
+static int is_numeric_type(enum ADIOS_DATATYPES type)
+{
+    switch (type) {
+        case adios_byte: case adios_short: case adios_integer: case adios_long:
+        case adios_unsigned_byte: case adios_unsigned_short:
+        case adios_unsigned_integer: case adios_unsigned_long:
+        case adios_real: case adios_double: case adios_long_double:
+            return 1;
+        default:
+            return 0;
+    }
+}
+
+static int is_float_type(enum ADIOS_DATATYPES type)
+{
+    return type == adios_real || type == adios_double || type == adios_long_double;
+}
+
+static double get_value(const void *data, enum ADIOS_DATATYPES type, uint64_t i)
+{
+    switch (type) {
+        case adios_byte:             return ((const int8_t *)data)[i];
+        case adios_short:            return ((const int16_t *)data)[i];
+        case adios_integer:          return ((const int32_t *)data)[i];
+        case adios_long:             return (double)((const int64_t *)data)[i];
+        case adios_unsigned_byte:    return ((const uint8_t *)data)[i];
+        case adios_unsigned_short:   return ((const uint16_t *)data)[i];
+        case adios_unsigned_integer: return ((const uint32_t *)data)[i];
+        case adios_unsigned_long:    return (double)((const uint64_t *)data)[i];
+        case adios_real:             return ((const float *)data)[i];
+        case adios_double:           return ((const double *)data)[i];
+        case adios_long_double:      return (double)((const long double *)data)[i];
+        default:                     return 0.0;
+    }
+}
+
+/* Reads the first step (and first block, for local arrays) of a variable of a BP file */
+static int read_input_var(ADIOS_FILE *fp, const char *varname, struct bench_input *in)
+{
+    ADIOS_VARINFO *vi;
+    ADIOS_SELECTION *sel;
+    uint64_t start[MAX_INPUT_DIMS];
+    int d, is_local = 0;
+
+    memset(in, 0, sizeof(*in));
+    vi = adios_inq_var(fp, varname);
+    if (!vi)
+        return 1;  /* the read library has printed the error */
+    if (vi->ndim < 1 || vi->ndim > MAX_INPUT_DIMS || !is_numeric_type(vi->type)) {
+        fprintf(stderr, "Error: variable %s is not a numeric array, skipped\n", varname);
+        adios_free_varinfo(vi);
+        return 1;
+    }
+    for (d = 0; d < vi->ndim; d++) {
+        if (vi->dims[d] == 0)
+            is_local = 1;
+    }
+    if (is_local) {
+        adios_inq_var_blockinfo(fp, vi);
+        for (d = 0; d < vi->ndim; d++)
+            in->dims[d] = vi->blockinfo[0].count[d];
+        sel = adios_selection_writeblock(0);
+    } else {
+        for (d = 0; d < vi->ndim; d++) {
+            in->dims[d] = vi->dims[d];
+            start[d] = 0;
+        }
+        sel = adios_selection_boundingbox(vi->ndim, start, in->dims);
+    }
+
+    snprintf(in->name, sizeof(in->name), "%s:%s", input_file, varname);
+    in->type = vi->type;
+    in->ndim = vi->ndim;
+    in->nelems = 1;
+    for (d = 0; d < vi->ndim; d++)
+        in->nelems *= in->dims[d];
+    in->nbytes = in->nelems * adios_type_size(in->type, NULL);
+    adios_free_varinfo(vi);
+
+    in->data = malloc(in->nbytes ? in->nbytes : 1);
+    if (!in->data) {
+        fprintf(stderr, "Error: cannot allocate %" PRIu64 " bytes for variable %s\n", in->nbytes, varname);
+        adios_selection_delete(sel);
+        return 1;
+    }
+    adios_schedule_read(fp, sel, varname, 0, 1, in->data);
+    adios_perform_reads(fp, 1);
+    adios_selection_delete(sel);
+    if (adios_errno) {
+        fprintf(stderr, "Error: cannot read variable %s: %s\n", varname, adios_errmsg());
+        free(in->data);
+        in->data = NULL;
+        return 1;
+    }
+    return 0;
+}
+
+/*
+ * The benchmark itself
+ */
+
+/* Transforms that only accept floating point data */
+static int is_float_only_transform(const char *spec)
+{
+    static const char *names[] = {"zfp", "sz", "fpred", "mgard", NULL};
+    size_t len = strcspn(spec, ":");
+    int i;
+    for (i = 0; names[i]; i++) {
+        if (strlen(names[i]) == len && !strncmp(spec, names[i], len))
+            return 1;
+    }
+    return 0;
+}
+
+static int run_one(const struct bench_input *in, const char *spec, int id, struct bench_result *res)
+{
+    char group_name[64], path[4096], dimstr[16 * MAX_INPUT_DIMS];
+    int64_t group, var, fd;
+    uint64_t total_size;
+    ADIOS_FILE *fp;
+    ADIOS_VARINFO *vi;
+    ADIOS_SELECTION *sel;
+    void *out;
+    double t;
+    uint64_t i;
+    int d, r, pos = 0;
+
+    memset(res, 0, sizeof(*res));
+    res->compress_time = res->decompress_time = HUGE_VAL;
+    res->status = "ok";
+
+    if (!is_float_type(in->type) && is_float_only_transform(spec)) {
+        res->status = "skipped";
+        return 0;
+    }
+
+    reset_peak_rss();
+
+    snprintf(group_name, sizeof(group_name), "bench%d", id);
+    snprintf(path, sizeof(path), "%s/adios_transform_bench_%d.bp", workdir, (int)getpid());
+    for (d = 0; d < in->ndim; d++)
+        pos += snprintf(dimstr + pos, sizeof(dimstr) - pos, "%s%" PRIu64, d ? "," : "", in->dims[d]);
+
+    adios_declare_group(&group, group_name, "", adios_stat_no);
+    adios_select_method(group, "POSIX", "", "");
+    var = adios_define_var(group, "data", "", in->type, dimstr, "", "");
+    if (adios_set_transform(var, spec) || adios_errno) {
+        res->status = "failed";
+        return 0;
+    }
+
+    /* Write: only adios_write is timed, it runs the transform */
+    for (r = 0; r < repeat; r++) {
+        adios_errno = 0;
+        adios_open(&fd, group_name, path, "w", MPI_COMM_SELF);
+        /* Some transforms need room beyond their output size while encoding */
+        adios_group_size(fd, in->nbytes + in->nbytes / 8 + 65536, &total_size);
+        t = now();
+        adios_write(fd, "data", in->data);
+        t = now() - t;
+        adios_close(fd);
+        if (adios_errno) {
+            res->status = "failed";
+            unlink(path);
+            return 0;
+        }
+        if (t < res->compress_time)
+            res->compress_time = t;
+    }
+
+    fp = adios_read_open_file(path, ADIOS_READ_METHOD_BP, MPI_COMM_SELF);
+    if (!fp) {
+        res->status = "failed";
+        unlink(path);
+        return 0;
+    }
+
+    /* The physical view presents the variable as stored, i.e. transformed */
+    adios_read_set_data_view(fp, PHYSICAL_DATA_VIEW);
+    vi = adios_inq_var(fp, "data");
+    if (vi) {
+        adios_inq_var_blockinfo(fp, vi);
+        res->stored_bytes = adios_type_size(vi->type, NULL);
+        for (d = 0; d < vi->ndim; d++)
+            res->stored_bytes *= vi->blockinfo[0].count[d];
+        adios_free_varinfo(vi);
+    }
+    adios_read_set_data_view(fp, LOGICAL_DATA_VIEW);
+
+    /* Read: perform_reads reads the stored bytes and runs the inverse transform */
+    out = malloc(in->nbytes ? in->nbytes : 1);
+    sel = adios_selection_writeblock(0);
+    for (r = 0; r < repeat && out; r++) {
+        memset(out, 0, in->nbytes);
+        adios_errno = 0;
+        adios_schedule_read(fp, sel, "data", 0, 1, out);
+        t = now();
+        adios_perform_reads(fp, 1);
+        t = now() - t;
+        if (adios_errno) {
+            res->status = "failed";
+            break;
+        }
+        if (t < res->decompress_time)
+            res->decompress_time = t;
+    }
+    adios_selection_delete(sel);
+    adios_read_close(fp);
+    unlink(path);
+
+    if (!out) {
+        res->status = "failed";
+        return 0;
+    }
+    if (!strcmp(res->status, "ok") && memcmp(in->data, out, in->nbytes)) {
+        for (i = 0; i < in->nelems; i++) {
+            double a = get_value(in->data, in->type, i);
+            double b = get_value(out, in->type, i);
+            double e = fabs(a - b);
+            if (e > res->max_error || (isnan(e) && !(isnan(a) && isnan(b))))
+                res->max_error = isnan(e) ? HUGE_VAL : e;
+        }
+    }
+    free(out);
+    res->peak_rss_kb = get_peak_rss_kb();
+    return 0;
+}
+
+/*
+ * Output
+ */
+static int nresults = 0;
+
+static void print_header(FILE *out)
+{
+    if (format == FORMAT_CSV)
+        fprintf(out, "dataset,type,dims,transform,orig_bytes,stored_bytes,ratio,"
+                     "compress_GBps,decompress_GBps,max_abs_error,peak_rss_kb,status\n");
+    else
+        fprintf(out, "[");
+}
+
+static void print_result(FILE *out, const struct bench_input *in, const char *spec,
+                         const struct bench_result *res)
+{
+    char dimstr[24 * MAX_INPUT_DIMS];
+    double ratio = 0.0, cgbps = 0.0, dgbps = 0.0;
+    int d, pos = 0, ok = !strcmp(res->status, "ok");
+
+    for (d = 0; d < in->ndim; d++)
+        pos += snprintf(dimstr + pos, sizeof(dimstr) - pos, "%s%" PRIu64, d ? "x" : "", in->dims[d]);
+    if (ok) {
+        if (res->stored_bytes)
+            ratio = (double)in->nbytes / res->stored_bytes;
+        if (res->compress_time > 0 && res->compress_time != HUGE_VAL)
+            cgbps = in->nbytes / res->compress_time * 1e-9;
+        if (res->decompress_time > 0 && res->decompress_time != HUGE_VAL)
+            dgbps = in->nbytes / res->decompress_time * 1e-9;
+    }
+
+    if (format == FORMAT_CSV) {
+        fprintf(out, "%s,%s,%s,\"%s\",%" PRIu64 ",%" PRIu64 ",%.4f,%.4f,%.4f,%.6g,%ld,%s\n",
+                in->name, adios_type_to_string(in->type), dimstr, spec,
+                in->nbytes, res->stored_bytes, ratio, cgbps, dgbps,
+                res->max_error, res->peak_rss_kb, res->status);
+    } else {
+        fprintf(out, "%s\n  {\"dataset\": \"%s\", \"type\": \"%s\", \"dims\": \"%s\", \"transform\": \"%s\", "
+                     "\"orig_bytes\": %" PRIu64 ", \"stored_bytes\": %" PRIu64 ", \"ratio\": %.4f, "
+                     "\"compress_GBps\": %.4f, \"decompress_GBps\": %.4f, ",
+                nresults ? "," : "", in->name, adios_type_to_string(in->type), dimstr, spec,
+                in->nbytes, res->stored_bytes, ratio, cgbps, dgbps);
+        /* JSON has no infinity */
+        if (isinf(res->max_error))
+            fprintf(out, "\"max_abs_error\": null, ");
+        else
+            fprintf(out, "\"max_abs_error\": %.6g, ", res->max_error);
+        fprintf(out, "\"peak_rss_kb\": %ld, \"status\": \"%s\"}", res->peak_rss_kb, res->status);
+    }
+    nresults++;
+    fflush(out);
+}
+
+static void print_footer(FILE *out)
+{
+    if (format == FORMAT_JSON)
+        fprintf(out, "\n]\n");
+}
+
+/*
+ * Options
+ */
+static int parse_dims(const char *str)
+{
+    char *s = strdup(str), *tok, *saveptr = NULL;
+    int n = 0;
+    for (tok = strtok_r(s, "x,", &saveptr); tok; tok = strtok_r(NULL, "x,", &saveptr)) {
+        char *end;
+        unsigned long long v = strtoull(tok, &end, 10);
+        if (n == MAX_DIMS || *end || v == 0) {
+            free(s);
+            return 1;
+        }
+        field_dims[n++] = v;
+    }
+    free(s);
+    if (n == 0)
+        return 1;
+    field_ndim = n;
+    return 0;
+}
+
+/* Default spec list: every available transform with default parameters */
+static char default_specs[MAX_SPECS][64];
+
+static void set_default_specs(void)
+{
+    ADIOS_AVAILABLE_TRANSFORM_METHODS *t = adios_available_transform_methods();
+    int i;
+    if (!t)
+        return;
+    for (i = 0; i < t->ntransforms && nspecs < MAX_SPECS; i++) {
+        const char *name = t->name[i];
+        if (!strcmp(name, "pipeline"))  /* needs a list of stages */
+            continue;
+        if (!strcmp(name, "zfp"))
+            snprintf(default_specs[nspecs], 64, "zfp:accuracy=%g", error_bound);
+        else if (!strcmp(name, "sz"))
+            snprintf(default_specs[nspecs], 64, "sz:absErrBound=%g", error_bound);
+        else
+            snprintf(default_specs[nspecs], 64, "%s", name);
+        specs[nspecs] = default_specs[nspecs];
+        nspecs++;
+    }
+    adios_available_transform_methods_free(t);
+}
+
+int main(int argc, char **argv)
+{
+    struct bench_input inputs[MAX_INPUTS];
+    struct bench_result res;
+    FILE *out = stdout;
+    char *s, *tok, *saveptr = NULL;
+    uint64_t max_bytes = 0;
+    int ninputs = 0, i, j, c, id = 0, rank;
+
+    while ((c = getopt_long(argc, argv, optstring, options, NULL)) != -1) {
+        switch (c) {
+            case 't':
+                if (nspecs < MAX_SPECS)
+                    specs[nspecs++] = optarg;
+                break;
+            case 'd':
+                snprintf(datasets, sizeof(datasets), "%s", optarg);
+                break;
+            case 'n':
+                if (parse_dims(optarg)) {
+                    fprintf(stderr, "Error: invalid dimensions '%s'\n", optarg);
+                    return 1;
+                }
+                break;
+            case 'T':
+                if (!strcmp(optarg, "float"))
+                    field_type = adios_real;
+                else if (!strcmp(optarg, "double"))
+                    field_type = adios_double;
+                else {
+                    fprintf(stderr, "Error: type must be float or double\n");
+                    return 1;
+                }
+                break;
+            case 'i':
+                input_file = optarg;
+                break;
+            case 'v':
+                if (ninput_vars < MAX_INPUTS)
+                    input_vars[ninput_vars++] = optarg;
+                break;
+            case 'e':
+                error_bound = strtod(optarg, NULL);
+                break;
+            case 'r':
+                repeat = atoi(optarg);
+                if (repeat < 1)
+                    repeat = 1;
+                break;
+            case 'f':
+                if (!strcmp(optarg, "csv"))
+                    format = FORMAT_CSV;
+                else if (!strcmp(optarg, "json"))
+                    format = FORMAT_JSON;
+                else {
+                    fprintf(stderr, "Error: format must be csv or json\n");
+                    return 1;
+                }
+                break;
+            case 'o':
+                output_file = optarg;
+                break;
+            case 'w':
+                workdir = optarg;
+                break;
+            case 'h':
+                display_help();
+                return 0;
+            default:
+                display_help();
+                return 1;
+        }
+    }
+    if (ninput_vars && !input_file) {
+        fprintf(stderr, "Error: --var needs --input\n");
+        return 1;
+    }
+
+    MPI_Init(&argc, &argv);
+    MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+    if (rank) {
+        /* Sequential tool, extra processes have nothing to do */
+        MPI_Finalize();
+        return 0;
+    }
+
+    adios_init_noxml(MPI_COMM_SELF);
+    adios_read_init_method(ADIOS_READ_METHOD_BP, MPI_COMM_SELF, "");
+
+    if (!nspecs)
+        set_default_specs();
+
+    /* Inputs */
+    s = strdup(datasets);
+    for (tok = strtok_r(s, ",", &saveptr); tok && ninputs < MAX_INPUTS; tok = strtok_r(NULL, ",", &saveptr)) {
+        if (!strcmp(tok, "none"))
+            continue;
+        if (!generate_field(tok, &inputs[ninputs]))
+            ninputs++;
+    }
+    free(s);
+
+    if (input_file) {
+        ADIOS_FILE *fp = adios_read_open_file(input_file, ADIOS_READ_METHOD_BP, MPI_COMM_SELF);
+        if (!fp) {
+            fprintf(stderr, "Error: %s\n", adios_errmsg());
+        } else {
+            for (i = 0; i < ninput_vars && ninputs < MAX_INPUTS; i++) {
+                if (!read_input_var(fp, input_vars[i], &inputs[ninputs]))
+                    ninputs++;
+            }
+            adios_read_close(fp);
+        }
+    }
+
+    for (i = 0; i < ninputs; i++) {
+        if (inputs[i].nbytes > max_bytes)
+            max_bytes = inputs[i].nbytes;
+    }
+    /* Room for the largest input plus the worst case growth of a transform */
+    adios_set_max_buffer_size(2 * (max_bytes >> 20) + 16);
+
+    if (output_file) {
+        out = fopen(output_file, "w");
+        if (!out) {
+            fprintf(stderr, "Error: cannot open %s: %s\n", output_file, strerror(errno));
+            out = stdout;
+        }
+    }
+
+    print_header(out);
+    for (i = 0; i < ninputs; i++) {
+        for (j = 0; j < nspecs; j++) {
+            run_one(&inputs[i], specs[j], id++, &res);
+            print_result(out, &inputs[i], specs[j], &res);
+        }
+    }
+    print_footer(out);
+
+    if (out != stdout)
+        fclose(out);
+    for (i = 0; i < ninputs; i++)
+        free(inputs[i].data);
+
+    adios_read_finalize_method(ADIOS_READ_METHOD_BP);
+    adios_finalize(0);
+    MPI_Finalize();
+    return 0;
+}
@@ -1160,6 +1160,19 @@ void print_vars_index (struct adios_index_var_struct_v1 * vars_root)
                 int j;
 
                 printf ("\tTransform type: %s (ID = %hhu)", adios_transform_plugin_desc(transform->transform_type), transform->transform_type);
+                // Pipelines, and the chain auto chose for this block, are recorded as pipeline metadata
+                if (transform->transform_type == adios_transform_pipeline ||
+                    transform->transform_type == adios_transform_auto) {
+                    struct adios_transform_pipeline_stage stages[ADIOS_TRANSFORM_PIPELINE_MAX_STAGES];
+                    int nstages = adios_transform_pipeline_parse_metadata(transform->transform_metadata,
+                                                                          transform->transform_metadata_len,
+                                                                          stages, ADIOS_TRANSFORM_PIPELINE_MAX_STAGES);
+                    printf (transform->transform_type == adios_transform_auto ? "\tChosen transform: " : "\tPipeline stages: ");
+                    for (j = 0; j < nstages; j++)
+                        printf ("%s%s", j ? "|" : "", adios_transform_plugin_primary_xml_alias(stages[j].transform_type));
+                    if (nstages < 0)
+                        printf ("(invalid)");
+                }
                 printf ("\tPre-transform datatype: %s", adios_type_to_string_int(transform->pre_transform_type));
                 printf ("\tPre-transform dims (l:g:o): (");
                 for (j = 0; j < dims->count; j++)
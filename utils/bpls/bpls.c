@@ -1040,7 +1040,7 @@ int print_data_hist(ADIOS_VARINFO * vi, char * varname)
         }
         else     
         {
-            fprintf(out_hist, "%.2lf Inf %u\n", h->breaks[i], h->gfrequencies[i]);
+            fprintf(out_hist, "%.2lf Inf %u\n", h->breaks[i - 1], h->gfrequencies[i]);
             sprintf(str, ", \"Inf\" pos(%d)", i); 
         }
         strcat(xtics, str);
@@ -1313,26 +1313,35 @@ int readVar(ADIOS_FILE *fp, ADIOS_VARINFO *vi, const char * name, bool timed)
             printf("  read %d elems\n", actualreadn);
         }
 
-        // read a slice finally
-        ADIOS_SELECTION *sel = adios_selection_boundingbox (vi->ndim, s+tidx, c+tidx);
-        if (timed) {
-            status = adios_schedule_read_byid (fp, sel, vi->varid, s[0], c[0], data); 
-        } else {
-            status = adios_schedule_read_byid (fp, sel, vi->varid, 0, 1, data); 
+        // scalars over steps: values come from the metadata, no need to read
+        if (timed && vi->ndim == 0 && vi->type != adios_string &&
+            adios_inq_var_scalar_steps (fp, vi, s[0], c[0], 0, data) == 0)
+        {
+            status = 0;
         }
+        else
+        {
+            // read a slice finally
+            ADIOS_SELECTION *sel = adios_selection_boundingbox (vi->ndim, s+tidx, c+tidx);
+            if (timed) {
+                status = adios_schedule_read_byid (fp, sel, vi->varid, s[0], c[0], data); 
+            } else {
+                status = adios_schedule_read_byid (fp, sel, vi->varid, 0, 1, data); 
+            }
 
-        if (status < 0) {
-            fprintf(stderr, "Error when scheduling variable %s for reading. errno=%d : %s \n", name, adios_errno, adios_errmsg());
-            free(data);
-            return 11;
-        }
+            if (status < 0) {
+                fprintf(stderr, "Error when scheduling variable %s for reading. errno=%d : %s \n", name, adios_errno, adios_errmsg());
+                free(data);
+                return 11;
+            }
 
-        status = adios_perform_reads (fp, 1); // blocking read performed here
-        adios_selection_delete (sel);
-        if (status < 0) {
-            fprintf(stderr, "Error when reading variable %s. errno=%d : %s \n", name, adios_errno, adios_errmsg());
-            free(data);
-            return 11;
+            status = adios_perform_reads (fp, 1); // blocking read performed here
+            adios_selection_delete (sel);
+            if (status < 0) {
+                fprintf(stderr, "Error when reading variable %s. errno=%d : %s \n", name, adios_errno, adios_errmsg());
+                free(data);
+                return 11;
+            }
         }
 
         // print slice
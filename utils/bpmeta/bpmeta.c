@@ -23,6 +23,7 @@
 #include "adios_transport_hooks.h"
 #include "adios_bp_v1.h"
 #include "bp_utils.h"
+#include "qhashtbl.h"
 #include "adios_transforms_common.h" // NCSU ALACRITY-ADIOS
 #include "adios_transforms_read.h" // NCSU ALACRITY-ADIOS
 
@@ -38,11 +39,13 @@ int nthreads=1;  // Number of threads to use (main counts as 1 thread)
 char * filename; // process 'filename'.dir/'filename'.NNN subfiles and 
                  //   generate metadata file 'filename'
 int nsubfiles=0; // number of subfiles to process
+int incremental=0; // 1: add only the new PGs of the subfiles to existing 'filename'
 
 struct option options[] = {
     {"help",                 no_argument,          NULL,    'h'},
     {"verbose",              no_argument,          NULL,    'v'},
     {"nsubfiles",            required_argument,    NULL,    'n'},
+    {"incremental",          no_argument,          NULL,    'i'},
 #if HAVE_PTHREAD
     {"nthreads",             required_argument,    NULL,    't'},
 #endif
@@ -50,9 +53,9 @@ struct option options[] = {
 };
 
 #if HAVE_PTHREAD
-static const char *optstring = "hvn:t:";
+static const char *optstring = "hvin:t:";
 #else
-static const char *optstring = "hvn:";
+static const char *optstring = "hvin:";
 #endif
 
 // help function
@@ -63,17 +66,20 @@ void display_help() {
             "\nIt is used to generate the missing metadata file after using\n"
             "the MPI_AGGREGATE output method with 'have_metada_file=0' option.\n" 
             "\n"
-            "  --nsubfiles | -n <N>   The number of subfiles to process in\n"
-            "                           <filename>.dir\n"
+            "  --nsubfiles   | -n <N>   The number of subfiles to process in\n"
+            "                             <filename>.dir\n"
 #if HAVE_PTHREAD
-            "  --nthreads  | -t <T>   Parallel reading with <T> threads.\n"
-            "                           The main thread is counted in.\n"
+            "  --nthreads    | -t <T>   Parallel reading with <T> threads.\n"
+            "                             The main thread is counted in.\n"
 #endif
+            "  --incremental | -i       Update an existing metadata file <filename>\n"
+            "                             with the steps appended to the subfiles\n"
+            "                             since it was created.\n"
             "\n"
             "Help options\n"
-            "  --help      | -h       Print this help.\n"
-            "  --verbose   | -v       Print log about what this program is doing.\n"
-            "                           Use multiple -v to increase logging level.\n"
+            "  --help        | -h       Print this help.\n"
+            "  --verbose     | -v       Print log about what this program is doing.\n"
+            "                             Use multiple -v to increase logging level.\n"
             "Typical use: bpmeta -t 16 -n 1024 mydata.bp\n"
            );
 }
@@ -81,10 +87,50 @@ void display_help() {
 
 /* Global variables among threads */
 struct adios_bp_buffer_struct_v1 ** b = 0;
-  /* sub-index structure variables */
-struct adios_index_struct_v1 ** subindex;
+  /* index lists of each subfile, only attributes of subfile 0 are used */
+struct adios_index_process_group_struct_v1 ** sub_pg_roots = 0;
+struct adios_index_var_struct_v1 ** sub_vars_roots = 0;
+struct adios_index_attribute_struct_v1 * sub_attrs_root = 0;
+  /* incremental mode: per subfile, the largest offset already
+     indexed in the metadata file, -1 if nothing */
+int64_t * highwater = 0;
+  /* incremental mode: the PGs in the metadata file, sorted by compare_pg_keys.
+     A PG is identified by its writer, time index and offset since the PG
+     index does not record the subfile */
+struct pg_key
+{
+    uint32_t process_id;
+    uint32_t time_index;
+    uint64_t offset_in_file;
+};
+struct pg_key * indexed_pgs = 0;
+int nindexed_pgs = 0;
+  /* variables to be merged: var_runs[i] is the list of index items of
+     the same variable from the existing metadata file and from the subfiles */
+struct var_runs
+{
+    struct adios_index_var_struct_v1 ** runs;
+    int nruns;
+};
+struct var_runs * var_runs = 0;
+int nvar_runs = 0;
 
 int process_subfiles (int tid, int startidx, int endidx);
+int merge_vars (int tid);
+int read_index (int tid, char * fn, struct adios_bp_buffer_struct_v1 * buf,
+                struct adios_index_process_group_struct_v1 ** pg_root,
+                struct adios_index_var_struct_v1 ** vars_root,
+                struct adios_index_attribute_struct_v1 ** attrs_root);
+void collect_indexed_pgs (struct adios_index_process_group_struct_v1 * pg_root);
+void compute_highwater (int idx, struct adios_index_process_group_struct_v1 * pg_root);
+void drop_indexed_items (int idx,
+                         struct adios_index_process_group_struct_v1 ** pg_root,
+                         struct adios_index_var_struct_v1 ** vars_root,
+                         struct adios_index_attribute_struct_v1 ** attrs_root);
+struct adios_index_process_group_struct_v1 * merge_pg_lists (
+                         struct adios_index_process_group_struct_v1 ** roots, int n);
+struct adios_index_var_struct_v1 * collect_vars (
+                         struct adios_index_var_struct_v1 ** roots, int n);
 int write_index (struct adios_index_struct_v1 * index, char * fname);
 int get_nsubfiles (char *filename);
 void print_pg_index ( int tid, struct adios_index_process_group_struct_v1 * pg_root);
@@ -106,6 +152,14 @@ void * thread_main (void *arg)
     pthread_exit(NULL);
     return NULL; // just to avoid compiler warning
 }
+
+void * thread_merge_main (void *arg)
+{
+    struct thread_args *targ = (struct thread_args *) arg;
+    merge_vars (targ->tid);
+    pthread_exit(NULL);
+    return NULL; // just to avoid compiler warning
+}
 #endif
 
 
@@ -130,6 +184,10 @@ int main (int argc, char ** argv)
                     nthreads=tmp;
                 break;
 
+            case 'i':
+                incremental = 1;
+                break;
+
             case 'h':
                 display_help();
                 return 0;
@@ -173,12 +231,37 @@ int main (int argc, char ** argv)
     }
 
     if (verbose>1)
-        printf ("Create metadata file %s from %d subfiles using %d threads\n", 
-                filename, nsubfiles, nthreads);
+        printf ("%s metadata file %s from %d subfiles using %d threads\n", 
+                (incremental ? "Update" : "Create"), filename, nsubfiles, nthreads);
 
     /* Initialize global variables */
     b = malloc (nsubfiles * sizeof (struct adios_bp_buffer_struct_v1*));
-    subindex = malloc (nthreads * sizeof (struct adios_index_struct_v1*));
+    sub_pg_roots = calloc (nsubfiles+1, sizeof (struct adios_index_process_group_struct_v1*));
+    sub_vars_roots = calloc (nsubfiles+1, sizeof (struct adios_index_var_struct_v1*));
+    highwater = malloc (nsubfiles * sizeof (int64_t));
+    int i;
+    for (i=0; i<nsubfiles; i++)
+        highwater[i] = -1;
+
+    /* The existing metadata is the first of the nsubfiles+1 runs to be merged,
+       the subfile indexes follow in order */
+    struct adios_index_process_group_struct_v1 ** pg_runs = sub_pg_roots;
+    struct adios_index_var_struct_v1 ** vars_runs = sub_vars_roots;
+    struct adios_index_attribute_struct_v1 * old_attrs_root = 0;
+    sub_pg_roots++;
+    sub_vars_roots++;
+
+    if (incremental)
+    {
+        struct adios_bp_buffer_struct_v1 mb;
+        if (read_index (nthreads-1, filename, &mb, &pg_runs[0], &vars_runs[0], &old_attrs_root))
+        {
+            fprintf (stderr, "bpmeta: cannot read the existing metadata file %s. "
+                     "Run bpmeta without the -i option to create it.\n", filename);
+            return 1;
+        }
+        collect_indexed_pgs (pg_runs[0]);
+    }
 
     /* Split the processing work among T threads */
     int tid;
@@ -238,8 +321,6 @@ int main (int argc, char ** argv)
                 printf ("Thread %d: Joined thread.\n", tid);
         }
     }
-    free (targs);
-    free (thread);
 
 #else /* non-threaded version */
 
@@ -248,28 +329,94 @@ int main (int argc, char ** argv)
 
 #endif
 
-    /* Merge the T indexes into the global output index */
-    struct adios_index_struct_v1 * globalindex;
-    globalindex = adios_alloc_index_v1(1);
-    for (tid=0; tid<nthreads; tid++)
+    if (incremental)
+    {
+        int nnew = 0;
+        for (i=0; i<nsubfiles; i++)
+            if (sub_pg_roots[i])
+                nnew++;
+        if (!nnew)
+        {
+            printf ("No new process groups found in the subfiles, "
+                    "metadata file %s is up to date\n", filename);
+            struct adios_index_struct_v1 * oldindex = adios_alloc_index_v1(0);
+            oldindex->pg_root = pg_runs[0];
+            oldindex->vars_root = vars_runs[0];
+            oldindex->attrs_root = old_attrs_root;
+            adios_clear_index_v1 (oldindex);
+            adios_free_index_v1 (oldindex);
+            free (pg_runs);
+            free (vars_runs);
+            free (highwater);
+            free (indexed_pgs);
+            free (b);
+            return 0;
+        }
+    }
+
+    /* Merge the existing and the subfile indexes into the global output index.
+       Each list is sorted by time already, so a k-way merge of the lists 
+       keeps the time order. Variables are merged by the threads in parallel. */
+    struct adios_index_process_group_struct_v1 * pg_root;
+    struct adios_index_var_struct_v1 * vars_root;
+    pg_root = merge_pg_lists (pg_runs, nsubfiles+1);
+    vars_root = collect_vars (vars_runs, nsubfiles+1);
+
+#if HAVE_PTHREAD
+    for (tid=0; tid<nthreads-1; tid++)
     {
-        adios_merge_index_v1 (globalindex, 
-                              subindex[tid]->pg_root, 
-                              subindex[tid]->vars_root, 
-                              subindex[tid]->attrs_root, 1); 
+        pthread_attr_t attr;
+        pthread_attr_init (&attr);
+        pthread_attr_setdetachstate (&attr, PTHREAD_CREATE_JOINABLE);
+        rc = pthread_create (&thread[tid], &attr, thread_merge_main, &targs[tid]);
+        if (rc) {
+            printf ("ERROR: Thread %d: Cannot create thread, err code = %d\n", 
+                    tid, rc);
+        }
+        pthread_attr_destroy(&attr);
     }
+    merge_vars (nthreads-1);
+    for (tid=0; tid<nthreads-1; tid++)
+    {
+        void *status;
+        rc = pthread_join (thread[tid], &status);
+        if (rc) {
+            printf ("ERROR: Thread %d: Cannot join thread, err code = %d\n", tid, rc);
+        }
+    }
+    free (targs);
+    free (thread);
+#else
+    merge_vars (0);
+#endif
+
+    /* Attributes are only merged by name, new ones are added to the end */
+    struct adios_index_attribute_struct_v1 * attrs_root = old_attrs_root;
+    if (attrs_root)
+    {
+        struct adios_index_attribute_struct_v1 * a = attrs_root;
+        while (a->next)
+            a = a->next;
+        a->next = sub_attrs_root;
+    }
+    else
+    {
+        attrs_root = sub_attrs_root;
+    }
+
+    struct adios_index_struct_v1 * globalindex;
+    globalindex = adios_alloc_index_v1(1);
+    adios_merge_index_v1 (globalindex, pg_root, vars_root, attrs_root, 0);
     write_index (globalindex, filename);
 
     /* Clean-up */
     adios_clear_index_v1 (globalindex);
-    /*... already cleaned-up by globalindex clearing
-    for (tid=0; tid<nthreads; tid++) {
-        adios_clear_index_v1 (subindex[tid]);
-        free (subindex[tid]);
-    }
-    */
-    free (subindex);
-    free (globalindex);
+    adios_free_index_v1 (globalindex);
+    free (var_runs);
+    free (pg_runs);
+    free (vars_runs);
+    free (highwater);
+    free (indexed_pgs);
     free (b);
     return 0;
 }
@@ -358,90 +505,548 @@ int write_index (struct adios_index_struct_v1 * index, char * fname)
     return 0;
 }
 
-int process_subfiles (int tid, int startidx, int endidx)
+/* Read and parse the index of a BP file. Attributes are only read if 
+   attrs_root is not NULL. Returns 0 on success. */
+int read_index (int tid, char * fn, struct adios_bp_buffer_struct_v1 * buf,
+                struct adios_index_process_group_struct_v1 ** pg_root,
+                struct adios_index_var_struct_v1 ** vars_root,
+                struct adios_index_attribute_struct_v1 ** attrs_root)
 {
-    char fn[256];
     uint32_t version = 0;
-    int idx;
     int rc = 0;
 
-    subindex[tid] = adios_alloc_index_v1(1);
+    adios_buffer_struct_init (buf);
+
+    rc = adios_posix_open_read_internal (fn, "", buf);
+    if (!rc)
+    {
+        fprintf (stderr, "bpmeta: file not found: %s\n", fn);
+        return -1;
+    }
+
+    adios_posix_read_version (buf);
+    adios_parse_version (buf, &version);
+    version = version & ADIOS_VERSION_NUM_MASK;
+    if (verbose) {
+        //printf (DIVIDER);
+        printf ("Thread %d: Metadata of %s:\n", tid, fn);
+        printf ("Thread %d: BP format version: %d\n", tid, version);
+    }
+    if (version < 2)
+    {
+        fprintf (stderr, "bpmeta: This version of bpmeta can only work with BP format version 2 and up. "
+                "Use an older bpmeta from adios 1.6 to work with this file.\n");
+        adios_posix_close_internal (buf);
+        return -1;
+    }
+
+    *pg_root = 0;
+    *vars_root = 0;
+
+    adios_posix_read_index_offsets (buf);
+    adios_parse_index_offsets_v1 (buf);
+
+    /*
+       printf ("End of process groups       = %" PRIu64 "\n", b->end_of_pgs);
+       printf ("Process Groups Index Offset = %" PRIu64 "\n", b->pg_index_offset);
+       printf ("Process Groups Index Size   = %" PRIu64 "\n", b->pg_size);
+       printf ("Variable Index Offset       = %" PRIu64 "\n", b->vars_index_offset);
+       printf ("Variable Index Size         = %" PRIu64 "\n", b->vars_size);
+       printf ("Attribute Index Offset      = %" PRIu64 "\n", b->attrs_index_offset);
+       printf ("Attribute Index Size        = %" PRIu64 "\n", b->attrs_size);
+     */
+
+    adios_posix_read_process_group_index (buf);
+    adios_parse_process_group_index_v1 (buf, pg_root, NULL);
+    print_pg_index (tid, *pg_root);
+
+    adios_posix_read_vars_index (buf);
+    adios_parse_vars_index_v1 (buf, vars_root, NULL, NULL);
+    print_variable_index (tid, *vars_root);
+
+    if (attrs_root)
+    {
+        *attrs_root = 0;
+        adios_posix_read_attributes_index (buf);
+        adios_parse_attributes_index_v1 (buf, attrs_root);
+        print_attribute_index (tid, *attrs_root);
+    }
+
+    adios_posix_close_internal (buf);
+    adios_shared_buffer_free (buf);
+
+    return 0;
+}
+
+int process_subfiles (int tid, int startidx, int endidx)
+{
+    char fn[256];
+    int idx;
 
     for (idx=startidx; idx<=endidx; idx++) 
     {
         b[idx] = malloc (sizeof (struct adios_bp_buffer_struct_v1));
-        adios_buffer_struct_init (b[idx]);
 
         snprintf (fn, 256, "%s.dir/%s.%d", filename, filename, idx);
-        rc = adios_posix_open_read_internal (fn, "", b[idx]);
-        if (!rc)
+        // only read attributes from the very first file. we don't merge attributes any more
+        if (read_index (tid, fn, b[idx], &sub_pg_roots[idx], &sub_vars_roots[idx],
+                        (idx == 0 ? &sub_attrs_root : NULL)))
         {
-            fprintf (stderr, "bpmeta: file not found: %s\n", fn);
+            free (b[idx]);
             return -1;
         }
 
-        adios_posix_read_version (b[idx]);
-        adios_parse_version (b[idx], &version);
-        version = version & ADIOS_VERSION_NUM_MASK;
-        if (verbose) {
-            //printf (DIVIDER);
-            printf ("Thread %d: Metadata of %s:\n", tid, fn);
-            printf ("Thread %d: BP format version: %d\n", tid, version);
+        if (incremental)
+        {
+            compute_highwater (idx, sub_pg_roots[idx]);
+            drop_indexed_items (idx, &sub_pg_roots[idx], &sub_vars_roots[idx],
+                                (idx == 0 ? &sub_attrs_root : NULL));
         }
-        if (version < 2)
+
+        free (b[idx]);
+    }
+
+    if (verbose>1) {
+        //printf (DIVIDER);
+        printf ("Thread %d: End of reading all subfiles\n", tid);
+    }
+
+
+    return 0;
+}
+
+static int compare_pg_keys (const void * a, const void * b)
+{
+    const struct pg_key * k1 = (const struct pg_key *) a;
+    const struct pg_key * k2 = (const struct pg_key *) b;
+    if (k1->process_id != k2->process_id)
+        return (k1->process_id < k2->process_id ? -1 : 1);
+    if (k1->time_index != k2->time_index)
+        return (k1->time_index < k2->time_index ? -1 : 1);
+    if (k1->offset_in_file != k2->offset_in_file)
+        return (k1->offset_in_file < k2->offset_in_file ? -1 : 1);
+    return 0;
+}
+
+/* Record the PGs of the existing metadata file */
+void collect_indexed_pgs (struct adios_index_process_group_struct_v1 * pg_root)
+{
+    struct adios_index_process_group_struct_v1 * pg;
+    int n = 0;
+
+    for (pg = pg_root; pg; pg = pg->next)
+        n++;
+    indexed_pgs = malloc (n * sizeof (struct pg_key));
+    for (pg = pg_root; pg; pg = pg->next)
+    {
+        indexed_pgs[nindexed_pgs].process_id = pg->process_id;
+        indexed_pgs[nindexed_pgs].time_index = pg->time_index;
+        indexed_pgs[nindexed_pgs].offset_in_file = pg->offset_in_file;
+        nindexed_pgs++;
+    }
+    qsort (indexed_pgs, nindexed_pgs, sizeof (struct pg_key), compare_pg_keys);
+}
+
+/* The largest offset in subfile 'idx' that is already in the metadata file.
+   The metadata file was made when the subfile ended before its first PG
+   that is not in it, so everything up to there is indexed, including the
+   PGs without any variables or attributes. */
+void compute_highwater (int idx, struct adios_index_process_group_struct_v1 * pg_root)
+{
+    struct adios_index_process_group_struct_v1 * pg;
+    struct pg_key key;
+    int nold = 0, nnew = 0;
+    uint64_t first_new = 0;
+
+    for (pg = pg_root; pg; pg = pg->next)
+    {
+        key.process_id = pg->process_id;
+        key.time_index = pg->time_index;
+        key.offset_in_file = pg->offset_in_file;
+        if (bsearch (&key, indexed_pgs, nindexed_pgs, sizeof (struct pg_key), compare_pg_keys))
         {
-            fprintf (stderr, "bpmeta: This version of bpmeta can only work with BP format version 2 and up. "
-                    "Use an older bpmeta from adios 1.6 to work with this file.\n");
-            adios_posix_close_internal (b[idx]);
-            return -1;
+            nold++;
+        }
+        else if (!nnew++ || pg->offset_in_file < first_new)
+        {
+            first_new = pg->offset_in_file;
         }
+    }
 
-        struct adios_index_process_group_struct_v1 * new_pg_root = 0;
-        struct adios_index_var_struct_v1 * new_vars_root = 0;
-        struct adios_index_attribute_struct_v1 * new_attrs_root = 0;
+    if (!nold)
+        highwater[idx] = -1; // the whole subfile is new
+    else if (!nnew)
+        highwater[idx] = INT64_MAX; // nothing new in the subfile
+    else
+        highwater[idx] = (int64_t) first_new - 1;
+}
 
-        adios_posix_read_index_offsets (b[idx]);
-        adios_parse_index_offsets_v1 (b[idx]);
+/* Keep only the PGs, variable blocks and attributes of subfile 'idx'
+   that are beyond its high-water offset, and free the rest */
+void drop_indexed_items (int idx,
+                         struct adios_index_process_group_struct_v1 ** pg_root,
+                         struct adios_index_var_struct_v1 ** vars_root,
+                         struct adios_index_attribute_struct_v1 ** attrs_root)
+{
+    int64_t hw = highwater[idx];
+    uint64_t i, n;
+    struct adios_index_struct_v1 * dropped;
 
-        /*
-           printf ("End of process groups       = %" PRIu64 "\n", b->end_of_pgs);
-           printf ("Process Groups Index Offset = %" PRIu64 "\n", b->pg_index_offset);
-           printf ("Process Groups Index Size   = %" PRIu64 "\n", b->pg_size);
-           printf ("Variable Index Offset       = %" PRIu64 "\n", b->vars_index_offset);
-           printf ("Variable Index Size         = %" PRIu64 "\n", b->vars_size);
-           printf ("Attribute Index Offset      = %" PRIu64 "\n", b->attrs_index_offset);
-           printf ("Attribute Index Size        = %" PRIu64 "\n", b->attrs_size);
-         */
+    if (hw < 0)
+        return; // the whole subfile is new
 
-        adios_posix_read_process_group_index (b[idx]);
-        adios_parse_process_group_index_v1 (b[idx], &new_pg_root, NULL);
-        print_pg_index (tid, new_pg_root);
+    dropped = adios_alloc_index_v1(0);
 
-        adios_posix_read_vars_index (b[idx]);
-        adios_parse_vars_index_v1 (b[idx], &new_vars_root, NULL, NULL);
-        print_variable_index (tid, new_vars_root);
+    struct adios_index_process_group_struct_v1 ** pg = pg_root;
+    while (*pg)
+    {
+        struct adios_index_process_group_struct_v1 * next = (*pg)->next;
+        if ((int64_t) (*pg)->offset_in_file <= hw)
+        {
+            (*pg)->next = dropped->pg_root;
+            dropped->pg_root = *pg;
+            *pg = next;
+        }
+        else
+        {
+            pg = &(*pg)->next;
+        }
+    }
 
-        if (idx == 0)
+    struct adios_index_var_struct_v1 ** v = vars_root;
+    while (*v)
+    {
+        struct adios_index_var_struct_v1 * old = 
+            (struct adios_index_var_struct_v1 *) calloc (1, sizeof (struct adios_index_var_struct_v1));
+        old->type = (*v)->type;
+        old->characteristics = malloc ((*v)->characteristics_count * 
+                                       sizeof (struct adios_index_characteristic_struct_v1));
+        n = 0;
+        for (i = 0; i < (*v)->characteristics_count; i++)
         {
-            // only read attributes from the very first file. we don't merge attributes any more
-            adios_posix_read_attributes_index (b[idx]);
-            adios_parse_attributes_index_v1 (b[idx], &new_attrs_root);
-            print_attribute_index (tid, new_attrs_root);
+            if ((int64_t) (*v)->characteristics[i].offset <= hw)
+            {
+                memcpy (&old->characteristics[old->characteristics_count++],
+                        &(*v)->characteristics[i],
+                        sizeof (struct adios_index_characteristic_struct_v1));
+            }
+            else
+            {
+                if (n != i)
+                    memcpy (&(*v)->characteristics[n], &(*v)->characteristics[i],
+                            sizeof (struct adios_index_characteristic_struct_v1));
+                n++;
+            }
+        }
+        (*v)->characteristics_count = n;
+        if (old->characteristics_count)
+        {
+            old->next = dropped->vars_root;
+            dropped->vars_root = old;
+        }
+        else
+        {
+            free (old->characteristics);
+            free (old);
         }
 
-        adios_merge_index_v1 (subindex[tid], new_pg_root, new_vars_root, new_attrs_root, 1); 
+        if (!n)
+        {
+            // variable was not written since, remove it from the list
+            struct adios_index_var_struct_v1 * next = (*v)->next;
+            (*v)->next = dropped->vars_root;
+            dropped->vars_root = *v;
+            *v = next;
+        }
+        else
+        {
+            v = &(*v)->next;
+        }
+    }
 
-        adios_posix_close_internal (b[idx]);
-        adios_shared_buffer_free (b[idx]);
+    struct adios_index_attribute_struct_v1 ** a = attrs_root;
+    while (a && *a)
+    {
+        struct adios_index_attribute_struct_v1 * old = 
+            (struct adios_index_attribute_struct_v1 *) calloc (1, sizeof (struct adios_index_attribute_struct_v1));
+        old->type = (*a)->type;
+        old->nelems = (*a)->nelems;
+        old->characteristics = malloc ((*a)->characteristics_count * 
+                                       sizeof (struct adios_index_characteristic_struct_v1));
+        n = 0;
+        for (i = 0; i < (*a)->characteristics_count; i++)
+        {
+            if ((int64_t) (*a)->characteristics[i].offset <= hw)
+            {
+                memcpy (&old->characteristics[old->characteristics_count++],
+                        &(*a)->characteristics[i],
+                        sizeof (struct adios_index_characteristic_struct_v1));
+            }
+            else
+            {
+                if (n != i)
+                    memcpy (&(*a)->characteristics[n], &(*a)->characteristics[i],
+                            sizeof (struct adios_index_characteristic_struct_v1));
+                n++;
+            }
+        }
+        (*a)->characteristics_count = n;
+        if (old->characteristics_count)
+        {
+            old->next = dropped->attrs_root;
+            dropped->attrs_root = old;
+        }
+        else
+        {
+            free (old->characteristics);
+            free (old);
+        }
 
+        if (!n)
+        {
+            // attribute was not written since, remove it from the list
+            struct adios_index_attribute_struct_v1 * next = (*a)->next;
+            (*a)->next = dropped->attrs_root;
+            dropped->attrs_root = *a;
+            *a = next;
+        }
+        else
+        {
+            a = &(*a)->next;
+        }
     }
 
     if (verbose>1) {
-        //printf (DIVIDER);
-        printf ("Thread %d: End of reading all subfiles\n", tid);
+        printf ("Subfile %d: skip items up to offset %" PRId64 " already in %s\n", 
+                idx, hw, filename);
     }
 
+    adios_clear_index_v1 (dropped);
+    adios_free_index_v1 (dropped);
+}
+
+/* Min-heap of run indices for the k-way merges. A run comes before another
+   if its current time index is smaller or equal and it has a lower index,
+   so the merge keeps the order of the runs for the same time index. */
+static int run_before (const uint32_t * key, int r1, int r2)
+{
+    return (key[r1] < key[r2] || (key[r1] == key[r2] && r1 < r2));
+}
+
+static void heap_sift_down (int * heap, int n, const uint32_t * key, int i)
+{
+    while (1)
+    {
+        int l = 2*i + 1;
+        int r = l + 1;
+        int m = i;
+        if (l < n && run_before (key, heap[l], heap[m]))
+            m = l;
+        if (r < n && run_before (key, heap[r], heap[m]))
+            m = r;
+        if (m == i)
+            break;
+        int t = heap[i];
+        heap[i] = heap[m];
+        heap[m] = t;
+        i = m;
+    }
+}
+
+static void heap_build (int * heap, int n, const uint32_t * key)
+{
+    int i;
+    for (i = n/2 - 1; i >= 0; i--)
+        heap_sift_down (heap, n, key, i);
+}
+
+/* k-way merge of PG lists, each sorted by time */
+struct adios_index_process_group_struct_v1 * merge_pg_lists (
+                         struct adios_index_process_group_struct_v1 ** roots, int n)
+{
+    struct adios_index_process_group_struct_v1 * head = 0, * tail = 0;
+    uint32_t * key = malloc (n * sizeof (uint32_t));
+    int * heap = malloc (n * sizeof (int));
+    int i, nheap = 0;
 
+    for (i = 0; i < n; i++)
+    {
+        if (roots[i])
+        {
+            key[i] = roots[i]->time_index;
+            heap[nheap++] = i;
+        }
+    }
+    heap_build (heap, nheap, key);
+
+    while (nheap)
+    {
+        int r = heap[0];
+        struct adios_index_process_group_struct_v1 * pg = roots[r];
+        roots[r] = pg->next;
+        pg->next = 0;
+        if (tail)
+            tail->next = pg;
+        else
+            head = pg;
+        tail = pg;
+
+        if (roots[r])
+            key[r] = roots[r]->time_index;
+        else
+            heap[0] = heap[--nheap];
+        heap_sift_down (heap, nheap, key, 0);
+    }
+
+    free (heap);
+    free (key);
+    return head;
+}
+
+/* Group the items of the same variable from all lists into var_runs[]. 
+   The first item of each variable will hold the merged characteristics, 
+   the returned list links these items in the order of appearance. */
+struct adios_index_var_struct_v1 * collect_vars (
+                         struct adios_index_var_struct_v1 ** roots, int n)
+{
+    struct adios_index_var_struct_v1 * head = 0, * tail = 0;
+    qhashtbl_t * tbl = qhashtbl (500);
+    int nalloc = 0;
+    int i;
+
+    for (i = 0; i < n; i++)
+    {
+        struct adios_index_var_struct_v1 * v = roots[i];
+        while (v)
+        {
+            struct adios_index_var_struct_v1 * next = v->next;
+            struct var_runs * vr;
+            intptr_t k = (intptr_t) tbl->get2 (tbl, v->var_path, v->var_name);
+            v->next = 0;
+            if (!k)
+            {
+                if (nvar_runs == nalloc)
+                {
+                    nalloc = (nalloc ? 2*nalloc : 64);
+                    var_runs = realloc (var_runs, nalloc * sizeof (struct var_runs));
+                }
+                vr = &var_runs[nvar_runs++];
+                vr->runs = malloc (n * sizeof (struct adios_index_var_struct_v1 *));
+                vr->nruns = 0;
+                tbl->put2 (tbl, v->var_path, v->var_name, (void *) (intptr_t) nvar_runs);
+                if (tail)
+                    tail->next = v;
+                else
+                    head = v;
+                tail = v;
+            }
+            else
+            {
+                vr = &var_runs[k-1];
+                if (strcmp (vr->runs[0]->group_name, v->group_name))
+                {
+                    fprintf (stderr, "bpmeta: Variable in two different groups have the "
+                             "same path+name. Groups: %s and %s, variable: path=%s, "
+                             "name=%s. Variable is skipped in group %s\n",
+                             vr->runs[0]->group_name, v->group_name,
+                             v->var_path, v->var_name, v->group_name);
+                    struct adios_index_struct_v1 * skip = adios_alloc_index_v1(0);
+                    skip->vars_root = v;
+                    adios_clear_index_v1 (skip);
+                    adios_free_index_v1 (skip);
+                    v = next;
+                    continue;
+                }
+            }
+            vr->runs[vr->nruns++] = v;
+            v = next;
+        }
+    }
+
+    tbl->free (tbl);
+    return head;
+}
+
+/* k-way merge of the characteristics of every nthreads-th variable,
+   starting with the tid-th one */
+int merge_vars (int tid)
+{
+    int i, k;
+    uint32_t * key = 0;
+    int * heap = 0;
+    uint64_t * pos = 0;
+    int maxruns = 0;
+
+    for (i = tid; i < nvar_runs; i += nthreads)
+    {
+        struct var_runs * vr = &var_runs[i];
+        struct adios_index_var_struct_v1 * v = vr->runs[0];
+        struct adios_index_characteristic_struct_v1 * c;
+        uint64_t count = 0, j = 0;
+        int nheap = 0;
+
+        if (vr->nruns > 1)
+        {
+            if (vr->nruns > maxruns)
+            {
+                maxruns = vr->nruns;
+                key = realloc (key, maxruns * sizeof (uint32_t));
+                heap = realloc (heap, maxruns * sizeof (int));
+                pos = realloc (pos, maxruns * sizeof (uint64_t));
+            }
+
+            for (k = 0; k < vr->nruns; k++)
+            {
+                count += vr->runs[k]->characteristics_count;
+                pos[k] = 0;
+                if (vr->runs[k]->characteristics_count)
+                {
+                    key[k] = vr->runs[k]->characteristics[0].time_index;
+                    heap[nheap++] = k;
+                }
+            }
+            heap_build (heap, nheap, key);
+
+            c = malloc (count * sizeof (struct adios_index_characteristic_struct_v1));
+            while (nheap)
+            {
+                int r = heap[0];
+                struct adios_index_var_struct_v1 * rv = vr->runs[r];
+                memcpy (&c[j++], &rv->characteristics[pos[r]++],
+                        sizeof (struct adios_index_characteristic_struct_v1));
+                if (pos[r] < rv->characteristics_count)
+                    key[r] = rv->characteristics[pos[r]].time_index;
+                else
+                    heap[0] = heap[--nheap];
+                heap_sift_down (heap, nheap, key, 0);
+            }
+
+            for (k = 1; k < vr->nruns; k++)
+            {
+                // characteristics are moved into c, free the rest of the item
+                struct adios_index_var_struct_v1 * rv = vr->runs[k];
+                free (rv->characteristics);
+                free (rv->group_name);
+                free (rv->var_name);
+                free (rv->var_path);
+                free (rv);
+            }
+
+            free (v->characteristics);
+            v->characteristics = c;
+            v->characteristics_count = count;
+            v->characteristics_allocated = count;
+        }
+        free (vr->runs);
+        vr->runs = 0;
+    }
+
+    free (key);
+    free (heap);
+    free (pos);
+    if (verbose>1) {
+        printf ("Thread %d: End of merging variables\n", tid);
+    }
     return 0;
 }
 
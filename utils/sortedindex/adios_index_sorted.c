@@ -0,0 +1,284 @@
+/*
+ * adios_index_sorted.c
+ *
+ * Build the sorted (value, position) secondary index of variables of a BP
+ * file, used by the SORTED query method and by adios_query_topk() and
+ * adios_query_quantile(). The index of foo.bp is written into foo.sidx,
+ * see src/query/query_sorted.h for its layout.
+ *
+ * Every writeblock is sorted separately into a run of the index, the
+ * writeblocks are distributed over the MPI processes.
+ *
+ * Usage: adios_index_sorted [-s first[:count]] file.bp [var1 var2 ...]
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <inttypes.h>
+#include "mpi.h"
+#include "public/adios.h"
+#include "public/adios_read.h"
+#include "../../src/query/query_sorted.h"
+
+static int64_t  group;
+static int64_t  fh;
+static int      rank, size;
+static int      first_step = 0;
+static int      nsteps = -1;   // all steps from first_step
+
+static void usage (const char *prog)
+{
+    fprintf (stderr,
+        "Usage: %s [-s first[:count]] file.bp [var1 var2 ...]\n"
+        "  Build the sorted index of variables (all global arrays by default)\n"
+        "  of file.bp into file.sidx, for the SORTED query method and for\n"
+        "  top-k and quantile queries.\n"
+        "  -s first[:count]  index only steps first .. first+count-1\n"
+        "                    (all steps from 'first' without count)\n",
+        prog);
+}
+
+/* Check if the variable can be indexed */
+static int can_index (ADIOS_VARINFO *v)
+{
+    return (v->ndim > 0 && v->global && query_sorted_supports_type (v->type));
+}
+
+static void write_array (const char *name, enum ADIOS_DATATYPES type,
+                         uint64_t n, uint64_t total, uint64_t offset, void *data)
+{
+    char l[32], g[32], o[32];
+    snprintf (l, sizeof(l), "%" PRIu64, n);
+    snprintf (g, sizeof(g), "%" PRIu64, total);
+    snprintf (o, sizeof(o), "%" PRIu64, offset);
+    int64_t id = adios_define_var (group, name, "", type, l, g, o);
+    adios_write_byid (fh, id, data);
+}
+
+/* Index variable 'v' at 'step': the runs of this process are sorted and written
+   if 'write', otherwise only the bytes they need in the output are counted.
+   Returns 0, or 1 on error. */
+static int index_step (ADIOS_FILE *f, const char *varname, ADIOS_VARINFO *v, int step,
+                       int write, uint64_t *bytes, uint64_t *nvalues)
+{
+    int elemsize = adios_type_size (v->type, NULL);
+    size_t len = strlen (varname) + 64;
+    char *vname = NULL, *pname = NULL, *fname = NULL;
+    uint64_t total = 1, sum = 0, nfences = 0, voffset = 0, foffset = 0;
+    int b, d, b0 = 0, run = 0, err = 0;
+
+    for (b = 0; b < step; b++)
+        b0 += v->nblocks[b];
+    for (d = 0; d < v->ndim; d++)
+        total *= v->dims[d];
+
+    // the runs of the blocks must cover the array exactly once
+    for (b = 0; b < v->nblocks[step]; b++) {
+        uint64_t n = 1;
+        for (d = 0; d < v->ndim; d++)
+            n *= v->blockinfo[b0 + b].count[d];
+        sum += n;
+        nfences += query_sorted_nfences (n);
+    }
+    if (sum != total) {
+        if (rank == 0 && write)
+            fprintf (stderr, "Skip variable %s at step %d: its blocks do not cover the array exactly\n",
+                     varname, step);
+        return 0;
+    }
+
+    if (write) {
+        vname = (char *) malloc (len);
+        pname = (char *) malloc (len);
+        fname = (char *) malloc (len);
+        if (!vname || !pname || !fname) {
+            fprintf (stderr, "rank %d: out of memory\n", rank);
+            free (vname);
+            free (pname);
+            free (fname);
+            return 1;
+        }
+        query_sorted_var_name (vname, len, varname, step, "values");
+        query_sorted_var_name (pname, len, varname, step, "positions");
+        query_sorted_var_name (fname, len, varname, step, "fences");
+    }
+
+    for (b = 0; b < v->nblocks[step] && !err; b++)
+    {
+        const ADIOS_VARBLOCK *bi = &v->blockinfo[b0 + b];
+        uint64_t n = 1, nf;
+        for (d = 0; d < v->ndim; d++)
+            n *= bi->count[d];
+        if (!n)
+            continue;
+        nf = query_sorted_nfences (n);
+
+        if (run++ % size == rank)
+        {
+            *nvalues += n;
+            if (!write) {
+                *bytes += n * (elemsize + sizeof(uint64_t)) + nf * elemsize + 3 * (len + 256);
+            } else {
+                char *data = (char *) malloc (n * elemsize);
+                uint64_t *positions = (uint64_t *) malloc (n * sizeof(uint64_t));
+                char *fences = (char *) malloc (nf * elemsize);
+                if (!data || !positions || !fences) {
+                    fprintf (stderr, "rank %d: cannot allocate memory for block %d of %s\n",
+                             rank, b, varname);
+                    err = 1;
+                } else {
+                    ADIOS_SELECTION *sel = adios_selection_writeblock (b);
+                    adios_schedule_read_byid (f, sel, v->varid, step, 1, data);
+                    err = adios_perform_reads (f, 1);
+                    adios_selection_delete (sel);
+                    if (err) {
+                        fprintf (stderr, "rank %d: cannot read block %d of %s at step %d: %s\n",
+                                 rank, b, varname, step, adios_errmsg());
+                    } else {
+                        err = query_sorted_build_run (v->type, v->ndim, v->dims, bi->start, bi->count,
+                                                      data, positions, fences);
+                    }
+                }
+                if (!err) {
+                    write_array (vname, v->type, n, total, voffset, data);
+                    write_array (pname, adios_unsigned_long, n, total, voffset, positions);
+                    write_array (fname, v->type, nf, nfences, foffset, fences);
+                }
+                free (data);
+                free (positions);
+                free (fences);
+            }
+        }
+        voffset += n;
+        foffset += nf;
+    }
+    free (vname);
+    free (pname);
+    free (fname);
+    return (err != 0);
+}
+
+/* Index the chosen steps of a variable */
+static int index_variable (ADIOS_FILE *f, const char *varname, int write, uint64_t *bytes)
+{
+    ADIOS_VARINFO *v = adios_inq_var (f, varname);
+    uint64_t nvalues = 0;
+    int step, last, err = 0;
+
+    if (!v) {
+        if (rank == 0 && write)
+            fprintf (stderr, "No such variable: %s\n", varname);
+        return 0;
+    }
+    if (!can_index (v)) {
+        if (rank == 0 && write)
+            fprintf (stderr, "Skip variable %s: only global arrays of integer and real types "
+                     "can be indexed\n", varname);
+        adios_free_varinfo (v);
+        return 0;
+    }
+    adios_inq_var_blockinfo (f, v);
+    if (!v->blockinfo) {
+        fprintf (stderr, "rank %d: cannot get the blocks of variable %s\n", rank, varname);
+        adios_free_varinfo (v);
+        return 1;
+    }
+
+    last = (nsteps < 0 || first_step + nsteps > v->nsteps ? v->nsteps : first_step + nsteps);
+    for (step = first_step; step < last && !err; step++)
+        err = index_step (f, varname, v, step, write, bytes, &nvalues);
+    if (write && !err && nvalues)
+        printf ("rank %d: indexed %" PRIu64 " values of %s in steps %d..%d\n",
+                rank, nvalues, varname, first_step, last - 1);
+    adios_free_varinfo (v);
+    return err;
+}
+
+/* Index the given variables, or all that can be indexed */
+static int index_all (ADIOS_FILE *f, int nvars, char **varnames, int write, uint64_t *bytes)
+{
+    int i, err = 0;
+    if (nvars) {
+        for (i = 0; i < nvars && !err; i++)
+            err = index_variable (f, varnames[i], write, bytes);
+        return err;
+    }
+    for (i = 0; i < f->nvars && !err; i++)
+    {
+        const char *name = f->var_namelist[i];
+        if (!strncmp (name, "/__adios__", 10) || !strncmp (name, "__adios__", 9))
+            continue;
+        ADIOS_VARINFO *v = adios_inq_var_byid (f, i);
+        int ok = (v && can_index (v));
+        adios_free_varinfo (v);
+        if (ok)
+            err = index_variable (f, name, write, bytes);
+    }
+    return err;
+}
+
+int main (int argc, char ** argv)
+{
+    MPI_Comm comm = MPI_COMM_WORLD;
+    ADIOS_FILE *f;
+    char *idxname;
+    uint64_t bytes = 0, total_size;
+    int a = 1, err, allerr = 0;
+
+    MPI_Init (&argc, &argv);
+    MPI_Comm_rank (comm, &rank);
+    MPI_Comm_size (comm, &size);
+
+    if (a + 1 < argc && !strcmp (argv[a], "-s")) {
+        char *colon = strchr (argv[a+1], ':');
+        first_step = atoi (argv[a+1]);
+        if (colon)
+            nsteps = atoi (colon + 1);
+        a += 2;
+    }
+    if (a >= argc || first_step < 0) {
+        if (rank == 0)
+            usage (argv[0]);
+        MPI_Finalize ();
+        return 1;
+    }
+
+    adios_init_noxml (comm);
+    adios_read_init_method (ADIOS_READ_METHOD_BP, comm, "");
+    f = adios_read_open_file (argv[a], ADIOS_READ_METHOD_BP, comm);
+    if (f == NULL) {
+        if (rank == 0)
+            fprintf (stderr, "Cannot open %s: %s\n", argv[a], adios_errmsg());
+        adios_finalize (rank);
+        MPI_Finalize ();
+        return 1;
+    }
+    idxname = query_sorted_index_file_name (argv[a]);
+
+    // count the bytes to write first, every process writes its runs in one go
+    err = index_all (f, argc - a - 1, argv + a + 1, 0, &bytes);
+    if (!err) {
+        adios_declare_group (&group, "sorted_index", "", adios_stat_no);
+        adios_select_method (group, "MPI", "", "");
+        adios_set_max_buffer_size (bytes / 1048576 + 16);
+        adios_open (&fh, "sorted_index", idxname, "w", comm);
+        adios_group_size (fh, bytes, &total_size);
+        err = index_all (f, argc - a - 1, argv + a + 1, 1, &bytes);
+        adios_close (fh);
+    }
+    MPI_Allreduce (&err, &allerr, 1, MPI_INT, MPI_MAX, comm);
+    if (rank == 0) {
+        if (allerr)
+            fprintf (stderr, "Failed to build the sorted index %s\n", idxname);
+        else
+            printf ("The sorted index of %s is in %s\n", argv[a], idxname);
+    }
+
+    adios_read_close (f);
+    adios_read_finalize_method (ADIOS_READ_METHOD_BP);
+    free (idxname);
+    MPI_Barrier (comm);
+    adios_finalize (rank);
+    MPI_Finalize ();
+    return (allerr != 0);
+}